@@ -0,0 +1,288 @@
+"""
+PlatformIO pre-script: convert the SquareLine image assets to the cheapest LVGL format at build time.
+
+SquareLine exports every PNG as LV_IMG_CF_TRUE_COLOR_ALPHA (RGB565 + 8-bit alpha) or TRUE_COLOR.
+Many of them never use their alpha channel, but LVGL still blends them pixel by pixel.
+This script reads src/squareline/ui_img_*.c and picks a format per asset:
+
+  - alpha is 0xFF everywhere             -> TRUE_COLOR           (2 B/px, opaque copy)
+  - alpha is only 0x00 / 0xFF and the    -> TRUE_COLOR_CHROMA_KEYED (2 B/px, per-pixel key test,
+    key colour is not used                  no blending)
+  - anything else                       -> TRUE_COLOR_ALPHA     (3 B/px, per-pixel blend)
+
+It also fixes the RGB565 byte order to match LV_COLOR_16_SWAP in lib/lv_conf.h.
+The converted copies are written to $BUILD_DIR/assets and compiled instead of the originals, so the
+SquareLine sources stay untouched and can be re-exported at any time.
+A per-asset report (flash bytes before/after, blend cost) is printed and saved to
+$BUILD_DIR/assets/report.txt.
+
+INDEXED_8BIT is only used when requested in OVERRIDES. It is smaller in flash, but LVGL 8.3 draws it through
+the line-by-line decoder; assets that stay live on screen are expanded once at boot by ui_assets.cpp
+(TRUE_COLOR_ALPHA in RAM), so the saving costs RAM instead of draw time.
+LVGL 8 has no built-in RLE decoder, so RLE is not offered.
+
+Standalone: python asset_pipeline.py [--out DIR]   (analyse and write, without PlatformIO)
+"""
+
+import os
+import re
+import sys
+
+# SCons runs extra scripts without __file__; the PlatformIO hook below resets both from $PROJECT_DIR
+SELF = os.path.abspath(__file__) if "__file__" in globals() else os.path.abspath("asset_pipeline.py")
+PROJECT_DIR = os.path.dirname(SELF)
+ASSET_DIR = os.path.join("src", "squareline")
+ASSET_GLOB = re.compile(r"^ui_img_.*\.c$")
+
+# Byte order the SquareLine project exported with (Project settings -> Color depth "16 swap")
+SOURCE_SWAP = 1
+
+# Per-asset format override: {"ui_img_map_demo2_png": "INDEXED_8BIT"}; values: AUTO, TRUE_COLOR,
+# CHROMA_KEYED, TRUE_COLOR_ALPHA, INDEXED_8BIT, KEEP
+OVERRIDES = {}
+
+CHROMA_KEY_RGB = (0x00, 0xFF, 0x00)  # LV_COLOR_CHROMA_KEY in lib/lv_conf.h
+
+CF_NAMES = {
+    "TRUE_COLOR": "LV_IMG_CF_TRUE_COLOR",
+    "CHROMA_KEYED": "LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED",
+    "TRUE_COLOR_ALPHA": "LV_IMG_CF_TRUE_COLOR_ALPHA",
+    "INDEXED_8BIT": "LV_IMG_CF_INDEXED_8BIT",
+}
+
+BLEND_COST = {
+    "TRUE_COLOR": "copy",
+    "CHROMA_KEYED": "key test/px",
+    "TRUE_COLOR_ALPHA": "blend/px",
+    "INDEXED_8BIT": "decode/line + blend",
+}
+
+
+# ---------------------------------------------------------------------------
+# Parsing
+# ---------------------------------------------------------------------------
+
+def read_lv_conf_swap(project_dir):
+    path = os.path.join(project_dir, "lib", "lv_conf.h")
+    try:
+        with open(path, "r", encoding="utf-8", errors="replace") as f:
+            m = re.search(r"^\s*#define\s+LV_COLOR_16_SWAP\s+(\d+)", f.read(), re.M)
+            return int(m.group(1)) if m else 0
+    except OSError:
+        return 0
+
+
+def parse_asset(path):
+    with open(path, "r", encoding="utf-8", errors="replace") as f:
+        text = f.read()
+
+    arr = re.search(r"const\s+LV_ATTRIBUTE_MEM_ALIGN\s+uint8_t\s+(\w+)\s*\[\]\s*=\s*\{(.*?)\};", text, re.S)
+    dsc = re.search(r"const\s+lv_img_dsc_t\s+(\w+)\s*=\s*\{(.*?)\};", text, re.S)
+    if not arr or not dsc:
+        return None
+    body = dsc.group(2)
+
+    def field(name):
+        m = re.search(r"\." + re.escape(name) + r"\s*=\s*([\w]+)", body)
+        return m.group(1) if m else None
+
+    data = bytes(int(x, 16) for x in re.findall(r"0x([0-9A-Fa-f]{2})", arr.group(2)))
+    return {
+        "path": path,
+        "array": arr.group(1),
+        "name": dsc.group(1),
+        "w": int(field("header.w")),
+        "h": int(field("header.h")),
+        "cf": field("header.cf").replace("LV_IMG_CF_", ""),
+        "data": data,
+    }
+
+
+# ---------------------------------------------------------------------------
+# Conversion (16-bit colour only, which is what lv_conf configures)
+# ---------------------------------------------------------------------------
+
+def split_pixels(a, src_swap):
+    """-> (list of RGB565 values, list of alpha or None)"""
+    d = a["data"]
+    n = a["w"] * a["h"]
+    bpp = 3 if a["cf"] == "TRUE_COLOR_ALPHA" else 2
+    if len(d) < n * bpp:
+        raise ValueError("%s: %d bytes, expected %d" % (a["name"], len(d), n * bpp))
+    colors = []
+    alphas = [] if bpp == 3 else None
+    for i in range(n):
+        b0, b1 = d[i * bpp], d[i * bpp + 1]
+        colors.append((b0 << 8 | b1) if src_swap else (b1 << 8 | b0))
+        if alphas is not None:
+            alphas.append(d[i * bpp + 2])
+    return colors, alphas
+
+
+def rgb565(r, g, b):
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+def c16_bytes(c, swap):
+    return bytes((c >> 8, c & 0xFF)) if swap else bytes((c & 0xFF, c >> 8))
+
+
+def choose_format(a, colors, alphas):
+    over = OVERRIDES.get(a["name"], "AUTO")
+    if over == "KEEP":
+        return a["cf"]
+    if over != "AUTO":
+        return over
+    if alphas is None:
+        return "TRUE_COLOR"
+    if all(x == 0xFF for x in alphas):
+        return "TRUE_COLOR"
+    key = rgb565(*CHROMA_KEY_RGB)
+    binary = all(x in (0, 0xFF) for x in alphas)
+    key_used = any(c == key and x == 0xFF for c, x in zip(colors, alphas))
+    if binary and not key_used:
+        return "CHROMA_KEYED"
+    return "TRUE_COLOR_ALPHA"
+
+
+def encode(fmt, colors, alphas, swap):
+    key = rgb565(*CHROMA_KEY_RGB)
+    out = bytearray()
+    if fmt == "TRUE_COLOR":
+        for c in colors:
+            out += c16_bytes(c, swap)
+    elif fmt == "CHROMA_KEYED":
+        for c, x in zip(colors, alphas or [0xFF] * len(colors)):
+            out += c16_bytes(key if x == 0 else c, swap)
+    elif fmt == "TRUE_COLOR_ALPHA":
+        for c, x in zip(colors, alphas or [0xFF] * len(colors)):
+            out += c16_bytes(c, swap)
+            out.append(x)
+    elif fmt == "INDEXED_8BIT":
+        pal = {}
+        idx = bytearray()
+        for c, x in zip(colors, alphas or [0xFF] * len(colors)):
+            k = (c, x)
+            if k not in pal:
+                if len(pal) == 256:
+                    raise ValueError("more than 256 colours, cannot index")
+                pal[k] = len(pal)
+            idx.append(pal[k])
+        palette = bytearray(256 * 4)
+        for (c, x), i in pal.items():
+            r = (c >> 11) & 0x1F
+            g = (c >> 5) & 0x3F
+            b = c & 0x1F
+            # lv_color32_t: blue, green, red, alpha
+            palette[i * 4:i * 4 + 4] = bytes(((b << 3) | (b >> 2), (g << 2) | (g >> 4), (r << 3) | (r >> 2), x))
+        out = palette + idx
+    else:
+        raise ValueError("unknown format " + fmt)
+    return bytes(out)
+
+
+def write_c(path, a, fmt, blob):
+    lines = []
+    for i in range(0, len(blob), 32):
+        lines.append("    " + ",".join("0x%02X" % b for b in blob[i:i + 32]) + ",")
+    src = (
+        "// Generated by asset_pipeline.py from %s - do not edit\n"
+        "// %dx%d %s -> %s\n\n"
+        "#include \"ui.h\"\n\n"
+        "#ifndef LV_ATTRIBUTE_MEM_ALIGN\n"
+        "    #define LV_ATTRIBUTE_MEM_ALIGN\n"
+        "#endif\n\n"
+        "const LV_ATTRIBUTE_MEM_ALIGN uint8_t %s[] = {\n%s\n};\n"
+        "const lv_img_dsc_t %s = {\n"
+        "    .header.always_zero = 0,\n"
+        "    .header.w = %d,\n"
+        "    .header.h = %d,\n"
+        "    .data_size = sizeof(%s),\n"
+        "    .header.cf = %s,\n"
+        "    .data = %s\n"
+        "};\n"
+    ) % (os.path.relpath(a["path"], PROJECT_DIR).replace("\\", "/"), a["w"], a["h"], a["cf"], fmt,
+         a["array"], "\n".join(lines), a["name"], a["w"], a["h"], a["array"], CF_NAMES[fmt], a["array"])
+    tmp = path + ".tmp"
+    with open(tmp, "w", encoding="utf-8", newline="\n") as f:
+        f.write(src)
+    os.replace(tmp, path)
+
+
+def run(project_dir, out_dir):
+    """Convert every asset; returns {original source path: generated path}."""
+    dst_swap = read_lv_conf_swap(project_dir)
+    src_dir = os.path.join(project_dir, ASSET_DIR)
+    os.makedirs(out_dir, exist_ok=True)
+
+    mapping = {}
+    report = ["%-26s %9s %-17s %-17s %8s %8s  %s" % ("asset", "size", "from", "to", "flash", "before", "blend")]
+    total_before = total_after = 0
+    for fn in sorted(os.listdir(src_dir)):
+        if not ASSET_GLOB.match(fn):
+            continue
+        path = os.path.join(src_dir, fn)
+        out = os.path.join(out_dir, fn)
+        a = parse_asset(path)
+        if a is None:
+            print("[assets] skip %s (unrecognised layout)" % fn)
+            continue
+
+        colors, alphas = split_pixels(a, SOURCE_SWAP)
+        fmt = choose_format(a, colors, alphas)
+        try:
+            blob = encode(fmt, colors, alphas, dst_swap)
+        except ValueError as e:
+            print("[assets] %s: %s, keeping %s" % (a["name"], e, a["cf"]))
+            fmt = a["cf"]
+            blob = encode(fmt, colors, alphas, dst_swap)
+
+        if not (os.path.exists(out) and os.path.getmtime(out) >= max(os.path.getmtime(path),
+                                                                         os.path.getmtime(SELF))):
+            write_c(out, a, fmt, blob)
+        mapping[os.path.normcase(os.path.abspath(path))] = out
+
+        before = len(a["data"])
+        total_before += before
+        total_after += len(blob)
+        report.append("%-26s %9s %-17s %-17s %8d %8d  %s" % (
+            a["name"], "%dx%d" % (a["w"], a["h"]), a["cf"], fmt, len(blob), before, BLEND_COST.get(fmt, "?")))
+
+    report.append("total flash %d -> %d bytes (%+d)" % (total_before, total_after, total_after - total_before))
+    text = "\n".join(report)
+    with open(os.path.join(out_dir, "report.txt"), "w", encoding="utf-8", newline="\n") as f:
+        f.write(text + "\n")
+    print("[assets] LV_COLOR_16_SWAP=%d\n%s" % (dst_swap, text))
+    return mapping
+
+
+# ---------------------------------------------------------------------------
+# PlatformIO / SCons hook
+# ---------------------------------------------------------------------------
+
+try:
+    Import("env")  # noqa: F821  (provided by SCons)
+except NameError:
+    env = None
+
+if env is not None:
+    PROJECT_DIR = env.subst("$PROJECT_DIR")
+    SELF = os.path.join(PROJECT_DIR, "asset_pipeline.py")
+    _out_dir = os.path.join(env.subst("$BUILD_DIR"), "assets")
+    _mapping = run(PROJECT_DIR, _out_dir)
+
+    def _skip_original(env_, node):
+        # originals are replaced by the converted copies built below
+        if os.path.normcase(os.path.abspath(node.srcnode().get_abspath())) in _mapping:
+            return None
+        return node
+
+    env.AddBuildMiddleware(_skip_original, "*/squareline/ui_img_*.c")
+    env.Append(CPPPATH=[os.path.join(PROJECT_DIR, ASSET_DIR)])
+    env.BuildSources(os.path.join("$BUILD_DIR", "assets_obj"), _out_dir, src_filter="+<*.c>")
+
+elif __name__ == "__main__":
+    _out = os.path.join(PROJECT_DIR, ".pio", "assets")
+    if "--out" in sys.argv:
+        _out = sys.argv[sys.argv.index("--out") + 1]
+    run(PROJECT_DIR, _out)
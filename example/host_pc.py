@@ -1,17 +1,19 @@
 #!/usr/bin/env python3
 # -*- coding: utf-8 -*-
 """
-上位机：通过串口(USB CDC / ttyACM / COM)向下位机发送两类帧
+上位机：通过串口(USB CDC / ttyACM / COM)或 USB vendor 批量接口向下位机发送两类帧
 - MSGF：高频短消息（建议 24Hz）
-- IMGF：低频 PNG（<=100KB）
+- IMGF：低频 PNG（<=100KB），可用 --png-frag 分片发送（type=1，flags FIRST/LAST，rsv=分片序号）
+  --img-mode r565 时发送已转好的 RGB565 位图（type=2，可 RLE/LZ4 压缩），下位机免去 PNG 解码
+  --r565-delta 时只发送与上一帧相比变化的矩形（type=3）
 
 帧格式（固定 20 bytes header，小端）：
 magic u32   // 'MSGF' 'IMGF'
 type  u8
-flags u8
+flags u8    // bit7：--compress 时载荷为 u32 原始长度 + LZ4 块，其余位归各帧类型
 rsv  u16
 len  u32
-crc32 u32   // 本脚本默认不启用（0）
+crc32 u32   // 默认不启用（0），--crc 时为 payload 的 CRC32(IEEE)
 seq  u32
 
 短消息 MSGF payload（小端）：
@@ -20,6 +22,10 @@ uint8  cmd
   - 0x01: 设备重启（后续可无payload）
   - 0x02: 设置亮度（后续1字节，0..255）
   - 0x03: 设置显示翻转（后续1字节，仅 1/3/5/7）
+  - 0x05: 增量快照：u32 基准整包 seq + u16 字段掩码 + 与基准不同的字段（顺序、宽度同下表）
+  - 0x06: 批量：若干条 [u8 len][u32 seq][上述任一 payload]，下位机按顺序分发
+  - 0x09: 能力握手，下位机回 'HELO' 帧（支持的图像类型/编码/命令、地图区域尺寸等）
+  - 0x0A: 事件追踪，下位机按核回若干帧 'TRCE'（后续1字节 bit0=读后清空），--trace 转成 Chrome trace / Perfetto 文件
 int16  speed_kmh
 int16  engine_speed_rpm
 int32  odo_m
@@ -35,13 +41,17 @@ uint16 fuel_total_dl   // 油箱总量，单位0.1L
 
 依赖：
 pip install pyserial pillow
+（--port vendor 走 USB vendor 批量接口时另需 pip install pyusb；Windows 需给该接口装 WinUSB 驱动）
 """
 
 import argparse
+import csv
 import json
+import math
 import random
 import struct
 import time
+import zlib
 import requests
 import io
 import os
@@ -60,6 +70,64 @@ MSG_CMD_SNAPSHOT = 0x00
 MSG_CMD_REBOOT = 0x01
 MSG_CMD_BRIGHTNESS = 0x02
 MSG_CMD_OFFSET_ROTATION = 0x03
+MSG_CMD_GET_PERF = 0x04     # 参数 bit0=读后清零；下位机回一帧 'PERF'
+MSG_CMD_SNAPSHOT_DELTA = 0x05
+MSG_CMD_BATCH = 0x06
+MSG_CMD_GET_TASKS = 0x07    # 下位机回一帧 'TASK'：各任务栈余量/优先级/CPU，窗口为上次查询到现在
+MSG_CMD_BUS_RETUNE = 0x08   # 清掉总线时钟标定结果，下次启动重新标定
+MSG_CMD_HELLO = 0x09        # 能力握手：下位机回一帧 'HELO'
+MSG_CMD_GET_TRACE = 0x0A    # 事件追踪：下位机回若干帧 'TRCE'；参数 bit0=读后清空
+SNAP_FMT = "<hhiihhhHHHH"   # 快照字段，掩码 bit i 对应第 i 个
+
+MAGIC_PERF = b"PERF"
+MAGIC_TASK = b"TASK"
+MAGIC_HELO = b"HELO"
+HELO_FMT = "<BBHHHHHBBBBIIHBBB3x"  # include/hud_stat.h 的 hud_hello_wire_t，32 字节
+HELO_FIELDS = ["version", "board", "proto_rev", "screen_w", "screen_h", "map_w", "map_h",
+               "imgf_types", "r565_codecs", "frame_codecs", "features", "msgf_cmds",
+               "img_max_bytes", "msg_max_bytes", "img_slots", "msg_queue", "mux_channels"]
+HELO_F_MUXF = 0x01
+HELO_F_CRC_REQUIRED = 0x02
+HELO_F_SWAP565 = 0x04
+HELO_F_TILE_CACHE = 0x08
+HELO_CODEC_LZ4 = 0x01
+TASK_REC_FMT = "<12sBBBBHH"   # include/hud_taskmon.h 的 hud_taskmon_task_t，20 字节
+HEADER_FMT = "<IBBHIII"
+HEADER_LEN = struct.calcsize(HEADER_FMT)
+MAGIC_TRCE = b"TRCE"
+TRCE_HDR_FMT = "<BBBBHHII"  # include/hud_trace.h：版本、核、核数、rsv、分片序号、分片数、dump 时刻 us、丢失条数
+TRCE_REC_FMT = "<IIIHBB"    # hud_trace_rec_t：t_us, seq, arg, id, core, rsv（16 字节）
+TRACE_STAGES = ["hdr", "commit", "request", "apply", "flush"]   # hud_perf_stage_t
+TR_STAGE, TR_METRIC = 1, 16
+TR_IMG_DISPATCH, TR_IMG_QUEUED, TR_IMG_REPLACED, TR_IMG_DROPPED, TR_IMG_APPLY_BEGIN, TR_IMG_APPLY_END = range(48, 54)
+PERF_METRICS = ["hdr->commit", "commit->request", "request->apply", "apply->flush",
+                "usb->glass", "render", "flush", "img_decode", "lv_timer"]
+
+IMGF_TYPE_PNG_FRAG = 0x01   # rsv = 分片序号
+IMGF_TYPE_R565 = 0x02       # 预转换 RGB565 位图，payload = R565 头 + 像素
+IMGF_TYPE_R565_RECT = 0x03  # 当前地图的局部矩形，payload = x,y,map_w,map_h + R565 载荷
+IMGF_TYPE_TRACK = 0x04      # 矢量轨迹折线，下位机画在地图之上，payload = TRK1 头 + int16 增量
+IMGF_TYPE_TILE = 0x05       # 可缓存的地图瓦片，payload = 12 字节编号 + R565 载荷
+IMGF_TYPE_TILE_MAP = 0x06   # 瓦片布局，下位机从缓存拼图，payload = TMAP 头 + n*(dx,dy,编号)
+IMGF_TYPE_TILE_VIEW = 0x07  # 平移瓦片视口，payload = TVEW + z + rsv + bg + 视口左上角世界坐标 x,y
+MAGIC_TMIS = b"TMIS"        # 下位机回报缓存里缺的瓦片编号
+MAGIC_STAT = b"STAT"        # 下位机周期遥测（include/hud_stat.h 的 hud_stat_wire_t，84 字节 + 堆碎片 20 字节）
+STAT_FMT = "<BBHI5I3I3IIHH3I3I"
+STAT_HEAP_FMT = "<4Ii"      # 紧跟在前 84 字节之后，旧固件没有
+STAT_HEAP_FIELDS = ["heap_min_psram", "heap_largest_internal", "heap_largest_psram",
+                    "heap_largest_min_psram", "heap_psram_trend"]
+STAT_FIELDS = ["version", "rsv", "period_ms", "uptime_ms",
+               "usb_bytes_rx", "usb_frames_ok", "usb_frames_dropped", "usb_resync", "usb_frames_timeout",
+               "imgf_ok", "imgf_drop", "imgf_bad", "msgf_ok", "msgf_drop", "msgf_bad",
+               "ui_img_replaced", "ui_img_pending", "rsv2",
+               "heap_free_internal", "heap_min_internal", "heap_free_psram",
+               "decode_count", "decode_avg_us", "decode_p99_us"]
+TILE_PX = 64
+IMGF_FLAG_FIRST = 0x01
+IMGF_FLAG_LAST = 0x02
+FRAME_FLAG_LZ4 = 0x80       # 帧头 flags 高位：载荷为 u32 原始长度 + LZ4 块，下位机路由器边收边解压
+FRAME_LZ4_MIN = 256         # 更短的载荷不值得压缩
+USB_VENDOR_VID = 0x303A     # Espressif；--port vendor 时按它与接口类 0xFF 找下位机
 
 
 def u32_le_from_magic(magic4: bytes) -> int:
@@ -68,9 +136,10 @@ def u32_le_from_magic(magic4: bytes) -> int:
     return struct.unpack("<I", magic4)[0]
 
 
-def pack_header(magic4: bytes, payload_len: int, seq: int, typ: int = 0, flags: int = 0, crc32: int = 0) -> bytes:
+def pack_header(magic4: bytes, payload_len: int, seq: int, typ: int = 0, flags: int = 0, crc32: int = 0,
+                rsv: int = 0) -> bytes:
     # <I B B H I I I  = 4 +1+1+2 +4+4+4 = 20 bytes
-    return struct.pack("<IBBHIII", u32_le_from_magic(magic4), typ & 0xFF, flags & 0xFF, 0, payload_len, crc32 & 0xFFFFFFFF, seq & 0xFFFFFFFF)
+    return struct.pack("<IBBHIII", u32_le_from_magic(magic4), typ & 0xFF, flags & 0xFF, rsv & 0xFFFF, payload_len, crc32 & 0xFFFFFFFF, seq & 0xFFFFFFFF)
 
 
 def hhmm_to_minutes(hhmm: str) -> int:
@@ -121,6 +190,73 @@ class TrackImageFetcher:
         return png
 
 
+TRACK_VIEW_SIZE = 4096
+TRACK_FLAG_RESET = 0x01
+
+
+def track_payload(view: int, first: int, reset: bool, pts: List[tuple[int, int]],
+                  width: int = 3, color_rgb: int = 0x2F80FF) -> bytes:
+    """IMGF type=4：视口 id/尺寸、首点序号、点数、标志、线宽、RGB565 颜色、首点，其余点为相对前一点的增量"""
+    c = color_rgb
+    c565 = ((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F)
+    out = bytearray(struct.pack("<IIHHHHBBHhh", 0x314B5254, view, TRACK_VIEW_SIZE, TRACK_VIEW_SIZE,
+                                first, len(pts), TRACK_FLAG_RESET if reset else 0, width, c565,
+                                pts[0][0], pts[0][1]))
+    for (x0, y0), (x1, y1) in zip(pts, pts[1:]):
+        out += struct.pack("<hh", x1 - x0, y1 - y0)
+    return bytes(out)
+
+
+class VectorTrack:
+    """演示用矢量轨迹：每次放出一个点，点在视口内只追加，出界时重新取景并整条重发"""
+
+    def __init__(self, points: List[List[float]]):
+        self.points = points    # [lon, lat]
+        self.count = 0
+        self.view = 0
+        self.sent = 0
+        self._box: Optional[tuple[float, float, float]] = None  # (left, top, span) 墨卡托
+
+    @staticmethod
+    def _merc(p: List[float]) -> tuple[float, float]:
+        lat = math.radians(max(-85.0, min(85.0, p[1])))
+        return math.radians(p[0]), math.log(math.tan(math.pi / 4 + lat / 2))
+
+    def _to_view(self, p: List[float]) -> tuple[int, int]:
+        left, top, span = self._box
+        x, y = self._merc(p)
+        return round((x - left) / span * TRACK_VIEW_SIZE), round((top - y) / span * TRACK_VIEW_SIZE)
+
+    def _fit(self, pts: List[List[float]]):
+        xy = [self._merc(p) for p in pts]
+        xs = [x for x, _ in xy]
+        ys = [y for _, y in xy]
+        lat = math.radians(sum(p[1] for p in pts) / len(pts))
+        min_span = 300.0 / (6378137.0 * max(0.01, math.cos(lat)))
+        span = max(max(max(xs) - min(xs), max(ys) - min(ys)) * 1.3, min_span)
+        cx, cy = (min(xs) + max(xs)) / 2, (min(ys) + max(ys)) / 2
+        self._box = (cx - span / 2, cy + span / 2, span)
+        self.view += 1
+
+    def next_payload(self) -> Optional[bytes]:
+        if self.count >= len(self.points):
+            return None
+        self.count += 1
+        pt = self.points[self.count - 1]
+        inside = False
+        if self._box:
+            x, y = self._to_view(pt)
+            inside = 0 <= x < TRACK_VIEW_SIZE and 0 <= y < TRACK_VIEW_SIZE
+        if not inside:
+            pts = self.points[:self.count]
+            self._fit(pts)
+            self.sent = len(pts)
+            return track_payload(self.view, 0, True, [self._to_view(p) for p in pts])
+        first = self.sent
+        self.sent += 1
+        return track_payload(self.view, first, False, [self._to_view(pt)])
+
+
 @dataclass
 class MsgfSnapshot:
     speed_kmh: int = 0
@@ -138,7 +274,7 @@ class MsgfSnapshot:
     def pack(self) -> bytes:
         # < h h i i h h h H H H H = 2+2+4+4+2+2+2+2+2+2+2 = 26 bytes
         return struct.pack(
-            "<hhiihhhHHHH",
+            SNAP_FMT,
             int(self.speed_kmh),
             int(self.engine_rpm),
             int(self.odo_m),
@@ -153,11 +289,93 @@ class MsgfSnapshot:
         )
 
 
+class VendorBulkPort:
+    """下位机 USB vendor 批量接口（固件 sc01_plus_vendor 环境），提供 HostSender 用到的 pyserial 子集。
+    port 为 "vendor" 或 "vendor:VID:PID"（十六进制）；按接口类 0xFF 找 bulk OUT/IN 端点。需要 pip install pyusb"""
+    CHUNK = 64 * 1024   # 每次提交给内核的 bulk 传输长度
+
+    def __init__(self, port: str, timeout_ms: int = 1000):
+        import usb.core
+        import usb.util
+        self._usb = usb
+        parts = port.split(":")
+        vid = int(parts[1], 16) if len(parts) > 1 else USB_VENDOR_VID
+        pid = int(parts[2], 16) if len(parts) > 2 else None
+        kw = {"idVendor": vid} if pid is None else {"idVendor": vid, "idProduct": pid}
+        self.dev = usb.core.find(**kw)
+        if self.dev is None:
+            raise IOError(f"no USB device {vid:04x}:{'*' if pid is None else f'{pid:04x}'}")
+        cfg = self.dev.get_active_configuration()
+        intf = usb.util.find_descriptor(cfg, bInterfaceClass=0xFF)
+        if intf is None:
+            raise IOError("device has no vendor interface (firmware not built with HUD_USB_VENDOR=1?)")
+        self.intf = intf.bInterfaceNumber
+        try:
+            if self.dev.is_kernel_driver_active(self.intf):
+                self.dev.detach_kernel_driver(self.intf)
+        except (NotImplementedError, usb.core.USBError):
+            pass  # Windows（WinUSB）没有内核驱动这一说
+        usb.util.claim_interface(self.dev, self.intf)
+        def ep(direction):
+            return usb.util.find_descriptor(
+                intf, custom_match=lambda e: usb.util.endpoint_direction(e.bEndpointAddress) == direction)
+        self.ep_out = ep(usb.util.ENDPOINT_OUT)
+        self.ep_in = ep(usb.util.ENDPOINT_IN)
+        self.timeout_ms = timeout_ms
+        self._rx = bytearray()
+
+    def write(self, data: bytes) -> int:
+        mv = memoryview(data)
+        for i in range(0, len(mv), self.CHUNK):
+            self.ep_out.write(mv[i:i + self.CHUNK], self.timeout_ms)
+        return len(data)
+
+    def _fill(self, timeout_ms: int):
+        try:
+            self._rx += self.ep_in.read(self.CHUNK, timeout_ms)
+        except self._usb.core.USBTimeoutError:
+            pass
+
+    @property
+    def in_waiting(self) -> int:
+        if not self._rx:
+            self._fill(1)
+        return len(self._rx)
+
+    def read(self, n: int = 1) -> bytes:
+        if not self._rx:
+            self._fill(10)
+        out = bytes(self._rx[:n])
+        del self._rx[:n]
+        return out
+
+    def reset_input_buffer(self):
+        self._rx.clear()
+        while self.in_waiting:
+            self._rx.clear()
+
+    def close(self):
+        self._usb.util.release_interface(self.dev, self.intf)
+        self._usb.util.dispose_resources(self.dev)
+
+
 class HostSender:
-    def __init__(self, port: str, baud: int = 115200, timeout: float = 0):
-        # 对 CDC ACM，波特率一般无意义，但 pyserial 仍要求填
-        self.ser = serial.Serial(port=port, baudrate=baud, timeout=timeout, write_timeout=1)
+    def __init__(self, port: str, baud: int = 115200, timeout: float = 0, enable_crc: bool = False,
+                 png_frag: int = 0, r565_delta: bool = False, compress: bool = False):
+        if port.startswith("vendor"):
+            self.ser = VendorBulkPort(port)
+        else:
+            # 对 CDC ACM，波特率一般无意义，但 pyserial 仍要求填
+            self.ser = serial.Serial(port=port, baudrate=baud, timeout=timeout, write_timeout=1)
         self.seq = 1
+        self.enable_crc = enable_crc
+        self.png_frag = png_frag
+        self.r565_delta = r565_delta
+        self.compress = compress
+        self._r565_base: Optional[tuple[int, int, bool, bytes]] = None  # 下位机当前位图 (w, h, swap, raw)
+        self._r565_since_full = 0
+        self._msg_base: Optional[tuple[int, tuple, float]] = None  # 增量快照基准 (seq, 字段, 发送时间)
+        self._rx = bytearray()  # poll_frames 的未完成数据
 
     def close(self):
         try:
@@ -165,8 +383,14 @@ class HostSender:
         except Exception:
             pass
 
-    def send_frame(self, magic4: bytes, payload: bytes, typ: int = 0, flags: int = 0):
-        hdr = pack_header(magic4, len(payload), self.seq, typ=typ, flags=flags, crc32=0)
+    def send_frame(self, magic4: bytes, payload: bytes, typ: int = 0, flags: int = 0, rsv: int = 0):
+        if self.compress and len(payload) >= FRAME_LZ4_MIN:
+            z = struct.pack("<I", len(payload)) + lz4_block_encode(payload)
+            if len(z) < len(payload):
+                payload = z
+                flags |= FRAME_FLAG_LZ4
+        crc32 = zlib.crc32(payload) if self.enable_crc else 0
+        hdr = pack_header(magic4, len(payload), self.seq, typ=typ, flags=flags, crc32=crc32, rsv=rsv)
         self.ser.write(hdr)
         self.ser.write(payload)
         self.seq += 1
@@ -175,6 +399,30 @@ class HostSender:
         payload = struct.pack("<B", cmd & 0xFF) + snap.pack()
         self.send_frame(MAGIC_MSGF, payload)
 
+    def send_msgf_auto(self, snap: MsgfSnapshot, keyframe_s: float):
+        """keyframe_s 秒内发相对最近整包的增量快照（只带变化字段），到期或 keyframe_s<=0 时发整包"""
+        now = time.time()
+        base = self._msg_base
+        if keyframe_s <= 0 or base is None or now - base[2] >= keyframe_s:
+            self._msg_base = (self.seq, struct.unpack(SNAP_FMT, snap.pack()), now)
+            self.send_msgf(snap)
+            return
+        fields = struct.unpack(SNAP_FMT, snap.pack())
+        mask = 0
+        body = b""
+        for i, (code, old, new) in enumerate(zip(SNAP_FMT[1:], base[1], fields)):
+            if old != new:
+                mask |= 1 << i
+                body += struct.pack("<" + code, new)
+        self.send_frame(MAGIC_MSGF, struct.pack("<BIH", MSG_CMD_SNAPSHOT_DELTA, base[0], mask) + body)
+
+    def send_msgf_batch(self, payloads: List[bytes]):
+        """把若干条 MSGF payload 合并成一帧 CMD=0x06；每条占用一个 seq，帧头 seq 为第一条的"""
+        first = self.seq
+        body = b"".join(struct.pack("<BI", len(p), first + i) + p for i, p in enumerate(payloads))
+        self.send_frame(MAGIC_MSGF, struct.pack("<B", MSG_CMD_BATCH) + body)
+        self.seq = first + len(payloads)
+
     def send_msgf_cmd_only(self, cmd: int):
         payload = struct.pack("<B", cmd & 0xFF)
         self.send_frame(MAGIC_MSGF, payload)
@@ -187,6 +435,136 @@ class HostSender:
         payload = struct.pack("<BB", MSG_CMD_OFFSET_ROTATION, int(offset_rotation) & 0xFF)
         self.send_frame(MAGIC_MSGF, payload)
 
+    def read_frame(self, magic4: bytes, timeout_s: float = 1.0) -> Optional[bytes]:
+        """读取下位机回传的一帧（同样的 20 字节帧头），返回 payload；超时返回 None"""
+        buf = bytearray()
+        deadline = time.time() + timeout_s
+        while time.time() < deadline:
+            chunk = self.ser.read(self.ser.in_waiting or 1)
+            if chunk:
+                buf += chunk
+            i = buf.find(magic4)
+            if i < 0:
+                del buf[:max(0, len(buf) - 3)]
+                continue
+            del buf[:i]
+            if len(buf) < HEADER_LEN:
+                continue
+            _, _, _, _, length, crc32, _ = struct.unpack(HEADER_FMT, bytes(buf[:HEADER_LEN]))
+            if len(buf) < HEADER_LEN + length:
+                continue
+            payload = bytes(buf[HEADER_LEN:HEADER_LEN + length])
+            if crc32 and zlib.crc32(payload) != crc32:
+                del buf[:4]
+                continue
+            return payload
+        return None
+
+    def poll_frames(self, magic4: bytes) -> List[bytes]:
+        """不阻塞：取出接收缓冲里已完整到达的 magic4 帧的 payload（其它帧丢弃）"""
+        n = self.ser.in_waiting
+        if n:
+            self._rx += self.ser.read(n)
+        out = []
+        while True:
+            i = self._rx.find(magic4)
+            if i < 0:
+                del self._rx[:max(0, len(self._rx) - 3)]
+                return out
+            del self._rx[:i]
+            if len(self._rx) < HEADER_LEN:
+                return out
+            _, _, _, _, length, crc32, _ = struct.unpack(HEADER_FMT, bytes(self._rx[:HEADER_LEN]))
+            if len(self._rx) < HEADER_LEN + length:
+                return out
+            payload = bytes(self._rx[HEADER_LEN:HEADER_LEN + length])
+            del self._rx[:HEADER_LEN + length]
+            if not crc32 or zlib.crc32(payload) == crc32:
+                out.append(payload)
+
+    def query_perf(self, reset: bool = False, timeout_s: float = 1.0) -> Optional[dict]:
+        """CMD=0x04：取回下位机时延统计，返回 {指标名: (count, min, avg, p50, p99, max)}，单位 us"""
+        self.ser.reset_input_buffer()
+        self.send_frame(MAGIC_MSGF, struct.pack("<BB", MSG_CMD_GET_PERF, 0x01 if reset else 0x00))
+        payload = self.read_frame(MAGIC_PERF, timeout_s)
+        if payload is None or len(payload) < 4 or payload[0] != 1:
+            return None
+        n = payload[1]
+        out = {}
+        for k in range(n):
+            rec = payload[4 + k * 28:4 + (k + 1) * 28]
+            if len(rec) < 28:
+                break
+            mid = rec[0]
+            name = PERF_METRICS[mid] if mid < len(PERF_METRICS) else f"metric{mid}"
+            out[name] = struct.unpack("<6I", rec[4:])
+        return out
+
+    def query_hello(self, timeout_s: float = 0.5) -> Optional[dict]:
+        """CMD=0x09：取回下位机能力（hud_hello_wire_t）；握手之前的旧固件不回，返回 None"""
+        self.ser.reset_input_buffer()
+        crc, self.enable_crc = self.enable_crc, True   # 下位机要求 CRC 时不带 CRC 的握手会被丢掉
+        self.send_frame(MAGIC_MSGF, struct.pack("<B", MSG_CMD_HELLO))
+        self.enable_crc = crc
+        payload = self.read_frame(MAGIC_HELO, timeout_s)
+        if payload is None or len(payload) < struct.calcsize(HELO_FMT) or payload[0] != 1:
+            return None
+        return dict(zip(HELO_FIELDS, struct.unpack_from(HELO_FMT, payload)))
+
+    def query_tasks(self, timeout_s: float = 1.0) -> Optional[dict]:
+        """CMD=0x07：取回任务监视数据，{window_ms, flags, core_busy: [..], tasks: [dict]}；255 = 本固件测不了"""
+        self.ser.reset_input_buffer()
+        self.send_frame(MAGIC_MSGF, struct.pack("<B", MSG_CMD_GET_TASKS))
+        payload = self.read_frame(MAGIC_TASK, timeout_s)
+        if payload is None or len(payload) < 12 or payload[0] != 1:
+            return None
+        n, ncores, flags = payload[1], payload[2], payload[3]
+        window_ms, = struct.unpack_from("<I", payload, 4)
+        out = {"window_ms": window_ms, "flags": flags, "core_busy": list(payload[8:8 + ncores]), "tasks": []}
+        for k in range(n):
+            off = 12 + k * 20
+            if off + 20 > len(payload):
+                break
+            name, core, prio, base, cpu, stack_free, _ = struct.unpack_from(TASK_REC_FMT, payload, off)
+            out["tasks"].append({"name": name.rstrip(b"\0").decode(errors="replace"), "core": core, "prio": prio,
+                                 "base_prio": base, "cpu_pct": cpu, "stack_free": stack_free})
+        return out
+
+    def query_trace(self, clear: bool = False, timeout_s: float = 3.0) -> Optional[dict]:
+        """CMD=0x0A：取回各核事件环形缓冲，{now_us, lost: {core: n}, records: [(core, t_us, id, seq, arg)]}，
+        每核按时间先后；旧固件不回，返回 None"""
+        self.ser.reset_input_buffer()
+        self._rx.clear()
+        self.send_frame(MAGIC_MSGF, struct.pack("<BB", MSG_CMD_GET_TRACE, 0x01 if clear else 0x00))
+        hdr_len = struct.calcsize(TRCE_HDR_FMT)
+        rec_len = struct.calcsize(TRCE_REC_FMT)
+        chunks = {}
+        ncores = None
+        now_us = 0
+        lost = {}
+        deadline = time.time() + timeout_s
+        while time.time() < deadline:
+            for p in self.poll_frames(MAGIC_TRCE):
+                if len(p) < hdr_len or p[0] != 1:
+                    continue
+                _, core, ncores, _, k, nk, now_us, n_lost = struct.unpack_from(TRCE_HDR_FMT, p)
+                chunks[(core, k)] = (nk, p[hdr_len:])
+                lost[core] = n_lost
+                deadline = time.time() + 1.0   # 后面的分片接着到
+            if ncores is not None and all((c, 0) in chunks and all((c, k) in chunks for k in range(chunks[(c, 0)][0]))
+                                          for c in range(ncores)):
+                break
+            time.sleep(0.01)
+        if ncores is None:
+            return None
+        records = []
+        for (core, k) in sorted(chunks):
+            body = chunks[(core, k)][1]
+            for off in range(0, len(body) - rec_len + 1, rec_len):
+                t_us, seq, arg, eid, _, _ = struct.unpack_from(TRCE_REC_FMT, body, off)
+                records.append((core, t_us, eid, seq, arg))
+        return {"now_us": now_us, "lost": lost, "records": records}
+
     def send_imgf(self, png_path: str):
         with open(png_path, "rb") as f:
             png = f.read()
@@ -194,16 +572,225 @@ class HostSender:
     
     def send_imgf_bytes(self, png: bytes):
         now = time.time()
+        if self.png_frag > 0 and len(png) > self.png_frag:
+            n = self.send_imgf_png_frags(png, self.png_frag)
+            print(f" Sent IMGF {len(png)} bytes as {n} fragments in {int((time.time() - now) * 1000):03d} ms")
+            return
         self.send_frame(MAGIC_IMGF, png)
         print(f" Sent IMGF {len(png)} bytes in {int((time.time() - now) * 1000):03d} ms")
 
+    def send_imgf_png_frags(self, png: bytes, frag_size: int) -> int:
+        """PNG 分片发送：下位机边收边解码，返回分片数"""
+        parts = [png[i:i + frag_size] for i in range(0, len(png), frag_size)]
+        for idx, part in enumerate(parts):
+            flags = (IMGF_FLAG_FIRST if idx == 0 else 0) | (IMGF_FLAG_LAST if idx == len(parts) - 1 else 0)
+            self.send_frame(MAGIC_IMGF, part, typ=IMGF_TYPE_PNG_FRAG, flags=flags, rsv=idx)
+        return len(parts)
+
     def send_imgf_r565_bytes(self, frame: bytes):
         now = time.time()
-        self.send_frame(MAGIC_IMGF, frame)
+        self.send_frame(MAGIC_IMGF, frame, typ=IMGF_TYPE_R565)
         print(f" Sent IMGF(R565) {len(frame)} bytes in {int((time.time() - now) * 1000):03d} ms")
 
+    def send_imgf_track(self, payload: bytes):
+        self.send_frame(MAGIC_IMGF, payload, typ=IMGF_TYPE_TRACK)
+        print(f" Sent IMGF(track) {len(payload)} bytes")
+
+    def send_imgf_tile_map(self, w: int, h: int, tiles: List[tuple[int, int, bytes, bytes]], bg: int = 0):
+        """IMGF type=6：只发布局，再按下位机回报的 'TMIS' 补发缓存里没有的瓦片（type=5）"""
+        layout = b"TMAP" + struct.pack("<HHHH", w, h, len(tiles), bg)
+        layout += b"".join(struct.pack("<hh", dx, dy) + key for dx, dy, key, _ in tiles)
+        by_key = {key: body for _, _, key, body in tiles}
+        self.ser.reset_input_buffer()
+        self.send_frame(MAGIC_IMGF, layout, typ=IMGF_TYPE_TILE_MAP)
+        sent = total = 0
+        # 每个 TMIS 最多 64 个编号，缺得多时会连着来几帧
+        timeout = 0.5
+        while True:
+            miss = self.read_frame(MAGIC_TMIS, timeout)
+            if miss is None:
+                break
+            timeout = 0.1
+            for i in range(0, len(miss) - 11, 12):
+                body = by_key.get(miss[i:i + 12])
+                if body is not None:
+                    self.send_frame(MAGIC_IMGF, miss[i:i + 12] + body, typ=IMGF_TYPE_TILE)
+                    sent += 1
+                    total += 12 + len(body)
+        print(f" Sent IMGF(tile map) {len(tiles)} tiles, {sent} missing tiles resent ({total} bytes)")
+
+    def send_imgf_tile_view(self, z: int, px: int, py: int, bg: int = 0):
+        self.send_frame(MAGIC_IMGF, b"TVEW" + struct.pack("<BBHII", z, 0, bg, px, py), typ=IMGF_TYPE_TILE_VIEW)
+
+    def send_imgf_r565_image(self, w: int, h: int, raw: bytes, swap_bytes: bool, codec: str):
+        """发送 RGB565 位图；--r565-delta 时与上一帧比较，只发送变化的矩形"""
+        base = self._r565_base
+        rects = None
+        if (self.r565_delta and base and base[:3] == (w, h, swap_bytes)
+                and self._r565_since_full < R565_DELTA_KEYFRAME):
+            rects = r565_dirty_rects(base[3], raw, w, h)
+            if sum(rw * rh for _, _, rw, rh in rects) * 10 > w * h * 6:
+                rects = None  # 变化太多，不如整帧
+        self._r565_base = (w, h, swap_bytes, raw)
+        if rects is None:
+            self._r565_since_full = 0
+            self.send_imgf_r565_bytes(r565_payload(w, h, w, raw, swap_bytes, codec))
+            return
+        self._r565_since_full += 1
+        now = time.time()
+        total = 0
+        for x, y, rw, rh in rects:
+            sub = b"".join(raw[((y + r) * w + x) * 2:((y + r) * w + x + rw) * 2] for r in range(rh))
+            payload = struct.pack("<HHHH", x, y, w, h) + r565_payload(rw, rh, rw, sub, swap_bytes, codec)
+            self.send_frame(MAGIC_IMGF, payload, typ=IMGF_TYPE_R565_RECT)
+            total += len(payload)
+        print(f" Sent IMGF(R565 delta) {len(rects)} rects {total} bytes in {int((time.time() - now) * 1000):03d} ms")
+
+
+R565_CODECS = {"raw": 0, "rle": 1, "lz4": 2, "qoi": 3}
+R565_FLAG_SWAPPED = 0x01
+
+
+def rle16_encode(raw: bytes) -> bytes:
+    """按像素(2字节)游程编码：c<0x80 后跟 c+1 个原样像素；c>=0x80 表示下一个像素重复 (c&0x7f)+1 次"""
+    px = [raw[i:i + 2] for i in range(0, len(raw), 2)]
+    out = bytearray()
+    i, n = 0, len(px)
+    while i < n:
+        run = 1
+        while i + run < n and run < 128 and px[i + run] == px[i]:
+            run += 1
+        if run >= 2:
+            out.append(0x80 | (run - 1))
+            out += px[i]
+            i += run
+            continue
+        j = i
+        while j < n and j - i < 128 and not (j + 1 < n and px[j + 1] == px[j]):
+            j += 1
+        j = max(j, i + 1)
+        out.append(j - i - 1)
+        out += b"".join(px[i:j])
+        i = j
+    return bytes(out)
 
-def png_to_r565_frame(png: bytes, resize_to: Optional[tuple[int, int]] = None, swap_bytes: bool = False) -> bytes:
+
+def lz4_block_encode(src: bytes) -> bytes:
+    """最简贪心 LZ4 块压缩（无帧头），遵守末尾 5 字节为字面量、最后匹配距结尾 >=12 字节的规则"""
+    def put_len(out: bytearray, n: int):
+        while n >= 255:
+            out.append(255)
+            n -= 255
+        out.append(n)
+
+    out = bytearray()
+    n = len(src)
+    table = {}
+    anchor = i = 0
+    limit = n - 12
+    while i < limit:
+        key = src[i:i + 4]
+        cand = table.get(key)
+        table[key] = i
+        if cand is None or i - cand > 0xFFFF:
+            i += 1
+            continue
+        mlen = 4
+        while i + mlen < n - 5 and src[cand + mlen] == src[i + mlen]:
+            mlen += 1
+        lit = i - anchor
+        tok = (min(lit, 15) << 4) | min(mlen - 4, 15)
+        out.append(tok)
+        if lit >= 15:
+            put_len(out, lit - 15)
+        out += src[anchor:i]
+        out += struct.pack("<H", i - cand)
+        if mlen - 4 >= 15:
+            put_len(out, mlen - 4 - 15)
+        i += mlen
+        anchor = i
+    lit = n - anchor
+    out.append(min(lit, 15) << 4)
+    if lit >= 15:
+        put_len(out, lit - 15)
+    out += src[anchor:]
+    return bytes(out)
+
+
+def qoi_encode_r565(w: int, h: int, stride: int, raw: bytes, swap_bytes: bool) -> bytes:
+    """RGB565 像素展开成 RGB888 后按 QOI 编码（3 通道）；下位机截回 565 时与原像素逐位一致"""
+    fmt = ">H" if swap_bytes else "<H"
+    out = bytearray(b"qoif" + struct.pack(">IIBB", w, h, 3, 0))
+    index = [(0, 0, 0, 0)] * 64
+    prev = (0, 0, 0, 255)
+    run = 0
+    for y in range(h):
+        row = raw[y * stride * 2:(y * stride + w) * 2]
+        for x in range(w):
+            v = struct.unpack_from(fmt, row, x * 2)[0]
+            r5, g6, b5 = v >> 11, (v >> 5) & 0x3F, v & 0x1F
+            px = ((r5 << 3) | (r5 >> 2), (g6 << 2) | (g6 >> 4), (b5 << 3) | (b5 >> 2), 255)
+            if px == prev:
+                run += 1
+                if run == 62:
+                    out.append(0xC0 | (run - 1))
+                    run = 0
+                continue
+            if run:
+                out.append(0xC0 | (run - 1))
+                run = 0
+            hsh = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64
+            if index[hsh] == px:
+                out.append(hsh)
+            else:
+                index[hsh] = px
+                dr = (px[0] - prev[0] + 128) % 256 - 128
+                dg = (px[1] - prev[1] + 128) % 256 - 128
+                db = (px[2] - prev[2] + 128) % 256 - 128
+                if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+                    out.append(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2))
+                elif -32 <= dg <= 31 and -8 <= dr - dg <= 7 and -8 <= db - dg <= 7:
+                    out.append(0x80 | (dg + 32))
+                    out.append(((dr - dg + 8) << 4) | (db - dg + 8))
+                else:
+                    out += bytes((0xFE, px[0], px[1], px[2]))
+            prev = px
+    if run:
+        out.append(0xC0 | (run - 1))
+    out += b"\x00" * 7 + b"\x01"
+    return bytes(out)
+
+
+R565_DELTA_TILE = 16       # 脏区检测粒度(像素)
+R565_DELTA_KEYFRAME = 10   # 每隔若干次局部更新强制整帧，防止下位机丢帧后一直错位
+
+
+def r565_dirty_rects(old: bytes, new: bytes, w: int, h: int) -> List[tuple[int, int, int, int]]:
+    """按 R565_DELTA_TILE 网格比较两帧，同一行内相邻的脏块合并为一个矩形"""
+    t = R565_DELTA_TILE
+    rects = []
+    for ty in range(0, h, t):
+        th = min(t, h - ty)
+        run_x = None
+        for tx in range(0, w + t, t):
+            dirty = False
+            if tx < w:
+                tw = min(t, w - tx)
+                for r in range(ty, ty + th):
+                    a = (r * w + tx) * 2
+                    if old[a:a + tw * 2] != new[a:a + tw * 2]:
+                        dirty = True
+                        break
+            if dirty and run_x is None:
+                run_x = tx
+            elif not dirty and run_x is not None:
+                rects.append((run_x, ty, min(tx, w) - run_x, th))
+                run_x = None
+    return rects
+
+
+def png_to_r565_pixels(png: bytes, resize_to: Optional[tuple[int, int]] = None,
+                       swap_bytes: bool = False) -> tuple[int, int, bytes]:
     img = Image.open(io.BytesIO(png)).convert("RGB")
     if resize_to:
         try:
@@ -219,10 +806,84 @@ def png_to_r565_frame(png: bytes, resize_to: Optional[tuple[int, int]] = None, s
             raw.extend(struct.pack(">H", v))
         else:
             raw.extend(struct.pack("<H", v))
-    # 8 bytes header: "R565" + w + h
-    return b"R565" + struct.pack("<HH", w, h) + bytes(raw)
+    return w, h, bytes(raw)
+
+
+def r565_payload(w: int, h: int, stride: int, raw: bytes, swap_bytes: bool, codec: str) -> bytes:
+    if codec == "rle":
+        data = rle16_encode(raw)
+    elif codec == "lz4":
+        data = lz4_block_encode(raw)
+    elif codec == "qoi":
+        data = qoi_encode_r565(w, h, stride, raw, swap_bytes)
+        stride = w  # QOI 文件是紧排的 w*h，像素序由下位机按需输出，flags 不起作用
+    else:
+        data = raw
+    raw_len = w * h * 2 if codec == "qoi" else len(raw)
+    # 16 bytes header: "R565" + w + h + stride + codec + flags + raw_len
+    flags = R565_FLAG_SWAPPED if swap_bytes else 0
+    return b"R565" + struct.pack("<HHHBBI", w, h, stride, R565_CODECS[codec], flags, raw_len) + data
+
+
+def send_png_as_r565(sender: HostSender, png: bytes, img_w: Optional[int], img_h: Optional[int],
+                     swap_bytes: bool, codec: str):
+    w, h, raw = png_to_r565_pixels(png, (img_w, img_h) if img_w and img_h else None, swap_bytes)
+    sender.send_imgf_r565_image(w, h, raw, swap_bytes, codec)
 
 
+def split_r565_tiles(w: int, h: int, raw: bytes, swap_bytes: bool, codec: str) -> List[tuple[int, int, bytes, bytes]]:
+    """切成 TILE_PX 见方的瓦片：编号取像素的 CRC（z=0），同样的内容下次直接命中下位机缓存"""
+    tiles = []
+    for ty in range(0, h, TILE_PX):
+        for tx in range(0, w, TILE_PX):
+            tw, th = min(TILE_PX, w - tx), min(TILE_PX, h - ty)
+            sub = b"".join(raw[((ty + r) * w + tx) * 2:((ty + r) * w + tx + tw) * 2] for r in range(th))
+            crc = zlib.crc32(sub)
+            key = struct.pack("<B3xII", 0, crc & 0x0FFFFFFF, (tw << 8) | th)
+            tiles.append((tx, ty, key, r565_payload(tw, th, tw, sub, swap_bytes, codec)))
+    return tiles
+
+
+def send_png_as_tiles(sender: HostSender, png: bytes, img_w: Optional[int], img_h: Optional[int],
+                      swap_bytes: bool, codec: str):
+    w, h, raw = png_to_r565_pixels(png, (img_w, img_h) if img_w and img_h else None, swap_bytes)
+    sender.send_imgf_tile_map(w, h, split_r565_tiles(w, h, raw, swap_bytes, codec))
+
+
+class TileWorld:
+    """瓦片视口演示：把一张 PNG 当作 z=0 的整个世界，视口沿椭圆来回平移，按下位机回报切瓦片补发"""
+
+    VIEW = 260  # 下位机地图区域边长
+
+    def __init__(self, png: bytes, swap_bytes: bool, codec: str):
+        self.w, self.h, self.raw = png_to_r565_pixels(png, None, swap_bytes)
+        self.swap_bytes = swap_bytes
+        self.codec = codec
+        self.t0 = time.time()
+
+    def position(self, now: float) -> tuple[int, int]:
+        a = (now - self.t0) * 0.2
+        cx = (self.w - self.VIEW) / 2
+        cy = (self.h - self.VIEW) / 2
+        return int(cx + cx * math.cos(a)), int(cy + cy * math.sin(a))
+
+    def tile(self, x: int, y: int) -> bytes:
+        rows = []
+        for r in range(TILE_PX):
+            yy = y * TILE_PX + r
+            x0 = x * TILE_PX
+            row = self.raw[(yy * self.w + x0) * 2:(yy * self.w + min(x0 + TILE_PX, self.w)) * 2] if yy < self.h and x0 < self.w else b""
+            rows.append(row + b"\x00" * (TILE_PX * 2 - len(row)))
+        return r565_payload(TILE_PX, TILE_PX, TILE_PX, b"".join(rows), self.swap_bytes, self.codec)
+
+    def step(self, sender: "HostSender", now: float):
+        for miss in sender.poll_frames(MAGIC_TMIS):
+            for i in range(0, len(miss) - 11, 12):
+                _, x, y = struct.unpack("<B3xII", miss[i:i + 12])
+                sender.send_frame(MAGIC_IMGF, miss[i:i + 12] + self.tile(x, y), typ=IMGF_TYPE_TILE)
+        px, py = self.position(now)
+        sender.send_imgf_tile_view(0, max(0, px), max(0, py))
+
 
 def run_demo(
     sender: HostSender, hz: float, 
@@ -234,11 +895,17 @@ def run_demo(
     img_w: Optional[int],
     img_h: Optional[int],
     r565_swap_bytes: bool,
+    r565_codec: str = "rle",
+    msg_keyframe_s: float = 1.0,
+    vector: Optional[VectorTrack] = None,
+    tile_world: Optional[TileWorld] = None,
+    tile_view_every_s: float = 0.3,
     ):
     """演示：MSGF 按 hz 发送；IMGF 每 png_every_s 秒发一次（如果提供 png_path）"""
     period = 1.0 / hz
     next_png = time.time() + png_every_s if (png_path and png_every_s > 0) else float("inf")
-    next_fetch = time.time() + track_every_s if fetcher else float("inf")
+    next_fetch = time.time() + track_every_s if (fetcher or vector) else float("inf")
+    next_view = time.time() if tile_world else float("inf")
     
     # 初始化一些演示数据
     speed = 80
@@ -307,19 +974,21 @@ def run_demo(
             f"{curr_min:04d} {trip_min:04d} {fuel_left_dl/10:.1f}/{fuel_total_dl/10:.1f}",
             end="\r",
         )
-        sender.send_msgf(snap, cmd=MSG_CMD_SNAPSHOT)
+        sender.send_msgf_auto(snap, msg_keyframe_s)
         
+        # 瓦片视口：按间隔发视口位置，顺带补发下位机回报缺的瓦片
+        if tile_world and now >= next_view:
+            tile_world.step(sender, now)
+            next_view = now + tile_view_every_s
+
         # 原有：本地 PNG demo
         if now >= next_png and png_path:
             with open(png_path, "rb") as f:
                 png = f.read()
             if img_mode == "r565":
-                frame = png_to_r565_frame(
-                    png,
-                    (img_w, img_h) if img_w and img_h else None,
-                    swap_bytes=r565_swap_bytes,
-                )
-                sender.send_imgf_r565_bytes(frame)
+                send_png_as_r565(sender, png, img_w, img_h, r565_swap_bytes, r565_codec)
+            elif img_mode == "tiles":
+                send_png_as_tiles(sender, png, img_w, img_h, r565_swap_bytes, r565_codec)
             else:
                 sender.send_imgf_bytes(png)
             next_png = now + png_every_s
@@ -328,16 +997,20 @@ def run_demo(
         if fetcher and now >= next_fetch:
             png = fetcher.fetch_next()
             if img_mode == "r565":
-                frame = png_to_r565_frame(
-                    png,
-                    (img_w, img_h) if img_w and img_h else None,
-                    swap_bytes=r565_swap_bytes,
-                )
-                sender.send_imgf_r565_bytes(frame)
+                send_png_as_r565(sender, png, img_w, img_h, r565_swap_bytes, r565_codec)
+            elif img_mode == "tiles":
+                send_png_as_tiles(sender, png, img_w, img_h, r565_swap_bytes, r565_codec)
             else:
                 sender.send_imgf_bytes(png)
             next_fetch = now + track_every_s
 
+        # 矢量轨迹：每次只发一个新点，由下位机画线
+        if vector and now >= next_fetch:
+            payload = vector.next_payload()
+            if payload:
+                sender.send_imgf_track(payload)
+            next_fetch = now + track_every_s
+
 
         # 固定频率循环
         elapsed = time.time() - last
@@ -347,10 +1020,376 @@ def run_demo(
         last = time.time()
 
 
+def print_perf(stats: Optional[dict]):
+    if stats is None:
+        print(" PERF: no reply")
+        return
+    print(f" {'metric':<16}{'count':>8}{'min':>9}{'avg':>9}{'p50':>9}{'p99':>9}{'max':>9}  (us)")
+    for name, (count, mn, avg, p50, p99, mx) in stats.items():
+        print(f" {name:<16}{count:>8}{mn:>9}{avg:>9}{p50:>9}{p99:>9}{mx:>9}")
+
+
+def print_tasks(rep: Optional[dict]):
+    if rep is None:
+        print(" TASK: no reply")
+        return
+    busy = " ".join(f"core{c} {'-' if b == 255 else str(b) + '%'}" for c, b in enumerate(rep["core_busy"]))
+    est = " (idle-hook estimate)" if rep["flags"] & 0x02 else ""
+    print(f" {rep['window_ms']} ms window, cpu {busy}{est}")
+    print(f" {'task':<12}{'core':>5}{'prio':>6}{'cpu':>6}{'stack_free':>12}")
+    for t in rep["tasks"]:
+        core = "any" if t["core"] == 255 else str(t["core"])
+        cpu = "-" if t["cpu_pct"] == 255 else f"{t['cpu_pct']}%"
+        # 当前优先级高于分配值 = 它持有高优先级任务在等的互斥量
+        prio = f"{t['prio']}{'!' if t['prio'] > t['base_prio'] else ''}"
+        print(f" {t['name']:<12}{core:>5}{prio:>6}{cpu:>6}{t['stack_free']:>12}")
+
+
+def print_hello(hello: Optional[dict]):
+    if hello is None:
+        print(" HELO: no reply (firmware without the capability handshake)")
+        return
+    codecs = [n for n, c in R565_CODECS.items() if hello["r565_codecs"] >> c & 1]
+    print(f" board {hello['board']:#04x} proto {hello['proto_rev']} screen {hello['screen_w']}x{hello['screen_h']}"
+          f" map {hello['map_w']}x{hello['map_h']}")
+    print(f" imgf types {hello['imgf_types']:#04x} r565 {','.join(codecs)} lz4 {bool(hello['frame_codecs'] & HELO_CODEC_LZ4)}"
+          f" features {hello['features']:#04x} msgf cmds {hello['msgf_cmds']:#x}")
+    print(f" imgf {hello['img_slots']} x {hello['img_max_bytes']} B, msgf {hello['msg_queue']} x {hello['msg_max_bytes']} B,"
+          f" mux channels {hello['mux_channels']}")
+
+
+def trace_to_chrome(tr: dict) -> dict:
+    """TRCE 记录 -> Chrome trace JSON（chrome://tracing、ui.perfetto.dev 都能打开）：每核一条线程，
+    hud_perf 时长为区间，阶段戳与图像事件为瞬时事件，同一快照 seq 从首个到最后一个阶段连成一条异步区间"""
+    def rel(t):
+        return ((t - tr["now_us"] + (1 << 31)) & 0xFFFFFFFF) - (1 << 31)   # dump 时刻之前的 us（负数）
+    recs = tr["records"]
+    # 时长事件的起点在记录时刻之前
+    base = min((rel(t) - (arg if TR_METRIC <= eid < TR_METRIC + len(PERF_METRICS) else 0)
+                for _, t, eid, _, arg in recs), default=0)
+    ev = [{"ph": "M", "name": "thread_name", "pid": 0, "tid": c, "args": {"name": f"core{c}"}}
+          for c in sorted({r[0] for r in recs})]
+    spans = {}
+    for core, t, eid, seq, arg in recs:
+        ts = rel(t) - base
+        e = {"pid": 0, "tid": core, "ts": ts}
+        if TR_STAGE <= eid < TR_STAGE + len(TRACE_STAGES):
+            e.update(ph="i", s="t", name=f"snap {TRACE_STAGES[eid - TR_STAGE]}", args={"seq": seq})
+            first, last = spans.get(seq, (ts, ts))
+            spans[seq] = (min(first, ts), max(last, ts))
+        elif TR_METRIC <= eid < TR_METRIC + len(PERF_METRICS):
+            e.update(ph="X", name=PERF_METRICS[eid - TR_METRIC], ts=ts - arg, dur=arg)
+        elif eid == TR_IMG_DISPATCH:
+            e.update(ph="i", s="t", name="img dispatch", args={"seq": seq, "type": arg >> 24, "len": arg & 0xFFFFFF})
+        elif eid in (TR_IMG_QUEUED, TR_IMG_REPLACED, TR_IMG_DROPPED):
+            name = {TR_IMG_QUEUED: "img queued", TR_IMG_REPLACED: "img replaced oldest",
+                    TR_IMG_DROPPED: "img dropped"}[eid]
+            e.update(ph="i", s="t", name=name, args={"token": seq, "queue_depth": arg})
+        elif eid == TR_IMG_APPLY_BEGIN:
+            e.update(ph="B", name="img apply", args={"token": seq, "len": arg})
+        elif eid == TR_IMG_APPLY_END:
+            e.update(ph="E", name="img apply")
+        else:
+            e.update(ph="i", s="t", name=f"event{eid}", args={"seq": seq, "arg": arg})
+        ev.append(e)
+    for seq, (first, last) in spans.items():
+        if last > first:
+            ev.append({"ph": "b", "cat": "snapshot", "id": seq, "name": "snapshot", "pid": 0, "tid": 0, "ts": first})
+            ev.append({"ph": "e", "cat": "snapshot", "id": seq, "name": "snapshot", "pid": 0, "tid": 0, "ts": last})
+    return {"traceEvents": ev, "displayTimeUnit": "ms", "otherData": {"lost": tr["lost"]}}
+
+
+def save_trace(tr: Optional[dict], path: str):
+    if tr is None:
+        print(" TRCE: no reply (firmware without the event trace)")
+        return
+    with open(path, "w", encoding="utf-8") as f:
+        json.dump(trace_to_chrome(tr), f)
+    recs = tr["records"]
+    per_core = {}
+    for r in recs:
+        per_core[r[0]] = per_core.get(r[0], 0) + 1
+    span_ms = (max(r[1] for r in recs) - min(r[1] for r in recs)) / 1000 if recs else 0
+    print(f" trace: {len(recs)} events {per_core} over ~{span_ms:.0f} ms, lost to wrap {tr['lost']} -> {path}")
+
+
+def pick_encoding(args, hello: Optional[dict]):
+    """按握手结果补全 --img-mode auto / --r565-codec / --img-w/-h：能发 RGB565 就不发 PNG（下位机免解码），
+    编码选最省带宽的（QOI > LZ4 > RLE），地图按下位机地图区尺寸出图，字节序跟随面板"""
+    if hello is None:
+        if args.img_mode == "auto":
+            args.img_mode = "png"
+        args.r565_codec = args.r565_codec or "rle"
+        return
+    if args.img_mode == "auto":
+        args.img_mode = "r565" if hello["imgf_types"] >> IMGF_TYPE_R565 & 1 else "png"
+    if args.r565_codec is None:
+        args.r565_codec = next((n for n in ("qoi", "lz4", "rle", "raw") if hello["r565_codecs"] >> R565_CODECS[n] & 1),
+                               "rle")
+    if args.img_w is None and args.img_h is None and hello["map_w"] and hello["map_h"]:
+        args.img_w, args.img_h = hello["map_w"], hello["map_h"]
+    if hello["features"] & HELO_F_SWAP565:
+        args.r565_swap_bytes = True
+    if hello["features"] & HELO_F_CRC_REQUIRED:
+        args.crc = True
+
+
+def parse_stat(payload: bytes) -> Optional[dict]:
+    base = struct.calcsize(STAT_FMT)
+    if len(payload) < base or payload[0] != 1:
+        return None
+    st = dict(zip(STAT_FIELDS, struct.unpack_from(STAT_FMT, payload)))
+    if len(payload) >= base + struct.calcsize(STAT_HEAP_FMT):
+        st.update(zip(STAT_HEAP_FIELDS, struct.unpack_from(STAT_HEAP_FMT, payload, base)))
+    return st
+
+
+def bench_image(kb: int) -> bytes:
+    """约 kb KB 的 R565 RAW 整帧（宽 260，按大小取行数），下位机照常解码上屏"""
+    w = 260
+    h = max(1, min(260, kb * 1024 // (w * 2)))
+    row = bytes(random.getrandbits(8) for _ in range(w * 2))
+    return r565_payload(w, h, 0, row * h, False, "raw")
+
+
+def run_bench_case(sender: HostSender, msg_hz: float, img_kb: int, img_hz: float, secs: float) -> dict:
+    """固定组合跑 secs 秒：MSGF 按 msg_hz（0=尽快发），img_kb>0 时每秒 img_hz 张 IMGF。
+    设备侧用首尾两帧 STAT 差分，时延取 PERF 里按 seq 匹配的 usb->glass"""
+    sender.query_perf(reset=True)
+    sender._rx.clear()
+    img = bench_image(img_kb) if img_kb > 0 else b""
+    snap = MsgfSnapshot(speed_kmh=0, engine_rpm=800, battery_mv=12600, fuel_left_dl=360, fuel_total_dl=520)
+    stats: List[dict] = []
+    sent_bytes = msg_n = img_n = 0
+    write_s = 0.0
+
+    t0 = time.time()
+    next_msg = next_img = t0
+    end = t0 + secs
+    while True:
+        now = time.time()
+        if now >= end:
+            break
+        if msg_hz <= 0 or now >= next_msg:
+            # 转速一直在变，下位机每帧都真的要重绘
+            snap.engine_rpm = 800 + (msg_n * 97) % 6200
+            snap.speed_kmh = snap.engine_rpm // 60
+            w0 = time.time()
+            sender.send_msgf(snap)
+            write_s += time.time() - w0
+            sent_bytes += HEADER_LEN + 1 + len(snap.pack())
+            msg_n += 1
+            next_msg += 1.0 / msg_hz if msg_hz > 0 else 0
+        if img and now >= next_img:
+            w0 = time.time()
+            sender.send_frame(MAGIC_IMGF, img, typ=IMGF_TYPE_R565)
+            write_s += time.time() - w0
+            sent_bytes += HEADER_LEN + len(img)
+            img_n += 1
+            next_img += 1.0 / img_hz
+        for p in sender.poll_frames(MAGIC_STAT):
+            st = parse_stat(p)
+            if st:
+                stats.append(st)
+        if msg_hz > 0:
+            wake = min(next_msg, next_img if img else end, end)
+            if wake > time.time():
+                time.sleep(min(wake - time.time(), 0.005))
+    elapsed = time.time() - t0
+
+    # 再等一帧 STAT，让最后这段也算进去
+    deadline = time.time() + 1.5
+    while time.time() < deadline and len(stats) < 2:
+        for p in sender.poll_frames(MAGIC_STAT):
+            st = parse_stat(p)
+            if st:
+                stats.append(st)
+        time.sleep(0.05)
+    perf = sender.query_perf() or {}
+
+    row = {
+        "msg_hz": msg_hz, "img_kb": img_kb, "img_hz": img_hz if img else 0, "crc": sender.enable_crc,
+        "secs": round(elapsed, 2), "msg_sent": msg_n, "img_sent": img_n,
+        "host_bytes": sent_bytes, "host_Bps": int(sent_bytes / elapsed) if elapsed else 0,
+        "host_write_ms": int(write_s * 1000),
+    }
+    if len(stats) >= 2:
+        a, b = stats[0], stats[-1]
+        dt = max(1, b["uptime_ms"] - a["uptime_ms"]) / 1000.0
+        d = lambda k: (b[k] - a[k]) & 0xFFFFFFFF
+        row.update({
+            "dev_rx_Bps": int(d("usb_bytes_rx") / dt),
+            "usb_ok": d("usb_frames_ok"), "usb_dropped": d("usb_frames_dropped"),
+            "usb_resync": d("usb_resync"), "usb_timeout": d("usb_frames_timeout"),
+            "imgf_ok": d("imgf_ok"), "imgf_drop": d("imgf_drop"), "imgf_bad": d("imgf_bad"),
+            "msgf_ok": d("msgf_ok"), "msgf_drop": d("msgf_drop"), "msgf_bad": d("msgf_bad"),
+            "img_replaced": d("ui_img_replaced"), "heap_min_internal": b["heap_min_internal"],
+        })
+    for name, key in (("usb->glass", "e2e"), ("render", "render"), ("img_decode", "decode")):
+        if name in perf:
+            count, _, avg, p50, p99, mx = perf[name]
+            row.update({f"{key}_count": count, f"{key}_p50_us": p50, f"{key}_p99_us": p99, f"{key}_max_us": mx})
+    return row
+
+
+def run_bench(sender: HostSender, msg_rates: List[float], img_sizes: List[int], img_hz: float,
+              crc_modes: List[bool], secs: float, out_path: Optional[str]):
+    """扫描 MSGF 频率 × IMGF 大小 × CRC 开关，每组打印一行，可存为 CSV / JSON（按扩展名）"""
+    rows = []
+    cols = ["msg_hz", "img_kb", "crc", "host_Bps", "dev_rx_Bps", "usb_dropped", "usb_resync",
+            "imgf_drop", "msgf_drop", "img_replaced", "e2e_p50_us", "e2e_p99_us"]
+    print(" " + " ".join(f"{c:>12}" for c in cols))
+    for crc in crc_modes:
+        sender.enable_crc = crc
+        for kb in img_sizes:
+            for hz in msg_rates:
+                row = run_bench_case(sender, hz, kb, img_hz, secs)
+                rows.append(row)
+                print(" " + " ".join(f"{str(row.get(c, '-')):>12}" for c in cols))
+                time.sleep(0.5)   # 让上一组的积压在下位机消化掉
+    if out_path:
+        if out_path.endswith(".json"):
+            with open(out_path, "w", encoding="utf-8") as f:
+                json.dump(rows, f, indent=2)
+        else:
+            keys = []
+            for r in rows:
+                keys += [k for k in r if k not in keys]
+            with open(out_path, "w", newline="", encoding="utf-8") as f:
+                wr = csv.DictWriter(f, fieldnames=keys)
+                wr.writeheader()
+                wr.writerows(rows)
+        print(f" Wrote {len(rows)} rows to {out_path}")
+    return rows
+
+
+def soak_image(w: int, h: int, rnd: random.Random) -> bytes:
+    """随机地图样的 PNG：底色 + 数量随机的色块与折线，压缩后大小每张不同，
+    下位机的 IMGF 缓冲与解码中间缓冲就按不同大小反复分配释放"""
+    from PIL import ImageDraw
+    img = Image.new("RGB", (w, h), (rnd.randrange(200, 256), rnd.randrange(200, 256), rnd.randrange(200, 256)))
+    dr = ImageDraw.Draw(img)
+    for _ in range(rnd.randrange(5, 400)):
+        x, y = rnd.randrange(w), rnd.randrange(h)
+        color = (rnd.randrange(256), rnd.randrange(256), rnd.randrange(256))
+        if rnd.random() < 0.5:
+            dr.rectangle([x, y, x + rnd.randrange(4, w // 3), y + rnd.randrange(4, h // 3)], fill=color)
+        else:
+            dr.line([x, y, rnd.randrange(w), rnd.randrange(h)], fill=color, width=rnd.randrange(1, 6))
+    bio = io.BytesIO()
+    img.save(bio, format="PNG")
+    return bio.getvalue()
+
+
+def lsq_slope_per_hour(ts: List[float], ys: List[float]) -> float:
+    n = len(ts)
+    if n < 2:
+        return 0.0
+    mx, my = sum(ts) / n, sum(ys) / n
+    den = sum((t - mx) ** 2 for t in ts)
+    return sum((t - mx) * (y - my) for t, y in zip(ts, ys)) / den * 3600 if den else 0.0
+
+
+def run_soak(sender: HostSender, hours: float, img_every_s: float, msg_hz: float, report_min: float,
+             png_path: Optional[str], map_size: tuple[int, int], out_path: Optional[str]):
+    """长时间重放地图流，记录 STAT 里的堆字段，看 PSRAM 最大空闲块是否随时间缩小（碎片）。
+    周期打印一行，结束时汇总并按趋势外推最大空闲块降到一张地图位图（宽×高×2）以下还剩多少小时"""
+    need = map_size[0] * map_size[1] * 2
+    fixed = None
+    if png_path:
+        with open(png_path, "rb") as f:
+            fixed = f.read()
+    rnd = random.Random(1)
+    snap = MsgfSnapshot(speed_kmh=60, engine_rpm=2000, battery_mv=12600, fuel_left_dl=360, fuel_total_dl=520)
+    rows: List[dict] = []
+    img_n = reboots = 0
+    last_uptime = None
+    t0 = time.time()
+    end = t0 + hours * 3600
+    next_msg = next_img = next_report = t0
+    cols = ["elapsed_h", "psram_free", "psram_largest", "largest_min", "dev_trend_Bph", "int_largest",
+            "imgf_drop", "decodes"]
+    print(f" soak {hours:g} h: image every {img_every_s:g} s, map bitmap {map_size[0]}x{map_size[1]} = {need} bytes")
+    print(" " + " ".join(f"{c:>14}" for c in cols))
+    try:
+        while time.time() < end:
+            now = time.time()
+            if now >= next_msg:
+                snap.odo_m += 5
+                sender.send_msgf(snap)   # 保持 UI 不休眠，休眠时下位机不上报 STAT
+                next_msg += 1.0 / msg_hz
+            if now >= next_img:
+                png = fixed or soak_image(map_size[0], map_size[1], rnd)
+                if sender.png_frag > 0 and len(png) > sender.png_frag:
+                    sender.send_imgf_png_frags(png, sender.png_frag)
+                else:
+                    sender.send_frame(MAGIC_IMGF, png)
+                img_n += 1
+                next_img += img_every_s
+            for p in sender.poll_frames(MAGIC_STAT):
+                st = parse_stat(p)
+                if not st:
+                    continue
+                if "heap_largest_psram" not in st:
+                    raise RuntimeError("device firmware does not report heap fragmentation in STAT")
+                if last_uptime is not None and st["uptime_ms"] < last_uptime:
+                    reboots += 1
+                    print(f" !! device rebooted at {(time.time() - t0) / 3600:.2f} h")
+                last_uptime = st["uptime_ms"]
+                st["elapsed_s"] = round(time.time() - t0, 1)
+                st["images_sent"] = img_n
+                rows.append(st)
+            if rows and now >= next_report:
+                r = rows[-1]
+                line = [f"{r['elapsed_s'] / 3600:.2f}", r["heap_free_psram"], r["heap_largest_psram"],
+                        r["heap_largest_min_psram"], r["heap_psram_trend"], r["heap_largest_internal"],
+                        r["imgf_drop"], r["decode_count"]]
+                print(" " + " ".join(f"{str(v):>14}" for v in line))
+                next_report += report_min * 60
+            time.sleep(min(max(0.0, min(next_msg, next_img) - time.time()), 0.01))
+    except KeyboardInterrupt:
+        print(" interrupted, summarising what was collected")
+
+    if out_path and rows:
+        keys = []
+        for r in rows:
+            keys += [k for k in r if k not in keys]
+        with open(out_path, "w", newline="", encoding="utf-8") as f:
+            wr = csv.DictWriter(f, fieldnames=keys)
+            wr.writeheader()
+            wr.writerows(rows)
+        print(f" Wrote {len(rows)} STAT samples to {out_path}")
+    if len(rows) < 2:
+        print(" not enough STAT samples for a trend")
+        return rows
+    a, b = rows[0], rows[-1]
+    ts = [r["elapsed_s"] for r in rows]
+    slope = lsq_slope_per_hour(ts, [r["heap_largest_psram"] for r in rows])
+    free_slope = lsq_slope_per_hour(ts, [r["heap_free_psram"] for r in rows])
+    print(f" images sent {img_n}, device decodes {(b['decode_count'] - a['decode_count']) & 0xFFFFFFFF}, "
+          f"imgf_drop {(b['imgf_drop'] - a['imgf_drop']) & 0xFFFFFFFF}, reboots {reboots}")
+    print(f" psram largest block {a['heap_largest_psram']} -> {b['heap_largest_psram']} "
+          f"(min {min(r['heap_largest_psram'] for r in rows)}), trend {slope:+.0f} B/h over the whole run")
+    print(f" psram free {a['heap_free_psram']} -> {b['heap_free_psram']}, trend {free_slope:+.0f} B/h; "
+          f"internal largest {a['heap_largest_internal']} -> {b['heap_largest_internal']}")
+    if slope < 0 and free_slope > slope / 2:
+        # 空闲总量基本不变而最大块在缩：碎片，而不是泄漏
+        left = (b["heap_largest_psram"] - need) / -slope
+        print(f" fragmentation: largest block shrinks while free stays flat; "
+              f"reaches one map bitmap in ~{max(0.0, left):.1f} h at this rate")
+    elif slope < 0:
+        print(" largest block and free bytes both shrink: looks like a leak rather than fragmentation")
+    else:
+        print(" no downward trend in the largest PSRAM block")
+    return rows
+
+
 def run_once(sender: HostSender, speed: int, rpm: int, odo: int, trip: int, out_t: int, in_t: int, batt: int,
              curr_time: str, trip_min: int, fuel_left: float, fuel_total: float, png_path: Optional[str], img_mode: str,
              img_w: Optional[int], img_h: Optional[int], r565_swap_bytes: bool, reboot_cmd: bool,
-             brightness: Optional[int], offset_rotation: Optional[int]):
+             brightness: Optional[int], offset_rotation: Optional[int], r565_codec: str = "rle",
+             perf: bool = False, perf_reset: bool = False, batch: bool = False, tasks: bool = False,
+             bus_retune: bool = False, trace_out: Optional[str] = None, trace_clear: bool = False):
     snap = MsgfSnapshot(
         speed_kmh=speed,
         engine_rpm=rpm,
@@ -364,29 +1403,39 @@ def run_once(sender: HostSender, speed: int, rpm: int, odo: int, trip: int, out_
         fuel_left_dl=int(round(fuel_left * 10)),
         fuel_total_dl=int(round(fuel_total * 10)),
     )
-    sender.send_msgf(snap, cmd=MSG_CMD_SNAPSHOT)
+    msgs = [struct.pack("<B", MSG_CMD_SNAPSHOT) + snap.pack()]
+    if bus_retune:
+        msgs.append(struct.pack("<B", MSG_CMD_BUS_RETUNE))
     if reboot_cmd:
-        sender.send_msgf_cmd_only(MSG_CMD_REBOOT)
+        msgs.append(struct.pack("<B", MSG_CMD_REBOOT))
     if brightness is not None:
         if not (0 <= brightness <= 255):
             raise ValueError("--brightness must be in range 0..255")
-        sender.send_brightness(brightness)
+        msgs.append(struct.pack("<BB", MSG_CMD_BRIGHTNESS, brightness))
     if offset_rotation is not None:
         if offset_rotation not in (1, 3, 5, 7):
             raise ValueError("--offset-rotation must be one of 1,3,5,7")
-        sender.send_offset_rotation(offset_rotation)
+        msgs.append(struct.pack("<BB", MSG_CMD_OFFSET_ROTATION, offset_rotation))
+    if batch and len(msgs) > 1:
+        sender.send_msgf_batch(msgs)
+    else:
+        for m in msgs:
+            sender.send_frame(MAGIC_MSGF, m)
     if png_path:
         with open(png_path, "rb") as f:
             png = f.read()
         if img_mode == "r565":
-            frame = png_to_r565_frame(
-                png,
-                (img_w, img_h) if img_w and img_h else None,
-                swap_bytes=r565_swap_bytes,
-            )
-            sender.send_imgf_r565_bytes(frame)
+            send_png_as_r565(sender, png, img_w, img_h, r565_swap_bytes, r565_codec)
+        elif img_mode == "tiles":
+            send_png_as_tiles(sender, png, img_w, img_h, r565_swap_bytes, r565_codec)
         else:
             sender.send_imgf_bytes(png)
+    if perf:
+        print_perf(sender.query_perf(reset=perf_reset))
+    if tasks:
+        print_tasks(sender.query_tasks())
+    if trace_out:
+        save_trace(sender.query_trace(clear=trace_clear), trace_out)
 
 def parse_basic_auth_from_env() -> Optional[tuple[str, str]]:
     raw = os.getenv("BASIC_AUTH_USERS")
@@ -410,20 +1459,41 @@ def parse_basic_auth_from_env() -> Optional[tuple[str, str]]:
 
 def main():
     ap = argparse.ArgumentParser()
-    ap.add_argument("--port", required=True, help="例如 /dev/ttyACM0 或 COM5")
+    ap.add_argument("--port", required=True,
+                    help="例如 /dev/ttyACM0 或 COM5；vendor 或 vendor:VID:PID 走 USB vendor 批量接口（需 pyusb）")
     ap.add_argument("--baud", type=int, default=115200)
-    ap.add_argument("--mode", choices=["demo", "once"], default="demo")
+    ap.add_argument("--crc", action="store_true", help="在帧头填写 payload CRC32（下位机 require_crc 时必须）")
+    ap.add_argument("--compress", action="store_true",
+                    help="较长的帧载荷按 LZ4 压缩发送（flags=0x80，变小才压），需要支持载荷压缩的固件")
+    ap.add_argument("--mode", choices=["demo", "once", "bench", "soak"], default="demo")
+    ap.add_argument("--png-frag", type=int, default=0,
+                    help="PNG 分片大小(字节)，>0 时按 IMGF 分片发送，下位机边收边解码")
 
     # demo 参数
     ap.add_argument("--hz", type=float, default=24.0, help="MSGF 发送频率")
+    ap.add_argument("--msg-keyframe", type=float, default=1.0,
+                    help="demo 模式：每隔多少秒发一次整包快照，其间只发变化字段（CMD=0x05）；0=总是整包")
     ap.add_argument("--png", type=str, default=None, help="PNG 文件路径（IMGF）")
     ap.add_argument("--png-every", type=float, default=29.0, help="多少秒发送一次 PNG（demo 模式）")
     ap.add_argument("--track", action="store_true", help="启用远程轨迹 PNG")
     ap.add_argument("--track-every", type=float, default=25.0)
-    ap.add_argument("--img-mode", choices=["png", "r565"], default="png", help="图片发送模式：PNG或RGB565原始帧")
+    ap.add_argument("--vector-track", action="store_true",
+                    help="demo模式：内置轨迹点按 --track-every 逐点以矢量帧(IMGF type=4)发送，无需地图服务")
+    ap.add_argument("--img-mode", choices=["auto", "png", "r565", "tiles"], default="auto",
+                    help="图片发送模式：PNG、RGB565原始帧，或切成瓦片只发布局（下位机缓存瓦片）；"
+                         "auto 按下位机握手（CMD=0x09）选，能发 RGB565 就发 RGB565，旧固件退回 PNG")
+    ap.add_argument("--tile-view", action="store_true",
+                    help="demo模式：把 --png 当作 z=0 世界，视口在上面平移（IMGF type=7），按需补发 64×64 瓦片")
+    ap.add_argument("--tile-view-every", type=float, default=0.3, help="瓦片视口位置发送间隔（秒）")
     ap.add_argument("--img-w", type=int, default=None, help="r565模式可选：重采样宽度")
     ap.add_argument("--img-h", type=int, default=None, help="r565模式可选：重采样高度")
-    ap.add_argument("--r565-swap-bytes", action="store_true", help="r565模式可选：交换RGB565高低字节")
+    ap.add_argument("--r565-swap-bytes", action="store_true",
+                    help="r565模式可选：按大端(交换高低字节)发送，与下位机 LV_COLOR_16_SWAP 一致时可省去设备端转换")
+    ap.add_argument("--r565-delta", action="store_true",
+                    help="r565模式可选：与上一帧比较，只发送变化的矩形(IMGF type=3)")
+    ap.add_argument("--r565-codec", choices=list(R565_CODECS), default=None,
+                    help="r565模式压缩方式（默认按握手选 qoi/lz4/rle）；单帧需小于下位机 max_png_bytes(128KB)")
+    ap.add_argument("--hello", action="store_true", help="打印下位机握手回报的能力（CMD=0x09）")
 
 
     # once 参数
@@ -439,17 +1509,54 @@ def main():
     ap.add_argument("--fuel-left", type=float, default=36.0, help="油箱余量，单位L（once 模式）")
     ap.add_argument("--fuel-total", type=float, default=52.0, help="油箱总量，单位L（once 模式）")
     ap.add_argument("--reboot-cmd", action="store_true", help="once模式额外发送CMD=0x01重启命令")
+    ap.add_argument("--bus-retune", action="store_true",
+                    help="once模式可选：发送CMD=0x08清掉总线时钟标定，下次启动重新标定（可与 --reboot-cmd 连用）")
     ap.add_argument("--brightness", type=int, default=None, help="once模式可选：发送CMD=0x02设置亮度(0..255)")
     ap.add_argument("--offset-rotation", type=int, default=None, help="once模式可选：发送CMD=0x03设置翻转(1/3/5/7)")
+    ap.add_argument("--perf", action="store_true", help="once模式可选：发送CMD=0x04读取下位机时延统计并打印")
+    ap.add_argument("--perf-reset", action="store_true", help="与 --perf 一起使用：读取后清零统计")
+    ap.add_argument("--tasks", action="store_true",
+                    help="once模式可选：发送CMD=0x07读取各任务栈余量/优先级/CPU与各核占用并打印")
+    ap.add_argument("--batch", action="store_true", help="once模式：快照与各控制命令合并成一帧 CMD=0x06 发送")
+    ap.add_argument("--trace", type=str, default=None,
+                    help="once模式可选：发送CMD=0x0A取回下位机事件追踪，写成 Chrome trace JSON（Perfetto 可打开）")
+    ap.add_argument("--trace-clear", action="store_true", help="与 --trace 一起使用：读取后清空追踪缓冲")
+
+    # bench 参数
+    ap.add_argument("--bench-msg-hz", type=str, default="12,24,48,96,0",
+                    help="bench模式：逗号分隔的 MSGF 频率，0=不限速尽快发")
+    ap.add_argument("--bench-img-kb", type=str, default="0,16,64,120",
+                    help="bench模式：逗号分隔的 IMGF(R565) 单帧大小 KB，0=只发 MSGF")
+    ap.add_argument("--bench-img-hz", type=float, default=2.0, help="bench模式：IMGF 每秒张数")
+    ap.add_argument("--bench-crc", choices=["off", "on", "both"], default="off",
+                    help="bench模式：帧头是否填 CRC32（下位机 HUD_REQUIRE_CRC=1 时才校验）")
+    ap.add_argument("--bench-secs", type=float, default=5.0, help="bench模式：每组持续秒数")
+    ap.add_argument("--bench-out", type=str, default=None, help="bench模式：结果写入 .csv 或 .json")
+    ap.add_argument("--soak-hours", type=float, default=8.0, help="soak模式：持续小时数（Ctrl-C 提前结束并汇总）")
+    ap.add_argument("--soak-img-every", type=float, default=2.0, help="soak模式：每隔多少秒发一张地图 PNG")
+    ap.add_argument("--soak-report-min", type=float, default=10.0, help="soak模式：每隔多少分钟打印一行")
+    ap.add_argument("--soak-out", type=str, default=None, help="soak模式：每帧 STAT 写入 .csv")
 
     args = ap.parse_args()
 
-    sender = HostSender(args.port, args.baud)
+    sender = HostSender(args.port, args.baud, enable_crc=args.crc, png_frag=args.png_frag,
+                        r565_delta=args.r565_delta, compress=args.compress)
+    hello = sender.query_hello()
+    if args.hello:
+        print_hello(hello)
+    pick_encoding(args, hello)
+    sender.enable_crc = args.crc
+    if hello is not None:
+        print(f" device map {hello['map_w']}x{hello['map_h']}: img-mode {args.img_mode}, codec {args.r565_codec}")
     fetcher = None
-    if args.track:
-        basic_auth = parse_basic_auth_from_env()
-        if basic_auth is None:
-            raise ValueError("BASIC_AUTH_USERS env is required when --track is enabled")
+    vector = None
+    tile_world = None
+    if args.tile_view:
+        if not args.png:
+            raise ValueError("--tile-view needs --png as the map world")
+        with open(args.png, "rb") as f:
+            tile_world = TileWorld(f.read(), args.r565_swap_bytes, args.r565_codec)
+    if args.track or args.vector_track:
         TRACK_POINTS = [
             [121.154031, 31.157299],
             [121.154365, 31.155985],
@@ -523,13 +1630,19 @@ def main():
             [120.974736, 31.077291],
             [120.983928, 31.076962]
         ]
+    if args.vector_track:
+        vector = VectorTrack(TRACK_POINTS)
+    elif args.track:
+        basic_auth = parse_basic_auth_from_env()
+        if basic_auth is None:
+            raise ValueError("BASIC_AUTH_USERS env is required when --track is enabled")
         fetcher = TrackImageFetcher(TRACK_POINTS, TRACK_URL, basic_auth=basic_auth)
     try:
         if args.mode == "demo":
             run_demo(
                 sender,
                 hz=args.hz,
-                png_path=args.png,
+                png_path=None if tile_world else args.png,
                 png_every_s=args.png_every,
                 fetcher=fetcher,
                 track_every_s=args.track_every,
@@ -537,12 +1650,30 @@ def main():
                 img_w=args.img_w,
                 img_h=args.img_h,
                 r565_swap_bytes=args.r565_swap_bytes,
+                r565_codec=args.r565_codec,
+                msg_keyframe_s=args.msg_keyframe,
+                vector=vector,
+                tile_world=tile_world,
+                tile_view_every_s=args.tile_view_every,
             )
+        elif args.mode == "bench":
+            run_bench(sender,
+                      [float(x) for x in args.bench_msg_hz.split(",")],
+                      [int(x) for x in args.bench_img_kb.split(",")],
+                      args.bench_img_hz,
+                      {"off": [False], "on": [True], "both": [False, True]}[args.bench_crc],
+                      args.bench_secs, args.bench_out)
+        elif args.mode == "soak":
+            map_size = (hello["map_w"], hello["map_h"]) if hello else (args.img_w or 260, args.img_h or 260)
+            run_soak(sender, args.soak_hours, args.soak_img_every, args.hz, args.soak_report_min,
+                     args.png, map_size, args.soak_out)
         else:
             run_once(sender, args.speed, args.rpm, args.odo, args.trip,
                     args.out_t, args.in_t, args.batt,
                     args.time, args.trip_min, args.fuel_left, args.fuel_total, args.png, args.img_mode, args.img_w, args.img_h,
-                    args.r565_swap_bytes, args.reboot_cmd, args.brightness, args.offset_rotation)
+                    args.r565_swap_bytes, args.reboot_cmd, args.brightness, args.offset_rotation,
+                    args.r565_codec, args.perf, args.perf_reset, args.batch, args.tasks, args.bus_retune,
+                    args.trace, args.trace_clear)
     finally:
         sender.close()
 
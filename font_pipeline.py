@@ -0,0 +1,482 @@
+"""
+PlatformIO pre-script: subset the SquareLine fonts to the glyphs the HUD can actually show.
+
+SquareLine exports ui_font_*.c with the full 0x20-0xFF range (about 190 glyphs each), but the dashboard
+only ever draws the label texts from the SquareLine screens plus what ui_bridge.cpp formats at run time:
+digits and ":.+-/" (fmt_uint, fmt_tenths, fmt_hhmm). This script reads src/squareline/ui_font_*.c and
+writes a copy of each font holding just those glyphs:
+
+  - charset: for every object given a font with lv_obj_set_style_text_font() in src/squareline/*.c, the
+    text it gets from lv_label_set_text() / lv_dropdown_set_options() / lv_roller_set_options(), plus
+    RUNTIME_CHARS for every font; EXTRA adds per-font characters (e.g. for a label set from new code)
+  - bpp: LVGL 8.3 draws 8 bpp glyphs without the per-pixel shift/mask and opacity table lookup that
+    1/2/4 bpp need; a font is widened to 8 bpp when its subset then still fits MAX_8BPP_BYTES
+  - layout: glyph bitmaps are stored run-time glyphs first, then the label-only ones. Labels that never
+    change are baked into the static layer and not drawn again, so every glyph a frame can draw sits in
+    one contiguous run at the start of the flash array, a few cache lines instead of spread over the
+    whole font; the cmap covering the digits is searched first
+  - kerning classes are kept for the remaining glyphs and the class table is compacted
+
+Compressed fonts (bitmap_format 1) and cmap types other than FORMAT0_TINY are copied unchanged.
+The subsets are written to $BUILD_DIR/fonts and compiled instead of the originals, so the SquareLine
+sources stay untouched. A per-font report is printed and saved to $BUILD_DIR/fonts/report.txt.
+
+Standalone: python font_pipeline.py [--out DIR]   (analyse and write, without PlatformIO)
+"""
+
+import os
+import re
+import sys
+
+# SCons runs extra scripts without __file__; the PlatformIO hook below resets both from $PROJECT_DIR
+SELF = os.path.abspath(__file__) if "__file__" in globals() else os.path.abspath("font_pipeline.py")
+PROJECT_DIR = os.path.dirname(SELF)
+UI_DIR = os.path.join("src", "squareline")
+FONT_GLOB = re.compile(r"^ui_font_.*\.c$")
+
+# What ui_bridge.cpp writes into labels at run time (numbers, times, "left/total", signed temperature)
+RUNTIME_CHARS = "0123456789:.+-/ "
+
+# Extra characters per font: {"ui_font_Small": "ABC"}; "*" keeps the whole font
+EXTRA = {}
+
+# Fonts whose subset at 8 bpp is at most this big are widened to 8 bpp
+MAX_8BPP_BYTES = 16 * 1024
+
+# Per-font bpp override: {"ui_font_Number": 4}
+BPP = {}
+
+
+# ---------------------------------------------------------------------------
+# Charset
+# ---------------------------------------------------------------------------
+
+def c_string(lit):
+    """Body of a C string literal -> str (the SquareLine sources are UTF-8)."""
+    out = bytearray()
+    i = 0
+    esc = {"n": 10, "t": 9, "r": 13, "\\": 92, "\"": 34, "'": 39, "0": 0}
+    raw = lit.encode("utf-8")
+    while i < len(raw):
+        c = raw[i]
+        if c == 92 and i + 1 < len(raw):
+            n = chr(raw[i + 1])
+            if n == "x":
+                m = re.match(rb"[0-9A-Fa-f]{1,2}", raw[i + 2:])
+                out.append(int(m.group(0), 16))
+                i += 2 + len(m.group(0))
+                continue
+            out.append(esc.get(n, raw[i + 1]))
+            i += 2
+            continue
+        out.append(c)
+        i += 1
+    return out.decode("utf-8", errors="replace")
+
+
+def collect_charsets(ui_dir):
+    """-> {font name: set of code points} from the SquareLine screen/component sources."""
+    fonts = {}
+    texts = {}
+    lit = r"\"((?:[^\"\\]|\\.)*)\""
+    for fn in sorted(os.listdir(ui_dir)):
+        if not fn.endswith(".c") or FONT_GLOB.match(fn) or fn.startswith("ui_img_"):
+            continue
+        with open(os.path.join(ui_dir, fn), "r", encoding="utf-8", errors="replace") as f:
+            text = f.read()
+        for m in re.finditer(r"lv_obj_set_style_text_font\(\s*(.+?)\s*,\s*&(ui_font_\w+)", text):
+            # "lv_dropdown_get_list(cui_Dropdown2)" -> the object is the innermost identifier
+            obj = re.findall(r"\w+", m.group(1))[-1]
+            fonts.setdefault(m.group(2), set()).add(obj)
+        for m in re.finditer(r"lv_(?:label_set_text|dropdown_set_options|roller_set_options)\(\s*(\w+)\s*,\s*" + lit,
+                             text):
+            texts.setdefault(m.group(1), "")
+            texts[m.group(1)] += c_string(m.group(2))
+
+    charsets = {}
+    for font, objs in fonts.items():
+        cs = set(ord(c) for c in RUNTIME_CHARS)
+        for o in objs:
+            cs.update(ord(c) for c in texts.get(o, "") if c not in "\n\r")
+        charsets[font] = cs
+    for font, extra in EXTRA.items():
+        if extra != "*":
+            charsets.setdefault(font, set(ord(c) for c in RUNTIME_CHARS)).update(ord(c) for c in extra)
+    return charsets
+
+
+# ---------------------------------------------------------------------------
+# Parsing (lv_font_conv "--format lvgl --no-compress" output)
+# ---------------------------------------------------------------------------
+
+def c_array(text, name):
+    m = re.search(r"\b" + name + r"\s*\[\]\s*=\s*\{(.*?)\};", text, re.S)
+    if not m:
+        return None
+    body = re.sub(r"/\*.*?\*/", "", m.group(1), flags=re.S)
+    return [int(x, 0) for x in re.findall(r"-?(?:0x[0-9A-Fa-f]+|\d+)", body)]
+
+
+def field(text, name, default=None):
+    m = re.search(r"\." + re.escape(name) + r"\s*=\s*(-?\w+)", text)
+    return m.group(1) if m else default
+
+
+def parse_font(path):
+    with open(path, "r", encoding="utf-8", errors="replace") as f:
+        text = f.read()
+
+    name = re.search(r"lv_font_t\s+(ui_font_\w+)\s*=", text)
+    public = re.search(r"/\*-+\s*\n\s*\*\s*PUBLIC FONT.*", text, re.S)
+    guard = re.search(r"#ifndef\s+(UI_FONT_\w+)", text)
+    bitmap = c_array(text, "glyph_bitmap")
+    if not name or not public or not guard or bitmap is None:
+        return None
+
+    glyphs = [tuple(int(v) for v in g) for g in re.findall(
+        r"\{\.bitmap_index = (\d+), \.adv_w = (\d+), \.box_w = (\d+), \.box_h = (\d+), "
+        r"\.ofs_x = (-?\d+), \.ofs_y = (-?\d+)\}", text)]
+    cmaps = []
+    for m in re.finditer(r"\{\s*\.range_start = (\d+), \.range_length = (\d+), \.glyph_id_start = (\d+),"
+                         r"\s*\.unicode_list = (\w+), \.glyph_id_ofs_list = (\w+), \.list_length = \d+, "
+                         r"\.type = (\w+)\s*\}", text):
+        cmaps.append({"start": int(m.group(1)), "len": int(m.group(2)), "gid": int(m.group(3)),
+                      "simple": m.group(4) == "NULL" and m.group(5) == "NULL" and
+                      m.group(6) == "LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY"})
+
+    dsc = re.search(r"font_dsc\s*=\s*\{(.*?)\};", text, re.S).group(1)
+    font = {
+        "path": path,
+        "name": name.group(1),
+        "guard": guard.group(1),
+        "header": text[:text.index("#include")],
+        "public": public.group(0),
+        "bitmap": bitmap,
+        "glyphs": glyphs,
+        "cmaps": cmaps,
+        "bpp": int(field(dsc, "bpp", "0")),
+        "format": int(field(dsc, "bitmap_format", "0")),
+        "kern_scale": int(field(dsc, "kern_scale", "0")),
+        "kern_classes": int(field(dsc, "kern_classes", "0")),
+        "has_kern": re.search(r"\.kern_dsc\s*=\s*&", dsc) is not None,
+        "cmap_num": int(field(dsc, "cmap_num", "0")),
+    }
+    if font["kern_classes"]:
+        font["kern_left"] = c_array(text, "kern_left_class_mapping")
+        font["kern_right"] = c_array(text, "kern_right_class_mapping")
+        font["kern_values"] = c_array(text, "kern_class_values")
+        font["left_cnt"] = int(field(text, "left_class_cnt"))
+        font["right_cnt"] = int(field(text, "right_class_cnt"))
+    return font
+
+
+def supported(font):
+    if font["format"] != 0:
+        return "compressed bitmaps"
+    if font["bpp"] not in (1, 2, 4, 8):
+        return "bpp %d" % font["bpp"]
+    if not font["cmaps"] or len(font["cmaps"]) != font["cmap_num"] or not all(c["simple"] for c in font["cmaps"]):
+        return "cmap type"
+    if font["has_kern"] and not font["kern_classes"]:
+        return "kerning pairs"
+    return None
+
+
+def codepoints(font):
+    """-> {code point: glyph id}"""
+    out = {}
+    for c in font["cmaps"]:
+        for i in range(c["len"]):
+            out[c["start"] + i] = c["gid"] + i
+    return out
+
+
+# ---------------------------------------------------------------------------
+# Subsetting
+# ---------------------------------------------------------------------------
+
+def glyph_pixels(font, gid):
+    """Glyph bitmap as one value per pixel (lv_font_conv packs pixels MSB first, rows not padded)."""
+    idx, _, w, h, _, _ = font["glyphs"][gid]
+    bpp = font["bpp"]
+    n = w * h
+    data = font["bitmap"]
+    mask = (1 << bpp) - 1
+    px = []
+    for i in range(n):
+        bit = i * bpp
+        px.append((data[idx + (bit >> 3)] >> (8 - bpp - (bit & 7))) & mask)
+    return px
+
+
+def pack(px, src_bpp, dst_bpp):
+    if dst_bpp != src_bpp:
+        # scale to the new range: 4 bpp 0xF -> 8 bpp 0xFF
+        top_s, top_d = (1 << src_bpp) - 1, (1 << dst_bpp) - 1
+        px = [(v * top_d + top_s // 2) // top_s for v in px]
+    out = bytearray((len(px) * dst_bpp + 7) // 8)
+    for i, v in enumerate(px):
+        bit = i * dst_bpp
+        out[bit >> 3] |= v << (8 - dst_bpp - (bit & 7))
+    return bytes(out)
+
+
+def make_cmaps(cps, hot):
+    """Sorted code points -> cmap list; runs of 3+ become FORMAT0_TINY, the rest one SPARSE_TINY."""
+    runs = []
+    for cp in cps:
+        if runs and cp == runs[-1][-1] + 1:
+            runs[-1].append(cp)
+        else:
+            runs.append([cp])
+    cmaps = []
+    sparse = []
+    for r in runs:
+        if len(r) >= 3:
+            cmaps.append({"start": r[0], "len": len(r), "gid": None, "list": None, "cps": r})
+        else:
+            sparse.extend(r)
+    if sparse:
+        # a sparse cmap maps to consecutive glyph ids: give it its own block at the end of the id range
+        cmaps.append({"start": sparse[0], "len": sparse[-1] - sparse[0] + 1, "gid": None,
+                      "list": [cp - sparse[0] for cp in sparse], "cps": sparse})
+    # LVGL walks the cmaps in order: the one holding most of the run-time glyphs goes first
+    cmaps.sort(key=lambda c: -sum(1 for cp in c["cps"] if cp in hot))
+    return cmaps
+
+
+def subset(font, charset, hot):
+    cp2gid = codepoints(font)
+    keep = sorted(cp for cp in charset if cp in cp2gid)
+    # run-time characters are offered to every font; only label texts must be covered
+    missing = sorted(cp for cp in charset if cp not in cp2gid and cp not in hot)
+
+    # glyph id order: FORMAT0_TINY runs need consecutive ids, sparse code points follow
+    cmaps = make_cmaps(keep, hot)
+    order = []
+    for c in cmaps:
+        if c["list"] is None:
+            c["gid"] = len(order) + 1
+            order.extend(c["cps"])
+    for c in cmaps:
+        if c["list"] is not None:
+            c["gid"] = len(order) + 1
+            order.extend(c["cps"])
+
+    bpp = BPP.get(font["name"])
+    if bpp is None:
+        wide = sum((font["glyphs"][cp2gid[cp]][2] * font["glyphs"][cp2gid[cp]][3]) for cp in order)
+        bpp = 8 if wide <= MAX_8BPP_BYTES else font["bpp"]
+
+    # bitmaps: run-time glyphs first so a frame's glyphs share as few cache lines as possible
+    blob = bytearray()
+    index = {}
+    for cp in sorted(order, key=lambda c: (c not in hot, c)):
+        g = font["glyphs"][cp2gid[cp]]
+        if g[2] * g[3] == 0:
+            index[cp] = 0
+            continue
+        index[cp] = len(blob)
+        blob += pack(glyph_pixels(font, cp2gid[cp]), font["bpp"], bpp)
+    if not blob:
+        blob = bytearray(1)
+
+    glyphs = [(0, 0, 0, 0, 0, 0)]
+    for cp in order:
+        g = font["glyphs"][cp2gid[cp]]
+        glyphs.append((index[cp],) + g[1:])
+
+    out = {"bpp": bpp, "bitmap": bytes(blob), "glyphs": glyphs, "cmaps": cmaps, "order": order,
+           "missing": missing, "kern": None}
+
+    if font["kern_classes"]:
+        left = [0] + [font["kern_left"][cp2gid[cp]] for cp in order]
+        right = [0] + [font["kern_right"][cp2gid[cp]] for cp in order]
+        lmap = {c: i + 1 for i, c in enumerate(sorted(set(left) - {0}))}
+        rmap = {c: i + 1 for i, c in enumerate(sorted(set(right) - {0}))}
+        values = []
+        for lc in sorted(lmap):
+            for rc in sorted(rmap):
+                values.append(font["kern_values"][(lc - 1) * font["right_cnt"] + (rc - 1)])
+        if lmap and rmap and any(values):
+            out["kern"] = {"left": [lmap.get(c, 0) for c in left], "right": [rmap.get(c, 0) for c in right],
+                           "values": values, "left_cnt": len(lmap), "right_cnt": len(rmap)}
+    return out
+
+
+# ---------------------------------------------------------------------------
+# Output
+# ---------------------------------------------------------------------------
+
+def c_list(values, per_line, fmt):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join(fmt % v for v in values[i:i + per_line]))
+    return ",\n".join(lines)
+
+
+def label(cp):
+    ch = chr(cp)
+    return "U+%04X \"%s\"" % (cp, ch.replace("\\", "\\\\").replace("\"", "\\\"")) if cp >= 0x20 else "U+%04X" % cp
+
+
+def write_c(path, font, s):
+    rel = os.path.relpath(font["path"], PROJECT_DIR).replace("\\", "/")
+    parts = []
+    parts.append("// Generated by font_pipeline.py from %s - do not edit\n"
+                 "// %d of %d glyphs, %d bpp -> %d bpp, bitmaps %d -> %d bytes\n" % (
+                     rel, len(s["order"]), len(font["glyphs"]) - 1, font["bpp"], s["bpp"],
+                     len(font["bitmap"]), len(s["bitmap"])))
+    parts.append(font["header"])
+    parts.append("#include \"ui.h\"\n\n#ifndef %s\n#define %s 1\n#endif\n\n#if %s\n\n" % (
+        font["guard"], font["guard"], font["guard"]))
+
+    parts.append("/*Glyph bitmaps, run-time glyphs first*/\n"
+                 "static LV_ATTRIBUTE_LARGE_CONST const uint8_t glyph_bitmap[] = {\n%s\n};\n\n" % c_list(
+                     list(s["bitmap"]), 16, "0x%02x"))
+
+    rows = ["    {.bitmap_index = 0, .adv_w = 0, .box_w = 0, .box_h = 0, .ofs_x = 0, .ofs_y = 0} /* id = 0 reserved */"]
+    for cp, g in zip(s["order"], s["glyphs"][1:]):
+        rows.append("    {.bitmap_index = %d, .adv_w = %d, .box_w = %d, .box_h = %d, .ofs_x = %d, .ofs_y = %d} /* %s */"
+                    % (g + (label(cp),)))
+    parts.append("static const lv_font_fmt_txt_glyph_dsc_t glyph_dsc[] = {\n%s\n};\n\n" % ",\n".join(rows))
+
+    cm = []
+    for i, c in enumerate(s["cmaps"]):
+        if c["list"] is not None:
+            parts.append("static const uint16_t unicode_list_%d[] = {\n%s\n};\n\n" % (
+                i, c_list(c["list"], 8, "0x%x")))
+            cm.append("    {\n        .range_start = %d, .range_length = %d, .glyph_id_start = %d,\n"
+                      "        .unicode_list = unicode_list_%d, .glyph_id_ofs_list = NULL, .list_length = %d, "
+                      ".type = LV_FONT_FMT_TXT_CMAP_SPARSE_TINY\n    }" % (c["start"], c["len"], c["gid"], i,
+                                                                        len(c["list"])))
+        else:
+            cm.append("    {\n        .range_start = %d, .range_length = %d, .glyph_id_start = %d,\n"
+                      "        .unicode_list = NULL, .glyph_id_ofs_list = NULL, .list_length = 0, "
+                      ".type = LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY\n    }" % (c["start"], c["len"], c["gid"]))
+    parts.append("static const lv_font_fmt_txt_cmap_t cmaps[] =\n{\n%s\n};\n\n" % ",\n".join(cm))
+
+    k = s["kern"]
+    if k:
+        parts.append("static const uint8_t kern_left_class_mapping[] =\n{\n%s\n};\n\n"
+                     "static const uint8_t kern_right_class_mapping[] =\n{\n%s\n};\n\n"
+                     "static const int8_t kern_class_values[] =\n{\n%s\n};\n\n"
+                     "static const lv_font_fmt_txt_kern_classes_t kern_classes =\n{\n"
+                     "    .class_pair_values   = kern_class_values,\n"
+                     "    .left_class_mapping  = kern_left_class_mapping,\n"
+                     "    .right_class_mapping = kern_right_class_mapping,\n"
+                     "    .left_class_cnt      = %d,\n"
+                     "    .right_class_cnt     = %d,\n};\n\n" % (
+                         c_list(k["left"], 8, "%d"), c_list(k["right"], 8, "%d"), c_list(k["values"], 8, "%d"),
+                         k["left_cnt"], k["right_cnt"]))
+
+    parts.append("#if LV_VERSION_CHECK(8, 0, 0)\n"
+                 "static  lv_font_fmt_txt_glyph_cache_t cache;\n"
+                 "static const lv_font_fmt_txt_dsc_t font_dsc = {\n"
+                 "#else\n"
+                 "static lv_font_fmt_txt_dsc_t font_dsc = {\n"
+                 "#endif\n"
+                 "    .glyph_bitmap = glyph_bitmap,\n"
+                 "    .glyph_dsc = glyph_dsc,\n"
+                 "    .cmaps = cmaps,\n"
+                 "    .kern_dsc = %s,\n"
+                 "    .kern_scale = %d,\n"
+                 "    .cmap_num = %d,\n"
+                 "    .bpp = %d,\n"
+                 "    .kern_classes = %d,\n"
+                 "    .bitmap_format = 0,\n"
+                 "#if LV_VERSION_CHECK(8, 0, 0)\n"
+                 "    .cache = &cache\n"
+                 "#endif\n"
+                 "};\n\n\n" % ("&kern_classes" if k else "NULL", font["kern_scale"] if k else 0,
+                               len(s["cmaps"]), s["bpp"], 1 if k else 0))
+    parts.append(font["public"])
+
+    tmp = path + ".tmp"
+    with open(tmp, "w", encoding="utf-8", newline="\n") as f:
+        f.write("".join(parts))
+    os.replace(tmp, path)
+
+
+def run(project_dir, out_dir):
+    """Subset every font; returns {original source path: generated path}."""
+    ui_dir = os.path.join(project_dir, UI_DIR)
+    os.makedirs(out_dir, exist_ok=True)
+    charsets = collect_charsets(ui_dir)
+    hot = set(ord(c) for c in RUNTIME_CHARS)
+
+    # the charset comes from the other UI sources, so regenerate when any of them is newer
+    newest = max([os.path.getmtime(SELF)] + [os.path.getmtime(os.path.join(ui_dir, fn))
+                                             for fn in os.listdir(ui_dir) if fn.endswith(".c")])
+    mapping = {}
+    report = ["%-16s %7s %5s %9s %9s  %s" % ("font", "glyphs", "bpp", "bitmap", "before", "charset")]
+    total_before = total_after = 0
+    for fn in sorted(os.listdir(ui_dir)):
+        if not FONT_GLOB.match(fn):
+            continue
+        path = os.path.join(ui_dir, fn)
+        out = os.path.join(out_dir, fn)
+        font = parse_font(path)
+        if font is None:
+            print("[fonts] skip %s (unrecognised layout)" % fn)
+            continue
+        why = supported(font)
+        if not why and EXTRA.get(font["name"]) == "*":
+            why = "EXTRA *"
+        if not why and font["name"] not in charsets:
+            why = "not used by any label"
+        if why:
+            print("[fonts] %s: %s, keeping it whole" % (font["name"], why))
+            continue
+
+        s = subset(font, charsets[font["name"]], hot)
+        if s["missing"]:
+            print("[fonts] %s has no glyph for %s" % (font["name"], " ".join(label(cp) for cp in s["missing"])))
+        if not (os.path.exists(out) and os.path.getmtime(out) >= newest):
+            write_c(out, font, s)
+        mapping[os.path.normcase(os.path.abspath(path))] = out
+
+        total_before += len(font["bitmap"])
+        total_after += len(s["bitmap"])
+        report.append("%-16s %3d/%-3d %d->%d %9d %9d  %s" % (
+            font["name"], len(s["order"]), len(font["glyphs"]) - 1, font["bpp"], s["bpp"], len(s["bitmap"]),
+            len(font["bitmap"]), "".join(chr(cp) for cp in s["order"])))
+
+    report.append("total glyph bitmaps %d -> %d bytes (%+d)" % (total_before, total_after, total_after - total_before))
+    text = "\n".join(report)
+    with open(os.path.join(out_dir, "report.txt"), "w", encoding="utf-8", newline="\n") as f:
+        f.write(text + "\n")
+    print("[fonts]\n%s" % text)
+    return mapping
+
+
+# ---------------------------------------------------------------------------
+# PlatformIO / SCons hook
+# ---------------------------------------------------------------------------
+
+try:
+    Import("env")  # noqa: F821  (provided by SCons)
+except NameError:
+    env = None
+
+if env is not None:
+    PROJECT_DIR = env.subst("$PROJECT_DIR")
+    SELF = os.path.join(PROJECT_DIR, "font_pipeline.py")
+    _out_dir = os.path.join(env.subst("$BUILD_DIR"), "fonts")
+    _mapping = run(PROJECT_DIR, _out_dir)
+
+    def _skip_original(env_, node):
+        # originals are replaced by the subsets built below
+        if os.path.normcase(os.path.abspath(node.srcnode().get_abspath())) in _mapping:
+            return None
+        return node
+
+    env.AddBuildMiddleware(_skip_original, "*/squareline/ui_font_*.c")
+    env.Append(CPPPATH=[os.path.join(PROJECT_DIR, UI_DIR)])
+    env.BuildSources(os.path.join("$BUILD_DIR", "fonts_obj"), _out_dir, src_filter="+<*.c>")
+
+elif __name__ == "__main__":
+    _out = os.path.join(PROJECT_DIR, ".pio", "fonts")
+    if "--out" in sys.argv:
+        _out = sys.argv[sys.argv.index("--out") + 1]
+    run(PROJECT_DIR, _out)
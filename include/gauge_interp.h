@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Gauge interpolation --------
+       Snapshots arrive at the host's MSGF rate (24 Hz driving, 2 Hz idle), so a gauge driven
+       straight from them steps. Each new sample starts a linear segment from the value shown
+       right now to the sample, lasting one estimated snapshot period: the gauge stays exactly
+       one period behind the host and never overshoots between samples. The period is measured
+       from arrival times, divided by the seq gap so snapshots the mailbox dropped don't stretch it.
+
+       If the next sample is late the value keeps moving along the last two samples' slope
+       (dead reckoning) for at most extrap_ms, then holds. Samples further apart than
+       GAUGE_INTERP_MAX_GAP_MS (link stalls, host restart) are taken as a jump.
+
+       Pure integer math and no LVGL, the caller owns the clock (any ms counter that wraps). */
+#ifndef GAUGE_INTERP_MAX_GAP_MS
+#define GAUGE_INTERP_MAX_GAP_MS 1000
+#endif
+
+    typedef struct
+    {
+        int32_t from;      /* segment start value */
+        int32_t to;        /* last sample */
+        int32_t slope_q10; /* last sample-to-sample change per ms, Q10 */
+        uint32_t t0;       /* segment start (arrival of the last sample) */
+        uint32_t dur;      /* segment length = estimated snapshot period */
+        uint32_t seq;      /* seq of the last sample */
+        uint16_t extrap;   /* dead-reckoning limit past the segment end, ms */
+        bool valid;
+    } gauge_interp_t;
+
+    void gauge_interp_init(gauge_interp_t *g, uint16_t extrap_ms);
+
+    /* Feeds a sample that arrived at now_ms. */
+    void gauge_interp_sample(gauge_interp_t *g, int32_t value, uint32_t seq, uint32_t now_ms);
+
+    /* Value to show at now_ms (the last sample if none has been interpolated yet). */
+    int32_t gauge_interp_value(const gauge_interp_t *g, uint32_t now_ms);
+
+    /* True once the value no longer changes until the next sample, i.e. the caller can stop ticking. */
+    bool gauge_interp_settled(const gauge_interp_t *g, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/* 基准测试模式（pio run -e sc01_plus_bench）：不需要上位机，固件自己以固定频率往 ui_bridge 灌
+   合成快照和 R565 地图，按窗口统计渲染/推屏/lv_timer_handler 耗时、快照时延、堆与 PSRAM 低水位、
+   各核 CPU 占用，并在 Serial0 打印汇总表。换 LVGL 配置、渲染模式或板子后烧录同一环境即可对比。 */
+#ifndef HUD_BENCH
+#define HUD_BENCH 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 在 ui_bridge 与解码线程启动之后调用一次；HUD_BENCH=0 时为空操作 */
+bool hud_bench_start(void);
+
+#ifdef __cplusplus
+}
+#endif
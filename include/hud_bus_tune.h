@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+
+/* 面板总线写时钟自动标定。各板文件里的 freq_write 是保守值，推屏耗时直接受它限制。
+   首次启动从板子默认值起逐级升频，每级写测试图样并校验：
+   - 面板能回读（总线接了 RD/MISO）时写入伪随机像素再读回比对；
+   - 不能回读就显示整屏测试图样，图样干净时在 HUD_BUS_TUNE_CONFIRM_MS 内点一下屏幕确认，不点即视为失败；
+   - 两者都不行（无回读也无触摸，如 SC02/KC01）时不标定，沿用默认值。
+   首次失败即停止，最后一级通过的频率再留 HUD_BUS_TUNE_MARGIN_PCT 余量后写入 NVS（每块板一条），
+   以后启动直接加载。RGB 面板的像素时钟属于面板时序，不参与标定。 */
+
+// 0=只加载 NVS 里已有的结果；1=没有结果时标定（默认）；2=每次启动都重新标定
+#ifndef HUD_BUS_TUNE
+#define HUD_BUS_TUNE 1
+#endif
+
+// 标定的上限：S3 LCD_CAM 240MHz/3，ESP32 SPI 的 APB 80MHz
+#ifndef HUD_BUS_TUNE_MAX_HZ
+#define HUD_BUS_TUNE_MAX_HZ 80000000
+#endif
+
+// 每级至少比上一级快这么多（按时钟源整数分频取下一个可达频率）
+#ifndef HUD_BUS_TUNE_STEP_PCT
+#define HUD_BUS_TUNE_STEP_PCT 20
+#endif
+
+// 存入 NVS 前从最快通过值再降的比例：车内温度变化大，标定时刚好通过的频率不算稳定
+#ifndef HUD_BUS_TUNE_MARGIN_PCT
+#define HUD_BUS_TUNE_MARGIN_PCT 10
+#endif
+
+// 触摸确认的等待时间
+#ifndef HUD_BUS_TUNE_CONFIRM_MS
+#define HUD_BUS_TUNE_CONFIRM_MS 4000
+#endif
+
+class PanelLan;
+
+// tft.begin() 之后、LVGL 初始化之前调用：加载或标定写时钟。返回生效的写时钟（Hz），RGB 面板返回 0
+uint32_t hud_bus_tune(PanelLan &tft);
+
+// 清掉当前板的标定结果，下次启动（HUD_BUS_TUNE>=1 时）重新标定
+void hud_bus_tune_forget(PanelLan &tft);
@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Bulk copies on the GDMA memcpy channel --------
+       Wraps ESP-IDF esp_async_memcpy for the big PSRAM<->PSRAM/SRAM moves (decoded map images,
+       raw RGB565 frames). While the DMA engine moves the data the calling task blocks on a
+       semaphore, so the other tasks on its core get the CPU instead of a multi-100 KB memcpy
+       stalling on PSRAM.
+
+       Any copy can be handed in: the engine takes the part where both pointers share
+       16-byte alignment and the destination covers whole cache lines; the unaligned head and
+       tail (and copies that are too small, come from flash, or run on a target without the
+       driver) are done with memcpy. PSRAM caches are written back / invalidated here, so the
+       caller sees ordinary memcpy semantics once hud_dma_copy_end() returns. */
+#ifndef HUD_DMA_COPY_MIN
+#define HUD_DMA_COPY_MIN 4096 /* below this the descriptor setup costs more than it saves */
+#endif
+
+#define HUD_DMA_COPY_ALIGN 64 /* allocate buffers with this alignment to get the DMA path */
+
+    /* Completion hook, called from the GDMA interrupt (only when hud_dma_copy_begin returned true).
+       Return true if it woke a higher-priority task. */
+    typedef bool (*hud_dma_done_cb_t)(void *arg);
+
+    typedef struct
+    {
+        hud_dma_done_cb_t on_done; /* optional, set before hud_dma_copy_begin */
+        void *on_done_arg;
+
+        /* private */
+        uint8_t *dst;
+        const uint8_t *src;
+        size_t n;
+        size_t dma_off;
+        size_t dma_len; /* 0: everything was copied by the CPU */
+        void *sem;
+        uint32_t sem_storage[24]; /* StaticSemaphore_t */
+    } hud_dma_job_t;
+
+    /* Install the driver once at boot. Returns false if there is no GDMA memcpy (copies then
+       always fall back to memcpy). */
+    bool hud_dma_copy_init(void);
+
+    /* Start copying n bytes (regions must not overlap). Returns true if the engine is running:
+       neither buffer may be touched until hud_dma_copy_end(job) returns, the CPU is free for other
+       work in between. Returns false if the copy was already done with memcpy. Calling
+       hud_dma_copy_end is fine (and a no-op) either way. */
+    bool hud_dma_copy_begin(hud_dma_job_t *job, void *dst, const void *src, size_t n);
+    void hud_dma_copy_end(hud_dma_job_t *job);
+
+    /* begin + end: a drop-in memcpy that sleeps instead of spinning on large copies */
+    void hud_dma_copy(void *dst, const void *src, size_t n);
+
+    typedef struct
+    {
+        uint32_t dma_copies;  /* copies that used the engine */
+        uint32_t cpu_copies;  /* copies done entirely by memcpy */
+        uint64_t dma_bytes;   /* bytes moved by the engine */
+    } hud_dma_copy_stats_t;
+
+    void hud_dma_copy_get_stats(hud_dma_copy_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 可选的 LVGL 绘制加速后端（-DHUD_DRAW_ACCEL=1）：在软件 draw_ctx 上替换 blend 回调，
+   把最常见的两种混合——不透明纯色填充、不透明位图拷贝（无遮罩）——交给 ESP32-S3 PIE
+   的 128 位向量存取；其余情况（带 alpha/遮罩、特殊混合模式）仍走 lv_draw_sw_blend_basic，
+   输出与纯软件渲染逐像素一致。非 S3 或 -DHUD_DRAW_PIE=0 时全部回退到软件路径。 */
+
+struct _lv_disp_drv_t;
+
+/* 在 lv_disp_drv_register 之前调用，替换驱动的 draw_ctx 初始化 */
+void hud_draw_accel_install(struct _lv_disp_drv_t *drv);
+
+typedef struct {
+    uint32_t fill_px;       // 走快速路径填充的像素数
+    uint32_t copy_px;       // 走快速路径拷贝的像素数
+    uint32_t fallback;      // 交回软件路径的 blend 调用次数
+} hud_draw_accel_stats_t;
+
+void hud_draw_accel_get_stats(hud_draw_accel_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
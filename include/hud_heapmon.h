@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Heap fragmentation monitor --------
+       Free bytes, low-water mark and largest free block of internal RAM and PSRAM. ui_alloc/ui_free,
+       the IMGF slot buffers and LVGL's allocator all draw from these caps heaps, and a map decode
+       needs one contiguous PSRAM block, so over a long drive it is the largest free block, not the
+       free total, that runs out first. Every HUD_HEAPMON_HISTORY_MS the sampler also keeps a history
+       point; the trend is a least-squares slope of the largest block over that history.
+       A sample walks each heap under its lock: meant for 1 Hz or slower, from one task. */
+#ifndef HUD_HEAPMON_HISTORY_MS
+#define HUD_HEAPMON_HISTORY_MS (60 * 1000)
+#endif
+
+#ifndef HUD_HEAPMON_HISTORY
+#define HUD_HEAPMON_HISTORY 120 /* points; 2 h window at the default interval */
+#endif
+
+    typedef struct
+    {
+        uint32_t free;
+        uint32_t min_free;      /* low-water mark of free bytes since boot */
+        uint32_t largest;       /* largest free block right now */
+        uint32_t largest_min;   /* smallest largest-free-block any sample has seen since boot */
+        int32_t largest_trend;  /* bytes per hour over the history window (negative = shrinking),
+                                   0 until there are two history points */
+    } hud_heapmon_region_t;
+
+    typedef struct
+    {
+        hud_heapmon_region_t internal;
+        hud_heapmon_region_t psram; /* all zero on boards without PSRAM */
+        uint32_t samples;           /* since boot */
+        uint32_t window_ms;         /* time the trend covers */
+    } hud_heapmon_report_t;
+
+    /* Samples both heaps now and fills out. */
+    void hud_heapmon_sample(hud_heapmon_report_t *out);
+
+#ifdef __cplusplus
+}
+#endif
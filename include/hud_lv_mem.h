@@ -0,0 +1,54 @@
+#pragma once
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- LVGL allocator for the performance profile --------
+       Selected from lv_conf.h when built with -DHUD_LV_MEM_INTERNAL=1 (or an arena, below). Objects, styles, label text
+       and draw scratch buffers (everything up to HUD_LV_MEM_INTERNAL_MAX bytes) come from internal
+       RAM, so the per-frame object walk and style lookups don't miss into QSPI PSRAM. Larger blocks
+       (snapshots, decoded images) go to PSRAM. Internal RAM is used only while more than
+       HUD_LV_MEM_INTERNAL_RESERVE bytes stay free for DMA buffers and task stacks. */
+#ifndef HUD_LV_MEM_INTERNAL_MAX
+#define HUD_LV_MEM_INTERNAL_MAX 4096
+#endif
+
+#ifndef HUD_LV_MEM_INTERNAL_RESERVE
+#define HUD_LV_MEM_INTERNAL_RESERVE (48 * 1024)
+#endif
+
+    /* Arena (-DHUD_LV_MEM_ARENA=<bytes>, 0 = off): the small blocks come from a fixed region of
+       internal RAM reserved for LVGL alone, run as a private heap (multi_heap_register; the IDF
+       heap is TLSF, so alloc/free cost is O(1) and doesn't depend on what else is allocated).
+       Map buffers, task stacks and Wi-Fi/USB churn in the system heap can then neither fragment
+       nor starve it. Blocks that don't fit (arena full, or larger than HUD_LV_MEM_INTERNAL_MAX)
+       take the path described above. */
+#ifndef HUD_LV_MEM_ARENA
+#define HUD_LV_MEM_ARENA 0
+#endif
+
+    void *hud_lv_malloc(size_t n);
+    void *hud_lv_realloc(void *p, size_t n);
+    void hud_lv_free(void *p);
+
+    typedef struct
+    {
+        size_t internal_allocs; /* successful allocations served from internal RAM */
+        size_t psram_allocs;    /* served from PSRAM (large, or internal reserve reached) */
+        size_t fallback_allocs; /* preferred region was full, took the other one */
+        size_t arena_allocs;    /* served from the arena */
+        size_t arena_full;      /* small blocks the arena had no room for */
+        size_t arena_size;      /* 0 when the arena is off */
+        size_t arena_free;
+        size_t arena_min_free;  /* low-water mark since boot */
+        size_t arena_largest;   /* largest free block right now */
+    } hud_lv_mem_stats_t;
+
+    void hud_lv_mem_get_stats(hud_lv_mem_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Latency / frame-timing instrumentation --------
+       Two kinds of samples end up in the same log-scale histograms:
+       - per-snapshot stage stamps tagged with the frame seq (USB header -> glass), matched up
+         in a small ring so no state has to travel with the data;
+       - plain durations (render, flush, decode) recorded directly.
+       Every stamp and duration is also an event in the binary trace (hud_trace.h).
+       Build with -DHUD_PERF_ENABLE=0 to compile every hook out. */
+#ifndef HUD_PERF_ENABLE
+#define HUD_PERF_ENABLE 1
+#endif
+
+    typedef enum
+    {
+        HUD_PERF_STAGE_HDR = 0, /* router: header of the MSGF frame parsed */
+        HUD_PERF_STAGE_COMMIT,  /* msgf_commit: payload queued */
+        HUD_PERF_STAGE_REQUEST, /* ui_request_msg: snapshot handed to the bridge */
+        HUD_PERF_STAGE_APPLY,   /* apply_snapshot_lvgl: labels updated */
+        HUD_PERF_STAGE_FLUSH,   /* last flush of the frame that contains it completed */
+        HUD_PERF_STAGE_COUNT
+    } hud_perf_stage_t;
+
+    typedef enum
+    {
+        /* stage-to-stage latency of one snapshot */
+        HUD_PERF_HDR_TO_COMMIT = 0,
+        HUD_PERF_COMMIT_TO_REQUEST,
+        HUD_PERF_REQUEST_TO_APPLY,
+        HUD_PERF_APPLY_TO_FLUSH,
+        HUD_PERF_USB_TO_GLASS, /* HDR -> FLUSH */
+        /* durations */
+        HUD_PERF_RENDER,     /* one LVGL refresh (lv_timer_handler call that flushed) */
+        HUD_PERF_FLUSH,      /* one flush_cb -> flush_ready */
+        HUD_PERF_IMG_DECODE, /* one map image / fragment / patch decode */
+        HUD_PERF_TIMER,      /* every lv_timer_handler call, idle ones included */
+        HUD_PERF_METRIC_COUNT
+    } hud_perf_metric_t;
+
+    typedef struct
+    {
+        uint32_t count;
+        uint32_t min_us;
+        uint32_t avg_us;
+        uint32_t p50_us;
+        uint32_t p99_us;
+        uint32_t max_us;
+    } hud_perf_summary_t;
+
+    uint32_t hud_perf_now_us(void);
+
+    /* Stamp a stage for frame seq (any task). FLUSH completes the record. */
+    void hud_perf_mark(uint32_t seq, hud_perf_stage_t stage);
+
+    /* Stamp FLUSH for the last seq that reached APPLY (call after the frame left the panel). */
+    void hud_perf_mark_flushed(void);
+
+    void hud_perf_record(hud_perf_metric_t m, uint32_t us);
+
+    void hud_perf_get(hud_perf_metric_t m, hud_perf_summary_t *out);
+    void hud_perf_reset(void);
+
+    /* -------- Wire format (MSGF CMD_GET_PERF reply, magic 'PERF') --------
+       u8 version (1), u8 metric count, u16 reserved, then per metric:
+       u8 id, u8 rsv[3], u32 count, min, avg, p50, p99, max (microseconds, little endian). */
+#define HUD_PERF_MAGIC 0x46524550u /* 'PERF' little endian */
+#define HUD_PERF_WIRE_VERSION 1
+#define HUD_PERF_WIRE_BYTES (4 + HUD_PERF_METRIC_COUNT * 28)
+
+    size_t hud_perf_serialize(uint8_t *dst, size_t cap);
+
+#if HUD_PERF_ENABLE
+#define HUD_PERF_MARK(seq, stage) hud_perf_mark((seq), (stage))
+#define HUD_PERF_RECORD(m, us) hud_perf_record((m), (us))
+#else
+#define HUD_PERF_MARK(seq, stage) ((void)0)
+#define HUD_PERF_RECORD(m, us) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Last known state across reboots --------
+       What the screen showed last, so a reboot (CMD 0x01, brown-out, ignition cycle) comes back
+       with real values and the real map instead of the SquareLine defaults:
+
+       - snapshot: the 26-byte MSGF snapshot as last applied. Every update lands in RTC memory
+         (survives esp_restart/panics, costs nothing); hud_persist_flush_snapshot copies it into
+         NVS for power-off, called at the save points below only if it changed.
+       - map: a complete IMGF type 2 payload (r565_hdr_t + raw pixels) of the bitmap on screen,
+         in the "lastmap" data partition. One record: body first, header last, so an interrupted
+         write reads as "nothing saved". Erasing ~34 sectors stalls the flash cache for a while,
+         so this is only written from a low-priority task and only when the map changed.
+
+       The UI suspend on USB idle keeps everything in RAM (panel asleep, PSRAM untouched), so
+       wake needs none of this; suspend is merely a good moment to save. */
+#define HUD_PERSIST_SUBTYPE 0x41 /* partition: data, 0x41, name "lastmap" */
+#define HUD_PERSIST_SNAP_BYTES 26
+
+    /* Find the partition and validate the RTC copy. False without a "lastmap" partition (the
+       snapshot still persists; map saves/loads then fail cheaply). */
+    bool hud_persist_init(void);
+
+    /* Remember the snapshot that is being shown (RTC memory only, any task). */
+    void hud_persist_put_snapshot(const uint8_t *wire);
+
+    /* Last snapshot: the RTC copy if it survived, else NVS. False if there is none. */
+    bool hud_persist_get_snapshot(uint8_t *wire);
+
+    /* Write the RTC copy to NVS if it differs from what NVS holds. */
+    void hud_persist_flush_snapshot(void);
+
+    /* Largest map payload the partition holds (0 without the partition). */
+    size_t hud_persist_map_cap(void);
+
+    /* Replace the saved map with payload/len (synchronous, seconds at worst). The same bytes as
+       the saved map are not rewritten. */
+    bool hud_persist_save_map(const uint8_t *payload, size_t len);
+
+    /* Size of the saved map payload, 0 if there is none. */
+    size_t hud_persist_map_len(void);
+
+    /* Copy the saved map payload into dst (checked against its crc). */
+    bool hud_persist_load_map(uint8_t *dst, size_t cap, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usb_stream_router.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- UART / RS-485 transport (pio run -e sc01_plus_rs485) --------
+       For head units with only a serial line: the router, receivers and UI run unchanged over the
+       board's RS-485 pins (board_pins_t.rs485) instead of USB. Frames are the same bytes as on CDC.
+
+       Built on the ESP-IDF UART driver. The RX ISR moves the hardware FIFO into a
+       HUD_RS485_RX_BUF ring buffer in bursts (FIFO almost full, or the line idle for
+       HUD_RS485_RX_TOUT byte times), never per byte; one small event task turns each burst into a
+       router wakeup and the router drains the ring in read_chunk blocks, straight into receiver
+       buffers. The hardware pattern detector only matches a run of one repeated character, so
+       it cannot find the 4-byte frame magic; resync stays in the router as on USB.
+
+       With an RTS pin the UART drives the transceiver's DE line (half duplex): device->host frames
+       (STAT, CRED, PERF...) go out while the host is silent, so on a shared 2-wire bus set
+       HUD_STAT_PERIOD_MS / HUD_CREDIT_PERIOD_MS to 0 and only query. Without an RTS pin the line is
+       treated as full duplex. */
+#ifndef HUD_RS485
+#define HUD_RS485 0
+#endif
+
+#ifndef HUD_RS485_UART
+#define HUD_RS485_UART 1 /* UART0 carries the Serial0 log */
+#endif
+
+/* S3 UARTs reach 5 Mbaud; the transceiver and cable length usually set the real limit */
+#ifndef HUD_RS485_BAUD
+#define HUD_RS485_BAUD 2000000
+#endif
+
+/* RX ring (internal RAM): ~80 ms at 4 Mbaud, covers the router being preempted by a map decode */
+#ifndef HUD_RS485_RX_BUF
+#define HUD_RS485_RX_BUF (32 * 1024)
+#endif
+
+#ifndef HUD_RS485_TX_BUF
+#define HUD_RS485_TX_BUF 4096
+#endif
+
+/* idle time (byte times) after which a partly filled FIFO is flushed to the ring */
+#ifndef HUD_RS485_RX_TOUT
+#define HUD_RS485_RX_TOUT 8
+#endif
+
+    /* Install the UART driver on the given pins (rts < 0: no direction control) and fill tp for
+       usb_sr_create. False if HUD_RS485 is 0, a pin is missing or the driver could not be installed. */
+    bool hud_rs485_init(int rts, int rxd, int txd, usb_sr_transport_t *tp);
+
+    typedef struct
+    {
+        uint32_t overflows;  /* RX FIFO/ring overflows; the ring is flushed and the router resyncs */
+        uint32_t line_errs;  /* framing/parity errors */
+    } hud_rs485_stats_t;
+
+    void hud_rs485_get_stats(hud_rs485_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
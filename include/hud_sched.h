@@ -0,0 +1,192 @@
+#pragma once
+
+/* 线程调度配置：所有任务的绑核、优先级、栈大小集中在这里，换板子/调负载只改这一处。
+   -DHUD_SCHED_PROFILE=<n> 选一套预设；单项再用 -DHUD_SCHED_<任务>_CORE/_PRIO/_STACK=... 覆盖
+   （命令行 > 预设 > 默认）。CORE=-1 表示不绑核。各任务实际用了多少栈、占多少 CPU 用 CMD=0x07 看（hud_taskmon.h）。
+
+   预设：
+   0 DEFAULT     USB 收、业务分发、电源管理、遥测、解码都在 core0，LVGL 独占 core1
+   1 LATENCY     快照到上屏最短：app 抬到解码/遥测之上，解码与瓦片写入降到最低，地图可以晚一点
+   2 THROUGHPUT  地图吞吐优先，解码仍在 core0：解码高于 app，解完一张才分发下一帧快照
+   3 DECODE_CORE1 core0 被 USB 高码率占满时：解码挪到 core1、比 LVGL 低一级，只用 LVGL 刷屏间隙；
+                  PNG 行转换（png_rows）反过来放到 core0 */
+#define HUD_SCHED_PROFILE_DEFAULT 0
+#define HUD_SCHED_PROFILE_LATENCY 1
+#define HUD_SCHED_PROFILE_THROUGHPUT 2
+#define HUD_SCHED_PROFILE_DECODE_CORE1 3
+
+#ifndef HUD_SCHED_PROFILE
+#define HUD_SCHED_PROFILE HUD_SCHED_PROFILE_DEFAULT
+#endif
+
+/* ---------- 预设：只写与默认不同的项 ---------- */
+
+#if HUD_SCHED_PROFILE == HUD_SCHED_PROFILE_LATENCY
+#ifndef HUD_SCHED_APP_PRIO
+#define HUD_SCHED_APP_PRIO 6
+#endif
+#ifndef HUD_SCHED_DECODE_PRIO
+#define HUD_SCHED_DECODE_PRIO 1
+#endif
+#ifndef HUD_SCHED_LVGL_PRIO
+#define HUD_SCHED_LVGL_PRIO 10
+#endif
+
+#elif HUD_SCHED_PROFILE == HUD_SCHED_PROFILE_THROUGHPUT
+#ifndef HUD_SCHED_DECODE_PRIO
+#define HUD_SCHED_DECODE_PRIO 5
+#endif
+#ifndef HUD_SCHED_TILE_WR_PRIO
+#define HUD_SCHED_TILE_WR_PRIO 2
+#endif
+
+#elif HUD_SCHED_PROFILE == HUD_SCHED_PROFILE_DECODE_CORE1
+#ifndef HUD_SCHED_DECODE_CORE
+#define HUD_SCHED_DECODE_CORE 1
+#endif
+#ifndef HUD_SCHED_DECODE_PRIO
+#define HUD_SCHED_DECODE_PRIO 7
+#endif
+#ifndef HUD_SCHED_PNG_ROWS_CORE
+#define HUD_SCHED_PNG_ROWS_CORE 0
+#endif
+#ifndef HUD_SCHED_PNG_ROWS_PRIO
+#define HUD_SCHED_PNG_ROWS_PRIO 2
+#endif
+
+#elif HUD_SCHED_PROFILE != HUD_SCHED_PROFILE_DEFAULT
+#error "unknown HUD_SCHED_PROFILE"
+#endif
+
+/* ---------- 默认 ---------- */
+
+// USB 收包/路由（usb_stream_router）：全系统最高，CDC FIFO 只有几 KB，晚读就丢
+#ifndef HUD_SCHED_USB_SR_CORE
+#define HUD_SCHED_USB_SR_CORE 0
+#endif
+#ifndef HUD_SCHED_USB_SR_PRIO
+#define HUD_SCHED_USB_SR_PRIO 18
+#endif
+#ifndef HUD_SCHED_USB_SR_STACK
+#define HUD_SCHED_USB_SR_STACK 6144
+#endif
+
+// RS-485 传输的 UART 事件线程（hud_rs485，HUD_RS485=1）：只把驱动的 RX 事件转成路由线程唤醒，与 usb_sr 同核、高一级
+#ifndef HUD_SCHED_RS485_CORE
+#define HUD_SCHED_RS485_CORE HUD_SCHED_USB_SR_CORE
+#endif
+#ifndef HUD_SCHED_RS485_PRIO
+#define HUD_SCHED_RS485_PRIO (HUD_SCHED_USB_SR_PRIO + 1)
+#endif
+#ifndef HUD_SCHED_RS485_STACK
+#define HUD_SCHED_RS485_STACK 2048
+#endif
+
+// 业务分发：取 MSGF/IMGF 交给 ui_bridge、处理控制命令
+#ifndef HUD_SCHED_APP_CORE
+#define HUD_SCHED_APP_CORE 0
+#endif
+#ifndef HUD_SCHED_APP_PRIO
+#define HUD_SCHED_APP_PRIO 4
+#endif
+#ifndef HUD_SCHED_APP_STACK
+#define HUD_SCHED_APP_STACK 3072
+#endif
+
+// 电源管理：USB 空闲休眠/唤醒 UI
+#ifndef HUD_SCHED_PM_CORE
+#define HUD_SCHED_PM_CORE 0
+#endif
+#ifndef HUD_SCHED_PM_PRIO
+#define HUD_SCHED_PM_PRIO 3
+#endif
+#ifndef HUD_SCHED_PM_STACK
+#define HUD_SCHED_PM_STACK 4096
+#endif
+
+// STAT/CRED 遥测与任务监视日志
+#ifndef HUD_SCHED_TELEMETRY_CORE
+#define HUD_SCHED_TELEMETRY_CORE 0
+#endif
+#ifndef HUD_SCHED_TELEMETRY_PRIO
+#define HUD_SCHED_TELEMETRY_PRIO 2
+#endif
+#ifndef HUD_SCHED_TELEMETRY_STACK
+#define HUD_SCHED_TELEMETRY_STACK 3072
+#endif
+
+// LVGL 线程（lvgl_port）：渲染 + 推屏
+#ifndef HUD_SCHED_LVGL_CORE
+#define HUD_SCHED_LVGL_CORE 1
+#endif
+#ifndef HUD_SCHED_LVGL_PRIO
+#define HUD_SCHED_LVGL_PRIO 8
+#endif
+#ifndef HUD_SCHED_LVGL_STACK
+#define HUD_SCHED_LVGL_STACK 6144
+#endif
+
+// 地图解码线程（ui_bridge_start_decoder）
+#ifndef HUD_SCHED_DECODE_CORE
+#define HUD_SCHED_DECODE_CORE 0
+#endif
+#ifndef HUD_SCHED_DECODE_PRIO
+#define HUD_SCHED_DECODE_PRIO 2
+#endif
+#ifndef HUD_SCHED_DECODE_STACK
+#define HUD_SCHED_DECODE_STACK 4096
+#endif
+
+// PNG 行转换（png_pipe.h）：解码线程只做 inflate，反滤波 + 转 RGB565 在另一个核上跟着做；
+// 默认与 LVGL 同核、低一级，只吃 LVGL 两帧之间的空闲
+#ifndef HUD_SCHED_PNG_ROWS_CORE
+#define HUD_SCHED_PNG_ROWS_CORE HUD_SCHED_LVGL_CORE
+#endif
+#ifndef HUD_SCHED_PNG_ROWS_PRIO
+#define HUD_SCHED_PNG_ROWS_PRIO (HUD_SCHED_LVGL_PRIO - 1)
+#endif
+#ifndef HUD_SCHED_PNG_ROWS_STACK
+#define HUD_SCHED_PNG_ROWS_STACK 2560
+#endif
+
+// 瓦片缓存后台写 flash（tile_cache）：擦写慢，永远最低
+#ifndef HUD_SCHED_TILE_WR_CORE
+#define HUD_SCHED_TILE_WR_CORE 0
+#endif
+#ifndef HUD_SCHED_TILE_WR_PRIO
+#define HUD_SCHED_TILE_WR_PRIO 1
+#endif
+#ifndef HUD_SCHED_TILE_WR_STACK
+#define HUD_SCHED_TILE_WR_STACK 3072
+#endif
+
+// 触摸采样（lvgl_port，LVGL_PORT_TOUCH=1）：HUD 行车时不用触摸，I2C 读放在最低优先级
+#ifndef HUD_SCHED_TOUCH_CORE
+#define HUD_SCHED_TOUCH_CORE 0
+#endif
+#ifndef HUD_SCHED_TOUCH_PRIO
+#define HUD_SCHED_TOUCH_PRIO 1
+#endif
+#ifndef HUD_SCHED_TOUCH_STACK
+#define HUD_SCHED_TOUCH_STACK 3072
+#endif
+
+// 基准测试驱动线程（hud_bench）：与 app 同核、低一级，走和真实上位机相同的 ui_bridge 路径
+#ifndef HUD_SCHED_BENCH_CORE
+#define HUD_SCHED_BENCH_CORE HUD_SCHED_APP_CORE
+#endif
+#ifndef HUD_SCHED_BENCH_PRIO
+#define HUD_SCHED_BENCH_PRIO (HUD_SCHED_APP_PRIO - 1)
+#endif
+#ifndef HUD_SCHED_BENCH_STACK
+#define HUD_SCHED_BENCH_STACK 4096
+#endif
+
+/* xTaskCreatePinnedToCore 的核参数：-1 -> tskNO_AFFINITY（使用处需已包含 freertos/task.h） */
+#define HUD_SCHED_AFFINITY(core) ((core) < 0 ? tskNO_AFFINITY : (core))
+
+#define HUD_SCHED_PROFILE_NAME                                                   \
+    (HUD_SCHED_PROFILE == HUD_SCHED_PROFILE_LATENCY        ? "latency"        \
+     : HUD_SCHED_PROFILE == HUD_SCHED_PROFILE_THROUGHPUT   ? "throughput"     \
+     : HUD_SCHED_PROFILE == HUD_SCHED_PROFILE_DECODE_CORE1 ? "decode-core1"   \
+                                                           : "default")
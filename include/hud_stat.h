@@ -0,0 +1,135 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Device -> host telemetry ('STAT' frame) --------
+       Sent periodically with usb_sr_send() so the host can see whether frames are being dropped
+       and back off. All counters are cumulative since boot (host diffs consecutive reports);
+       multi-byte fields are little endian. Fields are only ever appended (version stays 1):
+       hosts read the prefix they know and accept longer payloads. */
+#define HUD_STAT_MAGIC 0x54415453u /* 'STAT' little endian */
+#define HUD_STAT_WIRE_VERSION 1
+
+    typedef struct __attribute__((packed))
+    {
+        uint8_t version; /* HUD_STAT_WIRE_VERSION */
+        uint8_t rsv;
+        uint16_t period_ms; /* report interval */
+        uint32_t uptime_ms;
+
+        /* usb_sr_stats_t */
+        uint32_t usb_bytes_rx; /* low 32 bits */
+        uint32_t usb_frames_ok;
+        uint32_t usb_frames_dropped;
+        uint32_t usb_resync;
+        uint32_t usb_frames_timeout;
+
+        /* imgf_rx_stats_t */
+        uint32_t imgf_ok;
+        uint32_t imgf_drop; /* no free slot when the frame arrived */
+        uint32_t imgf_bad;
+
+        /* msgf_rx_stats_t */
+        uint32_t msgf_ok;
+        uint32_t msgf_drop;
+        uint32_t msgf_bad;
+
+        /* ui_bridge image queue */
+        uint32_t ui_img_replaced; /* whole images superseded before being shown */
+        uint16_t ui_img_pending;  /* events waiting in the image queue right now */
+        uint16_t rsv2;
+
+        /* heap, bytes */
+        uint32_t heap_free_internal;
+        uint32_t heap_min_internal; /* low-water mark since boot */
+        uint32_t heap_free_psram;
+
+        /* map decode time (hud_perf HUD_PERF_IMG_DECODE), microseconds */
+        uint32_t decode_count;
+        uint32_t decode_avg_us;
+        uint32_t decode_p99_us;
+
+        /* fragmentation (hud_heapmon), bytes; appended after the 84-byte first layout */
+        uint32_t heap_min_psram;
+        uint32_t heap_largest_internal;  /* largest free block right now */
+        uint32_t heap_largest_psram;
+        uint32_t heap_largest_min_psram; /* smallest largest-free-block sampled since boot */
+        int32_t heap_psram_trend;        /* largest PSRAM block, bytes per hour over the history window */
+    } hud_stat_wire_t;
+
+#define HUD_STAT_WIRE_BYTES 104
+
+    /* -------- Flow-control credits ('CRED' frame) --------
+       Sent whenever an IMGF slot is released and at least every HUD_CREDIT_PERIOD_MS. The host
+       may send (img_free - frames in flight) more IMGF frames, where in-flight = frames it has
+       sent minus img_seen; same for MSGF. Counters restart from 0 after a reboot. Frames lost
+       before acquire (corrupt header, BAD_LEN, lost on the link) are never seen: the host writes
+       them off once seen has not moved for a while with the device idle. */
+#define HUD_CRED_MAGIC 0x44455243u /* 'CRED' little endian */
+#define HUD_CRED_WIRE_VERSION 1
+
+    typedef struct __attribute__((packed))
+    {
+        uint8_t version; /* HUD_CRED_WIRE_VERSION */
+        uint8_t img_free; /* IMGF slots free right now */
+        uint8_t img_slots; /* IMGF slots allocated */
+        uint8_t msg_free; /* MSGF queue entries free right now */
+        uint32_t img_seen; /* IMGF headers seen since boot */
+        uint32_t msg_seen; /* MSGF headers seen since boot */
+        uint32_t img_max_bytes; /* largest IMGF payload accepted */
+    } hud_cred_wire_t;
+
+#define HUD_CRED_WIRE_BYTES 16
+
+    /* -------- Capabilities ('HELO' frame) --------
+       Answer to MSGF CMD=0x09, sent once per connect (and after the host sees the device reboot).
+       Tells the host which frame types, codecs and transport features this firmware handles and
+       how big the screen and map area are, so it can pick the cheapest encoding and size map images
+       to the panel. Bit n of a mask = type/codec/command n. Firmware that predates the handshake
+       never answers; hosts then keep their configured (blind) behaviour. */
+#define HUD_HELLO_MAGIC 0x4F4C4548u /* 'HELO' little endian */
+#define HUD_HELLO_WIRE_VERSION 1
+
+/* bumped whenever a frame type, MSGF command, codec or feature bit is added */
+#define HUD_PROTO_REV 2 /* 2: MSGF CMD=0x0A trace dump */
+
+#define HUD_HELLO_F_MUXF 0x01        /* MUXF fragments are reassembled */
+#define HUD_HELLO_F_CRC_REQUIRED 0x02 /* frames without crc32 are dropped */
+#define HUD_HELLO_F_SWAP565 0x04     /* display RGB565 is byte-swapped: send R565 with R565_FLAG_SWAPPED */
+#define HUD_HELLO_F_TILE_CACHE 0x08  /* the flash tile cache is present */
+#define HUD_HELLO_F_STAT 0x10        /* periodic STAT reports are on */
+#define HUD_HELLO_F_CRED 0x20        /* CRED flow-control reports are on */
+
+#define HUD_HELLO_CODEC_LZ4 0x01 /* frame_codecs: USB_SR_FLAG_LZ4 payloads */
+
+    typedef struct __attribute__((packed))
+    {
+        uint8_t version; /* HUD_HELLO_WIRE_VERSION */
+        uint8_t board;   /* panelLan_board_t */
+        uint16_t proto_rev; /* HUD_PROTO_REV */
+        uint16_t screen_w;  /* after rotation */
+        uint16_t screen_h;
+        uint16_t map_w;     /* map area: full map images should be this size */
+        uint16_t map_h;
+        uint8_t imgf_types;   /* IMGF_TYPE_* handled */
+        uint8_t r565_codecs;  /* R565_CODEC_* decoded */
+        uint8_t frame_codecs; /* HUD_HELLO_CODEC_* */
+        uint8_t features;     /* HUD_HELLO_F_* */
+        uint32_t msgf_cmds;   /* MSGF commands handled */
+        uint32_t img_max_bytes; /* largest IMGF payload accepted (after decompression) */
+        uint16_t msg_max_bytes;
+        uint8_t img_slots;    /* IMGF buffers */
+        uint8_t msg_queue;    /* MSGF queue depth */
+        uint8_t mux_channels; /* concurrent MUXF channels */
+        uint8_t rsv[3];
+    } hud_hello_wire_t;
+
+#define HUD_HELLO_WIRE_BYTES 32
+
+#ifdef __cplusplus
+}
+#endif
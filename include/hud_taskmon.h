@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Task monitor --------
+       Stack headroom, priority and core of a fixed list of tasks (looked up by name, so tasks
+       created later are picked up on the next sample), plus CPU usage over a window:
+       - per core: from the idle tasks' run-time counters, or, on cores built without
+         configGENERATE_RUN_TIME_STATS, an idle-hook estimate (opt-in, see hud_taskmon_init);
+       - per task: only with configGENERATE_RUN_TIME_STATS + configUSE_TRACE_FACILITY.
+       A sample costs one scheduler walk per watched task; meant for 1 Hz or slower. */
+#ifndef HUD_TASKMON_MAX_TASKS
+#define HUD_TASKMON_MAX_TASKS 12
+#endif
+#define HUD_TASKMON_MAX_CORES 2
+#define HUD_TASKMON_NAME_LEN 12 /* configMAX_TASK_NAME_LEN is 16; 11 chars are plenty here */
+
+#define HUD_TASKMON_UNKNOWN 0xFF /* cpu_pct / core_busy not measurable in this build */
+#define HUD_TASKMON_ANY_CORE 0xFF
+
+    /* Idle hooks busy-spin the idle task instead of letting the core wait for an interrupt,
+       so they are only worth it for measurements (the bench build), not in the car. */
+    bool hud_taskmon_init(bool idle_hooks);
+
+    /* Adds a task to the watch list (name as given to xTaskCreate). False if the list is full. */
+    bool hud_taskmon_watch(const char *name);
+
+    typedef struct __attribute__((packed))
+    {
+        char name[HUD_TASKMON_NAME_LEN]; /* NUL padded */
+        uint8_t core;                    /* pinned core, HUD_TASKMON_ANY_CORE if unpinned */
+        uint8_t prio;                    /* current priority (includes mutex inheritance) */
+        uint8_t base_prio;               /* assigned priority; prio above it = the task holds a
+                                            mutex a higher-priority task is blocked on */
+        uint8_t cpu_pct;                 /* share of one core over the window, or UNKNOWN */
+        uint16_t stack_free;             /* stack high-water mark: bytes never touched since start */
+        uint16_t rsv;
+    } hud_taskmon_task_t;
+
+    enum
+    {
+        HUD_TASKMON_F_TASK_CPU = 0x01, /* cpu_pct / base_prio are measured */
+        HUD_TASKMON_F_IDLE_EST = 0x02, /* core_busy comes from the idle-hook estimate */
+    };
+
+    typedef struct
+    {
+        uint32_t window_ms;
+        uint8_t flags; /* HUD_TASKMON_F_* */
+        uint8_t ncores;
+        uint8_t core_busy[HUD_TASKMON_MAX_CORES]; /* percent, or UNKNOWN */
+        uint8_t ntasks;                           /* watched tasks that exist right now */
+        hud_taskmon_task_t task[HUD_TASKMON_MAX_TASKS];
+    } hud_taskmon_report_t;
+
+    /* Window state owned by the caller, so independent readers (host query, Serial log, bench)
+       don't cut each other's windows. Zero-initialise; the first sample covers time since boot. */
+    typedef struct
+    {
+        uint32_t t_ms;
+        uint32_t total; /* run-time counter (or us for the idle-hook estimate) */
+        uint32_t idle[HUD_TASKMON_MAX_CORES];
+        uint32_t run[HUD_TASKMON_MAX_TASKS];
+    } hud_taskmon_mark_t;
+
+    /* Fills out for the window since the previous call with the same mark, then restarts it. */
+    void hud_taskmon_sample(hud_taskmon_mark_t *mark, hud_taskmon_report_t *out);
+
+    /* -------- Wire format (MSGF CMD_GET_TASKS reply, magic 'TASK') --------
+       u8 version (1), u8 task count, u8 core count, u8 flags (bit0 per-task cpu valid,
+       bit1 core busy is an idle-hook estimate), u32 window ms, u8 core busy[2], u16 reserved,
+       then per task the 20-byte hud_taskmon_task_t above (little endian). */
+#define HUD_TASKMON_MAGIC 0x4B534154u /* 'TASK' little endian */
+#define HUD_TASKMON_WIRE_VERSION 1
+#define HUD_TASKMON_WIRE_BYTES (12 + HUD_TASKMON_MAX_TASKS * 20)
+
+    size_t hud_taskmon_serialize(const hud_taskmon_report_t *r, uint8_t *dst, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
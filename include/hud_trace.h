@@ -0,0 +1,79 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Binary event trace --------
+       Pipeline events go into one ring per core of 16-byte records (timestamp, event id, seq, one
+       argument) instead of Serial0 lines: an event costs a timer read, an atomic add on an index in
+       internal RAM and four stores into the PSRAM ring, and never blocks. The rings keep the last
+       HUD_TRACE_RECORDS events per core and are only read on demand: MSGF CMD=0x0A dumps them as
+       'TRCE' frames, example/host_pc.py --trace turns the dump into a Chrome trace / Perfetto file.
+       hud_perf stage stamps and durations are traced too (see hud_perf.c).
+       Build with -DHUD_TRACE_ENABLE=0 to compile every hook out. */
+#ifndef HUD_TRACE_ENABLE
+#define HUD_TRACE_ENABLE 1
+#endif
+
+#ifndef HUD_TRACE_RECORDS
+#define HUD_TRACE_RECORDS 4096 /* per core, power of two; 64 KB of PSRAM each */
+#endif
+
+    typedef enum
+    {
+        HUD_TR_NONE = 0,
+        /* hud_perf stage stamp, id = HUD_TR_STAGE + hud_perf_stage_t, seq = snapshot seq */
+        HUD_TR_STAGE = 1,
+        /* hud_perf duration ending at the timestamp, id = HUD_TR_METRIC + hud_perf_metric_t, arg = us */
+        HUD_TR_METRIC = 16,
+        /* image path; seq = IMGF seq where known, otherwise the IMGF token (slot) */
+        HUD_TR_IMG_DISPATCH = 48, /* app_task hands a frame to the bridge; arg = type << 24 | len */
+        HUD_TR_IMG_QUEUED,        /* whole image queued for decode; seq = token, arg = queue depth */
+        HUD_TR_IMG_REPLACED,      /* queue full, the oldest queued whole image was dropped for it */
+        HUD_TR_IMG_DROPPED,       /* queue still full, the new image itself was dropped */
+        HUD_TR_IMG_APPLY_BEGIN,   /* decoder starts the latest whole image; seq = token */
+        HUD_TR_IMG_APPLY_END,
+    } hud_trace_event_t;
+
+    typedef struct __attribute__((packed))
+    {
+        uint32_t t_us; /* esp_timer, low 32 bits */
+        uint32_t seq;
+        uint32_t arg;
+        uint16_t id;   /* hud_trace_event_t */
+        uint8_t core;
+        uint8_t rsv;
+    } hud_trace_rec_t;
+
+    /* Allocates the rings (PSRAM preferred). Events before this, or if it failed, are dropped. */
+    bool hud_trace_init(void);
+
+    void hud_trace_emit(uint16_t id, uint32_t seq, uint32_t arg);
+
+    /* -------- Wire format (MSGF CMD=0x0A reply, magic 'TRCE') --------
+       Argument bit0 = clear the rings after the dump. Each core's ring goes out oldest first in
+       one or more frames of: u8 version (1), u8 core, u8 core count, u8 rsv, u16 chunk index,
+       u16 chunk count (for this core; an empty ring still sends one chunk), u32 device time (us)
+       when the dump started, u32 records lost to wrap-around since the last clear, then
+       (len - 16) / 16 hud_trace_rec_t records, little endian. Tracing pauses during the dump. */
+#define HUD_TRACE_MAGIC 0x45435254u /* 'TRCE' little endian */
+#define HUD_TRACE_WIRE_VERSION 1
+#define HUD_TRACE_CHUNK_RECORDS 256
+
+    /* Sends the rings through send (one call per frame, returns false to abort). */
+    bool hud_trace_dump(bool (*send)(const void *frame, size_t len, void *ctx), void *ctx, bool clear);
+
+#if HUD_TRACE_ENABLE
+#define HUD_TRACE(id, seq, arg) hud_trace_emit((uint16_t)(id), (uint32_t)(seq), (uint32_t)(arg))
+#else
+#define HUD_TRACE(id, seq, arg) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
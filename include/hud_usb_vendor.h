@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usb_stream_router.h"
+
+/* USB vendor 类批量端点传输（pio run -e sc01_plus_vendor）：路由器不走 CDC，改走一个 class 0xFF
+   接口的一对 bulk 端点。Arduino 的 USBCDC/USBVendor 把收到的每个字节逐个塞进 FreeRTOS 队列、
+   读出时再逐个取，帧越大越吃 CPU；这里 TinyUSB 任务每收到一包就整块搬进 HUD_USB_VENDOR_RX_BUF
+   的流缓冲，路由器按 read_chunk 成块取走（read_into 直接落到接收器的 PSRAM 缓冲）。
+   S3 是全速设备，bulk 包仍是 64 字节，省下的是逐字节排队与小块读的开销。
+   流缓冲满时不再从 TinyUSB 取数，端点 NAK，主机自动等待，不丢数据。
+   上位机按 VID 0x303A + 接口类 0xFF 找设备（example/host_pc.py --port vendor，SDK 的 UsbBulkTransport）；
+   CDC 口照样枚举，只是不再接路由器。 */
+#ifndef HUD_USB_VENDOR
+#define HUD_USB_VENDOR 0
+#endif
+
+// 接收流缓冲（内部 RAM），至少装得下几毫秒的满速数据，路由器被抢占时主机不至于被 NAK
+#ifndef HUD_USB_VENDOR_RX_BUF
+#define HUD_USB_VENDOR_RX_BUF (16 * 1024)
+#endif
+
+// 发送：端点 FIFO 一直满（主机没在读）超过这么久，usb_sr_send 返回失败
+#ifndef HUD_USB_VENDOR_TX_TIMEOUT_MS
+#define HUD_USB_VENDOR_TX_TIMEOUT_MS 100
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* USB.begin() 之前调用：登记 vendor 接口描述符、建好接收缓冲，并填好给 usb_sr_create 的 tp。
+   HUD_USB_VENDOR=0 或内存不足时返回 false，调用方退回 CDC */
+bool hud_usb_vendor_init(usb_sr_transport_t *tp);
+
+#ifdef __cplusplus
+}
+#endif
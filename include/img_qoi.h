@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- QOI ("Quite OK Image") decoder --------
+       Byte-oriented lossless codec: every op is one to five bytes with no bit stream and no
+       dictionary beyond a 64-entry color cache, so decoding is a tight loop several times faster
+       than inflate at comparable sizes on map imagery. Decodes straight to RGB565; alpha is ignored
+       (maps are opaque). Used as R565_CODEC_QOI (see img_r565.h) and, via img_qoi_lv_register, for
+       whole QOI files handed to LVGL as image sources. */
+#define QOI_HDR_BYTES 14 /* "qoif", u32 BE width, u32 BE height, channels, colorspace */
+
+    typedef struct
+    {
+        uint32_t w;
+        uint32_t h;
+        uint8_t channels; /* 3 or 4 */
+    } qoi_info_t;
+
+    /* Validate a QOI file header. False if data does not start with one. */
+    bool qoi_parse(const uint8_t *data, size_t len, qoi_info_t *info);
+
+    /* Decode the whole file into dst as packed w*h RGB565 (big-endian pixels when swapped, i.e.
+       LV_COLOR_16_SWAP order). dst_cap must hold w*h*2 bytes. False on truncated/corrupt data. */
+    bool qoi_decode_r565(const uint8_t *data, size_t len, uint8_t *dst, size_t dst_cap, bool swapped);
+
+    /* Register the LVGL image decoder for QOI files (lv_img_dsc_t sources whose data starts with
+       "qoif"). Call once after lv_init; the result is LV_IMG_CF_TRUE_COLOR. */
+    void img_qoi_lv_register(void);
+
+#ifdef __cplusplus
+}
+#endif
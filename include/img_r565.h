@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- IMGF type 2: pre-converted RGB565 bitmap --------
+       Lets a host with spare CPU skip PNG entirely: the device only has to (optionally)
+       decompress into the LVGL image buffer. Payload = r565_hdr_t + data. */
+#define R565_MAGIC 0x35363552u /* 'R565' little endian */
+
+    enum
+    {
+        R565_CODEC_RAW = 0, /* stride*h pixels */
+        R565_CODEC_RLE = 1, /* packets: c<0x80 -> c+1 literal px follow; c>=0x80 -> (c&0x7f)+1 x next px */
+        R565_CODEC_LZ4 = 2, /* one LZ4 block (no frame header) of raw_len bytes */
+        R565_CODEC_QOI = 3, /* a whole QOI file (see img_qoi.h) of w x h, stride = w; decoded straight
+                               to RGB565 in the wanted byte order, R565_FLAG_SWAPPED is ignored */
+    };
+
+    enum
+    {
+        R565_FLAG_SWAPPED = 0x01, /* pixels are big-endian (LV_COLOR_16_SWAP order) */
+    };
+
+    typedef struct __attribute__((packed))
+    {
+        uint32_t magic;   /* R565_MAGIC */
+        uint16_t w;
+        uint16_t h;
+        uint16_t stride;  /* source pixels per row (>= w), 0 -> w */
+        uint8_t codec;    /* R565_CODEC_* */
+        uint8_t flags;    /* R565_FLAG_* */
+        uint32_t raw_len; /* decoded bytes = stride*h*2 */
+    } r565_hdr_t;
+
+    /* -------- IMGF type 3: dirty rectangle against the current map --------
+       Payload = r565_rect_t + a complete type-2 payload holding just the rectangle's pixels.
+       map_w/map_h name the bitmap the host diffed against; the device drops the patch if its
+       current map differs (e.g. a whole frame was lost), the host's next full frame resyncs. */
+    typedef struct __attribute__((packed))
+    {
+        uint16_t x;
+        uint16_t y;
+        uint16_t map_w;
+        uint16_t map_h;
+    } r565_rect_t;
+
+    /* Validate the payload header. Fills *hdr (stride resolved) and returns false on garbage. */
+    bool r565_parse(const uint8_t *payload, size_t len, r565_hdr_t *hdr);
+
+    /* Bytes dst must provide for r565_decode (>= w*h*2, the decoder needs room for all of raw_len). */
+    size_t r565_work_size(const r565_hdr_t *hdr);
+
+    /* Decode into dst as a packed w*h RGB565 image in the requested byte order.
+       payload/len is the full IMGF payload (header included). */
+    bool r565_decode(const r565_hdr_t *hdr, const uint8_t *payload, size_t len,
+                     uint8_t *dst, size_t dst_cap, bool want_swapped);
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,36 +11,90 @@ extern "C"
 
     typedef struct imgf_rx imgf_rx_t;
 
+/* upper bound for imgf_rx_config_t.slots */
+#define IMGF_RX_MAX_SLOTS 8
+
     typedef enum
     {
         IMGF_DROP_NEW = 0,
         IMGF_DROP_OLD = 1
     } imgf_drop_policy_t;
 
+    /* IMGF hdr.type */
+    typedef enum
+    {
+        IMGF_TYPE_PNG = 0,      /* whole PNG in one frame */
+        IMGF_TYPE_PNG_FRAG = 1, /* one piece of a PNG; hdr.rsv = fragment index (0..) */
+        IMGF_TYPE_R565 = 2,     /* pre-converted RGB565 bitmap, see img_r565.h */
+        IMGF_TYPE_R565_RECT = 3, /* RGB565 patch for a rectangle of the current map */
+        IMGF_TYPE_TRACK = 4,     /* vector track polyline drawn over the map, see track_vec.h */
+        IMGF_TYPE_TILE = 5,      /* one cacheable map tile, see tile_cache.h */
+        IMGF_TYPE_TILE_MAP = 6,  /* map composed from cached tiles, see tile_cache.h */
+        IMGF_TYPE_TILE_VIEW = 7, /* pan the tile viewport, see tile_cache.h / tile_view.h */
+    } imgf_type_t;
+
+    /* IMGF hdr.flags for fragments */
+    enum
+    {
+        IMGF_FLAG_FIRST = 0x01,
+        IMGF_FLAG_LAST = 0x02,
+    };
+
     typedef struct
     {
         size_t max_png_bytes; /* e.g. 128*1024 */
         bool require_crc;
         imgf_drop_policy_t drop_policy;
+        int slots;          /* ring depth, 0 -> 2; clamped to [2, IMGF_RX_MAX_SLOTS] */
+        size_t mem_reserve; /* slots beyond the first 2 are only allocated while this much
+                               buffer heap stays free afterwards (0 = no limit) */
+        void (*on_commit)(void *arg); /* optional, router task: a slot became READY (wake the consumer) */
+        void *on_commit_arg;
     } imgf_rx_config_t;
 
-    /* Create IMGF receiver (allocates 2 buffers; PSRAM preferred if available by your platform allocator). */
+    /* Create IMGF receiver (allocates up to cfg->slots buffers; PSRAM preferred if available by
+       your platform allocator). Fails only if the first 2 buffers cannot be allocated. */
     imgf_rx_t *imgf_rx_create(const imgf_rx_config_t *cfg);
     void imgf_rx_destroy(imgf_rx_t *h);
 
     /* Get receiver descriptor to register into router */
     void imgf_rx_get_receiver(imgf_rx_t *h, usb_sr_receiver_t *out);
 
-    /* Consumer API (non-blocking) */
+    /* Number of slots actually allocated. */
+    int imgf_rx_slot_count(imgf_rx_t *h);
+
+    /* Slots currently FREE, i.e. frames that can arrive without stealing a READY image.
+       Advertised to the host as flow-control credits. */
+    int imgf_rx_free_slots(imgf_rx_t *h);
+
+    /* Consumer API (non-blocking, lock-free). get_ready hands out the oldest READY image;
+       token identifies its slot and must be passed back to release. */
     bool imgf_rx_get_ready(imgf_rx_t *h, const uint8_t **png, size_t *len, uint32_t *seq, int *token);
     void imgf_rx_release(imgf_rx_t *h, int token);
 
+    /* Same as get_ready, plus the frame type/flags needed to reassemble fragments. */
+    typedef struct
+    {
+        const uint8_t *data;
+        size_t len;
+        uint32_t seq;
+        int token;
+        uint8_t type;  /* imgf_type_t */
+        uint8_t flags; /* IMGF_FLAG_* */
+        uint16_t frag; /* fragment index */
+    } imgf_rx_item_t;
+
+    bool imgf_rx_get_item(imgf_rx_t *h, imgf_rx_item_t *out);
+
     /* stats */
     typedef struct
     {
         uint32_t frames_ok;
         uint32_t frames_drop;
         uint32_t frames_bad;
+        uint32_t frames_seen; /* headers the router acquired a buffer for (ok + drop + in progress +
+                                 bad after acquire); drops before acquire are only in frames_bad,
+                                 frames the router never matched to us are in neither */
     } imgf_rx_stats_t;
 
     void imgf_rx_get_stats(imgf_rx_t *h, imgf_rx_stats_t *out);
@@ -6,7 +6,22 @@
 extern "C" {
 #endif
 
-// 初始化：屏幕、触摸、LVGL、UI（ui_init）以及 LVGL 刷新线程
+// 渲染模式，编译期用 -DLVGL_PORT_RENDER_MODE=<值> 选择（默认 AUTO）
+typedef enum {
+    LVGL_RENDER_AUTO = -1,    // 有连续帧缓冲的 RGB 面板用 PANEL_FB，其余 PARTIAL
+
+    LVGL_RENDER_FULL = 0,     // PSRAM 整屏双缓冲 + full_refresh，每帧重绘整屏
+    LVGL_RENDER_PARTIAL = 1,  // 内部 SRAM 条带双缓冲，只重绘脏区（LVGL_PORT_STRIPE_LINES 行/块）
+    LVGL_RENDER_DIRECT = 2,   // PSRAM 整屏单缓冲 direct_mode，只重绘并推送脏区
+    LVGL_RENDER_PANEL_FB = 3  // RGB 面板：direct_mode 直接画进面板自己的帧缓冲，省掉整屏缓冲与每帧拷贝
+} lvgl_render_mode_t;
+
+// 开机第一步：只初始化屏幕（含总线时钟标定）并把 flash 里的背景图直接推到面板，
+// 不依赖 LVGL。之后 USB 可以先起来，UI 在开机画面后面慢慢建
+void lvgl_port_splash(void);
+
+// 初始化：LVGL、UI（ui_init）以及 LVGL 刷新线程；没调过 lvgl_port_splash 时先调它。
+// 静态层烘焙等耗时项在第一帧上屏后才在 LVGL 线程里做（ui_bridge_init_late）
 void lvgl_port_init(void);
 
 // 给 LVGL 线程一个“循环钩子”（在 LVGL 线程内部调用）
@@ -22,6 +37,23 @@ void lvgl_port_resume(void);
 // 当前是否已进入暂停态
 bool lvgl_port_is_suspended(void);
 
+// 实际生效的渲染模式（AUTO 已解析；PSRAM 分配失败、面板没有连续帧缓冲时会退回 PARTIAL）
+lvgl_render_mode_t lvgl_port_render_mode(void);
+
+// 清掉当前板的总线时钟标定结果（见 hud_bus_tune.h），下次启动重新标定
+void lvgl_port_forget_bus_tune(void);
+
+// 板型（panelLan_board_t）、旋转后的屏幕分辨率，以及 LVGL 位图是否为字节交换的 RGB565（LV_COLOR_16_SWAP）。
+// lvgl_port_splash 之后有效
+void lvgl_port_panel_info(uint8_t *board, uint16_t *hor_res, uint16_t *ver_res, bool *swap565);
+
+// 当前板的 RS-485 引脚（板型在 lvgl_port_splash 里确定，之后才有效）；rts<0 表示收发器方向不用控制。
+// 板上没有 RS-485（RX/TX 未引出）时返回 false
+bool lvgl_port_rs485_pins(int8_t *rts, int8_t *rxd, int8_t *txd);
+
+// LVGL 刷新周期（ms，任意线程调用，下一轮 LVGL 循环生效）；0 恢复 LV_DISP_DEF_REFR_PERIOD
+void lvgl_port_set_refresh_period(uint32_t ms);
+
 // 设置屏幕亮度（0-255）
 bool lvgl_port_set_brightness(uint8_t brightness);
 
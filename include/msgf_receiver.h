@@ -11,11 +11,19 @@ extern "C"
 
     typedef struct msgf_rx msgf_rx_t;
 
+    /* Single-producer (router RX task) / single-consumer (app task) lock-free ring over a slot
+       pool: no kernel calls per message. When the ring is full, new messages are dropped
+       (reliable mode, commands keep their order) unless their CMD byte is in latest_cmd_mask:
+       those go to a one-deep latest-wins mailbox instead, replacing whatever it held. The
+       consumer gets mailbox and ring messages back in arrival order. */
     typedef struct
     {
-        size_t max_msg_bytes; /* e.g. 1024 */
-        int queue_depth;      /* e.g. 4 or 8 */
+        size_t max_msg_bytes;     /* e.g. 1024 */
+        int queue_depth;          /* ring slots, e.g. 4 or 8 */
         bool require_crc;
+        uint32_t latest_cmd_mask; /* bit n: CMD n is latest-wins when the ring is full (snapshots) */
+        void (*on_commit)(void *arg); /* optional, router task: a message was queued (wake the consumer) */
+        void *on_commit_arg;
     } msgf_rx_config_t;
 
     msgf_rx_t *msgf_rx_create(const msgf_rx_config_t *cfg);
@@ -23,15 +31,26 @@ extern "C"
 
     void msgf_rx_get_receiver(msgf_rx_t *h, usb_sr_receiver_t *out);
 
-    /* consumer API: pop one message (non-blocking) */
+    /* consumer API, zero-copy: point *data at the oldest message inside the pool (non-blocking).
+       The message stays valid, and keeps its slot, until msgf_rx_release(); peeking again
+       before that returns the same message. */
+    bool msgf_rx_peek(msgf_rx_t *h, const uint8_t **data, size_t *len, uint32_t *seq);
+    void msgf_rx_release(msgf_rx_t *h);
+
+    /* consumer API: copy out and release one message (non-blocking) */
     bool msgf_rx_pop(msgf_rx_t *h, uint8_t *dst, size_t dst_cap, size_t *out_len, uint32_t *out_seq);
 
+    /* free ring slots (flow-control credits advertised to the host) */
+    int msgf_rx_free_space(msgf_rx_t *h);
+
     /* stats */
     typedef struct
     {
         uint32_t frames_ok;
         uint32_t frames_drop;
         uint32_t frames_bad;
+        uint32_t frames_seen; /* headers the router acquired a buffer for; drops before acquire are
+                                 only in frames_bad */
     } msgf_rx_stats_t;
 
     void msgf_rx_get_stats(msgf_rx_t *h, msgf_rx_stats_t *out);
@@ -0,0 +1,36 @@
+#pragma once
+#include "png_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Two-core PNG pipeline --------
+       png_stream with its row stage moved to a worker task: the feeding task (the map decoder,
+       core 0 by default) only parses chunks and inflates, copying each filtered scanline into a
+       ring of PNG_PIPE_ROWS row slots; the "png_rows" worker (hud_sched.h, default core 1 one
+       priority below LVGL, so it runs while LVGL sleeps between frames) unfilters, converts and
+       calls the row callback. Both stages are roughly the same cost on typical map PNGs, so a
+       large image finishes in a little over half the single-task time. The row callback runs on
+       the worker: it may only write its own row of the output.
+       Same calls and results as png_stream; feed returns DONE only after the worker has delivered
+       the last row, and reset/ERR wait until rows in flight are dropped, so the callbacks never
+       outlive the image. Feed from one task only. */
+#ifndef PNG_PIPE_ROWS
+#define PNG_PIPE_ROWS 8 /* row slots, internal RAM: PNG_PIPE_ROWS * raw_len bytes */
+#endif
+
+    typedef struct png_pipe png_pipe_t;
+
+    /* Starts the worker; NULL if the decoder, the ring or the task could not be created
+       (fall back to png_stream). The pipeline lives for the rest of the run. */
+    png_pipe_t *png_pipe_create(png_stream_begin_fn begin, png_stream_row_fn row, void *user);
+
+    void png_pipe_reset(png_pipe_t *pp);
+
+    int png_pipe_feed(png_pipe_t *pp, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
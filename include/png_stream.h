@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Incremental PNG decoder --------
+       The file can be fed in arbitrary pieces (e.g. one IMGF fragment at a time); every row is
+       delivered as soon as the inflated data for it is complete, so decoding overlaps the
+       transfer. Supported: non-interlaced, 8-bit gray / RGB / gray+alpha / RGBA and
+       1/2/4/8-bit gray / palette (palette tRNS honoured). Chunk CRCs and adler32 are not
+       checked, the transport CRC covers that. */
+    typedef struct png_stream png_stream_t;
+
+    typedef struct
+    {
+        uint32_t w;
+        uint32_t h;
+        bool has_alpha;   /* RGBA/gray+alpha, or palette with tRNS */
+        uint32_t raw_len; /* filtered scanline incl. the filter byte (split mode row size) */
+    } png_stream_info_t;
+
+    /* Called once per image before the first row. Return false to abort the image. */
+    typedef bool (*png_stream_begin_fn)(void *user, const png_stream_info_t *info);
+    /* One decoded row, w pixels RGBA8888, y increasing from 0. */
+    typedef void (*png_stream_row_fn)(void *user, uint32_t y, const uint8_t *rgba);
+
+    enum
+    {
+        PNG_STREAM_ERR = -1,
+        PNG_STREAM_MORE = 0, /* consumed everything, image not complete yet */
+        PNG_STREAM_DONE = 1, /* last row delivered; further input is ignored */
+    };
+
+    png_stream_t *png_stream_create(png_stream_begin_fn begin, png_stream_row_fn row, void *user);
+    void png_stream_destroy(png_stream_t *ps);
+
+    /* Start a new image (drops any partial state). */
+    void png_stream_reset(png_stream_t *ps);
+
+    /* Feed the next piece of the file. Result is sticky: after ERR/DONE, reset first. */
+    int png_stream_feed(png_stream_t *ps, const uint8_t *data, size_t len);
+
+    /* -------- Split row stage --------
+       With a raw callback set, feed stops after inflate: each complete, still filtered scanline
+       (raw_len bytes) goes to raw, in order, and the buffer is reused as soon as raw returns.
+       Unfilter + pixel conversion + the row callback then happen in png_stream_finish_row, which
+       may run on another task/core (see png_pipe.h): called once per row in y order, it only
+       touches the row buffers and the image header, never the inflate state. Rows handed to
+       raw must all be finished before the next reset. Return false from raw to abort. */
+    typedef bool (*png_stream_raw_fn)(void *user, uint32_t y, const uint8_t *raw, uint32_t len);
+
+    void png_stream_set_split(png_stream_t *ps, png_stream_raw_fn raw);
+
+    /* Unfilters raw in place against the previous finished row, converts it and calls row. */
+    void png_stream_finish_row(png_stream_t *ps, uint32_t y, uint8_t *raw);
+
+#ifdef __cplusplus
+}
+#endif
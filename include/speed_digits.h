@@ -0,0 +1,26 @@
+#pragma once
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 速度数字缓存控件：启动时把速度标签字体的 0-9 预解码成 A8 位图（内部 RAM），
+   之后速度变化只切换几张 lv_img 的图源，不再经字体查找、4bpp 解包和标签排版。
+   阴影/前景两个标签各一层，颜色沿用标签的文字颜色（图像重着色）。 */
+
+struct _lv_obj_t;
+
+/* 在 LVGL 线程、ui_init 之后调用一次。labels 按从下到上的叠放顺序给出，
+   成功后原标签被隐藏，失败（内存不足等）时保持不变、继续走标签 */
+bool speed_digits_init(struct _lv_obj_t *const *labels, int count);
+
+/* 显示速度；超出缓存能表示的范围（负数或超过 3 位）时返回 false，调用方退回标签 */
+bool speed_digits_set(int value);
+
+/* 是否已接管速度显示 */
+bool speed_digits_active(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Persistent map tile cache --------
+       Map backgrounds are assembled from tiles the host names by (z, x, y) (the host picks the
+       scheme; 64x64 pixel tiles fit a slot comfortably). Tile bodies are complete R565 payloads
+       (see img_r565.h, RLE/LZ4 as the host chose) stored in the "tiles" data partition, so after
+       a reboot or on a repeat route the host only names them:
+
+         IMGF type 5 (TILE)     tile_key_wire_t + R565 payload   -> cached and drawn where placed
+         IMGF type 6 (TILE_MAP) tile_map_hdr_t + count * tile_ref_t -> map composed from the cache
+
+       Tiles a TILE_MAP references but the cache doesn't hold are reported back in one 'TMIS'
+       frame (n * tile_key_wire_t); the host answers with TILE frames, which are patched into the
+       map as they arrive. The last TILE_MAP is saved as well and recomposed at boot, so the map
+       is back before the host connects.
+
+       IMGF type 7 (TILE_VIEW) pans a viewport over a zoom level's grid of TILE_VIEW_PX tiles
+       instead: tile (z, x, y) covers world pixels [x*64, x*64+64) x [y*64, y*64+64) and the frame
+       only names the viewport's top-left world pixel. The device keeps the tiles around the
+       viewport in RAM, loads the ones that enter it from this cache and reports the rest as
+       above; a pan costs a few bytes plus the tiles that come into view.
+
+       Flash layout: a 64 KB ring of layout records, then fixed slots of TILE_CACHE_SLOT_BYTES,
+       each a 32-byte header written after its body (an interrupted write is simply not there).
+       A RAM index keeps keys and use order; when full the least recently used slot is reused.
+       Use order lives in RAM only, across reboots it falls back to write order. Flash writes
+       stall the caches, so they run on a low-priority task, one tile at a time. */
+#define TILE_CACHE_SUBTYPE 0x40          /* partition: data, 0x40, name "tiles" */
+#define TILE_CACHE_SLOT_BYTES (12 * 1024)
+#define TILE_CACHE_MAX_BYTES (TILE_CACHE_SLOT_BYTES - 32) /* largest cacheable tile payload */
+#define TILE_LAYOUT_MAX_BYTES 1008       /* largest TILE_MAP payload that is saved for boot */
+
+#define TILE_MAP_MAGIC 0x50414D54u /* 'TMAP' little endian */
+#define TILE_MISS_MAGIC 0x53494D54u /* 'TMIS' little endian, device -> host */
+#define TILE_VIEW_MAGIC 0x57455654u /* 'TVEW' little endian */
+#define TILE_VIEW_PX 64             /* view tiles are square, TILE_VIEW_PX wide */
+
+    typedef struct __attribute__((packed))
+    {
+        uint8_t z;
+        uint8_t rsv[3];
+        uint32_t x;
+        uint32_t y;
+    } tile_key_wire_t;
+
+    typedef struct __attribute__((packed))
+    {
+        uint32_t magic;  /* TILE_MAP_MAGIC */
+        uint16_t map_w;  /* composed bitmap size */
+        uint16_t map_h;
+        uint16_t count;  /* tile_ref_t entries that follow */
+        uint16_t bg;     /* RGB565 (plain order) for area no tile covers */
+    } tile_map_hdr_t;
+
+    typedef struct __attribute__((packed))
+    {
+        int16_t dx;      /* tile's top-left corner in the map, may be negative (clipped) */
+        int16_t dy;
+        tile_key_wire_t key;
+    } tile_ref_t;
+
+    typedef struct __attribute__((packed))
+    {
+        uint32_t magic;  /* TILE_VIEW_MAGIC */
+        uint8_t z;       /* zoom level the tiles are named in */
+        uint8_t rsv;
+        uint16_t bg;     /* RGB565 (plain order) where a tile is not loaded yet */
+        uint32_t px;     /* viewport's top-left corner, world pixels at zoom z */
+        uint32_t py;
+    } tile_view_hdr_t;
+
+    static inline uint64_t tile_key(const tile_key_wire_t *k)
+    {
+        return ((uint64_t)k->z << 56) | ((uint64_t)(k->x & 0x0FFFFFFFu) << 28) | (k->y & 0x0FFFFFFFu);
+    }
+
+    /* Find the partition and rebuild the index. False without a "tiles" partition; every other
+       call is then a cheap no-op/miss, so the device works as before. */
+    bool tile_cache_init(void);
+
+    /* Copy a cached payload into dst. False on a miss (or if it doesn't fit in cap). */
+    bool tile_cache_get(uint64_t key, uint8_t *dst, size_t cap, size_t *len);
+
+    /* Queue a tile for writing (data is copied). False if the cache is off, the payload is larger
+       than TILE_CACHE_MAX_BYTES or the write queue is full. */
+    bool tile_cache_put(uint64_t key, const uint8_t *data, size_t len);
+
+    /* Remember a TILE_MAP payload for boot. Saved lazily (flash wear), latest call wins. */
+    void tile_cache_save_layout(const uint8_t *data, size_t len);
+
+    /* Last saved TILE_MAP payload, false if there is none. */
+    bool tile_cache_load_layout(uint8_t *dst, size_t cap, size_t *len);
+
+    typedef struct
+    {
+        uint32_t slots;     /* tile capacity */
+        uint32_t used;
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t writes;
+        uint32_t evictions;
+        uint32_t dropped;   /* puts refused (queue full / too large) */
+    } tile_cache_stats_t;
+
+    void tile_cache_get_stats(tile_cache_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "tile_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 瓦片视口（IMGF type=7，见 tile_cache.h）：地图区域上一个裁剪容器，内含 G×G 张 64×64 的 lv_img，
+   像素在一块 PSRAM 瓦片池里。主机只给出视口左上角的世界坐标，平移时只移动这些图像对象（可以不到一个瓦片），
+   移入视口的瓦片才需要加载；地图底图不再整张替换。
+   瓦片 (列, 行) 固定放在槽 (列 mod G, 行 mod G)，平移时已加载的瓦片原地不动。 */
+
+struct _lv_obj_t;
+
+/* LVGL 线程、ui_init 之后调用一次：在 map_img 的上一层创建隐藏的视口容器（瓦片池在第一帧到达时才分配） */
+bool tile_view_init(struct _lv_obj_t *map_img);
+
+/* 视口容器（静态层需把它标成动态），未初始化时为 NULL */
+struct _lv_obj_t *tile_view_obj(void);
+
+/* 每边瓦片数 G，init 之后不变；未初始化时为 0（解码侧据此判断是否支持视口） */
+uint8_t tile_view_grid(void);
+
+/* 瓦片 (col, row) 所在的槽 */
+static inline uint16_t tile_view_slot(uint32_t col, uint32_t row, uint8_t g)
+{
+    return (uint16_t)((row % g) * g + col % g);
+}
+
+/* 以下仅 LVGL 线程 */
+
+/* 平移到新视口并显示（小幅移动时动画过渡）；还没装上对应瓦片的槽先露出底色 */
+void tile_view_set(const tile_view_hdr_t *v);
+
+/* 把一块已解码的瓦片（64×64 lv_color_t）装进槽 slot */
+void tile_view_put(uint16_t slot, uint64_t key, const uint8_t *px);
+
+/* 换成整张地图时隐藏视口（已装的瓦片保留，回到视口模式时直接复用） */
+void tile_view_hide(void);
+
+#ifdef __cplusplus
+}
+#endif
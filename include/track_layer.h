@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 矢量轨迹层：地图底图之上一张与地图区域同尺寸的 A8 位图（图像重着色成轨迹颜色）。
+   IMGF type=4 的折线（见 track_vec.h）直接画进这张位图，每次只重绘新线段覆盖的区域，
+   底图保持不变；轨迹更新从“整张 PNG”降到几十字节。 */
+
+struct _lv_obj_t;
+
+/* LVGL 线程、ui_init 之后调用一次：在 map_img 的上一层创建隐藏的覆盖层。
+   位图内存在第一帧轨迹到达时才分配，不用矢量轨迹时不占内存 */
+bool track_layer_init(struct _lv_obj_t *map_img);
+
+/* 覆盖层对象（静态层需把它标成动态），未初始化时为 NULL */
+struct _lv_obj_t *track_layer_obj(void);
+
+/* 仅 LVGL 线程：应用一帧 IMGF type=4 载荷。格式错误、或追加帧与已画内容接不上时返回 false */
+bool track_layer_apply(const uint8_t *payload, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- IMGF type 4: vector track --------
+       The host sends the (simplified) GPS polyline instead of a rendered map: points are
+       projected into a host-chosen viewport of view_w x view_h units, the first one absolute,
+       the rest as int16 deltas. The device scales the viewport onto its track layer and draws
+       the segments into an A8 overlay above the map, so a GPS update costs a few bytes instead
+       of a whole image.
+
+       A frame either restarts the polyline (TRK_FLAG_RESET: clear, draw points 0..count-1) or
+       appends to it (first point joins the last one drawn). Appends carry the index of their
+       first point; if that doesn't match what the device has drawn for the same viewport (an
+       earlier frame was lost) the frame is dropped and the host's next reset resyncs.
+       Payload = trk_hdr_t + (count - 1) * {int16 dx, int16 dy}. */
+#define TRK_MAGIC 0x314B5254u /* 'TRK1' little endian */
+#define TRK_MAX_POINTS 2048
+
+    enum
+    {
+        TRK_FLAG_RESET = 0x01, /* clear the layer, this frame starts the polyline */
+    };
+
+    typedef struct __attribute__((packed))
+    {
+        uint32_t magic;   /* TRK_MAGIC */
+        uint32_t view;    /* host viewport id, appends only apply on the same one */
+        uint16_t view_w;  /* coordinate space the points live in */
+        uint16_t view_h;
+        uint16_t first;   /* index of this frame's first point within the polyline */
+        uint16_t count;   /* points in this frame (>= 1) */
+        uint8_t flags;    /* TRK_FLAG_* */
+        uint8_t width;    /* stroke width in layer pixels, 0 -> 3 */
+        uint16_t color;   /* RGB565, plain (not byte-swapped) order */
+        int16_t x0;       /* first point, viewport units */
+        int16_t y0;
+    } trk_hdr_t;
+
+    /* Validate the payload. Fills *hdr (width resolved) and returns false on garbage. */
+    bool trk_parse(const uint8_t *payload, size_t len, trk_hdr_t *hdr);
+
+    /* Walks the points of a parsed payload in viewport units (may lie outside the viewport). */
+    typedef struct
+    {
+        const uint8_t *p;
+        int32_t x, y;
+        uint16_t left;
+        bool started;
+    } trk_iter_t;
+
+    void trk_iter_init(trk_iter_t *it, const trk_hdr_t *hdr, const uint8_t *payload);
+    bool trk_iter_next(trk_iter_t *it, int32_t *x, int32_t *y);
+
+    typedef struct
+    {
+        int16_t x1, y1, x2, y2; /* inclusive; x1 > x2 when nothing was touched */
+    } trk_area_t;
+
+    /* Draw one anti-aliased segment (1/16 px endpoints, stroke width in px) into a w x h A8
+       buffer, keeping the maximum coverage per pixel, and grow *dirty by what it touched. */
+    void trk_draw_segment(uint8_t *a8, int w, int h, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                          int width, trk_area_t *dirty);
+
+#ifdef __cplusplus
+}
+#endif
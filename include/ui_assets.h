@@ -0,0 +1,33 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 静态图片资源驻留：SquareLine 导出的图片是 flash 里的 C 数组，每次绘制都经 XIP 读 flash，
+   和 PSRAM 上的帧缓冲、地图争同一条 cache。这里在启动时给仍然实时绘制的静态图片
+   （静态层没烘进底图的那些）定下固定位置，之后不再移动、不再解码：
+
+   - 放得下内部 RAM 预算的，拷进内部 RAM（最快，不走 cache）；
+   - 需要解码的格式（INDEXED_*，见 asset_pipeline.py 的 OVERRIDES）一次展开成 TRUE_COLOR_ALPHA，
+     内部 RAM 放不下就放 PSRAM，之后按原始位图直接绘制，不再逐行解码；
+   - 其余留在 flash：本板 PSRAM 也是 QSPI，读起来不比 flash 快，不值得占 2MB 里的空间。
+
+   驻留后的图片都是内置原始格式，LVGL 图片缓存里只是一个指针；地图换图只作废自己那一项
+   （lv_img_cache_invalidate_src(&s_map_dsc)），不会把这些图片挤出去重新打开。 */
+
+struct _lv_obj_t;
+
+/* 在 LVGL 线程中、静态层烘焙之后调用一次。assets 是要管理的 lv_img_dsc_t（与 lv_img_set_src
+   一样按 void 指针传），screen 下用到它们且可见的 lv_img 改指向驻留副本；被烘焙（隐藏）的不处理 */
+void ui_assets_pin(struct _lv_obj_t *screen, const void *const *assets, size_t n);
+
+/* 驻留副本占用的字节数 */
+size_t ui_assets_internal_bytes(void);
+size_t ui_assets_psram_bytes(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -9,18 +10,115 @@ extern "C" {
 /* 初始化桥接 */
 void ui_bridge_init(void);
 
-/* 来自 MSGF：整包状态快照 */
+/* 首帧上屏之后由 LVGL 线程调用一次：耗时、但不影响画面内容的初始化（静态层烘焙） */
+void ui_bridge_init_late(void);
+
+/* 注册“有新 UI 工作”回调：快照/地图入队或解码完成时调用（任意线程），
+   用于唤醒 LVGL 线程，让它不必固定周期轮询 */
+void ui_bridge_set_notify(void (*fn)(void *user), void *user);
+
+/* 启动图片解码线程（在 ui_bridge_init 之后调用）：PNG/R565 在该线程解码到新位图，
+   LVGL 线程只负责切换；core<0 不绑核。不调用或失败时仍在 LVGL 线程解码。 */
+bool ui_bridge_start_decoder(int core, unsigned priority, uint32_t stack);
+
+/* 来自 MSGF：整包状态快照（同时成为后续增量快照的基准） */
 void ui_request_msg(const uint8_t *data, size_t len, uint32_t seq);
 
+/* 来自 MSGF CMD=0x05：增量快照 = u32 基准整包 seq + u16 字段掩码 + 变化字段（按快照顺序）。
+   基准 seq 与最近一次整包不符或格式错误时丢弃并返回 false，等待下一个整包。 */
+bool ui_request_msg_delta(const uint8_t *data, size_t len, uint32_t seq);
+
 /* 来自 IMGF：带token和释放回调的PNG设置 */
 void ui_request_set_png(const uint8_t *png,
                        size_t len,
                        int imgf_token,
                        void (*release_cb)(int token));
 
-/* 仅 LVGL 线程调用 */
+/* 来自 IMGF_TYPE_R565：主机预转换的 RGB565 位图（可 RLE/LZ4 压缩），与 PNG 共用“只取最新”队列 */
+void ui_request_set_r565(const uint8_t *data,
+                         size_t len,
+                         int imgf_token,
+                         void (*release_cb)(int token));
+
+/* 来自 IMGF_TYPE_R565_RECT：对当前地图位图的局部修补，仅重绘该区域。
+   按序生效，返回 false 表示队列已满，调用方稍后重试（token 仍归调用方）。 */
+bool ui_request_map_rect(const uint8_t *data,
+                         size_t len,
+                         int imgf_token,
+                         void (*release_cb)(int token));
+
+/* 来自 IMGF_TYPE_TRACK：矢量轨迹折线（见 track_vec.h），画在地图之上的轨迹层。
+   按序生效，返回 false 表示队列已满，调用方稍后重试（token 仍归调用方）。 */
+bool ui_request_track(const uint8_t *data,
+                      size_t len,
+                      int imgf_token,
+                      void (*release_cb)(int token));
+
+/* 来自 IMGF_TYPE_TILE_MAP：按布局从瓦片缓存（见 tile_cache.h）拼出整张地图，同时保存布局供下次启动。
+   缺的瓦片经 ui_bridge_set_tile_miss 报告。按序生效，返回 false 表示队列已满（token 仍归调用方）。 */
+bool ui_request_tile_map(const uint8_t *data,
+                         size_t len,
+                         int imgf_token,
+                         void (*release_cb)(int token));
+
+/* 来自 IMGF_TYPE_TILE：写入瓦片缓存，当前布局引用它时补到地图上。按序生效，返回值同上。 */
+bool ui_request_tile(const uint8_t *data,
+                     size_t len,
+                     int imgf_token,
+                     void (*release_cb)(int token));
+
+/* 来自 IMGF_TYPE_TILE_VIEW：平移瓦片视口（见 tile_view.h），移入视口的瓦片从缓存加载，缺的同样报告。
+   按序生效，返回值同上。 */
+bool ui_request_tile_view(const uint8_t *data,
+                          size_t len,
+                          int imgf_token,
+                          void (*release_cb)(int token));
+
+/* 注册瓦片缺失回调：keys 为 n 个 tile_key_wire_t（len 字节），在解码线程调用 */
+void ui_bridge_set_tile_miss(void (*fn)(const void *keys, size_t len, void *user), void *user);
+
+/* 启动时调用（ui_bridge_init 之后）：优先恢复断电前保存的地图位图（hud_persist），
+   其次按上次保存的瓦片布局从缓存拼地图，都没有时返回 false */
+bool ui_bridge_restore_map(void);
+
+/* 启动时调用：显示重启前最后一帧快照（RTC 内存或 NVS），没有时返回 false */
+bool ui_bridge_restore_snapshot(void);
+
+/* 最近一帧快照里的车速（km/h），还没收到快照时返回 false。任意线程 */
+bool ui_bridge_last_speed(int16_t *speed);
+
+/* 省电：暂停地图解码与切换（快照照常）。暂停期间新到的整帧只留最新一张，
+   恢复后立即生效；局部修补可能因基准对不上被丢掉，等主机下一个整帧 */
+void ui_bridge_set_map_paused(bool paused);
+
+/* 把屏上的地图位图写入 "lastmap" 分区（R565 载荷）。自上次保存以来没变过、是瓦片视口
+   或不可保存时直接返回 false。擦写 flash 要几秒，只在低优先级线程里调用；
+   几个线程同时调用时依次进行，后进来的看到已保存过同一张就直接返回 false */
+bool ui_bridge_save_map(void);
+
+/* 来自 IMGF 分片（IMGF_TYPE_PNG_FRAG）：按序流式解码，最后一片完成后切换地图。
+   返回 false 表示队列已满，调用方保留该分片稍后重试（token 仍归调用方）。 */
+bool ui_request_png_frag(const uint8_t *data,
+                         size_t len,
+                         uint16_t frag,
+                         uint8_t flags,
+                         int imgf_token,
+                         void (*release_cb)(int token));
+
+/* 仅 LVGL 线程调用：应用快照，以及已解码好的地图切换 */
 void ui_bridge_apply_pending(void);
 
+/* 地图区域（ui_Group_Map）的像素尺寸：主机按它出图，整张地图不用缩放、也不浪费带宽 */
+void ui_bridge_map_size(uint16_t *w, uint16_t *h);
+
+/* 图片队列统计（任意线程读取，计数自启动累计） */
+typedef struct {
+    uint32_t img_replaced;   // 整帧在显示前被更新的一帧取代（含队列满丢弃）
+    uint32_t img_pending;    // 当前图片队列中的事件数
+} ui_bridge_stats_t;
+
+void ui_bridge_get_stats(ui_bridge_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
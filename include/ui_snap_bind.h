@@ -0,0 +1,226 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* ---------- MSGF 快照字段 -> 控件的编译期绑定表（C++11，ui_bridge.cpp 用） ----------
+
+   snap_bind::layout<field...> 描述线上布局：每个字段 = 偏移 + 类型 + 落到快照结构的哪个成员。
+     decode()   逐字段定长小端读取，编译期展开，没有循环、偏移表和按类型分支
+     offsets[]  各字段偏移（末尾是总长），增量快照按掩码拼字段用
+   编译期检查字段首尾相接、按线上顺序排列。
+
+   snap_bind::bindings<text<...>...> 描述显示：字段 + 换算（除数）+ 格式化函数 + 目标控件 + 限速。
+     apply(s, now_ms, first)  逐绑定把字段与上次显示时的原始值比较，没变的连换算/格式化都跳过；
+                              格式化结果与当前文本相同也不写控件（避免整块失效重绘）
+   每个绑定自带常驻文本缓冲，写控件用 static 文本（LVGL 不再 malloc 拷贝）。
+   rate<MinMs, Hyst> 给变化慢的字段限速：距上次重绘不足 MinMs 不画，原始值与显示值相差不足 Hyst
+   也不画（边界上来回抖的值不闪）；被压下的变化留到后续快照再画。首帧（first）总是画。
+
+   新增遥测字段（水温、档位、胎压……）= 快照结构加一个成员 + 布局表加一行 + 绑定表加一行，
+   运行时没有额外的分派。 */
+
+namespace snap_bind {
+
+enum wire_type { W_U8, W_I16, W_U16, W_I32 };
+
+template <wire_type T> struct wire;
+
+template <> struct wire<W_U8> {
+    typedef uint8_t type;
+    static const unsigned bytes = 1;
+    static type load(const uint8_t *p) { return p[0]; }
+};
+
+template <> struct wire<W_I16> {
+    typedef int16_t type;
+    static const unsigned bytes = 2;
+    static type load(const uint8_t *p) { return (int16_t)(p[0] | (p[1] << 8)); }
+};
+
+template <> struct wire<W_U16> {
+    typedef uint16_t type;
+    static const unsigned bytes = 2;
+    static type load(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+};
+
+template <> struct wire<W_I32> {
+    typedef int32_t type;
+    static const unsigned bytes = 4;
+    static type load(const uint8_t *p)
+    {
+        return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+    }
+};
+
+// 线上 [Off, Off + 宽度) 的小端字段，解到快照结构 S 的成员 M
+template <typename S, unsigned Off, wire_type T, typename wire<T>::type S::*M>
+struct field {
+    typedef S snap_type;
+    static const unsigned offset = Off;
+    static const unsigned end = Off + wire<T>::bytes;
+
+    static void decode(S &s, const uint8_t *d) { s.*M = wire<T>::load(d + Off); }
+    static int32_t value(const S &s) { return (int32_t)(s.*M); }
+};
+
+/* ---- 线上布局 ---- */
+
+template <typename... F> struct layout_rec;
+
+template <> struct layout_rec<> {
+    static const unsigned count = 0;
+    static const unsigned first = ~0u;   // 没有后继字段
+    static const unsigned bytes = 0;
+    template <typename S> static void decode(S &, const uint8_t *) {}
+};
+
+template <typename F, typename... R> struct layout_rec<F, R...> {
+    static_assert(layout_rec<R...>::first == ~0u || layout_rec<R...>::first == F::end,
+                  "snapshot fields must be contiguous and in wire order");
+    static const unsigned count = 1 + layout_rec<R...>::count;
+    static const unsigned first = F::offset;
+    static const unsigned bytes = layout_rec<R...>::bytes > F::end ? layout_rec<R...>::bytes : F::end;
+
+    template <typename S> static void decode(S &s, const uint8_t *d)
+    {
+        F::decode(s, d);
+        layout_rec<R...>::decode(s, d);
+    }
+};
+
+template <typename... F> struct layout : layout_rec<F...> {
+    static_assert(layout_rec<F...>::first == 0, "snapshot layout must start at offset 0");
+    // 各字段偏移，字段 i 的宽度 = offsets[i + 1] - offsets[i]
+    static const uint8_t offsets[sizeof...(F) + 1];
+};
+
+template <typename... F>
+const uint8_t layout<F...>::offsets[sizeof...(F) + 1] = { F::offset..., layout_rec<F...>::bytes };
+
+/* ---- 换算 ---- */
+
+// v / Div；Nearest 时四舍五入（远离 0），否则向 0 截断
+template <int32_t Div, bool Nearest = true> struct scale {
+    static_assert(Div > 0, "divisor must be positive");
+    static int32_t apply(int32_t v)
+    {
+        if (Div == 1) return v;
+        if (!Nearest) return v / Div;
+        return v >= 0 ? (v + Div / 2) / Div : -((-v + Div / 2) / Div);
+    }
+};
+
+/* ---- 限速 ---- */
+
+// 最短重绘间隔 MinMs（ms，0 = 不限）与迟滞 Hyst（原始单位，0 = 任何变化）
+template <uint32_t MinMs = 0, int32_t Hyst = 0> struct rate {
+    static bool due(uint32_t now_ms, uint32_t last_ms) { return MinMs == 0 || now_ms - last_ms >= MinMs; }
+    static bool moved(int32_t v, int32_t shown)
+    {
+        const int32_t d = v >= shown ? v - shown : shown - v;
+        return Hyst > 0 ? d >= Hyst : d != 0;
+    }
+};
+
+/* ---- 显示绑定 ---- */
+
+static const size_t TEXT_MAX = 16;
+
+// 格式化函数：把换算后的值写成以 0 结尾的文本（不超过 TEXT_MAX - 1 个字符）
+typedef void (*fmt1_fn)(char *buf, int32_t v);
+typedef void (*fmt2_fn)(char *buf, int32_t a, int32_t b);
+
+// 文本写进常驻缓冲，与当前显示不同才交给 Set 写到 *Target
+template <typename O, O **Target, void (*Set)(O *, const char *)>
+struct text_sink {
+    static char text[TEXT_MAX];
+    static bool valid;
+
+    static void put(const char *buf)
+    {
+        if (valid && strcmp(text, buf) == 0) return;
+        strncpy(text, buf, TEXT_MAX - 1);
+        text[TEXT_MAX - 1] = '\0';
+        valid = true;
+        if (*Target) Set(*Target, text);
+    }
+};
+
+template <typename O, O **Target, void (*Set)(O *, const char *)>
+char text_sink<O, Target, Set>::text[TEXT_MAX];
+
+template <typename O, O **Target, void (*Set)(O *, const char *)>
+bool text_sink<O, Target, Set>::valid = false;
+
+// 单字段文本：Fmt(Sc(字段))
+template <typename F, typename Sc, fmt1_fn Fmt, typename O, O **Target, void (*Set)(O *, const char *),
+          typename Rt = rate<> >
+struct text {
+    typedef typename F::snap_type S;
+    static int32_t shown;      // 上次显示的原始值
+    static uint32_t shown_ms;  // 上次重绘时刻
+
+    static void apply(const S &s, uint32_t now_ms, bool first)
+    {
+        const int32_t v = F::value(s);
+        if (!first && (!Rt::moved(v, shown) || !Rt::due(now_ms, shown_ms))) return;
+        shown = v;
+        shown_ms = now_ms;
+        char buf[TEXT_MAX];
+        Fmt(buf, Sc::apply(v));
+        text_sink<O, Target, Set>::put(buf);
+    }
+};
+
+template <typename F, typename Sc, fmt1_fn Fmt, typename O, O **Target, void (*Set)(O *, const char *), typename Rt>
+int32_t text<F, Sc, Fmt, O, Target, Set, Rt>::shown;
+
+template <typename F, typename Sc, fmt1_fn Fmt, typename O, O **Target, void (*Set)(O *, const char *), typename Rt>
+uint32_t text<F, Sc, Fmt, O, Target, Set, Rt>::shown_ms;
+
+// 双字段文本（如 余量/总量）：Fmt(Sc(A), Sc(B))，任一字段越过迟滞即重绘
+template <typename A, typename B, typename Sc, fmt2_fn Fmt, typename O, O **Target, void (*Set)(O *, const char *),
+          typename Rt = rate<> >
+struct text2 {
+    typedef typename A::snap_type S;
+    static int32_t shown_a, shown_b;
+    static uint32_t shown_ms;
+
+    static void apply(const S &s, uint32_t now_ms, bool first)
+    {
+        const int32_t a = A::value(s), b = B::value(s);
+        if (!first && ((!Rt::moved(a, shown_a) && !Rt::moved(b, shown_b)) || !Rt::due(now_ms, shown_ms))) return;
+        shown_a = a;
+        shown_b = b;
+        shown_ms = now_ms;
+        char buf[TEXT_MAX];
+        Fmt(buf, Sc::apply(a), Sc::apply(b));
+        text_sink<O, Target, Set>::put(buf);
+    }
+};
+
+template <typename A, typename B, typename Sc, fmt2_fn Fmt, typename O, O **Target, void (*Set)(O *, const char *), typename Rt>
+int32_t text2<A, B, Sc, Fmt, O, Target, Set, Rt>::shown_a;
+
+template <typename A, typename B, typename Sc, fmt2_fn Fmt, typename O, O **Target, void (*Set)(O *, const char *), typename Rt>
+int32_t text2<A, B, Sc, Fmt, O, Target, Set, Rt>::shown_b;
+
+template <typename A, typename B, typename Sc, fmt2_fn Fmt, typename O, O **Target, void (*Set)(O *, const char *), typename Rt>
+uint32_t text2<A, B, Sc, Fmt, O, Target, Set, Rt>::shown_ms;
+
+template <typename... B> struct bindings;
+
+template <> struct bindings<> {
+    template <typename S> static void apply(const S &, uint32_t, bool) {}
+};
+
+template <typename B, typename... R> struct bindings<B, R...> {
+    template <typename S> static void apply(const S &s, uint32_t now_ms, bool first)
+    {
+        B::apply(s, now_ms, first);
+        bindings<R...>::apply(s, now_ms, first);
+    }
+};
+
+} // namespace snap_bind
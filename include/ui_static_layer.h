@@ -0,0 +1,31 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 静态背景层：把屏幕上永不变化、且叠放在所有动态控件之下的对象（背景图、面板、
+   固定文字、刻度等）一次性渲染成一张不透明 RGB565 快照（PSRAM），作为屏幕最底层的
+   图片；原对象随后隐藏。之后每帧脏区只需拷一块背景，再画动态控件。
+
+   判断规则（按绘制顺序遍历）：
+   - 标记为动态的对象及其子树保持实时绘制；
+   - 静态对象只要与先前任何实时对象的区域相交，也保持实时（保证叠放顺序不变）；
+   - 有布局（flex/grid）且子树含动态对象的容器，其子对象全部实时（子尺寸变化会挪动兄弟）。 */
+
+struct _lv_obj_t;
+
+/* 标记会被运行时修改的对象（文字、图源、位置等），须在 build 之前调用 */
+void ui_static_layer_mark_dynamic(struct _lv_obj_t *obj);
+
+/* 在 LVGL 线程中、初始布局完成后调用一次。失败（内存不足、无法安全拆分）时界面保持原样 */
+bool ui_static_layer_build(struct _lv_obj_t *screen);
+
+/* 快照占用的字节数（未启用时为 0） */
+size_t ui_static_layer_bytes(void);
+
+#ifdef __cplusplus
+}
+#endif
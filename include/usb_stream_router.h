@@ -14,6 +14,17 @@ extern "C"
         void *ctx;
         int (*available)(void *ctx);
         int (*read)(void *ctx, uint8_t *dst, int max_len);
+        /* Optional: read straight into receiver-owned memory (may be PSRAM). When set, the
+           router uses it for the remainder of a payload instead of staging through its
+           internal chunk buffer. NULL -> always copy via read(). */
+        int (*read_into)(void *ctx, uint8_t *dst, int max_len);
+        /* Optional: event-driven wakeup. Called once after the RX task starts; the transport
+           must call notify(arg) (task context) whenever new RX data may be available. The router
+           then blocks on a task notification instead of polling every tick. NULL -> polling. */
+        void (*set_rx_notify)(void *ctx, void (*notify)(void *arg), void *arg);
+        /* Optional: device -> host direction, used by usb_sr_send(). Returns bytes written
+           (may be short), <= 0 on error. NULL -> the link stays RX only. */
+        int (*write)(void *ctx, const uint8_t *src, int len);
     } usb_sr_transport_t;
 
     /* -------- Frame header -------- */
@@ -28,6 +39,47 @@ extern "C"
         uint32_t seq;
     } usb_sr_hdr_t;
 
+    /* -------- Channel multiplexing --------
+       A frame the host does not want to hold the link for (a 128 KB R565 map is tens of ms on
+       CDC) may be sent as a run of MUXF fragments instead, so small frames (MSGF snapshots) fit
+       between them. The fragments of one inner frame ("channel" = hdr.type) are the inner frame's
+       own bytes, 20-byte header included, cut into pieces:
+
+         magic 'MUXF', type = channel (0..USB_SR_MUX_CHANNELS-1), flags = USB_SR_MUX_FIRST/LAST,
+         rsv = fragment index (0..), len = fragment bytes (the first one >= 20), crc32/seq unused
+
+       The router reassembles each channel straight into the buffer the inner frame's receiver
+       acquired, checks the inner crc32 on the last byte and commits it as if it had arrived in
+       one piece; receivers never see MUXF. Any other frame may come between two fragments, but a
+       receiver still has at most one frame open: a frame for a receiver that is busy on a channel
+       ends that channel (USB_SR_DROP_MUX_GAP). A missing or out-of-order fragment, or a new FIRST
+       on the same channel, drops the partial frame the same way; a channel idle for longer than
+       frame_timeout_ms is dropped with USB_SR_DROP_TIMEOUT. */
+#define USB_SR_MAGIC_MUX 0x4658554Du /* 'MUXF' */
+#define USB_SR_MUX_CHANNELS 4
+#define USB_SR_MUX_FRAG_MAX 65536 /* longer fragment headers are treated as corrupt */
+    enum
+    {
+        USB_SR_MUX_FIRST = 0x01,
+        USB_SR_MUX_LAST = 0x02,
+    };
+
+    /* -------- Payload compression --------
+       hdr.flags bits 6..7 belong to the router for every magic (receivers keep the low bits for
+       their own flags, e.g. IMGF_FLAG_FIRST/LAST). With USB_SR_FLAG_LZ4 the payload is
+
+         uint32 raw_len (little endian) + one LZ4 block (no frame header) of exactly raw_len bytes
+
+       and hdr.len / crc32 describe those wire bytes. The router acquires raw_len bytes from the
+       receiver and decompresses into them as the payload streams in, so receivers see the frame
+       the host compressed: codec bits cleared, len = raw_len. raw_len is checked against max_len
+       like an uncompressed len. A compressed frame may also travel inside MUXF; its first fragment
+       must then hold raw_len as well as the inner header. Codec values other than LZ4 (0x40 is kept
+       for heatshrink) and blocks that do not decode to exactly raw_len are dropped with
+       USB_SR_DROP_BAD_CODEC. */
+#define USB_SR_FLAG_CODEC_MASK 0xC0u
+#define USB_SR_FLAG_LZ4 0x80u
+
     /* -------- Receiver interface --------
        Router does NOT own receiver storage. Receiver provides buffer for payload. */
     typedef struct usb_sr_receiver usb_sr_receiver_t;
@@ -43,6 +95,9 @@ extern "C"
         USB_SR_DROP_BAD_LEN = 2,
         USB_SR_DROP_BAD_CRC = 3,
         USB_SR_DROP_NO_BUFFER = 4,
+        USB_SR_DROP_TIMEOUT = 5, /* frame stalled longer than frame_timeout_ms */
+        USB_SR_DROP_MUX_GAP = 6, /* multiplexed frame lost a fragment or was superseded */
+        USB_SR_DROP_BAD_CODEC = 7, /* unknown codec or corrupt compressed payload */
     };
 
     struct usb_sr_receiver
@@ -66,6 +121,7 @@ extern "C"
         int max_receivers;    /* e.g. 4 */
         void (*on_rx_activity)(void *user, size_t bytes);
         void *on_rx_activity_user;
+        int frame_timeout_ms; /* max gap between reads inside one frame, 0 = wait forever */
     } usb_sr_config_t;
 
     typedef struct usb_stream_router usb_stream_router_t;
@@ -83,13 +139,25 @@ extern "C"
     /* Optional: set default handler for unknown magic (can be NULL -> drop silently). */
     void usb_sr_set_default(usb_stream_router_t *r, const usb_sr_receiver_t *rcv);
 
+    /* Send one frame to the host with the same 20-byte header (crc32 always filled, seq is the
+       router's own TX counter). Thread-safe; blocks until written. False if the transport has
+       no write op or the write failed. */
+    bool usb_sr_send(usb_stream_router_t *r, uint32_t magic, uint8_t type, uint8_t flags,
+                     const void *payload, size_t len);
+
     /* Stats */
     typedef struct
     {
         uint64_t bytes_rx;
         uint32_t frames_ok;
         uint32_t frames_dropped;
-        uint32_t resync_count;
+        uint32_t resync_count;  /* hunts that had to skip garbage before a magic */
+        uint64_t bytes_skipped; /* garbage bytes discarded while hunting for a magic */
+        uint32_t frames_timeout; /* frames abandoned by frame_timeout_ms (also in frames_dropped) */
+        uint32_t mux_fragments;  /* MUXF fragments received */
+        uint32_t mux_frames;     /* frames reassembled from MUXF fragments (also in frames_ok) */
+        uint32_t lz4_frames;     /* compressed frames delivered (also in frames_ok) */
+        uint64_t lz4_bytes_out;  /* decompressed bytes handed to receivers by those frames */
     } usb_sr_stats_t;
 
     void usb_sr_get_stats(usb_stream_router_t *r, usb_sr_stats_t *out);
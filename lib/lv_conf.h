@@ -63,10 +63,18 @@
     #endif
 
 #else       /*LV_MEM_CUSTOM*/
+#if HUD_LV_MEM_INTERNAL || HUD_LV_MEM_ARENA
+    /*Performance profile: small blocks from internal RAM (or a private arena), large ones from PSRAM (see hud_lv_mem.h)*/
+    #define LV_MEM_CUSTOM_INCLUDE "hud_lv_mem.h"
+    #define LV_MEM_CUSTOM_ALLOC   hud_lv_malloc
+    #define LV_MEM_CUSTOM_FREE    hud_lv_free
+    #define LV_MEM_CUSTOM_REALLOC hud_lv_realloc
+#else
     #define LV_MEM_CUSTOM_INCLUDE <stdlib.h>   /*Header for the dynamic memory function*/
     #define LV_MEM_CUSTOM_ALLOC   malloc
     #define LV_MEM_CUSTOM_FREE    free
     #define LV_MEM_CUSTOM_REALLOC realloc
+#endif
 #endif     /*LV_MEM_CUSTOM*/
 
 /*Number of the intermediate memory buffer used during rendering and other internal processing mechanisms.
@@ -144,7 +152,7 @@
  *With complex image decoders (e.g. PNG or JPG) caching can save the continuous open/decode of images.
  *However the opened images might consume additional RAM.
  *0: to disable caching*/
-#define LV_IMG_CACHE_DEF_SIZE 1
+#define LV_IMG_CACHE_DEF_SIZE 8   /* 底图、驻留图片（ui_assets.h）、地图各占一项；换地图只作废地图那项 */
 
 /*Number of stops allowed per gradient. Increase this to allow more stops.
  *This adds (sizeof(lv_color_t) + 1) bytes per additional stop*/
@@ -335,7 +343,13 @@
 #define LV_ATTRIBUTE_LARGE_RAM_ARRAY
 
 /*Place performance critical functions into a faster memory (e.g RAM)*/
-#define LV_ATTRIBUTE_FAST_MEM
+#if HUD_LV_FAST_MEM && defined(__has_include) && __has_include("esp_attr.h")
+    /*Performance profile: blend/fill/mask kernels and lv_memcpy run from IRAM, no flash cache misses*/
+    #include "esp_attr.h"
+    #define LV_ATTRIBUTE_FAST_MEM IRAM_ATTR
+#else
+    #define LV_ATTRIBUTE_FAST_MEM
+#endif
 
 /*Prefix variables that are used in GPU accelerated operations, often these need to be placed in RAM sections that are DMA accessible*/
 #define LV_ATTRIBUTE_DMA
@@ -680,7 +694,7 @@
  *----------*/
 
 /*1: Enable API to take snapshot for object*/
-#define LV_USE_SNAPSHOT 0
+#define LV_USE_SNAPSHOT 1     /* ui_static_layer 用来渲染静态背景 */
 
 /*1: Enable Monkey test*/
 #define LV_USE_MONKEY 0
@@ -0,0 +1,116 @@
+package cn.crazythursdayvivo50.esp_hud;
+
+/**
+ * 基于下位机 {@code CRED} 帧的发送额度。
+ * <p>
+ * 下位机上报空闲缓冲数（IMGF 槽位 / MSGF 队列）以及开机以来见过的帧数；
+ * 主机已发出但下位机尚未见到的帧视为在途，可用额度 = 空闲数 - 在途数。
+ * 收到第一帧 {@code CRED} 之前、或上报中断超过 {@link #STALE_MS} 后不做限制（兼容旧固件/只写通道）。
+ * <p>
+ * 头部损坏、超长或在链路上丢失的帧下位机永远“见不到”，在途数会一直偏大。已见数停住
+ * {@link #SETTLE_MS} 以上、且下位机缓冲全空时，停住之前发出还没被见到的帧按丢失记账，额度自行恢复。
+ */
+final class CreditGate {
+    static final int WIRE_VERSION = 1;
+    static final int WIRE_BYTES = 16;
+    static final long STALE_MS = 3000;
+    /** 帧从写出到被下位机见到的时间远小于此值，见不到就是丢了 */
+    static final long SETTLE_MS = 1000;
+
+    private final Channel img = new Channel();
+    private final Channel msg = new Channel();
+    private long lastReportMs;
+    private boolean active;
+
+    private static final class Channel {
+        long sent;      // 本端累计发出
+        long base;      // sent 与下位机计数的对齐偏移（首帧、下位机重启时重置，核销丢帧时增加）
+        long seen = -1; // 下位机最近一次上报的累计已见数
+        int free;
+        int freeMax;    // 缓冲总数（IMGF 由上报给出，MSGF 取见过的最大空闲数）
+        long markSent;  // seen 上次变化时的 sent
+        long markMs;
+
+        void report(int freeNow, int capacity, long seenNow, long nowMs) {
+            if (seen < 0 || seenNow < seen) {
+                base = sent - seenNow;   // 无法得知在途数，按 0 对齐
+            }
+            freeMax = Math.max(capacity, Math.max(freeMax, freeNow));
+            if (seenNow != seen) {
+                markSent = sent;
+                markMs = nowMs;
+            } else if (nowMs - markMs >= SETTLE_MS && freeNow >= freeMax) {
+                // 停住之前发出的帧早该被见到：没见到的是丢了，不再占额度
+                long lost = markSent - base - seenNow;
+                if (lost > 0) {
+                    base += lost;
+                }
+                markSent = sent;
+                markMs = nowMs;
+            }
+            seen = seenNow;
+            free = freeNow;
+        }
+
+        int available() {
+            long inFlight = Math.max(0, sent - base - seen);
+            return (int) Math.max(0, free - inFlight);
+        }
+    }
+
+    /**
+     * 解析并应用一帧 CRED 载荷；格式不符时忽略。
+     */
+    synchronized boolean onReport(byte[] p, long nowMs) {
+        if (p == null || p.length < WIRE_BYTES || (p[0] & 0xFF) != WIRE_VERSION) {
+            return false;
+        }
+        img.report(p[1] & 0xFF, p[2] & 0xFF, FrameDecoder.getInt32LE(p, 4) & 0xFFFFFFFFL, nowMs);
+        msg.report(p[3] & 0xFF, 0, FrameDecoder.getInt32LE(p, 8) & 0xFFFFFFFFL, nowMs);
+        lastReportMs = nowMs;
+        active = true;
+        return true;
+    }
+
+    private boolean enforcing(long nowMs) {
+        return active && nowMs - lastReportMs <= STALE_MS;
+    }
+
+    /** 占用一个 IMGF 额度；无额度返回 {@code false}。 */
+    synchronized boolean tryTakeImg(long nowMs) {
+        if (enforcing(nowMs) && img.available() <= 0) {
+            return false;
+        }
+        img.sent++;
+        return true;
+    }
+
+    /** 占用一个 MSGF 额度；无额度返回 {@code false}。 */
+    synchronized boolean tryTakeMsg(long nowMs) {
+        if (enforcing(nowMs) && msg.available() <= 0) {
+            return false;
+        }
+        msg.sent++;
+        return true;
+    }
+
+    /** 记录一帧不受额度限制的 MSGF（控制命令），保持在途计数准确。 */
+    synchronized void forceMsg() {
+        msg.sent++;
+    }
+
+    /** 当前 IMGF 可用额度；未启用时返回 -1。 */
+    synchronized int imgCredits(long nowMs) {
+        return enforcing(nowMs) ? img.available() : -1;
+    }
+
+    synchronized void reset() {
+        img.sent = img.base = img.markSent = 0;
+        img.seen = -1;
+        img.freeMax = 0;
+        msg.sent = msg.base = msg.markSent = 0;
+        msg.seen = -1;
+        msg.freeMax = 0;
+        active = false;
+    }
+}
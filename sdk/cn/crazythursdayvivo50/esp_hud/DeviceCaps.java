@@ -0,0 +1,126 @@
+package cn.crazythursdayvivo50.esp_hud;
+
+/**
+ * 下位机能力（{@code HELO} 帧，SDK 启动时与检测到下位机重启后用 MSGF CMD=0x09 查询）。
+ * <p>
+ * 掩码字段的第 n 位对应帧类型 / 编码 / 命令 n。握手之前的旧固件不回该帧，此时
+ * {@link HudHostSdk#getDeviceCaps()} 为 {@code null}，SDK 按配置原样发送。
+ */
+public final class DeviceCaps {
+    static final int WIRE_VERSION = 1;
+    static final int WIRE_BYTES = 32;
+
+    static final int F_MUXF = 0x01;
+    static final int F_CRC_REQUIRED = 0x02;
+    static final int F_SWAP565 = 0x04;
+    static final int F_TILE_CACHE = 0x08;
+    static final int F_STAT = 0x10;
+    static final int F_CRED = 0x20;
+    static final int CODEC_LZ4 = 0x01;
+
+    /** R565 编码：不压缩。 */
+    public static final int R565_CODEC_RAW = 0;
+    /** R565 编码：RLE。 */
+    public static final int R565_CODEC_RLE = 1;
+    /** R565 编码：LZ4。 */
+    public static final int R565_CODEC_LZ4 = 2;
+    /** R565 编码：QOI。 */
+    public static final int R565_CODEC_QOI = 3;
+
+    /** 板型编号（固件 {@code panelLan_board_t}）。 */
+    public final int boardId;
+    /** 协议修订号，固件每增加帧类型 / 命令 / 编码时递增。 */
+    public final int protoRev;
+    /** 屏幕宽度（旋转后，像素）。 */
+    public final int screenWidth;
+    /** 屏幕高度（旋转后，像素）。 */
+    public final int screenHeight;
+    /** 地图区域宽度：整张地图按此尺寸出图。 */
+    public final int mapWidth;
+    /** 地图区域高度。 */
+    public final int mapHeight;
+    /** 支持的 IMGF 帧类型掩码。 */
+    public final int imgfTypes;
+    /** 支持的 R565 编码掩码。 */
+    public final int r565Codecs;
+    /** 支持的帧载荷压缩掩码（bit0 = LZ4）。 */
+    public final int frameCodecs;
+    /** 特性位。 */
+    public final int features;
+    /** 支持的 MSGF 命令掩码。 */
+    public final long msgfCmds;
+    /** 单个 IMGF 载荷上限（解压后，字节）。 */
+    public final int imgMaxBytes;
+    /** 单个 MSGF 载荷上限（字节）。 */
+    public final int msgMaxBytes;
+    /** IMGF 缓冲数。 */
+    public final int imgSlots;
+    /** MSGF 队列深度。 */
+    public final int msgQueue;
+    /** 可同时复用的 MUXF 通道数。 */
+    public final int muxChannels;
+
+    private DeviceCaps(byte[] p) {
+        this.boardId = p[1] & 0xFF;
+        this.protoRev = FrameDecoder.getUInt16LE(p, 2);
+        this.screenWidth = FrameDecoder.getUInt16LE(p, 4);
+        this.screenHeight = FrameDecoder.getUInt16LE(p, 6);
+        this.mapWidth = FrameDecoder.getUInt16LE(p, 8);
+        this.mapHeight = FrameDecoder.getUInt16LE(p, 10);
+        this.imgfTypes = p[12] & 0xFF;
+        this.r565Codecs = p[13] & 0xFF;
+        this.frameCodecs = p[14] & 0xFF;
+        this.features = p[15] & 0xFF;
+        this.msgfCmds = FrameDecoder.getInt32LE(p, 16) & 0xFFFFFFFFL;
+        this.imgMaxBytes = FrameDecoder.getInt32LE(p, 20);
+        this.msgMaxBytes = FrameDecoder.getUInt16LE(p, 24);
+        this.imgSlots = p[26] & 0xFF;
+        this.msgQueue = p[27] & 0xFF;
+        this.muxChannels = p[28] & 0xFF;
+    }
+
+    /**
+     * 解析 HELO 帧载荷；版本不符或长度不足时返回 {@code null}。
+     */
+    static DeviceCaps parse(byte[] payload) {
+        if (payload == null || payload.length < WIRE_BYTES || (payload[0] & 0xFF) != WIRE_VERSION) {
+            return null;
+        }
+        return new DeviceCaps(payload);
+    }
+
+    /** 是否处理 IMGF 帧类型 {@code type}（0..7）。 */
+    public boolean supportsImgType(int type) {
+        return type >= 0 && type < 8 && (imgfTypes >> type & 1) != 0;
+    }
+
+    /** 是否能解码 R565 编码 {@code codec}（见 {@code R565_CODEC_*}）。 */
+    public boolean supportsR565Codec(int codec) {
+        return codec >= 0 && codec < 8 && (r565Codecs >> codec & 1) != 0;
+    }
+
+    /** 是否处理 MSGF 命令 {@code cmd}。 */
+    public boolean supportsMsgCmd(int cmd) {
+        return cmd >= 0 && cmd < 32 && (msgfCmds >> cmd & 1) != 0;
+    }
+
+    /** 是否接受 LZ4 压缩的帧载荷（帧头 flags=0x80）。 */
+    public boolean supportsLz4Frames() {
+        return (frameCodecs & CODEC_LZ4) != 0;
+    }
+
+    /** 是否重组 MUXF 复用分片。 */
+    public boolean supportsMux() {
+        return (features & F_MUXF) != 0;
+    }
+
+    /** 下位机是否丢弃不带 CRC32 的帧。 */
+    public boolean requiresCrc32() {
+        return (features & F_CRC_REQUIRED) != 0;
+    }
+
+    /** 下位机是否有 flash 瓦片缓存。 */
+    public boolean hasTileCache() {
+        return (features & F_TILE_CACHE) != 0;
+    }
+}
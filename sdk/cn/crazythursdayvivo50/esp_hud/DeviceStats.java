@@ -0,0 +1,135 @@
+package cn.crazythursdayvivo50.esp_hud;
+
+/**
+ * 下位机周期上报的运行状态（{@code STAT} 帧，默认每秒一帧）。
+ * <p>
+ * 计数类字段均为下位机开机以来的累计值，判断是否丢帧需比较相邻两次上报。
+ * 堆碎片字段由较新的固件追加在 84 字节之后，旧固件上报时为 {@code -1}（趋势为 0），见 {@link #hasHeapFragmentation()}。
+ */
+public final class DeviceStats {
+    static final int WIRE_VERSION = 1;
+    static final int WIRE_BYTES = 84;
+    static final int WIRE_BYTES_HEAPMON = 104;
+
+    /** 上报周期（毫秒）。 */
+    public final int periodMs;
+    /** 下位机运行时间（毫秒）。 */
+    public final long uptimeMs;
+
+    /** USB 累计接收字节（低 32 位）。 */
+    public final long usbBytesRx;
+    /** 路由层成功分发的帧数。 */
+    public final long usbFramesOk;
+    /** 路由层丢弃的帧数（含超时）。 */
+    public final long usbFramesDropped;
+    /** 路由层重新同步次数。 */
+    public final long usbResync;
+    /** 帧内超时被放弃的帧数。 */
+    public final long usbFramesTimeout;
+
+    /** IMGF 成功接收帧数。 */
+    public final long imgfOk;
+    /** IMGF 因无空闲缓冲被丢弃的帧数。 */
+    public final long imgfDrop;
+    /** IMGF 校验失败帧数。 */
+    public final long imgfBad;
+
+    /** MSGF 成功接收帧数。 */
+    public final long msgfOk;
+    /** MSGF 因队列满被丢弃的帧数。 */
+    public final long msgfDrop;
+    /** MSGF 校验失败帧数。 */
+    public final long msgfBad;
+
+    /** 图像在显示前被更新一帧取代的次数。 */
+    public final long uiImgReplaced;
+    /** 上报时刻图像队列中待处理的事件数。 */
+    public final int uiImgPending;
+
+    /** 内部 RAM 空闲字节。 */
+    public final long heapFreeInternal;
+    /** 内部 RAM 开机以来最低空闲字节。 */
+    public final long heapMinInternal;
+    /** PSRAM 空闲字节。 */
+    public final long heapFreePsram;
+
+    /** 地图解码次数。 */
+    public final long decodeCount;
+    /** 地图解码平均耗时（微秒）。 */
+    public final long decodeAvgUs;
+    /** 地图解码 p99 耗时（微秒）。 */
+    public final long decodeP99Us;
+
+    /** PSRAM 开机以来最低空闲字节。 */
+    public final long heapMinPsram;
+    /** 内部 RAM 当前最大空闲块。 */
+    public final long heapLargestInternal;
+    /** PSRAM 当前最大空闲块：地图位图要整块分配，它小于位图大小时解码失败。 */
+    public final long heapLargestPsram;
+    /** 开机以来采样到的 PSRAM 最大空闲块的最小值。 */
+    public final long heapLargestMinPsram;
+    /** PSRAM 最大空闲块的变化趋势（字节/小时，负数为在缩小；下位机按最近约 2 小时拟合）。 */
+    public final long heapPsramTrend;
+
+    private DeviceStats(byte[] p) {
+        this.periodMs = FrameDecoder.getUInt16LE(p, 2);
+        this.uptimeMs = u32(p, 4);
+        this.usbBytesRx = u32(p, 8);
+        this.usbFramesOk = u32(p, 12);
+        this.usbFramesDropped = u32(p, 16);
+        this.usbResync = u32(p, 20);
+        this.usbFramesTimeout = u32(p, 24);
+        this.imgfOk = u32(p, 28);
+        this.imgfDrop = u32(p, 32);
+        this.imgfBad = u32(p, 36);
+        this.msgfOk = u32(p, 40);
+        this.msgfDrop = u32(p, 44);
+        this.msgfBad = u32(p, 48);
+        this.uiImgReplaced = u32(p, 52);
+        this.uiImgPending = FrameDecoder.getUInt16LE(p, 56);
+        this.heapFreeInternal = u32(p, 60);
+        this.heapMinInternal = u32(p, 64);
+        this.heapFreePsram = u32(p, 68);
+        this.decodeCount = u32(p, 72);
+        this.decodeAvgUs = u32(p, 76);
+        this.decodeP99Us = u32(p, 80);
+        boolean heap = p.length >= WIRE_BYTES_HEAPMON;
+        this.heapMinPsram = heap ? u32(p, 84) : -1;
+        this.heapLargestInternal = heap ? u32(p, 88) : -1;
+        this.heapLargestPsram = heap ? u32(p, 92) : -1;
+        this.heapLargestMinPsram = heap ? u32(p, 96) : -1;
+        this.heapPsramTrend = heap ? FrameDecoder.getInt32LE(p, 100) : 0;
+    }
+
+    /**
+     * 解析 STAT 帧载荷；版本不符或长度不足时返回 {@code null}。
+     */
+    static DeviceStats parse(byte[] payload) {
+        if (payload == null || payload.length < WIRE_BYTES || (payload[0] & 0xFF) != WIRE_VERSION) {
+            return null;
+        }
+        return new DeviceStats(payload);
+    }
+
+    /**
+     * 相对上一次上报，设备端是否丢弃或取代过图像。
+     *
+     * @param prev 上一次的上报，可为 {@code null}
+     * @return 有新增图像丢弃时返回 {@code true}
+     */
+    public boolean imageDroppedSince(DeviceStats prev) {
+        if (prev == null || uptimeMs < prev.uptimeMs) {
+            return false;   // 首帧或下位机已重启，没有可比的基准
+        }
+        return imgfDrop != prev.imgfDrop || uiImgReplaced != prev.uiImgReplaced;
+    }
+
+    /** 上报是否带堆碎片字段（{@code heapMinPsram} 起）。 */
+    public boolean hasHeapFragmentation() {
+        return heapLargestPsram >= 0;
+    }
+
+    private static long u32(byte[] p, int off) {
+        return FrameDecoder.getInt32LE(p, off) & 0xFFFFFFFFL;
+    }
+}
@@ -0,0 +1,90 @@
+package cn.crazythursdayvivo50.esp_hud;
+
+import java.util.zip.CRC32;
+
+/**
+ * 下位机回传帧的流式解析器：与上行相同的 20 字节帧头（magic/type/flags/rsv/len/crc32/seq，小端）。
+ * 按任意分块喂入字节，找到完整帧后回调；遇到未知 magic 或 CRC 不符时逐字节重新同步。
+ * 非线程安全，只在接收线程内使用。
+ */
+final class FrameDecoder {
+    static final int MAGIC_STAT = 0x54415453;
+    static final int MAGIC_CRED = 0x44455243;
+    static final int MAGIC_TMIS = 0x53494D54;
+    static final int MAGIC_HELO = 0x4F4C4548;
+    static final int HEADER_BYTES = 20;
+
+    interface Sink {
+        void onFrame(int magic, int type, int flags, int seq, byte[] payload);
+    }
+
+    private final int maxPayload;
+    private final Sink sink;
+    private byte[] buf = new byte[256];
+    private int len;
+
+    FrameDecoder(int maxPayload, Sink sink) {
+        this.maxPayload = maxPayload;
+        this.sink = sink;
+    }
+
+    void feed(byte[] data, int off, int n) {
+        ensure(len + n);
+        System.arraycopy(data, off, buf, len, n);
+        len += n;
+
+        int p = 0;
+        while (len - p >= HEADER_BYTES) {
+            int magic = getInt32LE(buf, p);
+            if (magic != MAGIC_STAT && magic != MAGIC_CRED && magic != MAGIC_TMIS
+                    && magic != MAGIC_HELO) {
+                p++;
+                continue;
+            }
+            int payloadLen = getInt32LE(buf, p + 8);
+            if (payloadLen < 0 || payloadLen > maxPayload) {
+                p++;
+                continue;
+            }
+            if (len - p < HEADER_BYTES + payloadLen) {
+                break;
+            }
+            int crc = getInt32LE(buf, p + 12);
+            if (crc != 0 && crc != crc32(buf, p + HEADER_BYTES, payloadLen)) {
+                p++;
+                continue;
+            }
+            byte[] payload = new byte[payloadLen];
+            System.arraycopy(buf, p + HEADER_BYTES, payload, 0, payloadLen);
+            sink.onFrame(magic, buf[p + 4] & 0xFF, buf[p + 5] & 0xFF, getInt32LE(buf, p + 16), payload);
+            p += HEADER_BYTES + payloadLen;
+        }
+        System.arraycopy(buf, p, buf, 0, len - p);
+        len -= p;
+    }
+
+    private void ensure(int cap) {
+        if (cap > buf.length) {
+            byte[] n = new byte[Math.max(cap, buf.length * 2)];
+            System.arraycopy(buf, 0, n, 0, len);
+            buf = n;
+        }
+    }
+
+    static int getInt32LE(byte[] src, int off) {
+        return (src[off] & 0xFF)
+                | ((src[off + 1] & 0xFF) << 8)
+                | ((src[off + 2] & 0xFF) << 16)
+                | ((src[off + 3] & 0xFF) << 24);
+    }
+
+    static int getUInt16LE(byte[] src, int off) {
+        return (src[off] & 0xFF) | ((src[off + 1] & 0xFF) << 8);
+    }
+
+    private static int crc32(byte[] data, int off, int n) {
+        CRC32 c = new CRC32();
+        c.update(data, off, n);
+        return (int) c.getValue();
+    }
+}
@@ -1,67 +1,577 @@
 package cn.crazythursdayvivo50.esp_hud;
 
+import java.util.Arrays;
+import java.util.List;
 import java.util.zip.CRC32;
 
 final class FrameEncoder {
     static final int MAGIC_MSGF = 0x4647534D;
     static final int MAGIC_IMGF = 0x46474D49;
+    static final int MAGIC_MUXF = 0x4658554D;
+
+    static final int IMGF_TYPE_PNG_FRAG = 1;
+    static final int IMGF_TYPE_R565 = 2;
+    static final int IMGF_TYPE_R565_RECT = 3;
+    static final int IMGF_TYPE_TRACK = 4;
+    static final int IMGF_TYPE_TILE = 5;
+    static final int IMGF_TYPE_TILE_MAP = 6;
+    static final int IMGF_TYPE_TILE_VIEW = 7;
+    static final int IMGF_FLAG_FIRST = 0x01;
+    static final int IMGF_FLAG_LAST = 0x02;
+    static final int MUX_FLAG_FIRST = 0x01;
+    static final int MUX_FLAG_LAST = 0x02;
+    /** 帧头 flags 高位：载荷为 u32 原始长度 + LZ4 块，下位机路由器边收边解压。 */
+    static final int FRAME_FLAG_LZ4 = 0x80;
+    /** 更短的载荷不值得压缩。 */
+    static final int FRAME_LZ4_MIN_BYTES = 256;
+    static final int TRACK_FLAG_RESET = 0x01;
+    /** 下位机一条折线最多的点数（重置之间累计）。 */
+    static final int TRACK_MAX_POINTS = 2048;
 
     private FrameEncoder() {}
 
+    /** 快照各字段在线上的字节宽度（顺序即增量掩码的位序）。 */
+    private static final int[] SNAPSHOT_FIELD_BYTES = { 2, 2, 4, 4, 2, 2, 2, 2, 2, 2, 2 };
+    private static final int HEADER_BYTES = 20;
+    /** 复用池：覆盖到最大的批量帧（下位机 MSGF max_msg_bytes=1024）。 */
+    private static final int POOL_MAX_BYTES = HEADER_BYTES + 1024;
+    private static final int POOL_DEPTH = 8;
+    private static final byte[][][] POOL = new byte[POOL_MAX_BYTES + 1][][];
+    private static final int[] POOL_COUNT = new int[POOL_MAX_BYTES + 1];
+    private static final ThreadLocal<CRC32> CRC = new ThreadLocal<CRC32>() {
+        @Override
+        protected CRC32 initialValue() {
+            return new CRC32();
+        }
+    };
+    static final int SNAPSHOT_BYTES = 26;
+    static final int MSG_CMD_SNAPSHOT_DELTA = 0x05;
+    static final int MSG_CMD_BATCH = 0x06;
+
     static byte[] encodeMsgSnapshot(int seq, VehicleSnapshot snapshot, boolean enableCrc32) {
-        byte[] payload = new byte[1 + 26];
-        int p = 0;
-        payload[p++] = 0x00;
-        p = putInt16LE(payload, p, clampI16(snapshot.speedKmh));
-        p = putInt16LE(payload, p, clampI16(snapshot.engineRpm));
-        p = putInt32LE(payload, p, snapshot.odoMeters);
-        p = putInt32LE(payload, p, snapshot.tripOdoMeters);
-        p = putInt16LE(payload, p, clampI16(snapshot.outsideTempDeciC));
-        p = putInt16LE(payload, p, clampI16(snapshot.insideTempDeciC));
-        p = putInt16LE(payload, p, clampI16(snapshot.batteryMv));
-        p = putUInt16LE(payload, p, clampU16(snapshot.currentTimeMinutes, 0, 1439));
-        p = putUInt16LE(payload, p, clampU16(snapshot.tripTimeMinutes, 0, 0xFFFF));
-        p = putUInt16LE(payload, p, clampU16(snapshot.fuelLeftDeciL, 0, 0xFFFF));
-        putUInt16LE(payload, p, clampU16(snapshot.fuelTotalDeciL, 0, 0xFFFF));
-        return encodeFrame(MAGIC_MSGF, payload, seq, enableCrc32);
+        byte[] out = obtain(HEADER_BYTES + 1 + SNAPSHOT_BYTES);
+        int p = HEADER_BYTES;
+        out[p++] = 0x00;
+        for (int i = 0; i < SNAPSHOT_FIELD_BYTES.length; i++) {
+            p = putField(out, p, i, snapshotField(snapshot, i));
+        }
+        writeHeader(out, 0, MAGIC_MSGF, 0, 0, 0, p - HEADER_BYTES, seq, enableCrc32);
+        return out;
+    }
+
+    /**
+     * 增量快照（CMD=0x05）：u32 基准整包 seq + u16 字段掩码 + 与基准不同的字段（顺序与宽度同整包）。
+     * 总是相对基准整包而不是上一帧，中间的增量帧被丢弃也不影响后续帧；下位机基准 seq 对不上时丢弃。
+     */
+    static byte[] encodeMsgDelta(int seq, int baseSeq, VehicleSnapshot base, VehicleSnapshot snapshot,
+                                 boolean enableCrc32) {
+        int mask = 0;
+        int len = 0;
+        for (int i = 0; i < SNAPSHOT_FIELD_BYTES.length; i++) {
+            if (snapshotField(base, i) != snapshotField(snapshot, i)) {
+                mask |= 1 << i;
+                len += SNAPSHOT_FIELD_BYTES[i];
+            }
+        }
+        byte[] out = obtain(HEADER_BYTES + 1 + 4 + 2 + len);
+        int p = HEADER_BYTES;
+        out[p++] = (byte) MSG_CMD_SNAPSHOT_DELTA;
+        p = putInt32LE(out, p, baseSeq);
+        p = putUInt16LE(out, p, mask);
+        for (int i = 0; i < SNAPSHOT_FIELD_BYTES.length; i++) {
+            if ((mask & (1 << i)) != 0) {
+                p = putField(out, p, i, snapshotField(snapshot, i));
+            }
+        }
+        writeHeader(out, 0, MAGIC_MSGF, 0, 0, 0, p - HEADER_BYTES, seq, enableCrc32);
+        return out;
+    }
+
+    /** 快照第 i 个字段按线上取值范围截断后的值。 */
+    private static int snapshotField(VehicleSnapshot s, int i) {
+        switch (i) {
+            case 0: return clampI16(s.speedKmh);
+            case 1: return clampI16(s.engineRpm);
+            case 2: return s.odoMeters;
+            case 3: return s.tripOdoMeters;
+            case 4: return clampI16(s.outsideTempDeciC);
+            case 5: return clampI16(s.insideTempDeciC);
+            case 6: return clampI16(s.batteryMv);
+            case 7: return clampU16(s.currentTimeMinutes, 0, 1439);
+            case 8: return clampU16(s.tripTimeMinutes, 0, 0xFFFF);
+            case 9: return clampU16(s.fuelLeftDeciL, 0, 0xFFFF);
+            default: return clampU16(s.fuelTotalDeciL, 0, 0xFFFF);
+        }
+    }
+
+    private static int putField(byte[] dst, int off, int field, int value) {
+        return SNAPSHOT_FIELD_BYTES[field] == 4 ? putInt32LE(dst, off, value) : putInt16LE(dst, off, value);
+    }
+
+    /** 批量帧的总字节数（含帧头），见 {@link #writeMsgBatch}。 */
+    static int msgBatchFrameBytes(byte[][] frames, int count) {
+        int len = HEADER_BYTES + 1;
+        for (int i = 0; i < count; i++) {
+            len += 5 + frames[i].length - HEADER_BYTES;
+        }
+        return len;
+    }
+
+    /**
+     * 批量帧（CMD=0x06）：把已编码好的前 count 个 MSGF 帧去掉帧头，按 [u8 len][u32 seq][payload] 依次拼进一帧，
+     * 写到 out 的 off 处（需 {@link #msgBatchFrameBytes} 字节），返回写完后的偏移。
+     * 各条保留原 seq（增量快照的基准与时延统计都按它对齐），帧头 seq 取第一条的。每条 payload 不超过 255 字节。
+     */
+    static int writeMsgBatch(byte[] out, int off, byte[][] frames, int[] seqs, int count, boolean enableCrc32) {
+        int p = off + HEADER_BYTES;
+        out[p++] = (byte) MSG_CMD_BATCH;
+        for (int i = 0; i < count; i++) {
+            int n = frames[i].length - HEADER_BYTES;
+            out[p++] = (byte) n;
+            p = putInt32LE(out, p, seqs[i]);
+            System.arraycopy(frames[i], HEADER_BYTES, out, p, n);
+            p += n;
+        }
+        writeHeader(out, off, MAGIC_MSGF, 0, 0, 0, p - off - HEADER_BYTES, seqs[0], enableCrc32);
+        return p;
     }
 
     static byte[] encodeMsgCommandOnly(int seq, int cmd, boolean enableCrc32) {
-        byte[] payload = new byte[] { (byte) (cmd & 0xFF) };
-        return encodeFrame(MAGIC_MSGF, payload, seq, enableCrc32);
+        byte[] out = obtain(HEADER_BYTES + 1);
+        out[HEADER_BYTES] = (byte) (cmd & 0xFF);
+        writeHeader(out, 0, MAGIC_MSGF, 0, 0, 0, 1, seq, enableCrc32);
+        return out;
     }
 
     static byte[] encodeMsgCommandWithU8Arg(int seq, int cmd, int arg, boolean enableCrc32) {
-        byte[] payload = new byte[] {
-                (byte) (cmd & 0xFF),
-                (byte) (arg & 0xFF)
-        };
-        return encodeFrame(MAGIC_MSGF, payload, seq, enableCrc32);
+        byte[] out = obtain(HEADER_BYTES + 2);
+        out[HEADER_BYTES] = (byte) (cmd & 0xFF);
+        out[HEADER_BYTES + 1] = (byte) (arg & 0xFF);
+        writeHeader(out, 0, MAGIC_MSGF, 0, 0, 0, 2, seq, enableCrc32);
+        return out;
+    }
+
+    /**
+     * 取一个长度正好为 len 的帧数组：MSGF 帧（快照、增量、命令、批量）按帧长分档复用，
+     * 发送线程拷进写缓冲或丢弃后用 {@link #recycle} 归还，高频快照不再产生垃圾。内容未清零，调用方须写满。
+     */
+    static byte[] obtain(int len) {
+        if (len <= POOL_MAX_BYTES) {
+            synchronized (POOL) {
+                int n = POOL_COUNT[len];
+                if (n > 0) {
+                    byte[] b = POOL[len][--n];
+                    POOL[len][n] = null;
+                    POOL_COUNT[len] = n;
+                    return b;
+                }
+            }
+        }
+        return new byte[len];
+    }
+
+    /** 归还 {@link #obtain} 取出的数组；调用后不得再使用它。超长或该档已满时交给 GC。 */
+    static void recycle(byte[] b) {
+        if (b == null || b.length > POOL_MAX_BYTES) {
+            return;
+        }
+        synchronized (POOL) {
+            byte[][] slot = POOL[b.length];
+            if (slot == null) {
+                slot = new byte[POOL_DEPTH][];
+                POOL[b.length] = slot;
+            }
+            int n = POOL_COUNT[b.length];
+            if (n < POOL_DEPTH) {
+                slot[n] = b;
+                POOL_COUNT[b.length] = n + 1;
+            }
+        }
     }
 
     static byte[] encodeImgPng(int seq, byte[] png, boolean enableCrc32) {
         return encodeFrame(MAGIC_IMGF, png, seq, enableCrc32);
     }
 
+    /**
+     * 将 PNG 切成若干 IMGF 分片帧（type=1，rsv=分片序号，首/末片带 FIRST/LAST 标志），
+     * 依次拼接在同一个数组中，使用 firstSeq 起连续的 seq。下位机边收边解码。
+     */
+    static byte[] encodeImgPngFragments(int firstSeq, byte[] png, int fragmentBytes, boolean enableCrc32) {
+        int count = fragmentCount(png.length, fragmentBytes);
+        byte[] out = new byte[count * 20 + png.length];
+        int o = 0;
+        for (int i = 0; i < count; i++) {
+            int off = i * fragmentBytes;
+            int len = Math.min(fragmentBytes, png.length - off);
+            int flags = (i == 0 ? IMGF_FLAG_FIRST : 0) | (i == count - 1 ? IMGF_FLAG_LAST : 0);
+            o = writeFrame(out, o, MAGIC_IMGF, IMGF_TYPE_PNG_FRAG, flags, i,
+                    png, off, len, firstSeq + i, enableCrc32);
+        }
+        return out;
+    }
+
+    /**
+     * 复用分片帧（MUXF）：把 src 中 [off, off+len) 这段内层帧字节（首片从内层帧头开始）原样装进去，
+     * type=通道，rsv=分片序号。不另算 CRC，下位机重组后按内层帧头校验。
+     */
+    static byte[] encodeMuxFragment(int channel, int index, boolean first, boolean last,
+                                    byte[] src, int off, int len) {
+        byte[] out = new byte[20 + len];
+        writeMuxFragment(out, 0, channel, index, first, last, src, off, len);
+        return out;
+    }
+
+    /** 同 {@link #encodeMuxFragment}，直接写到 out 的 dstOff 处（需 20+len 字节），返回写完后的偏移。 */
+    static int writeMuxFragment(byte[] out, int dstOff, int channel, int index, boolean first, boolean last,
+                                byte[] src, int off, int len) {
+        int flags = (first ? MUX_FLAG_FIRST : 0) | (last ? MUX_FLAG_LAST : 0);
+        return writeFrame(out, dstOff, MAGIC_MUXF, channel, flags, index, src, off, len, 0, false);
+    }
+
+    /**
+     * 把 frames 中首尾相接的各帧分别改写成 LZ4 压缩帧（flags |= FRAME_FLAG_LZ4，CRC 按压缩后的载荷重算），
+     * 载荷过短或压缩后不变小的帧原样保留，序号与其余帧头字段不变。
+     */
+    static byte[] compressFrames(byte[] frames, boolean enableCrc32) {
+        byte[] out = new byte[frames.length];
+        int o = 0;
+        int i = 0;
+        while (i + 20 <= frames.length) {
+            int len = FrameDecoder.getInt32LE(frames, i + 8);
+            byte[] z = len >= FRAME_LZ4_MIN_BYTES ? lz4Payload(frames, i + 20, len) : null;
+            if (z == null || z.length >= len) {
+                System.arraycopy(frames, i, out, o, 20 + len);
+                o += 20 + len;
+            } else {
+                int flags = (frames[i + 5] & 0xFF) | FRAME_FLAG_LZ4;
+                int rsv = (frames[i + 6] & 0xFF) | ((frames[i + 7] & 0xFF) << 8);
+                o = writeFrame(out, o, FrameDecoder.getInt32LE(frames, i), frames[i + 4] & 0xFF, flags, rsv,
+                        z, 0, z.length, FrameDecoder.getInt32LE(frames, i + 16), enableCrc32);
+            }
+            i += 20 + len;
+        }
+        return o == frames.length ? frames : Arrays.copyOf(out, o);
+    }
+
+    /** u32 原始长度 + 贪心 LZ4 块（无帧头）；遵守末尾 5 字节为字面量、最后匹配距结尾 >=12 字节的规则。 */
+    private static byte[] lz4Payload(byte[] src, int off, int len) {
+        byte[] out = new byte[4 + len + len / 255 + 16];
+        int o = putInt32LE(out, 0, len);
+        int[] table = new int[4096];
+        Arrays.fill(table, -1);
+        int end = off + len;
+        int anchor = off;
+        int i = off;
+        while (i < end - 12) {
+            int key = FrameDecoder.getInt32LE(src, i);
+            int slot = (key * -1640531535) >>> 20;
+            int cand = table[slot];
+            table[slot] = i;
+            if (cand < 0 || i - cand > 0xFFFF || FrameDecoder.getInt32LE(src, cand) != key) {
+                i++;
+                continue;
+            }
+            int mlen = 4;
+            while (i + mlen < end - 5 && src[cand + mlen] == src[i + mlen]) {
+                mlen++;
+            }
+            int lit = i - anchor;
+            out[o++] = (byte) ((Math.min(lit, 15) << 4) | Math.min(mlen - 4, 15));
+            if (lit >= 15) {
+                o = putLz4Length(out, o, lit - 15);
+            }
+            System.arraycopy(src, anchor, out, o, lit);
+            o += lit;
+            o = putUInt16LE(out, o, i - cand);
+            if (mlen - 4 >= 15) {
+                o = putLz4Length(out, o, mlen - 4 - 15);
+            }
+            i += mlen;
+            anchor = i;
+        }
+        int lit = end - anchor;
+        out[o++] = (byte) (Math.min(lit, 15) << 4);
+        if (lit >= 15) {
+            o = putLz4Length(out, o, lit - 15);
+        }
+        System.arraycopy(src, anchor, out, o, lit);
+        return Arrays.copyOf(out, o + lit);
+    }
+
+    private static int putLz4Length(byte[] dst, int off, int n) {
+        for (; n >= 255; n -= 255) {
+            dst[off++] = (byte) 255;
+        }
+        dst[off++] = (byte) n;
+        return off;
+    }
+
+    /**
+     * 将 ARGB8888 像素转换为 RGB565 位图帧（IMGF type=2）：16 字节 R565 头 + RLE 压缩像素，
+     * qoi=true 时为 QOI 文件（codec=3，下位机直接解成 RGB565）。
+     * 像素按大端（与下位机 LV_COLOR_16_SWAP 一致）写出，设备端无需再做字节交换。
+     */
+    static byte[] encodeImgR565(int seq, int width, int height, int[] argb, boolean qoi, boolean enableCrc32) {
+        return writeTypedFrame(MAGIC_IMGF, IMGF_TYPE_R565, r565Payload(0, width, height, argb, qoi), seq, enableCrc32);
+    }
+
+    /**
+     * 局部更新帧（IMGF type=3）：x/y/mapWidth/mapHeight 头 + 矩形区域的 R565 载荷。
+     * 下位机仅当当前地图尺寸为 mapWidth×mapHeight 时修补该区域。
+     */
+    static byte[] encodeImgR565Rect(int seq, int mapWidth, int mapHeight, int x, int y,
+                                   int width, int height, int[] argb, boolean qoi, boolean enableCrc32) {
+        byte[] payload = r565Payload(8, width, height, argb, qoi);
+        int p = putUInt16LE(payload, 0, x);
+        p = putUInt16LE(payload, p, y);
+        p = putUInt16LE(payload, p, mapWidth);
+        putUInt16LE(payload, p, mapHeight);
+        return writeTypedFrame(MAGIC_IMGF, IMGF_TYPE_R565_RECT, payload, seq, enableCrc32);
+    }
+
+    /**
+     * 矢量轨迹帧（IMGF type=4）：24 字节头（视口 id/尺寸、首点序号、点数、标志、线宽、RGB565 颜色、
+     * 首点绝对坐标）+ 其余各点相对前一点的 int16 增量。reset=false 时首点接在下位机已画的最后一点后面，
+     * first 须等于下位机已画点数，否则被丢弃。
+     */
+    static byte[] encodeImgTrack(int seq, int view, int viewSize, int first, boolean reset, int widthPx,
+                                 int colorRgb, int[] xs, int[] ys, boolean enableCrc32) {
+        int n = xs.length;
+        byte[] payload = new byte[24 + (n - 1) * 4];
+        int p = putInt32LE(payload, 0, 0x314B5254);
+        p = putInt32LE(payload, p, view);
+        p = putUInt16LE(payload, p, viewSize);
+        p = putUInt16LE(payload, p, viewSize);
+        p = putUInt16LE(payload, p, first);
+        p = putUInt16LE(payload, p, n);
+        payload[p++] = (byte) (reset ? TRACK_FLAG_RESET : 0);
+        payload[p++] = (byte) widthPx;
+        p = putUInt16LE(payload, p, ((colorRgb >>> 8) & 0xF800) | ((colorRgb >>> 5) & 0x07E0) | ((colorRgb >>> 3) & 0x001F));
+        p = putInt16LE(payload, p, xs[0]);
+        p = putInt16LE(payload, p, ys[0]);
+        for (int i = 1; i < n; i++) {
+            p = putInt16LE(payload, p, xs[i] - xs[i - 1]);
+            p = putInt16LE(payload, p, ys[i] - ys[i - 1]);
+        }
+        return writeTypedFrame(MAGIC_IMGF, IMGF_TYPE_TRACK, payload, seq, enableCrc32);
+    }
+
+    /**
+     * 瓦片帧（IMGF type=5）的载荷：12 字节瓦片编号（z、3 字节保留、u32 x、u32 y）+ 瓦片的 R565 载荷。
+     * 下位机写入瓦片缓存，当前瓦片布局引用它时补到地图上。
+     */
+    static byte[] tilePayload(MapTile t) {
+        byte[] payload = r565Payload(12, t.width, t.height, t.argbPixels, false);
+        payload[0] = (byte) t.zoom;
+        putInt32LE(payload, 4, (int) t.x);
+        putInt32LE(payload, 8, (int) t.y);
+        return payload;
+    }
+
+    static byte[] encodeImgTile(int seq, byte[] tilePayload, boolean enableCrc32) {
+        return writeTypedFrame(MAGIC_IMGF, IMGF_TYPE_TILE, tilePayload, seq, enableCrc32);
+    }
+
+    /**
+     * 瓦片布局帧（IMGF type=6）：12 字节头（'TMAP'、地图宽高、瓦片数、RGB565 底色）+ 每块瓦片 16 字节
+     * （int16 dx/dy + 12 字节编号）。下位机从缓存拼出地图，缺的瓦片用 'TMIS' 帧报回。
+     */
+    static byte[] encodeImgTileMap(int seq, int mapWidth, int mapHeight, int bgRgb, List<MapTile> tiles,
+                                   boolean enableCrc32) {
+        byte[] payload = new byte[12 + tiles.size() * 16];
+        int p = putInt32LE(payload, 0, 0x50414D54);
+        p = putUInt16LE(payload, p, mapWidth);
+        p = putUInt16LE(payload, p, mapHeight);
+        p = putUInt16LE(payload, p, tiles.size());
+        p = putUInt16LE(payload, p, ((bgRgb >>> 8) & 0xF800) | ((bgRgb >>> 5) & 0x07E0) | ((bgRgb >>> 3) & 0x001F));
+        for (MapTile t : tiles) {
+            p = putInt16LE(payload, p, t.dx);
+            p = putInt16LE(payload, p, t.dy);
+            payload[p] = (byte) t.zoom;
+            p = putInt32LE(payload, p + 4, (int) t.x);
+            p = putInt32LE(payload, p, (int) t.y);
+        }
+        return writeTypedFrame(MAGIC_IMGF, IMGF_TYPE_TILE_MAP, payload, seq, enableCrc32);
+    }
+
+    /**
+     * 瓦片视口帧（IMGF type=7）：'TVEW'、缩放级别、保留字节、RGB565 底色、视口左上角世界坐标 u32 x/y，共 16 字节。
+     */
+    static byte[] encodeImgTileView(int seq, int zoom, long px, long py, int bgRgb, boolean enableCrc32) {
+        byte[] payload = new byte[16];
+        int p = putInt32LE(payload, 0, 0x57455654);
+        payload[p++] = (byte) zoom;
+        payload[p++] = 0;
+        p = putUInt16LE(payload, p, ((bgRgb >>> 8) & 0xF800) | ((bgRgb >>> 5) & 0x07E0) | ((bgRgb >>> 3) & 0x001F));
+        p = putInt32LE(payload, p, (int) px);
+        putInt32LE(payload, p, (int) py);
+        return writeTypedFrame(MAGIC_IMGF, IMGF_TYPE_TILE_VIEW, payload, seq, enableCrc32);
+    }
+
+    /** 在 prefix 字节之后写 16 字节 R565 头 + RLE 像素（或 QOI 文件）；像素按大端（与 LV_COLOR_16_SWAP 一致）。 */
+    private static byte[] r565Payload(int prefix, int width, int height, int[] argb, boolean qoi) {
+        byte[] body = qoi ? qoiEncode(argb, width, height) : rle16Encode(argb, width * height);
+        byte[] payload = new byte[prefix + 16 + body.length];
+        int p = putInt32LE(payload, prefix, 0x35363552);
+        p = putUInt16LE(payload, p, width);
+        p = putUInt16LE(payload, p, height);
+        p = putUInt16LE(payload, p, width);
+        payload[p++] = (byte) (qoi ? 3 : 1); // codec: QOI / RLE
+        payload[p++] = 1; // flags: 大端像素（QOI 由下位机按需输出，不看此位）
+        p = putInt32LE(payload, p, width * height * 2);
+        System.arraycopy(body, 0, payload, p, body.length);
+        return payload;
+    }
+
+    /**
+     * QOI 编码（3 通道）。像素先截成 RGB565 再展开回 8 位，相邻像素在 565 下相同时能走游程/差分，
+     * 下位机截回 565 时与 RLE 路径逐位一致。
+     */
+    private static byte[] qoiEncode(int[] argb, int width, int height) {
+        int count = width * height;
+        // 最坏情况每像素 4 字节，外加 14 字节头与 8 字节结尾
+        byte[] out = new byte[14 + count * 4 + 8];
+        out[0] = 'q';
+        out[1] = 'o';
+        out[2] = 'i';
+        out[3] = 'f';
+        int o = putInt32BE(out, 4, width);
+        o = putInt32BE(out, o, height);
+        out[o++] = 3;
+        out[o++] = 0;
+        int[] index = new int[64];
+        int prev = 0xFF000000;
+        int run = 0;
+        for (int i = 0; i < count; i++) {
+            int c = argb[i];
+            int r = (c >>> 16) & 0xF8;
+            int g = (c >>> 8) & 0xFC;
+            int b = c & 0xF8;
+            int px = 0xFF000000 | ((r | (r >>> 5)) << 16) | ((g | (g >>> 6)) << 8) | (b | (b >>> 5));
+            if (px == prev) {
+                run++;
+                if (run == 62) {
+                    out[o++] = (byte) (0xC0 | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                out[o++] = (byte) (0xC0 | (run - 1));
+                run = 0;
+            }
+            int pr = (px >>> 16) & 0xFF;
+            int pg = (px >>> 8) & 0xFF;
+            int pb = px & 0xFF;
+            int hash = (pr * 3 + pg * 5 + pb * 7 + 255 * 11) & 63;
+            if (index[hash] == px) {
+                out[o++] = (byte) hash;
+            } else {
+                index[hash] = px;
+                int dr = (byte) (pr - ((prev >>> 16) & 0xFF));
+                int dg = (byte) (pg - ((prev >>> 8) & 0xFF));
+                int db = (byte) (pb - (prev & 0xFF));
+                int drg = dr - dg;
+                int dbg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    out[o++] = (byte) (0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                    out[o++] = (byte) (0x80 | (dg + 32));
+                    out[o++] = (byte) (((drg + 8) << 4) | (dbg + 8));
+                } else {
+                    out[o++] = (byte) 0xFE;
+                    out[o++] = (byte) pr;
+                    out[o++] = (byte) pg;
+                    out[o++] = (byte) pb;
+                }
+            }
+            prev = px;
+        }
+        if (run > 0) {
+            out[o++] = (byte) (0xC0 | (run - 1));
+        }
+        o += 7;
+        out[o++] = 1;
+        return Arrays.copyOf(out, o);
+    }
+
+    /** c<0x80：后跟 c+1 个原样像素；c>=0x80：下一个像素重复 (c&0x7f)+1 次。 */
+    private static byte[] rle16Encode(int[] argb, int count) {
+        int[] px = new int[count];
+        for (int i = 0; i < count; i++) {
+            int c = argb[i];
+            px[i] = ((c >>> 8) & 0xF800) | ((c >>> 5) & 0x07E0) | ((c >>> 3) & 0x001F);
+        }
+        // 最坏情况每 128 个像素多 1 个控制字节
+        byte[] out = new byte[count * 2 + (count + 127) / 128];
+        int o = 0;
+        int i = 0;
+        while (i < count) {
+            int run = 1;
+            while (i + run < count && run < 128 && px[i + run] == px[i]) {
+                run++;
+            }
+            if (run >= 2) {
+                out[o++] = (byte) (0x80 | (run - 1));
+                o = putUInt16BE(out, o, px[i]);
+                i += run;
+                continue;
+            }
+            int j = i + 1;
+            while (j < count && j - i < 128 && !(j + 1 < count && px[j + 1] == px[j])) {
+                j++;
+            }
+            out[o++] = (byte) (j - i - 1);
+            for (int k = i; k < j; k++) {
+                o = putUInt16BE(out, o, px[k]);
+            }
+            i = j;
+        }
+        byte[] trimmed = new byte[o];
+        System.arraycopy(out, 0, trimmed, 0, o);
+        return trimmed;
+    }
+
+    static int fragmentCount(int length, int fragmentBytes) {
+        return (length + fragmentBytes - 1) / fragmentBytes;
+    }
+
     private static byte[] encodeFrame(int magic, byte[] payload, int seq, boolean enableCrc32) {
-        int total = 20 + payload.length;
-        byte[] out = new byte[total];
-        int h = 0;
+        return writeTypedFrame(magic, 0, payload, seq, enableCrc32);
+    }
+
+    private static byte[] writeTypedFrame(int magic, int type, byte[] payload, int seq, boolean enableCrc32) {
+        byte[] out = new byte[20 + payload.length];
+        writeFrame(out, 0, magic, type, 0, 0, payload, 0, payload.length, seq, enableCrc32);
+        return out;
+    }
+
+    private static int writeFrame(byte[] out, int off, int magic, int type, int flags, int rsv,
+                                  byte[] payload, int pOff, int pLen, int seq, boolean enableCrc32) {
+        System.arraycopy(payload, pOff, out, off + HEADER_BYTES, pLen);
+        writeHeader(out, off, magic, type, flags, rsv, pLen, seq, enableCrc32);
+        return off + HEADER_BYTES + pLen;
+    }
+
+    /** 载荷已在 out[off+20, off+20+pLen) 时补上帧头（CRC 按该段计算）。 */
+    private static void writeHeader(byte[] out, int off, int magic, int type, int flags, int rsv,
+                                    int pLen, int seq, boolean enableCrc32) {
+        int h = off;
         h = putInt32LE(out, h, magic);
-        out[h++] = 0;
-        out[h++] = 0;
-        h = putUInt16LE(out, h, 0);
-        h = putInt32LE(out, h, payload.length);
-        int crc32 = enableCrc32 ? crc32(payload) : 0;
+        out[h++] = (byte) (type & 0xFF);
+        out[h++] = (byte) (flags & 0xFF);
+        h = putUInt16LE(out, h, rsv);
+        h = putInt32LE(out, h, pLen);
+        int crc32 = enableCrc32 ? crc32(out, off + HEADER_BYTES, pLen) : 0;
         h = putInt32LE(out, h, crc32);
         putInt32LE(out, h, seq);
-        System.arraycopy(payload, 0, out, 20, payload.length);
-        return out;
     }
 
-    private static int crc32(byte[] data) {
-        CRC32 crc32 = new CRC32();
-        crc32.update(data);
+    private static int crc32(byte[] data, int off, int len) {
+        CRC32 crc32 = CRC.get();
+        crc32.reset();
+        crc32.update(data, off, len);
         long value = crc32.getValue();
         return (int) (value & 0xFFFFFFFFL);
     }
@@ -79,6 +589,20 @@ final class FrameEncoder {
         return off + 2;
     }
 
+    private static int putUInt16BE(byte[] dst, int off, int value) {
+        dst[off] = (byte) ((value >>> 8) & 0xFF);
+        dst[off + 1] = (byte) (value & 0xFF);
+        return off + 2;
+    }
+
+    private static int putInt32BE(byte[] dst, int off, int value) {
+        dst[off] = (byte) ((value >>> 24) & 0xFF);
+        dst[off + 1] = (byte) ((value >>> 16) & 0xFF);
+        dst[off + 2] = (byte) ((value >>> 8) & 0xFF);
+        dst[off + 3] = (byte) (value & 0xFF);
+        return off + 4;
+    }
+
     private static int putInt32LE(byte[] dst, int off, int value) {
         dst[off] = (byte) (value & 0xFF);
         dst[off + 1] = (byte) ((value >>> 8) & 0xFF);
@@ -132,7 +132,8 @@ public final class HttpTrackMapImageProvider implements MapImageProvider {
     }
 
     private String buildRequestJson(List<GpsPoint> points) {
-        StringBuilder sb = new StringBuilder();
+        // 每点约 40 个字符，一次分配到位
+        StringBuilder sb = new StringBuilder(16 + points.size() * 44);
         sb.append("{\"points\":[");
         for (int i = 0; i < points.size(); i++) {
             if (i > 0) {
@@ -141,9 +142,9 @@ public final class HttpTrackMapImageProvider implements MapImageProvider {
             GpsPoint p = points.get(i);
             // 与 Python 示例保持一致：[lon, lat]
             sb.append('[')
-              .append(Double.toString(p.longitude))
+              .append(p.longitude)
               .append(',')
-              .append(Double.toString(p.latitude))
+              .append(p.latitude)
               .append(']');
         }
         sb.append("]}");
@@ -1,14 +1,21 @@
 package cn.crazythursdayvivo50.esp_hud;
 
 import java.io.IOException;
+import java.util.ArrayDeque;
 import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.Iterator;
+import java.util.LinkedHashMap;
 import java.util.List;
+import java.util.Map;
 import java.util.concurrent.BlockingQueue;
 import java.util.concurrent.Executors;
 import java.util.concurrent.PriorityBlockingQueue;
 import java.util.concurrent.RejectedExecutionException;
 import java.util.concurrent.ScheduledExecutorService;
 import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicBoolean;
 import java.util.concurrent.atomic.AtomicInteger;
 import java.util.concurrent.atomic.AtomicLong;
 
@@ -26,11 +33,20 @@ public final class HudHostSdk implements AutoCloseable {
     private static final int CMD_REBOOT = 0x01;
     private static final int CMD_BRIGHTNESS = 0x02;
     private static final int CMD_OFFSET_ROTATION = 0x03;
+    private static final int CMD_HELLO = 0x09;
+    private static final long IMG_THROTTLE_MIN_MS = 500;
+    private static final int STAT_MAX_PAYLOAD = 1024;
+    private static final int MSG_BATCH_ENTRY_BYTES = 5;      // u8 len + u32 seq
+    private static final int MSG_BATCH_MAX_BYTES = 1024;     // 下位机 MSGF max_msg_bytes
+    private static final int TILE_STORE_MAX = 256;           // 留着应答 'TMIS' 的已编码瓦片数
+    private static final int TILE_PREFETCH_MAX = 32;         // 一次预取的瓦片数上限
+    private static final int DEFAULT_MAP_PX = 260;           // 握手前按固件默认地图区域估算视口
 
     private final HudTransport transport;
     private final MapImageProvider mapImageProvider;
     private final HudSdkConfig config;
     private volatile HudSdkListener listener;
+    private volatile MapTileProvider tileProvider;
 
     private final VehicleStateStore stateStore = new VehicleStateStore();
     private ScheduledExecutorService scheduler = Executors.newScheduledThreadPool(2);
@@ -45,6 +61,21 @@ public final class HudHostSdk implements AutoCloseable {
     private final AtomicLong dropped = new AtomicLong(0);
     private final AtomicLong errors = new AtomicLong(0);
 
+    /** 最近用过的瓦片（键 -> TILE 载荷），下位机报缺失时从这里补发；按访问顺序淘汰。 */
+    private final Map<Long, byte[]> tileStore = new LinkedHashMap<Long, byte[]>(64, 0.75f, true) {
+        @Override
+        protected boolean removeEldestEntry(Map.Entry<Long, byte[]> eldest) {
+            return size() > TILE_STORE_MAX;
+        }
+    };
+
+    private final MapImageCache mapCache;
+    // 瓦片视口预取：上一次视口（tileStore 锁内访问）与是否有预取任务在跑
+    private int lastViewZoom = -1;
+    private long lastViewPx;
+    private long lastViewPy;
+    private final AtomicBoolean tilePrefetching = new AtomicBoolean(false);
+
     private final Object gpsLock = new Object();
     private final OnlineVwTrackSimplifier simplifiedTrack;
     private enum MapFetchTriggerReason {
@@ -55,7 +86,8 @@ public final class HudHostSdk implements AutoCloseable {
     private enum MapFrameKind {
         NONE,
         INITIAL,
-        PERIODIC
+        PERIODIC,
+        TRACK
     }
 
     /**
@@ -110,11 +142,48 @@ public final class HudHostSdk implements AutoCloseable {
     private boolean mapRetryScheduled;
     private long nextMapRetryAtMs;
     private long currentBackoffMs;
+    // 矢量轨迹：当前视口、下位机应已画的点数、上次整条重发时间
+    private TrackViewport trackView;
+    private int trackViewId;
+    private int trackSent;
+    private long trackResetMs;
+    // 轨迹帧在本地队列里被丢弃：下一点整条重发（发送线程置位）
+    private volatile boolean trackResync;
 
     private volatile boolean running;
     private volatile boolean writerRunning;
     private Thread writerThread;
     private long lastMsgSentMs;
+    // 增量快照的基准整包：调度线程写，发送线程在它真正写出后置 written
+    private volatile MsgBase msgBase;
+
+    // 下位机状态上报与图像限流：接收线程写，发送线程读
+    private volatile boolean readerRunning;
+    private Thread readerThread;
+    private volatile DeviceStats deviceStats;
+    // 下位机能力（HELO）：接收线程写；null = 还没回报或旧固件，按配置原样发送
+    private volatile DeviceCaps deviceCaps;
+    private volatile long imgHoldUntilMs;
+    private volatile int imgByteBudget;
+    private long imgBackoffMs;
+    // 等待限流结束/下位机额度的图像帧（仅发送线程访问），保持原有先后顺序
+    private final ArrayDeque<OutboundFrame> deferredImgs = new ArrayDeque<OutboundFrame>();
+    private final AtomicInteger deferredCount = new AtomicInteger(0);
+    private int imgSentOffset;  // 队首分片组已写出的字节数
+    private int imgMuxOffset;   // 当前帧已按 MUXF 分片写出的字节数
+    private int imgMuxIndex;
+    private final CreditGate creditGate = new CreditGate();
+    // 写合并（仅发送线程访问）：就绪的帧先拼进 txBuf，队列空了或攒满时一次写出
+    private byte[] txBuf = new byte[0];
+    private int txLen;
+    private final ArrayList<OutboundFrame> txSent = new ArrayList<OutboundFrame>();  // 写出后再回调 onFrameSent
+    private OutboundFrame txImg;  // 最近一个有字节在 txBuf 里的暂存图像
+    private final AtomicLong transportWrites = new AtomicLong(0);
+    // 批量帧的组装区（仅发送线程访问），每条至少 1 字节 payload
+    private final ArrayList<OutboundFrame> msgBatch = new ArrayList<OutboundFrame>();
+    private final byte[][] msgBatchFrames = new byte[MSG_BATCH_MAX_BYTES / (MSG_BATCH_ENTRY_BYTES + 1)][];
+    private final int[] msgBatchSeqs = new int[msgBatchFrames.length];
+    private volatile OutboundFrame queuedMsg;  // 发送队列里唯一的 MSGF 快照，新快照到来时替换它
 
     /**
      * 构造 SDK 实例。
@@ -132,7 +201,9 @@ public final class HudHostSdk implements AutoCloseable {
         this.mapImageProvider = mapImageProvider;
         this.config = (config != null) ? config : HudSdkConfig.newBuilder().build();
         this.simplifiedTrack = new OnlineVwTrackSimplifier(this.config.trackMaxPoints);
+        this.mapCache = new MapImageCache(this.config.mapImageCacheEntries);
         this.currentBackoffMs = this.config.mapRetryBackoffInitialMs;
+        this.imgByteBudget = imgMaxBytes();
     }
 
     /**
@@ -164,8 +235,33 @@ public final class HudHostSdk implements AutoCloseable {
             retryReason = MapFetchTriggerReason.NORMAL;
             nextMapRetryAtMs = 0;
             currentBackoffMs = config.mapRetryBackoffInitialMs;
-        }
+            trackView = null;
+            trackSent = 0;
+            trackResetMs = 0;
+            trackResync = false;
+        }
+        deviceStats = null;
+        deviceCaps = null;
+        mapCache.invalidateShown();
+        synchronized (tileStore) {
+            lastViewZoom = -1;
+        }
+        imgHoldUntilMs = 0;
+        imgBackoffMs = 0;
+        imgByteBudget = imgMaxBytes();
+        deferredImgs.clear();
+        deferredCount.set(0);
+        imgSentOffset = 0;
+        imgMuxOffset = 0;
+        imgMuxIndex = 0;
+        creditGate.reset();
+        msgBase = null;
         startWriterThread();
+        readerRunning = true;
+        startReaderThread();
+        if (config.negotiateCapabilities) {
+            sendHello();
+        }
         long periodMs = Math.max(1L, 1000L / Math.max(1, config.msgRateHz));
         scheduler.scheduleAtFixedRate(new Runnable() {
             @Override
@@ -198,6 +294,16 @@ public final class HudHostSdk implements AutoCloseable {
             }
             writerThread = null;
         }
+        readerRunning = false;
+        if (readerThread != null) {
+            readerThread.interrupt();
+            try {
+                readerThread.join(1000);
+            } catch (InterruptedException ignored) {
+                Thread.currentThread().interrupt();
+            }
+            readerThread = null;
+        }
     }
 
     /**
@@ -236,7 +342,51 @@ public final class HudHostSdk implements AutoCloseable {
                 sentCmd.get(),
                 dropped.get(),
                 errors.get(),
-                sendQueue.size());
+                sendQueue.size() + deferredCount.get(),
+                transportWrites.get());
+    }
+
+    /**
+     * 获取最近一次下位机状态上报。
+     *
+     * @return 最新上报；传输层不支持读取或尚未收到时为 {@code null}
+     */
+    public DeviceStats getDeviceStats() {
+        return deviceStats;
+    }
+
+    /**
+     * 获取下位机能力（启动时与下位机重启后经 MSGF CMD=0x09 握手取得）。
+     * <p>
+     * 收到后 SDK 自动关闭下位机不支持的特性（LZ4 压缩、MUXF 复用、批量/增量快照），
+     * 支持 QOI 时 RGB565 帧改用 QOI，图片上限取与下位机 {@code max_png_bytes} 的较小值，
+     * 地图按下位机地图区尺寸向 {@link MapImageProvider} 请求。
+     *
+     * @return 能力；传输层不支持读取、尚未回报或旧固件时为 {@code null}
+     */
+    public DeviceCaps getDeviceCaps() {
+        return deviceCaps;
+    }
+
+    /**
+     * 获取当前建议的单张图片字节上限。
+     * <p>
+     * 初始为 {@code imgMaxBytes}；下位机上报丢图时逐步收紧，恢复正常后逐步放宽。
+     * 地图拉取时会通过 {@link MapImageProvider#fetchTrackImage(List, int)} 传给提供器。
+     *
+     * @return 字节数
+     */
+    public int getImageByteBudget() {
+        return imgByteBudget;
+    }
+
+    /**
+     * 获取当前可发送的 IMGF 帧额度（下位机空闲缓冲数减去在途帧数）。
+     *
+     * @return 额度；下位机未上报 {@code CRED} 或上报中断时为 -1（不限制）
+     */
+    public int getImageCredits() {
+        return creditGate.imgCredits(System.currentTimeMillis());
     }
 
     /**
@@ -367,7 +517,7 @@ public final class HudHostSdk implements AutoCloseable {
      */
     public void sendReboot() {
         int nextSeq = seq.getAndIncrement();
-        byte[] frame = FrameEncoder.encodeMsgCommandOnly(nextSeq, CMD_REBOOT, config.enableCrc32);
+        byte[] frame = FrameEncoder.encodeMsgCommandOnly(nextSeq, CMD_REBOOT, useCrc32());
         enqueueControlFrame(new OutboundFrame(PRIORITY_CONTROL, queueOrder.incrementAndGet(), "CMD", nextSeq, frame, MapFrameKind.NONE));
     }
 
@@ -382,7 +532,7 @@ public final class HudHostSdk implements AutoCloseable {
             throw new IllegalArgumentException("brightness must be in range 0..255");
         }
         int nextSeq = seq.getAndIncrement();
-        byte[] frame = FrameEncoder.encodeMsgCommandWithU8Arg(nextSeq, CMD_BRIGHTNESS, brightness, config.enableCrc32);
+        byte[] frame = FrameEncoder.encodeMsgCommandWithU8Arg(nextSeq, CMD_BRIGHTNESS, brightness, useCrc32());
         enqueueControlFrame(new OutboundFrame(PRIORITY_CONTROL, queueOrder.incrementAndGet(), "CMD", nextSeq, frame, MapFrameKind.NONE));
     }
 
@@ -412,7 +562,7 @@ public final class HudHostSdk implements AutoCloseable {
             throw new IllegalArgumentException("offsetRotation must be one of 1,3,5,7");
         }
         int nextSeq = seq.getAndIncrement();
-        byte[] frame = FrameEncoder.encodeMsgCommandWithU8Arg(nextSeq, CMD_OFFSET_ROTATION, offsetRotation, config.enableCrc32);
+        byte[] frame = FrameEncoder.encodeMsgCommandWithU8Arg(nextSeq, CMD_OFFSET_ROTATION, offsetRotation, useCrc32());
         enqueueControlFrame(new OutboundFrame(PRIORITY_CONTROL, queueOrder.incrementAndGet(), "CMD", nextSeq, frame, MapFrameKind.NONE));
     }
 
@@ -422,24 +572,343 @@ public final class HudHostSdk implements AutoCloseable {
      * @param pngBytes PNG 字节数组，不能为空，且不能超过 {@code imgMaxBytes}
      */
     public void sendPng(byte[] pngBytes) {
-        sendPngInternal(pngBytes, MapFrameKind.NONE);
+        sendPngInternal(pngBytes, MapFrameKind.NONE, 0);
     }
 
-    private void sendPngInternal(byte[] pngBytes, MapFrameKind kind) {
+    /** mapKey：轨迹地图的内容键（见 {@link MapImageCache#key}），其余图像为 0。 */
+    private void sendPngInternal(byte[] pngBytes, MapFrameKind kind, long mapKey) {
         if (pngBytes == null || pngBytes.length == 0) {
             emitDrop("IMGF", "empty image");
             return;
         }
-        if (pngBytes.length > config.imgMaxBytes) {
+        if (pngBytes.length > imgMaxBytes()) {
             emitDrop("IMGF", "image too large: " + pngBytes.length);
             return;
         }
+        byte[] frame;
+        int nextSeq;
+        if (config.imgFragmentBytes > 0 && pngBytes.length > config.imgFragmentBytes) {
+            // 分片整体作为一个出站单元排队，保证片间连续
+            nextSeq = seq.getAndAdd(FrameEncoder.fragmentCount(pngBytes.length, config.imgFragmentBytes));
+            frame = FrameEncoder.encodeImgPngFragments(nextSeq, pngBytes, config.imgFragmentBytes, useCrc32());
+        } else {
+            nextSeq = seq.getAndIncrement();
+            frame = FrameEncoder.encodeImgPng(nextSeq, pngBytes, useCrc32());
+        }
+        enqueueImgFrame(new OutboundFrame(PRIORITY_IMG, queueOrder.incrementAndGet(), "IMGF", nextSeq, frame, kind,
+                mapKey));
+        emitImageEnqueued("IMGF", nextSeq, frame.length);
+    }
+
+    /**
+     * 发送已解码的位图（IMGF type=2，RGB565 + RLE，{@code qoiRgb565} 时为 QOI）。下位机无需 PNG 解码，可直接显示，
+     * 适合主机端已有像素（如 Android {@code Bitmap.getPixels}）的场景。
+     *
+     * @param width 宽度，1..65535
+     * @param height 高度，1..65535
+     * @param argbPixels ARGB8888 像素，按行排列，长度至少 width*height（alpha 忽略）
+     * @throws IllegalArgumentException 当参数非法时抛出
+     */
+    public void sendRgb565(int width, int height, int[] argbPixels) {
+        if (width <= 0 || width > 0xFFFF || height <= 0 || height > 0xFFFF) {
+            throw new IllegalArgumentException("width/height must be in range 1..65535");
+        }
+        if (argbPixels == null || argbPixels.length < width * height) {
+            throw new IllegalArgumentException("argbPixels must hold width*height pixels");
+        }
+        int nextSeq = seq.getAndIncrement();
+        byte[] frame = FrameEncoder.encodeImgR565(nextSeq, width, height, argbPixels, useQoi(),
+                useCrc32());
+        if (frame.length - 20 > imgMaxBytes()) {
+            emitDrop("IMGF", "image too large: " + (frame.length - 20));
+            return;
+        }
+        enqueueImgFrame(new OutboundFrame(PRIORITY_IMG, queueOrder.incrementAndGet(), "IMGF", nextSeq, frame, MapFrameKind.NONE));
+        emitImageEnqueued("IMGF", nextSeq, frame.length);
+    }
+
+    /**
+     * 局部更新当前地图（IMGF type=3）：只发送变化的矩形，下位机原地修补并只重绘该区域。
+     * 下位机当前地图须为先前通过 {@link #sendRgb565} 发送的 mapWidth×mapHeight 位图，否则丢弃。
+     * 图像队列溢出时局部帧同样会被丢弃，建议定期发送一次整帧。
+     *
+     * @param mapWidth 当前地图宽度
+     * @param mapHeight 当前地图高度
+     * @param x 矩形左上角 x
+     * @param y 矩形左上角 y
+     * @param width 矩形宽度
+     * @param height 矩形高度
+     * @param argbPixels 矩形内的 ARGB8888 像素，按行排列，长度至少 width*height
+     * @throws IllegalArgumentException 当矩形超出地图或参数非法时抛出
+     */
+    public void sendRgb565Rect(int mapWidth, int mapHeight, int x, int y, int width, int height, int[] argbPixels) {
+        if (mapWidth <= 0 || mapWidth > 0xFFFF || mapHeight <= 0 || mapHeight > 0xFFFF) {
+            throw new IllegalArgumentException("mapWidth/mapHeight must be in range 1..65535");
+        }
+        if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > mapWidth || y + height > mapHeight) {
+            throw new IllegalArgumentException("rect must lie inside the map");
+        }
+        if (argbPixels == null || argbPixels.length < width * height) {
+            throw new IllegalArgumentException("argbPixels must hold width*height pixels");
+        }
         int nextSeq = seq.getAndIncrement();
-        byte[] frame = FrameEncoder.encodeImgPng(nextSeq, pngBytes, config.enableCrc32);
-        enqueueImgFrame(new OutboundFrame(PRIORITY_IMG, queueOrder.incrementAndGet(), "IMGF", nextSeq, frame, kind));
+        byte[] frame = FrameEncoder.encodeImgR565Rect(nextSeq, mapWidth, mapHeight, x, y, width, height,
+                argbPixels, useQoi(), useCrc32());
+        if (frame.length - 20 > imgMaxBytes()) {
+            emitDrop("IMGF", "image too large: " + (frame.length - 20));
+            return;
+        }
+        enqueueImgFrame(new OutboundFrame(PRIORITY_IMG, queueOrder.incrementAndGet(), "IMGF", nextSeq, frame, MapFrameKind.NONE));
         emitImageEnqueued("IMGF", nextSeq, frame.length);
     }
 
+    /**
+     * 发送瓦片地图（IMGF type=6）：只发布局（每块瓦片 16 字节），下位机从本地瓦片缓存拼出地图，
+     * 缓存里没有的瓦片会报回来，SDK 再自动补发这些瓦片（IMGF type=5）。重复路线上几乎不再传像素；
+     * 下位机也会记住最后一个布局，重启后不等主机即可恢复地图。
+     * <p>
+     * 同一编号的瓦片内容应保持不变（下位机按编号缓存）。SDK 只保留最近 256 块瓦片用于补发。
+     *
+     * @param mapWidth 地图宽度，1..65535
+     * @param mapHeight 地图高度，1..65535
+     * @param bgRgb 无瓦片覆盖处的底色（RGB888）
+     * @param tiles 组成地图的瓦片，最多 4000 块
+     * @throws IllegalArgumentException 当参数非法时抛出
+     */
+    public void sendTileMap(int mapWidth, int mapHeight, int bgRgb, List<MapTile> tiles) {
+        if (mapWidth <= 0 || mapWidth > 0xFFFF || mapHeight <= 0 || mapHeight > 0xFFFF) {
+            throw new IllegalArgumentException("mapWidth/mapHeight must be in range 1..65535");
+        }
+        if (tiles == null || tiles.size() > 4000) {
+            throw new IllegalArgumentException("tiles must hold at most 4000 entries");
+        }
+        synchronized (tileStore) {
+            for (MapTile t : tiles) {
+                // 编号不变内容就不变，已编码过的不再重复压缩
+                if (tileStore.get(t.key()) == null) {
+                    tileStore.put(t.key(), FrameEncoder.tilePayload(t));
+                }
+            }
+        }
+        int nextSeq = seq.getAndIncrement();
+        byte[] frame = FrameEncoder.encodeImgTileMap(nextSeq, mapWidth, mapHeight, bgRgb, tiles, useCrc32());
+        if (frame.length - 20 > imgMaxBytes()) {
+            emitDrop("IMGF", "tile map too large: " + (frame.length - 20));
+            return;
+        }
+        enqueueImgFrame(new OutboundFrame(PRIORITY_IMG, queueOrder.incrementAndGet(), "IMGF", nextSeq, frame, MapFrameKind.NONE));
+        emitImageEnqueued("IMGF", nextSeq, frame.length);
+    }
+
+    /**
+     * 平移下位机的瓦片视口（IMGF type=7）：只发视口左上角的世界坐标（16 字节），下位机保留视口附近的瓦片，
+     * 平移不到一个瓦片时平滑过渡；移入视口且下位机缓存里没有的瓦片会报回来，SDK 从最近发过的瓦片或
+     * {@link #setMapTileProvider} 设置的来源补发。跟车时按定位频率调用即可，每次只多传新进入视口的几块瓦片。
+     * <p>
+     * 坐标系：缩放级别 zoom 下瓦片 (x, y) 覆盖世界坐标 [x*64, x*64+64) × [y*64, y*64+64)（瓦片方案由调用方决定，
+     * 例如 256 像素瓦片的 Web 墨卡托地图在 zoom+2 级按 64 像素切分）。
+     *
+     * @param zoom 缩放级别，0..255
+     * @param px 视口左上角 x（世界像素），0..2^32-1
+     * @param py 视口左上角 y（世界像素），0..2^32-1
+     * @param bgRgb 瓦片未到时的底色（RGB888）
+     * @throws IllegalArgumentException 当参数非法时抛出
+     */
+    public void sendTileView(int zoom, long px, long py, int bgRgb) {
+        if (zoom < 0 || zoom > 255 || px < 0 || px > 0xFFFFFFFFL || py < 0 || py > 0xFFFFFFFFL) {
+            throw new IllegalArgumentException("zoom/px/py out of range");
+        }
+        int nextSeq = seq.getAndIncrement();
+        byte[] frame = FrameEncoder.encodeImgTileView(nextSeq, zoom, px, py, bgRgb, useCrc32());
+        enqueueImgFrame(new OutboundFrame(PRIORITY_IMG, queueOrder.incrementAndGet(), "IMGF", nextSeq, frame, MapFrameKind.NONE));
+        emitImageEnqueued("IMGF", nextSeq, frame.length);
+        if (config.prefetchTilesAhead) {
+            prefetchTilesAhead(zoom, px, py);
+        }
+    }
+
+    /**
+     * 沿上次到这次视口的移动方向，把前方一个视口内 SDK 还没有的瓦片在后台向瓦片来源取进 tileStore
+     * （只取不发）。视口移到那里、下位机报缺失时即可立即补发，不用再等下载或渲染。
+     */
+    private void prefetchTilesAhead(int zoom, long px, long py) {
+        final MapTileProvider provider = tileProvider;
+        long dx;
+        long dy;
+        synchronized (tileStore) {
+            boolean moved = lastViewZoom == zoom && (px != lastViewPx || py != lastViewPy);
+            dx = px - lastViewPx;
+            dy = py - lastViewPy;
+            lastViewZoom = zoom;
+            lastViewPx = px;
+            lastViewPy = py;
+            if (provider == null || !moved) {
+                return;
+            }
+        }
+        DeviceCaps caps = deviceCaps;
+        int w = caps != null && caps.mapWidth > 0 ? caps.mapWidth : DEFAULT_MAP_PX;
+        int h = caps != null && caps.mapHeight > 0 ? caps.mapHeight : DEFAULT_MAP_PX;
+        double len = Math.sqrt((double) dx * dx + (double) dy * dy);
+        long qx = Math.max(0L, Math.min(0xFFFFFFFFL, px + Math.round(w * dx / len)));
+        long qy = Math.max(0L, Math.min(0xFFFFFFFFL, py + Math.round(h * dy / len)));
+
+        final List<long[]> ids = new ArrayList<long[]>();
+        synchronized (tileStore) {
+            for (long ty = qy / 64; ty <= (qy + h - 1) / 64 && ids.size() < TILE_PREFETCH_MAX; ty++) {
+                for (long tx = qx / 64; tx <= (qx + w - 1) / 64 && ids.size() < TILE_PREFETCH_MAX; tx++) {
+                    if (!tileStore.containsKey(MapTile.key(zoom, tx, ty))) {
+                        ids.add(new long[] { zoom, tx, ty });
+                    }
+                }
+            }
+        }
+        if (ids.isEmpty() || !tilePrefetching.compareAndSet(false, true)) {
+            return;
+        }
+        try {
+            scheduler.execute(new Runnable() {
+                @Override
+                public void run() {
+                    try {
+                        for (long[] id : ids) {
+                            loadTile(provider, id);
+                        }
+                    } finally {
+                        tilePrefetching.set(false);
+                    }
+                }
+            });
+        } catch (RejectedExecutionException e) {
+            tilePrefetching.set(false);
+            emitError("tile.prefetch.schedule", e);
+        }
+    }
+
+    /**
+     * 设置瓦片视口的瓦片来源（在后台线程调用）。传 {@code null} 表示只补发 SDK 保留的瓦片。
+     *
+     * @param provider 瓦片来源
+     */
+    public void setMapTileProvider(MapTileProvider provider) {
+        this.tileProvider = provider;
+    }
+
+    /**
+     * 接收线程调用：'TMIS' = n 个 12 字节瓦片编号。持有的瓦片拼成一组帧入队，
+     * 与 PNG 分片一样按额度逐帧发出，只占一个图像队列位置；其余的交给瓦片来源在后台取。
+     */
+    private void onTileMiss(byte[] payload) {
+        List<byte[]> bodies = new ArrayList<byte[]>();
+        List<long[]> unknown = new ArrayList<long[]>();
+        for (int off = 0; off + 12 <= payload.length; off += 12) {
+            byte[] body;
+            synchronized (tileStore) {
+                body = tileStore.get(MapTile.key(payload, off));
+            }
+            if (body != null) {
+                bodies.add(body);
+            } else {
+                unknown.add(new long[] {
+                        payload[off] & 0xFF,
+                        FrameDecoder.getInt32LE(payload, off + 4) & 0xFFFFFFFFL,
+                        FrameDecoder.getInt32LE(payload, off + 8) & 0xFFFFFFFFL });
+            }
+        }
+        enqueueTiles(bodies);
+
+        final MapTileProvider provider = tileProvider;
+        if (unknown.isEmpty()) {
+            return;
+        }
+        if (provider == null) {
+            for (int i = 0; i < unknown.size(); i++) {
+                emitDrop("IMGF", "missing tile not held");
+            }
+            return;
+        }
+        final List<long[]> ids = unknown;
+        try {
+            scheduler.execute(new Runnable() {
+                @Override
+                public void run() {
+                    loadTiles(provider, ids);
+                }
+            });
+        } catch (RejectedExecutionException e) {
+            emitError("tile.schedule", e);
+        }
+    }
+
+    private void loadTiles(MapTileProvider provider, List<long[]> ids) {
+        List<byte[]> bodies = new ArrayList<byte[]>();
+        for (long[] id : ids) {
+            byte[] body;
+            synchronized (tileStore) {
+                body = tileStore.get(MapTile.key((int) id[0], id[1], id[2]));  // 可能刚被预取进来
+            }
+            if (body == null) {
+                body = loadTile(provider, id);
+            }
+            if (body != null) {
+                bodies.add(body);
+            }
+        }
+        enqueueTiles(bodies);
+    }
+
+    /** 向瓦片来源取一块瓦片，编码后存进 tileStore；取不到时返回 null。 */
+    private byte[] loadTile(MapTileProvider provider, long[] id) {
+        MapTile tile;
+        try {
+            int[] argb = provider.loadTile((int) id[0], id[1], id[2]);
+            if (argb == null) {
+                emitDrop("IMGF", "tile provider returned nothing");
+                return null;
+            }
+            tile = new MapTile((int) id[0], id[1], id[2], 0, 0, 64, 64, argb);
+        } catch (Exception e) {
+            emitError("tile.load", e);
+            return null;
+        }
+        byte[] body = FrameEncoder.tilePayload(tile);
+        synchronized (tileStore) {
+            tileStore.put(tile.key(), body);
+        }
+        return body;
+    }
+
+    /** 一组 TILE 帧拼成一个出站项。 */
+    private void enqueueTiles(List<byte[]> bodies) {
+        List<byte[]> frames = new ArrayList<byte[]>();
+        int total = 0;
+        int firstSeq = 0;
+        for (byte[] body : bodies) {
+            if (body.length > imgMaxBytes()) {
+                emitDrop("IMGF", "tile too large: " + body.length);
+                continue;
+            }
+            int nextSeq = seq.getAndIncrement();
+            if (frames.isEmpty()) {
+                firstSeq = nextSeq;
+            }
+            byte[] frame = FrameEncoder.encodeImgTile(nextSeq, body, useCrc32());
+            frames.add(frame);
+            total += frame.length;
+        }
+        if (frames.isEmpty()) {
+            return;
+        }
+        byte[] group = new byte[total];
+        int p = 0;
+        for (byte[] frame : frames) {
+            System.arraycopy(frame, 0, group, p, frame.length);
+            p += frame.length;
+        }
+        enqueueImgFrame(new OutboundFrame(PRIORITY_IMG, queueOrder.incrementAndGet(), "IMGF", firstSeq, group, MapFrameKind.NONE));
+        emitImageEnqueued("IMGF", firstSeq, group.length);
+    }
+
     /**
      * 写入 GPS 点（基础参数）。
      *
@@ -484,10 +953,52 @@ public final class HudHostSdk implements AutoCloseable {
             acceptedSinceLastMap++;
             emitGpsAccepted(point);
 
-            maybeTriggerMapFetchLocked(System.currentTimeMillis());
+            if (config.vectorTrack) {
+                sendTrackLocked(point, System.currentTimeMillis());
+            } else {
+                maybeTriggerMapFetchLocked(System.currentTimeMillis());
+            }
         }
     }
 
+    /**
+     * 矢量轨迹：点还在视口内时只追加这一个点；出界、视口点数用尽、周期刷新或之前的轨迹帧被丢弃时
+     * 重新取景并把简化后的整条轨迹重发（下位机清空重画）。
+     */
+    private void sendTrackLocked(GpsPoint point, long nowMs) {
+        if (!running) {
+            return;
+        }
+        boolean reset = trackView == null
+                || trackResync
+                || !trackView.contains(point)
+                || trackSent >= FrameEncoder.TRACK_MAX_POINTS
+                || (config.periodicRefreshIntervalMs > 0 && (nowMs - trackResetMs) >= config.periodicRefreshIntervalMs);
+        List<GpsPoint> points;
+        int first;
+        if (reset) {
+            points = simplifiedTrack.snapshot();
+            trackView = TrackViewport.fit(++trackViewId, points);
+            trackResetMs = nowMs;
+            trackResync = false;
+            first = 0;
+        } else {
+            points = Collections.singletonList(point);
+            first = trackSent;
+        }
+        int[] xs = new int[points.size()];
+        int[] ys = new int[points.size()];
+        for (int i = 0; i < xs.length; i++) {
+            xs[i] = trackView.x(points.get(i));
+            ys[i] = trackView.y(points.get(i));
+        }
+        int nextSeq = seq.getAndIncrement();
+        byte[] frame = FrameEncoder.encodeImgTrack(nextSeq, trackView.id, TrackViewport.VIEW_SIZE, first, reset,
+                config.trackLineWidthPx, config.trackColorRgb, xs, ys, useCrc32());
+        trackSent = first + xs.length;
+        enqueueImgFrame(new OutboundFrame(PRIORITY_IMG, queueOrder.incrementAndGet(), "IMGF", nextSeq, frame, MapFrameKind.TRACK));
+    }
+
     private void maybeBurstMsg() {
         if (!config.burstOnVehicleDataChange || !running) {
             return;
@@ -518,7 +1029,18 @@ public final class HudHostSdk implements AutoCloseable {
             return;
         }
         int nextSeq = seq.getAndIncrement();
-        byte[] frame = FrameEncoder.encodeMsgSnapshot(nextSeq, s.snapshot, config.enableCrc32);
+        // 基准整包已写出且未过期时只发变化字段；基准被替换/丢弃（未写出）则继续发整包
+        MsgBase base = msgBase;
+        byte[] frame;
+        DeviceCaps caps = deviceCaps;
+        if (base != null && base.written && config.msgKeyframeIntervalMs > 0
+                && (now - base.createdMs) < config.msgKeyframeIntervalMs
+                && (caps == null || caps.supportsMsgCmd(FrameEncoder.MSG_CMD_SNAPSHOT_DELTA))) {
+            frame = FrameEncoder.encodeMsgDelta(nextSeq, base.seq, base.snapshot, s.snapshot, useCrc32());
+        } else {
+            frame = FrameEncoder.encodeMsgSnapshot(nextSeq, s.snapshot, useCrc32());
+            msgBase = new MsgBase(nextSeq, s.snapshot, now);
+        }
         enqueueMsgFrame(new OutboundFrame(PRIORITY_MSG, queueOrder.incrementAndGet(), "MSGF", nextSeq, frame, MapFrameKind.NONE));
         lastMsgSentMs = now;
     }
@@ -598,22 +1120,39 @@ public final class HudHostSdk implements AutoCloseable {
     private void doMapFetch(List<GpsPoint> points, MapFetchTriggerReason reason) {
         boolean ok = false;
         long t0 = System.currentTimeMillis();
-        if (!points.isEmpty()) {
-            emitMapFetchStart(points.size(), points.get(0).timestampMs, points.get(points.size() - 1).timestampMs);
-        }
-        try {
-            byte[] png = mapImageProvider.fetchTrackImage(points);
-            if (png != null && png.length > 0) {
-                sendPngInternal(png, mapFrameKindFromReason(reason));
-                emitMapFetchSuccess(System.currentTimeMillis() - t0, png.length);
-                ok = true;
-            } else {
-                emitDrop("IMGF", "map provider returned empty image");
-                emitMapFetchError("map.fetch", "map provider returned empty image");
+        DeviceCaps caps = deviceCaps;
+        boolean sized = caps != null && caps.mapWidth > 0 && caps.mapHeight > 0;
+        long key = MapImageCache.key(points, sized ? caps.mapWidth : 0, sized ? caps.mapHeight : 0);
+        byte[] cached = mapCache.get(key);
+        if (mapCache.isShown(key)) {
+            // 轨迹与尺寸都没变（例如停车时的周期刷新），下位机上已经是这张图
+            emitMapFetchCached(0, false);
+            ok = true;
+        } else if (cached != null && cached.length <= imgByteBudget) {
+            sendPngInternal(cached, mapFrameKindFromReason(reason), key);
+            emitMapFetchCached(cached.length, true);
+            ok = true;
+        } else {
+            if (!points.isEmpty()) {
+                emitMapFetchStart(points.size(), points.get(0).timestampMs, points.get(points.size() - 1).timestampMs);
+            }
+            try {
+                byte[] png = sized
+                        ? mapImageProvider.fetchTrackImage(points, imgByteBudget, caps.mapWidth, caps.mapHeight)
+                        : mapImageProvider.fetchTrackImage(points, imgByteBudget);
+                if (png != null && png.length > 0) {
+                    mapCache.put(key, png);
+                    sendPngInternal(png, mapFrameKindFromReason(reason), key);
+                    emitMapFetchSuccess(System.currentTimeMillis() - t0, png.length);
+                    ok = true;
+                } else {
+                    emitDrop("IMGF", "map provider returned empty image");
+                    emitMapFetchError("map.fetch", "map provider returned empty image");
+                }
+            } catch (Exception e) {
+                emitMapFetchError("map.fetch", String.valueOf(e.getMessage()));
+                emitError("map.fetch", e);
             }
-        } catch (Exception e) {
-            emitMapFetchError("map.fetch", String.valueOf(e.getMessage()));
-            emitError("map.fetch", e);
         }
 
         synchronized (gpsLock) {
@@ -722,46 +1261,418 @@ public final class HudHostSdk implements AutoCloseable {
             public void run() {
                 while (writerRunning || !sendQueue.isEmpty()) {
                     try {
-                        OutboundFrame f = sendQueue.poll(100, TimeUnit.MILLISECONDS);
+                        // 控制帧/MSGF 优先；队列空时再按额度推进暂存的图像，一次一帧
+                        OutboundFrame f = sendQueue.poll();
                         if (f == null) {
-                            continue;
+                            if (pumpImage()) {
+                                continue;
+                            }
+                            // 暂时没有更多可写的帧：把这一轮攒下的一次写出
+                            txFlush();
+                            f = sendQueue.poll(deferredImgs.isEmpty() ? 100 : 20, TimeUnit.MILLISECONDS);
+                            if (f == null) {
+                                continue;
+                            }
                         }
-                        transport.write(f.bytes);
-                        transport.flush();
-                        onFrameSent(f);
+                        sendOrHold(f);
                     } catch (InterruptedException e) {
                         Thread.currentThread().interrupt();
                         break;
                     } catch (IOException e) {
+                        mapCache.invalidateShown();
                         emitError("transport.write", e);
                     }
                 }
+                try {
+                    txFlush();
+                } catch (IOException e) {
+                    emitError("transport.write", e);
+                }
             }
         }, "esp-hud-writer");
         writerThread.setDaemon(true);
         writerThread.start();
     }
 
-    private void enqueueControlFrame(OutboundFrame frame) {
-        sendQueue.offer(frame);
+    /** 仅发送线程调用：IMGF 转入暂存等待额度；MSGF 无额度时在源头丢弃（下一拍会发更新的快照）。 */
+    private void sendOrHold(OutboundFrame f) throws IOException {
+        if ("IMGF".equals(f.channel)) {
+            deferImg(f);
+            return;
+        }
+        if (useBatch() && drainMsgBatch(f)) {
+            sendMsgBatch();
+            return;
+        }
+        if ("MSGF".equals(f.channel)) {
+            if (!creditGate.tryTakeMsg(System.currentTimeMillis())) {
+                emitDrop("MSGF", "no device credit");
+                FrameEncoder.recycle(f.bytes);
+                return;
+            }
+        } else {
+            creditGate.forceMsg();  // 控制命令同样占用下位机 MSGF 队列，但不能丢
+        }
+        txAppend(f.bytes, 0, f.bytes.length);
+        FrameEncoder.recycle(f.bytes);
+        txSent.add(f);
     }
 
-    private void enqueueMsgFrame(OutboundFrame frame) {
-        List<OutboundFrame> stale = new ArrayList<OutboundFrame>();
-        for (OutboundFrame queued : sendQueue) {
-            if ("MSGF".equals(queued.channel)) {
-                stale.add(queued);
+    /** 仅发送线程调用：把队首之后紧跟着的控制命令/快照一并取进 msgBatch，凑成批（至少两帧）时返回 true。 */
+    private boolean drainMsgBatch(OutboundFrame first) {
+        msgBatch.clear();
+        if (first.bytes.length - FrameDecoder.HEADER_BYTES > 255) {
+            return false;
+        }
+        int bytes = 1 + first.bytes.length - FrameDecoder.HEADER_BYTES + MSG_BATCH_ENTRY_BYTES;
+        for (;;) {
+            OutboundFrame next = sendQueue.peek();
+            if (next == null || "IMGF".equals(next.channel) || next.bytes.length - FrameDecoder.HEADER_BYTES > 255) {
+                break;
+            }
+            int len = next.bytes.length - FrameDecoder.HEADER_BYTES + MSG_BATCH_ENTRY_BYTES;
+            if (bytes + len > MSG_BATCH_MAX_BYTES || !sendQueue.remove(next)) {
+                break;
+            }
+            if (msgBatch.isEmpty()) {
+                msgBatch.add(first);
+            }
+            msgBatch.add(next);
+            bytes += len;
+        }
+        return !msgBatch.isEmpty();
+    }
+
+    /** 一帧 CMD=0x06 发出整批：只占下位机一个 MSGF 队列项；含控制命令时不能丢，否则与单帧快照一样看额度。 */
+    private void sendMsgBatch() throws IOException {
+        int n = msgBatch.size();
+        boolean hasCmd = false;
+        for (int i = 0; i < n; i++) {
+            hasCmd |= !"MSGF".equals(msgBatch.get(i).channel);
+        }
+        if (hasCmd) {
+            creditGate.forceMsg();
+        } else if (!creditGate.tryTakeMsg(System.currentTimeMillis())) {
+            for (int i = 0; i < n; i++) {
+                emitDrop("MSGF", "no device credit");
+                FrameEncoder.recycle(msgBatch.get(i).bytes);
+            }
+            msgBatch.clear();
+            return;
+        }
+        for (int i = 0; i < n; i++) {
+            msgBatchFrames[i] = msgBatch.get(i).bytes;
+            msgBatchSeqs[i] = msgBatch.get(i).seq;
+        }
+        int len = FrameEncoder.msgBatchFrameBytes(msgBatchFrames, n);
+        int o = txReserve(len);
+        if (o >= 0) {
+            txLen = FrameEncoder.writeMsgBatch(txBuf, o, msgBatchFrames, msgBatchSeqs, n, useCrc32());
+        } else {
+            byte[] frame = FrameEncoder.obtain(len);
+            FrameEncoder.writeMsgBatch(frame, 0, msgBatchFrames, msgBatchSeqs, n, useCrc32());
+            txAppend(frame, 0, len);
+            FrameEncoder.recycle(frame);
+        }
+        for (int i = 0; i < n; i++) {
+            FrameEncoder.recycle(msgBatchFrames[i]);
+            msgBatchFrames[i] = null;
+        }
+        txSent.addAll(msgBatch);
+        msgBatch.clear();
+    }
+
+    /**
+     * 仅发送线程调用：在写缓冲末尾留出 len 字节并返回其偏移（调用方写入后把 txLen 推到末尾）。
+     * 放不下时先写出已有内容；超过合并上限（含上限为 0）时返回 -1，由调用方直接写出。
+     */
+    private int txReserve(int len) throws IOException {
+        int cap = config.writeCoalesceBytes;
+        if (txLen + len > cap) {
+            txFlush();
+        }
+        if (len > cap) {
+            return -1;
+        }
+        if (txLen + len > txBuf.length) {
+            txBuf = Arrays.copyOf(txBuf, Math.min(cap, Math.max(txLen + len, Math.max(256, txBuf.length * 2))));
+        }
+        return txLen;
+    }
+
+    /** 仅发送线程调用：把一段已编码的帧字节排进写缓冲，超过合并上限的直接写出。 */
+    private void txAppend(byte[] src, int off, int len) throws IOException {
+        int o = txReserve(len);
+        if (o < 0) {
+            transportWrites.incrementAndGet();
+            transport.write(src, off, len);
+            transport.flush();
+            return;
+        }
+        System.arraycopy(src, off, txBuf, o, len);
+        txLen = o + len;
+    }
+
+    /** 仅发送线程调用：一次写出写缓冲里的全部帧，再为其中写完的帧回调 onFrameSent。 */
+    private void txFlush() throws IOException {
+        if (txLen > 0) {
+            try {
+                transportWrites.incrementAndGet();
+                transport.write(txBuf, 0, txLen);
+                transport.flush();
+            } catch (IOException e) {
+                // 整批作废；其中没发完的图像已被截断，与整帧写失败一致：放弃这张图
+                txLen = 0;
+                txSent.clear();
+                if (txImg != null && deferredImgs.peekFirst() == txImg) {
+                    removeDeferredHead();
+                }
+                txImg = null;
+                throw e;
+            }
+            txLen = 0;
+        }
+        txImg = null;
+        for (int i = 0; i < txSent.size(); i++) {
+            onFrameSent(txSent.get(i));
+        }
+        txSent.clear();
+    }
+
+    /**
+     * 仅发送线程调用：暂存队首图像在未限流且有额度时发出下一帧，返回是否写出了数据。
+     * 长于 imgMuxFragmentBytes 的帧每次只写一个 MUXF 分片，发送线程在分片之间先处理快照与控制命令。
+     */
+    private boolean pumpImage() throws IOException {
+        OutboundFrame head = deferredImgs.peekFirst();
+        if (head == null) {
+            return false;
+        }
+        long now = System.currentTimeMillis();
+        // 限流只在图与图之间生效，已开始发送的分片组发完为止；额度按帧取，复用分片只在首片取
+        if (imgMuxOffset == 0) {
+            if (imgSentOffset == 0 && imgHoldUntilMs - now > 0) {
+                return false;
+            }
+            if (!creditGate.tryTakeImg(now)) {
+                return false;
+            }
+        }
+        int len = FrameDecoder.HEADER_BYTES + FrameDecoder.getInt32LE(head.bytes, imgSentOffset + 8);
+        DeviceCaps caps = deviceCaps;
+        int mux = caps == null || caps.supportsMux() ? config.imgMuxFragmentBytes : 0;
+        int sent = len;
+        try {
+            if (mux > 0 && len > mux) {
+                sent = Math.min(mux, len - imgMuxOffset);
+                boolean first = imgMuxOffset == 0;
+                boolean last = imgMuxOffset + sent >= len;
+                int src = imgSentOffset + imgMuxOffset;
+                int o = txReserve(FrameDecoder.HEADER_BYTES + sent);
+                if (o >= 0) {
+                    txLen = FrameEncoder.writeMuxFragment(txBuf, o, 0, imgMuxIndex, first, last, head.bytes, src, sent);
+                } else {
+                    txAppend(FrameEncoder.encodeMuxFragment(0, imgMuxIndex, first, last, head.bytes, src, sent),
+                            0, FrameDecoder.HEADER_BYTES + sent);
+                }
+            } else {
+                txAppend(head.bytes, imgSentOffset, len);
+            }
+            txImg = head;
+        } catch (IOException e) {
+            // 与整帧写失败一致：放弃这张图（写缓冲出错时可能已经放弃过）
+            if (deferredImgs.peekFirst() == head) {
+                removeDeferredHead();
+            }
+            throw e;
+        }
+        if (sent < len) {
+            imgMuxOffset += sent;
+            imgMuxIndex++;
+            if (imgMuxOffset < len) {
+                return true;
+            }
+        }
+        imgMuxOffset = 0;
+        imgMuxIndex = 0;
+        imgSentOffset += len;
+        if (imgSentOffset >= head.bytes.length) {
+            removeDeferredHead();
+            txSent.add(head);
+        }
+        return true;
+    }
+
+    private void removeDeferredHead() {
+        deferredImgs.pollFirst();
+        deferredCount.decrementAndGet();
+        imgSentOffset = 0;
+        imgMuxOffset = 0;
+        imgMuxIndex = 0;
+    }
+
+    /** 仅发送线程调用：暂存图像，超出 imgQueueCapacity 时丢最旧的（已发出一部分的队首除外）。 */
+    private void deferImg(OutboundFrame f) {
+        deferredImgs.addLast(f);
+        deferredCount.incrementAndGet();
+        while (deferredImgs.size() > Math.max(1, config.imgQueueCapacity)) {
+            Iterator<OutboundFrame> it = deferredImgs.iterator();
+            OutboundFrame victim = it.next();
+            if (imgSentOffset > 0 || imgMuxOffset > 0) {
+                victim = it.next();
             }
+            it.remove();
+            deferredCount.decrementAndGet();
+            noteImgDropped(victim);
+            emitDrop("IMGF", "drop old image (device busy)");
         }
-        for (OutboundFrame old : stale) {
-            if (sendQueue.remove(old)) {
-                emitDrop("MSGF", "replace old snapshot");
+    }
+
+    private void startReaderThread() {
+        readerThread = new Thread(new Runnable() {
+            @Override
+            public void run() {
+                FrameDecoder decoder = new FrameDecoder(STAT_MAX_PAYLOAD, new FrameDecoder.Sink() {
+                    @Override
+                    public void onFrame(int magic, int type, int flags, int frameSeq, byte[] payload) {
+                        if (magic == FrameDecoder.MAGIC_STAT) {
+                            DeviceStats stats = DeviceStats.parse(payload);
+                            if (stats != null) {
+                                onDeviceStatsReceived(stats);
+                            }
+                        } else if (magic == FrameDecoder.MAGIC_CRED) {
+                            creditGate.onReport(payload, System.currentTimeMillis());
+                        } else if (magic == FrameDecoder.MAGIC_TMIS) {
+                            onTileMiss(payload);
+                        } else if (magic == FrameDecoder.MAGIC_HELO) {
+                            DeviceCaps caps = DeviceCaps.parse(payload);
+                            if (caps != null) {
+                                onDeviceCapsReceived(caps);
+                            }
+                        }
+                    }
+                });
+                byte[] buf = new byte[512];
+                while (readerRunning) {
+                    try {
+                        int n = transport.read(buf, 0, buf.length);
+                        if (n < 0) {
+                            break;      // 只写通道或已关闭
+                        }
+                        if (n == 0) {
+                            Thread.sleep(20);
+                            continue;
+                        }
+                        decoder.feed(buf, 0, n);
+                    } catch (InterruptedException e) {
+                        Thread.currentThread().interrupt();
+                        break;
+                    } catch (IOException e) {
+                        emitError("transport.read", e);
+                        try {
+                            Thread.sleep(100);
+                        } catch (InterruptedException ie) {
+                            Thread.currentThread().interrupt();
+                            break;
+                        }
+                    }
+                }
+            }
+        }, "esp-hud-reader");
+        readerThread.setDaemon(true);
+        readerThread.start();
+    }
+
+    /**
+     * 接收线程调用：设备端新增丢图/替换时暂停发送图像（指数退避）并收紧图片预算，
+     * 图像队列清空后逐步恢复。
+     */
+    private void onDeviceStatsReceived(DeviceStats stats) {
+        DeviceStats prev = deviceStats;
+        deviceStats = stats;
+        if (prev != null && stats.uptimeMs < prev.uptimeMs) {
+            // 下位机重启了：它显示的地图不再确定；能力重新握手（可能刷了新固件）
+            mapCache.invalidateShown();
+            if (config.negotiateCapabilities) {
+                deviceCaps = null;
+                sendHello();
             }
         }
+        if (config.adaptiveImageThrottle) {
+            if (stats.imageDroppedSince(prev)) {
+                imgBackoffMs = (imgBackoffMs == 0) ? IMG_THROTTLE_MIN_MS
+                        : Math.min(imgBackoffMs * 2, config.imgThrottleMaxMs);
+                imgHoldUntilMs = System.currentTimeMillis() + imgBackoffMs;
+                imgByteBudget = Math.max(imgMaxBytes() / 4, imgByteBudget * 3 / 4);
+            } else if (stats.uiImgPending == 0) {
+                imgBackoffMs = (imgBackoffMs / 2 < IMG_THROTTLE_MIN_MS) ? 0 : imgBackoffMs / 2;
+                imgByteBudget = Math.min(imgMaxBytes(), imgByteBudget + imgMaxBytes() / 8);
+            }
+        }
+        HudSdkListener l = listener;
+        if (l != null) {
+            l.onDeviceStats(stats);
+        }
+    }
+
+    /** 接收线程调用：记录下位机能力，图片预算收到下位机上限以内。 */
+    private void onDeviceCapsReceived(DeviceCaps caps) {
+        deviceCaps = caps;
+        imgByteBudget = Math.min(imgByteBudget, imgMaxBytes());
+        HudSdkListener l = listener;
+        if (l != null) {
+            l.onDeviceCaps(caps);
+        }
+    }
+
+    /** 能力握手（MSGF CMD=0x09）：总是带 CRC，下位机要求 CRC 时也不会被丢。 */
+    private void sendHello() {
+        int nextSeq = seq.getAndIncrement();
+        byte[] frame = FrameEncoder.encodeMsgCommandOnly(nextSeq, CMD_HELLO, true);
+        enqueueControlFrame(new OutboundFrame(PRIORITY_CONTROL, queueOrder.incrementAndGet(), "CMD", nextSeq, frame, MapFrameKind.NONE));
+    }
+
+    private boolean useCrc32() {
+        DeviceCaps caps = deviceCaps;
+        return config.enableCrc32 || (caps != null && caps.requiresCrc32());
+    }
+
+    /** 下位机回报支持 QOI 时总用 QOI（比 RLE 小得多、解码仍快）；未握手时按配置。 */
+    private boolean useQoi() {
+        DeviceCaps caps = deviceCaps;
+        return caps == null ? config.qoiRgb565 : caps.supportsR565Codec(DeviceCaps.R565_CODEC_QOI);
+    }
+
+    private boolean useBatch() {
+        DeviceCaps caps = deviceCaps;
+        return config.batchMsgFrames && (caps == null || caps.supportsMsgCmd(FrameEncoder.MSG_CMD_BATCH));
+    }
+
+    private int imgMaxBytes() {
+        DeviceCaps caps = deviceCaps;
+        return caps == null || caps.imgMaxBytes <= 0 ? config.imgMaxBytes : Math.min(config.imgMaxBytes, caps.imgMaxBytes);
+    }
+
+    private void enqueueControlFrame(OutboundFrame frame) {
+        sendQueue.offer(frame);
+    }
+
+    /** 仅 msgTick 调用：队列里最多留一帧快照，旧的还没发出就换成新的（不遍历队列，不产生垃圾）。 */
+    private void enqueueMsgFrame(OutboundFrame frame) {
+        OutboundFrame old = queuedMsg;
+        queuedMsg = frame;
+        if (old != null && sendQueue.remove(old)) {
+            emitDrop("MSGF", "replace old snapshot");
+            FrameEncoder.recycle(old.bytes);
+        }
         sendQueue.offer(frame);
     }
 
     private void enqueueImgFrame(OutboundFrame frame) {
+        DeviceCaps caps = deviceCaps;
+        if (config.compressImgFrames && (caps == null || caps.supportsLz4Frames())) {
+            frame = frame.withBytes(FrameEncoder.compressFrames(frame.bytes, useCrc32()));
+        }
         List<OutboundFrame> queuedImgs = new ArrayList<OutboundFrame>();
         for (OutboundFrame queued : sendQueue) {
             if ("IMGF".equals(queued.channel)) {
@@ -778,11 +1689,19 @@ public final class HudHostSdk implements AutoCloseable {
             }
             queuedImgs.remove(oldest);
             if (sendQueue.remove(oldest)) {
+                noteImgDropped(oldest);
                 emitDrop("IMGF", "drop old image");
             }
         }
     }
 
+    /** 轨迹追加帧依赖之前的帧，丢了一帧后下一点整条重发。 */
+    private void noteImgDropped(OutboundFrame f) {
+        if (f.mapFrameKind == MapFrameKind.TRACK) {
+            trackResync = true;
+        }
+    }
+
     private OutboundFrame findOldest(List<OutboundFrame> frames) {
         OutboundFrame oldest = null;
         for (OutboundFrame frame : frames) {
@@ -796,8 +1715,15 @@ public final class HudHostSdk implements AutoCloseable {
     private void onFrameSent(OutboundFrame f) {
         if ("MSGF".equals(f.channel)) {
             sentMsg.incrementAndGet();
+            MsgBase base = msgBase;
+            if (base != null && base.seq == f.seq) {
+                base.written = true;
+            }
         } else if ("IMGF".equals(f.channel)) {
             sentImg.incrementAndGet();
+            if (f.mapFrameKind != MapFrameKind.TRACK) {
+                mapCache.onImageWritten(f.mapKey);  // 矢量轨迹画在地图之上，不换掉地图
+            }
             if (f.mapFrameKind == MapFrameKind.INITIAL) {
                 emitInitialMapFrameSent();
             } else if (f.mapFrameKind == MapFrameKind.PERIODIC) {
@@ -835,6 +1761,13 @@ public final class HudHostSdk implements AutoCloseable {
         }
     }
 
+    private void emitMapFetchCached(int bytes, boolean resent) {
+        HudSdkListener l = listener;
+        if (l != null) {
+            l.onMapFetchCached(bytes, resent);
+        }
+    }
+
     private void emitMapFetchSuccess(long latencyMs, int bytes) {
         HudSdkListener l = listener;
         if (l != null) {
@@ -901,6 +1834,19 @@ public final class HudHostSdk implements AutoCloseable {
         }
     }
 
+    private static final class MsgBase {
+        final int seq;
+        final VehicleSnapshot snapshot;
+        final long createdMs;
+        volatile boolean written;
+
+        MsgBase(int seq, VehicleSnapshot snapshot, long createdMs) {
+            this.seq = seq;
+            this.snapshot = snapshot;
+            this.createdMs = createdMs;
+        }
+    }
+
     private static final class OutboundFrame implements Comparable<OutboundFrame> {
         final int priority;
         final long order;
@@ -908,14 +1854,26 @@ public final class HudHostSdk implements AutoCloseable {
         final int seq;
         final byte[] bytes;
         final MapFrameKind mapFrameKind;
+        final long mapKey;
 
         OutboundFrame(int priority, long order, String channel, int seq, byte[] bytes, MapFrameKind mapFrameKind) {
+            this(priority, order, channel, seq, bytes, mapFrameKind, 0);
+        }
+
+        OutboundFrame(int priority, long order, String channel, int seq, byte[] bytes, MapFrameKind mapFrameKind,
+                      long mapKey) {
             this.priority = priority;
             this.order = order;
             this.channel = channel;
             this.seq = seq;
             this.bytes = bytes;
             this.mapFrameKind = mapFrameKind;
+            this.mapKey = mapKey;
+        }
+
+        OutboundFrame withBytes(byte[] newBytes) {
+            return newBytes == bytes ? this
+                    : new OutboundFrame(priority, order, channel, seq, newBytes, mapFrameKind, mapKey);
         }
 
         @Override
@@ -20,6 +20,16 @@ public final class HudSdkConfig {
     public final int msgIdleRateHz;
     /** 数据变化时是否触发一次加急发送。默认开启。 */
     public final boolean burstOnVehicleDataChange;
+    /**
+     * 增量快照的整包间隔（毫秒）。默认 1000：其间只发与最近整包不同的字段（CMD=0x05），
+     * 设为 0 表示每次都发整包（兼容不支持 CMD=0x05 的旧固件）。
+     */
+    public final long msgKeyframeIntervalMs;
+    /**
+     * 发送线程里同时排队的控制命令与快照是否合并成一帧批量帧（CMD=0x06）。默认开启；
+     * 旧固件不认识 CMD=0x06，需关闭。
+     */
+    public final boolean batchMsgFrames;
 
     /** GPS 最小保留距离（米）。默认 5。 */
     public final double gpsMinDistanceM;
@@ -40,10 +50,62 @@ public final class HudSdkConfig {
     public final int trackMaxPoints;
     /** 单张图像允许的最大字节数。默认 128KB。 */
     public final int imgMaxBytes;
+    /** PNG 分片大小（字节），大于 0 时按分片发送以便下位机边收边解码。默认 0（整帧发送）。 */
+    public final int imgFragmentBytes;
+    /**
+     * 图像帧的复用分片大小（字节）。默认 4096：更长的 IMGF 帧切成 MUXF 分片逐片写出，
+     * 快照与控制命令可以插在分片之间，不必等整张图发完；下位机重组后与整帧无异。
+     * 设为 0 表示整帧写出（旧固件不认识 MUXF，需关闭）。
+     */
+    public final int imgMuxFragmentBytes;
+    /**
+     * 写合并上限（字节）。默认 16384：发送线程把同一时刻就绪的帧（快照、控制命令、图像分片）
+     * 拼进一块复用的缓冲区，队列空了或攒满时一次 {@link HudTransport#write(byte[], int, int)} 写出；
+     * 每次写开销大的链路（Android UsbManager）上 24Hz 快照加分片可少一大半写调用。
+     * 设为 0 表示每帧单独写出。
+     */
+    public final int writeCoalesceBytes;
+    /**
+     * 轨迹地图内容缓存的图片张数。默认 4：键为简化后轨迹点与出图尺寸的哈希，触发时轨迹没变
+     * （停车时的周期刷新等）且下位机上已是这张图就既不请求也不重发，缓存里有则直接重发、不请求。设为 0 关闭。
+     */
+    public final int mapImageCacheEntries;
+    /**
+     * 瓦片视口是否预取前方瓦片。默认关闭：开启后每次 {@code sendTileView} 沿视口移动方向，
+     * 在后台把前方一个视口内 SDK 还没有的瓦片向 {@link MapTileProvider} 取好（只取不发），
+     * 下位机报缺失时立即补发。
+     */
+    public final boolean prefetchTilesAhead;
+    /**
+     * 图像帧载荷是否按 LZ4 压缩发送（帧头 flags=0x80，下位机路由器边收边解压）。默认开启：
+     * RGB565 位图、瓦片布局等压缩后通常只剩一半以下，压缩后不变小的帧（如 PNG）原样发送。
+     * 旧固件不认识压缩帧，需关闭。
+     */
+    public final boolean compressImgFrames;
+    /**
+     * {@code sendRgb565}/{@code sendRgb565Rect} 的像素是否按 QOI 编码（R565 codec=3）。默认关闭（RLE）：
+     * 地图这类有渐变的图像 QOI 通常小得多，下位机解码仍比 PNG 的 inflate 快数倍；旧固件不认识，需保持关闭。
+     */
+    public final boolean qoiRgb565;
+    /**
+     * 启动时（及检测到下位机重启后）是否用 MSGF CMD=0x09 查询下位机能力。默认开启：
+     * 收到应答后，下位机不支持的压缩、复用、批量、增量快照自动关闭，支持 QOI 时改用 QOI，
+     * 下位机要求 CRC32 时自动带上，地图按下位机地图区域尺寸出图。旧固件不应答，SDK 按配置原样发送。
+     */
+    public final boolean negotiateCapabilities;
     /** 首帧地图触发策略。默认 ON_TWO_POINTS。 */
     public final InitialFramePolicy initialFramePolicy;
     /** 地图周期刷新间隔（毫秒）。默认 30000，设为 0 表示关闭周期刷新。 */
     public final long periodicRefreshIntervalMs;
+    /**
+     * 是否改用矢量轨迹（IMGF type=4）：每个有效 GPS 点直接发给下位机画线，不再请求地图 PNG，
+     * 周期刷新变为整条轨迹重发。默认关闭；需支持 type=4 的固件。
+     */
+    public final boolean vectorTrack;
+    /** 矢量轨迹线宽（下位机像素，1..32）。默认 3。 */
+    public final int trackLineWidthPx;
+    /** 矢量轨迹颜色（0xRRGGBB）。默认 0x2F80FF。 */
+    public final int trackColorRgb;
 
     /** 是否启用 CRC32。默认关闭（与当前下位机默认设置一致）。 */
     public final boolean enableCrc32;
@@ -57,10 +119,17 @@ public final class HudSdkConfig {
     /** 地图请求失败最大退避时间（毫秒）。默认 15000。 */
     public final long mapRetryBackoffMaxMs;
 
+    /** 是否根据下位机 STAT 上报自适应限流图像。默认开启（传输层不支持读取时无效）。 */
+    public final boolean adaptiveImageThrottle;
+    /** 下位机丢图时暂停发送图像的最长时间（毫秒）。默认 8000。 */
+    public final long imgThrottleMaxMs;
+
     private HudSdkConfig(Builder b) {
         this.msgRateHz = b.msgRateHz;
         this.msgIdleRateHz = b.msgIdleRateHz;
         this.burstOnVehicleDataChange = b.burstOnVehicleDataChange;
+        this.msgKeyframeIntervalMs = b.msgKeyframeIntervalMs;
+        this.batchMsgFrames = b.batchMsgFrames;
         this.gpsMinDistanceM = b.gpsMinDistanceM;
         this.gpsMinIntervalMs = b.gpsMinIntervalMs;
         this.gpsTurnAngleDeg = b.gpsTurnAngleDeg;
@@ -70,13 +139,26 @@ public final class HudSdkConfig {
         this.mapTriggerDistanceM = b.mapTriggerDistanceM;
         this.trackMaxPoints = b.trackMaxPoints;
         this.imgMaxBytes = b.imgMaxBytes;
+        this.imgFragmentBytes = b.imgFragmentBytes;
+        this.imgMuxFragmentBytes = b.imgMuxFragmentBytes;
+        this.writeCoalesceBytes = b.writeCoalesceBytes;
+        this.mapImageCacheEntries = b.mapImageCacheEntries;
+        this.prefetchTilesAhead = b.prefetchTilesAhead;
+        this.compressImgFrames = b.compressImgFrames;
+        this.qoiRgb565 = b.qoiRgb565;
+        this.negotiateCapabilities = b.negotiateCapabilities;
         this.initialFramePolicy = b.initialFramePolicy;
         this.periodicRefreshIntervalMs = b.periodicRefreshIntervalMs;
+        this.vectorTrack = b.vectorTrack;
+        this.trackLineWidthPx = b.trackLineWidthPx;
+        this.trackColorRgb = b.trackColorRgb;
         this.enableCrc32 = b.enableCrc32;
         this.msgQueueCapacity = b.msgQueueCapacity;
         this.imgQueueCapacity = b.imgQueueCapacity;
         this.mapRetryBackoffInitialMs = b.mapRetryBackoffInitialMs;
         this.mapRetryBackoffMaxMs = b.mapRetryBackoffMaxMs;
+        this.adaptiveImageThrottle = b.adaptiveImageThrottle;
+        this.imgThrottleMaxMs = b.imgThrottleMaxMs;
     }
 
     /**
@@ -95,6 +177,8 @@ public final class HudSdkConfig {
         private int msgRateHz = 24;
         private int msgIdleRateHz = 2;
         private boolean burstOnVehicleDataChange = true;
+        private long msgKeyframeIntervalMs = 1000;
+        private boolean batchMsgFrames = true;
 
         private double gpsMinDistanceM = 5.0;
         private long gpsMinIntervalMs = 250;
@@ -106,8 +190,19 @@ public final class HudSdkConfig {
         private double mapTriggerDistanceM = 30.0;
         private int trackMaxPoints = 500;
         private int imgMaxBytes = 128 * 1024;
+        private int imgFragmentBytes = 0;
+        private int imgMuxFragmentBytes = 4096;
+        private int writeCoalesceBytes = 16 * 1024;
+        private int mapImageCacheEntries = 4;
+        private boolean prefetchTilesAhead = false;
+        private boolean compressImgFrames = true;
+        private boolean qoiRgb565 = false;
+        private boolean negotiateCapabilities = true;
         private InitialFramePolicy initialFramePolicy = InitialFramePolicy.ON_TWO_POINTS;
         private long periodicRefreshIntervalMs = 30000;
+        private boolean vectorTrack = false;
+        private int trackLineWidthPx = 3;
+        private int trackColorRgb = 0x2F80FF;
 
         private boolean enableCrc32 = false;
         private int msgQueueCapacity = 1;
@@ -116,6 +211,9 @@ public final class HudSdkConfig {
         private long mapRetryBackoffInitialMs = 1000;
         private long mapRetryBackoffMaxMs = 15000;
 
+        private boolean adaptiveImageThrottle = true;
+        private long imgThrottleMaxMs = 8000;
+
         /**
          * 设置 MSGF 正常发送频率。
          *
@@ -149,6 +247,28 @@ public final class HudSdkConfig {
             return this;
         }
 
+        /**
+         * 设置增量快照的整包间隔。
+         *
+         * @param value 间隔（毫秒），必须大于等于 0；0 表示关闭增量快照
+         * @return 当前 Builder
+         */
+        public Builder setMsgKeyframeIntervalMs(long value) {
+            this.msgKeyframeIntervalMs = value;
+            return this;
+        }
+
+        /**
+         * 设置是否把同时排队的控制命令与快照合并成批量帧发送。
+         *
+         * @param value 是否启用
+         * @return 当前 Builder
+         */
+        public Builder setBatchMsgFrames(boolean value) {
+            this.batchMsgFrames = value;
+            return this;
+        }
+
         /**
          * 设置 GPS 去重点最小距离。
          *
@@ -248,6 +368,94 @@ public final class HudSdkConfig {
             return this;
         }
 
+        /**
+         * 设置 PNG 分片大小。下位机每收到一片即开始解码，缩短地图更新延迟。
+         *
+         * @param value 分片字节数，0 表示整帧发送，否则必须在 1024..65535 之间
+         * @return 当前 Builder
+         */
+        public Builder setImgFragmentBytes(int value) {
+            this.imgFragmentBytes = value;
+            return this;
+        }
+
+        /**
+         * 设置图像帧的复用分片大小。越小快照插队越及时，每片多 20 字节帧头。
+         *
+         * @param value 分片字节数，0 表示整帧写出，否则必须在 256..65535 之间
+         * @return 当前 Builder
+         */
+        public Builder setImgMuxFragmentBytes(int value) {
+            this.imgMuxFragmentBytes = value;
+            return this;
+        }
+
+        /**
+         * 设置写合并上限。应不小于复用分片大小，否则每个分片仍单独写出。
+         *
+         * @param value 缓冲字节数，0 表示每帧单独写出，否则必须在 256..1048576 之间
+         * @return 当前 Builder
+         */
+        public Builder setWriteCoalesceBytes(int value) {
+            this.writeCoalesceBytes = value;
+            return this;
+        }
+
+        /**
+         * 设置轨迹地图内容缓存的图片张数。
+         *
+         * @param value 张数，0 表示关闭，最大 64
+         * @return 当前 Builder
+         */
+        public Builder setMapImageCacheEntries(int value) {
+            this.mapImageCacheEntries = value;
+            return this;
+        }
+
+        /**
+         * 设置瓦片视口是否预取前方瓦片（需 {@link HudHostSdk#setMapTileProvider}）。
+         *
+         * @param value 是否启用
+         * @return 当前 Builder
+         */
+        public Builder setPrefetchTilesAhead(boolean value) {
+            this.prefetchTilesAhead = value;
+            return this;
+        }
+
+        /**
+         * 设置是否按 LZ4 压缩图像帧载荷。
+         *
+         * @param value 是否启用
+         * @return 当前 Builder
+         */
+        public Builder setCompressImgFrames(boolean value) {
+            this.compressImgFrames = value;
+            return this;
+        }
+
+        /**
+         * 设置 RGB565 位图是否按 QOI 编码发送。
+         *
+         * @param value 是否启用
+         * @return 当前 Builder
+         */
+        public Builder setQoiRgb565(boolean value) {
+            this.qoiRgb565 = value;
+            return this;
+        }
+
+        /**
+         * 设置启动时是否与下位机握手查询能力。
+         *
+         * @param value 是否启用
+         * @return 当前 Builder
+         */
+        public Builder setNegotiateCapabilities(boolean value) {
+            this.negotiateCapabilities = value;
+            return this;
+        }
+
         /**
          * 设置首帧地图触发策略。
          *
@@ -270,6 +478,39 @@ public final class HudSdkConfig {
             return this;
         }
 
+        /**
+         * 设置是否改用矢量轨迹（下位机画线，不再请求地图 PNG）。
+         *
+         * @param value 是否开启
+         * @return 当前 Builder
+         */
+        public Builder setVectorTrack(boolean value) {
+            this.vectorTrack = value;
+            return this;
+        }
+
+        /**
+         * 设置矢量轨迹线宽。
+         *
+         * @param value 线宽（像素），1..32
+         * @return 当前 Builder
+         */
+        public Builder setTrackLineWidthPx(int value) {
+            this.trackLineWidthPx = value;
+            return this;
+        }
+
+        /**
+         * 设置矢量轨迹颜色。
+         *
+         * @param value 颜色 0xRRGGBB（高 8 位忽略）
+         * @return 当前 Builder
+         */
+        public Builder setTrackColorRgb(int value) {
+            this.trackColorRgb = value;
+            return this;
+        }
+
         /**
          * 设置是否启用 CRC32。
          *
@@ -325,6 +566,28 @@ public final class HudSdkConfig {
             return this;
         }
 
+        /**
+         * 设置是否根据下位机状态上报自适应限流图像。
+         *
+         * @param value {@code true} 开启
+         * @return 当前 Builder
+         */
+        public Builder setAdaptiveImageThrottle(boolean value) {
+            this.adaptiveImageThrottle = value;
+            return this;
+        }
+
+        /**
+         * 设置下位机丢图时暂停发送图像的最长时间。
+         *
+         * @param value 时间（毫秒），必须大于 0
+         * @return 当前 Builder
+         */
+        public Builder setImgThrottleMaxMs(long value) {
+            this.imgThrottleMaxMs = value;
+            return this;
+        }
+
         /**
          * 构建不可变配置对象。
          *
@@ -338,6 +601,9 @@ public final class HudSdkConfig {
             if (msgIdleRateHz <= 0) {
                 throw new IllegalArgumentException("msgIdleRateHz must be > 0");
             }
+            if (msgKeyframeIntervalMs < 0) {
+                throw new IllegalArgumentException("msgKeyframeIntervalMs must be >= 0");
+            }
             if (gpsMinDistanceM < 0) {
                 throw new IllegalArgumentException("gpsMinDistanceM must be >= 0");
             }
@@ -356,12 +622,30 @@ public final class HudSdkConfig {
             if (imgMaxBytes <= 0) {
                 throw new IllegalArgumentException("imgMaxBytes must be > 0");
             }
+            if (imgFragmentBytes != 0 && (imgFragmentBytes < 1024 || imgFragmentBytes > 65535)) {
+                throw new IllegalArgumentException("imgFragmentBytes must be 0 or in 1024..65535");
+            }
+            if (imgMuxFragmentBytes != 0 && (imgMuxFragmentBytes < 256 || imgMuxFragmentBytes > 65535)) {
+                throw new IllegalArgumentException("imgMuxFragmentBytes must be 0 or in 256..65535");
+            }
+            if (writeCoalesceBytes != 0 && (writeCoalesceBytes < 256 || writeCoalesceBytes > 1024 * 1024)) {
+                throw new IllegalArgumentException("writeCoalesceBytes must be 0 or in 256..1048576");
+            }
+            if (mapImageCacheEntries < 0 || mapImageCacheEntries > 64) {
+                throw new IllegalArgumentException("mapImageCacheEntries must be in 0..64");
+            }
             if (initialFramePolicy == null) {
                 throw new IllegalArgumentException("initialFramePolicy must not be null");
             }
             if (periodicRefreshIntervalMs < 0) {
                 throw new IllegalArgumentException("periodicRefreshIntervalMs must be >= 0");
             }
+            if (trackLineWidthPx < 1 || trackLineWidthPx > 32) {
+                throw new IllegalArgumentException("trackLineWidthPx must be in range 1..32");
+            }
+            if (vectorTrack && trackMaxPoints > 2048) {
+                throw new IllegalArgumentException("trackMaxPoints must be <= 2048 when vectorTrack is enabled");
+            }
             if (msgQueueCapacity <= 0) {
                 throw new IllegalArgumentException("msgQueueCapacity must be > 0");
             }
@@ -374,6 +658,9 @@ public final class HudSdkConfig {
             if (mapRetryBackoffInitialMs > mapRetryBackoffMaxMs) {
                 throw new IllegalArgumentException("initial backoff cannot exceed max backoff");
             }
+            if (imgThrottleMaxMs <= 0) {
+                throw new IllegalArgumentException("imgThrottleMaxMs must be > 0");
+            }
             return new HudSdkConfig(this);
         }
     }
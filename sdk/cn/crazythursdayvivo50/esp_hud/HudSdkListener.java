@@ -55,6 +55,14 @@ public interface HudSdkListener {
      */
     default void onMapFetchSuccess(long latencyMs, int bytes) {}
 
+    /**
+     * 地图触发命中内容缓存（简化后的轨迹与出图尺寸和之前某次相同），没有请求 {@link MapImageProvider}。
+     *
+     * @param bytes 重发的图片字节数；未重发时为 0
+     * @param resent {@code false} 表示下位机上已经是这张图，连重发也省掉
+     */
+    default void onMapFetchCached(int bytes, boolean resent) {}
+
     /**
      * 地图拉取失败事件。
      *
@@ -87,6 +95,21 @@ public interface HudSdkListener {
      */
     default void onPeriodicMapFrameSent() {}
 
+    /**
+     * 收到下位机状态上报回调（需要 {@link HudTransport#read} 支持读取）。
+     *
+     * @param stats 本次上报
+     */
+    default void onDeviceStats(DeviceStats stats) {}
+
+    /**
+     * 收到下位机能力（握手应答，需要 {@link HudTransport#read} 支持读取）。
+     * 回调之后 SDK 已按能力调整发送方式。
+     *
+     * @param caps 下位机能力
+     */
+    default void onDeviceCaps(DeviceCaps caps) {}
+
     /**
      * SDK 内部错误回调。
      *
@@ -16,13 +16,17 @@ public final class HudStats {
     public final long errors;
     /** 当前发送队列深度。 */
     public final int queueDepth;
+    /** {@link HudTransport} 写调用次数：同时就绪的多帧合并成一次写，通常明显少于帧数之和。 */
+    public final long transportWrites;
 
-    HudStats(long msgSent, long imgSent, long cmdSent, long dropped, long errors, int queueDepth) {
+    HudStats(long msgSent, long imgSent, long cmdSent, long dropped, long errors, int queueDepth,
+             long transportWrites) {
         this.msgSent = msgSent;
         this.imgSent = imgSent;
         this.cmdSent = cmdSent;
         this.dropped = dropped;
         this.errors = errors;
         this.queueDepth = queueDepth;
+        this.transportWrites = transportWrites;
     }
 }
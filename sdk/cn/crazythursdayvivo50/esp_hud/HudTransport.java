@@ -1,11 +1,13 @@
 package cn.crazythursdayvivo50.esp_hud;
 
 import java.io.IOException;
+import java.util.Arrays;
 
 /**
  * HUD 数据发送通道抽象。
  * <p>
- * Android 侧可基于 USB CDC、蓝牙串口或网络连接实现该接口，SDK 仅负责调用。
+ * Android 侧可基于 USB CDC、蓝牙串口或网络连接实现该接口，SDK 仅负责调用；
+ * 下位机 USB vendor 批量接口可直接使用 {@link UsbBulkTransport}。
  */
 public interface HudTransport {
     /**
@@ -16,6 +18,23 @@ public interface HudTransport {
      */
     void write(byte[] data) throws IOException;
 
+    /**
+     * 写入 {@code data} 中 {@code [offset, offset+length)} 这一段，内容为一帧或首尾相接的多帧。
+     * <p>
+     * SDK 把同一时刻就绪的帧拼进一块复用的缓冲区后用本方法一次写出（见
+     * {@link HudSdkConfig#writeCoalesceBytes}）。默认实现拷出这一段再调用 {@link #write(byte[])}；
+     * 底层接口本身支持偏移的实现（如 {@link UsbBulkTransport}）应覆盖它，省掉每次写的拷贝。
+     * 方法返回后 SDK 会复用这块缓冲区，实现不得保留对它的引用。
+     *
+     * @param data   缓冲区，不能为 {@code null}
+     * @param offset 起始偏移
+     * @param length 字节数
+     * @throws IOException 当底层链路写失败时抛出
+     */
+    default void write(byte[] data, int offset, int length) throws IOException {
+        write(offset == 0 && length == data.length ? data : Arrays.copyOfRange(data, offset, offset + length));
+    }
+
     /**
      * 刷新底层发送缓冲区。
      *
@@ -23,6 +42,22 @@ public interface HudTransport {
      */
     void flush() throws IOException;
 
+    /**
+     * 读取下位机回传的字节（可选实现，用于接收 {@code STAT} 遥测帧）。
+     * <p>
+     * 默认实现返回 -1，表示该通道只写；此时 SDK 不启动接收线程，也不做基于设备状态的限流。
+     * 实现方可阻塞等待，但建议带超时（例如 100ms 内无数据返回 0），以便 SDK 停止时能及时退出。
+     *
+     * @param buffer 目标缓冲区
+     * @param offset 写入起始偏移
+     * @param length 最多读取的字节数
+     * @return 实际读取的字节数；0 表示暂无数据；-1 表示不支持读取或通道已关闭
+     * @throws IOException 当底层链路读失败时抛出
+     */
+    default int read(byte[] buffer, int offset, int length) throws IOException {
+        return -1;
+    }
+
     /**
      * 关闭传输通道并释放资源。
      *
@@ -0,0 +1,82 @@
+package cn.crazythursdayvivo50.esp_hud;
+
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * 轨迹地图图片的内容缓存，键为简化后轨迹点与出图尺寸的哈希（见 {@link #key}）。
+ * <p>
+ * 停车时的周期刷新、轨迹没有变化的触发都会算出同一个键：下位机上已经是这张图时拉取和重发都省掉，
+ * 否则直接重发缓存里的图片，不再请求 {@link MapImageProvider}。
+ */
+final class MapImageCache {
+    private final int capacity;
+    private final Map<Long, byte[]> images;
+    // 下位机当前显示的地图：该图已写出，此后没有写出别的图像、没有写失败、下位机没有重启；0 = 不确定
+    private long shownKey;
+
+    MapImageCache(final int capacity) {
+        this.capacity = capacity;
+        this.images = new LinkedHashMap<Long, byte[]>(Math.max(4, capacity * 2), 0.75f, true) {
+            @Override
+            protected boolean removeEldestEntry(Map.Entry<Long, byte[]> eldest) {
+                return size() > capacity;
+            }
+        };
+    }
+
+    /**
+     * 轨迹点（经纬度）与出图尺寸的 64 位 FNV-1a 哈希，从不为 0。时间戳、精度等不影响出图的字段不参与。
+     */
+    static long key(List<GpsPoint> points, int widthPx, int heightPx) {
+        long h = 0xcbf29ce484222325L;
+        h = mix(h, widthPx);
+        h = mix(h, heightPx);
+        for (int i = 0; i < points.size(); i++) {
+            GpsPoint p = points.get(i);
+            h = mix(h, Double.doubleToLongBits(p.latitude));
+            h = mix(h, Double.doubleToLongBits(p.longitude));
+        }
+        return h == 0 ? 1 : h;
+    }
+
+    private static long mix(long h, long v) {
+        for (int i = 0; i < 8; i++) {
+            h ^= (v >>> (i * 8)) & 0xFF;
+            h *= 0x100000001b3L;
+        }
+        return h;
+    }
+
+    /** 缓存的图片，没有时返回 {@code null}。 */
+    synchronized byte[] get(long key) {
+        return capacity > 0 ? images.get(key) : null;
+    }
+
+    synchronized void put(long key, byte[] image) {
+        if (capacity > 0) {
+            images.put(key, image);
+        }
+    }
+
+    /** 下位机当前是否正显示这张图。 */
+    synchronized boolean isShown(long key) {
+        return capacity > 0 && key != 0 && shownKey == key;
+    }
+
+    /** 发送线程写出一帧图像后调用；非地图图像传 0，下位机显示的内容从此不确定。 */
+    synchronized void onImageWritten(long key) {
+        shownKey = key;
+    }
+
+    /** 写失败、下位机重启或 SDK 重新启动时调用。 */
+    synchronized void invalidateShown() {
+        shownKey = 0;
+    }
+
+    synchronized void clear() {
+        images.clear();
+        shownKey = 0;
+    }
+}
@@ -55,4 +55,32 @@ public interface MapImageProvider {
      * @throws Exception 地图请求、渲染或编码失败时抛出
      */
     byte[] fetchTrackImage(List<GpsPoint> points) throws Exception;
+
+    /**
+     * 带字节预算的版本：SDK 根据下位机上报（丢帧、剩余内存）给出当前建议的图片大小上限，
+     * 可自行渲染的实现可据此降低分辨率或压缩参数。默认忽略预算。
+     *
+     * @param points 轨迹点列表，按时间升序，至少包含两个点
+     * @param maxBytes 建议的最大图片字节数
+     * @return PNG 字节数组
+     * @throws Exception 地图请求、渲染或编码失败时抛出
+     */
+    default byte[] fetchTrackImage(List<GpsPoint> points, int maxBytes) throws Exception {
+        return fetchTrackImage(points);
+    }
+
+    /**
+     * 带目标尺寸的版本：握手拿到下位机地图区域尺寸后 SDK 调用此方法，
+     * 可自行渲染的实现应直接按该尺寸出图，省去下位机缩放。默认忽略尺寸。
+     *
+     * @param points 轨迹点列表，按时间升序，至少包含两个点
+     * @param maxBytes 建议的最大图片字节数
+     * @param widthPx 下位机地图区域宽度（像素）
+     * @param heightPx 下位机地图区域高度（像素）
+     * @return PNG 字节数组
+     * @throws Exception 地图请求、渲染或编码失败时抛出
+     */
+    default byte[] fetchTrackImage(List<GpsPoint> points, int maxBytes, int widthPx, int heightPx) throws Exception {
+        return fetchTrackImage(points, maxBytes);
+    }
 }
@@ -0,0 +1,83 @@
+package cn.crazythursdayvivo50.esp_hud;
+
+/**
+ * 瓦片地图中的一块瓦片：瓦片编号（z/x/y，由调用方的瓦片方案决定）、在地图中的位置和像素。
+ * 下位机按编号缓存瓦片，见 {@link HudHostSdk#sendTileMap}。
+ */
+public final class MapTile {
+    /** 缩放级别，0..255。 */
+    public final int zoom;
+    /** 瓦片列号，0..2^28-1。 */
+    public final long x;
+    /** 瓦片行号，0..2^28-1。 */
+    public final long y;
+    /** 瓦片左上角在地图中的 x，可为负（超出部分被裁掉）。 */
+    public final int dx;
+    /** 瓦片左上角在地图中的 y，可为负。 */
+    public final int dy;
+    /** 瓦片宽度。 */
+    public final int width;
+    /** 瓦片高度。 */
+    public final int height;
+    /** ARGB8888 像素，按行排列（alpha 忽略）。 */
+    public final int[] argbPixels;
+
+    /**
+     * 构造瓦片。
+     *
+     * @param zoom 缩放级别，0..255
+     * @param x 瓦片列号，0..2^28-1
+     * @param y 瓦片行号，0..2^28-1
+     * @param dx 左上角在地图中的 x，-32768..32767
+     * @param dy 左上角在地图中的 y，-32768..32767
+     * @param width 宽度，1..255
+     * @param height 高度，1..255
+     * @param argbPixels ARGB8888 像素，长度至少 width*height
+     * @throws IllegalArgumentException 当参数非法时抛出
+     */
+    public MapTile(int zoom, long x, long y, int dx, int dy, int width, int height, int[] argbPixels) {
+        if (zoom < 0 || zoom > 255 || x < 0 || x > 0x0FFFFFFFL || y < 0 || y > 0x0FFFFFFFL) {
+            throw new IllegalArgumentException("tile id out of range");
+        }
+        if (dx < Short.MIN_VALUE || dx > Short.MAX_VALUE || dy < Short.MIN_VALUE || dy > Short.MAX_VALUE) {
+            throw new IllegalArgumentException("dx/dy must fit in int16");
+        }
+        // 下位机单个缓存槽 12KB，255×255 RLE 后通常也放得下；更大的瓦片请先切小
+        if (width <= 0 || width > 255 || height <= 0 || height > 255) {
+            throw new IllegalArgumentException("width/height must be in range 1..255");
+        }
+        if (argbPixels == null || argbPixels.length < width * height) {
+            throw new IllegalArgumentException("argbPixels must hold width*height pixels");
+        }
+        this.zoom = zoom;
+        this.x = x;
+        this.y = y;
+        this.dx = dx;
+        this.dy = dy;
+        this.width = width;
+        this.height = height;
+        this.argbPixels = argbPixels;
+    }
+
+    /** 与下位机 tile_key() 相同的打包方式，用作缓存键。 */
+    long key() {
+        return ((long) zoom << 56) | (x << 28) | y;
+    }
+
+    /** 瓦片 (zoom, x, y) 的键，与线上编号的打包方式相同。 */
+    static long key(int zoom, long x, long y) {
+        return ((long) (zoom & 0xFF) << 56) | ((x & 0x0FFFFFFFL) << 28) | (y & 0x0FFFFFFFL);
+    }
+
+    /** 12 字节线上编号（tile_key_wire_t）所对应的键。 */
+    static long key(byte[] wire, int off) {
+        long z = wire[off] & 0xFFL;
+        long x = getUInt32LE(wire, off + 4) & 0x0FFFFFFFL;
+        long y = getUInt32LE(wire, off + 8) & 0x0FFFFFFFL;
+        return (z << 56) | (x << 28) | y;
+    }
+
+    private static long getUInt32LE(byte[] b, int off) {
+        return (b[off] & 0xFFL) | ((b[off + 1] & 0xFFL) << 8) | ((b[off + 2] & 0xFFL) << 16) | ((b[off + 3] & 0xFFL) << 24);
+    }
+}
@@ -0,0 +1,19 @@
+package cn.crazythursdayvivo50.esp_hud;
+
+/**
+ * 瓦片视口的瓦片来源，见 {@link HudHostSdk#sendTileView}。
+ * <p>
+ * 下位机缓存里没有、SDK 也没保留的瓦片由 SDK 在后台线程向它要，可以阻塞（例如下载、渲染）。
+ */
+public interface MapTileProvider {
+    /**
+     * 返回瓦片像素。瓦片 (zoom, x, y) 覆盖该级别世界坐标 [x*64, x*64+64) × [y*64, y*64+64)。
+     *
+     * @param zoom 缩放级别，0..255
+     * @param x 瓦片列号
+     * @param y 瓦片行号
+     * @return 64×64 个 ARGB8888 像素（按行，alpha 忽略）；拿不到时返回 {@code null}
+     * @throws Exception 获取失败时抛出
+     */
+    int[] loadTile(int zoom, long x, long y) throws Exception;
+}
@@ -1,9 +1,7 @@
 package cn.crazythursdayvivo50.esp_hud;
 
 import java.util.ArrayList;
-import java.util.Comparator;
 import java.util.List;
-import java.util.PriorityQueue;
 
 /**
  * Streaming Visvalingam-Whyatt simplifier with fixed-capacity output.
@@ -11,55 +9,56 @@ import java.util.PriorityQueue;
  * <p>The structure is optimized for append-only GPS streams:
  * add a point, update local importance, and evict least-important points
  * while keeping size <= maxPoints.
+ *
+ * <p>All state lives in primitive arrays sized once at construction: a slot-indexed
+ * doubly linked list (slots recycled through a free list) and an indexed binary
+ * min-heap over interior points keyed by area, so an area change is an in-place
+ * sift instead of a new heap entry. Adding a point allocates nothing.
  */
 final class OnlineVwTrackSimplifier {
-    private static final double INF_AREA = Double.MAX_VALUE;
-
-    private static final class Node {
-        final GpsPoint point;
-        Node prev;
-        Node next;
-        double area = INF_AREA;
-        boolean removed;
-        int version;
-
-        Node(GpsPoint point) {
-            this.point = point;
-        }
-    }
-
-    private static final class HeapEntry {
-        final Node node;
-        final int version;
-
-        HeapEntry(Node node) {
-            this.node = node;
-            this.version = node.version;
-        }
-    }
+    private static final int NIL = -1;
 
     private final int maxPoints;
-    private final PriorityQueue<HeapEntry> minHeap = new PriorityQueue<HeapEntry>(
-            new Comparator<HeapEntry>() {
-                @Override
-                public int compare(HeapEntry a, HeapEntry b) {
-                    return Double.compare(a.node.area, b.node.area);
-                }
-            });
-
-    private Node head;
-    private Node tail;
+
+    // Linked list over slots; free slots are chained through next[].
+    private final GpsPoint[] points;
+    private final int[] prev;
+    private final int[] next;
+    private final double[] area;
+    private int head;
+    private int tail;
+    private int free;
     private int size;
 
+    // heap[i] = slot, heapPos[slot] = i; endpoints are never in the heap (heapPos = NIL).
+    private final int[] heap;
+    private final int[] heapPos;
+    private int heapSize;
+
     OnlineVwTrackSimplifier(int maxPoints) {
         this.maxPoints = Math.max(2, maxPoints);
+        int cap = this.maxPoints + 1;  // one extra slot for the point being added before eviction
+        this.points = new GpsPoint[cap];
+        this.prev = new int[cap];
+        this.next = new int[cap];
+        this.area = new double[cap];
+        this.heap = new int[cap];
+        this.heapPos = new int[cap];
+        clear();
     }
 
     void clear() {
-        head = null;
-        tail = null;
+        for (int i = 0; i < points.length; i++) {
+            points[i] = null;
+            prev[i] = NIL;
+            next[i] = i + 1 < points.length ? i + 1 : NIL;
+            heapPos[i] = NIL;
+        }
+        free = 0;
+        head = NIL;
+        tail = NIL;
         size = 0;
-        minHeap.clear();
+        heapSize = 0;
     }
 
     int size() {
@@ -67,102 +66,134 @@ final class OnlineVwTrackSimplifier {
     }
 
     void add(GpsPoint point) {
-        Node node = new Node(point);
-        if (tail == null) {
-            head = node;
-            tail = node;
-            size = 1;
-            return;
+        int s = free;
+        free = next[s];
+        points[s] = point;
+        prev[s] = tail;
+        next[s] = NIL;
+        int oldTail = tail;
+        if (oldTail == NIL) {
+            head = s;
+        } else {
+            next[oldTail] = s;
         }
-
-        tail.next = node;
-        node.prev = tail;
-        tail = node;
+        tail = s;
         size++;
 
         // Only the old tail might become an interior point and needs area update.
-        Node maybeInterior = node.prev;
-        if (maybeInterior != null && maybeInterior.prev != null) {
-            updateAreaAndOffer(maybeInterior);
+        if (oldTail != NIL && prev[oldTail] != NIL) {
+            area[oldTail] = triangleArea(oldTail);
+            heapInsert(oldTail);
         }
 
+        // size > maxPoints >= 2 implies at least one interior point, so the heap is non-empty.
         while (size > maxPoints) {
-            if (!removeLeastImportant()) {
-                break;
-            }
+            removeLeastImportant();
         }
     }
 
+    /** Current points in track order; O(n), the list is the only allocation. */
     List<GpsPoint> snapshot() {
         List<GpsPoint> out = new ArrayList<GpsPoint>(size);
-        Node cur = head;
-        while (cur != null) {
-            if (!cur.removed) {
-                out.add(cur.point);
-            }
-            cur = cur.next;
+        for (int s = head; s != NIL; s = next[s]) {
+            out.add(points[s]);
         }
         return out;
     }
 
-    private boolean removeLeastImportant() {
-        Node node = pollValidRemovableNode();
-        if (node == null) {
-            return false;
-        }
-        Node prev = node.prev;
-        Node next = node.next;
-
-        node.removed = true;
-        node.prev = null;
-        node.next = null;
+    private void removeLeastImportant() {
+        int n = heapPollMin();
+        int p = prev[n];
+        int x = next[n];
+        next[p] = x;
+        prev[x] = p;
+
+        points[n] = null;
+        prev[n] = NIL;
+        next[n] = free;
+        free = n;
         size--;
 
-        if (prev != null) {
-            prev.next = next;
-        } else {
-            head = next;
+        // A neighbour is interior (and thus in the heap) iff it still has both links.
+        if (prev[p] != NIL) {
+            area[p] = triangleArea(p);
+            heapFix(p);
         }
-        if (next != null) {
-            next.prev = prev;
-        } else {
-            tail = prev;
+        if (next[x] != NIL) {
+            area[x] = triangleArea(x);
+            heapFix(x);
         }
+    }
 
-        if (prev != null && prev.prev != null && prev.next != null) {
-            updateAreaAndOffer(prev);
+    private void heapInsert(int s) {
+        int i = heapSize++;
+        heap[i] = s;
+        heapPos[s] = i;
+        siftUp(i);
+    }
+
+    private int heapPollMin() {
+        int top = heap[0];
+        heapPos[top] = NIL;
+        int last = heap[--heapSize];
+        if (heapSize > 0) {
+            heap[0] = last;
+            heapPos[last] = 0;
+            siftDown(0);
         }
-        if (next != null && next.prev != null && next.next != null) {
-            updateAreaAndOffer(next);
+        return top;
+    }
+
+    /** Restores heap order after area[s] changed in either direction (decrease- or increase-key). */
+    private void heapFix(int s) {
+        siftDown(siftUp(heapPos[s]));
+    }
+
+    private int siftUp(int i) {
+        int s = heap[i];
+        double a = area[s];
+        while (i > 0) {
+            int parent = (i - 1) >>> 1;
+            int ps = heap[parent];
+            if (area[ps] <= a) {
+                break;
+            }
+            heap[i] = ps;
+            heapPos[ps] = i;
+            i = parent;
         }
-        return true;
+        heap[i] = s;
+        heapPos[s] = i;
+        return i;
     }
 
-    private Node pollValidRemovableNode() {
-        while (!minHeap.isEmpty()) {
-            HeapEntry e = minHeap.poll();
-            Node n = e.node;
-            if (n.removed) {
-                continue;
+    private void siftDown(int i) {
+        int s = heap[i];
+        double a = area[s];
+        for (;;) {
+            int c = 2 * i + 1;
+            if (c >= heapSize) {
+                break;
             }
-            if (e.version != n.version) {
-                continue;
+            if (c + 1 < heapSize && area[heap[c + 1]] < area[heap[c]]) {
+                c++;
             }
-            if (n.prev == null || n.next == null) {
-                continue;
+            int cs = heap[c];
+            if (area[cs] >= a) {
+                break;
             }
-            return n;
+            heap[i] = cs;
+            heapPos[cs] = i;
+            i = c;
         }
-        return null;
-    }
-
-    private void updateAreaAndOffer(Node node) {
-        node.version++;
-        node.area = triangleArea(node.prev.point, node.point, node.next.point);
-        minHeap.offer(new HeapEntry(node));
+        heap[i] = s;
+        heapPos[s] = i;
     }
 
-    private static double triangleArea(GpsPoint a, GpsPoint b, GpsPoint c) {
+    private double triangleArea(int s) {
+        GpsPoint a = points[prev[s]];
+        GpsPoint b = points[s];
+        GpsPoint c = points[next[s]];
         // For local trajectory simplification, planar area over lat/lon degrees is sufficient.
         return Math.abs(
                 a.longitude * (b.latitude - c.latitude)
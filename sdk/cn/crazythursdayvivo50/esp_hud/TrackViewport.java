@@ -0,0 +1,75 @@
+package cn.crazythursdayvivo50.esp_hud;
+
+import java.util.List;
+
+/**
+ * 矢量轨迹的视口：把轨迹外接框（Web 墨卡托，留边）映射到 VIEW_SIZE×VIEW_SIZE 的正方形坐标系，
+ * 下位机再把该坐标系缩放到轨迹层。新点落到视口外时由调用方重新 fit 并整条重发。
+ */
+final class TrackViewport {
+    static final int VIEW_SIZE = 4096;
+
+    /** 外接框四周再各留的比例，新点不至于马上出界。 */
+    private static final double MARGIN = 0.15;
+    /** 视口最小边长（米），静止或轨迹很短时避免放大到看不清。 */
+    private static final double MIN_SPAN_M = 300.0;
+    private static final double EARTH_RADIUS_M = 6378137.0;
+
+    final int id;
+    private final double left;
+    private final double top;
+    private final double span;
+
+    private TrackViewport(int id, double left, double top, double span) {
+        this.id = id;
+        this.left = left;
+        this.top = top;
+        this.span = span;
+    }
+
+    static TrackViewport fit(int id, List<GpsPoint> points) {
+        double minX = Double.MAX_VALUE;
+        double minY = Double.MAX_VALUE;
+        double maxX = -Double.MAX_VALUE;
+        double maxY = -Double.MAX_VALUE;
+        double latSum = 0;
+        for (GpsPoint p : points) {
+            double x = mercX(p);
+            double y = mercY(p);
+            minX = Math.min(minX, x);
+            maxX = Math.max(maxX, x);
+            minY = Math.min(minY, y);
+            maxY = Math.max(maxY, y);
+            latSum += p.latitude;
+        }
+        double lat = Math.toRadians(latSum / Math.max(1, points.size()));
+        double minSpan = MIN_SPAN_M / (EARTH_RADIUS_M * Math.max(0.01, Math.cos(lat)));
+        double span = Math.max(Math.max(maxX - minX, maxY - minY) * (1 + 2 * MARGIN), minSpan);
+        double cx = (minX + maxX) * 0.5;
+        double cy = (minY + maxY) * 0.5;
+        return new TrackViewport(id, cx - span * 0.5, cy + span * 0.5, span);
+    }
+
+    int x(GpsPoint p) {
+        return (int) Math.round((mercX(p) - left) / span * VIEW_SIZE);
+    }
+
+    int y(GpsPoint p) {
+        return (int) Math.round((top - mercY(p)) / span * VIEW_SIZE);
+    }
+
+    boolean contains(GpsPoint p) {
+        int x = x(p);
+        int y = y(p);
+        return x >= 0 && x < VIEW_SIZE && y >= 0 && y < VIEW_SIZE;
+    }
+
+    private static double mercX(GpsPoint p) {
+        return Math.toRadians(p.longitude);
+    }
+
+    private static double mercY(GpsPoint p) {
+        double lat = Math.toRadians(Math.max(-85.0, Math.min(85.0, p.latitude)));
+        return Math.log(Math.tan(Math.PI / 4 + lat / 2));
+    }
+}
@@ -0,0 +1,132 @@
+package cn.crazythursdayvivo50.esp_hud;
+
+import java.io.IOException;
+
+/**
+ * 基于下位机 USB vendor 批量接口（固件 {@code sc01_plus_vendor} 环境）的 {@link HudTransport}。
+ * <p>
+ * 下位机在 VID {@code 0x303A} 上多出一个接口类 {@code 0xFF} 的接口，带一对 bulk 端点；
+ * 与 CDC 相比没有线路规程与逐字节排队，大帧（整张地图）吞吐更高。SDK 不依赖 Android，
+ * 端点读写经 {@link BulkPipe} 交给调用方，Android 侧通常一行转给 {@code UsbDeviceConnection.bulkTransfer}：
+ *
+ * <pre>{@code
+ * UsbBulkTransport transport = new UsbBulkTransport(new UsbBulkTransport.BulkPipe() {
+ *     public int bulkOut(byte[] b, int off, int len, int timeoutMs) {
+ *         return conn.bulkTransfer(epOut, b, off, len, timeoutMs);
+ *     }
+ *     public int bulkIn(byte[] b, int off, int len, int timeoutMs) {
+ *         return conn.bulkTransfer(epIn, b, off, len, timeoutMs);
+ *     }
+ *     public void close() {
+ *         conn.releaseInterface(intf);
+ *         conn.close();
+ *     }
+ * });
+ * }</pre>
+ */
+public final class UsbBulkTransport implements HudTransport {
+    /** 下位机的 USB 厂商 ID（Espressif）。 */
+    public static final int USB_VENDOR_ID = 0x303A;
+    /** 承载帧流的接口类（vendor specific）。 */
+    public static final int USB_INTERFACE_CLASS = 0xFF;
+    /** 单次 bulk 传输的默认上限：Android 旧版本 {@code bulkTransfer} 每次最多 16KB。 */
+    public static final int DEFAULT_MAX_TRANSFER = 16 * 1024;
+    /** 默认超时：下位机接收缓冲满时端点 NAK，写会在这段时间内阻塞等待。 */
+    public static final int DEFAULT_TIMEOUT_MS = 1000;
+    private static final int READ_TIMEOUT_MS = 100;
+
+    /**
+     * 一对 bulk 端点的读写，由调用方接到具体 USB 栈。
+     */
+    public interface BulkPipe {
+        /**
+         * 向 bulk OUT 端点写一段数据。
+         *
+         * @return 实际写出的字节数；负数表示失败或超时
+         * @throws IOException 当底层链路写失败时抛出
+         */
+        int bulkOut(byte[] buffer, int offset, int length, int timeoutMs) throws IOException;
+
+        /**
+         * 从 bulk IN 端点读一段数据，{@code length} 不小于端点包长。
+         *
+         * @return 实际读到的字节数；0 或负数表示超时无数据
+         * @throws IOException 当底层链路读失败时抛出
+         */
+        int bulkIn(byte[] buffer, int offset, int length, int timeoutMs) throws IOException;
+
+        /**
+         * 释放接口并关闭设备连接。
+         *
+         * @throws IOException 当关闭过程失败时抛出
+         */
+        void close() throws IOException;
+    }
+
+    private final BulkPipe pipe;
+    private final int maxTransfer;
+    private final int timeoutMs;
+    private volatile boolean closed;
+
+    public UsbBulkTransport(BulkPipe pipe) {
+        this(pipe, DEFAULT_MAX_TRANSFER, DEFAULT_TIMEOUT_MS);
+    }
+
+    /**
+     * @param pipe        端点读写，不能为 {@code null}
+     * @param maxTransfer 单次 bulk 传输的最大字节数，整帧按它切块写出
+     * @param timeoutMs   单次写的超时
+     */
+    public UsbBulkTransport(BulkPipe pipe, int maxTransfer, int timeoutMs) {
+        if (pipe == null) {
+            throw new IllegalArgumentException("pipe must not be null");
+        }
+        if (maxTransfer <= 0 || timeoutMs <= 0) {
+            throw new IllegalArgumentException("maxTransfer and timeoutMs must be > 0");
+        }
+        this.pipe = pipe;
+        this.maxTransfer = maxTransfer;
+        this.timeoutMs = timeoutMs;
+    }
+
+    @Override
+    public void write(byte[] data) throws IOException {
+        write(data, 0, data.length);
+    }
+
+    @Override
+    public void write(byte[] data, int offset, int length) throws IOException {
+        int off = 0;
+        while (off < length) {
+            if (closed) {
+                throw new IOException("transport closed");
+            }
+            int len = Math.min(maxTransfer, length - off);
+            int n = pipe.bulkOut(data, offset + off, len, timeoutMs);
+            if (n <= 0) {
+                throw new IOException("bulk OUT failed (" + n + ") after " + off + "/" + length + " bytes");
+            }
+            off += n;
+        }
+    }
+
+    @Override
+    public void flush() {
+        // bulk 传输返回时数据已交给主机控制器，没有额外缓冲
+    }
+
+    @Override
+    public int read(byte[] buffer, int offset, int length) throws IOException {
+        if (closed) {
+            return -1;
+        }
+        int n = pipe.bulkIn(buffer, offset, length, READ_TIMEOUT_MS);
+        return Math.max(0, n);
+    }
+
+    @Override
+    public void close() throws IOException {
+        closed = true;
+        pipe.close();
+    }
+}
@@ -66,6 +66,9 @@ Panel_Device* panel_load_from_bc02(board_pins_t* pins) {
   
   {
     auto cfg = panle->config_detail();
+#ifdef PANELLAN_RGB_USE_PSRAM
+    cfg.use_psram = PANELLAN_RGB_USE_PSRAM;
+#endif
     panle->config_detail(cfg);
   }
 
@@ -1,5 +1,9 @@
 #include "boards.h"
 
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+#include <lgfx/v1/platforms/esp32s3/Panel_RGB.hpp>
+#endif
+
 using namespace lgfx::v1;
 
 #ifdef CONFIG_IDF_TARGET_ESP32
@@ -20,7 +24,71 @@ PanelLan::PanelLan(panelLan_board_t board) {
   setPanel(nullptr);
 }
 
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+namespace {
+struct board_probe_t {
+  panelLan_board_t board;
+  int8_t sda, scl;
+  uint8_t addr;
+};
+
+// 各板 TP_I2C_SDA/SCL_PIN（见 */*_pin.h）上的触摸芯片；GT911 上电时 INT 电平决定地址，两个都试
+const board_probe_t k_probes[] = {
+  { BOARD_SC01_PLUS,  6,  5, 0x38 },  // FT5x06
+  { BOARD_SC05,      48, 47, 0x5d },  // GT911
+  { BOARD_SC05,      48, 47, 0x14 },
+  { BOARD_SC05_PLUS, 18, 17, 0x5d },  // GT911
+  { BOARD_SC05_PLUS, 18, 17, 0x14 },
+  { BOARD_SC05_X,     8,  9, 0x38 },  // FT5x06
+  { BOARD_BC02,      15,  6, 0x38 },  // FT5x06
+  { BOARD_SC07,       9,  3, 0x5a },  // CST3240
+};
+
+bool i2c_ack(int sda, int scl, uint8_t addr) {
+  const int port = I2C_NUM_1;
+  if (!lgfx::i2c::init(port, sda, scl).has_value()) return false;
+  const bool ok = lgfx::i2c::transactionWrite(port, addr, nullptr, 0, 100000).has_value();
+  lgfx::i2c::release(port);
+  return ok;
+}
+}
+#endif
+
+panelLan_board_t PanelLan::detect(panelLan_board_t fallback) {
+#ifdef CONFIG_IDF_TARGET_ESP32
+  (void)fallback;
+  return BOARD_SC01;  // ESP32 上只有这一块
+#else
+  for (const auto& p : k_probes) {
+    if (i2c_ack(p.sda, p.scl, p.addr)) return p.board;
+  }
+  return fallback;
+#endif
+}
+
+const char* PanelLan::boardName(panelLan_board_t board) {
+  switch (board) {
+#ifdef CONFIG_IDF_TARGET_ESP32
+    case BOARD_SC01: return "SC01";
+#elif CONFIG_IDF_TARGET_ESP32S3
+    case BOARD_SC01_PLUS: return "SC01_PLUS";
+    case BOARD_SC02: return "SC02";
+    case BOARD_SC05: return "SC05";
+    case BOARD_SC05_PLUS: return "SC05_PLUS";
+    case BOARD_SC05_X: return "SC05_X";
+    case BOARD_KC01: return "KC01";
+    case BOARD_BC02: return "BC02";
+    case BOARD_SC07: return "SC07";
+#endif
+    default: return "AUTO";
+  }
+}
+
 bool PanelLan::init_impl(bool use_reset, bool use_clear) {
+  if (_board == BOARD_AUTO) {
+    _board = detect(PANELLAN_BOARD_FALLBACK);
+  }
+
   Panel_Device* panel = nullptr;
   switch (_board) {
 #ifdef CONFIG_IDF_TARGET_ESP32
@@ -45,3 +113,102 @@ bool PanelLan::init_impl(bool use_reset, bool use_clear) {
   setPanel(panel);
   return LGFX_Device::init_impl(false, use_clear);
 }
+
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+namespace {
+// _lines_buffer 是 protected：借派生类取成员指针读出来，不改 LovyanGFX
+struct FrameBufferLines : public Panel_FrameBufferBase {
+  static uint8_t** of(Panel_FrameBufferBase* p) { return p->*(&FrameBufferLines::_lines_buffer); }
+};
+}
+#endif
+
+void* PanelLan::frameBuffer(uint32_t* width, uint32_t* height) {
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+  switch (_board) {
+    case BOARD_SC02: case BOARD_SC05: case BOARD_KC01: case BOARD_BC02: break;
+    default: return nullptr;
+  }
+  auto panel = static_cast<Panel_FrameBufferBase*>(getPanel());
+  if (panel == nullptr || panel->getColorDepth() != rgb565_2Byte) return nullptr;
+
+  uint8_t** lines = FrameBufferLines::of(panel);
+  const uint32_t w = panel->config().memory_width;
+  const uint32_t h = panel->config().memory_height;
+  if (lines == nullptr || w == 0 || h == 0) return nullptr;
+
+  // LVGL direct_mode 要一整块：每行都必须紧接上一行
+  const size_t stride = (size_t)w * 2;
+  for (uint32_t y = 1; y < h; y++) {
+    if (lines[y] != lines[0] + y * stride) return nullptr;
+  }
+  *width = w;
+  *height = h;
+  return lines[0];
+#else
+  (void)width;
+  (void)height;
+  return nullptr;
+#endif
+}
+
+namespace {
+enum bus_kind_t { BUS_NONE, BUS_SPI, BUS_PARALLEL8 };
+
+bus_kind_t bus_kind(panelLan_board_t board) {
+  switch (board) {
+#ifdef CONFIG_IDF_TARGET_ESP32
+    case BOARD_SC01: return BUS_SPI;
+#elif CONFIG_IDF_TARGET_ESP32S3
+    case BOARD_SC01_PLUS: case BOARD_SC05_PLUS: case BOARD_SC05_X: case BOARD_SC07: return BUS_PARALLEL8;
+#endif
+    default: return BUS_NONE;  // RGB 面板
+  }
+}
+
+template <class Bus> uint32_t bus_get_freq(IBus* bus) {
+  return static_cast<Bus*>(bus)->config().freq_write;
+}
+
+template <class Bus> bool bus_set_freq(IBus* bus, uint32_t hz) {
+  auto b = static_cast<Bus*>(bus);
+  auto cfg = b->config();
+  cfg.freq_write = hz;
+  b->release();
+  b->config(cfg);
+  return b->init();
+}
+}
+
+uint32_t PanelLan::busFreq(void) {
+  Panel_Device* panel = getPanel();
+  IBus* bus = panel ? panel->getBus() : nullptr;
+  if (bus == nullptr) return 0;
+  switch (bus_kind(_board)) {
+    case BUS_SPI: return bus_get_freq<Bus_SPI>(bus);
+    case BUS_PARALLEL8: return bus_get_freq<Bus_Parallel8>(bus);
+    default: return 0;
+  }
+}
+
+bool PanelLan::setBusFreq(uint32_t hz) {
+  Panel_Device* panel = getPanel();
+  IBus* bus = panel ? panel->getBus() : nullptr;
+  if (bus == nullptr || hz == 0) return false;
+
+  waitDMA();
+  while (getStartCount() > 0) endWrite();
+  switch (bus_kind(_board)) {
+    case BUS_SPI: return bus_set_freq<Bus_SPI>(bus, hz);
+    case BUS_PARALLEL8: return bus_set_freq<Bus_Parallel8>(bus, hz);
+    default: return false;
+  }
+}
+
+uint32_t PanelLan::busClockSource(void) {
+  switch (bus_kind(_board)) {
+    case BUS_SPI: return 80000000;
+    case BUS_PARALLEL8: return 240000000;
+    default: return 0;
+  }
+}
@@ -2,6 +2,11 @@
 
 #include <LovyanGFX.hpp>
 
+// RGB 面板帧缓冲放哪（LovyanGFX config_detail.use_psram）：0=仅 SRAM，1=一半 SRAM 一半 PSRAM
+// （SRAM 那半减轻 PSRAM 带宽，扫描不易欠载），2=仅 PSRAM。不定义则用各板默认。
+// LVGL_RENDER_PANEL_FB 需要连续的一整块，不能用 1
+// #define PANELLAN_RGB_USE_PSRAM 2
+
 enum panelLan_board_t {
 #ifdef CONFIG_IDF_TARGET_ESP32
   BOARD_SC01,             //
@@ -15,8 +20,18 @@ enum panelLan_board_t {
   BOARD_BC02,             // ZX3D95CE01S
   BOARD_SC07,             // ZX7D00CE01S
 #endif
+  BOARD_AUTO = 0xFF,      // begin() 时探测，见 PanelLan::detect
 };
 
+// 探测不出来（SC02/KC01 没有触摸芯片，或触摸坏了）时用哪块板
+#ifndef PANELLAN_BOARD_FALLBACK
+#ifdef CONFIG_IDF_TARGET_ESP32
+#define PANELLAN_BOARD_FALLBACK BOARD_SC01
+#else
+#define PANELLAN_BOARD_FALLBACK BOARD_SC01_PLUS
+#endif
+#endif
+
 typedef struct {
   // BOARD BASE PIN
   int8_t reset;
@@ -62,4 +77,24 @@ public:
   PanelLan(panelLan_board_t board);
   board_pins_t pins;
   bool init_impl(bool use_reset, bool use_clear);
+
+  // 实际使用的板型（BOARD_AUTO 在 begin() 之后才确定）
+  panelLan_board_t board(void) const { return _board; }
+  static const char* boardName(panelLan_board_t board);
+
+  // 按各板触摸芯片所在的 I2C 引脚/地址逐个探测，谁应答就是谁；都没有应答返回 fallback。
+  // 只能在面板初始化之前调用：探测会短暂占用别的板上的 LCD 数据线
+  static panelLan_board_t detect(panelLan_board_t fallback);
+
+  // 面板总线写时钟（Hz）。RGB 面板返回 0：像素时钟属于面板时序，按屏幕规格书固定，不在这里调
+  uint32_t busFreq(void);
+  // begin() 之后改写时钟：结束当前传输，按新频率重新初始化总线（面板寄存器/GRAM 不受影响）
+  bool setBusFreq(uint32_t hz);
+  // 总线时钟源：写时钟只能取它的整数分频（S3 LCD_CAM 240MHz，ESP32 SPI 80MHz）
+  uint32_t busClockSource(void);
+
+  // RGB 面板（SC02/SC05/KC01/BC02）驱动自己持有的 PSRAM 帧缓冲，begin() 之后可用。
+  // 像素按 LovyanGFX 的 swap565 存放（与 LV_COLOR_16_SWAP=1 相同），width 即行跨度；
+  // 其他面板，或帧缓冲被拆成 SRAM/PSRAM 两半（config_detail.use_psram=1）时返回 nullptr
+  void* frameBuffer(uint32_t* width, uint32_t* height);
 };
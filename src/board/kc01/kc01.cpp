@@ -66,7 +66,9 @@ Panel_Device* panel_load_from_kc01(board_pins_t* pins) {
 
   {
     auto cfg = panle->config_detail();
-    // cfg.use_psram = 1;
+#ifdef PANELLAN_RGB_USE_PSRAM
+    cfg.use_psram = PANELLAN_RGB_USE_PSRAM;
+#endif
     panle->config_detail(cfg);
   }
 
@@ -38,7 +38,11 @@ Panel_Device* panel_load_from_sc02(board_pins_t* pins) {
 
   {
     auto cfg = panle->config_detail();
+#ifdef PANELLAN_RGB_USE_PSRAM
+    cfg.use_psram = PANELLAN_RGB_USE_PSRAM;
+#else
     cfg.use_psram = 1;
+#endif
     panle->config_detail(cfg);
   }
 
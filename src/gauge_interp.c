@@ -0,0 +1,81 @@
+#include "gauge_interp.h"
+#include <string.h>
+
+/* seq gaps beyond this are a host restart, not dropped snapshots */
+#define GAUGE_SEQ_GAP_MAX 64
+
+void gauge_interp_init(gauge_interp_t *g, uint16_t extrap_ms)
+{
+    memset(g, 0, sizeof(*g));
+    g->extrap = extrap_ms;
+}
+
+int32_t gauge_interp_value(const gauge_interp_t *g, uint32_t now_ms)
+{
+    if (!g->valid)
+        return 0;
+    const uint32_t e = now_ms - g->t0;
+    if (e < g->dur)
+        return g->from + (int32_t)((int64_t)(g->to - g->from) * e / g->dur);
+
+    uint32_t x = e - g->dur;
+    if (x > g->extrap)
+        x = g->extrap;
+    const int64_t v = (int64_t)g->to + (int64_t)g->slope_q10 * x / 1024;
+    if (v > INT32_MAX)
+        return INT32_MAX;
+    if (v < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t)v;
+}
+
+bool gauge_interp_settled(const gauge_interp_t *g, uint32_t now_ms)
+{
+    if (!g->valid)
+        return true;
+    const uint32_t end = g->dur + (g->slope_q10 ? g->extrap : 0);
+    return now_ms - g->t0 >= end;
+}
+
+void gauge_interp_sample(gauge_interp_t *g, int32_t value, uint32_t seq, uint32_t now_ms)
+{
+    if (!g->valid)
+    {
+        g->from = g->to = value;
+        g->slope_q10 = 0;
+        g->dur = 0;
+        g->t0 = now_ms;
+        g->seq = seq;
+        g->valid = true;
+        return;
+    }
+
+    const uint32_t dt = now_ms - g->t0;
+    uint32_t n = seq - g->seq;
+    if (n == 0 || n > GAUGE_SEQ_GAP_MAX)
+        n = 1;
+    const uint32_t per = dt / n;
+
+    if (dt > GAUGE_INTERP_MAX_GAP_MS || per == 0)
+    {
+        // stale or back-to-back (two snapshots in one tick): show it as is
+        g->from = value;
+        g->slope_q10 = 0;
+        g->dur = 0;
+    }
+    else
+    {
+        int64_t slope = ((int64_t)value - g->to) * 1024 / (int64_t)dt;
+        if (slope > INT32_MAX)
+            slope = INT32_MAX;
+        if (slope < -INT32_MAX)
+            slope = -INT32_MAX;
+        g->from = gauge_interp_value(g, now_ms);
+        g->slope_q10 = (int32_t)slope;
+        // light smoothing: USB arrival times jitter by a few ms
+        g->dur = g->dur ? (3 * g->dur + per) / 4 : per;
+    }
+    g->to = value;
+    g->t0 = now_ms;
+    g->seq = seq;
+}
@@ -0,0 +1,305 @@
+#include "hud_bench.h"
+
+#if HUD_BENCH
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+extern "C" {
+#include "hud_perf.h"
+#include "hud_taskmon.h"
+#include "hud_lv_mem.h"
+#include "hud_sched.h"
+#include "img_r565.h"
+}
+#include "ui_bridge.h"
+
+// 合成快照频率（Hz），与 SDK 默认 msgRateHz 相同
+#ifndef HUD_BENCH_MSG_HZ
+#define HUD_BENCH_MSG_HZ 24
+#endif
+
+// 整张地图（R565 RAW）间隔（ms），0 只测快照
+#ifndef HUD_BENCH_MAP_PERIOD_MS
+#define HUD_BENCH_MAP_PERIOD_MS 500
+#endif
+
+// 合成地图尺寸，默认与 ui_Map_Bg 所在区域一致
+#ifndef HUD_BENCH_MAP_W
+#define HUD_BENCH_MAP_W 260
+#endif
+#ifndef HUD_BENCH_MAP_H
+#define HUD_BENCH_MAP_H 260
+#endif
+
+// 统计窗口长度（ms），每个窗口打印一次汇总表后清零
+#ifndef HUD_BENCH_REPORT_MS
+#define HUD_BENCH_REPORT_MS 10000
+#endif
+
+// 启动后先跑这么久再开始统计（跳过首帧、静态层合成等一次性开销）
+#ifndef HUD_BENCH_WARMUP_MS
+#define HUD_BENCH_WARMUP_MS 3000
+#endif
+
+#define BENCH_MAP_BUFS 2
+#define BENCH_SNAP_BYTES 26
+
+extern "C" {
+
+/* ---------- 合成快照 ---------- */
+
+static void put16(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, v);
+    put16(p + 2, v >> 16);
+}
+
+// 第 n 帧：转速 4s 一个来回扫过 800..7000，车速跟着转速走，里程、时间照常累加
+static void make_snapshot(uint8_t *d, uint32_t n)
+{
+    const uint32_t t = n * 1000u / HUD_BENCH_MSG_HZ;
+    const uint32_t phase = t % 4000u;
+    const uint32_t rpm = 800u + (phase < 2000u ? phase : 4000u - phase) * 6200u / 2000u;
+
+    memset(d, 0, BENCH_SNAP_BYTES);
+    put16(d + 0, rpm / 60u);                 // speed_kmh
+    put16(d + 2, rpm);                       // rpm
+    put32(d + 4, 123456000u + t / 40u);      // odo_m
+    put32(d + 8, t / 40u);                   // trip_odo_m
+    put16(d + 12, (uint16_t)235);            // 23.5°C
+    put16(d + 14, (uint16_t)228);
+    put16(d + 16, 12600u + (t / 100u) % 200u);
+    put16(d + 18, (t / 60000u) % 1440u);
+    put16(d + 20, t / 60000u);
+    put16(d + 22, 420u - (t / 10000u) % 400u);
+    put16(d + 24, 550u);
+}
+
+/* ---------- 合成地图 ---------- */
+
+static uint8_t *s_map_buf[BENCH_MAP_BUFS];
+static volatile bool s_map_busy[BENCH_MAP_BUFS];
+static const size_t s_map_bytes = sizeof(r565_hdr_t) + (size_t)HUD_BENCH_MAP_W * HUD_BENCH_MAP_H * 2;
+
+static void map_release(int token)
+{
+    if (token >= 0 && token < BENCH_MAP_BUFS) {
+        s_map_busy[token] = false;
+    }
+}
+
+// 斜条纹随帧号平移：每张都和上一张不同，解码与整图重绘都跑满
+static void make_map(uint8_t *buf, uint32_t n)
+{
+    r565_hdr_t h = {};
+    h.magic = R565_MAGIC;
+    h.w = HUD_BENCH_MAP_W;
+    h.h = HUD_BENCH_MAP_H;
+    h.codec = R565_CODEC_RAW;
+    h.raw_len = (uint32_t)HUD_BENCH_MAP_W * HUD_BENCH_MAP_H * 2;
+    memcpy(buf, &h, sizeof(h));
+
+    uint8_t *p = buf + sizeof(h);
+    const uint16_t c0 = 0x2104, c1 = (uint16_t)(0x8410 + (n & 7) * 0x0841);
+    for (uint32_t y = 0; y < HUD_BENCH_MAP_H; y++) {
+        for (uint32_t x = 0; x < HUD_BENCH_MAP_W; x++) {
+            const uint16_t c = ((x + y + n * 8) & 32) ? c1 : c0;
+            *p++ = (uint8_t)c;
+            *p++ = (uint8_t)(c >> 8);
+        }
+    }
+}
+
+// 有空闲缓冲就生成并送一张；两张都还没被显示/释放时跳过，返回 false
+static bool send_map(uint32_t n)
+{
+    for (int i = 0; i < BENCH_MAP_BUFS; i++) {
+        if (!s_map_buf[i] || s_map_busy[i]) continue;
+        make_map(s_map_buf[i], n);
+        s_map_busy[i] = true;
+        ui_request_set_r565(s_map_buf[i], s_map_bytes, i, map_release);
+        return true;
+    }
+    return false;
+}
+
+/* ---------- 汇总表 ---------- */
+
+typedef struct {
+    hud_perf_metric_t m;
+    const char *name;
+} bench_metric_t;
+
+static const bench_metric_t k_metrics[] = {
+    {HUD_PERF_RENDER, "render"},
+    {HUD_PERF_FLUSH, "flush"},
+    {HUD_PERF_TIMER, "lv_timer"},
+    {HUD_PERF_REQUEST_TO_APPLY, "request->apply"},
+    {HUD_PERF_APPLY_TO_FLUSH, "apply->flush"},
+    {HUD_PERF_IMG_DECODE, "img_decode"},
+};
+
+static hud_taskmon_report_t s_tasks; // 只在 bench 线程里用，不占栈
+
+typedef struct {
+    uint32_t t0_ms;
+    hud_taskmon_mark_t cpu; // 各核/各任务 CPU 窗口（main 打开了 idle 钩子估算，见 hud_taskmon.h）
+    uint32_t snaps;
+    uint32_t maps;
+    uint32_t maps_skipped;
+    uint32_t img_replaced;
+} bench_window_t;
+
+static void window_begin(bench_window_t *w)
+{
+    ui_bridge_stats_t bs;
+    ui_bridge_get_stats(&bs);
+    memset(w, 0, sizeof(*w));
+    w->t0_ms = millis();
+    w->img_replaced = bs.img_replaced;
+    hud_taskmon_sample(&w->cpu, &s_tasks);
+    hud_perf_reset();
+}
+
+static void report(bench_window_t *w)
+{
+    const uint32_t ms = millis() - w->t0_ms;
+    hud_perf_summary_t s;
+    hud_perf_get(HUD_PERF_RENDER, &s);
+    const uint32_t fps10 = ms ? (uint32_t)((uint64_t)s.count * 10000u / ms) : 0;
+
+    Serial0.printf("[BENCH] ---- %u.%u s window, %u.%u fps, %u snapshots, %u maps (%u skipped) ----\n",
+                   (unsigned)(ms / 1000), (unsigned)(ms % 1000 / 100), (unsigned)(fps10 / 10),
+                   (unsigned)(fps10 % 10), (unsigned)w->snaps, (unsigned)w->maps, (unsigned)w->maps_skipped);
+    Serial0.printf("[BENCH] %-16s %7s %8s %8s %8s %8s  (us)\n", "metric", "count", "avg", "p50", "p99", "max");
+    for (size_t i = 0; i < sizeof(k_metrics) / sizeof(k_metrics[0]); i++) {
+        hud_perf_get(k_metrics[i].m, &s);
+        Serial0.printf("[BENCH] %-16s %7u %8u %8u %8u %8u\n", k_metrics[i].name, (unsigned)s.count,
+                       (unsigned)s.avg_us, (unsigned)s.p50_us, (unsigned)s.p99_us, (unsigned)s.max_us);
+    }
+
+    Serial0.printf("[BENCH] heap internal free %u min %u largest %u | psram free %u min %u\n",
+                   (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                   (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+                   (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+                   (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+                   (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+    hud_lv_mem_stats_t ms;
+    hud_lv_mem_get_stats(&ms);
+    if (ms.arena_size) {
+        Serial0.printf("[BENCH] lvgl arena %u free %u min %u largest %u | %u allocs, %u did not fit\n",
+                       (unsigned)ms.arena_size, (unsigned)ms.arena_free, (unsigned)ms.arena_min_free,
+                       (unsigned)ms.arena_largest, (unsigned)ms.arena_allocs, (unsigned)ms.arena_full);
+    }
+
+    hud_taskmon_sample(&w->cpu, &s_tasks);
+    Serial0.printf("[BENCH] cpu");
+    for (int c = 0; c < s_tasks.ncores; c++) {
+        if (s_tasks.core_busy[c] == HUD_TASKMON_UNKNOWN) {
+            Serial0.printf(" core%d -", c);
+        } else {
+            Serial0.printf(" core%d %u%%", c, (unsigned)s_tasks.core_busy[c]);
+        }
+    }
+    ui_bridge_stats_t bs;
+    ui_bridge_get_stats(&bs);
+    Serial0.printf(" | maps replaced before shown %u\n", (unsigned)(bs.img_replaced - w->img_replaced));
+
+    // 满负荷下的栈余量：缩栈前看这一行
+    Serial0.printf("[BENCH] stack free");
+    for (int i = 0; i < s_tasks.ntasks; i++) {
+        const hud_taskmon_task_t *t = &s_tasks.task[i];
+        Serial0.printf(" %.11s %u", t->name, (unsigned)t->stack_free);
+        if (t->cpu_pct != HUD_TASKMON_UNKNOWN) {
+            Serial0.printf("(%u%%)", (unsigned)t->cpu_pct);
+        }
+    }
+    Serial0.printf("\n");
+}
+
+/* ---------- 驱动线程 ---------- */
+
+static void bench_task(void *param)
+{
+    (void)param;
+    TickType_t period = pdMS_TO_TICKS(1000 / HUD_BENCH_MSG_HZ);
+    if (period == 0) period = 1;
+    const uint32_t start = millis();
+    uint8_t snap[BENCH_SNAP_BYTES];
+    bench_window_t win;
+    bool counting = false;
+    uint32_t n = 0, map_n = 0, last_map = start;
+
+    window_begin(&win);
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        make_snapshot(snap, n);
+        ui_request_msg(snap, sizeof(snap), n);
+        n++;
+        win.snaps++;
+
+        const uint32_t now = millis();
+        if (HUD_BENCH_MAP_PERIOD_MS > 0 && (uint32_t)(now - last_map) >= HUD_BENCH_MAP_PERIOD_MS) {
+            last_map = now;
+            if (send_map(map_n++)) {
+                win.maps++;
+            } else {
+                win.maps_skipped++;
+            }
+        }
+
+        if (!counting && (uint32_t)(now - start) >= HUD_BENCH_WARMUP_MS) {
+            counting = true;
+            window_begin(&win);
+        } else if (counting && (uint32_t)(now - win.t0_ms) >= HUD_BENCH_REPORT_MS) {
+            report(&win);
+            window_begin(&win);
+        }
+
+        vTaskDelayUntil(&wake, period);
+    }
+}
+
+bool hud_bench_start(void)
+{
+    for (int i = 0; i < BENCH_MAP_BUFS && HUD_BENCH_MAP_PERIOD_MS > 0; i++) {
+        s_map_buf[i] = (uint8_t *)heap_caps_malloc(s_map_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!s_map_buf[i]) {
+            Serial0.printf("[BENCH] map buffer %d allocation failed (%u bytes)\n", i, (unsigned)s_map_bytes);
+        }
+    }
+
+    // 默认与 app_task 同核、低一级优先级：和真实上位机数据走同一条 ui_bridge 路径
+    if (xTaskCreatePinnedToCore(bench_task, "bench", HUD_SCHED_BENCH_STACK, nullptr, HUD_SCHED_BENCH_PRIO, nullptr,
+                                HUD_SCHED_AFFINITY(HUD_SCHED_BENCH_CORE)) != pdPASS) {
+        Serial0.println("[BENCH] task creation failed");
+        return false;
+    }
+    Serial0.printf("[BENCH] %u Hz snapshots, %ux%u map every %u ms, report every %u ms\n",
+                   (unsigned)HUD_BENCH_MSG_HZ, (unsigned)HUD_BENCH_MAP_W, (unsigned)HUD_BENCH_MAP_H,
+                   (unsigned)HUD_BENCH_MAP_PERIOD_MS, (unsigned)HUD_BENCH_REPORT_MS);
+    return true;
+}
+
+} // extern "C"
+
+#else
+
+extern "C" bool hud_bench_start(void)
+{
+    return false;
+}
+
+#endif
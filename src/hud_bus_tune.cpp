@@ -0,0 +1,212 @@
+#include "hud_bus_tune.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_heap_caps.h>
+
+#include "PanelLan.h"
+
+// 回读校验用的小块：放在屏幕左上角，伪随机像素，每级换几种种子
+#define RB_W 64
+#define RB_H 16
+#define RB_ROUNDS 4
+
+static const char *NVS_NS = "hud_bus";
+
+static void nvs_key(PanelLan &tft, char *key, size_t n)
+{
+    snprintf(key, n, "hz_%s", PanelLan::boardName(tft.board()));
+}
+
+// 下一级：时钟源整数分频里不低于 cur*(1+STEP) 的最低频率；超过上限返回 0
+static uint32_t next_step(uint32_t src, uint32_t cur)
+{
+    const uint32_t want = cur + cur / 100 * HUD_BUS_TUNE_STEP_PCT;
+    const uint32_t div = src / want;
+    if (div == 0) {
+        return 0;
+    }
+    const uint32_t hz = src / div;
+    return hz > HUD_BUS_TUNE_MAX_HZ ? 0 : hz;
+}
+
+// 留余量：不高于 good*(1-MARGIN) 的最高可达频率，但不低于板子默认值
+static uint32_t with_margin(uint32_t src, uint32_t base, uint32_t good)
+{
+    if (good <= base) {
+        return base;
+    }
+    const uint32_t floor_hz = good - good / 100 * HUD_BUS_TUNE_MARGIN_PCT;
+    const uint32_t div = (src + floor_hz - 1) / floor_hz;
+    const uint32_t hz = src / div;
+    return hz > base ? hz : base;
+}
+
+static bool readback_ok(PanelLan &tft, uint16_t *wbuf, uint16_t *rbuf)
+{
+    uint32_t x = 0x9E3779B9u;
+    for (int round = 0; round < RB_ROUNDS; round++) {
+        x ^= (uint32_t)round * 0x85EBCA6Bu;
+        for (int i = 0; i < RB_W * RB_H; i++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            wbuf[i] = (uint16_t)x;
+        }
+        // 写读用同一种像素格式，panel 不做颜色转换；读时钟是 freq_read，不受标定影响
+        tft.pushImage(0, 0, RB_W, RB_H, (lgfx::swap565_t *)wbuf);
+        memset(rbuf, 0, RB_W * RB_H * sizeof(uint16_t));
+        tft.readRect(0, 0, RB_W, RB_H, (lgfx::swap565_t *)rbuf);
+        if (memcmp(wbuf, rbuf, RB_W * RB_H * sizeof(uint16_t)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 整屏测试图样：上 1/4 色条，中间 1px 黑白棋盘（时钟不稳时最先出现错位、花点），下面三色渐变
+static void draw_pattern(PanelLan &tft, uint32_t hz)
+{
+    static const uint16_t bars[8] = {0xFFFF, 0xFFE0, 0x07FF, 0x07E0, 0xF81F, 0xF800, 0x001F, 0x0000};
+    const int32_t w = tft.width();
+    const int32_t h = tft.height();
+
+    tft.startWrite();
+    for (int i = 0; i < 8; i++) {
+        tft.fillRect(i * w / 8, 0, (i + 1) * w / 8 - i * w / 8, h / 4, bars[i]);
+    }
+    for (int32_t y = h / 4; y < h / 2; y++) {
+        for (int32_t x = 0; x < w; x++) {
+            tft.writePixel(x, y, (uint16_t)(((x ^ y) & 1) ? 0xFFFF : 0x0000));
+        }
+    }
+    const int32_t gh = h / 8;
+    for (int32_t x = 0; x < w; x += 2) {
+        const uint8_t v = (uint8_t)(x * 255 / w);
+        tft.fillRect(x, h / 2, 2, gh, tft.color565(v, 0, 0));
+        tft.fillRect(x, h / 2 + gh, 2, gh, tft.color565(0, v, 0));
+        tft.fillRect(x, h / 2 + 2 * gh, 2, gh, tft.color565(0, 0, v));
+    }
+    tft.fillRect(0, h / 2 + 3 * gh, w, h - (h / 2 + 3 * gh), 0x0000);
+    tft.endWrite();
+
+    char msg[48];
+    snprintf(msg, sizeof(msg), "%u kHz: tap if clean", (unsigned)(hz / 1000));
+    tft.setTextSize(2);
+    tft.setTextColor(0xFFFF, 0x0000);
+    tft.drawString(msg, (w - tft.textWidth(msg)) / 2, h - gh / 2 - tft.fontHeight() / 2);
+}
+
+static bool touch_confirm(PanelLan &tft, uint32_t hz)
+{
+    draw_pattern(tft, hz);
+    uint16_t x, y;
+    // 先等手离开，上一级的点击不算
+    while (tft.getTouch(&x, &y)) {
+        delay(10);
+    }
+    const uint32_t t0 = millis();
+    while (millis() - t0 < HUD_BUS_TUNE_CONFIRM_MS) {
+        if (tft.getTouch(&x, &y)) {
+            return true;
+        }
+        delay(20);
+    }
+    return false;
+}
+
+// 失败的一级可能把命令字节也写花了：回到可靠频率后重新走一遍面板初始化序列
+static void recover(PanelLan &tft, uint32_t hz)
+{
+    tft.setBusFreq(hz);
+    tft.getPanel()->init(false);
+    tft.setRotation(tft.getRotation());
+    tft.fillScreen(0x0000);
+}
+
+static uint32_t calibrate(PanelLan &tft, uint32_t base, uint32_t src)
+{
+    uint16_t *wbuf = (uint16_t *)heap_caps_malloc(2 * RB_W * RB_H * sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    uint16_t *rbuf = wbuf ? wbuf + RB_W * RB_H : nullptr;
+    const bool readback = wbuf && readback_ok(tft, wbuf, rbuf);
+    const bool touch = tft.touch() != nullptr;
+    if (!readback && !touch) {
+        Serial0.println("[BUS] no readback and no touch, keep the board default clock");
+        heap_caps_free(wbuf);
+        return 0;
+    }
+    Serial0.printf("[BUS] calibrating %s from %u kHz (%s)\n", PanelLan::boardName(tft.board()),
+                   (unsigned)(base / 1000), readback ? "readback" : "touch confirm");
+
+    uint32_t good = base;
+    for (uint32_t hz = next_step(src, base); hz; hz = next_step(src, hz)) {
+        if (!tft.setBusFreq(hz)) {
+            break;
+        }
+        const uint32_t t0 = micros();
+        tft.fillScreen(0x0000);
+        const uint32_t fill_us = micros() - t0;
+        const bool ok = readback ? readback_ok(tft, wbuf, rbuf) : touch_confirm(tft, hz);
+        Serial0.printf("[BUS] %u kHz: %s, full screen fill %u us\n", (unsigned)(hz / 1000),
+                       ok ? "ok" : "FAIL", (unsigned)fill_us);
+        if (!ok) {
+            break;
+        }
+        good = hz;
+    }
+    heap_caps_free(wbuf);
+
+    const uint32_t keep = with_margin(src, base, good);
+    recover(tft, keep);
+    Serial0.printf("[BUS] fastest ok %u kHz, keeping %u kHz\n", (unsigned)(good / 1000), (unsigned)(keep / 1000));
+    return keep;
+}
+
+uint32_t hud_bus_tune(PanelLan &tft)
+{
+    const uint32_t base = tft.busFreq();
+    const uint32_t src = tft.busClockSource();
+    if (base == 0 || src == 0) {
+        return base;  // RGB 面板
+    }
+
+    char key[16];
+    nvs_key(tft, key, sizeof(key));
+    Preferences prefs;
+    if (!prefs.begin(NVS_NS, false)) {
+        return base;
+    }
+
+    const uint32_t stored = prefs.getUInt(key, 0);
+    uint32_t hz = base;
+    if (stored && HUD_BUS_TUNE < 2) {
+        if (stored == base || tft.setBusFreq(stored)) {
+            hz = stored;
+        } else {
+            recover(tft, base);
+        }
+        Serial0.printf("[BUS] %s write clock %u kHz (stored)\n", PanelLan::boardName(tft.board()), (unsigned)(hz / 1000));
+    } else if (HUD_BUS_TUNE > 0) {
+        const uint32_t best = calibrate(tft, base, src);
+        if (best) {
+            prefs.putUInt(key, best);
+            hz = best;
+        }
+    }
+    prefs.end();
+    return hz;
+}
+
+void hud_bus_tune_forget(PanelLan &tft)
+{
+    char key[16];
+    nvs_key(tft, key, sizeof(key));
+    Preferences prefs;
+    if (prefs.begin(NVS_NS, false)) {
+        prefs.remove(key);
+        prefs.end();
+    }
+}
@@ -0,0 +1,187 @@
+#include "hud_dma_copy.h"
+#include <stdint.h>
+#include <string.h>
+
+#if __has_include("esp_async_memcpy.h")
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_async_memcpy.h"
+#include "sdkconfig.h"
+#if __has_include("esp_memory_utils.h")
+#include "esp_memory_utils.h"
+#else
+#include "soc/soc_memory_layout.h"
+#endif
+#define HAVE_GDMA 1
+#else
+#define HAVE_GDMA 0
+#endif
+
+/* PSRAM endpoints need explicit cache maintenance; without a way to do it only internal RAM
+   is handed to the engine */
+#if HAVE_GDMA && __has_include("esp_cache.h")
+#include "esp_cache.h"
+#define PSRAM_DMA 1
+#define CACHE_IDF5 1
+#elif HAVE_GDMA && defined(CONFIG_IDF_TARGET_ESP32S3) && defined(CONFIG_SPIRAM)
+#include "esp32s3/rom/cache.h"
+#define PSRAM_DMA 1
+#define CACHE_IDF5 0
+#else
+#define PSRAM_DMA 0
+#endif
+
+#define BURST_ALIGN 16            /* GDMA address/size alignment for external memory (psram_trans_align) */
+#define LINE HUD_DMA_COPY_ALIGN   /* >= data cache line: invalidating whole lines never drops neighbours */
+
+/* Updated from several tasks; plain counters are good enough for a diagnostic. */
+static hud_dma_copy_stats_t s_stats;
+
+#if HAVE_GDMA
+_Static_assert(sizeof(StaticSemaphore_t) <= sizeof(((hud_dma_job_t *)0)->sem_storage),
+               "hud_dma_job_t::sem_storage too small");
+
+static async_memcpy_t s_drv;
+
+#if PSRAM_DMA
+static void cache_writeback(const void *p, size_t n)
+{
+#if CACHE_IDF5
+    esp_cache_msync((void *)p, n, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+#else
+    Cache_WriteBack_Addr((uint32_t)(uintptr_t)p, (uint32_t)n);
+#endif
+}
+
+static void cache_invalidate(void *p, size_t n)
+{
+#if CACHE_IDF5
+    esp_cache_msync(p, n, ESP_CACHE_MSYNC_FLAG_DIR_M2C);
+#else
+    Cache_Invalidate_Addr((uint32_t)(uintptr_t)p, (uint32_t)n);
+#endif
+}
+#endif
+
+/* can the engine reach this buffer (flash-mapped rodata and, without cache helpers, PSRAM can't) */
+static bool reachable(const void *p, bool *ext)
+{
+    *ext = esp_ptr_external_ram(p);
+    if (*ext)
+        return PSRAM_DMA;
+    return esp_ptr_dma_capable(p);
+}
+
+static bool IRAM_ATTR on_isr(async_memcpy_t drv, async_memcpy_event_t *ev, void *arg)
+{
+    (void)drv;
+    (void)ev;
+    hud_dma_job_t *job = (hud_dma_job_t *)arg;
+    /* the waiter may return (and its job go out of scope) as soon as the semaphore is given */
+    const hud_dma_done_cb_t cb = job->on_done;
+    void *cb_arg = job->on_done_arg;
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR((SemaphoreHandle_t)job->sem, &woken);
+    const bool more = cb && cb(cb_arg);
+    return woken == pdTRUE || more;
+}
+#endif
+
+bool hud_dma_copy_init(void)
+{
+#if HAVE_GDMA
+    if (s_drv)
+        return true;
+    async_memcpy_config_t cfg = ASYNC_MEMCPY_DEFAULT_CONFIG();
+#if PSRAM_DMA
+    cfg.psram_trans_align = BURST_ALIGN;
+#endif
+    if (esp_async_memcpy_install(&cfg, &s_drv) != ESP_OK)
+    {
+        s_drv = NULL;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool hud_dma_copy_begin(hud_dma_job_t *job, void *dst, const void *src, size_t n)
+{
+    job->dst = (uint8_t *)dst;
+    job->src = (const uint8_t *)src;
+    job->n = n;
+    job->dma_off = 0;
+    job->dma_len = 0;
+
+#if HAVE_GDMA
+    /* engine part: destination starts on a line boundary and covers whole lines,
+       source shares the burst alignment */
+    const uintptr_t d = (uintptr_t)dst;
+    const size_t off = (LINE - (d & (LINE - 1))) & (LINE - 1);
+    const size_t len = off < n ? (n - off) & ~(size_t)(LINE - 1) : 0;
+    bool ext_s = false, ext_d = false;
+    if (s_drv && len >= HUD_DMA_COPY_MIN && ((d ^ (uintptr_t)src) & (BURST_ALIGN - 1)) == 0 &&
+        reachable(job->src + off, &ext_s) && reachable(job->dst + off, &ext_d))
+    {
+#if PSRAM_DMA
+        if (ext_s)
+            cache_writeback(job->src + off, len);
+        if (ext_d)
+            cache_invalidate(job->dst + off, len); /* no dirty line may land on top of the DMA data later */
+#endif
+        job->sem = xSemaphoreCreateBinaryStatic((StaticSemaphore_t *)job->sem_storage);
+        if (esp_async_memcpy(s_drv, job->dst + off, (void *)(job->src + off), len, on_isr, job) == ESP_OK)
+        {
+            job->dma_off = off;
+            job->dma_len = len;
+            s_stats.dma_copies++;
+            s_stats.dma_bytes += len;
+            /* head and tail on the CPU while the engine runs: they never share a line with it */
+            memcpy(job->dst, job->src, off);
+            memcpy(job->dst + off + len, job->src + off + len, n - off - len);
+            return true;
+        }
+        vSemaphoreDelete((SemaphoreHandle_t)job->sem);
+    }
+#endif
+
+    s_stats.cpu_copies++;
+    memcpy(dst, src, n);
+    return false;
+}
+
+void hud_dma_copy_end(hud_dma_job_t *job)
+{
+#if HAVE_GDMA
+    if (!job->dma_len)
+        return;
+    xSemaphoreTake((SemaphoreHandle_t)job->sem, portMAX_DELAY);
+    vSemaphoreDelete((SemaphoreHandle_t)job->sem);
+#if PSRAM_DMA
+    /* lines the CPU may have speculatively refilled while the engine was writing */
+    if (esp_ptr_external_ram(job->dst + job->dma_off))
+        cache_invalidate(job->dst + job->dma_off, job->dma_len);
+#endif
+    job->dma_len = 0;
+#else
+    (void)job;
+#endif
+}
+
+void hud_dma_copy(void *dst, const void *src, size_t n)
+{
+    hud_dma_job_t job;
+    job.on_done = NULL;
+    job.on_done_arg = NULL;
+    if (hud_dma_copy_begin(&job, dst, src, n))
+        hud_dma_copy_end(&job);
+}
+
+void hud_dma_copy_get_stats(hud_dma_copy_stats_t *out)
+{
+    if (out)
+        *out = s_stats;
+}
@@ -0,0 +1,161 @@
+#include "hud_draw_accel.h"
+
+#include <string.h>
+#include <lvgl.h>
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+// 0：即使在 S3 上也不用 PIE 指令（对照测试用）
+#ifndef HUD_DRAW_PIE
+#define HUD_DRAW_PIE 1
+#endif
+
+#if HUD_DRAW_PIE && defined(CONFIG_IDF_TARGET_ESP32S3) && LV_COLOR_DEPTH == 16
+#define USE_PIE 1
+#else
+#define USE_PIE 0
+#endif
+
+extern "C" {
+
+static hud_draw_accel_stats_t s_stats;
+
+#if USE_PIE
+/* --- PIE 内核：地址须 16 字节对齐（EE.VLD/VST.128 会忽略低 4 位）--- */
+
+// 从 pat（16 字节对齐的 8 个像素）重复写 blocks 个 16 字节块
+static inline void pie_fill_blocks(void *dst, const void *pat, uint32_t blocks)
+{
+    asm volatile(
+        "ee.vld.128.ip q0, %[p], 0      \n"
+        "loopnez %[n], 1f               \n"
+        "ee.vst.128.ip q0, %[d], 16     \n"
+        "1:                             \n"
+        : [d] "+r"(dst)
+        : [p] "r"(pat), [n] "r"(blocks)
+        : "memory");
+}
+
+static inline void pie_copy_blocks(void *dst, const void *src, uint32_t blocks)
+{
+    asm volatile(
+        "loopnez %[n], 1f               \n"
+        "ee.vld.128.ip q0, %[s], 16     \n"
+        "ee.vst.128.ip q0, %[d], 16     \n"
+        "1:                             \n"
+        : [d] "+r"(dst), [s] "+r"(src)
+        : [n] "r"(blocks)
+        : "memory");
+}
+#endif
+
+// 一行纯色：先逐像素写到 16 字节边界，中间整块向量写，尾部（或无 PIE 时整行）用 lv_color_fill
+static void fill_row(lv_color_t *d, lv_color_t c, int32_t w, const uint16_t *pat)
+{
+#if USE_PIE
+    while (w > 0 && ((uintptr_t)d & 15)) {
+        *d++ = c;
+        w--;
+    }
+    const uint32_t blocks = (uint32_t)w >> 3;
+    if (blocks) {
+        pie_fill_blocks(d, pat, blocks);
+        d += blocks << 3;
+        w -= (int32_t)(blocks << 3);
+    }
+#else
+    (void)pat;
+#endif
+    if (w > 0) lv_color_fill(d, c, (uint32_t)w);
+}
+
+// 一行拷贝：源与目标对 16 取模相同时走向量，否则交给 memcpy
+static void copy_row(lv_color_t *d, const lv_color_t *s, int32_t w)
+{
+#if USE_PIE
+    if ((((uintptr_t)d ^ (uintptr_t)s) & 15) == 0) {
+        while (w > 0 && ((uintptr_t)d & 15)) {
+            *d++ = *s++;
+            w--;
+        }
+        const uint32_t blocks = (uint32_t)w >> 3;
+        if (blocks) {
+            pie_copy_blocks(d, s, blocks);
+            d += blocks << 3;
+            s += blocks << 3;
+            w -= (int32_t)(blocks << 3);
+        }
+    }
+#endif
+    if (w > 0) memcpy(d, s, (size_t)w * sizeof(lv_color_t));
+}
+
+static void accel_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    if (dsc->opa <= LV_OPA_MIN) return;
+    if (dsc->mask_buf && dsc->mask_res == LV_DRAW_MASK_RES_TRANSP) return;
+
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    const bool simple = dsc->opa >= LV_OPA_MAX &&
+                        (!dsc->mask_buf || dsc->mask_res == LV_DRAW_MASK_RES_FULL_COVER) &&
+                        dsc->blend_mode == LV_BLEND_MODE_NORMAL &&
+                        disp && !disp->driver->set_px_cb && !disp->driver->screen_transp;
+    if (!simple) {
+        s_stats.fallback++;
+        lv_draw_sw_blend_basic(draw_ctx, dsc);
+        return;
+    }
+
+    lv_area_t a;
+    if (!_lv_area_intersect(&a, dsc->blend_area, draw_ctx->clip_area)) return;
+
+    const int32_t w = lv_area_get_width(&a);
+    const int32_t h = lv_area_get_height(&a);
+    const int32_t dst_stride = lv_area_get_width(draw_ctx->buf_area);
+    lv_color_t *d = (lv_color_t *)draw_ctx->buf +
+                    (size_t)dst_stride * (a.y1 - draw_ctx->buf_area->y1) + (a.x1 - draw_ctx->buf_area->x1);
+
+    if (!dsc->src_buf) {
+        alignas(16) uint16_t pat[8];
+        for (int i = 0; i < 8; i++) pat[i] = dsc->color.full;
+        if (w == dst_stride) {
+            fill_row(d, dsc->color, w * h, pat);   // 整行宽：一次填完
+        } else {
+            for (int32_t y = 0; y < h; y++, d += dst_stride) fill_row(d, dsc->color, w, pat);
+        }
+        s_stats.fill_px += (uint32_t)(w * h);
+        return;
+    }
+
+    const int32_t src_stride = lv_area_get_width(dsc->blend_area);
+    const lv_color_t *s = dsc->src_buf + (size_t)src_stride * (a.y1 - dsc->blend_area->y1) +
+                          (a.x1 - dsc->blend_area->x1);
+    if (w == dst_stride && w == src_stride) {
+        copy_row(d, s, w * h);
+    } else {
+        for (int32_t y = 0; y < h; y++, d += dst_stride, s += src_stride) copy_row(d, s, w);
+    }
+    s_stats.copy_px += (uint32_t)(w * h);
+}
+
+static void accel_ctx_init(lv_disp_drv_t *drv, lv_draw_ctx_t *draw_ctx)
+{
+    lv_draw_sw_init_ctx(drv, draw_ctx);
+    ((lv_draw_sw_ctx_t *)draw_ctx)->blend = accel_blend;
+}
+
+void hud_draw_accel_install(lv_disp_drv_t *drv)
+{
+    if (!drv) return;
+    drv->draw_ctx_init = accel_ctx_init;
+    drv->draw_ctx_deinit = lv_draw_sw_deinit_ctx;
+    drv->draw_ctx_size = sizeof(lv_draw_sw_ctx_t);
+}
+
+void hud_draw_accel_get_stats(hud_draw_accel_stats_t *out)
+{
+    if (out) *out = s_stats;
+}
+
+} // extern "C"
@@ -0,0 +1,101 @@
+#include "hud_heapmon.h"
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+typedef struct
+{
+    uint32_t t_s;
+    uint32_t largest[2]; /* internal, psram */
+} heapmon_point_t;
+
+static heapmon_point_t s_hist[HUD_HEAPMON_HISTORY];
+static int s_hist_n;
+static int s_hist_head; /* oldest point */
+static uint32_t s_hist_last_ms;
+static uint32_t s_samples;
+static uint32_t s_largest_min[2] = {UINT32_MAX, UINT32_MAX};
+static int32_t s_trend[2];
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* Least-squares slope of the largest block over the history, in bytes per hour. x is seconds
+   since the oldest point (<= a few days), y < 2^24 on this chip, so the sums fit in int64;
+   runs once per history point, so the final division can be in double. */
+static int32_t trend_of(int region)
+{
+    if (s_hist_n < 2)
+        return 0;
+    const uint32_t t0 = s_hist[s_hist_head].t_s;
+    int64_t sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (int i = 0; i < s_hist_n; i++)
+    {
+        const heapmon_point_t *p = &s_hist[(s_hist_head + i) % HUD_HEAPMON_HISTORY];
+        const int64_t x = (int64_t)(p->t_s - t0);
+        const int64_t y = (int64_t)p->largest[region];
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    const int64_t n = s_hist_n;
+    const int64_t den = n * sxx - sx * sx;
+    if (den == 0)
+        return 0;
+    return (int32_t)((double)(n * sxy - sx * sy) * 3600.0 / (double)den);
+}
+
+static void fill(hud_heapmon_region_t *r, uint32_t caps, int region)
+{
+    r->free = (uint32_t)heap_caps_get_free_size(caps);
+    r->min_free = (uint32_t)heap_caps_get_minimum_free_size(caps);
+    r->largest = (uint32_t)heap_caps_get_largest_free_block(caps);
+    if (r->largest < s_largest_min[region])
+        s_largest_min[region] = r->largest;
+    r->largest_min = s_largest_min[region];
+}
+
+void hud_heapmon_sample(hud_heapmon_report_t *out)
+{
+    hud_heapmon_report_t r;
+    memset(&r, 0, sizeof(r));
+    fill(&r.internal, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, 0);
+    fill(&r.psram, MALLOC_CAP_SPIRAM, 1);
+    s_samples++;
+
+    const uint32_t now = now_ms();
+    if (s_hist_n == 0 || (uint32_t)(now - s_hist_last_ms) >= HUD_HEAPMON_HISTORY_MS)
+    {
+        s_hist_last_ms = now;
+        heapmon_point_t *p;
+        if (s_hist_n < HUD_HEAPMON_HISTORY)
+        {
+            p = &s_hist[(s_hist_head + s_hist_n) % HUD_HEAPMON_HISTORY];
+            s_hist_n++;
+        }
+        else
+        {
+            p = &s_hist[s_hist_head];
+            s_hist_head = (s_hist_head + 1) % HUD_HEAPMON_HISTORY;
+        }
+        p->t_s = now / 1000;
+        p->largest[0] = r.internal.largest;
+        p->largest[1] = r.psram.largest;
+        s_trend[0] = trend_of(0);
+        s_trend[1] = trend_of(1);
+    }
+
+    r.internal.largest_trend = s_trend[0];
+    r.psram.largest_trend = s_trend[1];
+    r.samples = s_samples;
+    if (s_hist_n >= 2)
+    {
+        const heapmon_point_t *last = &s_hist[(s_hist_head + s_hist_n - 1) % HUD_HEAPMON_HISTORY];
+        r.window_ms = (last->t_s - s_hist[s_hist_head].t_s) * 1000u;
+    }
+    *out = r;
+}
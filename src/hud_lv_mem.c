@@ -0,0 +1,183 @@
+#include "hud_lv_mem.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if __has_include("esp_heap_caps.h")
+#include "esp_heap_caps.h"
+#include "multi_heap.h"
+#include "freertos/FreeRTOS.h"
+#define HAVE_HEAP_CAPS 1
+#else
+#define HAVE_HEAP_CAPS 0
+#endif
+
+/* Updated from whatever task runs LVGL; plain counters are good enough for a diagnostic. */
+static hud_lv_mem_stats_t s_stats;
+
+#if HAVE_HEAP_CAPS
+#define CAPS_INTERNAL (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define CAPS_PSRAM (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+
+static bool want_internal(size_t n)
+{
+    return n <= HUD_LV_MEM_INTERNAL_MAX &&
+           heap_caps_get_free_size(CAPS_INTERNAL) > HUD_LV_MEM_INTERNAL_RESERVE + n;
+}
+
+static void *sys_malloc(size_t n)
+{
+    const bool internal = want_internal(n);
+    void *p = heap_caps_malloc(n, internal ? CAPS_INTERNAL : CAPS_PSRAM);
+    if (p)
+    {
+        if (internal)
+            s_stats.internal_allocs++;
+        else
+            s_stats.psram_allocs++;
+        return p;
+    }
+    /* no PSRAM on this board, or the preferred region is exhausted */
+    p = heap_caps_malloc(n, MALLOC_CAP_8BIT);
+    if (p)
+        s_stats.fallback_allocs++;
+    return p;
+}
+
+#if HUD_LV_MEM_ARENA > 0
+/* .bss is internal DRAM; the heap handle lives at the start of the region */
+static uint8_t s_arena[HUD_LV_MEM_ARENA] __attribute__((aligned(8)));
+static multi_heap_handle_t s_heap = NULL;
+/* LVGL runs on one task, but lodepng/snapshot helpers may be called elsewhere; TLSF ops are short */
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool in_arena(const void *p)
+{
+    return (const uint8_t *)p >= s_arena && (const uint8_t *)p < s_arena + sizeof(s_arena);
+}
+
+static void *arena_malloc(size_t n)
+{
+    if (n > HUD_LV_MEM_INTERNAL_MAX)
+        return NULL;
+    portENTER_CRITICAL(&s_mux);
+    if (!s_heap)
+        s_heap = multi_heap_register(s_arena, sizeof(s_arena)); /* first lv_mem call is lv_init */
+    void *p = s_heap ? multi_heap_malloc(s_heap, n) : NULL;
+    portEXIT_CRITICAL(&s_mux);
+    if (p)
+        s_stats.arena_allocs++;
+    else
+        s_stats.arena_full++;
+    return p;
+}
+
+static void arena_free(void *p)
+{
+    portENTER_CRITICAL(&s_mux);
+    multi_heap_free(s_heap, p);
+    portEXIT_CRITICAL(&s_mux);
+}
+#else
+static bool in_arena(const void *p)
+{
+    (void)p;
+    return false;
+}
+
+static void *arena_malloc(size_t n)
+{
+    (void)n;
+    return NULL;
+}
+
+static void arena_free(void *p) { (void)p; }
+#endif
+#endif
+
+void *hud_lv_malloc(size_t n)
+{
+#if HAVE_HEAP_CAPS
+    void *p = arena_malloc(n);
+    return p ? p : sys_malloc(n);
+#else
+    return malloc(n);
+#endif
+}
+
+void *hud_lv_realloc(void *p, size_t n)
+{
+#if HAVE_HEAP_CAPS
+    if (!p)
+        return hud_lv_malloc(n);
+#if HUD_LV_MEM_ARENA > 0
+    if (in_arena(p))
+    {
+        if (n == 0)
+        {
+            arena_free(p);
+            return NULL;
+        }
+        void *q = NULL;
+        if (n <= HUD_LV_MEM_INTERNAL_MAX)
+        {
+            portENTER_CRITICAL(&s_mux);
+            q = multi_heap_realloc(s_heap, p, n);
+            portEXIT_CRITICAL(&s_mux);
+        }
+        if (q)
+            return q;
+        /* grew past the small-block limit or the arena is full: move it out */
+        portENTER_CRITICAL(&s_mux);
+        const size_t old = multi_heap_get_allocated_size(s_heap, p);
+        portEXIT_CRITICAL(&s_mux);
+        q = sys_malloc(n);
+        if (!q)
+            return NULL;
+        memcpy(q, p, old < n ? old : n);
+        arena_free(p);
+        return q;
+    }
+#endif
+    /* heap_caps_realloc moves the block between regions when the caps require it */
+    void *q = heap_caps_realloc(p, n, want_internal(n) ? CAPS_INTERNAL : CAPS_PSRAM);
+    if (q || n == 0)
+        return q;
+    return heap_caps_realloc(p, n, MALLOC_CAP_8BIT);
+#else
+    return realloc(p, n);
+#endif
+}
+
+void hud_lv_free(void *p)
+{
+#if HAVE_HEAP_CAPS
+    if (in_arena(p))
+        arena_free(p);
+    else
+        heap_caps_free(p);
+#else
+    free(p);
+#endif
+}
+
+void hud_lv_mem_get_stats(hud_lv_mem_stats_t *out)
+{
+    if (!out)
+        return;
+    *out = s_stats;
+#if HAVE_HEAP_CAPS && HUD_LV_MEM_ARENA > 0
+    if (s_heap)
+    {
+        multi_heap_info_t info;
+        /* walks the arena's blocks: diagnostics only */
+        portENTER_CRITICAL(&s_mux);
+        multi_heap_get_info(s_heap, &info);
+        portEXIT_CRITICAL(&s_mux);
+        out->arena_size = sizeof(s_arena);
+        out->arena_free = info.total_free_bytes;
+        out->arena_min_free = info.minimum_free_bytes;
+        out->arena_largest = info.largest_free_block;
+    }
+#endif
+}
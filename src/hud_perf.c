@@ -0,0 +1,252 @@
+#include "hud_perf.h"
+#include "hud_trace.h"
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+#if __has_include("esp_timer.h")
+#include "esp_timer.h"
+uint32_t hud_perf_now_us(void) { return (uint32_t)esp_timer_get_time(); }
+#else
+#include "freertos/task.h"
+uint32_t hud_perf_now_us(void) { return (uint32_t)xTaskGetTickCount() * portTICK_PERIOD_MS * 1000u; }
+#endif
+
+/* -------- Log-scale histogram --------
+   Values below 8 us get their own bucket, above that every power of two is split into 4
+   buckets (<= 12.5% error), which covers 0 .. 2^32 us in 124 buckets. */
+#define HIST_BUCKETS 124
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t bucket[HIST_BUCKETS];
+} hist_t;
+
+static int bucket_of(uint32_t v)
+{
+    if (v < 8)
+        return (int)v;
+    int msb = 31 - __builtin_clz(v);
+    return 8 + (msb - 3) * 4 + (int)((v >> (msb - 2)) & 3u);
+}
+
+/* value of the rank-th sample (1-based) inside bucket i, interpolated linearly */
+static uint32_t bucket_value(int i, uint32_t rank, uint32_t in_bucket)
+{
+    if (i < 8)
+        return (uint32_t)i;
+    int msb = (i - 8) / 4 + 3;
+    uint32_t sub = (uint32_t)((i - 8) % 4);
+    uint64_t lo = (uint64_t)(4u + sub) << (msb - 2);
+    uint64_t width = (uint64_t)1u << (msb - 2);
+    uint64_t v = lo + width * rank / (in_bucket + 1);
+    return v > 0xffffffffu ? 0xffffffffu : (uint32_t)v;
+}
+
+/* -------- Per-seq stage stamps -------- */
+#define TRACE_SLOTS 16
+
+typedef struct
+{
+    uint32_t seq;
+    uint8_t mask; /* stages stamped so far */
+    uint32_t t[HUD_PERF_STAGE_COUNT];
+} trace_t;
+
+static hist_t s_hist[HUD_PERF_METRIC_COUNT];
+static trace_t s_trace[TRACE_SLOTS];
+static int s_trace_next;
+static bool s_have_applied;
+static uint32_t s_applied_seq;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void hist_add(hist_t *h, uint32_t us)
+{
+    if (h->count == 0 || us < h->min)
+        h->min = us;
+    if (us > h->max)
+        h->max = us;
+    h->count++;
+    h->sum += us;
+    h->bucket[bucket_of(us)]++;
+}
+
+void hud_perf_record(hud_perf_metric_t m, uint32_t us)
+{
+    if ((unsigned)m >= HUD_PERF_METRIC_COUNT)
+        return;
+    HUD_TRACE(HUD_TR_METRIC + m, 0, us);
+    portENTER_CRITICAL(&s_mux);
+    hist_add(&s_hist[m], us);
+    portEXIT_CRITICAL(&s_mux);
+}
+
+/* caller holds s_mux */
+static void trace_finish(trace_t *t)
+{
+    static const struct
+    {
+        uint8_t from, to, metric;
+    } spans[] = {
+        {HUD_PERF_STAGE_HDR, HUD_PERF_STAGE_COMMIT, HUD_PERF_HDR_TO_COMMIT},
+        {HUD_PERF_STAGE_COMMIT, HUD_PERF_STAGE_REQUEST, HUD_PERF_COMMIT_TO_REQUEST},
+        {HUD_PERF_STAGE_REQUEST, HUD_PERF_STAGE_APPLY, HUD_PERF_REQUEST_TO_APPLY},
+        {HUD_PERF_STAGE_APPLY, HUD_PERF_STAGE_FLUSH, HUD_PERF_APPLY_TO_FLUSH},
+        {HUD_PERF_STAGE_HDR, HUD_PERF_STAGE_FLUSH, HUD_PERF_USB_TO_GLASS},
+    };
+    for (size_t i = 0; i < sizeof(spans) / sizeof(spans[0]); i++)
+    {
+        uint8_t need = (uint8_t)((1u << spans[i].from) | (1u << spans[i].to));
+        if ((t->mask & need) == need)
+            hist_add(&s_hist[spans[i].metric], t->t[spans[i].to] - t->t[spans[i].from]);
+    }
+    t->mask = 0;
+}
+
+void hud_perf_mark(uint32_t seq, hud_perf_stage_t stage)
+{
+    if ((unsigned)stage >= HUD_PERF_STAGE_COUNT)
+        return;
+    const uint32_t now = hud_perf_now_us();
+    HUD_TRACE(HUD_TR_STAGE + stage, seq, 0);
+
+    portENTER_CRITICAL(&s_mux);
+    trace_t *t = NULL;
+    for (int i = 0; i < TRACE_SLOTS; i++)
+    {
+        if (s_trace[i].mask && s_trace[i].seq == seq)
+        {
+            t = &s_trace[i];
+            break;
+        }
+    }
+    if (!t)
+    {
+        /* oldest slot goes; snapshots that were coalesced away never complete */
+        t = &s_trace[s_trace_next];
+        s_trace_next = (s_trace_next + 1) % TRACE_SLOTS;
+        t->seq = seq;
+        t->mask = 0;
+    }
+    t->t[stage] = now;
+    t->mask |= (uint8_t)(1u << stage);
+
+    if (stage == HUD_PERF_STAGE_APPLY)
+    {
+        s_applied_seq = seq;
+        s_have_applied = true;
+    }
+    else if (stage == HUD_PERF_STAGE_FLUSH)
+    {
+        trace_finish(t);
+    }
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void hud_perf_mark_flushed(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    bool have = s_have_applied;
+    uint32_t seq = s_applied_seq;
+    s_have_applied = false;
+    portEXIT_CRITICAL(&s_mux);
+    if (have)
+        hud_perf_mark(seq, HUD_PERF_STAGE_FLUSH);
+}
+
+void hud_perf_get(hud_perf_metric_t m, hud_perf_summary_t *out)
+{
+    if (!out)
+        return;
+    memset(out, 0, sizeof(*out));
+    if ((unsigned)m >= HUD_PERF_METRIC_COUNT)
+        return;
+
+    hist_t h;
+    portENTER_CRITICAL(&s_mux);
+    h = s_hist[m];
+    portEXIT_CRITICAL(&s_mux);
+    if (!h.count)
+        return;
+
+    out->count = h.count;
+    out->min_us = h.min;
+    out->max_us = h.max;
+    out->avg_us = (uint32_t)(h.sum / h.count);
+
+    const uint32_t r50 = (h.count + 1) / 2;
+    const uint32_t r99 = h.count - h.count / 100; /* rank of the 99th percentile sample */
+    uint32_t acc = 0;
+    bool got50 = false;
+    for (int i = 0; i < HIST_BUCKETS; i++)
+    {
+        const uint32_t before = acc;
+        acc += h.bucket[i];
+        if (!got50 && acc >= r50)
+        {
+            out->p50_us = bucket_value(i, r50 - before, h.bucket[i]);
+            got50 = true;
+        }
+        if (acc >= r99)
+        {
+            out->p99_us = bucket_value(i, r99 - before, h.bucket[i]);
+            break;
+        }
+    }
+    /* interpolation can overshoot the observed range */
+    if (out->p50_us < h.min)
+        out->p50_us = h.min;
+    if (out->p99_us > h.max)
+        out->p99_us = h.max;
+    if (out->p50_us > out->p99_us)
+        out->p50_us = out->p99_us;
+}
+
+void hud_perf_reset(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    memset(s_hist, 0, sizeof(s_hist));
+    memset(s_trace, 0, sizeof(s_trace));
+    s_have_applied = false;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+size_t hud_perf_serialize(uint8_t *dst, size_t cap)
+{
+    if (!dst || cap < HUD_PERF_WIRE_BYTES)
+        return 0;
+    uint8_t *p = dst;
+    *p++ = HUD_PERF_WIRE_VERSION;
+    *p++ = HUD_PERF_METRIC_COUNT;
+    *p++ = 0;
+    *p++ = 0;
+    for (int m = 0; m < HUD_PERF_METRIC_COUNT; m++)
+    {
+        hud_perf_summary_t s;
+        hud_perf_get((hud_perf_metric_t)m, &s);
+        *p++ = (uint8_t)m;
+        *p++ = 0;
+        *p++ = 0;
+        *p++ = 0;
+        p = put_u32(p, s.count);
+        p = put_u32(p, s.min_us);
+        p = put_u32(p, s.avg_us);
+        p = put_u32(p, s.p50_us);
+        p = put_u32(p, s.p99_us);
+        p = put_u32(p, s.max_us);
+    }
+    return (size_t)(p - dst);
+}
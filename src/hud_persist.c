@@ -0,0 +1,215 @@
+#include "hud_persist.h"
+#include <string.h>
+
+#if __has_include("esp_partition.h")
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+#define HAVE_PARTITION 1
+#else
+#define HAVE_PARTITION 0
+#endif
+
+#define SECTOR 4096
+#define WRITE_GAP_MS 40 /* same pacing as the tile cache writer: one cache-off window at a time */
+
+#define SNAP_MAGIC 0x50414E53u /* 'SNAP' */
+#define MAP_MAGIC 0x50414D4Cu  /* 'LMAP' */
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t crc;
+    uint8_t wire[HUD_PERSIST_SNAP_BYTES];
+} snap_rec_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t len;
+    uint32_t crc;
+    uint32_t rsv;
+} map_hdr_t;
+
+#if HAVE_PARTITION
+
+static uint32_t crc32(const uint8_t *d, size_t n) { return esp_rom_crc32_le(0, d, (uint32_t)n); }
+
+static const char *NVS_NS = "hud_persist";
+static const char *NVS_KEY = "snap";
+
+/* not cleared by the startup code: survives esp_restart, panics and the watchdog */
+static RTC_NOINIT_ATTR snap_rec_t s_rtc;
+static snap_rec_t s_nvs; /* what NVS holds, to skip identical writes */
+static bool s_nvs_valid = false;
+
+static const esp_partition_t *s_part = NULL;
+static map_hdr_t s_map; /* header of the saved map, magic 0 if none */
+
+static bool snap_ok(const snap_rec_t *r)
+{
+    return r->magic == SNAP_MAGIC && r->crc == crc32(r->wire, sizeof(r->wire));
+}
+
+static void load_nvs(void)
+{
+    nvs_handle_t h;
+    if (nvs_open(NVS_NS, NVS_READONLY, &h) != ESP_OK)
+        return;
+    size_t n = sizeof(s_nvs.wire);
+    if (nvs_get_blob(h, NVS_KEY, s_nvs.wire, &n) == ESP_OK && n == sizeof(s_nvs.wire))
+    {
+        s_nvs.magic = SNAP_MAGIC;
+        s_nvs.crc = crc32(s_nvs.wire, sizeof(s_nvs.wire));
+        s_nvs_valid = true;
+    }
+    nvs_close(h);
+}
+
+bool hud_persist_init(void)
+{
+    if (!snap_ok(&s_rtc))
+        memset(&s_rtc, 0, sizeof(s_rtc));
+    load_nvs();
+
+    if (s_part)
+        return true;
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           (esp_partition_subtype_t)HUD_PERSIST_SUBTYPE, "lastmap");
+    if (!part || part->size <= SECTOR)
+        return false;
+    s_part = part;
+    if (esp_partition_read(s_part, 0, &s_map, sizeof(s_map)) != ESP_OK || s_map.magic != MAP_MAGIC ||
+        s_map.len == 0 || s_map.len > hud_persist_map_cap())
+        memset(&s_map, 0, sizeof(s_map));
+    return true;
+}
+
+void hud_persist_put_snapshot(const uint8_t *wire)
+{
+    if (!wire)
+        return;
+    /* magic off while the record is inconsistent: a reset in between drops it, not corrupts it */
+    s_rtc.magic = 0;
+    memcpy(s_rtc.wire, wire, sizeof(s_rtc.wire));
+    s_rtc.crc = crc32(s_rtc.wire, sizeof(s_rtc.wire));
+    s_rtc.magic = SNAP_MAGIC;
+}
+
+bool hud_persist_get_snapshot(uint8_t *wire)
+{
+    if (!wire)
+        return false;
+    snap_rec_t r = s_rtc;
+    if (!snap_ok(&r))
+    {
+        if (!s_nvs_valid)
+            return false;
+        r = s_nvs;
+    }
+    memcpy(wire, r.wire, sizeof(r.wire));
+    return true;
+}
+
+void hud_persist_flush_snapshot(void)
+{
+    /* the app task may be updating s_rtc right now; a torn copy fails its crc, try next time */
+    snap_rec_t r = s_rtc;
+    if (!snap_ok(&r) || (s_nvs_valid && memcmp(r.wire, s_nvs.wire, sizeof(r.wire)) == 0))
+        return;
+    nvs_handle_t h;
+    if (nvs_open(NVS_NS, NVS_READWRITE, &h) != ESP_OK)
+        return;
+    if (nvs_set_blob(h, NVS_KEY, r.wire, sizeof(r.wire)) == ESP_OK && nvs_commit(h) == ESP_OK)
+    {
+        s_nvs = r;
+        s_nvs_valid = true;
+    }
+    nvs_close(h);
+}
+
+size_t hud_persist_map_cap(void)
+{
+    return s_part ? s_part->size - SECTOR : 0;
+}
+
+bool hud_persist_save_map(const uint8_t *payload, size_t len)
+{
+    if (!s_part || !payload || len == 0 || len > hud_persist_map_cap())
+        return false;
+    const uint32_t crc = crc32(payload, len);
+    if (s_map.magic == MAP_MAGIC && s_map.len == len && s_map.crc == crc)
+        return true; /* e.g. the map restored at boot: no erase for the same bytes */
+
+    /* header sector first: from here until the final write the partition holds "nothing" */
+    memset(&s_map, 0, sizeof(s_map));
+    if (esp_partition_erase_range(s_part, 0, SECTOR) != ESP_OK)
+        return false;
+    for (size_t off = 0; off < len; off += SECTOR)
+    {
+        const size_t n = len - off < SECTOR ? len - off : SECTOR;
+        if (esp_partition_erase_range(s_part, SECTOR + off, SECTOR) != ESP_OK ||
+            esp_partition_write(s_part, SECTOR + off, payload + off, n) != ESP_OK)
+            return false;
+        vTaskDelay(pdMS_TO_TICKS(WRITE_GAP_MS));
+    }
+    const map_hdr_t h = {MAP_MAGIC, (uint32_t)len, crc, 0};
+    if (esp_partition_write(s_part, 0, &h, sizeof(h)) != ESP_OK)
+        return false;
+    s_map = h;
+    return true;
+}
+
+size_t hud_persist_map_len(void)
+{
+    return s_map.magic == MAP_MAGIC ? s_map.len : 0;
+}
+
+bool hud_persist_load_map(uint8_t *dst, size_t cap, size_t *len)
+{
+    const size_t n = hud_persist_map_len();
+    if (!dst || n == 0 || n > cap || esp_partition_read(s_part, SECTOR, dst, n) != ESP_OK ||
+        crc32(dst, n) != s_map.crc)
+        return false;
+    if (len)
+        *len = n;
+    return true;
+}
+
+#else /* no esp_partition / NVS: nothing persists */
+
+bool hud_persist_init(void) { return false; }
+
+void hud_persist_put_snapshot(const uint8_t *wire) { (void)wire; }
+
+bool hud_persist_get_snapshot(uint8_t *wire)
+{
+    (void)wire;
+    return false;
+}
+
+void hud_persist_flush_snapshot(void) {}
+
+size_t hud_persist_map_cap(void) { return 0; }
+
+bool hud_persist_save_map(const uint8_t *payload, size_t len)
+{
+    (void)payload;
+    (void)len;
+    return false;
+}
+
+size_t hud_persist_map_len(void) { return 0; }
+
+bool hud_persist_load_map(uint8_t *dst, size_t cap, size_t *len)
+{
+    (void)dst;
+    (void)cap;
+    (void)len;
+    return false;
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include "hud_rs485.h"
+#include <string.h>
+
+#if HUD_RS485
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "driver/uart.h"
+
+#include "hud_sched.h"
+
+#define EV_QUEUE_LEN 32
+#define RX_FULL_THRESH 100 /* of the 128-byte FIFO: leaves ~28 byte times for the ISR to get in */
+
+static QueueHandle_t s_evq;
+static void (*s_notify)(void *arg);
+static void *s_notify_arg;
+static hud_rs485_stats_t s_stats;
+
+/* Driver events -> router wakeups. One event per FIFO burst, not per byte. */
+static void ev_task(void *arg)
+{
+    (void)arg;
+    uart_event_t ev;
+    for (;;)
+    {
+        if (xQueueReceive(s_evq, &ev, portMAX_DELAY) != pdTRUE)
+            continue;
+        switch (ev.type)
+        {
+        case UART_DATA:
+            break;
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            /* bytes were lost anyway: start clean, the router drops the torn frame and resyncs */
+            s_stats.overflows++;
+            uart_flush_input(HUD_RS485_UART);
+            xQueueReset(s_evq);
+            break;
+        case UART_FRAME_ERR:
+        case UART_PARITY_ERR:
+            s_stats.line_errs++;
+            break;
+        default:
+            continue;
+        }
+        if (s_notify)
+            s_notify(s_notify_arg);
+    }
+}
+
+static int tp_available(void *ctx)
+{
+    (void)ctx;
+    size_t n = 0;
+    uart_get_buffered_data_len(HUD_RS485_UART, &n);
+    return (int)n;
+}
+
+static int tp_read(void *ctx, uint8_t *dst, int max_len)
+{
+    (void)ctx;
+    return uart_read_bytes(HUD_RS485_UART, dst, (uint32_t)max_len, 0);
+}
+
+static int tp_write(void *ctx, const uint8_t *src, int len)
+{
+    (void)ctx;
+    return uart_write_bytes(HUD_RS485_UART, (const char *)src, (size_t)len);
+}
+
+static void tp_set_rx_notify(void *ctx, void (*notify)(void *arg), void *arg)
+{
+    (void)ctx;
+    s_notify_arg = arg;
+    s_notify = notify;
+}
+
+bool hud_rs485_init(int rts, int rxd, int txd, usb_sr_transport_t *tp)
+{
+    if (!tp || rxd < 0 || txd < 0)
+        return false;
+
+    const uart_config_t cfg = {
+        .baud_rate = HUD_RS485_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_APB,
+    };
+    if (uart_driver_install(HUD_RS485_UART, HUD_RS485_RX_BUF, HUD_RS485_TX_BUF, EV_QUEUE_LEN, &s_evq, 0) != ESP_OK)
+        return false;
+    if (uart_param_config(HUD_RS485_UART, &cfg) != ESP_OK ||
+        uart_set_pin(HUD_RS485_UART, txd, rxd, rts < 0 ? UART_PIN_NO_CHANGE : rts, UART_PIN_NO_CHANGE) != ESP_OK ||
+        uart_set_mode(HUD_RS485_UART, rts < 0 ? UART_MODE_UART : UART_MODE_RS485_HALF_DUPLEX) != ESP_OK ||
+        uart_set_rx_full_threshold(HUD_RS485_UART, RX_FULL_THRESH) != ESP_OK ||
+        uart_set_rx_timeout(HUD_RS485_UART, HUD_RS485_RX_TOUT) != ESP_OK)
+    {
+        uart_driver_delete(HUD_RS485_UART);
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(ev_task, "rs485", HUD_SCHED_RS485_STACK, NULL, HUD_SCHED_RS485_PRIO, NULL,
+                                HUD_SCHED_AFFINITY(HUD_SCHED_RS485_CORE)) != pdPASS)
+    {
+        uart_driver_delete(HUD_RS485_UART);
+        return false;
+    }
+
+    memset(tp, 0, sizeof(*tp));
+    tp->available = tp_available;
+    tp->read = tp_read;
+    tp->read_into = tp_read;
+    tp->set_rx_notify = tp_set_rx_notify;
+    tp->write = tp_write;
+    return true;
+}
+
+void hud_rs485_get_stats(hud_rs485_stats_t *out)
+{
+    if (out)
+        *out = s_stats;
+}
+
+#else
+
+bool hud_rs485_init(int rts, int rxd, int txd, usb_sr_transport_t *tp)
+{
+    (void)rts;
+    (void)rxd;
+    (void)txd;
+    (void)tp;
+    return false;
+}
+
+void hud_rs485_get_stats(hud_rs485_stats_t *out)
+{
+    if (out)
+        memset(out, 0, sizeof(*out));
+}
+
+#endif
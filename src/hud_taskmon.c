@@ -0,0 +1,200 @@
+#include "hud_taskmon.h"
+#include <string.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_freertos_hooks.h"
+
+#define TASKMON_RUNTIME (configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY)
+#define TASKMON_CORES (portNUM_PROCESSORS < HUD_TASKMON_MAX_CORES ? portNUM_PROCESSORS : HUD_TASKMON_MAX_CORES)
+/* idle-hook estimate: consecutive hook calls closer than this count as idle time */
+#define TASKMON_IDLE_GAP_US 50
+
+_Static_assert(sizeof(hud_taskmon_task_t) == 20, "TASK wire record must stay 20 bytes");
+
+static char s_names[HUD_TASKMON_MAX_TASKS][HUD_TASKMON_NAME_LEN];
+static int s_count;
+static bool s_hooks;
+
+/* -------- idle-hook estimate --------
+   A hook that returns false keeps the idle loop spinning; short gaps between calls mean the
+   core was idle for that time, a preemption shows up as a long gap and is not counted. */
+static volatile uint32_t s_idle_us[HUD_TASKMON_MAX_CORES];
+static uint32_t s_idle_last[HUD_TASKMON_MAX_CORES];
+
+static bool idle_tick(int core)
+{
+    const uint32_t now = (uint32_t)esp_timer_get_time();
+    const uint32_t gap = now - s_idle_last[core];
+    s_idle_last[core] = now;
+    if (gap < TASKMON_IDLE_GAP_US)
+        s_idle_us[core] += gap;
+    return false;
+}
+
+static bool idle_hook0(void) { return idle_tick(0); }
+#if TASKMON_CORES > 1
+static bool idle_hook1(void) { return idle_tick(1); }
+#endif
+
+bool hud_taskmon_init(bool idle_hooks)
+{
+    if (TASKMON_RUNTIME || !idle_hooks || s_hooks)
+        return true;
+    if (esp_register_freertos_idle_hook_for_cpu(idle_hook0, 0) != ESP_OK)
+        return false;
+#if TASKMON_CORES > 1
+    if (esp_register_freertos_idle_hook_for_cpu(idle_hook1, 1) != ESP_OK)
+    {
+        esp_deregister_freertos_idle_hook_for_cpu(idle_hook0, 0);
+        return false;
+    }
+#endif
+    s_hooks = true;
+    return true;
+}
+
+bool hud_taskmon_watch(const char *name)
+{
+    if (!name)
+        return false;
+    for (int i = 0; i < s_count; i++)
+    {
+        if (strncmp(s_names[i], name, HUD_TASKMON_NAME_LEN - 1) == 0)
+            return true;
+    }
+    if (s_count >= HUD_TASKMON_MAX_TASKS)
+        return false;
+    strncpy(s_names[s_count], name, HUD_TASKMON_NAME_LEN - 1);
+    s_names[s_count][HUD_TASKMON_NAME_LEN - 1] = '\0';
+    s_count++;
+    return true;
+}
+
+static uint8_t pct(uint32_t part, uint32_t whole)
+{
+    if (!whole)
+        return HUD_TASKMON_UNKNOWN;
+    if (part >= whole)
+        return 100;
+    return (uint8_t)((uint64_t)part * 100u / whole);
+}
+
+static uint8_t clamp_u8(UBaseType_t v)
+{
+    return v > 0xFE ? 0xFE : (uint8_t)v;
+}
+
+void hud_taskmon_sample(hud_taskmon_mark_t *mark, hud_taskmon_report_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    const uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    out->window_ms = now_ms - mark->t_ms;
+    mark->t_ms = now_ms;
+    out->ncores = TASKMON_CORES;
+    for (int c = 0; c < HUD_TASKMON_MAX_CORES; c++)
+        out->core_busy[c] = HUD_TASKMON_UNKNOWN;
+
+#if TASKMON_RUNTIME
+    /* one snapshot of every task: idle counters for the cores, run counters for the watch list */
+    const UBaseType_t cap = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *st = (TaskStatus_t *)malloc(cap * sizeof(TaskStatus_t));
+    uint32_t total = 0;
+    const UBaseType_t n = st ? uxTaskGetSystemState(st, cap, &total) : 0;
+    const uint32_t dt = total - mark->total;
+    if (st)
+    {
+        mark->total = total;
+        out->flags |= HUD_TASKMON_F_TASK_CPU;
+        for (int c = 0; c < TASKMON_CORES; c++)
+        {
+            const TaskHandle_t idle = xTaskGetIdleTaskHandleForCPU(c);
+            for (UBaseType_t k = 0; k < n; k++)
+            {
+                if (st[k].xHandle != idle)
+                    continue;
+                const uint32_t di = st[k].ulRunTimeCounter - mark->idle[c];
+                mark->idle[c] = st[k].ulRunTimeCounter;
+                out->core_busy[c] = dt ? (uint8_t)(100u - pct(di, dt)) : HUD_TASKMON_UNKNOWN;
+            }
+        }
+    }
+#else
+    if (s_hooks)
+    {
+        const uint32_t now_us = (uint32_t)esp_timer_get_time();
+        const uint32_t dt = now_us - mark->total;
+        mark->total = now_us;
+        out->flags |= HUD_TASKMON_F_IDLE_EST;
+        for (int c = 0; c < TASKMON_CORES; c++)
+        {
+            const uint32_t idle = s_idle_us[c];
+            const uint32_t di = idle - mark->idle[c];
+            mark->idle[c] = idle;
+            out->core_busy[c] = dt ? (uint8_t)(100u - pct(di, dt)) : HUD_TASKMON_UNKNOWN;
+        }
+    }
+#endif
+
+    for (int i = 0; i < s_count; i++)
+    {
+        /* by name every time: the task may not exist yet, or may have been restarted */
+        TaskHandle_t h = xTaskGetHandle(s_names[i]);
+        if (!h)
+            continue;
+        hud_taskmon_task_t *t = &out->task[out->ntasks++];
+        memcpy(t->name, s_names[i], HUD_TASKMON_NAME_LEN);
+        const BaseType_t aff = xTaskGetAffinity(h);
+        t->core = (aff >= 0 && aff < TASKMON_CORES) ? (uint8_t)aff : HUD_TASKMON_ANY_CORE;
+        t->prio = clamp_u8(uxTaskPriorityGet(h));
+        t->base_prio = t->prio;
+        t->cpu_pct = HUD_TASKMON_UNKNOWN;
+        const UBaseType_t hwm = uxTaskGetStackHighWaterMark(h);
+        t->stack_free = hwm > 0xFFFF ? 0xFFFF : (uint16_t)hwm;
+#if TASKMON_RUNTIME
+        for (UBaseType_t k = 0; k < n; k++)
+        {
+            if (st[k].xHandle != h)
+                continue;
+            t->base_prio = clamp_u8(st[k].uxBasePriority);
+            t->cpu_pct = pct(st[k].ulRunTimeCounter - mark->run[i], dt);
+            mark->run[i] = st[k].ulRunTimeCounter;
+        }
+#endif
+    }
+
+#if TASKMON_RUNTIME
+    free(st);
+#endif
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+size_t hud_taskmon_serialize(const hud_taskmon_report_t *r, uint8_t *dst, size_t cap)
+{
+    const size_t need = 12 + (size_t)r->ntasks * sizeof(hud_taskmon_task_t);
+    if (!dst || cap < need)
+        return 0;
+    uint8_t *p = dst;
+    *p++ = HUD_TASKMON_WIRE_VERSION;
+    *p++ = r->ntasks;
+    *p++ = r->ncores;
+    *p++ = r->flags;
+    p = put32(p, r->window_ms);
+    *p++ = r->core_busy[0];
+    *p++ = r->core_busy[1];
+    *p++ = 0;
+    *p++ = 0;
+    /* packed, little-endian target: the records go out as they are */
+    memcpy(p, r->task, (size_t)r->ntasks * sizeof(hud_taskmon_task_t));
+    return need;
+}
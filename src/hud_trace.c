@@ -0,0 +1,132 @@
+#include "hud_trace.h"
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+#define TRACE_CORES (portNUM_PROCESSORS < 2 ? portNUM_PROCESSORS : 2)
+#define TRACE_HDR_BYTES 16
+
+_Static_assert(sizeof(hud_trace_rec_t) == 16, "TRCE record must stay 16 bytes");
+_Static_assert((HUD_TRACE_RECORDS & (HUD_TRACE_RECORDS - 1)) == 0, "HUD_TRACE_RECORDS must be a power of two");
+
+/* Indexes stay in internal RAM (atomics on PSRAM are not safe on this chip); only the records
+   live in PSRAM. head counts every event ever emitted on the core, base is head at the last clear. */
+typedef struct
+{
+    hud_trace_rec_t *rec;
+    uint32_t head;
+    uint32_t base;
+} trace_ring_t;
+
+static trace_ring_t s_ring[TRACE_CORES];
+static volatile bool s_on;
+
+bool hud_trace_init(void)
+{
+    if (s_on)
+        return true;
+    for (int c = 0; c < TRACE_CORES; c++)
+    {
+        const size_t bytes = HUD_TRACE_RECORDS * sizeof(hud_trace_rec_t);
+        hud_trace_rec_t *r = (hud_trace_rec_t *)heap_caps_calloc(1, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!r)
+            r = (hud_trace_rec_t *)heap_caps_calloc(1, bytes, MALLOC_CAP_8BIT);
+        if (!r)
+        {
+            for (int k = 0; k < c; k++)
+            {
+                heap_caps_free(s_ring[k].rec);
+                s_ring[k].rec = NULL;
+            }
+            return false;
+        }
+        s_ring[c].rec = r;
+    }
+    s_on = true;
+    return true;
+}
+
+void hud_trace_emit(uint16_t id, uint32_t seq, uint32_t arg)
+{
+    if (!s_on)
+        return;
+    const int core = (int)xPortGetCoreID();
+    trace_ring_t *r = &s_ring[core < TRACE_CORES ? core : 0];
+    /* tasks on the same core may preempt each other between here and the stores: the atomic add
+       still gives each its own slot */
+    const uint32_t i = __atomic_fetch_add(&r->head, 1, __ATOMIC_RELAXED);
+    hud_trace_rec_t *e = &r->rec[i & (HUD_TRACE_RECORDS - 1)];
+    e->t_us = (uint32_t)esp_timer_get_time();
+    e->seq = seq;
+    e->arg = arg;
+    e->id = id;
+    e->core = (uint8_t)core;
+    e->rsv = 0;
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+bool hud_trace_dump(bool (*send)(const void *frame, size_t len, void *ctx), void *ctx, bool clear)
+{
+    static uint8_t frame[TRACE_HDR_BYTES + HUD_TRACE_CHUNK_RECORDS * sizeof(hud_trace_rec_t)];
+    if (!send || !s_ring[0].rec)
+        return false;
+
+    /* writers that already passed the s_on check may still land a record in the ring being
+       copied; at worst that record is torn, the rest of the dump is consistent */
+    s_on = false;
+    const uint32_t now = (uint32_t)esp_timer_get_time();
+    bool ok = true;
+    for (int c = 0; c < TRACE_CORES && ok; c++)
+    {
+        trace_ring_t *r = &s_ring[c];
+        const uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        uint32_t n = head - r->base;
+        uint32_t lost = 0;
+        if (n > HUD_TRACE_RECORDS)
+        {
+            lost = n - HUD_TRACE_RECORDS;
+            n = HUD_TRACE_RECORDS;
+        }
+        const uint32_t first = head - n;
+        const uint16_t chunks = (uint16_t)(n ? (n + HUD_TRACE_CHUNK_RECORDS - 1) / HUD_TRACE_CHUNK_RECORDS : 1);
+        for (uint16_t k = 0; k < chunks && ok; k++)
+        {
+            const uint32_t from = (uint32_t)k * HUD_TRACE_CHUNK_RECORDS;
+            const uint32_t cnt = n - from < HUD_TRACE_CHUNK_RECORDS ? n - from : HUD_TRACE_CHUNK_RECORDS;
+            frame[0] = HUD_TRACE_WIRE_VERSION;
+            frame[1] = (uint8_t)c;
+            frame[2] = (uint8_t)TRACE_CORES;
+            frame[3] = 0;
+            put_u16(frame + 4, k);
+            put_u16(frame + 6, chunks);
+            put_u32(frame + 8, now);
+            put_u32(frame + 12, lost);
+            for (uint32_t j = 0; j < cnt; j++)
+            {
+                const hud_trace_rec_t *e = &r->rec[(first + from + j) & (HUD_TRACE_RECORDS - 1)];
+                memcpy(frame + TRACE_HDR_BYTES + j * sizeof(hud_trace_rec_t), e, sizeof(*e));
+            }
+            ok = send(frame, TRACE_HDR_BYTES + cnt * sizeof(hud_trace_rec_t), ctx);
+        }
+        if (clear)
+            r->base = head;
+    }
+    s_on = true;
+    return ok;
+}
@@ -0,0 +1,158 @@
+#include "hud_usb_vendor.h"
+
+#if HUD_USB_VENDOR
+
+#include <string.h>
+
+#include <Arduino.h>
+#include "esp32-hal-tinyusb.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+
+#define VENDOR_ITF 0        // 第一个（唯一一个）vendor 实例
+#define VENDOR_EP_SIZE 64   // 全速 bulk 最大包长
+
+static StreamBufferHandle_t s_rx;
+static SemaphoreHandle_t s_pump_mtx;       // TinyUSB 任务与路由线程都会往 s_rx 里搬，串行化
+static volatile bool s_backlog;            // s_rx 满时 TinyUSB FIFO 里还留着数据
+static void (*s_notify)(void *arg);
+static void *s_notify_arg;
+
+static uint16_t load_descriptor(uint8_t *dst, uint8_t *itf)
+{
+    uint8_t str_index = tinyusb_add_string_descriptor("ESP HUD stream");
+    uint8_t ep_num = tinyusb_get_free_duplex_endpoint();
+    TU_VERIFY(ep_num != 0);
+    uint8_t desc[TUD_VENDOR_DESC_LEN] = {
+        TUD_VENDOR_DESCRIPTOR(*itf, str_index, ep_num, (uint8_t)(0x80 | ep_num), VENDOR_EP_SIZE)
+    };
+    *itf += 1;
+    memcpy(dst, desc, TUD_VENDOR_DESC_LEN);
+    return TUD_VENDOR_DESC_LEN;
+}
+
+// TinyUSB FIFO -> s_rx，按包整块搬；s_rx 放不下时留在 FIFO 里，端点不再重新开启接收，主机被 NAK
+static void pump(void)
+{
+    uint8_t pkt[VENDOR_EP_SIZE * 4];
+    xSemaphoreTake(s_pump_mtx, portMAX_DELAY);
+    bool left = false;
+    for (;;) {
+        uint32_t n = tud_vendor_n_available(VENDOR_ITF);
+        if (n == 0) {
+            break;
+        }
+        size_t space = xStreamBufferSpacesAvailable(s_rx);
+        if (space == 0) {
+            left = true;
+            break;
+        }
+        if (n > sizeof(pkt)) {
+            n = sizeof(pkt);
+        }
+        if (n > space) {
+            n = (uint32_t)space;
+        }
+        n = tud_vendor_n_read(VENDOR_ITF, pkt, n);
+        xStreamBufferSend(s_rx, pkt, n, 0);
+    }
+    s_backlog = left;
+    xSemaphoreGive(s_pump_mtx);
+}
+
+// TinyUSB 任务里调用：覆盖 TinyUSB 的弱符号（不实例化 Arduino 的 USBVendor，它的版本不会链接进来）
+extern "C" void tud_vendor_rx_cb(uint8_t itf)
+{
+    (void)itf;
+    if (!s_rx) {
+        return;
+    }
+    pump();
+    if (s_notify) {
+        s_notify(s_notify_arg);
+    }
+}
+
+static int tp_available(void *ctx)
+{
+    (void)ctx;
+    size_t n = xStreamBufferBytesAvailable(s_rx);
+    // s_rx 读空时再看一眼 FIFO：TinyUSB 任务可能刚看到 s_rx 满、还没来得及置 s_backlog，
+    // tp_read 就漏掉了补搬；这里不补，路由线程不会再来读，剩下的包要等主机发下一包才动
+    if (n == 0 && (s_backlog || tud_vendor_n_available(VENDOR_ITF) > 0)) {
+        pump();
+        n = xStreamBufferBytesAvailable(s_rx);
+    }
+    return (int)n;
+}
+
+static int tp_read(void *ctx, uint8_t *dst, int max)
+{
+    (void)ctx;
+    size_t n = xStreamBufferReceive(s_rx, dst, (size_t)max, 0);
+    // 腾出了空间：把 TinyUSB 里积压的包接着搬过来，端点才会重新开始接收
+    if (n && s_backlog) {
+        pump();
+    }
+    return (int)n;
+}
+
+static void tp_set_rx_notify(void *ctx, void (*notify)(void *arg), void *arg)
+{
+    (void)ctx;
+    s_notify_arg = arg;
+    s_notify = notify;
+}
+
+static int tp_write(void *ctx, const uint8_t *src, int len)
+{
+    (void)ctx;
+    const uint32_t t0 = millis();
+    while (tud_vendor_n_mounted(VENDOR_ITF)) {
+        uint32_t space = tud_vendor_n_write_available(VENDOR_ITF);
+        if (space) {
+            return (int)tud_vendor_n_write(VENDOR_ITF, src, (uint32_t)len < space ? (uint32_t)len : space);
+        }
+        if (millis() - t0 >= HUD_USB_VENDOR_TX_TIMEOUT_MS) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+    return 0;
+}
+
+extern "C" bool hud_usb_vendor_init(usb_sr_transport_t *tp)
+{
+    if (!tp) {
+        return false;
+    }
+    if (!s_rx) {
+        s_pump_mtx = xSemaphoreCreateMutex();
+        s_rx = xStreamBufferCreate(HUD_USB_VENDOR_RX_BUF, 1);
+        if (!s_pump_mtx || !s_rx) {
+            return false;
+        }
+        if (tinyusb_enable_interface(USB_INTERFACE_VENDOR, TUD_VENDOR_DESC_LEN, load_descriptor) != ESP_OK) {
+            return false;
+        }
+    }
+    memset(tp, 0, sizeof(*tp));
+    tp->ctx = nullptr;
+    tp->available = tp_available;
+    tp->read = tp_read;
+    tp->read_into = tp_read;
+    tp->set_rx_notify = tp_set_rx_notify;
+    tp->write = tp_write;
+    return true;
+}
+
+#else
+
+extern "C" bool hud_usb_vendor_init(usb_sr_transport_t *tp)
+{
+    (void)tp;
+    return false;
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include "img_qoi.h"
+#include <string.h>
+
+#define QOI_OP_INDEX 0x00 /* 00xxxxxx */
+#define QOI_OP_DIFF 0x40  /* 01xxxxxx */
+#define QOI_OP_LUMA 0x80  /* 10xxxxxx */
+#define QOI_OP_RUN 0xc0   /* 11xxxxxx */
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MASK_2 0xc0
+
+#define QOI_PADDING 8 /* 7 x 0x00, 0x01 */
+
+static uint32_t get_u32be(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+bool qoi_parse(const uint8_t *data, size_t len, qoi_info_t *info)
+{
+    if (!data || !info || len < QOI_HDR_BYTES + QOI_PADDING || memcmp(data, "qoif", 4) != 0)
+        return false;
+    info->w = get_u32be(data + 4);
+    info->h = get_u32be(data + 8);
+    info->channels = data[12];
+    if (!info->w || !info->h || info->w > 0xffff || info->h > 0xffff)
+        return false;
+    return info->channels == 3 || info->channels == 4;
+}
+
+static inline uint16_t to_r565(uint8_t r, uint8_t g, uint8_t b)
+{
+    return (uint16_t)(((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3));
+}
+
+bool qoi_decode_r565(const uint8_t *data, size_t len, uint8_t *dst, size_t dst_cap, bool swapped)
+{
+    qoi_info_t info;
+    if (!qoi_parse(data, len, &info) || !dst)
+        return false;
+    const size_t px_len = (size_t)info.w * info.h;
+    if (dst_cap < px_len * 2)
+        return false;
+
+    /* the color cache keeps RGBA (the hash needs it) plus the RGB565 value, so INDEX ops and
+       runs never convert again */
+    uint8_t idx_rgba[64][4];
+    uint16_t idx_565[64];
+    memset(idx_rgba, 0, sizeof(idx_rgba));
+    memset(idx_565, 0, sizeof(idx_565));
+
+    uint8_t r = 0, g = 0, b = 0, a = 255;
+    uint16_t v = 0;
+    const uint8_t *s = data + QOI_HDR_BYTES;
+    const uint8_t *end = data + len - QOI_PADDING;
+    const int hi = swapped ? 0 : 1, lo = swapped ? 1 : 0;
+    uint8_t *d = dst;
+    uint8_t *const d_end = dst + px_len * 2;
+
+    while (d < d_end)
+    {
+        if (s >= end)
+            return false;
+        const uint8_t op = *s++;
+        uint32_t run = 1;
+        bool fresh = true; /* a new color: convert it and put it in the cache */
+
+        if (op == QOI_OP_RGB || op == QOI_OP_RGBA)
+        {
+            const size_t n = (op == QOI_OP_RGB) ? 3 : 4;
+            if ((size_t)(end - s) < n)
+                return false;
+            r = s[0];
+            g = s[1];
+            b = s[2];
+            if (n == 4)
+                a = s[3];
+            s += n;
+        }
+        else if ((op & QOI_MASK_2) == QOI_OP_INDEX)
+        {
+            r = idx_rgba[op][0];
+            g = idx_rgba[op][1];
+            b = idx_rgba[op][2];
+            a = idx_rgba[op][3];
+            v = idx_565[op];
+            fresh = false;
+        }
+        else if ((op & QOI_MASK_2) == QOI_OP_DIFF)
+        {
+            r += (uint8_t)(((op >> 4) & 3) - 2);
+            g += (uint8_t)(((op >> 2) & 3) - 2);
+            b += (uint8_t)((op & 3) - 2);
+        }
+        else if ((op & QOI_MASK_2) == QOI_OP_LUMA)
+        {
+            if (s >= end)
+                return false;
+            const uint8_t b2 = *s++;
+            const int vg = (op & 0x3f) - 32;
+            g += (uint8_t)vg;
+            r += (uint8_t)(vg - 8 + ((b2 >> 4) & 0x0f));
+            b += (uint8_t)(vg - 8 + (b2 & 0x0f));
+        }
+        else
+        {
+            /* QOI_OP_RUN: the previous pixel again; a run past the end is cut, as in the reference */
+            run = (uint32_t)(op & 0x3f) + 1;
+            if (run > (uint32_t)(d_end - d) / 2)
+                run = (uint32_t)(d_end - d) / 2;
+            fresh = false;
+        }
+
+        if (fresh)
+        {
+            v = to_r565(r, g, b);
+            const unsigned h = (unsigned)(r * 3 + g * 5 + b * 7 + a * 11) & 63;
+            idx_rgba[h][0] = r;
+            idx_rgba[h][1] = g;
+            idx_rgba[h][2] = b;
+            idx_rgba[h][3] = a;
+            idx_565[h] = v;
+        }
+
+        const uint8_t vh = (uint8_t)(v >> 8), vl = (uint8_t)v;
+        for (uint32_t i = 0; i < run; i++, d += 2)
+        {
+            d[hi] = vh;
+            d[lo] = vl;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+#include "img_qoi.h"
+
+#include <lvgl.h>
+
+/* LVGL 图像解码器：lv_img_dsc_t 的 data 以 "qoif" 开头时按 QOI 整张解成 TRUE_COLOR（RGB565），
+   比 lodepng 的 inflate 快得多。注册在 PNG 解码器之前，其它格式交回 LVGL 继续尝试。 */
+
+static bool qoi_src_info(const void *src, const uint8_t **data, size_t *len, qoi_info_t *info)
+{
+    if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) return false;
+    const lv_img_dsc_t *dsc = static_cast<const lv_img_dsc_t *>(src);
+    if (!dsc->data || !qoi_parse(dsc->data, dsc->data_size, info)) return false;
+    // lv_img_header_t 的宽高只有 11 位
+    if (info->w > 2047 || info->h > 2047) return false;
+    *data = dsc->data;
+    *len = dsc->data_size;
+    return true;
+}
+
+static lv_res_t qoi_info_cb(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header)
+{
+    (void)decoder;
+    const uint8_t *data;
+    size_t len;
+    qoi_info_t info;
+    if (!qoi_src_info(src, &data, &len, &info)) return LV_RES_INV;
+    header->always_zero = 0;
+    header->cf = LV_IMG_CF_TRUE_COLOR;
+    header->w = info.w;
+    header->h = info.h;
+    return LV_RES_OK;
+}
+
+static lv_res_t qoi_open_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    (void)decoder;
+    const uint8_t *data;
+    size_t len;
+    qoi_info_t info;
+    if (!qoi_src_info(dsc->src, &data, &len, &info)) return LV_RES_INV;
+
+    const size_t bytes = (size_t)info.w * info.h * sizeof(lv_color_t);
+    uint8_t *buf = static_cast<uint8_t *>(lv_mem_alloc(bytes));
+    if (!buf) return LV_RES_INV;
+    if (!qoi_decode_r565(data, len, buf, bytes, LV_COLOR_16_SWAP != 0)) {
+        lv_mem_free(buf);
+        return LV_RES_INV;
+    }
+    dsc->img_data = buf;
+    return LV_RES_OK;
+}
+
+static void qoi_close_cb(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    (void)decoder;
+    if (dsc->img_data) {
+        lv_mem_free((void *)dsc->img_data);
+        dsc->img_data = nullptr;
+    }
+}
+
+void img_qoi_lv_register(void)
+{
+    static lv_img_decoder_t *s_dec = nullptr;
+    if (s_dec) return;
+    s_dec = lv_img_decoder_create();
+    if (!s_dec) return;
+    lv_img_decoder_set_info_cb(s_dec, qoi_info_cb);
+    lv_img_decoder_set_open_cb(s_dec, qoi_open_cb);
+    lv_img_decoder_set_close_cb(s_dec, qoi_close_cb);
+}
@@ -0,0 +1,192 @@
+#include "img_r565.h"
+#include "img_qoi.h"
+#include "hud_dma_copy.h"
+#include <string.h>
+
+bool r565_parse(const uint8_t *payload, size_t len, r565_hdr_t *hdr)
+{
+    if (!payload || !hdr || len < sizeof(*hdr))
+        return false;
+    memcpy(hdr, payload, sizeof(*hdr));
+    if (hdr->magic != R565_MAGIC || !hdr->w || !hdr->h)
+        return false;
+    if (!hdr->stride)
+        hdr->stride = hdr->w;
+    if (hdr->stride < hdr->w || hdr->codec > R565_CODEC_QOI)
+        return false;
+    if (hdr->codec == R565_CODEC_QOI && hdr->stride != hdr->w)
+        return false;
+    if (hdr->raw_len != (uint32_t)hdr->stride * hdr->h * 2u)
+        return false;
+    if (hdr->codec == R565_CODEC_RAW && len - sizeof(*hdr) < hdr->raw_len)
+        return false;
+    return true;
+}
+
+size_t r565_work_size(const r565_hdr_t *hdr)
+{
+    return hdr->raw_len;
+}
+
+static bool rle_decode(const uint8_t *s, size_t n, uint8_t *d, size_t out_len)
+{
+    const uint8_t *end = s + n;
+    size_t o = 0;
+    while (o < out_len)
+    {
+        if (s >= end)
+            return false;
+        uint8_t c = *s++;
+        size_t cnt = (size_t)(c & 0x7f) + 1;
+        if (o + cnt * 2 > out_len)
+            return false;
+        if (c & 0x80)
+        {
+            if (end - s < 2)
+                return false;
+            uint8_t a = s[0], b = s[1];
+            s += 2;
+            for (size_t i = 0; i < cnt; i++, o += 2)
+            {
+                d[o] = a;
+                d[o + 1] = b;
+            }
+        }
+        else
+        {
+            if ((size_t)(end - s) < cnt * 2)
+                return false;
+            memcpy(d + o, s, cnt * 2);
+            s += cnt * 2;
+            o += cnt * 2;
+        }
+    }
+    return true;
+}
+
+static bool lz4_decode(const uint8_t *s, size_t n, uint8_t *d, size_t out_len)
+{
+    const uint8_t *end = s + n;
+    size_t o = 0;
+    while (s < end)
+    {
+        uint8_t tok = *s++;
+
+        size_t lit = tok >> 4;
+        if (lit == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (s >= end)
+                    return false;
+                b = *s++;
+                lit += b;
+            } while (b == 255);
+        }
+        if ((size_t)(end - s) < lit || o + lit > out_len)
+            return false;
+        memcpy(d + o, s, lit);
+        s += lit;
+        o += lit;
+        if (s >= end)
+            break; /* last sequence has literals only */
+
+        if (end - s < 2)
+            return false;
+        size_t off = (size_t)s[0] | ((size_t)s[1] << 8);
+        s += 2;
+        if (off == 0 || off > o)
+            return false;
+
+        size_t mlen = (tok & 0x0f);
+        if (mlen == 15)
+        {
+            uint8_t b;
+            do
+            {
+                if (s >= end)
+                    return false;
+                b = *s++;
+                mlen += b;
+            } while (b == 255);
+        }
+        mlen += 4;
+        if (o + mlen > out_len)
+            return false;
+        /* overlapping copy is the RLE case of LZ4: must go forward byte by byte */
+        const uint8_t *m = d + o - off;
+        if (off >= mlen)
+        {
+            memcpy(d + o, m, mlen);
+        }
+        else
+        {
+            for (size_t i = 0; i < mlen; i++)
+                d[o + i] = m[i];
+        }
+        o += mlen;
+    }
+    return o == out_len;
+}
+
+bool r565_decode(const r565_hdr_t *hdr, const uint8_t *payload, size_t len,
+                 uint8_t *dst, size_t dst_cap, bool want_swapped)
+{
+    if (!hdr || !payload || !dst || dst_cap < r565_work_size(hdr) || len < sizeof(*hdr))
+        return false;
+
+    const uint8_t *src = payload + sizeof(*hdr);
+    const size_t n = len - sizeof(*hdr);
+
+    if (hdr->codec == R565_CODEC_QOI)
+    {
+        /* packed output in the wanted order already: nothing to repack */
+        qoi_info_t qi;
+        return qoi_parse(src, n, &qi) && qi.w == hdr->w && qi.h == hdr->h &&
+               qoi_decode_r565(src, n, dst, dst_cap, want_swapped);
+    }
+
+    const bool swap = ((hdr->flags & R565_FLAG_SWAPPED) != 0) != want_swapped;
+
+    /* nothing to repack: one bulk copy (raw, on GDMA when aligned) or a straight decompress */
+    bool ok;
+    switch (hdr->codec)
+    {
+    case R565_CODEC_RAW:
+        hud_dma_copy(dst, src, hdr->raw_len);
+        ok = true;
+        break;
+    case R565_CODEC_RLE:
+        ok = rle_decode(src, n, dst, hdr->raw_len);
+        break;
+    default:
+        ok = lz4_decode(src, n, dst, hdr->raw_len);
+        break;
+    }
+    if (!ok)
+        return false;
+
+    if (hdr->stride == hdr->w && !swap)
+        return true;
+
+    /* compact rows in place (destination never overtakes the source) and fix byte order */
+    const size_t row_out = (size_t)hdr->w * 2, row_in = (size_t)hdr->stride * 2;
+    for (uint32_t y = 0; y < hdr->h; y++)
+    {
+        uint8_t *o = dst + y * row_out;
+        const uint8_t *i = dst + y * row_in;
+        if (o != i)
+            memmove(o, i, row_out);
+        if (swap)
+        {
+            for (size_t x = 0; x < row_out; x += 2)
+            {
+                uint8_t t = o[x];
+                o[x] = o[x + 1];
+                o[x + 1] = t;
+            }
+        }
+    }
+    return true;
+}
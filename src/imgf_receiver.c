@@ -1,22 +1,31 @@
 #include "imgf_receiver.h"
+#include "hud_dma_copy.h"
 #include <string.h>
-#include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#include <stdatomic.h>
 
 #if __has_include("esp_heap_caps.h")
 #include "esp_heap_caps.h"
+/* aligned so a raw R565 body (payload + 16-byte header) can be moved by GDMA */
 static void *buf_alloc(size_t n)
 {
-    void *p = heap_caps_malloc(n, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    void *p = heap_caps_aligned_alloc(HUD_DMA_COPY_ALIGN, n, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
     if (p)
         return p;
-    return heap_caps_malloc(n, MALLOC_CAP_8BIT);
+    return heap_caps_aligned_alloc(HUD_DMA_COPY_ALIGN, n, MALLOC_CAP_8BIT);
 }
 static void buf_free(void *p) { heap_caps_free(p); }
+/* free bytes in the heap buf_alloc() would serve the next request from */
+static size_t buf_heap_free(void)
+{
+    size_t n = heap_caps_get_free_size(MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return n ? n : heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
 #else
 #include <stdlib.h>
+#include <stdint.h>
 static void *buf_alloc(size_t n) { return malloc(n); }
 static void buf_free(void *p) { free(p); }
+static size_t buf_heap_free(void) { return SIZE_MAX; }
 #endif
 
 #define MAGIC_IMGF 0x46474D49u
@@ -28,74 +37,97 @@ enum
     BREADING
 };
 
+/* Slot ownership is handed over with CAS on state[]:
+     FREE -> WRITING            router (acquire)
+     READY -> WRITING           router (acquire, IMGF_DROP_OLD steals the oldest image)
+     WRITING -> READY / FREE    router (commit / drop)
+     READY -> READING           consumer (get_ready)
+     READING -> FREE            consumer (release)
+   len/seq/stamp are written by the owner before the releasing store, so whoever wins the
+   next CAS sees them. There is a single writer (the router RX task) and a single consumer. */
 struct imgf_rx
 {
     imgf_rx_config_t cfg;
-    SemaphoreHandle_t mtx;
 
-    uint8_t *buf[2];
+    int nslots;
+    uint8_t *buf[IMGF_RX_MAX_SLOTS];
     size_t cap;
 
-    uint8_t state[2];
-    size_t len[2];
-    uint32_t seq[2];
+    atomic_int state[IMGF_RX_MAX_SLOTS];
+    size_t len[IMGF_RX_MAX_SLOTS];
+    uint32_t seq[IMGF_RX_MAX_SLOTS];
+    uint8_t type[IMGF_RX_MAX_SLOTS];
+    uint8_t flags[IMGF_RX_MAX_SLOTS];
+    uint16_t frag[IMGF_RX_MAX_SLOTS];
+    uint32_t stamp[IMGF_RX_MAX_SLOTS]; /* commit order, oldest READY is consumed first */
+    atomic_uint pub;                   /* bumped after every commit, lets the consumer detect
+                                          a commit racing with its oldest-READY scan */
 
-    int wr_idx;
+    int wr_idx;          /* slot being written, -1 none (router task only) */
+    uint32_t next_stamp; /* router task only */
 
     imgf_rx_stats_t st;
 };
 
+static bool slot_cas(imgf_rx_t *h, int i, int from, int to)
+{
+    int expect = from;
+    return atomic_compare_exchange_strong(&h->state[i], &expect, to);
+}
+
+/* oldest READY slot, -1 if none */
+static int oldest_ready(imgf_rx_t *h)
+{
+    int best = -1;
+    for (int i = 0; i < h->nslots; i++)
+    {
+        if (atomic_load(&h->state[i]) != BREADY)
+            continue;
+        if (best < 0 || (int32_t)(h->stamp[i] - h->stamp[best]) < 0)
+            best = i;
+    }
+    return best;
+}
+
 static void *imgf_acquire(void *user, const usb_sr_hdr_t *hdr, size_t *capacity)
 {
     imgf_rx_t *h = (imgf_rx_t *)user;
     if (!h || !capacity)
         return NULL;
+    (void)hdr;
+    h->st.frames_seen++;
 
-    xSemaphoreTake(h->mtx, portMAX_DELAY);
-
-    int wi = h->wr_idx;
-    if (h->state[wi] != BFREE)
+    int wi = -1;
+    for (int i = 0; i < h->nslots && wi < 0; i++)
     {
-        int alt = wi ^ 1;
-        if (h->state[alt] == BFREE)
-            wi = alt;
+        if (slot_cas(h, i, BFREE, BWRITING))
+            wi = i;
     }
 
-    if (h->state[wi] != BFREE)
+    if (wi < 0 && h->cfg.drop_policy == IMGF_DROP_OLD)
     {
-        if (h->cfg.drop_policy == IMGF_DROP_OLD)
+        /* the consumer may grab the candidate meanwhile: retry with the next oldest */
+        int cand;
+        while (wi < 0 && (cand = oldest_ready(h)) >= 0)
         {
-            int drop = (h->state[0] == BREADY) ? 0 : ((h->state[1] == BREADY) ? 1 : -1);
-            if (drop >= 0)
+            if (slot_cas(h, cand, BREADY, BWRITING))
             {
-                h->state[drop] = BFREE;
-                h->len[drop] = 0;
+                h->len[cand] = 0;
                 h->st.frames_drop++;
-                wi = drop;
+                wi = cand;
             }
-            else
-            {
-                h->st.frames_drop++;
-                xSemaphoreGive(h->mtx);
-                return NULL;
-            }
-        }
-        else
-        {
-            h->st.frames_drop++;
-            xSemaphoreGive(h->mtx);
-            return NULL;
         }
     }
 
+    if (wi < 0)
+    {
+        h->st.frames_drop++;
+        return NULL;
+    }
+
     h->wr_idx = wi;
-    h->state[wi] = BWRITING;
     *capacity = h->cap;
-
-    void *p = h->buf[wi];
-    xSemaphoreGive(h->mtx);
-    (void)hdr;
-    return p;
+    return h->buf[wi];
 }
 
 static void imgf_commit(void *user, const usb_sr_hdr_t *hdr, void *buf, size_t len)
@@ -103,14 +135,21 @@ static void imgf_commit(void *user, const usb_sr_hdr_t *hdr, void *buf, size_t l
     imgf_rx_t *h = (imgf_rx_t *)user;
     (void)buf;
 
-    xSemaphoreTake(h->mtx, portMAX_DELAY);
     int wi = h->wr_idx;
-    h->state[wi] = BREADY;
+    if (wi < 0)
+        return;
     h->len[wi] = len;
     h->seq[wi] = hdr->seq;
+    h->type[wi] = hdr->type;
+    h->flags[wi] = hdr->flags;
+    h->frag[wi] = hdr->rsv;
+    h->stamp[wi] = h->next_stamp++;
     h->st.frames_ok++;
-    h->wr_idx ^= 1;
-    xSemaphoreGive(h->mtx);
+    h->wr_idx = -1;
+    atomic_store(&h->state[wi], BREADY);
+    atomic_fetch_add(&h->pub, 1);
+    if (h->cfg.on_commit)
+        h->cfg.on_commit(h->cfg.on_commit_arg);
 }
 
 static void imgf_drop(void *user, const usb_sr_hdr_t *hdr, int reason)
@@ -118,16 +157,15 @@ static void imgf_drop(void *user, const usb_sr_hdr_t *hdr, int reason)
     imgf_rx_t *h = (imgf_rx_t *)user;
     (void)hdr;
     (void)reason;
-    xSemaphoreTake(h->mtx, portMAX_DELAY);
     h->st.frames_bad++;
     /* if we were WRITING, free it */
     int wi = h->wr_idx;
-    if (h->state[wi] == BWRITING)
+    if (wi >= 0)
     {
-        h->state[wi] = BFREE;
         h->len[wi] = 0;
+        h->wr_idx = -1;
+        slot_cas(h, wi, BWRITING, BFREE);
     }
-    xSemaphoreGive(h->mtx);
 }
 
 imgf_rx_t *imgf_rx_create(const imgf_rx_config_t *cfg)
@@ -142,24 +180,32 @@ imgf_rx_t *imgf_rx_create(const imgf_rx_config_t *cfg)
     h->cfg = *cfg;
     h->cap = cfg->max_png_bytes;
 
-    h->mtx = xSemaphoreCreateMutex();
-    if (!h->mtx)
-    {
-        buf_free(h);
-        return NULL;
-    }
+    int want = cfg->slots;
+    if (want < 2)
+        want = 2;
+    if (want > IMGF_RX_MAX_SLOTS)
+        want = IMGF_RX_MAX_SLOTS;
+    h->cfg.slots = want;
 
-    for (int i = 0; i < 2; i++)
+    for (int i = 0; i < want; i++)
     {
+        /* 2 slots are the minimum for streaming; extra ones must leave mem_reserve free */
+        if (i >= 2 && cfg->mem_reserve &&
+            buf_heap_free() < h->cap + cfg->mem_reserve)
+            break;
         h->buf[i] = (uint8_t *)buf_alloc(h->cap);
         if (!h->buf[i])
         {
+            if (i >= 2)
+                break;
             imgf_rx_destroy(h);
             return NULL;
         }
-        h->state[i] = BFREE;
+        atomic_init(&h->state[i], BFREE);
+        h->nslots = i + 1;
     }
-    h->wr_idx = 0;
+    atomic_init(&h->pub, 0);
+    h->wr_idx = -1;
     return h;
 }
 
@@ -167,12 +213,11 @@ void imgf_rx_destroy(imgf_rx_t *h)
 {
     if (!h)
         return;
-    if (h->buf[0])
-        buf_free(h->buf[0]);
-    if (h->buf[1])
-        buf_free(h->buf[1]);
-    if (h->mtx)
-        vSemaphoreDelete(h->mtx);
+    for (int i = 0; i < IMGF_RX_MAX_SLOTS; i++)
+    {
+        if (h->buf[i])
+            buf_free(h->buf[i]);
+    }
     buf_free(h);
 }
 
@@ -188,50 +233,79 @@ void imgf_rx_get_receiver(imgf_rx_t *h, usb_sr_receiver_t *out)
     out->drop = imgf_drop;
 }
 
-bool imgf_rx_get_ready(imgf_rx_t *h, const uint8_t **png, size_t *len, uint32_t *seq, int *token)
+int imgf_rx_slot_count(imgf_rx_t *h)
 {
-    if (!h || !png || !len || !token)
-        return false;
-    bool ok = false;
+    return h ? h->nslots : 0;
+}
 
-    xSemaphoreTake(h->mtx, portMAX_DELAY);
+int imgf_rx_free_slots(imgf_rx_t *h)
+{
+    if (!h)
+        return 0;
+    int n = 0;
+    for (int i = 0; i < h->nslots; i++)
+    {
+        if (atomic_load(&h->state[i]) == BFREE)
+            n++;
+    }
+    return n;
+}
 
-    int idx = -1;
-    if (h->state[0] == BREADY)
-        idx = 0;
-    else if (h->state[1] == BREADY)
-        idx = 1;
+bool imgf_rx_get_item(imgf_rx_t *h, imgf_rx_item_t *out)
+{
+    if (!h || !out)
+        return false;
 
-    if (idx >= 0)
+    for (;;)
     {
-        h->state[idx] = BREADING;
-        *png = h->buf[idx];
-        *len = h->len[idx];
-        if (seq)
-            *seq = h->seq[idx];
-        *token = idx;
-        ok = true;
+        unsigned p0 = atomic_load(&h->pub);
+        int idx = oldest_ready(h);
+        if (atomic_load(&h->pub) != p0)
+            continue; /* a commit landed mid-scan, an older slot may have been missed */
+        if (idx < 0)
+            return false;
+        /* lost the race against an IMGF_DROP_OLD steal: look again */
+        if (!slot_cas(h, idx, BREADY, BREADING))
+            continue;
+        out->data = h->buf[idx];
+        out->len = h->len[idx];
+        out->seq = h->seq[idx];
+        out->token = idx;
+        out->type = h->type[idx];
+        out->flags = h->flags[idx];
+        out->frag = h->frag[idx];
+        return true;
     }
+}
 
-    xSemaphoreGive(h->mtx);
-    return ok;
+bool imgf_rx_get_ready(imgf_rx_t *h, const uint8_t **png, size_t *len, uint32_t *seq, int *token)
+{
+    if (!png || !len || !token)
+        return false;
+
+    imgf_rx_item_t it;
+    if (!imgf_rx_get_item(h, &it))
+        return false;
+    *png = it.data;
+    *len = it.len;
+    if (seq)
+        *seq = it.seq;
+    *token = it.token;
+    return true;
 }
 
 void imgf_rx_release(imgf_rx_t *h, int token)
 {
-    if (!h || (token != 0 && token != 1))
+    if (!h || token < 0 || token >= h->nslots)
         return;
-    xSemaphoreTake(h->mtx, portMAX_DELAY);
-    h->state[token] = BFREE;
     h->len[token] = 0;
-    xSemaphoreGive(h->mtx);
+    slot_cas(h, token, BREADING, BFREE);
 }
 
 void imgf_rx_get_stats(imgf_rx_t *h, imgf_rx_stats_t *out)
 {
     if (!h || !out)
         return;
-    xSemaphoreTake(h->mtx, portMAX_DELAY);
+    /* counters are 32-bit and written by the router task only */
     *out = h->st;
-    xSemaphoreGive(h->mtx);
-}
\ No newline at end of file
+}
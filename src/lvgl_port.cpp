@@ -4,44 +4,275 @@
 #include <esp_heap_caps.h>
 #include <lvgl.h>
 #include "freertos/task.h"
+#include "sdkconfig.h"
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+#include "esp32s3/rom/cache.h"
+#endif
 
 #include "PanelLan.h"
 #include "ui.h"
 #include "squareline/ui_Home.h"
 
 #include "ui_bridge.h"
-
-// BOARD_SC01_PLUS, BOARD_SC02, BOARD_SC05, BOARD_KC01, BOARD_BC02, BOARD_SC07
-static PanelLan tft(BOARD_SC01_PLUS);
-
-/*Change to your screen resolution*/
-static const uint16_t screenWidth  = 480;
-static const uint16_t screenHeight = 320;
+#include "hud_perf.h"
+#include "hud_draw_accel.h"
+#include "hud_sched.h"
+#include "hud_bus_tune.h"
+
+// 板型：默认 BOARD_AUTO，begin() 时按触摸芯片探测（见 PanelLan::detect）；
+// 也可 -DHUD_BOARD=BOARD_SC02 等固定某一块板
+#ifndef HUD_BOARD
+#define HUD_BOARD BOARD_AUTO
+#endif
+static PanelLan tft(HUD_BOARD);
+
+// 1：flush 用 DMA 异步推屏，传输完成后才通知 LVGL，期间 LVGL 可以往另一块缓冲渲染
+#ifndef LVGL_PORT_ASYNC_FLUSH
+#define LVGL_PORT_ASYNC_FLUSH 1
+#endif
+
+// 渲染模式（见 lvgl_render_mode_t）：FULL=PSRAM 整屏双缓冲+full_refresh；
+// PARTIAL=内部 SRAM 条带双缓冲，只重绘脏区；DIRECT=PSRAM 整屏单缓冲，只重绘并推送脏区；
+// PANEL_FB=RGB 面板直接画进面板帧缓冲，不另配缓冲、不拷贝；AUTO=按探测到的面板在 PANEL_FB/PARTIAL 中选
+#ifndef LVGL_PORT_RENDER_MODE
+#define LVGL_PORT_RENDER_MODE LVGL_RENDER_AUTO
+#endif
+
+#if (LVGL_PORT_RENDER_MODE == 3) && !LV_COLOR_16_SWAP
+#error "LVGL_RENDER_PANEL_FB needs LV_COLOR_16_SWAP=1 (the panel framebuffer holds swap565)"
+#endif
+
+// LVGL 线程两次 lv_timer_handler 之间最长睡眠；有新数据时由通知提前唤醒
+#ifndef LVGL_PORT_MAX_SLEEP_MS
+#define LVGL_PORT_MAX_SLEEP_MS 50
+#endif
+
+// 1：替换 LVGL 软件 draw_ctx 的 blend，不透明填充/拷贝走 S3 PIE 向量指令（见 hud_draw_accel.h）
+#ifndef HUD_DRAW_ACCEL
+#define HUD_DRAW_ACCEL 0
+#endif
+
+// PARTIAL 模式每块条带的行数
+#ifndef LVGL_PORT_STRIPE_LINES
+#define LVGL_PORT_STRIPE_LINES 40
+#endif
+
+// 触摸：0=不注册输入设备（行车时 HUD 不接受触摸）；1=独立低优先级线程采样，有 INT 脚时按下才读 I2C（默认）；
+// 2=LVGL 每个输入周期在 lvgl 线程里直接读 I2C（旧方式，触摸与屏幕共用总线时自动退回这种）
+#ifndef LVGL_PORT_TOUCH
+#define LVGL_PORT_TOUCH 1
+#endif
+
+// 采样线程：没有 INT 脚时的轮询周期；按住期间的采样周期
+#ifndef LVGL_PORT_TOUCH_POLL_MS
+#define LVGL_PORT_TOUCH_POLL_MS 50
+#endif
+#ifndef LVGL_PORT_TOUCH_HOLD_MS
+#define LVGL_PORT_TOUCH_HOLD_MS 20
+#endif
+
+// 分辨率取自 begin() 后的面板
+static uint16_t s_hor_res = 0;
+static uint16_t s_ver_res = 0;
 
 static lv_disp_draw_buf_t draw_buf;
 static lv_color_t *buf1 = nullptr;
 static lv_color_t *buf2 = nullptr;
-static const uint32_t draw_buf_pixels = screenWidth * screenHeight;
-static lv_color_t fallback_buf1[screenWidth * 40];
-static lv_color_t fallback_buf2[screenWidth * 40];
+static lvgl_render_mode_t s_render_mode = LVGL_RENDER_PARTIAL;
 static TaskHandle_t s_lvgl_task_handle = nullptr;
 static volatile bool s_suspend_requested = false;
 static volatile bool s_is_suspended = false;
+static bool s_panel_up = false;            // lvgl_port_splash 已经初始化过屏幕
+static volatile bool s_frame_shown = false;   // 第一帧完整上屏
+static volatile uint32_t s_refr_req = 0;      // 请求的刷新周期（ms），0=LV_DISP_DEF_REFR_PERIOD
+
+// 时延统计：当前 flush 的起始时间、是否为本帧最后一块、累计 flush 次数
+static uint32_t s_flush_t0 = 0;
+static bool s_flush_last = false;
+static uint32_t s_flush_count = 0;
+
+static void flush_begin(lv_disp_drv_t *disp)
+{
+    s_flush_t0 = hud_perf_now_us();
+    s_flush_last = lv_disp_flush_is_last(disp);
+    s_flush_count++;
+}
+
+// 所有 flush 路径都从这里通知 LVGL；最后一块推完即视为本帧上屏
+static void flush_done(lv_disp_drv_t *disp)
+{
+    HUD_PERF_RECORD(HUD_PERF_FLUSH, hud_perf_now_us() - s_flush_t0);
+    if (s_flush_last) {
+        hud_perf_mark_flushed();
+        s_frame_shown = true;
+    }
+    lv_disp_flush_ready(disp);
+}
+
+#if LVGL_PORT_ASYNC_FLUSH
+static lv_disp_drv_t *volatile s_flush_drv = nullptr;  // DMA 进行中的 flush
+
+// 传输完成则通知 LVGL；LovyanGFX 没有完成回调，在 wait_cb 和 LVGL 线程循环里轮询
+static void flush_dma_poll(void)
+{
+    lv_disp_drv_t *drv = s_flush_drv;
+    if (drv && !tft.dmaBusy()) {
+        s_flush_drv = nullptr;
+        flush_done(drv);
+    }
+}
+
+static void my_disp_wait(lv_disp_drv_t *disp)
+{
+    (void)disp;
+    flush_dma_poll();
+}
+#endif
+
+/* DIRECT 模式：color_p 是整屏缓冲，脏区按屏幕坐标存放，逐行推送（整行宽时一次推完） */
+static void flush_direct(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p)
+{
+    const int32_t w = area->x2 - area->x1 + 1;
+    const int32_t h = area->y2 - area->y1 + 1;
+    lv_color_t *src = color_p + (size_t)area->y1 * s_hor_res + area->x1;
+
+#if LVGL_PORT_ASYNC_FLUSH
+    tft.waitDMA();
+#endif
+    if (w == s_hor_res) {
+        tft.pushImage(area->x1, area->y1, w, h, (lgfx::swap565_t*)&src->full);
+    } else {
+        for (int32_t y = 0; y < h; y++, src += s_hor_res) {
+            tft.pushImage(area->x1, area->y1 + y, w, 1, (lgfx::swap565_t*)&src->full);
+        }
+    }
+    flush_done(disp);
+}
+
+/* PANEL_FB 模式：LVGL 已经画在面板帧缓冲里，只需把脏行从 CPU cache 写回 PSRAM，
+   LCD_CAM 的 GDMA 直接读 PSRAM，不写回会扫出旧像素 */
+static uint32_t s_fb_stride = 0;  // 帧缓冲一行的像素数（= hor_res）
+
+static void flush_panel_fb(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p)
+{
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+    const uint32_t h = (uint32_t)(area->y2 - area->y1 + 1);
+    lv_color_t *row = color_p + (size_t)area->y1 * s_fb_stride;
+    Cache_WriteBack_Addr((uint32_t)row, h * s_fb_stride * sizeof(lv_color_t));
+#else
+    (void)area;
+    (void)color_p;
+#endif
+    flush_done(disp);
+}
 
 /* Display flushing */
 static void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p)
 {
+    if (s_render_mode == LVGL_RENDER_PANEL_FB) {
+        flush_begin(disp);
+        flush_panel_fb(disp, area, color_p);
+        return;
+    }
+
     if (tft.getStartCount() == 0) {
         tft.startWrite();
     }
+    flush_begin(disp);
+
+    if (s_render_mode == LVGL_RENDER_DIRECT) {
+        flush_direct(disp, area, color_p);
+        return;
+    }
 
+#if LVGL_PORT_ASYNC_FLUSH
+    // 只有两块缓冲，LVGL 不会在上一块未 ready 前再次 flush；这里的 wait 只是保险
+    tft.waitDMA();
+    s_flush_drv = disp;
+    tft.pushImageDMA(area->x1,
+                     area->y1,
+                     area->x2 - area->x1 + 1,
+                     area->y2 - area->y1 + 1,
+                     (lgfx::swap565_t*)&color_p->full);
+#else
     tft.pushImage(area->x1,
                   area->y1,
                   area->x2 - area->x1 + 1,
                   area->y2 - area->y1 + 1,
                   (lgfx::swap565_t*)&color_p->full);
 
-    lv_disp_flush_ready(disp);
+    flush_done(disp);
+#endif
+}
+
+/* 触摸采样线程：最新状态打包成一个 32 位字（bit31 按下，bit16-30 x，bit0-15 y），
+   单写单读，LVGL 读取不加锁、不碰 I2C */
+#define TOUCH_PRESSED 0x80000000u
+
+static volatile uint32_t s_touch_state = 0;
+static TaskHandle_t s_touch_task = nullptr;
+
+static void IRAM_ATTR touch_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_touch_task, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void touch_task(void *param)
+{
+    const int int_pin = (int)(intptr_t)param;
+    for (;;) {
+        // 有 INT 脚：触摸芯片拉低才醒；按住期间持续采样，松开后回去等
+        if (int_pin >= 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+        for (;;) {
+            uint16_t x, y;
+            const bool pressed = !s_is_suspended && tft.getTouch(&x, &y);
+            if (pressed) {
+                s_touch_state = TOUCH_PRESSED | ((uint32_t)(x & 0x7FFF) << 16) | y;
+            } else {
+                s_touch_state &= ~TOUCH_PRESSED;   // 保留最后的坐标，LVGL 用它做松开点
+            }
+            if (!pressed && int_pin >= 0) {
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(pressed ? LVGL_PORT_TOUCH_HOLD_MS : LVGL_PORT_TOUCH_POLL_MS));
+        }
+    }
+}
+
+static void touchpad_read_sampled(lv_indev_drv_t *indev_driver, lv_indev_data_t *data)
+{
+    (void)indev_driver;
+    const uint32_t st = s_touch_state;
+    data->state = (st & TOUCH_PRESSED) ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    data->point.x = (lv_coord_t)((st >> 16) & 0x7FFF);
+    data->point.y = (lv_coord_t)(st & 0xFFFF);
+}
+
+// 起采样线程；触摸与屏幕共用总线（要和推屏互斥）或线程建不起来时返回 false
+static bool touch_task_start(void)
+{
+    auto *touch = tft.touch();
+    if (!touch || touch->config().bus_shared) {
+        return false;
+    }
+    const int int_pin = tft.pins.touchPad.i2c_int;
+    if (xTaskCreatePinnedToCore(touch_task, "touch", HUD_SCHED_TOUCH_STACK, (void *)(intptr_t)int_pin,
+                                HUD_SCHED_TOUCH_PRIO, &s_touch_task,
+                                HUD_SCHED_AFFINITY(HUD_SCHED_TOUCH_CORE)) != pdPASS) {
+        return false;
+    }
+    if (int_pin >= 0) {
+        attachInterrupt(int_pin, touch_isr, FALLING);
+        xTaskNotifyGive(s_touch_task);   // 先采一次，开机时已经按着的情况
+    }
+    Serial0.printf("[LVGL] touch sampled off the render task (%s)\n", int_pin >= 0 ? "INT" : "polled");
+    return true;
 }
 
 /*Read the touchpad*/
@@ -52,6 +283,10 @@ static void my_touchpad_read(lv_indev_drv_t * indev_driver, lv_indev_data_t * da
     uint16_t touchX, touchY;
     data->state = LV_INDEV_STATE_REL;
 
+#if LVGL_PORT_ASYNC_FLUSH
+    // 部分板子触摸与屏幕共用总线，读触摸前先等推屏结束
+    tft.waitDMA();
+#endif
     if (tft.getTouch(&touchX, &touchY)) {
         data->state = LV_INDEV_STATE_PR;
         data->point.x = touchX;
@@ -63,13 +298,17 @@ static void my_touchpad_read(lv_indev_drv_t * indev_driver, lv_indev_data_t * da
 static void lvgl_task(void *param)
 {
     (void)param;
-
-    const TickType_t delayTicks = pdMS_TO_TICKS(5);
+    bool late_init_done = false;
+    uint32_t refr_applied = 0;
 
     for (;;) {
         if (s_suspend_requested) {
             if (!s_is_suspended) {
                 lv_timer_enable(false);
+#if LVGL_PORT_ASYNC_FLUSH
+                tft.waitDMA();
+                flush_dma_poll();
+#endif
                 if (tft.getStartCount() > 0) {
                     tft.endWrite();
                 }
@@ -87,81 +326,220 @@ static void lvgl_task(void *param)
             continue;
         }
 
+        // 刷新周期只能在 LVGL 线程里改
+        const uint32_t refr = s_refr_req;
+        if (refr != refr_applied) {
+            refr_applied = refr;
+            lv_timer_t *t = _lv_disp_get_refr_timer(lv_disp_get_default());
+            if (t) {
+                lv_timer_set_period(t, refr ? refr : LV_DISP_DEF_REFR_PERIOD);
+            }
+        }
+
         // 处理 UI 更新请求（你未来 CDC/router/PNG decode 都通过桥接发到这里）
         lvgl_port_poll_ui();
 
-        // LVGL 内部定时器/动画/刷新
-        lv_timer_handler();
+#if LVGL_PORT_ASYNC_FLUSH
+        flush_dma_poll();
+#endif
+
+        // LVGL 内部定时器/动画/刷新；返回值为距下一个定时器到期的毫秒数
+        const uint32_t flushes = s_flush_count;
+        const uint32_t t0 = hud_perf_now_us();
+        uint32_t sleep_ms = lv_timer_handler();
+        const uint32_t handler_us = hud_perf_now_us() - t0;
+        HUD_PERF_RECORD(HUD_PERF_TIMER, handler_us);
+        if (s_flush_count != flushes) {   // 只统计真正发生了重绘的调用
+            HUD_PERF_RECORD(HUD_PERF_RENDER, handler_us);
+        }
+        if (sleep_ms > LVGL_PORT_MAX_SLEEP_MS) {
+            sleep_ms = LVGL_PORT_MAX_SLEEP_MS;   // 含 LV_NO_TIMER_READY
+        }
+#if LVGL_PORT_ASYNC_FLUSH
+        if (s_flush_drv) {
+            sleep_ms = 1;   // DMA 未完成，尽快轮询以便 LVGL 继续下一块
+        }
+#endif
+        TickType_t ticks = pdMS_TO_TICKS(sleep_ms);
+        if (ticks == 0) {
+            ticks = 1;
+        }
+
+        // 首帧已经盖掉开机画面：再做不影响画面的耗时初始化
+        if (!late_init_done && s_frame_shown) {
+            late_init_done = true;
+            Serial0.printf("[BOOT] first frame at %u ms\n", (unsigned)millis());
+            ui_bridge_init_late();
+        }
 
-        vTaskDelay(delayTicks);
+        // 桥接层有新快照/地图时 xTaskNotifyGive 唤醒（暂停请求也走同一个通知）
+        ulTaskNotifyTake(pdTRUE, ticks);
     }
 }
 
-void lvgl_port_init(void)
+static void lvgl_wake(void *user)
 {
+    (void)user;
+    TaskHandle_t h = s_lvgl_task_handle;
+    if (h) {
+        xTaskNotifyGive(h);
+    }
+}
+
+void lvgl_port_splash(void)
+{
+    if (s_panel_up) {
+        return;
+    }
+    s_panel_up = true;
+
     // 屏幕
     tft.begin();
+    // 写时钟：NVS 里有标定结果就用，首次启动先标定（RGB 面板跳过）
+    hud_bus_tune(tft);
+#if LVGL_PORT_ASYNC_FLUSH
+    tft.initDMA();
+#endif
+
+    // 开机画面直接用 flash 里 ui_Home 的背景图（与 LV_COLOR_16_SWAP 同字节序），不经 LVGL；
+    // 背景图被资源管线换成其他格式或与面板尺寸不符时居中/清黑
+    const lv_img_dsc_t *bg = &ui_img_bg5_png;
+    tft.fillScreen(0x0000);
+    if (LV_COLOR_16_SWAP && bg->header.cf == LV_IMG_CF_TRUE_COLOR &&
+        bg->header.w <= tft.width() && bg->header.h <= tft.height()) {
+        tft.pushImage((tft.width() - bg->header.w) / 2, (tft.height() - bg->header.h) / 2,
+                      bg->header.w, bg->header.h, (const lgfx::swap565_t *)bg->data);
+    }
+    // 先画好再开背光，不闪上一次的残影
     tft.setBrightness(255);
+    Serial0.printf("[BOOT] splash at %u ms\n", (unsigned)millis());
+}
+
+void lvgl_port_init(void)
+{
+    lvgl_port_splash();
 
     // LVGL
     lv_init();
 
-    buf1 = static_cast<lv_color_t *>(
-        heap_caps_malloc(draw_buf_pixels * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
-    buf2 = static_cast<lv_color_t *>(
-        heap_caps_malloc(draw_buf_pixels * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+    // 分辨率、缓冲大小、渲染模式都按实际探测到的面板来定（旋转已含在 width/height 里）
+    s_hor_res = (uint16_t)tft.width();
+    s_ver_res = (uint16_t)tft.height();
+    const uint32_t screen_pixels = (uint32_t)s_hor_res * s_ver_res;
+    uint32_t fb_w = 0, fb_h = 0;
+    // 面板帧缓冲按显存方向存放，LVGL 坐标必须与之一致，所以只接受旋转 0
+    void *fb = tft.getRotation() == 0 ? tft.frameBuffer(&fb_w, &fb_h) : nullptr;
+    if (fb && (fb_w != s_hor_res || fb_h != s_ver_res)) {
+        fb = nullptr;
+    }
+
+    s_render_mode = (lvgl_render_mode_t)(LVGL_PORT_RENDER_MODE);
+    if (s_render_mode == LVGL_RENDER_AUTO) {
+        // RGB 面板本来就有整屏帧缓冲，直接画进去；SPI/8080 面板用 SRAM 条带
+        s_render_mode = (fb && LV_COLOR_16_SWAP) ? LVGL_RENDER_PANEL_FB : LVGL_RENDER_PARTIAL;
+    }
+    uint32_t active_pixels = screen_pixels;
+
+    if (s_render_mode == LVGL_RENDER_PANEL_FB) {
+        if (fb) {
+            buf1 = static_cast<lv_color_t *>(fb);
+            s_fb_stride = fb_w;
+        } else {
+            Serial0.println("[LVGL] no contiguous panel framebuffer, fallback to partial");
+            s_render_mode = LVGL_RENDER_PARTIAL;
+        }
+    } else if (s_render_mode != LVGL_RENDER_PARTIAL) {
+        buf1 = static_cast<lv_color_t *>(
+            heap_caps_malloc(screen_pixels * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        // DIRECT 只用一块：双缓冲时 LVGL 8 不会同步两块之间的脏区
+        if (s_render_mode == LVGL_RENDER_FULL) {
+            buf2 = static_cast<lv_color_t *>(
+                heap_caps_malloc(screen_pixels * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+        }
 
-    uint32_t active_pixels = draw_buf_pixels;
-    bool use_full_refresh = true;
+        if (!buf1 || (s_render_mode == LVGL_RENDER_FULL && !buf2)) {
+            Serial0.println("[LVGL] PSRAM draw buffer allocation failed, fallback to internal RAM");
+            if (buf1) {
+                heap_caps_free(buf1);
+                buf1 = nullptr;
+            }
+            if (buf2) {
+                heap_caps_free(buf2);
+                buf2 = nullptr;
+            }
+            s_render_mode = LVGL_RENDER_PARTIAL;
+        }
+    }
 
-    if (!buf1 || !buf2) {
-        Serial0.println("[LVGL] PSRAM draw buffer allocation failed, fallback to internal RAM");
-        if (buf1) {
+    if (s_render_mode == LVGL_RENDER_PARTIAL) {
+        // 条带按实际行宽分配；16 字节对齐，整行宽的条带可以直接走向量填充/拷贝。内部 RAM 不够就减半行数
+        for (uint32_t lines = LVGL_PORT_STRIPE_LINES; lines > 0; lines /= 2) {
+            const size_t bytes = (size_t)s_hor_res * lines * sizeof(lv_color_t);
+            buf1 = static_cast<lv_color_t *>(heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA));
+            buf2 = static_cast<lv_color_t *>(heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA));
+            if (buf1 && buf2) {
+                active_pixels = (uint32_t)s_hor_res * lines;
+                break;
+            }
             heap_caps_free(buf1);
-            buf1 = nullptr;
-        }
-        if (buf2) {
             heap_caps_free(buf2);
-            buf2 = nullptr;
+            buf1 = buf2 = nullptr;
+        }
+        if (!buf1) {
+            Serial0.println("[LVGL] no internal RAM for draw buffers");
+            return;
         }
-        buf1 = fallback_buf1;
-        buf2 = fallback_buf2;
-        active_pixels = screenWidth * 40;
-        use_full_refresh = false;
     }
+    Serial0.printf("[LVGL] %s %ux%u, render mode %d (%s, %u px per buffer)\n",
+                   PanelLan::boardName(tft.board()), (unsigned)s_hor_res, (unsigned)s_ver_res,
+                   (int)s_render_mode,
+                   s_render_mode == LVGL_RENDER_FULL ? "full" :
+                   s_render_mode == LVGL_RENDER_DIRECT ? "direct" :
+                   s_render_mode == LVGL_RENDER_PANEL_FB ? "panel-fb" : "partial",
+                   (unsigned)active_pixels);
 
     lv_disp_draw_buf_init(&draw_buf, buf1, buf2, active_pixels);
 
     static lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);
-    disp_drv.hor_res  = screenWidth;
-    disp_drv.ver_res  = screenHeight;
+    disp_drv.hor_res  = s_hor_res;
+    disp_drv.ver_res  = s_ver_res;
     disp_drv.flush_cb = my_disp_flush;
+#if LVGL_PORT_ASYNC_FLUSH
+    disp_drv.wait_cb  = my_disp_wait;
+#endif
     disp_drv.draw_buf = &draw_buf;
-    disp_drv.full_refresh = use_full_refresh ? 1 : 0;
+    disp_drv.full_refresh = (s_render_mode == LVGL_RENDER_FULL) ? 1 : 0;
+    disp_drv.direct_mode = (s_render_mode == LVGL_RENDER_DIRECT || s_render_mode == LVGL_RENDER_PANEL_FB) ? 1 : 0;
+#if HUD_DRAW_ACCEL
+    hud_draw_accel_install(&disp_drv);
+#endif
     lv_disp_drv_register(&disp_drv);
 
-    static lv_indev_drv_t indev_drv;
-    lv_indev_drv_init(&indev_drv);
-    indev_drv.type    = LV_INDEV_TYPE_POINTER;
-    indev_drv.read_cb = my_touchpad_read;
-    lv_indev_drv_register(&indev_drv);
+    if (LVGL_PORT_TOUCH != 0 && tft.touch()) {
+        static lv_indev_drv_t indev_drv;
+        lv_indev_drv_init(&indev_drv);
+        indev_drv.type    = LV_INDEV_TYPE_POINTER;
+        indev_drv.read_cb = (LVGL_PORT_TOUCH == 1 && touch_task_start()) ? touchpad_read_sampled : my_touchpad_read;
+        lv_indev_drv_register(&indev_drv);
+    }
 
     // SquareLine UI init（创建对象）
     ui_init();
 
     // 初始化 UI 桥接（队列/共享状态）
     ui_bridge_init();
+    ui_bridge_set_notify(lvgl_wake, nullptr);
 
-    // 创建 LVGL 线程（建议 pin 到 core1）
+    // 创建 LVGL 线程（默认独占 core1，见 hud_sched.h）
     xTaskCreatePinnedToCore(
         lvgl_task,
         "lvgl",
-        6144,
+        HUD_SCHED_LVGL_STACK,
         nullptr,
-        8,
+        HUD_SCHED_LVGL_PRIO,
         &s_lvgl_task_handle,
-        1
+        HUD_SCHED_AFFINITY(HUD_SCHED_LVGL_CORE)
     );
 }
 
@@ -200,6 +578,38 @@ bool lvgl_port_is_suspended(void)
     return s_is_suspended;
 }
 
+lvgl_render_mode_t lvgl_port_render_mode(void)
+{
+    return s_render_mode;
+}
+
+void lvgl_port_forget_bus_tune(void)
+{
+    hud_bus_tune_forget(tft);
+}
+
+void lvgl_port_panel_info(uint8_t *board, uint16_t *hor_res, uint16_t *ver_res, bool *swap565)
+{
+    *board = (uint8_t)tft.board();
+    *hor_res = (uint16_t)tft.width();
+    *ver_res = (uint16_t)tft.height();
+    *swap565 = LV_COLOR_16_SWAP != 0;
+}
+
+bool lvgl_port_rs485_pins(int8_t *rts, int8_t *rxd, int8_t *txd)
+{
+    *rts = tft.pins.rs485.rts;
+    *rxd = tft.pins.rs485.rxd;
+    *txd = tft.pins.rs485.txd;
+    return *rxd >= 0 && *txd >= 0;
+}
+
+void lvgl_port_set_refresh_period(uint32_t ms)
+{
+    s_refr_req = ms;
+    lvgl_wake(nullptr);
+}
+
 bool lvgl_port_set_brightness(uint8_t brightness)
 {
     tft.setBrightness(brightness);
@@ -211,6 +621,10 @@ bool lvgl_port_set_offset_rotation(uint8_t offset_rotation)
     if ((offset_rotation > 7) || ((offset_rotation & 0x01u) == 0u)) {
         return false;
     }
+    // LVGL 直接写显存，换方向后坐标对不上
+    if (s_render_mode == LVGL_RENDER_PANEL_FB) {
+        return false;
+    }
 
     auto *panel = tft.getPanel();
     if (!panel) {
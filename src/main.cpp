@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include <esp_system.h>
+#include <esp_heap_caps.h>
 
 #include "USB.h"
 #include "USBCDC.h"
@@ -9,10 +10,79 @@ extern "C" {
 #include "usb_stream_router.h"
 #include "imgf_receiver.h"
 #include "msgf_receiver.h"
+#include "hud_perf.h"
+#include "hud_stat.h"
+#include "hud_taskmon.h"
+#include "hud_heapmon.h"
+#include "hud_trace.h"
+#include "hud_sched.h"
+#include "hud_dma_copy.h"
+#include "tile_cache.h"
+#include "hud_persist.h"
+#include "hud_rs485.h"
+#include "img_r565.h"
 }
 
 #include "lvgl_port.h"
 #include "ui_bridge.h"
+#include "hud_bench.h"
+#include "hud_usb_vendor.h"
+
+/* 帧 CRC 校验开关：接收端边拷贝边累计 CRC，开销很小；开启后上位机必须填写 crc32 */
+#ifndef HUD_REQUIRE_CRC
+#define HUD_REQUIRE_CRC 0
+#endif
+
+/* 'STAT' 遥测上报周期（ms），0 关闭；上位机据此判断是否丢帧并自行降速 */
+#ifndef HUD_STAT_PERIOD_MS
+#define HUD_STAT_PERIOD_MS 1000
+#endif
+
+/* 'CRED' 流控额度：每释放一个 IMGF 缓冲立即上报，空闲时至少每隔该周期上报一次；0 关闭 */
+#ifndef HUD_CREDIT_PERIOD_MS
+#define HUD_CREDIT_PERIOD_MS 250
+#endif
+
+/* 任务监视：每隔该周期（ms）在 Serial0 打印各任务栈余量/优先级/CPU 与各核占用，0 关闭；
+   上位机随时可用 CMD=0x07 取回同样的数据（'TASK' 帧） */
+#ifndef HUD_TASKMON_LOG_MS
+#define HUD_TASKMON_LOG_MS 0
+#endif
+
+/* 没有 FreeRTOS 运行时统计的内核上用 idle 钩子估算各核占用；钩子让空闲核空转不进 WAITI，只在测量时打开 */
+#ifndef HUD_TASKMON_IDLE_HOOK
+#define HUD_TASKMON_IDLE_HOOK 0
+#endif
+
+/* 定期保存最后画面（快照进 NVS、地图进 "lastmap" 分区）的周期（ms），0 只在休眠和 CMD=0x01 时保存；
+   内容没变不写 flash，地图变了才擦写（约 34 个扇区，分散在几秒里） */
+#ifndef HUD_PERSIST_PERIOD_MS
+#define HUD_PERSIST_PERIOD_MS (5 * 60 * 1000)
+#endif
+
+/* 电源状态（见 power_mgr_task）：USB 静默这么久休眠（停 LVGL、屏幕 sleep） */
+#ifndef HUD_PM_SUSPEND_MS
+#define HUD_PM_SUSPEND_MS (60 * 1000)
+#endif
+
+/* 进入省电态：USB 静默这么久，或车速为 0 持续这么久（0 关闭该条件） */
+#ifndef HUD_PM_ECO_IDLE_MS
+#define HUD_PM_ECO_IDLE_MS (10 * 1000)
+#endif
+#ifndef HUD_PM_ECO_PARKED_MS
+#define HUD_PM_ECO_PARKED_MS (30 * 1000)
+#endif
+
+/* 省电态：LVGL 刷新周期（ms）、背光按设定亮度的百分比、CPU 频率（MHz，0 不改） */
+#ifndef HUD_PM_ECO_REFR_MS
+#define HUD_PM_ECO_REFR_MS 100
+#endif
+#ifndef HUD_PM_ECO_DIM_PCT
+#define HUD_PM_ECO_DIM_PCT 40
+#endif
+#ifndef HUD_PM_ECO_CPU_MHZ
+#define HUD_PM_ECO_CPU_MHZ 80
+#endif
 
 /* -------- CDC transport -------- */
 
@@ -23,6 +93,30 @@ static int tp_read(void *ctx, uint8_t *dst, int max){
     return ((USBCDC*)ctx)->read(dst, max);
 }
 
+static int tp_write(void *ctx, const uint8_t *src, int len){
+    return (int)((USBCDC*)ctx)->write(src, (size_t)len);
+}
+
+/* CDC RX 事件 -> 唤醒路由线程，替代逐 tick 轮询 */
+static void (*s_tp_notify)(void *arg) = nullptr;
+static void *s_tp_notify_arg = nullptr;
+
+static void cdc_rx_event(void *arg, esp_event_base_t base, int32_t id, void *data){
+    (void)arg;
+    (void)base;
+    (void)id;
+    (void)data;
+    if (s_tp_notify) {
+        s_tp_notify(s_tp_notify_arg);
+    }
+}
+
+static void tp_set_rx_notify(void *ctx, void (*notify)(void *arg), void *arg){
+    s_tp_notify_arg = arg;
+    s_tp_notify = notify;
+    ((USBCDC*)ctx)->onEvent(ARDUINO_USB_CDC_RX_EVENT, cdc_rx_event);
+}
+
 /* -------- router / receivers -------- */
 
 static usb_stream_router_t *router;
@@ -31,12 +125,30 @@ static msgf_rx_t *msgf;
 static volatile uint32_t g_last_usb_rx_ms = 0;
 static volatile bool g_ui_suspended = false;
 static volatile bool g_resume_requested = false;
+static volatile bool g_eco = false;
+static volatile uint8_t g_brightness = 255;   // 主机设定的亮度（CMD=0x02），省电态在它基础上调暗
+static TaskHandle_t g_telemetry_task = nullptr;
+static uint32_t g_imgf_max_bytes = 0;
+static uint16_t g_msgf_max_bytes = 0;
+static uint8_t g_msgf_queue_depth = 0;
+static bool g_tile_cache_ok = false;
 
 /* -------- 释放回调适配器 -------- */
 
 static void imgf_release_adapter(int token)
 {
     imgf_rx_release(imgf, token);
+    // 缓冲空出来了：让遥测线程马上把新额度告诉上位机
+    if (g_telemetry_task) {
+        xTaskNotifyGive(g_telemetry_task);
+    }
+}
+
+// 省电态按设定亮度的 HUD_PM_ECO_DIM_PCT 调暗
+static bool apply_brightness(void)
+{
+    const uint32_t b = g_brightness;
+    return lvgl_port_set_brightness((uint8_t)(g_eco ? b * HUD_PM_ECO_DIM_PCT / 100 : b));
 }
 
 static void on_usb_rx_activity(void *user, size_t bytes)
@@ -49,6 +161,15 @@ static void on_usb_rx_activity(void *user, size_t bytes)
     }
 }
 
+static bool send_hello(void);
+
+// hud_trace_dump 的发送回调：每次一帧 'TRCE'
+static bool send_trace_frame(const void *frame, size_t len, void *ctx)
+{
+    (void)ctx;
+    return usb_sr_send(router, HUD_TRACE_MAGIC, 0, 0, frame, len);
+}
+
 static void handle_msg_command(const uint8_t *msg, size_t len, uint32_t seq)
 {
     if (!msg || len < 1) {
@@ -66,6 +187,9 @@ static void handle_msg_command(const uint8_t *msg, size_t len, uint32_t seq)
 
         case 0x01:
             Serial0.println("[MSG] CMD=0x01 restart requested");
+            // 快照本来就在 RTC 内存里；地图只在变过时才写
+            hud_persist_flush_snapshot();
+            (void)ui_bridge_save_map();
             vTaskDelay(pdMS_TO_TICKS(20));
             esp_restart();
             break;
@@ -76,7 +200,8 @@ static void handle_msg_command(const uint8_t *msg, size_t len, uint32_t seq)
                 break;
             }
             const uint8_t brightness = payload[0];
-            if (lvgl_port_set_brightness(brightness)) {
+            g_brightness = brightness;
+            if (apply_brightness()) {
                 Serial0.printf("[MSG] CMD=0x02 brightness=%u\n", (unsigned)brightness);
             } else {
                 Serial0.printf("[MSG] CMD=0x02 failed, brightness=%u\n", (unsigned)brightness);
@@ -99,6 +224,75 @@ static void handle_msg_command(const uint8_t *msg, size_t len, uint32_t seq)
             break;
         }
 
+        case 0x04: {
+            // 时延统计：回一帧 'PERF'；参数 bit0=读后清零
+            uint8_t out[HUD_PERF_WIRE_BYTES];
+            const size_t n = hud_perf_serialize(out, sizeof(out));
+            const bool sent = usb_sr_send(router, HUD_PERF_MAGIC, 0, 0, out, n);
+            if (payload_len >= 1 && (payload[0] & 0x01)) {
+                hud_perf_reset();
+            }
+            Serial0.printf("[MSG] CMD=0x04 perf stats %s (%u bytes)\n", sent ? "sent" : "send failed", (unsigned)n);
+            break;
+        }
+
+        case 0x05:
+            // 增量快照：基准对不上时丢弃（不打印，24Hz 会刷屏），上位机定期发整包重新同步
+            (void)ui_request_msg_delta(payload, payload_len, seq);
+            break;
+
+        case 0x06: {
+            // 批量：若干条 [u8 len][u32 seq][消息]，一帧头、一次路由收取，按顺序分发（不允许嵌套）
+            size_t p = 0;
+            while (p + 5 <= payload_len) {
+                const size_t n = payload[p];
+                const uint32_t s = (uint32_t)payload[p + 1] | ((uint32_t)payload[p + 2] << 8) |
+                                   ((uint32_t)payload[p + 3] << 16) | ((uint32_t)payload[p + 4] << 24);
+                p += 5;
+                if (n == 0 || p + n > payload_len || payload[p] == 0x06) {
+                    Serial0.printf("[MSG] CMD=0x06 malformed entry at %u\n", (unsigned)(p - 5));
+                    break;
+                }
+                handle_msg_command(payload + p, n, s);
+                p += n;
+            }
+            break;
+        }
+
+        case 0x07: {
+            // 任务监视：回一帧 'TASK'，窗口为上一次查询到现在（只在 app 线程里处理，静态缓冲不用占栈）
+            static hud_taskmon_mark_t mark;
+            static hud_taskmon_report_t rep;
+            static uint8_t out[HUD_TASKMON_WIRE_BYTES];
+            hud_taskmon_sample(&mark, &rep);
+            const size_t n = hud_taskmon_serialize(&rep, out, sizeof(out));
+            const bool sent = n && usb_sr_send(router, HUD_TASKMON_MAGIC, 0, 0, out, n);
+            Serial0.printf("[MSG] CMD=0x07 task stats %s (%u tasks)\n", sent ? "sent" : "send failed",
+                           (unsigned)rep.ntasks);
+            break;
+        }
+
+        case 0x08:
+            // 清掉总线时钟标定结果，下次启动重新标定（换屏或出现花屏时用，通常紧跟 CMD=0x01）
+            lvgl_port_forget_bus_tune();
+            Serial0.println("[MSG] CMD=0x08 bus clock calibration cleared");
+            break;
+
+        case 0x09: {
+            // 能力握手：回一帧 'HELO'（主机连上时发一次，见 hud_stat.h）
+            const bool sent = send_hello();
+            Serial0.printf("[MSG] CMD=0x09 hello %s\n", sent ? "sent" : "send failed");
+            break;
+        }
+
+        case 0x0A: {
+            // 事件追踪：各核环形缓冲按时间顺序回若干帧 'TRCE'；参数 bit0=读后清空（见 hud_trace.h）
+            const bool clear = payload_len >= 1 && (payload[0] & 0x01);
+            const bool sent = hud_trace_dump(send_trace_frame, nullptr, clear);
+            Serial0.printf("[MSG] CMD=0x0A trace %s\n", sent ? "sent" : "send failed");
+            break;
+        }
+
         default:
             // Reserved for future commands.
             Serial0.printf("[MSG] unknown CMD=0x%02X, len=%u\n", cmd, (unsigned)len);
@@ -108,50 +302,158 @@ static void handle_msg_command(const uint8_t *msg, size_t len, uint32_t seq)
 
 /* -------- 业务线程 -------- */
 
+static TaskHandle_t g_app_task = nullptr;
+
+/* 接收器提交回调（路由 RX 任务里）：唤醒 app_task */
+static void wake_app_task(void *arg)
+{
+    (void)arg;
+    TaskHandle_t t = g_app_task;
+    if (t) {
+        xTaskNotifyGive(t);
+    }
+}
+
+/* 瓦片布局里缓存没有的瓦片：回一帧 'TMIS'，主机补发这些 TILE（解码线程调用） */
+static void on_tile_miss(const void *keys, size_t len, void *user)
+{
+    (void)user;
+    if (!router) {
+        return;     // 启动恢复时 USB 尚未就绪，主机连上后会重发布局
+    }
+    usb_sr_send(router, TILE_MISS_MAGIC, 0, 0, keys, len);
+}
+
+/* 零拷贝：将buffer所有权转移给UI系统，由UI系统在使用完成后释放。
+   返回 false 表示桥接队列已满，分片/修补仍归调用方，稍后重试 */
+static bool dispatch_image(const imgf_rx_item_t *it)
+{
+    HUD_TRACE(HUD_TR_IMG_DISPATCH, it->seq, ((uint32_t)it->type << 24) | (it->len & 0xFFFFFFu));
+    if (it->type == IMGF_TYPE_PNG_FRAG) {
+        return ui_request_png_frag(it->data, it->len, it->frag, it->flags, it->token, imgf_release_adapter);
+    }
+    if (it->type == IMGF_TYPE_R565_RECT) {
+        return ui_request_map_rect(it->data, it->len, it->token, imgf_release_adapter);
+    }
+    if (it->type == IMGF_TYPE_TRACK) {
+        return ui_request_track(it->data, it->len, it->token, imgf_release_adapter);
+    }
+    if (it->type == IMGF_TYPE_TILE) {
+        return ui_request_tile(it->data, it->len, it->token, imgf_release_adapter);
+    }
+    if (it->type == IMGF_TYPE_TILE_MAP) {
+        return ui_request_tile_map(it->data, it->len, it->token, imgf_release_adapter);
+    }
+    if (it->type == IMGF_TYPE_TILE_VIEW) {
+        return ui_request_tile_view(it->data, it->len, it->token, imgf_release_adapter);
+    }
+    if (it->type == IMGF_TYPE_R565) {
+        ui_request_set_r565(it->data, it->len, it->token, imgf_release_adapter);
+    } else {
+        ui_request_set_png(it->data, it->len, it->token, imgf_release_adapter);
+    }
+    return true;
+}
+
 static void app_task(void *param)
 {
     (void)param;
 
+    /* 桥接队列满时暂存的图片分片（分片不能丢，下一轮重试） */
+    imgf_rx_item_t pending = {};
+    bool has_pending = false;
+
     for (;;) {
-        /* ---- 短消息（先留空） ---- */
-        uint8_t msg[1024];
+        /* ---- 短消息：直接在接收池里解析，处理完再归还槽位 ---- */
+        const uint8_t *msg;
         size_t mlen;
         uint32_t mseq;
-        while (msgf_rx_pop(msgf, msg, sizeof(msg), &mlen, &mseq)) {
+        while (msgf_rx_peek(msgf, &msg, &mlen, &mseq)) {
             handle_msg_command(msg, mlen, mseq);
+            msgf_rx_release(msgf);
         }
 
-        /* ---- 图片 ---- */
-        const uint8_t *png;
-        size_t plen;
-        uint32_t pseq;
-        int token;
-
-        if (imgf_rx_get_ready(imgf, &png, &plen, &pseq, &token)) {
-                /* 零拷贝：将buffer所有权转移给UI系统 */
-                Serial0.println("Got PNG");
-                ui_request_set_png(png, plen, token, imgf_release_adapter);
-                        /* 不再提前释放，由UI系统在使用完成后释放 */
+        /* ---- 图片：先重试卡住的分片，再取完为止 ---- */
+        if (has_pending) {
+            has_pending = !dispatch_image(&pending);
         }
+        while (!has_pending && imgf_rx_get_item(imgf, &pending)) {
+            has_pending = !dispatch_image(&pending);
+        }
+
+        // 没事做就睡到接收器提交新帧；有分片卡在桥接队列时隔几毫秒重试一次
+        ulTaskNotifyTake(pdTRUE, has_pending ? pdMS_TO_TICKS(2) : portMAX_DELAY);
+    }
+}
 
-        vTaskDelay(pdMS_TO_TICKS(1));
+/* -------- 电源管理 --------
+   ACTIVE：正常刷新。
+   ECO：停车（车速为 0）超过 HUD_PM_ECO_PARKED_MS，或 USB 静默超过 HUD_PM_ECO_IDLE_MS。
+        LVGL 降到 HUD_PM_ECO_REFR_MS 一帧、暂停地图解码、背光调暗、CPU 降频；车一动或数据回来立即恢复。
+   SUSPEND：USB 静默 HUD_PM_SUSPEND_MS，停 LVGL、屏幕 sleep。
+   不用 esp_pm 自动轻睡：USB-OTG CDC 在轻睡里断开，主机会认为设备掉线；空闲时 FreeRTOS idle 本来就 WAITI 停核。 */
+
+static uint32_t g_cpu_mhz_full = 0;
+
+static void set_eco(bool on, const char *why)
+{
+    if (g_eco == on) {
+        return;
     }
+    g_eco = on;
+    lvgl_port_set_refresh_period(on ? HUD_PM_ECO_REFR_MS : 0);
+    ui_bridge_set_map_paused(on);
+    (void)apply_brightness();
+    if (HUD_PM_ECO_CPU_MHZ > 0 && g_cpu_mhz_full > HUD_PM_ECO_CPU_MHZ) {
+        setCpuFrequencyMhz(on ? HUD_PM_ECO_CPU_MHZ : g_cpu_mhz_full);
+    }
+    Serial0.printf("[PM] %s (%s)\n", on ? "eco" : "active", why);
 }
 
 static void power_mgr_task(void *param)
 {
     (void)param;
-    const uint32_t idle_sleep_ms = 60 * 1000;
     const TickType_t poll_ticks = pdMS_TO_TICKS(200);
+    uint32_t last_persist = millis();
+    uint32_t parked_since = 0;
+    bool parked_seen = false;
+    g_cpu_mhz_full = getCpuFrequencyMhz();
 
     for (;;) {
         const uint32_t now = millis();
-        const uint32_t last = g_last_usb_rx_ms;
+        const uint32_t quiet_ms = now - g_last_usb_rx_ms;
 
-        if (!g_ui_suspended && (uint32_t)(now - last) >= idle_sleep_ms) {
-            Serial0.println("[PM] USB idle 60s, suspend UI");
+        int16_t speed = 0;
+        if (ui_bridge_last_speed(&speed) && speed == 0) {
+            if (!parked_seen) {
+                parked_seen = true;
+                parked_since = now;
+            }
+        } else {
+            parked_seen = false;
+        }
+
+        if (!g_ui_suspended && quiet_ms >= HUD_PM_SUSPEND_MS) {
+            Serial0.printf("[PM] USB idle %us, suspend UI\n", (unsigned)(HUD_PM_SUSPEND_MS / 1000));
             lvgl_port_suspend();
             g_ui_suspended = true;
+            // 多半是熄火：把最后的画面存下来，下次上电直接显示
+            hud_persist_flush_snapshot();
+            (void)ui_bridge_save_map();
+        }
+
+        if (!g_ui_suspended) {
+            const bool parked = HUD_PM_ECO_PARKED_MS > 0 && parked_seen &&
+                                (uint32_t)(now - parked_since) >= HUD_PM_ECO_PARKED_MS;
+            const bool quiet = HUD_PM_ECO_IDLE_MS > 0 && quiet_ms >= HUD_PM_ECO_IDLE_MS;
+            set_eco(parked || quiet, parked ? "parked" : quiet ? "USB quiet" : "moving");
+        }
+
+        // 直接断电的车上等不到休眠，定期补存（内容没变时不写 flash）
+        if (HUD_PERSIST_PERIOD_MS > 0 && !g_ui_suspended && (uint32_t)(now - last_persist) >= HUD_PERSIST_PERIOD_MS) {
+            last_persist = now;
+            hud_persist_flush_snapshot();
+            (void)ui_bridge_save_map();
         }
 
         if (g_ui_suspended && g_resume_requested) {
@@ -166,56 +468,306 @@ static void power_mgr_task(void *param)
     }
 }
 
+/* -------- 遥测上报 -------- */
+
+static void send_stat(void)
+{
+    usb_sr_stats_t us;
+    imgf_rx_stats_t is;
+    msgf_rx_stats_t ms;
+    ui_bridge_stats_t bs;
+    hud_perf_summary_t dec;
+    usb_sr_get_stats(router, &us);
+    imgf_rx_get_stats(imgf, &is);
+    msgf_rx_get_stats(msgf, &ms);
+    ui_bridge_get_stats(&bs);
+    hud_perf_get(HUD_PERF_IMG_DECODE, &dec);
+    hud_heapmon_report_t hm;
+    hud_heapmon_sample(&hm);
+
+    hud_stat_wire_t w = {};
+    w.version            = HUD_STAT_WIRE_VERSION;
+    w.period_ms          = HUD_STAT_PERIOD_MS;
+    w.uptime_ms          = millis();
+    w.usb_bytes_rx       = (uint32_t)us.bytes_rx;
+    w.usb_frames_ok      = us.frames_ok;
+    w.usb_frames_dropped = us.frames_dropped;
+    w.usb_resync         = us.resync_count;
+    w.usb_frames_timeout = us.frames_timeout;
+    w.imgf_ok            = is.frames_ok;
+    w.imgf_drop          = is.frames_drop;
+    w.imgf_bad           = is.frames_bad;
+    w.msgf_ok            = ms.frames_ok;
+    w.msgf_drop          = ms.frames_drop;
+    w.msgf_bad           = ms.frames_bad;
+    w.ui_img_replaced    = bs.img_replaced;
+    w.ui_img_pending     = (uint16_t)bs.img_pending;
+    w.heap_free_internal = hm.internal.free;
+    w.heap_min_internal  = hm.internal.min_free;
+    w.heap_free_psram    = hm.psram.free;
+    w.decode_count       = dec.count;
+    w.decode_avg_us      = dec.avg_us;
+    w.decode_p99_us      = dec.p99_us;
+    w.heap_min_psram         = hm.psram.min_free;
+    w.heap_largest_internal  = hm.internal.largest;
+    w.heap_largest_psram     = hm.psram.largest;
+    w.heap_largest_min_psram = hm.psram.largest_min;
+    w.heap_psram_trend       = hm.psram.largest_trend;
+
+    usb_sr_send(router, HUD_STAT_MAGIC, 0, 0, &w, sizeof(w));
+}
+
+// 'HELO'：固件能力与屏幕/地图尺寸，主机据此选编码、按面板出图（CMD=0x09 时回送）
+static bool send_hello(void)
+{
+    uint8_t board;
+    uint16_t scr_w, scr_h, map_w, map_h;
+    bool swap565;
+    lvgl_port_panel_info(&board, &scr_w, &scr_h, &swap565);
+    ui_bridge_map_size(&map_w, &map_h);
+
+    hud_hello_wire_t w = {};
+    w.version       = HUD_HELLO_WIRE_VERSION;
+    w.board         = board;
+    w.proto_rev     = HUD_PROTO_REV;
+    w.screen_w      = scr_w;
+    w.screen_h      = scr_h;
+    w.map_w         = map_w;
+    w.map_h         = map_h;
+    w.imgf_types    = (uint8_t)((1u << (IMGF_TYPE_TILE_VIEW + 1)) - 1);
+    w.r565_codecs   = (uint8_t)((1u << (R565_CODEC_QOI + 1)) - 1);
+    w.frame_codecs  = HUD_HELLO_CODEC_LZ4;
+    w.features      = HUD_HELLO_F_MUXF |
+                      (HUD_REQUIRE_CRC ? HUD_HELLO_F_CRC_REQUIRED : 0) |
+                      (swap565 ? HUD_HELLO_F_SWAP565 : 0) |
+                      (g_tile_cache_ok ? HUD_HELLO_F_TILE_CACHE : 0) |
+                      (HUD_STAT_PERIOD_MS > 0 ? HUD_HELLO_F_STAT : 0) |
+                      (HUD_CREDIT_PERIOD_MS > 0 ? HUD_HELLO_F_CRED : 0);
+    w.msgf_cmds     = (1u << (0x0A + 1)) - 1;   // 0x00..0x0A，见 handle_msg_command
+    w.img_max_bytes = g_imgf_max_bytes;
+    w.msg_max_bytes = g_msgf_max_bytes;
+    w.img_slots     = (uint8_t)imgf_rx_slot_count(imgf);
+    w.msg_queue     = g_msgf_queue_depth;
+    w.mux_channels  = USB_SR_MUX_CHANNELS;
+
+    return usb_sr_send(router, HUD_HELLO_MAGIC, 0, 0, &w, sizeof(w));
+}
+
+static void send_credit(void)
+{
+    imgf_rx_stats_t is;
+    msgf_rx_stats_t ms;
+    imgf_rx_get_stats(imgf, &is);
+    msgf_rx_get_stats(msgf, &ms);
+
+    hud_cred_wire_t w = {};
+    w.version       = HUD_CRED_WIRE_VERSION;
+    w.img_free      = (uint8_t)imgf_rx_free_slots(imgf);
+    w.img_slots     = (uint8_t)imgf_rx_slot_count(imgf);
+    w.msg_free      = (uint8_t)msgf_rx_free_space(msgf);
+    w.img_seen      = is.frames_seen;
+    w.msg_seen      = ms.frames_seen;
+    w.img_max_bytes = g_imgf_max_bytes;
+
+    usb_sr_send(router, HUD_CRED_MAGIC, 0, 0, &w, sizeof(w));
+}
+
+static void print_tasks(const hud_taskmon_report_t *r)
+{
+    Serial0.printf("[TASK] %u ms window, cpu", (unsigned)r->window_ms);
+    for (int c = 0; c < r->ncores; c++) {
+        if (r->core_busy[c] == HUD_TASKMON_UNKNOWN) {
+            Serial0.printf(" core%d -", c);
+        } else {
+            Serial0.printf(" core%d %u%%", c, (unsigned)r->core_busy[c]);
+        }
+    }
+    Serial0.printf("%s\n", (r->flags & HUD_TASKMON_F_IDLE_EST) ? " (idle-hook estimate)" : "");
+    Serial0.printf("[TASK] %-11s %4s %4s %4s %10s\n", "name", "core", "prio", "cpu", "stack_free");
+    for (int i = 0; i < r->ntasks; i++) {
+        const hud_taskmon_task_t *t = &r->task[i];
+        char core[4] = "any", cpu[5] = "-";
+        if (t->core != HUD_TASKMON_ANY_CORE) snprintf(core, sizeof(core), "%u", (unsigned)t->core);
+        if (t->cpu_pct != HUD_TASKMON_UNKNOWN) snprintf(cpu, sizeof(cpu), "%u%%", (unsigned)t->cpu_pct);
+        // 当前优先级高于分配值：它正持有一个高优先级任务在等的互斥量（优先级继承）
+        Serial0.printf("[TASK] %-11.11s %4s %3u%c %4s %10u\n", t->name, core, (unsigned)t->prio,
+                       t->prio > t->base_prio ? '!' : ' ', cpu, (unsigned)t->stack_free);
+    }
+}
+
+static void telemetry_task(void *param)
+{
+    (void)param;
+    const TickType_t wait = HUD_CREDIT_PERIOD_MS > 0 ? pdMS_TO_TICKS(HUD_CREDIT_PERIOD_MS)
+                          : HUD_STAT_PERIOD_MS > 0 ? pdMS_TO_TICKS(HUD_STAT_PERIOD_MS)
+                                                   : pdMS_TO_TICKS(HUD_TASKMON_LOG_MS);
+    uint32_t last_stat = millis();
+    uint32_t last_tasks = millis();
+    static hud_taskmon_mark_t tm_mark;
+    static hud_taskmon_report_t tm_rep;
+
+    for (;;) {
+        // 释放缓冲时被提前唤醒；连续释放合并为一次上报
+        ulTaskNotifyTake(pdTRUE, wait);
+        // 本地日志与主机在不在线无关
+        if (HUD_TASKMON_LOG_MS > 0 && (uint32_t)(millis() - last_tasks) >= HUD_TASKMON_LOG_MS) {
+            last_tasks = millis();
+            hud_taskmon_sample(&tm_mark, &tm_rep);
+            print_tasks(&tm_rep);
+            // 串口日志下也能看碎片趋势（RS485 环境关了 STAT）；与 send_stat 同一任务采样
+            hud_heapmon_report_t hm;
+            hud_heapmon_sample(&hm);
+            Serial0.printf("[HEAP] internal free %u largest %u min %u | psram free %u largest %u (min %u, %+d B/h)\n",
+                           (unsigned)hm.internal.free, (unsigned)hm.internal.largest, (unsigned)hm.internal.min_free,
+                           (unsigned)hm.psram.free, (unsigned)hm.psram.largest, (unsigned)hm.psram.largest_min,
+                           (int)hm.psram.largest_trend);
+            if (HUD_RS485) {
+                hud_rs485_stats_t rs;
+                hud_rs485_get_stats(&rs);
+                Serial0.printf("[RS485] overflows %u line_errs %u\n", (unsigned)rs.overflows, (unsigned)rs.line_errs);
+            }
+        }
+        // 主机空闲导致 UI 休眠时不上报（主机不在线，写也只会失败）
+        if (g_ui_suspended) {
+            continue;
+        }
+        if (HUD_CREDIT_PERIOD_MS > 0) {
+            send_credit();
+        }
+        const uint32_t now = millis();
+        if (HUD_STAT_PERIOD_MS > 0 && (uint32_t)(now - last_stat) >= HUD_STAT_PERIOD_MS) {
+            last_stat = now;
+            send_stat();
+        }
+    }
+}
+
 /* -------- Arduino entry -------- */
 
 void setup()
 {
     Serial0.begin(115200);
 
-    /* UI */
-    lvgl_port_init();
+    // 追踪缓冲最先分配，之后的各阶段都能记下
+    if (!hud_trace_init()) {
+        Serial0.println("[MAIN] trace buffers unavailable, event trace off");
+    }
 
-    /* USB CDC */
-    USB.begin();
-    USBSerial.begin();
+    // 任务监视按名字找任务，之后才创建的任务也能看到
+    if (!hud_taskmon_init(HUD_TASKMON_IDLE_HOOK || HUD_BENCH)) {
+        Serial0.println("[MAIN] idle hooks unavailable, core usage not measured");
+    }
+    static const char *const k_watch[] = {"usb_sr", "rs485", "app", "pm", "telemetry", "lvgl", "img_dec", "png_rows", "tile_wr", "touch", "bench"};
+    for (const char *name : k_watch) {
+        hud_taskmon_watch(name);
+    }
+
+    // 大块位图拷贝走 GDMA；安装失败时 hud_dma_copy 自动退回 memcpy
+    if (!hud_dma_copy_init()) {
+        Serial0.println("[MAIN] GDMA memcpy unavailable, bulk copies use the CPU");
+    }
+
+    // 断电前的快照（RTC 内存/NVS）与地图（"lastmap" 分区），没有该分区时只恢复快照
+    if (!hud_persist_init()) {
+        Serial0.println("[MAIN] no lastmap partition, the map is not kept across reboots");
+    }
+
+    // 地图瓦片缓存（"tiles" 分区），没有该分区时瓦片帧照常显示、只是不缓存
+    g_tile_cache_ok = tile_cache_init();
+    if (!g_tile_cache_ok) {
+        Serial0.println("[MAIN] no tile cache partition, map tiles are not cached");
+    }
+
+    /* 开机画面：flash 里的 RGB565 背景图直接推屏，不等 LVGL */
+    lvgl_port_splash();
 
+    /* USB CDC：紧跟开机画面，主机在 UI 构建期间就能枚举、开始推流；
+       快照/地图先缓在接收器里，业务线程在 UI 建好后才创建、取走。
+       HUD_USB_VENDOR 构建里路由器改走 vendor 批量端点（接口描述符要在 USB.begin() 之前登记） */
     usb_sr_transport_t tp = {
         .ctx = &USBSerial,
         .available = tp_available,
-        .read = tp_read
+        .read = tp_read,
+        .read_into = tp_read,
+        .set_rx_notify = tp_set_rx_notify,
+        .write = tp_write
     };
+    const bool vendor_tp = hud_usb_vendor_init(&tp);
+    if (HUD_USB_VENDOR && !vendor_tp) {
+        Serial0.println("[MAIN] USB vendor interface unavailable, streaming over CDC");
+    }
+    // HUD_RS485 构建里路由器改接板载 RS-485（没有引出 RS-485 的板子仍走 USB）
+    int8_t rs485_rts, rs485_rxd, rs485_txd;
+    if (HUD_RS485 && !vendor_tp) {
+        if (lvgl_port_rs485_pins(&rs485_rts, &rs485_rxd, &rs485_txd) &&
+            hud_rs485_init(rs485_rts, rs485_rxd, rs485_txd, &tp)) {
+            Serial0.printf("[MAIN] streaming over RS-485 at %u baud (rx %d tx %d rts %d)\n",
+                           (unsigned)HUD_RS485_BAUD, rs485_rxd, rs485_txd, rs485_rts);
+        } else {
+            Serial0.println("[MAIN] no RS-485 on this board, streaming over USB");
+        }
+    }
+    USB.begin();
+    USBSerial.begin();
 
     usb_sr_config_t rcfg = {
-        .rx_task_priority = 18,
-        .rx_task_stack    = 6144,
-        .rx_task_core     = 0,
+        .rx_task_priority = HUD_SCHED_USB_SR_PRIO,
+        .rx_task_stack    = HUD_SCHED_USB_SR_STACK,
+        .rx_task_core     = HUD_SCHED_USB_SR_CORE,
         .read_chunk       = 8192,
         .max_receivers    = 4,
         .on_rx_activity   = on_usb_rx_activity,
-        .on_rx_activity_user = nullptr
+        .on_rx_activity_user = nullptr,
+        .frame_timeout_ms = 300   // 帧内超过 300ms 无数据则丢弃该帧并重新同步
     };
 
     router = usb_sr_create(&tp, &rcfg);
 
     imgf_rx_config_t icfg = {
         .max_png_bytes = 128 * 1024,
-        .require_crc   = false,
-        .drop_policy   = IMGF_DROP_OLD
+        .require_crc   = HUD_REQUIRE_CRC,
+        .drop_policy   = IMGF_DROP_OLD,
+        .slots         = 3,            // 解码中 + 就绪 + 接收中，互不阻塞
+        .mem_reserve   = 512 * 1024,   // 第3个缓冲仅在PSRAM余量足够时分配(2MB板)
+        .on_commit     = wake_app_task,
+        .on_commit_arg = nullptr
     };
     imgf = imgf_rx_create(&icfg);
+    g_imgf_max_bytes = (uint32_t)icfg.max_png_bytes;
     usb_sr_receiver_t ir;
     imgf_rx_get_receiver(imgf, &ir);
     usb_sr_register(router, &ir);
 
     msgf_rx_config_t mcfg = {
-        .max_msg_bytes = 1024,
-        .queue_depth   = 8,
-        .require_crc   = false
+        .max_msg_bytes   = 1024,
+        .queue_depth     = 8,
+        .require_crc     = HUD_REQUIRE_CRC,
+        // 队列满时整包快照只留最新；增量快照总是相对整包，丢了无妨；命令按序可靠
+        .latest_cmd_mask = 1u << 0x00,
+        .on_commit       = wake_app_task,
+        .on_commit_arg   = nullptr
     };
     msgf = msgf_rx_create(&mcfg);
+    g_msgf_max_bytes = (uint16_t)mcfg.max_msg_bytes;
+    g_msgf_queue_depth = (uint8_t)mcfg.queue_depth;
     usb_sr_receiver_t mr;
     msgf_rx_get_receiver(msgf, &mr);
     usb_sr_register(router, &mr);
+    Serial0.printf("[BOOT] usb at %u ms\n", (unsigned)millis());
+
+    /* UI：LVGL 和控件树在 USB 起来之后再建，期间屏幕上是开机画面 */
+    lvgl_port_init();
+    Serial0.printf("[BOOT] ui at %u ms\n", (unsigned)millis());
+    // 地图解码放到独立线程，LVGL 不再因解码卡顿（核/优先级见 hud_sched.h）
+    ui_bridge_start_decoder(HUD_SCHED_DECODE_CORE, HUD_SCHED_DECODE_PRIO, HUD_SCHED_DECODE_STACK);
+    ui_bridge_set_tile_miss(on_tile_miss, nullptr);
+    // 不等主机：先显示断电前的快照与地图（没有保存的位图时用上次的瓦片布局拼）
+    ui_bridge_restore_snapshot();
+    ui_bridge_restore_map();
+    // 基准测试构建：固件自己灌合成快照/地图并周期打印汇总（见 hud_bench.h）
+    if (HUD_BENCH) {
+        hud_bench_start();
+    }
 
     g_last_usb_rx_ms = millis();
 
@@ -223,22 +775,38 @@ void setup()
     xTaskCreatePinnedToCore(
         app_task,
         "app",
-        4096,
+        HUD_SCHED_APP_STACK,
         nullptr,
-        4,
-        nullptr,
-        0
+        HUD_SCHED_APP_PRIO,
+        &g_app_task,
+        HUD_SCHED_AFFINITY(HUD_SCHED_APP_CORE)
     );
 
-    xTaskCreatePinnedToCore(
-        power_mgr_task,
-        "pm",
-        4096,
-        nullptr,
-        3,
-        nullptr,
-        0
-    );
+    // 基准测试时没有上位机，不能因 USB 空闲而休眠
+    if (!HUD_BENCH) {
+        xTaskCreatePinnedToCore(
+            power_mgr_task,
+            "pm",
+            HUD_SCHED_PM_STACK,
+            nullptr,
+            HUD_SCHED_PM_PRIO,
+            nullptr,
+            HUD_SCHED_AFFINITY(HUD_SCHED_PM_CORE)
+        );
+    }
+
+    if (HUD_STAT_PERIOD_MS > 0 || HUD_CREDIT_PERIOD_MS > 0 || HUD_TASKMON_LOG_MS > 0) {
+        xTaskCreatePinnedToCore(
+            telemetry_task,
+            "telemetry",
+            HUD_SCHED_TELEMETRY_STACK,
+            nullptr,
+            HUD_SCHED_TELEMETRY_PRIO,
+            &g_telemetry_task,
+            HUD_SCHED_AFFINITY(HUD_SCHED_TELEMETRY_CORE)
+        );
+    }
+    Serial0.printf("[MAIN] sched profile %s\n", HUD_SCHED_PROFILE_NAME);
     Serial0.println("Init done");
 }
 
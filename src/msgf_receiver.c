@@ -1,9 +1,7 @@
 #include "msgf_receiver.h"
+#include "hud_perf.h"
 #include <string.h>
-
-#include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
-#include "freertos/semphr.h"
+#include <stdatomic.h>
 
 #if __has_include("esp_heap_caps.h")
 #include "esp_heap_caps.h"
@@ -21,66 +19,137 @@ static void mem_free(void *p) { free(p); }
 
 #define MAGIC_MSGF 0x4647534Du /* 'MSGF' little endian */
 
+#define MBOX_N 3           /* triple buffer: producer back, shared middle, consumer front */
+#define MBOX_FRESH 0x4u    /* set in mid when the middle buffer holds an undelivered message */
+
+enum
+{
+    PEEK_NONE = 0,
+    PEEK_RING,
+    PEEK_MBOX
+};
+
 typedef struct
 {
-    uint8_t *buf;
     size_t len;
     uint32_t seq;
-} msg_item_t;
+    uint32_t stamp; /* arrival order across ring and mailbox */
+} msg_slot_t;
 
+/* Ring: head/tail are free-running counters, slot = counter % depth.
+     head  written by the router (release after the slot is filled)
+     tail  written by the consumer (release after it is done with the slot)
+   Mailbox: the router fills its back buffer and swaps it into mid; the consumer swaps its
+   front buffer out of mid when MBOX_FRESH is set. Whoever holds a buffer index owns it. */
 struct msgf_rx
 {
     msgf_rx_config_t cfg;
-    QueueHandle_t q;
-    SemaphoreHandle_t mtx;
 
     /* pool */
-    uint8_t *pool; /* queue_depth * max_msg_bytes */
+    uint8_t *pool; /* (queue_depth + MBOX_N) * max_msg_bytes: ring slots, then mailbox */
     int depth;
+    msg_slot_t *ring;
+    msg_slot_t mbox[MBOX_N];
+
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_uint mid;
 
-    /* writing temp */
-    int cur_slot;
+    /* router task only */
+    uint8_t *wr;      /* buffer handed out by acquire, NULL none */
+    bool wr_ring;     /* wr is ring slot head % depth (else mailbox back) */
+    int back;
+    uint32_t next_stamp;
+
+    /* consumer only */
+    int front;
+    bool front_full;
+    uint8_t peeked; /* PEEK_*: message handed out by peek, freed by release */
 
     msgf_rx_stats_t st;
 };
 
+static uint8_t *slot_buf(msgf_rx_t *h, int i)
+{
+    return h->pool + (size_t)i * h->cfg.max_msg_bytes;
+}
+
+static uint8_t *mbox_buf(msgf_rx_t *h, int i)
+{
+    return slot_buf(h, h->depth + i);
+}
+
 static void *msgf_acquire(void *user, const usb_sr_hdr_t *hdr, size_t *capacity)
 {
     msgf_rx_t *h = (msgf_rx_t *)user;
     if (!h)
         return NULL;
+    h->st.frames_seen++;
 
-    /* best effort: if queue full, drop new */
-    if (uxQueueSpacesAvailable(h->q) == 0)
+    const unsigned head = atomic_load_explicit(&h->head, memory_order_relaxed);
+    const unsigned tail = atomic_load_explicit(&h->tail, memory_order_acquire);
+    if (head - tail < (unsigned)h->depth)
+    {
+        h->wr = slot_buf(h, (int)(head % (unsigned)h->depth));
+        h->wr_ring = true;
+    }
+    else if (h->cfg.latest_cmd_mask)
+    {
+        /* ring full: only a latest-wins message can still get in, decided once the CMD is known */
+        h->wr = mbox_buf(h, h->back);
+        h->wr_ring = false;
+    }
+    else
     {
         h->st.frames_drop++;
         return NULL;
     }
 
-    xSemaphoreTake(h->mtx, portMAX_DELAY);
-    int slot = h->cur_slot;
-    h->cur_slot = (h->cur_slot + 1) % h->depth;
-    xSemaphoreGive(h->mtx);
-
-    uint8_t *p = h->pool + (size_t)slot * h->cfg.max_msg_bytes;
     *capacity = h->cfg.max_msg_bytes;
     (void)hdr;
-    return p;
+    HUD_PERF_MARK(hdr->seq, HUD_PERF_STAGE_HDR);
+    return h->wr;
 }
 
 static void msgf_commit(void *user, const usb_sr_hdr_t *hdr, void *buf, size_t len)
 {
     msgf_rx_t *h = (msgf_rx_t *)user;
-    msg_item_t it = {
-        .buf = (uint8_t *)buf,
-        .len = len,
-        .seq = hdr->seq};
-    if (xQueueSend(h->q, &it, 0) != pdTRUE)
-    {
-        h->st.frames_drop++;
+    (void)buf;
+    if (!h->wr)
         return;
+    h->wr = NULL;
+
+    if (h->wr_ring)
+    {
+        const unsigned head = atomic_load_explicit(&h->head, memory_order_relaxed);
+        msg_slot_t *s = &h->ring[head % (unsigned)h->depth];
+        s->len = len;
+        s->seq = hdr->seq;
+        s->stamp = h->next_stamp++;
+        atomic_store_explicit(&h->head, head + 1, memory_order_release);
     }
+    else
+    {
+        const uint8_t cmd = len ? mbox_buf(h, h->back)[0] : 0xff;
+        if (cmd >= 32 || !(h->cfg.latest_cmd_mask & (1u << cmd)))
+        {
+            h->st.frames_drop++; /* reliable message, no room */
+            return;
+        }
+        msg_slot_t *s = &h->mbox[h->back];
+        s->len = len;
+        s->seq = hdr->seq;
+        s->stamp = h->next_stamp++;
+        const unsigned old = atomic_exchange_explicit(&h->mid, (unsigned)h->back | MBOX_FRESH,
+                                                      memory_order_acq_rel);
+        h->back = (int)(old & ~MBOX_FRESH);
+        if (old & MBOX_FRESH)
+            h->st.frames_drop++; /* replaced an undelivered one */
+    }
+    HUD_PERF_MARK(hdr->seq, HUD_PERF_STAGE_COMMIT);
     h->st.frames_ok++;
+    if (h->cfg.on_commit)
+        h->cfg.on_commit(h->cfg.on_commit_arg);
 }
 
 static void msgf_drop(void *user, const usb_sr_hdr_t *hdr, int reason)
@@ -89,6 +158,7 @@ static void msgf_drop(void *user, const usb_sr_hdr_t *hdr, int reason)
     (void)hdr;
     (void)reason;
     h->st.frames_bad++;
+    h->wr = NULL; /* nothing was published, the buffer is simply reused */
 }
 
 msgf_rx_t *msgf_rx_create(const msgf_rx_config_t *cfg)
@@ -103,28 +173,19 @@ msgf_rx_t *msgf_rx_create(const msgf_rx_config_t *cfg)
     h->cfg = *cfg;
     h->depth = cfg->queue_depth;
 
-    h->q = xQueueCreate((UBaseType_t)h->depth, sizeof(msg_item_t));
-    if (!h->q)
-    {
-        msgf_rx_destroy(h);
-        return NULL;
-    }
-
-    h->mtx = xSemaphoreCreateMutex();
-    if (!h->mtx)
-    {
-        msgf_rx_destroy(h);
-        return NULL;
-    }
-
-    h->pool = (uint8_t *)mem_alloc((size_t)h->depth * h->cfg.max_msg_bytes);
-    if (!h->pool)
+    h->ring = (msg_slot_t *)mem_alloc((size_t)h->depth * sizeof(msg_slot_t));
+    h->pool = (uint8_t *)mem_alloc((size_t)(h->depth + MBOX_N) * h->cfg.max_msg_bytes);
+    if (!h->ring || !h->pool)
     {
         msgf_rx_destroy(h);
         return NULL;
     }
 
-    h->cur_slot = 0;
+    atomic_init(&h->head, 0);
+    atomic_init(&h->tail, 0);
+    atomic_init(&h->mid, 1);
+    h->back = 0;
+    h->front = 2;
     return h;
 }
 
@@ -134,10 +195,8 @@ void msgf_rx_destroy(msgf_rx_t *h)
         return;
     if (h->pool)
         mem_free(h->pool);
-    if (h->q)
-        vQueueDelete(h->q);
-    if (h->mtx)
-        vSemaphoreDelete(h->mtx);
+    if (h->ring)
+        mem_free(h->ring);
     mem_free(h);
 }
 
@@ -153,30 +212,93 @@ void msgf_rx_get_receiver(msgf_rx_t *h, usb_sr_receiver_t *out)
     out->drop = msgf_drop;
 }
 
+bool msgf_rx_peek(msgf_rx_t *h, const uint8_t **data, size_t *len, uint32_t *seq)
+{
+    if (!h || !data || !len)
+        return false;
+
+    if (h->peeked == PEEK_NONE)
+    {
+        /* mailbox first: any ring message committed before it is then visible as well */
+        if (!h->front_full && (atomic_load_explicit(&h->mid, memory_order_relaxed) & MBOX_FRESH))
+        {
+            const unsigned old = atomic_exchange_explicit(&h->mid, (unsigned)h->front, memory_order_acq_rel);
+            h->front = (int)(old & ~MBOX_FRESH);
+            h->front_full = true;
+        }
+
+        const unsigned tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+        const bool ring_any = atomic_load_explicit(&h->head, memory_order_acquire) != tail;
+        const msg_slot_t *rs = ring_any ? &h->ring[tail % (unsigned)h->depth] : NULL;
+
+        if (h->front_full && (!rs || (int32_t)(h->mbox[h->front].stamp - rs->stamp) < 0))
+            h->peeked = PEEK_MBOX;
+        else if (rs)
+            h->peeked = PEEK_RING;
+        else
+            return false;
+    }
+
+    const msg_slot_t *s;
+    if (h->peeked == PEEK_MBOX)
+    {
+        s = &h->mbox[h->front];
+        *data = mbox_buf(h, h->front);
+    }
+    else
+    {
+        const unsigned tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+        s = &h->ring[tail % (unsigned)h->depth];
+        *data = slot_buf(h, (int)(tail % (unsigned)h->depth));
+    }
+    *len = s->len;
+    if (seq)
+        *seq = s->seq;
+    return true;
+}
+
+void msgf_rx_release(msgf_rx_t *h)
+{
+    if (!h)
+        return;
+    if (h->peeked == PEEK_RING)
+        atomic_store_explicit(&h->tail, atomic_load_explicit(&h->tail, memory_order_relaxed) + 1,
+                              memory_order_release);
+    else if (h->peeked == PEEK_MBOX)
+        h->front_full = false;
+    h->peeked = PEEK_NONE;
+}
+
 bool msgf_rx_pop(msgf_rx_t *h, uint8_t *dst, size_t dst_cap, size_t *out_len, uint32_t *out_seq)
 {
     if (!h || !dst || dst_cap == 0)
         return false;
 
-    msg_item_t it;
-    if (xQueueReceive(h->q, &it, 0) != pdTRUE)
+    const uint8_t *src;
+    size_t n;
+    if (!msgf_rx_peek(h, &src, &n, out_seq))
         return false;
-
-    size_t n = it.len;
     if (n > dst_cap)
         n = dst_cap;
-    memcpy(dst, it.buf, n);
-
+    memcpy(dst, src, n);
     if (out_len)
         *out_len = n;
-    if (out_seq)
-        *out_seq = it.seq;
+    msgf_rx_release(h);
     return true;
 }
 
+int msgf_rx_free_space(msgf_rx_t *h)
+{
+    if (!h)
+        return 0;
+    const unsigned used = atomic_load(&h->head) - atomic_load(&h->tail);
+    return h->depth - (int)used;
+}
+
 void msgf_rx_get_stats(msgf_rx_t *h, msgf_rx_stats_t *out)
 {
     if (!h || !out)
         return;
+    /* counters are 32-bit and written by the router task only */
     *out = h->st;
-}
\ No newline at end of file
+}
@@ -0,0 +1,140 @@
+#include "png_pipe.h"
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "hud_sched.h"
+
+struct png_pipe
+{
+    png_stream_t *ps;
+    png_stream_begin_fn begin;
+    png_stream_row_fn row;
+    void *user;
+
+    /* free_rows counts empty slots, full_rows filled ones: the semaphores are the only
+       handshake between the stages and also order the slot contents across cores */
+    SemaphoreHandle_t free_rows;
+    SemaphoreHandle_t full_rows;
+    uint8_t *ring;
+    uint32_t slot; /* bytes per slot */
+    uint32_t ys[PNG_PIPE_ROWS];
+    uint32_t head; /* feeder only */
+    uint32_t tail; /* worker only */
+    volatile bool drop;
+};
+
+static void rows_task(void *arg)
+{
+    png_pipe_t *pp = (png_pipe_t *)arg;
+    for (;;)
+    {
+        xSemaphoreTake(pp->full_rows, portMAX_DELAY);
+        const uint32_t i = pp->tail % PNG_PIPE_ROWS;
+        if (!pp->drop)
+            png_stream_finish_row(pp->ps, pp->ys[i], pp->ring + (size_t)i * pp->slot);
+        pp->tail++;
+        xSemaphoreGive(pp->free_rows);
+    }
+}
+
+/* wait until the worker has returned every slot, i.e. no row is in flight */
+static void drain(png_pipe_t *pp)
+{
+    for (int k = 0; k < PNG_PIPE_ROWS; k++)
+        xSemaphoreTake(pp->free_rows, portMAX_DELAY);
+    for (int k = 0; k < PNG_PIPE_ROWS; k++)
+        xSemaphoreGive(pp->free_rows);
+}
+
+/* runs in feed before the first row of an image, with the ring drained */
+static bool pipe_begin(void *user, const png_stream_info_t *info)
+{
+    png_pipe_t *pp = (png_pipe_t *)user;
+    if (info->raw_len > pp->slot)
+    {
+        heap_caps_free(pp->ring);
+        pp->ring = (uint8_t *)heap_caps_malloc((size_t)info->raw_len * PNG_PIPE_ROWS,
+                                               MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!pp->ring)
+            pp->ring = (uint8_t *)heap_caps_malloc((size_t)info->raw_len * PNG_PIPE_ROWS, MALLOC_CAP_8BIT);
+        pp->slot = pp->ring ? info->raw_len : 0;
+        if (!pp->ring)
+            return false;
+    }
+    return !pp->begin || pp->begin(pp->user, info);
+}
+
+static void pipe_row(void *user, uint32_t y, const uint8_t *rgba)
+{
+    png_pipe_t *pp = (png_pipe_t *)user;
+    pp->row(pp->user, y, rgba);
+}
+
+static bool pipe_raw(void *user, uint32_t y, const uint8_t *raw, uint32_t len)
+{
+    png_pipe_t *pp = (png_pipe_t *)user;
+    xSemaphoreTake(pp->free_rows, portMAX_DELAY);
+    const uint32_t i = pp->head % PNG_PIPE_ROWS;
+    memcpy(pp->ring + (size_t)i * pp->slot, raw, len);
+    pp->ys[i] = y;
+    pp->head++;
+    xSemaphoreGive(pp->full_rows);
+    return true;
+}
+
+png_pipe_t *png_pipe_create(png_stream_begin_fn begin, png_stream_row_fn row, void *user)
+{
+    if (!row)
+        return NULL;
+    png_pipe_t *pp = (png_pipe_t *)heap_caps_calloc(1, sizeof(*pp), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!pp)
+        return NULL;
+    pp->begin = begin;
+    pp->row = row;
+    pp->user = user;
+    pp->ps = png_stream_create(pipe_begin, pipe_row, pp);
+    pp->free_rows = xSemaphoreCreateCounting(PNG_PIPE_ROWS, PNG_PIPE_ROWS);
+    pp->full_rows = xSemaphoreCreateCounting(PNG_PIPE_ROWS, 0);
+    if (pp->ps && pp->free_rows && pp->full_rows)
+    {
+        png_stream_set_split(pp->ps, pipe_raw);
+        if (xTaskCreatePinnedToCore(rows_task, "png_rows", HUD_SCHED_PNG_ROWS_STACK, pp, HUD_SCHED_PNG_ROWS_PRIO,
+                                    NULL, HUD_SCHED_AFFINITY(HUD_SCHED_PNG_ROWS_CORE)) == pdPASS)
+            return pp;
+    }
+    if (pp->free_rows)
+        vSemaphoreDelete(pp->free_rows);
+    if (pp->full_rows)
+        vSemaphoreDelete(pp->full_rows);
+    png_stream_destroy(pp->ps);
+    heap_caps_free(pp);
+    return NULL;
+}
+
+void png_pipe_reset(png_pipe_t *pp)
+{
+    if (!pp)
+        return;
+    pp->drop = true;
+    drain(pp);
+    pp->drop = false;
+    png_stream_reset(pp->ps);
+}
+
+int png_pipe_feed(png_pipe_t *pp, const uint8_t *data, size_t len)
+{
+    if (!pp)
+        return PNG_STREAM_ERR;
+    const int r = png_stream_feed(pp->ps, data, len);
+    if (r != PNG_STREAM_MORE)
+    {
+        /* DONE: the last rows are still on the worker; ERR: drop them */
+        pp->drop = r == PNG_STREAM_ERR;
+        drain(pp);
+        pp->drop = false;
+    }
+    return r;
+}
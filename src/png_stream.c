@@ -0,0 +1,964 @@
+#include "png_stream.h"
+#include <string.h>
+
+#if __has_include("esp_heap_caps.h")
+#include "esp_heap_caps.h"
+/* inflate window and row buffers are hit per byte: keep them in internal RAM when possible */
+static void *ps_alloc(size_t n)
+{
+    void *p = heap_caps_malloc(n, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (p)
+        return p;
+    return heap_caps_malloc(n, MALLOC_CAP_8BIT);
+}
+static void ps_free(void *p) { heap_caps_free(p); }
+#else
+#include <stdlib.h>
+static void *ps_alloc(size_t n) { return malloc(n); }
+static void ps_free(void *p) { free(p); }
+#endif
+
+#define PS_MAX_W 4096
+#define PS_WIN_SIZE 32768u
+#define PS_WIN_MASK (PS_WIN_SIZE - 1)
+/* hand inflated bytes to the row stage before the window could wrap over them */
+#define PS_FLUSH_AT 16384u
+#define HUFF_FAST_BITS 9
+
+/* -------- Huffman tables (canonical, puff-style + first-level lookup) -------- */
+typedef struct
+{
+    int16_t count[16];
+    int16_t symbol[288];
+    uint16_t fast[1 << HUFF_FAST_BITS]; /* (len << 9) | sym, 0 -> slow path */
+} huff_t;
+
+static int huff_build(huff_t *h, const uint8_t *lens, int n)
+{
+    int16_t offs[16];
+    memset(h->count, 0, sizeof(h->count));
+    memset(h->fast, 0, sizeof(h->fast));
+    for (int s = 0; s < n; s++)
+        h->count[lens[s]]++;
+    if (h->count[0] == n)
+        return 0; /* no codes: only valid for an unused distance tree */
+
+    int left = 1;
+    for (int len = 1; len < 16; len++)
+    {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0)
+            return -1; /* over-subscribed */
+    }
+
+    offs[1] = 0;
+    for (int len = 1; len < 15; len++)
+        offs[len + 1] = (int16_t)(offs[len] + h->count[len]);
+    for (int s = 0; s < n; s++)
+    {
+        if (lens[s])
+            h->symbol[offs[lens[s]]++] = (int16_t)s;
+    }
+
+    int code = 0, idx = 0;
+    for (int len = 1; len <= HUFF_FAST_BITS; len++)
+    {
+        for (int k = 0; k < h->count[len]; k++)
+        {
+            int rev = 0;
+            for (int b = 0; b < len; b++)
+                rev |= ((code >> b) & 1) << (len - 1 - b);
+            uint16_t e = (uint16_t)((len << 9) | h->symbol[idx++]);
+            for (int j = rev; j < (1 << HUFF_FAST_BITS); j += 1 << len)
+                h->fast[j] = e;
+            code++;
+        }
+        code <<= 1;
+    }
+    return left;
+}
+
+static const uint16_t s_len_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t s_len_ext[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t s_dist_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                         193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                         6145, 8193, 12289, 16385, 24577};
+static const uint8_t s_dist_ext[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                       7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const uint8_t s_clen_order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+static huff_t s_fixed_len, s_fixed_dist;
+static bool s_fixed_ready = false;
+
+static void build_fixed(void)
+{
+    if (s_fixed_ready)
+        return;
+    uint8_t l[288];
+    int s = 0;
+    for (; s < 144; s++)
+        l[s] = 8;
+    for (; s < 256; s++)
+        l[s] = 9;
+    for (; s < 280; s++)
+        l[s] = 7;
+    for (; s < 288; s++)
+        l[s] = 8;
+    huff_build(&s_fixed_len, l, 288);
+    memset(l, 5, 30);
+    huff_build(&s_fixed_dist, l, 30);
+    s_fixed_ready = true;
+}
+
+/* -------- Resumable inflate (zlib wrapper) --------
+   Every state consumes a bounded number of bits and only commits once they are all
+   available, so running out of input simply returns and the next IDAT piece resumes. */
+enum
+{
+    Z_HDR,
+    Z_BLOCK,
+    Z_STORED_LEN,
+    Z_STORED_COPY,
+    Z_TABLE_COUNTS,
+    Z_TABLE_CLEN,
+    Z_TABLE_LENS,
+    Z_TABLE_REP,
+    Z_LEN_SYM,
+    Z_LEN_EXTRA,
+    Z_DIST_SYM,
+    Z_DIST_EXTRA,
+    Z_TRAILER,
+    Z_DONE
+};
+
+enum
+{
+    P_SIG,
+    P_CHUNK_HDR,
+    P_CHUNK_DATA,
+    P_CHUNK_CRC,
+    P_END
+};
+
+struct png_stream
+{
+    png_stream_begin_fn begin;
+    png_stream_row_fn row;
+    png_stream_raw_fn raw; /* split mode: filtered rows go here, png_stream_finish_row does the rest */
+    void *user;
+    int result;
+
+    /* container */
+    int pst;
+    uint8_t acc[8];
+    uint32_t acc_got;
+    uint32_t chunk_len;
+    uint32_t chunk_type;
+    uint32_t chunk_left;
+    bool have_ihdr;
+    bool begun;
+    uint8_t meta[13]; /* IHDR data */
+
+    uint32_t w, h;
+    uint8_t depth, ctype;
+    uint8_t palette[256][4];
+    int pal_n;
+    bool pal_trns;
+
+    /* rows */
+    uint32_t row_len; /* filter byte + scanline */
+    uint32_t row_pos;
+    uint32_t bpp;     /* filter distance in bytes */
+    uint32_t y;
+    uint8_t *cur, *prev, *rgba;
+    uint32_t row_cap;
+
+    /* inflate */
+    int zst;
+    uint32_t bitbuf;
+    int bitcnt;
+    bool last_block;
+    uint32_t stored_left;
+    int hlit, hdist, hclen, lens_idx;
+    int rep_sym;
+    uint32_t match_len;
+    int sym;
+    const huff_t *lcode, *dcode;
+    huff_t dyn_len, dyn_dist;
+    uint8_t lens[320];
+    uint8_t *win;
+    uint32_t wpos, flushed;
+};
+
+static uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+#define FOURCC(a, b, c, d) (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+/* -------- Row stage -------- */
+static void unfilter(const png_stream_t *ps, uint8_t *cur, const uint8_t *prev)
+{
+    uint8_t *x = cur + 1;
+    const uint8_t *p = prev + 1;
+    const uint32_t n = ps->row_len - 1, bpp = ps->bpp;
+
+    switch (cur[0])
+    {
+    case 1:
+        for (uint32_t i = bpp; i < n; i++)
+            x[i] = (uint8_t)(x[i] + x[i - bpp]);
+        break;
+    case 2:
+        for (uint32_t i = 0; i < n; i++)
+            x[i] = (uint8_t)(x[i] + p[i]);
+        break;
+    case 3:
+        for (uint32_t i = 0; i < bpp; i++)
+            x[i] = (uint8_t)(x[i] + (p[i] >> 1));
+        for (uint32_t i = bpp; i < n; i++)
+            x[i] = (uint8_t)(x[i] + ((x[i - bpp] + p[i]) >> 1));
+        break;
+    case 4:
+        for (uint32_t i = 0; i < n; i++)
+        {
+            int a = (i >= bpp) ? x[i - bpp] : 0;
+            int c = (i >= bpp) ? p[i - bpp] : 0;
+            int b = p[i];
+            int pa = b - c, pb = a - c, pc = a + b - 2 * c;
+            pa = pa < 0 ? -pa : pa;
+            pb = pb < 0 ? -pb : pb;
+            pc = pc < 0 ? -pc : pc;
+            int pr = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+            x[i] = (uint8_t)(x[i] + pr);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void convert_row(const png_stream_t *ps, const uint8_t *cur)
+{
+    const uint8_t *s = cur + 1;
+    uint8_t *d = ps->rgba;
+    const uint32_t w = ps->w;
+
+    switch (ps->ctype)
+    {
+    case 2:
+        for (uint32_t i = 0; i < w; i++, s += 3, d += 4)
+        {
+            d[0] = s[0];
+            d[1] = s[1];
+            d[2] = s[2];
+            d[3] = 0xff;
+        }
+        break;
+    case 6:
+        memcpy(d, s, (size_t)w * 4);
+        break;
+    case 4:
+        for (uint32_t i = 0; i < w; i++, s += 2, d += 4)
+        {
+            d[0] = d[1] = d[2] = s[0];
+            d[3] = s[1];
+        }
+        break;
+    default: /* 0 gray, 3 palette, any bit depth <= 8 */
+    {
+        const int dep = ps->depth;
+        const int mask = (1 << dep) - 1;
+        const int scale = 255 / mask;
+        for (uint32_t i = 0; i < w; i++, d += 4)
+        {
+            uint32_t bit = i * (uint32_t)dep;
+            int v = (s[bit >> 3] >> (8 - dep - (int)(bit & 7))) & mask;
+            if (ps->ctype == 3)
+            {
+                memcpy(d, ps->palette[v], 4);
+            }
+            else
+            {
+                d[0] = d[1] = d[2] = (uint8_t)(v * scale);
+                d[3] = 0xff;
+            }
+        }
+        break;
+    }
+    }
+}
+
+static bool rows_push(png_stream_t *ps, const uint8_t *p, uint32_t n)
+{
+    while (n && ps->y < ps->h)
+    {
+        uint32_t take = ps->row_len - ps->row_pos;
+        if (take > n)
+            take = n;
+        memcpy(ps->cur + ps->row_pos, p, take);
+        ps->row_pos += take;
+        p += take;
+        n -= take;
+        if (ps->row_pos < ps->row_len)
+            break;
+
+        if (ps->cur[0] > 4)
+            return false;
+        if (ps->raw)
+        {
+            /* the other stage keeps its own previous row: cur is free again once copied */
+            if (!ps->raw(ps->user, ps->y, ps->cur, ps->row_len))
+                return false;
+            ps->y++;
+            ps->row_pos = 0;
+            continue;
+        }
+        unfilter(ps, ps->cur, ps->prev);
+        convert_row(ps, ps->cur);
+        ps->row(ps->user, ps->y, ps->rgba);
+        ps->y++;
+        ps->row_pos = 0;
+        uint8_t *t = ps->prev;
+        ps->prev = ps->cur;
+        ps->cur = t;
+    }
+    return true;
+}
+
+/* move inflated bytes [flushed, wpos) from the window into the row stage */
+static bool win_flush(png_stream_t *ps)
+{
+    while (ps->flushed != ps->wpos)
+    {
+        uint32_t at = ps->flushed & PS_WIN_MASK;
+        uint32_t n = ps->wpos - ps->flushed;
+        if (n > PS_WIN_SIZE - at)
+            n = PS_WIN_SIZE - at;
+        if (!rows_push(ps, ps->win + at, n))
+            return false;
+        ps->flushed += n;
+    }
+    return true;
+}
+
+/* -------- Inflate -------- */
+static int huff_decode(png_stream_t *ps, const huff_t *h)
+{
+    uint16_t e = h->fast[ps->bitbuf & ((1u << HUFF_FAST_BITS) - 1)];
+    if (e && (e >> 9) <= ps->bitcnt)
+    {
+        ps->bitbuf >>= (e >> 9);
+        ps->bitcnt -= (e >> 9);
+        return e & 0x1ff;
+    }
+
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len < 16; len++)
+    {
+        if (len > ps->bitcnt)
+            return -1; /* need more input */
+        code |= (int)((ps->bitbuf >> (len - 1)) & 1);
+        int count = h->count[len];
+        if (code - count < first)
+        {
+            ps->bitbuf >>= len;
+            ps->bitcnt -= len;
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return -2; /* invalid code */
+}
+
+/* not enough bits buffered: top up from the input, or park until the next piece */
+#define NEED(nb)                         \
+    do                                   \
+    {                                    \
+        if (ps->bitcnt < (nb))           \
+        {                                \
+            if (in < end)                \
+                goto refill;             \
+            return PNG_STREAM_MORE;      \
+        }                                \
+    } while (0)
+#define NEED_MORE()                      \
+    do                                   \
+    {                                    \
+        if (in < end)                    \
+            goto refill;                 \
+        return PNG_STREAM_MORE;          \
+    } while (0)
+
+static uint32_t take_bits(png_stream_t *ps, int nb)
+{
+    uint32_t v = ps->bitbuf & ((1u << nb) - 1);
+    ps->bitbuf >>= nb;
+    ps->bitcnt -= nb;
+    return v;
+}
+
+static int inflate_run(png_stream_t *ps, const uint8_t *in, uint32_t n)
+{
+    const uint8_t *end = in + n;
+
+    for (;;)
+    {
+    refill:
+        while (ps->bitcnt <= 24 && in < end)
+        {
+            ps->bitbuf |= (uint32_t)(*in++) << ps->bitcnt;
+            ps->bitcnt += 8;
+        }
+
+        switch (ps->zst)
+        {
+        case Z_HDR:
+        {
+            NEED(16);
+            uint32_t cmf = take_bits(ps, 8), flg = take_bits(ps, 8);
+            if ((cmf & 0x0f) != 8 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20))
+                return PNG_STREAM_ERR;
+            ps->zst = Z_BLOCK;
+            break;
+        }
+
+        case Z_BLOCK:
+        {
+            if (ps->last_block)
+            {
+                ps->zst = Z_TRAILER;
+                break;
+            }
+            NEED(3);
+            ps->last_block = take_bits(ps, 1) != 0;
+            uint32_t type = take_bits(ps, 2);
+            if (type == 0)
+            {
+                take_bits(ps, ps->bitcnt & 7); /* to byte boundary */
+                ps->zst = Z_STORED_LEN;
+            }
+            else if (type == 1)
+            {
+                ps->lcode = &s_fixed_len;
+                ps->dcode = &s_fixed_dist;
+                ps->zst = Z_LEN_SYM;
+            }
+            else if (type == 2)
+            {
+                ps->zst = Z_TABLE_COUNTS;
+            }
+            else
+            {
+                return PNG_STREAM_ERR;
+            }
+            break;
+        }
+
+        case Z_STORED_LEN:
+        {
+            NEED(32);
+            uint32_t len = take_bits(ps, 16), nlen = take_bits(ps, 16);
+            if ((len ^ 0xffff) != nlen)
+                return PNG_STREAM_ERR;
+            ps->stored_left = len;
+            ps->zst = len ? Z_STORED_COPY : Z_BLOCK;
+            break;
+        }
+
+        case Z_STORED_COPY:
+        {
+            /* bytes parked in bitbuf first (always whole bytes here), then straight from input */
+            while (ps->stored_left && ps->bitcnt >= 8)
+            {
+                ps->win[ps->wpos++ & PS_WIN_MASK] = (uint8_t)take_bits(ps, 8);
+                ps->stored_left--;
+            }
+            if (ps->wpos - ps->flushed >= PS_FLUSH_AT && !win_flush(ps))
+                return PNG_STREAM_ERR;
+            while (ps->stored_left && in < end)
+            {
+                uint32_t at = ps->wpos & PS_WIN_MASK;
+                uint32_t k = (uint32_t)(end - in);
+                if (k > ps->stored_left)
+                    k = ps->stored_left;
+                if (k > PS_WIN_SIZE - at)
+                    k = PS_WIN_SIZE - at;
+                if (k > PS_FLUSH_AT)
+                    k = PS_FLUSH_AT;
+                memcpy(ps->win + at, in, k);
+                in += k;
+                ps->wpos += k;
+                ps->stored_left -= k;
+                if (!win_flush(ps))
+                    return PNG_STREAM_ERR;
+            }
+            if (ps->stored_left)
+                return PNG_STREAM_MORE;
+            ps->zst = Z_BLOCK;
+            break;
+        }
+
+        case Z_TABLE_COUNTS:
+            NEED(14);
+            ps->hlit = (int)take_bits(ps, 5) + 257;
+            ps->hdist = (int)take_bits(ps, 5) + 1;
+            ps->hclen = (int)take_bits(ps, 4) + 4;
+            if (ps->hlit > 286 || ps->hdist > 30)
+                return PNG_STREAM_ERR;
+            memset(ps->lens, 0, 19);
+            ps->lens_idx = 0;
+            ps->zst = Z_TABLE_CLEN;
+            break;
+
+        case Z_TABLE_CLEN:
+            while (ps->lens_idx < ps->hclen)
+            {
+                NEED(3);
+                ps->lens[s_clen_order[ps->lens_idx++]] = (uint8_t)take_bits(ps, 3);
+            }
+            if (huff_build(&ps->dyn_len, ps->lens, 19) != 0)
+                return PNG_STREAM_ERR; /* code-length code must be complete */
+            memset(ps->lens, 0, sizeof(ps->lens));
+            ps->lens_idx = 0;
+            ps->zst = Z_TABLE_LENS;
+            break;
+
+        case Z_TABLE_LENS:
+            while (ps->lens_idx < ps->hlit + ps->hdist)
+            {
+                int sym = huff_decode(ps, &ps->dyn_len);
+                if (sym == -1)
+                    NEED_MORE();
+                if (sym < 0)
+                    return PNG_STREAM_ERR;
+                if (sym < 16)
+                {
+                    ps->lens[ps->lens_idx++] = (uint8_t)sym;
+                    continue;
+                }
+                if (sym == 16 && ps->lens_idx == 0)
+                    return PNG_STREAM_ERR;
+                ps->rep_sym = sym;
+                ps->zst = Z_TABLE_REP;
+                break;
+            }
+            if (ps->zst == Z_TABLE_REP)
+                break;
+
+            if (ps->lens[256] == 0)
+                return PNG_STREAM_ERR;
+            {
+                int el = huff_build(&ps->dyn_len, ps->lens, ps->hlit);
+                int ed = huff_build(&ps->dyn_dist, ps->lens + ps->hlit, ps->hdist);
+                if (el < 0 || (el > 0 && ps->hlit - ps->dyn_len.count[0] != 1) || ed < 0)
+                    return PNG_STREAM_ERR;
+            }
+            ps->lcode = &ps->dyn_len;
+            ps->dcode = &ps->dyn_dist;
+            ps->zst = Z_LEN_SYM;
+            break;
+
+        case Z_TABLE_REP:
+        {
+            static const uint8_t eb[3] = {2, 3, 7}, base[3] = {3, 3, 11};
+            const int k = ps->rep_sym - 16;
+            NEED(eb[k]);
+            int rep = base[k] + (int)take_bits(ps, eb[k]);
+            uint8_t v = (k == 0) ? ps->lens[ps->lens_idx - 1] : 0;
+            if (ps->lens_idx + rep > ps->hlit + ps->hdist)
+                return PNG_STREAM_ERR;
+            while (rep--)
+                ps->lens[ps->lens_idx++] = v;
+            ps->zst = Z_TABLE_LENS;
+            break;
+        }
+
+        case Z_LEN_SYM:
+            for (;;)
+            {
+                /* hot loop: literals straight into the window */
+                if (ps->bitcnt < 15 && in < end)
+                    break; /* refill first */
+                int sym = huff_decode(ps, ps->lcode);
+                if (sym == -1)
+                    NEED_MORE();
+                if (sym < 0)
+                    return PNG_STREAM_ERR;
+                if (sym < 256)
+                {
+                    ps->win[ps->wpos++ & PS_WIN_MASK] = (uint8_t)sym;
+                    if (ps->wpos - ps->flushed >= PS_FLUSH_AT && !win_flush(ps))
+                        return PNG_STREAM_ERR;
+                    continue;
+                }
+                if (sym == 256)
+                {
+                    ps->zst = Z_BLOCK;
+                    break;
+                }
+                sym -= 257;
+                if (sym >= 29)
+                    return PNG_STREAM_ERR;
+                ps->sym = sym;
+                ps->zst = Z_LEN_EXTRA;
+                break;
+            }
+            break;
+
+        case Z_LEN_EXTRA:
+            NEED(s_len_ext[ps->sym]);
+            ps->match_len = s_len_base[ps->sym] + take_bits(ps, s_len_ext[ps->sym]);
+            ps->zst = Z_DIST_SYM;
+            break;
+
+        case Z_DIST_SYM:
+        {
+            int sym = huff_decode(ps, ps->dcode);
+            if (sym == -1)
+                NEED_MORE();
+            if (sym < 0 || sym >= 30)
+                return PNG_STREAM_ERR;
+            ps->sym = sym;
+            ps->zst = Z_DIST_EXTRA;
+            break;
+        }
+
+        case Z_DIST_EXTRA:
+        {
+            NEED(s_dist_ext[ps->sym]);
+            uint32_t dist = s_dist_base[ps->sym] + take_bits(ps, s_dist_ext[ps->sym]);
+            if (dist > ps->wpos)
+                return PNG_STREAM_ERR;
+            for (uint32_t i = 0; i < ps->match_len; i++, ps->wpos++)
+                ps->win[ps->wpos & PS_WIN_MASK] = ps->win[(ps->wpos - dist) & PS_WIN_MASK];
+            if (ps->wpos - ps->flushed >= PS_FLUSH_AT && !win_flush(ps))
+                return PNG_STREAM_ERR;
+            ps->zst = Z_LEN_SYM;
+            break;
+        }
+
+        case Z_TRAILER:
+            /* adler32 is not verified (see header) */
+            if (!win_flush(ps))
+                return PNG_STREAM_ERR;
+            ps->zst = Z_DONE;
+            return PNG_STREAM_DONE;
+
+        default:
+            return PNG_STREAM_DONE;
+        }
+    }
+}
+
+/* Inflate IDAT bytes. Returns MORE when the input is used up, DONE at the end of the
+   zlib stream, ERR on corrupt data. Rows completed by this piece are delivered before
+   returning, so the image builds up as the input arrives. */
+static int inflate_feed(png_stream_t *ps, const uint8_t *in, uint32_t n)
+{
+    int r = inflate_run(ps, in, n);
+    if (r == PNG_STREAM_MORE && !win_flush(ps))
+        return PNG_STREAM_ERR;
+    return r;
+}
+
+/* -------- Container -------- */
+static bool start_image(png_stream_t *ps)
+{
+    if (!ps->have_ihdr)
+        return false;
+    if (ps->ctype == 3 && ps->pal_n == 0)
+        return false;
+
+    static const uint8_t chans[7] = {1, 0, 3, 1, 2, 0, 4};
+    uint32_t bits = (uint32_t)chans[ps->ctype] * ps->depth;
+    ps->bpp = (bits + 7) / 8;
+    ps->row_len = 1 + (ps->w * bits + 7) / 8;
+
+    uint32_t need = ps->row_len > ps->w * 4 ? ps->row_len : ps->w * 4;
+    if (need > ps->row_cap)
+    {
+        ps_free(ps->cur);
+        ps_free(ps->prev);
+        ps_free(ps->rgba);
+        ps->cur = (uint8_t *)ps_alloc(need);
+        ps->prev = (uint8_t *)ps_alloc(need);
+        ps->rgba = (uint8_t *)ps_alloc(need);
+        ps->row_cap = (ps->cur && ps->prev && ps->rgba) ? need : 0;
+        if (!ps->row_cap)
+            return false;
+    }
+    memset(ps->prev, 0, ps->row_len);
+    ps->row_pos = 0;
+    ps->y = 0;
+
+    png_stream_info_t info = {
+        .w = ps->w,
+        .h = ps->h,
+        .has_alpha = ps->ctype == 4 || ps->ctype == 6 || (ps->ctype == 3 && ps->pal_trns),
+        .raw_len = ps->row_len};
+    if (ps->begin && !ps->begin(ps->user, &info))
+        return false;
+
+    ps->begun = true;
+    return true;
+}
+
+static bool parse_ihdr(png_stream_t *ps)
+{
+    const uint8_t *m = ps->meta;
+    ps->w = be32(m);
+    ps->h = be32(m + 4);
+    ps->depth = m[8];
+    ps->ctype = m[9];
+    if (!ps->w || !ps->h || ps->w > PS_MAX_W || ps->h > PS_MAX_W)
+        return false;
+    if (m[10] != 0 || m[11] != 0 || m[12] != 0)
+        return false; /* compression/filter method, interlace */
+
+    bool ok;
+    switch (ps->ctype)
+    {
+    case 0:
+        ok = ps->depth == 1 || ps->depth == 2 || ps->depth == 4 || ps->depth == 8;
+        break;
+    case 3:
+        ok = ps->depth == 1 || ps->depth == 2 || ps->depth == 4 || ps->depth == 8;
+        break;
+    case 2:
+    case 4:
+    case 6:
+        ok = ps->depth == 8;
+        break;
+    default:
+        ok = false;
+        break;
+    }
+    ps->have_ihdr = ok;
+    return ok;
+}
+
+/* small chunks (IHDR/PLTE/tRNS) are consumed byte-wise from the data stream */
+static void meta_byte(png_stream_t *ps, uint32_t idx, uint8_t b)
+{
+    switch (ps->chunk_type)
+    {
+    case FOURCC('I', 'H', 'D', 'R'):
+        if (idx < sizeof(ps->meta))
+            ps->meta[idx] = b;
+        break;
+    case FOURCC('P', 'L', 'T', 'E'):
+        if (idx < 768)
+        {
+            ps->palette[idx / 3][idx % 3] = b;
+            ps->palette[idx / 3][3] = 0xff;
+        }
+        break;
+    case FOURCC('t', 'R', 'N', 'S'):
+        if (ps->ctype == 3 && idx < 256)
+        {
+            ps->palette[idx][3] = b;
+            ps->pal_trns = true;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static bool chunk_end(png_stream_t *ps)
+{
+    switch (ps->chunk_type)
+    {
+    case FOURCC('I', 'H', 'D', 'R'):
+        return ps->chunk_len == 13 && parse_ihdr(ps);
+    case FOURCC('P', 'L', 'T', 'E'):
+        if (ps->chunk_len % 3 || ps->chunk_len > 768)
+            return false;
+        ps->pal_n = (int)(ps->chunk_len / 3);
+        return true;
+    default:
+        return true;
+    }
+}
+
+png_stream_t *png_stream_create(png_stream_begin_fn begin, png_stream_row_fn row, void *user)
+{
+    if (!row)
+        return NULL;
+    build_fixed();
+
+    png_stream_t *ps = (png_stream_t *)ps_alloc(sizeof(*ps));
+    if (!ps)
+        return NULL;
+    memset(ps, 0, sizeof(*ps));
+    ps->begin = begin;
+    ps->row = row;
+    ps->user = user;
+    ps->win = (uint8_t *)ps_alloc(PS_WIN_SIZE);
+    if (!ps->win)
+    {
+        ps_free(ps);
+        return NULL;
+    }
+    png_stream_reset(ps);
+    return ps;
+}
+
+void png_stream_destroy(png_stream_t *ps)
+{
+    if (!ps)
+        return;
+    ps_free(ps->win);
+    ps_free(ps->cur);
+    ps_free(ps->prev);
+    ps_free(ps->rgba);
+    ps_free(ps);
+}
+
+void png_stream_set_split(png_stream_t *ps, png_stream_raw_fn raw)
+{
+    if (ps)
+        ps->raw = raw;
+}
+
+void png_stream_finish_row(png_stream_t *ps, uint32_t y, uint8_t *raw)
+{
+    unfilter(ps, raw, ps->prev);
+    convert_row(ps, raw);
+    ps->row(ps->user, y, ps->rgba);
+    memcpy(ps->prev, raw, ps->row_len);
+}
+
+void png_stream_reset(png_stream_t *ps)
+{
+    if (!ps)
+        return;
+    ps->result = PNG_STREAM_MORE;
+    ps->pst = P_SIG;
+    ps->acc_got = 0;
+    ps->have_ihdr = false;
+    ps->begun = false;
+    ps->pal_n = 0;
+    ps->pal_trns = false;
+    memset(ps->palette, 0, sizeof(ps->palette));
+    ps->y = 0;
+
+    ps->zst = Z_HDR;
+    ps->bitbuf = 0;
+    ps->bitcnt = 0;
+    ps->last_block = false;
+    ps->wpos = 0;
+    ps->flushed = 0;
+}
+
+int png_stream_feed(png_stream_t *ps, const uint8_t *data, size_t len)
+{
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a};
+
+    if (!ps)
+        return PNG_STREAM_ERR;
+    if (ps->result != PNG_STREAM_MORE)
+        return ps->result;
+
+    const uint8_t *p = data;
+    const uint8_t *end = data + len;
+
+    while (p < end && ps->result == PNG_STREAM_MORE)
+    {
+        switch (ps->pst)
+        {
+        case P_SIG:
+            if (*p++ != sig[ps->acc_got++])
+                ps->result = PNG_STREAM_ERR;
+            else if (ps->acc_got == 8)
+            {
+                ps->acc_got = 0;
+                ps->pst = P_CHUNK_HDR;
+            }
+            break;
+
+        case P_CHUNK_HDR:
+            ps->acc[ps->acc_got++] = *p++;
+            if (ps->acc_got < 8)
+                break;
+            ps->acc_got = 0;
+            ps->chunk_len = be32(ps->acc);
+            ps->chunk_type = be32(ps->acc + 4);
+            ps->chunk_left = ps->chunk_len;
+            if (ps->chunk_len > 0x7fffffffu)
+            {
+                ps->result = PNG_STREAM_ERR;
+                break;
+            }
+            if (ps->chunk_type == FOURCC('I', 'D', 'A', 'T') && !ps->begun && !start_image(ps))
+            {
+                ps->result = PNG_STREAM_ERR;
+                break;
+            }
+            if (ps->chunk_type == FOURCC('I', 'E', 'N', 'D'))
+            {
+                /* rows should all be out by now */
+                ps->result = (ps->begun && ps->y == ps->h) ? PNG_STREAM_DONE : PNG_STREAM_ERR;
+                ps->pst = P_END;
+                break;
+            }
+            ps->pst = ps->chunk_left ? P_CHUNK_DATA : P_CHUNK_CRC;
+            if (!ps->chunk_left && !chunk_end(ps))
+                ps->result = PNG_STREAM_ERR;
+            break;
+
+        case P_CHUNK_DATA:
+        {
+            uint32_t k = (uint32_t)(end - p);
+            if (k > ps->chunk_left)
+                k = ps->chunk_left;
+
+            if (ps->chunk_type == FOURCC('I', 'D', 'A', 'T'))
+            {
+                int zr = inflate_feed(ps, p, k);
+                if (zr == PNG_STREAM_ERR)
+                    ps->result = PNG_STREAM_ERR;
+                else if (ps->y == ps->h)
+                    ps->result = PNG_STREAM_DONE;
+            }
+            else
+            {
+                uint32_t base = ps->chunk_len - ps->chunk_left;
+                for (uint32_t i = 0; i < k; i++)
+                    meta_byte(ps, base + i, p[i]);
+            }
+            p += k;
+            ps->chunk_left -= k;
+            if (ps->chunk_left == 0 && ps->result == PNG_STREAM_MORE)
+            {
+                if (!chunk_end(ps))
+                    ps->result = PNG_STREAM_ERR;
+                ps->pst = P_CHUNK_CRC;
+            }
+            break;
+        }
+
+        case P_CHUNK_CRC:
+            p++;
+            if (++ps->acc_got == 4)
+            {
+                ps->acc_got = 0;
+                ps->pst = P_CHUNK_HDR;
+            }
+            break;
+
+        default:
+            p = end;
+            break;
+        }
+    }
+    return ps->result;
+}
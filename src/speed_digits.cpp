@@ -0,0 +1,227 @@
+#include "speed_digits.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <lvgl.h>
+#if __has_include("esp_heap_caps.h")
+#include "esp_heap_caps.h"
+#endif
+
+extern "C" {
+
+#define SD_MAX_DIGITS 3     // 速度 0..999
+#define SD_MAX_LAYERS 2     // 阴影 + 前景
+
+typedef struct {
+    lv_img_dsc_t dsc;       // A8 位图，data 指向图集内
+    lv_coord_t adv;         // 字宽（像素，已取整，与标签排版一致）
+    lv_coord_t ofs_x;       // 位图相对字原点的偏移
+    lv_coord_t ofs_y;       // 位图顶边相对行顶
+} sd_glyph_t;
+
+typedef struct {
+    lv_obj_t *label;        // 被接管的原标签
+    lv_obj_t *cont;         // 与标签同位置同尺寸的容器
+    lv_obj_t *img[SD_MAX_DIGITS];
+    int8_t shown[SD_MAX_DIGITS];   // 各位当前图源（-1 = 隐藏）
+    lv_coord_t x[SD_MAX_DIGITS];
+} sd_layer_t;
+
+static sd_glyph_t s_glyph[10];
+static uint8_t *s_atlas = nullptr;
+static sd_layer_t s_layer[SD_MAX_LAYERS];
+static int s_layer_count = 0;
+static lv_coord_t s_cont_w = 0;
+static bool s_active = false;
+static bool s_on_labels = true;     // 超范围时暂时退回标签
+
+static void *sd_alloc(size_t n)
+{
+#if __has_include("esp_heap_caps.h")
+    // 每帧都要读，优先内部 RAM；放不下再用 PSRAM（仍省掉解包和排版）
+    void *p = heap_caps_malloc(n, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (p) return p;
+    return heap_caps_malloc(n, MALLOC_CAP_8BIT);
+#else
+    return malloc(n);
+#endif
+}
+
+/* 把 1/2/4/8 bpp 的字形（行间不对齐，按位连续）展开成 A8，取值与 LVGL 的 opa 表相同 */
+static void unpack_glyph(uint8_t *dst, const uint8_t *src, int n, uint8_t bpp)
+{
+    const unsigned mask = (1u << bpp) - 1u;
+    const unsigned scale = 255u / mask;
+    for (int i = 0; i < n; i++) {
+        const unsigned bit = (unsigned)i * bpp;
+        const unsigned v = (src[bit >> 3] >> (8 - bpp - (bit & 7))) & mask;
+        dst[i] = (uint8_t)(v * scale);
+    }
+}
+
+static bool build_atlas(const lv_font_t *font)
+{
+    lv_font_glyph_dsc_t g[10];
+    size_t total = 0;
+    for (int d = 0; d < 10; d++) {
+        if (!lv_font_get_glyph_dsc(font, &g[d], (uint32_t)('0' + d), 0)) return false;
+        if (g[d].bpp != 1 && g[d].bpp != 2 && g[d].bpp != 4 && g[d].bpp != 8) return false;
+        total += (size_t)g[d].box_w * g[d].box_h;
+    }
+
+    s_atlas = (uint8_t *)sd_alloc(total);
+    if (!s_atlas) return false;
+
+    // 与 lv_draw_label 相同的基线计算
+    const lv_coord_t top = (lv_coord_t)(lv_font_get_line_height(font) - font->base_line);
+    uint8_t *p = s_atlas;
+    for (int d = 0; d < 10; d++) {
+        const int n = g[d].box_w * g[d].box_h;
+        const uint8_t *bmp = lv_font_get_glyph_bitmap(font, (uint32_t)('0' + d));
+        if (bmp && n) {
+            unpack_glyph(p, bmp, n, g[d].bpp);
+        } else {
+            memset(p, 0, (size_t)n);
+        }
+
+        sd_glyph_t *sg = &s_glyph[d];
+        memset(&sg->dsc, 0, sizeof(sg->dsc));
+        sg->dsc.header.always_zero = 0;
+        sg->dsc.header.cf = LV_IMG_CF_ALPHA_8BIT;
+        sg->dsc.header.w = g[d].box_w;
+        sg->dsc.header.h = g[d].box_h;
+        sg->dsc.data_size = (uint32_t)n;
+        sg->dsc.data = p;
+        sg->adv = (lv_coord_t)g[d].adv_w;
+        sg->ofs_x = g[d].ofs_x;
+        sg->ofs_y = (lv_coord_t)(top - g[d].box_h - g[d].ofs_y);
+        p += n;
+    }
+    return true;
+}
+
+static void make_layer(sd_layer_t *l, lv_obj_t *label)
+{
+    l->label = label;
+    l->cont = lv_obj_create(lv_obj_get_parent(label));
+    lv_obj_remove_style_all(l->cont);
+    lv_obj_clear_flag(l->cont, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(l->cont, lv_obj_get_width(label), lv_obj_get_height(label));
+    lv_obj_set_align(l->cont, lv_obj_get_style_align(label, LV_PART_MAIN));
+    lv_obj_set_pos(l->cont, lv_obj_get_x_aligned(label), lv_obj_get_y_aligned(label));
+    // 占据原标签的叠放位置，并继承用户标志（例如静态层的动态标记）
+    lv_obj_move_to_index(l->cont, lv_obj_get_index(label));
+    const lv_obj_flag_t user = (lv_obj_flag_t)(LV_OBJ_FLAG_USER_1 | LV_OBJ_FLAG_USER_2 |
+                                               LV_OBJ_FLAG_USER_3 | LV_OBJ_FLAG_USER_4);
+    if (lv_obj_has_flag_any(label, user)) {
+        lv_obj_add_flag(l->cont, (lv_obj_flag_t)(label->flags & user));
+    }
+
+    const lv_color_t color = lv_obj_get_style_text_color(label, LV_PART_MAIN);
+    const lv_opa_t opa = lv_obj_get_style_text_opa(label, LV_PART_MAIN);
+    for (int i = 0; i < SD_MAX_DIGITS; i++) {
+        lv_obj_t *img = lv_img_create(l->cont);
+        lv_obj_clear_flag(img, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_set_style_img_recolor(img, color, LV_PART_MAIN);
+        lv_obj_set_style_img_recolor_opa(img, LV_OPA_COVER, LV_PART_MAIN);
+        lv_obj_set_style_img_opa(img, opa, LV_PART_MAIN);
+        lv_obj_add_flag(img, LV_OBJ_FLAG_HIDDEN);
+        l->img[i] = img;
+        l->shown[i] = -1;
+        l->x[i] = LV_COORD_MIN;
+    }
+}
+
+static void show_labels(bool on)
+{
+    for (int i = 0; i < s_layer_count; i++) {
+        if (on) {
+            lv_obj_clear_flag(s_layer[i].label, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_add_flag(s_layer[i].cont, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_add_flag(s_layer[i].label, LV_OBJ_FLAG_HIDDEN);
+            lv_obj_clear_flag(s_layer[i].cont, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+    s_on_labels = on;
+}
+
+bool speed_digits_init(lv_obj_t *const *labels, int count)
+{
+    if (s_active || !labels || count <= 0 || count > SD_MAX_LAYERS) return false;
+
+    const lv_font_t *font = lv_obj_get_style_text_font(labels[0], LV_PART_MAIN);
+    for (int i = 0; i < count; i++) {
+        if (!labels[i] || lv_obj_get_style_text_font(labels[i], LV_PART_MAIN) != font) return false;
+        // 只复刻单行居中、字距为 0 的排版，其它情况不接管
+        if (lv_obj_get_style_text_letter_space(labels[i], LV_PART_MAIN) != 0) return false;
+        if (lv_obj_get_style_text_align(labels[i], LV_PART_MAIN) != LV_TEXT_ALIGN_CENTER) return false;
+        if (!lv_obj_get_parent(labels[i])) return false;
+    }
+    if (!font || !build_atlas(font)) return false;
+
+    lv_obj_update_layout(labels[0]);
+    for (int i = 0; i < count; i++) {
+        make_layer(&s_layer[i], labels[i]);
+    }
+    s_layer_count = count;
+    s_cont_w = lv_obj_get_content_width(labels[0]);
+    s_active = true;
+
+    // 先显示标签上的初始文本（SquareLine 的占位值），不等第一帧快照
+    const char *t = lv_label_get_text(labels[count - 1]);
+    speed_digits_set(t ? atoi(t) : 0);
+    return true;
+}
+
+bool speed_digits_set(int value)
+{
+    if (!s_active) return false;
+    if (value < 0 || value > 999) {
+        if (!s_on_labels) show_labels(true);
+        return false;
+    }
+    if (s_on_labels) show_labels(false);
+
+    int digit[SD_MAX_DIGITS];
+    int n = 0;
+    do {
+        digit[n++] = value % 10;
+        value /= 10;
+    } while (value);
+
+    // 居中对齐：行宽 = 字宽之和（字距为 0）
+    lv_coord_t w = 0;
+    for (int i = 0; i < n; i++) w += s_glyph[digit[i]].adv;
+    lv_coord_t pen = (lv_coord_t)((s_cont_w - w) / 2);
+
+    for (int i = 0; i < SD_MAX_DIGITS; i++) {
+        const int d = (i < n) ? digit[n - 1 - i] : -1;
+        const lv_coord_t x = (d >= 0) ? (lv_coord_t)(pen + s_glyph[d].ofs_x) : LV_COORD_MIN;
+        if (d >= 0) pen += s_glyph[d].adv;
+
+        for (int k = 0; k < s_layer_count; k++) {
+            sd_layer_t *l = &s_layer[k];
+            if (l->shown[i] == d && (d < 0 || l->x[i] == x)) continue;
+            lv_obj_t *img = l->img[i];
+            if (d < 0) {
+                lv_obj_add_flag(img, LV_OBJ_FLAG_HIDDEN);
+            } else {
+                if (l->shown[i] != d) lv_img_set_src(img, &s_glyph[d].dsc);
+                lv_obj_set_pos(img, x, s_glyph[d].ofs_y);
+                if (l->shown[i] < 0) lv_obj_clear_flag(img, LV_OBJ_FLAG_HIDDEN);
+            }
+            l->shown[i] = (int8_t)d;
+            l->x[i] = x;
+        }
+    }
+    return true;
+}
+
+bool speed_digits_active(void)
+{
+    return s_active && !s_on_labels;
+}
+
+} // extern "C"
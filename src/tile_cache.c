@@ -0,0 +1,478 @@
+#include "tile_cache.h"
+#include <string.h>
+
+#if __has_include("esp_partition.h")
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "esp_heap_caps.h"
+#include "hud_sched.h"
+#define HAVE_PARTITION 1
+#else
+#define HAVE_PARTITION 0
+#endif
+
+#define SECTOR 4096
+#define LAYOUT_REGION (64 * 1024)
+#define LAYOUT_REC 1024
+#define LAYOUT_RECS (LAYOUT_REGION / LAYOUT_REC)
+#define LAYOUT_MIN_MS 10000 /* at most one layout record per 10 s */
+#define PENDING_N 32        /* a screenful of new tiles arrives in one burst (copies sit in PSRAM) */
+#define WRITE_GAP_MS 40     /* let the other tasks breathe between cache-off windows */
+
+#define SLOT_MAGIC 0x454C4954u   /* 'TILE' */
+#define LAYOUT_MAGIC 0x59414C54u /* 'TLAY' */
+#define KEY_NONE UINT64_MAX
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t len;
+    uint64_t key;
+    uint32_t crc;
+    uint32_t stamp; /* write order */
+    uint32_t rsv[2];
+} slot_hdr_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t len;
+    uint32_t crc;
+} layout_hdr_t;
+
+_Static_assert(sizeof(slot_hdr_t) == TILE_CACHE_SLOT_BYTES - TILE_CACHE_MAX_BYTES, "slot header size");
+_Static_assert(sizeof(layout_hdr_t) + TILE_LAYOUT_MAX_BYTES <= LAYOUT_REC, "layout record size");
+
+static tile_cache_stats_t s_stats;
+
+#if HAVE_PARTITION
+
+#if __has_include("esp_rom_crc.h")
+#include "esp_rom_crc.h"
+static uint32_t crc32(const uint8_t *d, size_t n) { return esp_rom_crc32_le(0, d, (uint32_t)n); }
+#else
+static uint32_t crc32(const uint8_t *d, size_t n)
+{
+    uint32_t c = ~0u;
+    while (n--)
+    {
+        c ^= *d++;
+        for (int k = 0; k < 8; k++)
+            c = (c >> 1) ^ (0xedb88320u & (-(int32_t)(c & 1)));
+    }
+    return ~c;
+}
+#endif
+
+typedef struct
+{
+    uint64_t key;
+    uint32_t stamp; /* last use */
+    uint32_t len;
+} slot_t;
+
+typedef struct
+{
+    uint64_t key;
+    uint8_t *buf;
+    size_t len;
+} pending_t;
+
+static const esp_partition_t *s_part = NULL;
+static slot_t *s_slot = NULL;
+static uint32_t s_nslots = 0;
+static uint32_t s_clock = 0;
+static SemaphoreHandle_t s_lock = NULL;
+static SemaphoreHandle_t s_work = NULL;
+
+static pending_t s_pend[PENDING_N];
+static int s_pend_head = 0; /* oldest, being written */
+static int s_pend_n = 0;
+
+static uint8_t s_layout[TILE_LAYOUT_MAX_BYTES];
+static uint8_t s_layout_wr[TILE_LAYOUT_MAX_BYTES]; /* writer's copy while flash is busy */
+static size_t s_layout_len = 0;
+static bool s_layout_dirty = false;
+static uint32_t s_layout_seq = 0;
+static int s_layout_next = 0;       /* record index the next save goes to */
+static TickType_t s_layout_saved = 0;
+
+static uint32_t slot_off(uint32_t i)
+{
+    return LAYOUT_REGION + i * TILE_CACHE_SLOT_BYTES;
+}
+
+/* caller holds s_lock */
+static int find_slot(uint64_t key)
+{
+    for (uint32_t i = 0; i < s_nslots; i++)
+    {
+        if (s_slot[i].key == key)
+            return (int)i;
+    }
+    return -1;
+}
+
+static void scan_slots(void)
+{
+    for (uint32_t i = 0; i < s_nslots; i++)
+    {
+        slot_hdr_t h;
+        s_slot[i].key = KEY_NONE;
+        if (esp_partition_read(s_part, slot_off(i), &h, sizeof(h)) != ESP_OK)
+            continue;
+        if (h.magic != SLOT_MAGIC || h.len > TILE_CACHE_MAX_BYTES || h.key == KEY_NONE)
+            continue;
+        s_slot[i].key = h.key;
+        s_slot[i].len = h.len;
+        s_slot[i].stamp = h.stamp;
+        if (h.stamp > s_clock)
+            s_clock = h.stamp;
+        s_stats.used++;
+    }
+}
+
+static void scan_layout(void)
+{
+    int best = -1;
+    for (int i = 0; i < LAYOUT_RECS; i++)
+    {
+        layout_hdr_t h;
+        if (esp_partition_read(s_part, (size_t)i * LAYOUT_REC, &h, sizeof(h)) != ESP_OK)
+            continue;
+        if (h.magic != LAYOUT_MAGIC || h.len > TILE_LAYOUT_MAX_BYTES)
+            continue;
+        if (best >= 0 && (int32_t)(h.seq - s_layout_seq) <= 0)
+            continue;
+        if (esp_partition_read(s_part, (size_t)i * LAYOUT_REC + sizeof(h), s_layout, h.len) != ESP_OK ||
+            crc32(s_layout, h.len) != h.crc)
+            continue;
+        best = i;
+        s_layout_seq = h.seq;
+        s_layout_len = h.len;
+    }
+    if (best >= 0)
+    {
+        /* buffer holds the last record read, reload the winner */
+        esp_partition_read(s_part, (size_t)best * LAYOUT_REC + sizeof(layout_hdr_t), s_layout, s_layout_len);
+        s_layout_next = (best + 1) % LAYOUT_RECS;
+    }
+    else
+    {
+        s_layout_len = 0;
+    }
+}
+
+static void write_layout(const uint8_t *d, size_t len)
+{
+    const size_t off = (size_t)s_layout_next * LAYOUT_REC;
+    if (off % SECTOR == 0 && esp_partition_erase_range(s_part, off, SECTOR) != ESP_OK)
+        return;
+    layout_hdr_t h = {LAYOUT_MAGIC, s_layout_seq + 1, (uint32_t)len, crc32(d, len)};
+    if (esp_partition_write(s_part, off + sizeof(h), d, len) != ESP_OK ||
+        esp_partition_write(s_part, off, &h, sizeof(h)) != ESP_OK)
+        return;
+    s_layout_seq = h.seq;
+    s_layout_next = (s_layout_next + 1) % LAYOUT_RECS;
+}
+
+static void write_tile(const pending_t *p)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    int i = find_slot(p->key);
+    if (i < 0)
+        i = find_slot(KEY_NONE);
+    if (i < 0)
+    {
+        uint32_t oldest = UINT32_MAX;
+        for (uint32_t k = 0; k < s_nslots; k++)
+        {
+            if (s_slot[k].stamp < oldest)
+            {
+                oldest = s_slot[k].stamp;
+                i = (int)k;
+            }
+        }
+        s_stats.evictions++;
+        s_stats.used--;
+    }
+    else if (s_slot[i].key != KEY_NONE)
+    {
+        s_stats.used--;
+    }
+    /* out of the index before the erase, a reader holding the offset fails its crc check */
+    s_slot[i].key = KEY_NONE;
+    const uint32_t stamp = ++s_clock;
+    xSemaphoreGive(s_lock);
+
+    const uint32_t off = slot_off((uint32_t)i);
+    slot_hdr_t h = {SLOT_MAGIC, (uint32_t)p->len, p->key, crc32(p->buf, p->len), stamp, {0, 0}};
+    const size_t span = (sizeof(h) + p->len + SECTOR - 1) / SECTOR * SECTOR;
+    if (esp_partition_erase_range(s_part, off, span) != ESP_OK ||
+        esp_partition_write(s_part, off + sizeof(h), p->buf, p->len) != ESP_OK ||
+        esp_partition_write(s_part, off, &h, sizeof(h)) != ESP_OK)
+        return;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_slot[i].key = p->key;
+    s_slot[i].len = (uint32_t)p->len;
+    s_slot[i].stamp = stamp;
+    s_stats.used++;
+    s_stats.writes++;
+    xSemaphoreGive(s_lock);
+}
+
+static void writer_task(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        TickType_t wait = portMAX_DELAY;
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        const bool have_tile = s_pend_n > 0;
+        pending_t p = s_pend[s_pend_head];
+        bool save_layout = false;
+        if (s_layout_dirty)
+        {
+            const TickType_t since = xTaskGetTickCount() - s_layout_saved;
+            if (since >= pdMS_TO_TICKS(LAYOUT_MIN_MS))
+                save_layout = true;
+            else
+                wait = pdMS_TO_TICKS(LAYOUT_MIN_MS) - since;
+        }
+        size_t layout_len = 0;
+        if (save_layout)
+        {
+            layout_len = s_layout_len;
+            memcpy(s_layout_wr, s_layout, layout_len);
+            s_layout_dirty = false;
+            s_layout_saved = xTaskGetTickCount();
+        }
+        xSemaphoreGive(s_lock);
+
+        if (save_layout)
+        {
+            write_layout(s_layout_wr, layout_len);
+            vTaskDelay(pdMS_TO_TICKS(WRITE_GAP_MS));
+        }
+        if (have_tile)
+        {
+            write_tile(&p);
+            /* stays visible to tile_cache_get until the flash copy exists */
+            xSemaphoreTake(s_lock, portMAX_DELAY);
+            s_pend_head = (s_pend_head + 1) % PENDING_N;
+            s_pend_n--;
+            xSemaphoreGive(s_lock);
+            heap_caps_free(p.buf);
+            vTaskDelay(pdMS_TO_TICKS(WRITE_GAP_MS));
+            continue;
+        }
+        if (!save_layout)
+            xSemaphoreTake(s_work, wait);
+    }
+}
+
+bool tile_cache_init(void)
+{
+    if (s_part)
+        return true;
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           (esp_partition_subtype_t)TILE_CACHE_SUBTYPE, "tiles");
+    if (!part || part->size <= LAYOUT_REGION + TILE_CACHE_SLOT_BYTES)
+        return false;
+
+    const uint32_t n = (uint32_t)((part->size - LAYOUT_REGION) / TILE_CACHE_SLOT_BYTES);
+    s_slot = (slot_t *)heap_caps_malloc(n * sizeof(slot_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!s_slot)
+        s_slot = (slot_t *)heap_caps_malloc(n * sizeof(slot_t), MALLOC_CAP_8BIT);
+    s_lock = xSemaphoreCreateMutex();
+    s_work = xSemaphoreCreateBinary();
+    if (!s_slot || !s_lock || !s_work)
+        return false;
+
+    s_part = part;
+    s_nslots = n;
+    s_stats.slots = n;
+    scan_slots();
+    scan_layout();
+    s_layout_saved = xTaskGetTickCount();
+
+    if (xTaskCreatePinnedToCore(writer_task, "tile_wr", HUD_SCHED_TILE_WR_STACK, NULL, HUD_SCHED_TILE_WR_PRIO, NULL,
+                                HUD_SCHED_AFFINITY(HUD_SCHED_TILE_WR_CORE)) != pdPASS)
+    {
+        s_part = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool tile_cache_get(uint64_t key, uint8_t *dst, size_t cap, size_t *len)
+{
+    if (!s_part)
+        return false;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int k = 0; k < s_pend_n; k++)
+    {
+        const pending_t *p = &s_pend[(s_pend_head + k) % PENDING_N];
+        if (p->key == key && p->len <= cap)
+        {
+            memcpy(dst, p->buf, p->len);
+            *len = p->len;
+            s_stats.hits++;
+            xSemaphoreGive(s_lock);
+            return true;
+        }
+    }
+    const int i = find_slot(key);
+    const uint32_t n = i >= 0 ? s_slot[i].len : 0;
+    if (i >= 0)
+        s_slot[i].stamp = ++s_clock;
+    xSemaphoreGive(s_lock);
+
+    slot_hdr_t h;
+    if (i < 0 || n > cap || esp_partition_read(s_part, slot_off((uint32_t)i), &h, sizeof(h)) != ESP_OK ||
+        h.magic != SLOT_MAGIC || h.key != key || h.len != n ||
+        esp_partition_read(s_part, slot_off((uint32_t)i) + sizeof(h), dst, n) != ESP_OK ||
+        crc32(dst, n) != h.crc)
+    {
+        s_stats.misses++;
+        return false;
+    }
+    *len = n;
+    s_stats.hits++;
+    return true;
+}
+
+bool tile_cache_put(uint64_t key, const uint8_t *data, size_t len)
+{
+    if (!s_part || !len || len > TILE_CACHE_MAX_BYTES || key == KEY_NONE)
+    {
+        s_stats.dropped++;
+        return false;
+    }
+    uint8_t *copy = (uint8_t *)heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!copy)
+    {
+        s_stats.dropped++;
+        return false;
+    }
+    memcpy(copy, data, len);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    /* the same tile again before it was written: replace the queued copy (not the head, the
+       writer may be on it) */
+    for (int k = 1; k < s_pend_n; k++)
+    {
+        pending_t *p = &s_pend[(s_pend_head + k) % PENDING_N];
+        if (p->key == key)
+        {
+            uint8_t *old = p->buf;
+            p->buf = copy;
+            p->len = len;
+            xSemaphoreGive(s_lock);
+            heap_caps_free(old);
+            return true;
+        }
+    }
+    const bool ok = s_pend_n < PENDING_N;
+    if (ok)
+    {
+        pending_t *p = &s_pend[(s_pend_head + s_pend_n) % PENDING_N];
+        p->key = key;
+        p->buf = copy;
+        p->len = len;
+        s_pend_n++;
+    }
+    xSemaphoreGive(s_lock);
+
+    if (!ok)
+    {
+        heap_caps_free(copy);
+        s_stats.dropped++;
+        return false;
+    }
+    xSemaphoreGive(s_work);
+    return true;
+}
+
+void tile_cache_save_layout(const uint8_t *data, size_t len)
+{
+    if (!s_part || len > TILE_LAYOUT_MAX_BYTES)
+        return;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    const bool same = len == s_layout_len && memcmp(s_layout, data, len) == 0;
+    if (!same)
+    {
+        memcpy(s_layout, data, len);
+        s_layout_len = len;
+        s_layout_dirty = true;
+    }
+    xSemaphoreGive(s_lock);
+    if (!same)
+        xSemaphoreGive(s_work);
+}
+
+bool tile_cache_load_layout(uint8_t *dst, size_t cap, size_t *len)
+{
+    if (!s_part)
+        return false;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    const size_t n = s_layout_len;
+    const bool ok = n && n <= cap;
+    if (ok)
+    {
+        memcpy(dst, s_layout, n);
+        *len = n;
+    }
+    xSemaphoreGive(s_lock);
+    return ok;
+}
+
+#else /* no esp_partition: cache disabled */
+
+bool tile_cache_init(void) { return false; }
+
+bool tile_cache_get(uint64_t key, uint8_t *dst, size_t cap, size_t *len)
+{
+    (void)key;
+    (void)dst;
+    (void)cap;
+    (void)len;
+    s_stats.misses++;
+    return false;
+}
+
+bool tile_cache_put(uint64_t key, const uint8_t *data, size_t len)
+{
+    (void)key;
+    (void)data;
+    (void)len;
+    s_stats.dropped++;
+    return false;
+}
+
+void tile_cache_save_layout(const uint8_t *data, size_t len)
+{
+    (void)data;
+    (void)len;
+}
+
+bool tile_cache_load_layout(uint8_t *dst, size_t cap, size_t *len)
+{
+    (void)dst;
+    (void)cap;
+    (void)len;
+    return false;
+}
+
+#endif
+
+void tile_cache_get_stats(tile_cache_stats_t *out)
+{
+    if (out)
+        *out = s_stats;
+}
@@ -0,0 +1,219 @@
+#include "tile_view.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <lvgl.h>
+#if __has_include("esp_heap_caps.h")
+#include "esp_heap_caps.h"
+#endif
+
+// 小幅平移的过渡时长（ms），0 关闭动画；一般设成主机发送视口的间隔左右，跟车时看不出跳动
+#ifndef TILE_VIEW_ANIM_MS
+#define TILE_VIEW_ANIM_MS 300
+#endif
+
+#define TV_MAX_GRID 8
+#define TV_TILE_BYTES ((size_t)TILE_VIEW_PX * TILE_VIEW_PX * sizeof(lv_color_t))
+#define TV_KEY_NONE UINT64_MAX
+
+extern "C" {
+
+static lv_obj_t *s_cont = nullptr;
+static lv_obj_t *s_img[TV_MAX_GRID * TV_MAX_GRID];
+static lv_img_dsc_t s_dsc[TV_MAX_GRID * TV_MAX_GRID];
+static uint64_t s_key[TV_MAX_GRID * TV_MAX_GRID];   // 各槽当前装着的瓦片
+static uint8_t *s_pool = nullptr;
+static uint8_t s_g = 0;
+
+// 目标视口，以及正在显示的位置（世界像素，动画中介于两次视口之间）
+static tile_view_hdr_t s_view;
+static bool s_have_view = false;
+static int64_t s_cur_x = 0;
+static int64_t s_cur_y = 0;
+static int64_t s_from_x = 0;
+static int64_t s_from_y = 0;
+
+static void *tv_alloc(size_t n)
+{
+#if __has_include("esp_heap_caps.h")
+    // 瓦片只在重绘地图区域时读，放 PSRAM
+    void *p = heap_caps_malloc(n, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (p) return p;
+    return heap_caps_malloc(n, MALLOC_CAP_8BIT);
+#else
+    return malloc(n);
+#endif
+}
+
+bool tile_view_init(lv_obj_t *map_img)
+{
+    if (s_cont) return true;
+    if (!map_img) return false;
+
+    lv_obj_t *parent = lv_obj_get_parent(map_img);
+    lv_obj_update_layout(parent);
+    const lv_coord_t w = lv_obj_get_content_width(parent);
+    const lv_coord_t h = lv_obj_get_content_height(parent);
+    if (w <= 0 || h <= 0) return false;
+
+    // 视口任意偏移时都要盖满：每边 ceil(边长/64) + 1 块
+    const int g = ((w > h ? w : h) + TILE_VIEW_PX - 1) / TILE_VIEW_PX + 1;
+    if (g > TV_MAX_GRID) {
+        Serial0.printf("[TILEVIEW] map area %dx%d too large for the tile grid\n", (int)w, (int)h);
+        return false;
+    }
+    s_g = (uint8_t)g;
+
+    s_cont = lv_obj_create(parent);
+    lv_obj_remove_style_all(s_cont);
+    lv_obj_clear_flag(s_cont, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(s_cont, w, h);
+    // 与地图同样对齐，紧贴在地图上面（轨迹层等仍在它之上）
+    lv_obj_set_align(s_cont, lv_obj_get_style_align(map_img, LV_PART_MAIN));
+    lv_obj_move_to_index(s_cont, lv_obj_get_index(map_img) + 1);
+    // 不透明底色：整块盖住下面的地图，LVGL 不再画被盖住的底图
+    lv_obj_set_style_bg_opa(s_cont, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_add_flag(s_cont, LV_OBJ_FLAG_HIDDEN);
+
+    for (int i = 0; i < g * g; i++) {
+        s_img[i] = lv_img_create(s_cont);
+        lv_obj_clear_flag(s_img[i], LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_set_size(s_img[i], TILE_VIEW_PX, TILE_VIEW_PX);
+        lv_obj_add_flag(s_img[i], LV_OBJ_FLAG_HIDDEN);
+        s_key[i] = TV_KEY_NONE;
+    }
+    return true;
+}
+
+lv_obj_t *tile_view_obj(void)
+{
+    return s_cont;
+}
+
+uint8_t tile_view_grid(void)
+{
+    return s_g;
+}
+
+static bool ensure_pool(void)
+{
+    if (s_pool) return true;
+    const int n = s_g * s_g;
+    s_pool = (uint8_t *)tv_alloc(TV_TILE_BYTES * n);
+    if (!s_pool) {
+        Serial0.printf("[TILEVIEW] tile pool allocation failed (%u bytes)\n", (unsigned)(TV_TILE_BYTES * n));
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        lv_img_dsc_t *d = &s_dsc[i];
+        memset(d, 0, sizeof(*d));
+        d->header.always_zero = 0;
+        d->header.cf = LV_IMG_CF_TRUE_COLOR;
+        d->header.w = TILE_VIEW_PX;
+        d->header.h = TILE_VIEW_PX;
+        d->data_size = TV_TILE_BYTES;
+        d->data = s_pool + TV_TILE_BYTES * i;
+        lv_img_set_src(s_img[i], d);
+    }
+    return true;
+}
+
+// 按目标视口的瓦片网格、以 (x, y) 为左上角摆放各槽；没装对瓦片的槽隐藏（露出底色）
+static void layout(int64_t x, int64_t y)
+{
+    const uint32_t c0 = s_view.px / TILE_VIEW_PX;
+    const uint32_t r0 = s_view.py / TILE_VIEW_PX;
+    for (uint32_t r = r0; r < r0 + s_g; r++) {
+        for (uint32_t c = c0; c < c0 + s_g; c++) {
+            const uint16_t slot = tile_view_slot(c, r, s_g);
+            tile_key_wire_t k = {};
+            k.z = s_view.z;
+            k.x = c;
+            k.y = r;
+            lv_obj_t *img = s_img[slot];
+            if (s_key[slot] != tile_key(&k)) {
+                lv_obj_add_flag(img, LV_OBJ_FLAG_HIDDEN);
+                continue;
+            }
+            lv_obj_set_pos(img, (lv_coord_t)((int64_t)c * TILE_VIEW_PX - x),
+                           (lv_coord_t)((int64_t)r * TILE_VIEW_PX - y));
+            lv_obj_clear_flag(img, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+}
+
+static void anim_cb(void *var, int32_t v)
+{
+    (void)var;
+    s_cur_x = s_from_x + ((int64_t)s_view.px - s_from_x) * v / 1024;
+    s_cur_y = s_from_y + ((int64_t)s_view.py - s_from_y) * v / 1024;
+    layout(s_cur_x, s_cur_y);
+}
+
+void tile_view_set(const tile_view_hdr_t *v)
+{
+    if (!s_cont || !ensure_pool()) return;
+
+    lv_anim_del(s_cont, anim_cb);
+    const int64_t dx = (int64_t)v->px - s_cur_x;
+    const int64_t dy = (int64_t)v->py - s_cur_y;
+    // 只在同一缩放级别、移动不到一个瓦片时过渡；其余情况（首帧、换级、跳转）直接到位
+    const bool glide = TILE_VIEW_ANIM_MS > 0 && s_have_view && v->z == s_view.z &&
+                       !lv_obj_has_flag(s_cont, LV_OBJ_FLAG_HIDDEN) &&
+                       dx > -TILE_VIEW_PX && dx < TILE_VIEW_PX && dy > -TILE_VIEW_PX && dy < TILE_VIEW_PX;
+
+    if (!s_have_view || v->bg != s_view.bg) {
+        const uint8_t r = (uint8_t)(((v->bg >> 11) & 0x1F) * 255 / 31);
+        const uint8_t g = (uint8_t)(((v->bg >> 5) & 0x3F) * 255 / 63);
+        const uint8_t b = (uint8_t)((v->bg & 0x1F) * 255 / 31);
+        lv_obj_set_style_bg_color(s_cont, lv_color_make(r, g, b), LV_PART_MAIN);
+    }
+    s_view = *v;
+    s_have_view = true;
+    lv_obj_clear_flag(s_cont, LV_OBJ_FLAG_HIDDEN);
+
+    if (!glide) {
+        s_cur_x = v->px;
+        s_cur_y = v->py;
+        layout(s_cur_x, s_cur_y);
+        return;
+    }
+    s_from_x = s_cur_x;
+    s_from_y = s_cur_y;
+    // 起点先按新网格摆好（新进来的瓦片可能换了槽）
+    layout(s_cur_x, s_cur_y);
+
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, s_cont);
+    lv_anim_set_exec_cb(&a, anim_cb);
+    lv_anim_set_values(&a, 0, 1024);
+    lv_anim_set_time(&a, TILE_VIEW_ANIM_MS);
+    lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
+    lv_anim_start(&a);
+}
+
+void tile_view_put(uint16_t slot, uint64_t key, const uint8_t *px)
+{
+    if (!s_cont || slot >= s_g * s_g || !ensure_pool()) return;
+
+    memcpy(s_pool + TV_TILE_BYTES * slot, px, TV_TILE_BYTES);
+    s_key[slot] = key;
+    lv_img_cache_invalidate_src(&s_dsc[slot]);
+    lv_obj_invalidate(s_img[slot]);
+    if (s_have_view) {
+        layout(s_cur_x, s_cur_y);
+    }
+}
+
+void tile_view_hide(void)
+{
+    if (!s_cont) return;
+    lv_anim_del(s_cont, anim_cb);
+    lv_obj_add_flag(s_cont, LV_OBJ_FLAG_HIDDEN);
+    s_have_view = false;
+}
+
+} // extern "C"
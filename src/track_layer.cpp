@@ -0,0 +1,166 @@
+#include "track_layer.h"
+#include "track_vec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <lvgl.h>
+#if __has_include("esp_heap_caps.h")
+#include "esp_heap_caps.h"
+#endif
+
+extern "C" {
+
+static lv_obj_t *s_img = nullptr;
+static lv_img_dsc_t s_dsc;
+static uint8_t *s_buf = nullptr;
+static lv_coord_t s_w = 0;
+static lv_coord_t s_h = 0;
+
+// 当前折线：所属视口、已画点数、最后一点（1/16 像素）
+static bool s_valid = false;
+static uint32_t s_view = 0;
+static uint16_t s_count = 0;
+static int32_t s_last_x = 0;
+static int32_t s_last_y = 0;
+static uint16_t s_color = 0;
+
+static void *tl_alloc(size_t n)
+{
+#if __has_include("esp_heap_caps.h")
+    // 只在重绘覆盖层时读，放 PSRAM
+    void *p = heap_caps_malloc(n, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (p) return p;
+    return heap_caps_malloc(n, MALLOC_CAP_8BIT);
+#else
+    return malloc(n);
+#endif
+}
+
+bool track_layer_init(lv_obj_t *map_img)
+{
+    if (s_img) return true;
+    if (!map_img) return false;
+
+    lv_obj_t *parent = lv_obj_get_parent(map_img);
+    lv_obj_update_layout(parent);
+    s_w = lv_obj_get_content_width(parent);
+    s_h = lv_obj_get_content_height(parent);
+    if (s_w <= 0 || s_h <= 0) return false;
+
+    s_img = lv_img_create(parent);
+    lv_obj_clear_flag(s_img, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_size(s_img, s_w, s_h);
+    // 与地图同样对齐，紧贴在地图上面（GPS 标题栏等仍在轨迹之上）
+    lv_obj_set_align(s_img, lv_obj_get_style_align(map_img, LV_PART_MAIN));
+    lv_obj_move_to_index(s_img, lv_obj_get_index(map_img) + 1);
+    lv_obj_set_style_img_recolor_opa(s_img, LV_OPA_COVER, LV_PART_MAIN);
+    lv_obj_add_flag(s_img, LV_OBJ_FLAG_HIDDEN);
+    return true;
+}
+
+lv_obj_t *track_layer_obj(void)
+{
+    return s_img;
+}
+
+static bool ensure_buf(void)
+{
+    if (s_buf) return true;
+    const size_t bytes = (size_t)s_w * s_h;
+    s_buf = (uint8_t *)tl_alloc(bytes);
+    if (!s_buf) return false;
+
+    memset(&s_dsc, 0, sizeof(s_dsc));
+    s_dsc.header.always_zero = 0;
+    s_dsc.header.cf = LV_IMG_CF_ALPHA_8BIT;
+    s_dsc.header.w = s_w;
+    s_dsc.header.h = s_h;
+    s_dsc.data_size = bytes;
+    s_dsc.data = s_buf;
+    memset(s_buf, 0, bytes);
+    lv_img_set_src(s_img, &s_dsc);
+    return true;
+}
+
+static void set_color(uint16_t c565)
+{
+    if (c565 == s_color && s_valid) return;
+    s_color = c565;
+    const uint8_t r = (uint8_t)(((c565 >> 11) & 0x1F) * 255 / 31);
+    const uint8_t g = (uint8_t)(((c565 >> 5) & 0x3F) * 255 / 63);
+    const uint8_t b = (uint8_t)((c565 & 0x1F) * 255 / 31);
+    lv_obj_set_style_img_recolor(s_img, lv_color_make(r, g, b), LV_PART_MAIN);
+}
+
+// 视口坐标 -> 覆盖层 1/16 像素
+static void to_layer(const trk_hdr_t *hdr, int32_t vx, int32_t vy, int32_t *x, int32_t *y)
+{
+    *x = (int32_t)((int64_t)vx * s_w * 16 / hdr->view_w);
+    *y = (int32_t)((int64_t)vy * s_h * 16 / hdr->view_h);
+}
+
+bool track_layer_apply(const uint8_t *payload, size_t len)
+{
+    trk_hdr_t hdr;
+    if (!s_img || !trk_parse(payload, len, &hdr)) {
+        Serial0.println("[TRACK] frame dropped (bad payload)");
+        return false;
+    }
+
+    const bool reset = (hdr.flags & TRK_FLAG_RESET) != 0;
+    if (!reset && (!s_valid || hdr.view != s_view || hdr.first != s_count)) {
+        // 之前的帧丢了：等主机下一帧重置
+        Serial0.printf("[TRACK] append dropped (have %u pts, frame starts at %u)\n",
+                       (unsigned)s_count, (unsigned)hdr.first);
+        return false;
+    }
+    if (!ensure_buf()) {
+        Serial0.println("[TRACK] layer allocation failed");
+        return false;
+    }
+
+    trk_area_t dirty = {1, 0, 0, 0};
+    if (reset) {
+        memset(s_buf, 0, (size_t)s_w * s_h);
+        dirty = {0, 0, (int16_t)(s_w - 1), (int16_t)(s_h - 1)};
+        s_view = hdr.view;
+        s_count = 0;
+    }
+    set_color(hdr.color);
+
+    trk_iter_t it;
+    trk_iter_init(&it, &hdr, payload);
+    int32_t vx, vy;
+    bool first = true;
+    while (trk_iter_next(&it, &vx, &vy)) {
+        int32_t x, y;
+        to_layer(&hdr, vx, vy, &x, &y);
+        if (first && reset) {
+            // 单点也画出一个圆点
+            s_last_x = x;
+            s_last_y = y;
+        }
+        trk_draw_segment(s_buf, s_w, s_h, s_last_x, s_last_y, x, y, hdr.width, &dirty);
+        s_last_x = x;
+        s_last_y = y;
+        first = false;
+    }
+    s_count = (uint16_t)(s_count + hdr.count);
+    s_valid = true;
+
+    lv_obj_clear_flag(s_img, LV_OBJ_FLAG_HIDDEN);
+    if (dirty.x1 <= dirty.x2) {
+        lv_area_t a;
+        lv_obj_get_coords(s_img, &a);
+        a.x1 += dirty.x1;
+        a.y1 += dirty.y1;
+        a.x2 = a.x1 + (dirty.x2 - dirty.x1);
+        a.y2 = a.y1 + (dirty.y2 - dirty.y1);
+        lv_obj_invalidate_area(s_img, &a);
+    }
+    return true;
+}
+
+} // extern "C"
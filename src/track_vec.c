@@ -0,0 +1,113 @@
+#include "track_vec.h"
+#include <math.h>
+#include <string.h>
+
+#define TRK_DELTA_BYTES 4
+
+bool trk_parse(const uint8_t *payload, size_t len, trk_hdr_t *hdr)
+{
+    if (!payload || !hdr || len < sizeof(*hdr))
+        return false;
+    memcpy(hdr, payload, sizeof(*hdr));
+    if (hdr->magic != TRK_MAGIC || !hdr->view_w || !hdr->view_h)
+        return false;
+    if (!hdr->count || (uint32_t)hdr->first + hdr->count > TRK_MAX_POINTS)
+        return false;
+    if ((hdr->flags & TRK_FLAG_RESET) && hdr->first)
+        return false;
+    if (len - sizeof(*hdr) < (size_t)(hdr->count - 1) * TRK_DELTA_BYTES)
+        return false;
+    if (!hdr->width)
+        hdr->width = 3;
+    return true;
+}
+
+void trk_iter_init(trk_iter_t *it, const trk_hdr_t *hdr, const uint8_t *payload)
+{
+    it->p = payload + sizeof(*hdr);
+    it->x = hdr->x0;
+    it->y = hdr->y0;
+    it->left = hdr->count;
+    it->started = false;
+}
+
+bool trk_iter_next(trk_iter_t *it, int32_t *x, int32_t *y)
+{
+    if (!it->left)
+        return false;
+    if (it->started)
+    {
+        it->x += (int16_t)(it->p[0] | (it->p[1] << 8));
+        it->y += (int16_t)(it->p[2] | (it->p[3] << 8));
+        it->p += TRK_DELTA_BYTES;
+    }
+    it->started = true;
+    it->left--;
+    *x = it->x;
+    *y = it->y;
+    return true;
+}
+
+static void grow(trk_area_t *a, int x1, int y1, int x2, int y2)
+{
+    if (a->x1 > a->x2)
+    {
+        a->x1 = (int16_t)x1;
+        a->y1 = (int16_t)y1;
+        a->x2 = (int16_t)x2;
+        a->y2 = (int16_t)y2;
+        return;
+    }
+    if (x1 < a->x1)
+        a->x1 = (int16_t)x1;
+    if (y1 < a->y1)
+        a->y1 = (int16_t)y1;
+    if (x2 > a->x2)
+        a->x2 = (int16_t)x2;
+    if (y2 > a->y2)
+        a->y2 = (int16_t)y2;
+}
+
+static int imin(int a, int b) { return a < b ? a : b; }
+static int imax(int a, int b) { return a > b ? a : b; }
+
+void trk_draw_segment(uint8_t *a8, int w, int h, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                      int width, trk_area_t *dirty)
+{
+    /* coverage = distance from the pixel centre to the segment against half the stroke,
+       with a one pixel ramp; round caps fall out of clamping to the endpoints */
+    const float ax = x0 / 16.0f, ay = y0 / 16.0f;
+    const float dx = (x1 - x0) / 16.0f, dy = (y1 - y0) / 16.0f;
+    const float len2 = dx * dx + dy * dy;
+    const float r = width * 0.5f;
+    const float outer = r + 0.5f;
+    const int pad = (int)ceilf(outer);
+
+    const int bx1 = imax((imin(x0, x1) >> 4) - pad, 0);
+    const int by1 = imax((imin(y0, y1) >> 4) - pad, 0);
+    const int bx2 = imin((imax(x0, x1) >> 4) + pad, w - 1);
+    const int by2 = imin((imax(y0, y1) >> 4) + pad, h - 1);
+    if (bx1 > bx2 || by1 > by2)
+        return;
+
+    for (int y = by1; y <= by2; y++)
+    {
+        uint8_t *row = a8 + (size_t)y * w;
+        const float py = y + 0.5f - ay;
+        for (int x = bx1; x <= bx2; x++)
+        {
+            const float px = x + 0.5f - ax;
+            float t = len2 > 0.0f ? (px * dx + py * dy) / len2 : 0.0f;
+            t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+            const float ex = px - t * dx, ey = py - t * dy;
+            const float d2 = ex * ex + ey * ey;
+            if (d2 >= outer * outer)
+                continue;
+            const float cov = outer - sqrtf(d2);
+            const uint8_t a = cov >= 1.0f ? 255 : (uint8_t)(cov * 255.0f);
+            if (a > row[x])
+                row[x] = a;
+        }
+    }
+    grow(dirty, bx1, by1, bx2, by2);
+}
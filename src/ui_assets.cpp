@@ -0,0 +1,165 @@
+#include "ui_assets.h"
+
+#include <Arduino.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+
+#include <lvgl.h>
+
+extern "C" {
+
+// 驻留副本合计可用的内部 RAM；超出的留在 flash（或需要解码时放 PSRAM）
+#ifndef UI_ASSETS_INTERNAL_BUDGET
+#define UI_ASSETS_INTERNAL_BUDGET (64 * 1024)
+#endif
+
+// 拷完之后内部 RAM 至少还要剩这么多（DMA 缓冲、任务栈、LVGL 小块）
+#ifndef UI_ASSETS_INTERNAL_RESERVE
+#define UI_ASSETS_INTERNAL_RESERVE (64 * 1024)
+#endif
+
+#define UA_MAX 8
+#define CAPS_INTERNAL (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define CAPS_PSRAM (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+
+static lv_img_dsc_t s_pinned[UA_MAX];
+static int s_count;
+static size_t s_internal_bytes;
+static size_t s_psram_bytes;
+
+size_t ui_assets_internal_bytes(void)
+{
+    return s_internal_bytes;
+}
+
+size_t ui_assets_psram_bytes(void)
+{
+    return s_psram_bytes;
+}
+
+static int index_bpp(lv_img_cf_t cf)
+{
+    switch (cf) {
+    case LV_IMG_CF_INDEXED_1BIT: return 1;
+    case LV_IMG_CF_INDEXED_2BIT: return 2;
+    case LV_IMG_CF_INDEXED_4BIT: return 4;
+    case LV_IMG_CF_INDEXED_8BIT: return 8;
+    default: return 0;
+    }
+}
+
+static bool raw_cf(lv_img_cf_t cf)
+{
+    return cf == LV_IMG_CF_TRUE_COLOR || cf == LV_IMG_CF_TRUE_COLOR_ALPHA ||
+           cf == LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED;
+}
+
+// 调色板图展开成 TRUE_COLOR_ALPHA：调色板是 2^bpp 个 lv_color32_t，像素按行打包、高位在前
+static void expand_indexed(const lv_img_dsc_t *src, int bpp, uint8_t *dst)
+{
+    const uint32_t w = src->header.w;
+    const uint32_t h = src->header.h;
+    const lv_color32_t *pal = (const lv_color32_t *)src->data;
+    const uint8_t *px = src->data + (sizeof(lv_color32_t) << bpp);
+    const uint32_t stride = (w * bpp + 7) / 8;
+    const uint8_t mask = (uint8_t)((1u << bpp) - 1);
+
+    for (uint32_t y = 0; y < h; y++) {
+        const uint8_t *row = px + y * stride;
+        for (uint32_t x = 0; x < w; x++) {
+            const uint32_t bit = x * bpp;
+            const uint8_t idx = (uint8_t)((row[bit >> 3] >> (8 - bpp - (bit & 7))) & mask);
+            const lv_color_t c = lv_color_make(pal[idx].ch.red, pal[idx].ch.green, pal[idx].ch.blue);
+            memcpy(dst, &c, sizeof(c));
+            dst[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = pal[idx].ch.alpha;
+            dst += LV_IMG_PX_SIZE_ALPHA_BYTE;
+        }
+    }
+}
+
+// 可见的 lv_img 里 src 为 from 的个数；to 非空时顺便改指向 to。隐藏的子树（已烘进静态层）跳过
+static int retarget(lv_obj_t *obj, const void *from, const void *to)
+{
+    if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) return 0;
+    int users = 0;
+    if (lv_obj_check_type(obj, &lv_img_class) && lv_img_get_src(obj) == from) {
+        if (to) lv_img_set_src(obj, to);
+        users++;
+    }
+    const uint32_t n = lv_obj_get_child_cnt(obj);
+    for (uint32_t i = 0; i < n; i++) {
+        users += retarget(lv_obj_get_child(obj, (int32_t)i), from, to);
+    }
+    return users;
+}
+
+static uint8_t *alloc_copy(size_t bytes, bool must, const char **where)
+{
+    if (s_internal_bytes + bytes <= UI_ASSETS_INTERNAL_BUDGET &&
+        heap_caps_get_free_size(CAPS_INTERNAL) > UI_ASSETS_INTERNAL_RESERVE + bytes) {
+        uint8_t *p = (uint8_t *)heap_caps_malloc(bytes, CAPS_INTERNAL);
+        if (p) {
+            s_internal_bytes += bytes;
+            *where = "internal";
+            return p;
+        }
+    }
+    if (!must) return nullptr;
+    uint8_t *p = (uint8_t *)heap_caps_malloc(bytes, CAPS_PSRAM);
+    if (p) {
+        s_psram_bytes += bytes;
+        *where = "psram";
+    }
+    return p;
+}
+
+static void pin_one(lv_obj_t *screen, const lv_img_dsc_t *src)
+{
+    const int users = retarget(screen, src, nullptr);
+    if (users == 0) {
+        Serial0.printf("[ASSETS] %ux%u: baked or unused, left in flash\n",
+                       (unsigned)src->header.w, (unsigned)src->header.h);
+        return;
+    }
+
+    const int bpp = index_bpp((lv_img_cf_t)src->header.cf);
+    if (!bpp && !raw_cf((lv_img_cf_t)src->header.cf)) return;  // 别的格式交给 LVGL 的解码器
+    const size_t bytes = bpp ? (size_t)src->header.w * src->header.h * LV_IMG_PX_SIZE_ALPHA_BYTE
+                             : src->data_size;
+
+    // 原始格式拷进内部 RAM 才有收益；调色板图无论放哪都比逐行解码强
+    const char *where = "flash";
+    uint8_t *data = alloc_copy(bytes, bpp != 0, &where);
+    if (!data) {
+        Serial0.printf("[ASSETS] %ux%u (%u bytes): %s\n", (unsigned)src->header.w, (unsigned)src->header.h,
+                       (unsigned)bytes, bpp ? "decode alloc failed" : "over budget, left in flash");
+        return;
+    }
+    if (bpp) {
+        expand_indexed(src, bpp, data);
+    } else {
+        memcpy(data, src->data, bytes);
+    }
+
+    lv_img_dsc_t *d = &s_pinned[s_count++];
+    d->header = src->header;
+    d->header.cf = bpp ? LV_IMG_CF_TRUE_COLOR_ALPHA : src->header.cf;
+    d->data_size = bytes;
+    d->data = data;
+    retarget(screen, src, d);
+    lv_img_cache_invalidate_src(src);
+
+    Serial0.printf("[ASSETS] %ux%u (%u bytes, %d users): %s%s\n", (unsigned)src->header.w,
+                   (unsigned)src->header.h, (unsigned)bytes, users, where, bpp ? ", decoded" : "");
+}
+
+void ui_assets_pin(lv_obj_t *screen, const void *const *assets, size_t n)
+{
+    if (!screen || !assets) return;
+    for (size_t i = 0; i < n && s_count < UA_MAX; i++) {
+        const lv_img_dsc_t *src = (const lv_img_dsc_t *)assets[i];
+        if (src && lv_img_src_get_type(src) == LV_IMG_SRC_VARIABLE) pin_one(screen, src);
+    }
+}
+
+} // extern "C"
@@ -5,14 +5,68 @@
 #include <string.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
 
 #include <lvgl.h>
 #include "ui.h"
 #include "squareline/ui_Home.h"
+#include "png_stream.h"
+#include "png_pipe.h"
+#include "imgf_receiver.h"
+#include "img_r565.h"
+#include "img_qoi.h"
+#include "hud_perf.h"
+#include "speed_digits.h"
+#include "ui_static_layer.h"
+#include "hud_dma_copy.h"
+#include "track_layer.h"
+#include "tile_cache.h"
+#include "tile_view.h"
+#include "gauge_interp.h"
+#include "hud_persist.h"
+#include "ui_assets.h"
+#include "ui_snap_bind.h"
+#include "hud_trace.h"
 #if __has_include("esp_heap_caps.h")
 #include "esp_heap_caps.h"
 #endif
 
+// 速度数字用预解码位图显示（见 speed_digits.h），-DUI_SPEED_DIGIT_CACHE=0 退回标签
+#ifndef UI_SPEED_DIGIT_CACHE
+#define UI_SPEED_DIGIT_CACHE 1
+#endif
+
+// 静态控件合成为一张底图（见 ui_static_layer.h），-DUI_STATIC_LAYER=0 关闭
+#ifndef UI_STATIC_LAYER
+#define UI_STATIC_LAYER 1
+#endif
+
+// 转速条/车速在两次快照之间按显示刷新率插值（见 gauge_interp.h），-DUI_GAUGE_INTERP=0 收到即跳
+#ifndef UI_GAUGE_INTERP
+#define UI_GAUGE_INTERP 1
+#endif
+
+// 下一帧快照迟到时沿原斜率外推的最长时间（ms）
+#ifndef UI_GAUGE_EXTRAP_MS
+#define UI_GAUGE_EXTRAP_MS 80
+#endif
+
+// 转速条前景不动，绘制时按裁剪宽度露出，只重绘新旧位置之间的竖条；-DUI_RPM_BAR_CLIP=0 退回移动图像
+#ifndef UI_RPM_BAR_CLIP
+#define UI_RPM_BAR_CLIP 1
+#endif
+
+// 变化慢的标签（时间、里程、油量、温度、电压）最短重绘间隔（ms），车速/转速条不限速；0 = 不限
+#ifndef UI_SLOW_LABEL_MS
+#define UI_SLOW_LABEL_MS 1000
+#endif
+
+// 解码线程里的 PNG 分两核流水：本线程 inflate，png_rows 线程反滤波 + 转色（见 png_pipe.h）；0 = 单线程解
+#ifndef UI_PNG_PIPE
+#define UI_PNG_PIPE 1
+#endif
+
 extern "C" {
 
 /* ---------- UI 快照结构 ---------- */
@@ -46,8 +100,35 @@ typedef struct {
     uint16_t trip_time_min;
     uint16_t fuel_left_dl;
     uint16_t fuel_total_dl;
+    uint32_t seq;            // 帧序号，用于时延统计和插值
+    uint32_t rx_ms;          // 到达时刻（millis），插值按到达间隔估计快照周期
 } ui_snapshot_t;
 
+/* 线上布局表（见 ui_snap_bind.h）：解码、增量快照的字段偏移都由它展开，
+   新字段在结构里加成员、这里按线上顺序加一行 */
+#define SNAP_FIELD(off, type, member) \
+    snap_bind::field<ui_snapshot_t, off, snap_bind::type, &ui_snapshot_t::member>
+
+typedef SNAP_FIELD(0,  W_I16, speed)         snap_f_speed;
+typedef SNAP_FIELD(2,  W_I16, rpm)           snap_f_rpm;
+typedef SNAP_FIELD(4,  W_I32, odo)           snap_f_odo;
+typedef SNAP_FIELD(8,  W_I32, trip_odo)      snap_f_trip_odo;
+typedef SNAP_FIELD(12, W_I16, out_temp)      snap_f_out_temp;
+typedef SNAP_FIELD(14, W_I16, in_temp)       snap_f_in_temp;
+typedef SNAP_FIELD(16, W_I16, batt_mv)       snap_f_batt_mv;
+typedef SNAP_FIELD(18, W_U16, cur_time_min)  snap_f_cur_time;
+typedef SNAP_FIELD(20, W_U16, trip_time_min) snap_f_trip_time;
+typedef SNAP_FIELD(22, W_U16, fuel_left_dl)  snap_f_fuel_left;
+typedef SNAP_FIELD(24, W_U16, fuel_total_dl) snap_f_fuel_total;
+
+#undef SNAP_FIELD
+
+typedef snap_bind::layout<
+    snap_f_speed, snap_f_rpm, snap_f_odo, snap_f_trip_odo,
+    snap_f_out_temp, snap_f_in_temp, snap_f_batt_mv,
+    snap_f_cur_time, snap_f_trip_time, snap_f_fuel_left, snap_f_fuel_total
+> snap_layout;
+
 /* ---------- PNG项结构（零拷贝方案）---------- */
 
 typedef struct {
@@ -55,13 +136,22 @@ typedef struct {
     size_t len;
     int token;
     void (*release_cb)(int);
+    uint16_t frag;   // 分片序号（仅 UI_EV_PNG_FRAG）
+    uint8_t flags;   // IMGF_FLAG_*（仅 UI_EV_PNG_FRAG）
+    uint8_t type;    // IMGF_TYPE_*，整帧时区分 PNG / R565
 } png_item_t;
 
 /* ---------- 事件类型 ---------- */
 
 typedef enum {
     UI_EV_SNAPSHOT = 1,
-    UI_EV_PNG_ITEM = 2
+    UI_EV_PNG_ITEM = 2,
+    UI_EV_PNG_FRAG = 3,
+    UI_EV_MAP_RECT = 4,
+    UI_EV_TRACK = 5,
+    UI_EV_TILE = 6,
+    UI_EV_TILE_MAP = 7,
+    UI_EV_TILE_VIEW = 8
 } ui_ev_type_t;
 
 typedef struct {
@@ -75,16 +165,32 @@ typedef struct {
 // 分别为MSG和IMG创建独立队列
 static QueueHandle_t s_msg_q = nullptr;  // MSG队列 - 用于快速的小数据
 static QueueHandle_t s_img_q = nullptr;  // IMG队列 - 用于慢速的大数据
+#define IMG_Q_DEPTH 4
+static TaskHandle_t s_decode_task = nullptr;  // 图片解码线程（可选）
+static volatile uint32_t s_img_replaced = 0;  // 未显示就被取代的整帧数（遥测用）
+
+static void (*volatile s_notify_fn)(void *) = nullptr;
+static void *s_notify_user = nullptr;
+
+static void notify_ui(void)
+{
+    void (*fn)(void *) = s_notify_fn;
+    if (fn) {
+        fn(s_notify_user);
+    }
+}
 
 // 当前正在被 lv_img 对象引用的位图数据（TRUE_COLOR 或 TRUE_COLOR_ALPHA）
 static uint8_t *s_map_img_buf = nullptr;
+static lv_img_dsc_t s_map_dsc;
 
+// 按 HUD_DMA_COPY_ALIGN 对齐，位图之间的大块拷贝可以交给 GDMA
 static void *ui_alloc(size_t n)
 {
 #if __has_include("esp_heap_caps.h")
-    void *p = heap_caps_malloc(n, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    void *p = heap_caps_aligned_alloc(HUD_DMA_COPY_ALIGN, n, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
     if (p) return p;
-    return heap_caps_malloc(n, MALLOC_CAP_8BIT);
+    return heap_caps_aligned_alloc(HUD_DMA_COPY_ALIGN, n, MALLOC_CAP_8BIT);
 #else
     return malloc(n);
 #endif
@@ -99,6 +205,86 @@ static void ui_free(void *p)
 #endif
 }
 
+/* ---------- 地图位图池（乒乓双缓冲）----------
+   启动时一次性分配两块最大尺寸的位图，解码器直接写入空闲的一块，切换显示后旧的一块
+   回到空闲；长时间运行不再反复 malloc/free 大块 PSRAM。超出池容量的图退回动态分配。 */
+
+#ifndef UI_MAP_POOL_W
+#define UI_MAP_POOL_W 260   // ui_Group_Map 尺寸
+#endif
+#ifndef UI_MAP_POOL_H
+#define UI_MAP_POOL_H 260
+#endif
+
+#define MAP_POOL_N 2
+
+static uint8_t *s_pool_buf[MAP_POOL_N];
+static bool s_pool_used[MAP_POOL_N];
+static size_t s_pool_cap = 0;
+static SemaphoreHandle_t s_pool_sem = nullptr;  // 空闲块计数
+static portMUX_TYPE s_pool_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static void map_pool_init(void)
+{
+    if (s_pool_sem) return;
+
+    const size_t cap = (size_t)lv_img_buf_get_img_size(UI_MAP_POOL_W, UI_MAP_POOL_H, LV_IMG_CF_TRUE_COLOR_ALPHA);
+    for (int i = 0; i < MAP_POOL_N; i++) {
+        s_pool_buf[i] = (uint8_t *)ui_alloc(cap);
+        if (!s_pool_buf[i]) {
+            for (int j = 0; j < i; j++) {
+                ui_free(s_pool_buf[j]);
+                s_pool_buf[j] = nullptr;
+            }
+            Serial0.println("[UI_BRIDGE] map pool allocation failed, using per-frame buffers");
+            return;
+        }
+    }
+    s_pool_cap = cap;
+    s_pool_sem = xSemaphoreCreateCounting(MAP_POOL_N, MAP_POOL_N);
+}
+
+/* 取一块能放下 bytes 的位图缓冲；池满时最多等 wait（解码线程可等，LVGL 线程不等） */
+static uint8_t *map_buf_acquire(size_t bytes, TickType_t wait)
+{
+    if (s_pool_sem && bytes <= s_pool_cap && xSemaphoreTake(s_pool_sem, wait) == pdTRUE) {
+        uint8_t *p = nullptr;
+        portENTER_CRITICAL(&s_pool_mux);
+        for (int i = 0; i < MAP_POOL_N; i++) {
+            if (!s_pool_used[i]) {
+                s_pool_used[i] = true;
+                p = s_pool_buf[i];
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&s_pool_mux);
+        if (p) return p;
+        xSemaphoreGive(s_pool_sem);
+    }
+    return (uint8_t *)ui_alloc(bytes);
+}
+
+/* 解码线程可以等 LVGL 线程切换后归还缓冲；LVGL 线程自己绝不能等 */
+static TickType_t map_buf_wait(void)
+{
+    return (s_decode_task && xTaskGetCurrentTaskHandle() == s_decode_task) ? portMAX_DELAY : 0;
+}
+
+static void map_buf_release(uint8_t *p)
+{
+    if (!p) return;
+    for (int i = 0; i < MAP_POOL_N; i++) {
+        if (p == s_pool_buf[i]) {
+            portENTER_CRITICAL(&s_pool_mux);
+            s_pool_used[i] = false;
+            portEXIT_CRITICAL(&s_pool_mux);
+            xSemaphoreGive(s_pool_sem);
+            return;
+        }
+    }
+    ui_free(p);
+}
+
 static bool decode_png_to_lv_img_data(const uint8_t *png,
                                       size_t len,
                                       uint8_t **out_data,
@@ -135,12 +321,12 @@ static bool decode_png_to_lv_img_data(const uint8_t *png,
     }
 
     const size_t out_sz = (size_t)lv_img_buf_get_img_size(dec.header.w, dec.header.h, out_cf_local);
-    uint8_t *buf = (uint8_t *)ui_alloc(out_sz);
+    uint8_t *buf = map_buf_acquire(out_sz, 0);
     if (!buf) {
         lv_img_decoder_close(&dec);
         return false;
     }
-    memcpy(buf, dec.img_data, out_sz);
+    hud_dma_copy(buf, dec.img_data, out_sz);   // 解码线程睡眠等待 GDMA，CPU 让给同核其它任务
 
     *out_data = buf;
     *out_bytes = out_sz;
@@ -154,63 +340,359 @@ static bool decode_png_to_lv_img_data(const uint8_t *png,
 
 /* ---------- LVGL 内部工具 ---------- */
 
-static void set_time_label(lv_obj_t *label, uint16_t min)
+/* 速度标签的常驻文本缓冲，用 lv_label_set_text_static 直接引用：不再经
+   lv_label_set_text 的 malloc 拷贝，文本不变就不碰标签。其余标签的缓冲在绑定表里
+   （见 apply_snapshot_lvgl 前的 snap_labels） */
+typedef struct {
+    char text[16];
+    bool valid;
+} label_cache_t;
+
+static label_cache_t s_speed_lbl;       // ui_Speed_Number_1/_2 共用同一块缓冲
+static ui_snapshot_t s_last_snap;       // 上次生效的快照（车速/转速未变时跳过）
+static bool s_last_valid = false;
+static lv_coord_t s_rpm_x = LV_COORD_MIN;
+
+/* 格式化好的文本与当前显示不同则写入常驻缓冲，返回是否需要刷新标签 */
+static bool label_changed(label_cache_t *c, const char *text)
 {
-    char buf[6];
-    snprintf(buf, sizeof(buf), "%02u:%02u", min / 60, min % 60);
-    lv_label_set_text(label, buf);
+    if (c->valid && strcmp(c->text, text) == 0) return false;
+    strncpy(c->text, text, sizeof(c->text) - 1);
+    c->text[sizeof(c->text) - 1] = '\0';
+    c->valid = true;
+    return true;
 }
 
-/* ---------- 整体 UI 刷新 ---------- */
+/* ---- 定点整数格式化（代替 snprintf 的 %f / double 软浮点）---- */
 
-static void apply_snapshot_lvgl(const ui_snapshot_t *s)
+// 十进制无符号整数，返回写入字符数（不含结尾 0）
+static int fmt_uint(char *p, uint32_t v)
+{
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (int i = 0; i < n; i++) {
+        p[i] = tmp[n - 1 - i];
+    }
+    p[n] = '\0';
+    return n;
+}
+
+static int fmt_int(char *p, int32_t v)
+{
+    if (v < 0) {
+        *p = '-';
+        return 1 + fmt_uint(p + 1, (uint32_t)(-(int64_t)v));
+    }
+    return fmt_uint(p, (uint32_t)v);
+}
+
+// 以 0.1 为单位的值 -> "[-]x.y"；plus 时非负数带 '+'（同 "%+.1f"）
+static int fmt_tenths(char *p, int32_t tenths, bool plus)
 {
-    /* 速度 */
+    int n = 0;
+    uint32_t mag;
+    if (tenths < 0) {
+        p[n++] = '-';
+        mag = (uint32_t)(-(int64_t)tenths);
+    } else {
+        if (plus) p[n++] = '+';
+        mag = (uint32_t)tenths;
+    }
+    n += fmt_uint(p + n, mag / 10);
+    p[n++] = '.';
+    p[n++] = (char)('0' + mag % 10);
+    p[n] = '\0';
+    return n;
+}
+
+// v / d 四舍五入（远离 0），d > 0
+static int32_t div_round(int32_t v, int32_t d)
+{
+    return v >= 0 ? (v + d / 2) / d : -((-v + d / 2) / d);
+}
+
+static void fmt_hhmm(char *p, uint16_t min)
+{
+    const unsigned h = min / 60, m = min % 60;
+    if (h < 100) {
+        p[0] = (char)('0' + h / 10);
+        p[1] = (char)('0' + h % 10);
+        p[2] = ':';
+        p[3] = (char)('0' + m / 10);
+        p[4] = (char)('0' + m % 10);
+        p[5] = '\0';
+    } else {
+        int n = fmt_uint(p, h);
+        p[n++] = ':';
+        p[n++] = (char)('0' + m / 10);
+        p[n++] = (char)('0' + m % 10);
+        p[n] = '\0';
+    }
+}
+
+/* ---------- 转速/车速 ---------- */
+
+static void show_speed(int32_t speed)
+{
+    if (speed_digits_set(speed)) return;
+    // 数字缓存未启用或超出 0..999 时走标签
     char buf[16];
-    snprintf(buf, sizeof(buf), "%d", (int)s->speed);
-    lv_label_set_text(ui_Speed_Number_1, buf);
-    lv_label_set_text(ui_Speed_Number_2, buf);
+    fmt_int(buf, speed);
+    if (label_changed(&s_speed_lbl, buf)) {
+        lv_label_set_text_static(ui_Speed_Number_1, s_speed_lbl.text);
+        lv_label_set_text_static(ui_Speed_Number_2, s_speed_lbl.text);
+    }
+}
 
-    /* 转速 */
-    int rpm = s->rpm;
+#if UI_RPM_BAR_CLIP
+/* 原设计把前景图右移 x、由容器裁掉右边出界的部分，每次都让新旧两块 180 px 宽的区域失效。
+   现在前景固定在 x=0，DRAW_MAIN 期间把裁剪区收窄到 [x1 + s_rpm_x, x2]，屏幕上露出的范围不变；
+   转速变化只让新旧两个边界之间的竖条失效 */
+static lv_area_t s_rpm_clip;
+static const lv_area_t *s_rpm_clip_saved = nullptr;
+
+static void rpm_bar_draw_cb(lv_event_t *e)
+{
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    if (lv_event_get_code(e) == LV_EVENT_DRAW_MAIN_BEGIN) {
+        lv_area_t reveal;
+        lv_obj_get_coords(ui_ImgSpeedfg, &reveal);
+        reveal.x1 += s_rpm_x;
+        s_rpm_clip_saved = draw_ctx->clip_area;
+        if (!_lv_area_intersect(&s_rpm_clip, s_rpm_clip_saved, &reveal)) {
+            // 全部遮住：给一个空区域，图像绘制自己会跳过
+            s_rpm_clip.x1 = 0;
+            s_rpm_clip.y1 = 0;
+            s_rpm_clip.x2 = -1;
+            s_rpm_clip.y2 = -1;
+        }
+        draw_ctx->clip_area = &s_rpm_clip;
+    } else if (s_rpm_clip_saved) {
+        draw_ctx->clip_area = s_rpm_clip_saved;
+        s_rpm_clip_saved = nullptr;
+    }
+}
+
+static void rpm_bar_init(void)
+{
+    // 从设计稿的初始位置开始，第一帧快照前显示不变
+    s_rpm_x = lv_obj_get_style_x(ui_ImgSpeedfg, LV_PART_MAIN);
+    lv_obj_set_x(ui_ImgSpeedfg, 0);
+    lv_obj_add_event_cb(ui_ImgSpeedfg, rpm_bar_draw_cb, LV_EVENT_DRAW_MAIN_BEGIN, nullptr);
+    lv_obj_add_event_cb(ui_ImgSpeedfg, rpm_bar_draw_cb, LV_EVENT_DRAW_MAIN_END, nullptr);
+}
+
+static void rpm_bar_set(lv_coord_t x)
+{
+    lv_area_t strip;
+    lv_obj_get_coords(ui_ImgSpeedfg, &strip);
+    const lv_coord_t x0 = strip.x1;
+    strip.x1 = x0 + LV_MIN(x, s_rpm_x);
+    strip.x2 = x0 + LV_MAX(x, s_rpm_x) - 1;
+    s_rpm_x = x;
+    lv_obj_invalidate_area(ui_ImgSpeedfg, &strip);
+}
+#endif
+
+/* 转速：0..8000 -> 0..180 px，四舍五入 */
+static void show_rpm(int32_t rpm)
+{
     if (rpm < 0) rpm = 0;
     if (rpm > 8000) rpm = 8000;
-    int x = lround(rpm / 8000.0 * 180.0);
-    lv_obj_set_x(ui_ImgSpeedfg, x);
+    lv_coord_t x = (lv_coord_t)div_round(rpm * 180, 8000);
+    if (x != s_rpm_x) {
+#if UI_RPM_BAR_CLIP
+        rpm_bar_set(x);
+#else
+        s_rpm_x = x;
+        lv_obj_set_x(ui_ImgSpeedfg, x);
+#endif
+    }
+}
+
+#if UI_GAUGE_INTERP
+/* 快照只给出目标值，这个定时器按显示刷新周期把转速条/车速推到插值位置；
+   两者都停下后暂停，静止时没有额外开销 */
+static gauge_interp_t s_rpm_ip;
+static gauge_interp_t s_speed_ip;
+static lv_timer_t *s_gauge_timer = nullptr;
+static int32_t s_speed_shown = INT32_MIN;
+
+static void gauge_tick(lv_timer_t *t)
+{
+    (void)t;
+    const uint32_t now = millis();
+    show_rpm(gauge_interp_value(&s_rpm_ip, now));
+    const int32_t speed = gauge_interp_value(&s_speed_ip, now);
+    if (speed != s_speed_shown) {
+        s_speed_shown = speed;
+        show_speed(speed);
+    }
+    if (gauge_interp_settled(&s_rpm_ip, now) && gauge_interp_settled(&s_speed_ip, now)) {
+        lv_timer_pause(s_gauge_timer);
+    }
+}
+
+static void gauge_init(void)
+{
+    gauge_interp_init(&s_rpm_ip, UI_GAUGE_EXTRAP_MS);
+    gauge_interp_init(&s_speed_ip, UI_GAUGE_EXTRAP_MS);
+    s_gauge_timer = lv_timer_create(gauge_tick, LV_DISP_DEF_REFR_PERIOD, nullptr);
+    lv_timer_pause(s_gauge_timer);
+}
+#endif
+
+static void apply_gauges(const ui_snapshot_t *s, bool first)
+{
+#if UI_GAUGE_INTERP
+    if (s_gauge_timer) {
+        // 每帧都喂（值没变也要更新到达时刻，否则会按旧斜率外推）
+        gauge_interp_sample(&s_rpm_ip, s->rpm, s->seq, s->rx_ms);
+        gauge_interp_sample(&s_speed_ip, s->speed, s->seq, s->rx_ms);
+        lv_timer_resume(s_gauge_timer);
+        gauge_tick(s_gauge_timer);   // 立即走一步，已经停下（如首帧、跳变）时会自己再暂停
+        return;
+    }
+#endif
+    if (first || s_last_snap.speed != s->speed) show_speed(s->speed);
+    if (first || s_last_snap.rpm != s->rpm) show_rpm(s->rpm);
+}
+
+/* ---------- 整体 UI 刷新 ---------- */
+
+/* 标签绑定表：字段 -> 换算 -> 格式化 -> 控件 -> 限速（见 ui_snap_bind.h）。
+   字段与上次显示的值相同连格式化都跳过（首帧全部刷新），文本相同不碰标签。
+   这些字段变化慢，按 UI_SLOW_LABEL_MS 限速，重绘和刷屏留给车速、转速条；
+   会在显示边界上抖动的值（油量晃动、电压纹波）再加迟滞，单位是字段原始单位 */
+
+static void label_set_static(lv_obj_t *label, const char *text)
+{
+    lv_label_set_text_static(label, text);
+}
 
+static void fmt_clock(char *p, int32_t min) { fmt_hhmm(p, (uint16_t)min); }
+static void fmt_dec1(char *p, int32_t tenths) { fmt_tenths(p, tenths, false); }
+static void fmt_dec1_signed(char *p, int32_t tenths) { fmt_tenths(p, tenths, true); }
+
+static void fmt_ratio(char *p, int32_t a, int32_t b)
+{
+    int n = fmt_uint(p, (uint32_t)a);
+    p[n++] = '/';
+    fmt_uint(p + n, (uint32_t)b);
+}
+
+#define SNAP_LABEL(f, sc, fmt, obj, hyst) \
+    snap_bind::text<f, sc, fmt, lv_obj_t, &obj, label_set_static, snap_bind::rate<UI_SLOW_LABEL_MS, hyst> >
+
+typedef snap_bind::bindings<
     /* 时间 */
-    set_time_label(ui_Label_Time3,  s->cur_time_min);
-    set_time_label(ui_Label_Time_Trip, s->trip_time_min);
+    SNAP_LABEL(snap_f_cur_time,  snap_bind::scale<1>, fmt_clock, ui_Label_Time3, 0),
+    SNAP_LABEL(snap_f_trip_time, snap_bind::scale<1>, fmt_clock, ui_Label_Time_Trip, 0),
+    /* 油量：0.1L -> 整数L（截断），格式 left/total；液面晃动 0.5L 以内不重绘 */
+    snap_bind::text2<snap_f_fuel_left, snap_f_fuel_total, snap_bind::scale<10, false>, fmt_ratio,
+                     lv_obj_t, &ui_Label_Gas_Number, label_set_static, snap_bind::rate<UI_SLOW_LABEL_MS, 5> >,
+    /* ODO / Trip ODO：米 -> 公里，1位小数 */
+    SNAP_LABEL(snap_f_odo,      snap_bind::scale<100>, fmt_dec1, ui_Label_ODO_Number1, 0),
+    SNAP_LABEL(snap_f_trip_odo, snap_bind::scale<100>, fmt_dec1, ui_Label_Trip_Odo, 0),
+    /* 室外温度：0.1°C -> ±xx.x，变化 ≥0.1°C 才重绘 */
+    SNAP_LABEL(snap_f_out_temp, snap_bind::scale<1>, fmt_dec1_signed, ui_Label_Temp2, 1),
+    /* 电池电压：mV -> V，1位小数；半个显示步长（50mV）以内的纹波不重绘 */
+    SNAP_LABEL(snap_f_batt_mv,  snap_bind::scale<100>, fmt_dec1, ui_Label_Battery_Number1, 50)
+> snap_labels;
+
+#undef SNAP_LABEL
+
+static void apply_snapshot_lvgl(const ui_snapshot_t *s)
+{
+    HUD_PERF_MARK(s->seq, HUD_PERF_STAGE_APPLY);
+
+    /* 速度、转速 */
+    apply_gauges(s, !s_last_valid);
+
+    snap_labels::apply(*s, s->rx_ms, !s_last_valid);
+
+    s_last_snap = *s;
+    s_last_valid = true;
+}
+
+/* ---------- 地图位图切换 ---------- */
+
+/* 断电保存用：LVGL 线程换图/修补时持锁，ui_bridge_save_map 持锁拷一份当前位图，写 flash 在锁外 */
+static SemaphoreHandle_t s_map_lock = nullptr;
+static SemaphoreHandle_t s_map_save_lock = nullptr;   // app（CMD=0x01）与 pm 线程都会保存，整次保存串行化
+static volatile uint32_t s_map_gen = 0;   // 当前地图内容每变一次 +1
+static uint32_t s_map_saved_gen = 0;
+static volatile bool s_map_view = false;  // 瓦片视口盖在位图上，位图不是屏上看到的
+
+static void map_lock(void)
+{
+    if (s_map_lock) xSemaphoreTake(s_map_lock, portMAX_DELAY);
+}
+
+static void map_unlock(void)
+{
+    if (s_map_lock) xSemaphoreGive(s_map_lock);
+}
+
+static void set_map_bitmap(uint8_t *data, size_t bytes, lv_coord_t w, lv_coord_t h, lv_img_cf_t cf)
+{
+    map_lock();
+    s_map_dsc.header.always_zero = 0;
+    s_map_dsc.header.w = w;
+    s_map_dsc.header.h = h;
+    s_map_dsc.header.cf = cf;
+    s_map_dsc.data_size = bytes;
+    s_map_dsc.data = data;
+
+    lv_img_cache_invalidate_src(&s_map_dsc);
+    lv_img_set_src(ui_Map_Bg, &s_map_dsc);
 
-    /* 油量：0.1L -> 整数L，格式 left/total */
-    int fuel_left_l = (int)(s->fuel_left_dl / 10U);
-    int fuel_total_l = (int)(s->fuel_total_dl / 10U);
-    snprintf(buf, sizeof(buf), "%d/%d", fuel_left_l, fuel_total_l);
-    lv_label_set_text(ui_Label_Gas_Number, buf);
+    // 旧位图已不再被 lv_img 引用，回到池中（乒乓）
+    if (s_map_img_buf && s_map_img_buf != data) {
+        map_buf_release(s_map_img_buf);
+    }
+    s_map_img_buf = data;
+    s_map_view = false;
+    s_map_gen++;
+    map_unlock();
+}
 
-    /* ODO：米 -> 公里，1位小数 */
-    char big_buf[24];
-    float odo_km = (float)s->odo / 1000.0f;
-    snprintf(big_buf, sizeof(big_buf), "%.1f", (double)odo_km);
-    lv_label_set_text(ui_Label_ODO_Number1, big_buf);
+/* ---------- 解码结果 ----------
+   解码（可在解码线程）与生效（只在 LVGL 线程）分成两步：解码只产出 map_out_t，
+   不碰任何 lv_obj；commit_map_out 再切换/修补地图。 */
 
-    /* Trip ODO：米 -> 公里，1位小数 */
-    float trip_odo_km = (float)s->trip_odo / 1000.0f;
-    snprintf(big_buf, sizeof(big_buf), "%.1f", (double)trip_odo_km);
-    lv_label_set_text(ui_Label_Trip_Odo, big_buf);
+typedef enum {
+    MAP_OUT_NONE = 0,   // 无需处理（解码失败 / 分片未完）
+    MAP_OUT_SWAP,       // 整张新位图，切换显示
+    MAP_OUT_RECT,       // 局部矩形，修补当前位图
+    MAP_OUT_LVGL_PNG,   // 流式解码器不支持，退回 LVGL 线程用 LVGL 解码器
+    MAP_OUT_TRACK,      // 矢量轨迹载荷副本，LVGL 线程画进轨迹层
+    MAP_OUT_VIEW        // 瓦片视口：一批新瓦片（view_batch_t）+ 可选的新视口
+} map_out_kind_t;
 
-    /* 室外温度：0.1°C -> ±xx.x */
-    float out_temp_c = (float)s->out_temp / 10.0f;
-    snprintf(big_buf, sizeof(big_buf), "%+.1f", (double)out_temp_c);
-    lv_label_set_text(ui_Label_Temp2, big_buf);
+typedef struct {
+    map_out_kind_t kind;
+    uint8_t *buf;
+    size_t bytes;
+    lv_coord_t w;
+    lv_coord_t h;
+    lv_img_cf_t cf;
+    r565_rect_t rect;   // MAP_OUT_RECT
+    png_item_t item;    // MAP_OUT_LVGL_PNG，token 尚未释放
+} map_out_t;
 
-    /* 电池电压：mV -> V，1位小数 */
-    float batt_v = (float)s->batt_mv / 1000.0f;
-    snprintf(big_buf, sizeof(big_buf), "%.1f", (double)batt_v);
-    lv_label_set_text(ui_Label_Battery_Number1, big_buf);
+static void release_item(const png_item_t *it)
+{
+    if (it->release_cb) {
+        it->release_cb(it->token);
+    }
 }
 
-/* ---------- PNG处理（一次解码转RGB565）---------- */
+/* ---------- PNG处理（LVGL解码器，只能在LVGL线程）---------- */
 
 static void apply_png_lvgl(const png_item_t *it)
 {
@@ -223,151 +705,1394 @@ static void apply_png_lvgl(const png_item_t *it)
     const bool ok = decode_png_to_lv_img_data(it->png, it->len, &new_data, &new_bytes, &new_w, &new_h, &new_cf);
 
     // PNG原始buffer只在当前函数解码时使用，随后即可释放
-    if (it->release_cb) {
-        it->release_cb(it->token);
-    }
+    release_item(it);
 
     if (!ok) {
-        Serial0.println("[UI_BRIDGE] PNG decode failed, keep previous map");
+        // 多半是 PSRAM 碎片：空闲总量够，但没有一块放得下整张位图
+        Serial0.printf("[UI_BRIDGE] PNG decode failed, keep previous map (psram free %u largest %u)\n",
+                       (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+                       (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
         return;
     }
 
-    static lv_img_dsc_t img_dsc;
-    img_dsc.header.always_zero = 0;
-    img_dsc.header.w = new_w;
-    img_dsc.header.h = new_h;
-    img_dsc.header.cf = new_cf;
-    img_dsc.data_size = new_bytes;
-    img_dsc.data = new_data;
+    set_map_bitmap(new_data, new_bytes, new_w, new_h, new_cf);
+}
+
+/* ---------- R565位图（主机已转好像素，跳过PNG）---------- */
+
+static void decode_r565(const png_item_t *it, map_out_t *out)
+{
+    r565_hdr_t hdr;
+    uint8_t *buf = nullptr;
+    size_t bytes = 0;
+    bool ok = r565_parse(it->png, it->len, &hdr);
+    if (ok) {
+        bytes = r565_work_size(&hdr);
+        buf = map_buf_acquire(bytes, map_buf_wait());
+        // 解压后直接就是 lv_color_t 数组，字节序按 LV_COLOR_16_SWAP 调整
+        ok = buf && r565_decode(&hdr, it->png, it->len, buf, bytes, LV_COLOR_16_SWAP != 0);
+    }
 
-    lv_img_cache_invalidate_src(&img_dsc);
-    lv_img_set_src(ui_Map_Bg, &img_dsc);
+    release_item(it);
 
-    if (s_map_img_buf) {
-        ui_free(s_map_img_buf);
+    if (!ok) {
+        map_buf_release(buf);
+        Serial0.println("[UI_BRIDGE] R565 decode failed, keep previous map");
+        return;
     }
-    s_map_img_buf = new_data;
+
+    out->kind = MAP_OUT_SWAP;
+    out->buf = buf;
+    out->bytes = (size_t)hdr.w * hdr.h * sizeof(lv_color_t);
+    out->w = hdr.w;
+    out->h = hdr.h;
+    out->cf = LV_IMG_CF_TRUE_COLOR;
 }
 
-/* ---------- API ---------- */
+/* ---------- 局部更新（只改脏矩形）----------
+   解码到临时缓冲，生效时改写当前位图的对应区域并只重绘这块区域；TRUE_COLOR 位图由 LVGL
+   直接引用原始数据，不需要重新 set_src。 */
 
-void ui_bridge_init(void)
+static void decode_map_rect(const png_item_t *it, map_out_t *out)
 {
-    if (!s_msg_q) {
-        /* MSG队列：只保留最新快照，降低UI线程负担 */
-        s_msg_q = xQueueCreate(1, sizeof(ui_event_t));
+    r565_rect_t rc = {};
+    r565_hdr_t hdr = {};
+    uint8_t *tmp = nullptr;
+    const char *why = nullptr;
+
+    if (it->len < sizeof(rc)) {
+        why = "short";
+    } else {
+        memcpy(&rc, it->png, sizeof(rc));
+        const uint8_t *body = it->png + sizeof(rc);
+        const size_t body_len = it->len - sizeof(rc);
+
+        if (!r565_parse(body, body_len, &hdr) ||
+            (uint32_t)rc.x + hdr.w > rc.map_w || (uint32_t)rc.y + hdr.h > rc.map_h) {
+            why = "bad rect";
+        } else {
+            const size_t cap = r565_work_size(&hdr);
+            tmp = (uint8_t *)ui_alloc(cap);
+            if (!tmp || !r565_decode(&hdr, body, body_len, tmp, cap, LV_COLOR_16_SWAP != 0)) {
+                why = "decode failed";
+            }
+        }
     }
-    
-    if (!s_img_q) {
-        /* IMG队列：深度2，适合低频大数据 */
-        s_img_q = xQueueCreate(2, sizeof(ui_event_t));
+
+    release_item(it);
+
+    if (why) {
+        if (tmp) {
+            ui_free(tmp);
+        }
+        Serial0.printf("[UI_BRIDGE] map rect dropped (%s)\n", why);
+        return;
     }
+
+    out->kind = MAP_OUT_RECT;
+    out->buf = tmp;
+    out->w = hdr.w;
+    out->h = hdr.h;
+    out->rect = rc;
 }
 
-void ui_request_msg(const uint8_t *d, size_t len, uint32_t seq)
+static void patch_map_rect(const map_out_t *o)
 {
-    (void)seq;
-    if (!d || len < 22 || !s_msg_q) return;
+    const r565_rect_t *rc = &o->rect;
+    // 基准位图已被替换（例如之前的整帧丢失），修补无意义
+    if (!s_map_img_buf || s_map_dsc.header.cf != LV_IMG_CF_TRUE_COLOR ||
+        rc->map_w != s_map_dsc.header.w || rc->map_h != s_map_dsc.header.h) {
+        Serial0.println("[UI_BRIDGE] map rect dropped (base mismatch)");
+        return;
+    }
 
-    ui_event_t ev;
-    ev.type = UI_EV_SNAPSHOT;
+    const size_t row = (size_t)o->w * sizeof(lv_color_t);
+    const size_t pitch = (size_t)rc->map_w * sizeof(lv_color_t);
+    uint8_t *dst = s_map_img_buf + (size_t)rc->y * pitch + (size_t)rc->x * sizeof(lv_color_t);
+    map_lock();
+    for (lv_coord_t y = 0; y < o->h; y++) {
+        memcpy(dst + y * pitch, o->buf + y * row, row);
+    }
+    s_map_gen++;
+    map_unlock();
+
+    lv_area_t a;
+    lv_obj_get_coords(ui_Map_Bg, &a);
+    a.x1 += rc->x;
+    a.y1 += rc->y;
+    a.x2 = a.x1 + o->w - 1;
+    a.y2 = a.y1 + o->h - 1;
+    lv_obj_invalidate_area(ui_Map_Bg, &a);
+}
+
+/* ---------- 矢量轨迹（IMGF type=4）----------
+   载荷只有几百字节：先拷出来让接收槽尽快归还，画线放在 LVGL 线程（轨迹层位图由它读取）。 */
+
+static void decode_track(const png_item_t *it, map_out_t *out)
+{
+    uint8_t *copy = (uint8_t *)malloc(it->len);
+    if (copy) {
+        memcpy(copy, it->png, it->len);
+    }
+    const size_t len = it->len;
+    release_item(it);
 
-    ev.snap.speed        = (int16_t)(d[0]  | (d[1]  << 8));
-    ev.snap.rpm          = (int16_t)(d[2]  | (d[3]  << 8));
-    ev.snap.odo          = (int32_t)(d[4]  | (d[5]<<8) | (d[6]<<16) | (d[7]<<24));
-    ev.snap.trip_odo     = (int32_t)(d[8]  | (d[9]<<8) | (d[10]<<16)| (d[11]<<24));
-    ev.snap.out_temp     = (int16_t)(d[12] | (d[13]<<8));
-    ev.snap.in_temp      = (int16_t)(d[14] | (d[15]<<8));
-    ev.snap.batt_mv      = (int16_t)(d[16] | (d[17]<<8));
-    ev.snap.cur_time_min = (uint16_t)(d[18] | (d[19]<<8));
-    ev.snap.trip_time_min= (uint16_t)(d[20] | (d[21]<<8));
-    ev.snap.fuel_left_dl = 0;
-    ev.snap.fuel_total_dl= 0;
-    if (len >= 26) {
-        ev.snap.fuel_left_dl = (uint16_t)(d[22] | (d[23] << 8));
-        ev.snap.fuel_total_dl= (uint16_t)(d[24] | (d[25] << 8));
+    if (!copy) {
+        Serial0.println("[UI_BRIDGE] track frame dropped (no memory)");
+        return;
     }
+    out->kind = MAP_OUT_TRACK;
+    out->buf = copy;
+    out->bytes = len;
+}
 
-    // 仪表语义：只关心最新状态，覆盖旧快照
-    xQueueOverwrite(s_msg_q, &ev);
+/* ---------- 瓦片地图（IMGF type=5/6，见 tile_cache.h）----------
+   TILE_MAP 从缓存取瓦片拼成整张位图并报告缺失的瓦片；之后到达的 TILE 写进缓存，
+   落在当前布局里的再当作局部矩形补到地图上。只在解码侧（同一时刻一个线程）执行。 */
+
+#define TILE_MISS_BATCH 64  // 每个 'TMIS' 帧最多带的 key 数
+
+static uint8_t *s_tile_layout = nullptr;  // 当前布局副本，TILE 据此找落点
+static uint8_t *s_tile_raw = nullptr;     // 从缓存读出的瓦片载荷
+static uint8_t *s_tile_px = nullptr;      // 瓦片解码缓冲
+static size_t s_tile_px_cap = 0;
+static void (*s_tile_miss_fn)(const void *keys, size_t len, void *user) = nullptr;
+static void *s_tile_miss_user = nullptr;
+
+static bool tile_layout_parse(const uint8_t *p, size_t len, tile_map_hdr_t *hdr)
+{
+    if (len < sizeof(*hdr)) return false;
+    memcpy(hdr, p, sizeof(*hdr));
+    return hdr->magic == TILE_MAP_MAGIC && hdr->map_w > 0 && hdr->map_h > 0 &&
+           len == sizeof(*hdr) + (size_t)hdr->count * sizeof(tile_ref_t);
 }
 
-void ui_request_set_png(const uint8_t *png,
-                       size_t len,
-                       int imgf_token,
-                       void (*release_cb)(int token))
+static void tile_layout_forget(void)
 {
-    if (!s_img_q || !png || len == 0) return;
+    free(s_tile_layout);
+    s_tile_layout = nullptr;
+}
 
-    ui_event_t ev;
-    ev.type = UI_EV_PNG_ITEM;
-    ev.png_item.png = png;
-    ev.png_item.len = len;
-    ev.png_item.token = imgf_token;
-    ev.png_item.release_cb = release_cb;
-    
-    // IMG队列使用发送语义：避免数据丢失
-    if (xQueueSend(s_img_q, &ev, 0) != pdTRUE) {
-        // 队列满时丢弃最旧帧并释放其token，优先保留最新帧
-        ui_event_t dropped;
-        if (xQueueReceive(s_img_q, &dropped, 0) == pdTRUE &&
-            dropped.type == UI_EV_PNG_ITEM &&
-            dropped.png_item.release_cb) {
-            dropped.png_item.release_cb(dropped.png_item.token);
-        }
+// 解码一个瓦片载荷到 s_tile_px（紧密排列的 w*h 像素）
+static bool tile_decode(const uint8_t *body, size_t len, r565_hdr_t *hdr)
+{
+    if (!r565_parse(body, len, hdr)) return false;
+    const size_t cap = r565_work_size(hdr);
+    if (cap > s_tile_px_cap) {
+        ui_free(s_tile_px);
+        s_tile_px = (uint8_t *)ui_alloc(cap);
+        s_tile_px_cap = s_tile_px ? cap : 0;
+        if (!s_tile_px) return false;
+    }
+    return r565_decode(hdr, body, len, s_tile_px, s_tile_px_cap, LV_COLOR_16_SWAP != 0);
+}
 
-        if (xQueueSend(s_img_q, &ev, 0) != pdTRUE) {
-            if (release_cb) {
-                release_cb(imgf_token);
-            }
-            Serial0.println("[UI_BRIDGE] IMG queue full, dropped newest PNG update");
-        } else {
-            Serial0.println("[UI_BRIDGE] IMG queue full, replaced oldest PNG update");
-        }
+// 瓦片放在 (dx,dy) 时落在地图内的部分：地图坐标 x,y 起 w*h，对应瓦片内 sx,sy 起
+typedef struct {
+    int x, y, w, h;
+    int sx, sy;
+} tile_clip_t;
+
+static bool tile_clip(const tile_ref_t *ref, const r565_hdr_t *th, const tile_map_hdr_t *mh, tile_clip_t *c)
+{
+    const int x1 = ref->dx < 0 ? 0 : ref->dx;
+    const int y1 = ref->dy < 0 ? 0 : ref->dy;
+    const int x2 = ref->dx + th->w < mh->map_w ? ref->dx + th->w : mh->map_w;
+    const int y2 = ref->dy + th->h < mh->map_h ? ref->dy + th->h : mh->map_h;
+    if (x1 >= x2 || y1 >= y2) return false;
+    c->x = x1;
+    c->y = y1;
+    c->w = x2 - x1;
+    c->h = y2 - y1;
+    c->sx = x1 - ref->dx;
+    c->sy = y1 - ref->dy;
+    return true;
+}
+
+// 把 s_tile_px 里已解码的瓦片裁剪拷到 dst（pitch 字节每行）
+static void tile_blit(const r565_hdr_t *th, const tile_clip_t *c, uint8_t *dst, size_t pitch)
+{
+    const size_t src_pitch = (size_t)th->w * sizeof(lv_color_t);
+    const size_t row = (size_t)c->w * sizeof(lv_color_t);
+    const uint8_t *src = s_tile_px + (size_t)c->sy * src_pitch + (size_t)c->sx * sizeof(lv_color_t);
+    for (int y = 0; y < c->h; y++) {
+        memcpy(dst + y * pitch, src + y * src_pitch, row);
     }
-    else {
-        Serial0.println("[UI_BRIDGE] PNG queued successfully");
+}
+
+static void tile_report_miss(const tile_key_wire_t *keys, size_t n)
+{
+    if (n > 0 && s_tile_miss_fn) {
+        s_tile_miss_fn(keys, n * sizeof(*keys), s_tile_miss_user);
     }
-    // 注意：release_cb在LVGL线程里解码完成后立即调用
 }
 
-void ui_bridge_apply_pending(void)
+static void decode_tile_map(const png_item_t *it, map_out_t *out)
 {
-    if (!s_msg_q && !s_img_q) return;
+    tile_map_hdr_t hdr;
+    uint8_t *copy = nullptr;
+    if (tile_layout_parse(it->png, it->len, &hdr)) {
+        copy = (uint8_t *)malloc(it->len);
+        if (copy) {
+            memcpy(copy, it->png, it->len);
+        }
+    }
+    const size_t len = it->len;
+    release_item(it);
 
-    ui_event_t ev;
+    if (!copy) {
+        Serial0.println("[UI_BRIDGE] tile map dropped (bad layout / no memory)");
+        return;
+    }
+    if (!s_tile_raw) {
+        s_tile_raw = (uint8_t *)ui_alloc(TILE_CACHE_MAX_BYTES);
+    }
+    const size_t bytes = (size_t)hdr.map_w * hdr.map_h * sizeof(lv_color_t);
+    uint8_t *buf = map_buf_acquire(bytes, map_buf_wait());
+    if (!buf || !s_tile_raw) {
+        map_buf_release(buf);
+        free(copy);
+        Serial0.println("[UI_BRIDGE] tile map dropped (no memory)");
+        return;
+    }
+    tile_layout_forget();
+    s_tile_layout = copy;
 
-    // 优先处理MSG数据（高频小数据）
-    if (s_msg_q) {
-        while (xQueueReceive(s_msg_q, &ev, 0) == pdTRUE) {
-            if (ev.type == UI_EV_SNAPSHOT) {
-                apply_snapshot_lvgl(&ev.snap);
+    // 底色：主机给的是常规字节序，按 LV_COLOR_16_SWAP 调整后铺满
+    const uint16_t bg = LV_COLOR_16_SWAP ? (uint16_t)((hdr.bg >> 8) | (hdr.bg << 8)) : hdr.bg;
+    uint16_t *px = (uint16_t *)buf;
+    for (size_t i = 0; i < (size_t)hdr.map_w * hdr.map_h; i++) {
+        px[i] = bg;
+    }
+
+    tile_key_wire_t miss[TILE_MISS_BATCH];
+    size_t miss_n = 0;
+    uint16_t hit = 0;
+    const size_t pitch = (size_t)hdr.map_w * sizeof(lv_color_t);
+    for (uint16_t i = 0; i < hdr.count; i++) {
+        tile_ref_t ref;
+        memcpy(&ref, copy + sizeof(hdr) + (size_t)i * sizeof(ref), sizeof(ref));
+        size_t n = 0;
+        r565_hdr_t th;
+        tile_clip_t c;
+        if (tile_cache_get(tile_key(&ref.key), s_tile_raw, TILE_CACHE_MAX_BYTES, &n) &&
+            tile_decode(s_tile_raw, n, &th)) {
+            if (tile_clip(&ref, &th, &hdr, &c)) {
+                tile_blit(&th, &c, buf + c.y * pitch + c.x * sizeof(lv_color_t), pitch);
             }
+            hit++;
+            continue;
+        }
+        miss[miss_n++] = ref.key;
+        if (miss_n == TILE_MISS_BATCH) {
+            tile_report_miss(miss, miss_n);
+            miss_n = 0;
         }
     }
+    tile_report_miss(miss, miss_n);
+    Serial0.printf("[UI_BRIDGE] tile map %ux%u: %u/%u tiles cached\n",
+                   (unsigned)hdr.map_w, (unsigned)hdr.map_h, (unsigned)hit, (unsigned)hdr.count);
 
-    // 然后处理IMG数据（低频大数据）
-    if (s_img_q) {
-        // 只处理最新一张，避免解码过期帧导致延迟累积
-        bool has_latest = false;
-        png_item_t latest = {};
+    tile_cache_save_layout(copy, len);
 
-        while (xQueueReceive(s_img_q, &ev, 0) == pdTRUE) {
+    out->kind = MAP_OUT_SWAP;
+    out->buf = buf;
+    out->bytes = bytes;
+    out->w = hdr.map_w;
+    out->h = hdr.map_h;
+    out->cf = LV_IMG_CF_TRUE_COLOR;
+}
+
+/* ---------- 瓦片视口（IMGF type=7，见 tile_view.h）----------
+   解码侧记着每个槽已经投递过的瓦片（LVGL 线程按序收到，两边一致），新视口只为换了瓦片的槽
+   从缓存加载；缓存里没有的报给主机，对应 TILE 到达时再装进槽。新瓦片与新视口在同一次提交里生效，
+   移动中不会露出装错的瓦片。 */
+
+#define VIEW_MAX_SLOTS 64
+#define VIEW_TILE_BYTES ((size_t)TILE_VIEW_PX * TILE_VIEW_PX * sizeof(lv_color_t))
+
+typedef struct {
+    bool set_view;              // 提交时平移到 view
+    tile_view_hdr_t view;
+    uint16_t n;                 // 随附的瓦片数，像素紧跟在结构体后
+    uint16_t slot[VIEW_MAX_SLOTS];
+    uint64_t key[VIEW_MAX_SLOTS];
+} view_batch_t;
+
+static uint64_t s_view_key[VIEW_MAX_SLOTS];   // 各槽已投递的瓦片
+static uint64_t s_view_want[VIEW_MAX_SLOTS];  // 各槽已向主机要、还没到的瓦片
+static bool s_view_keys_init = false;
+static bool s_view_on = false;                // 当前地图是视口（否则 TILE 补到瓦片布局）
+static tile_view_hdr_t s_view_hdr;
+
+// 缓存 / 载荷里的瓦片解码到 s_tile_px；视口只接受 TILE_VIEW_PX 见方的瓦片
+static bool view_decode(const uint8_t *body, size_t len)
+{
+    r565_hdr_t th;
+    return tile_decode(body, len, &th) && th.w == TILE_VIEW_PX && th.h == TILE_VIEW_PX;
+}
+
+static view_batch_t *view_batch_alloc(uint16_t want, uint16_t *got)
+{
+    // 首帧或跳转时整个网格都要换：内存紧就先装一部分，其余留到下一个视口
+    for (uint16_t n = want;; n /= 2) {
+        view_batch_t *b = (view_batch_t *)ui_alloc(sizeof(view_batch_t) + (size_t)n * VIEW_TILE_BYTES);
+        if (b || n == 0) {
+            *got = b ? n : 0;
+            return b;
+        }
+    }
+}
+
+static void view_batch_add(view_batch_t *b, uint16_t slot, uint64_t key)
+{
+    memcpy((uint8_t *)(b + 1) + (size_t)b->n * VIEW_TILE_BYTES, s_tile_px, VIEW_TILE_BYTES);
+    b->slot[b->n] = slot;
+    b->key[b->n] = key;
+    b->n++;
+    s_view_key[slot] = key;
+}
+
+static void decode_tile_view(const png_item_t *it, map_out_t *out)
+{
+    tile_view_hdr_t v;
+    const uint8_t g = tile_view_grid();
+    const bool ok = it->len == sizeof(v) && g > 0 && (size_t)g * g <= VIEW_MAX_SLOTS;
+    if (ok) {
+        memcpy(&v, it->png, sizeof(v));
+    }
+    release_item(it);
+    if (!ok || v.magic != TILE_VIEW_MAGIC) {
+        Serial0.println("[UI_BRIDGE] tile view dropped (bad payload / no view)");
+        return;
+    }
+    if (!s_view_keys_init) {
+        for (int i = 0; i < VIEW_MAX_SLOTS; i++) {
+            s_view_key[i] = UINT64_MAX;
+            s_view_want[i] = UINT64_MAX;
+        }
+        s_view_keys_init = true;
+    }
+    if (!s_tile_raw) {
+        s_tile_raw = (uint8_t *)ui_alloc(TILE_CACHE_MAX_BYTES);
+    }
+    tile_layout_forget();
+    s_view_on = true;
+    s_view_hdr = v;
+
+    // 视口网格里换了瓦片的槽
+    uint16_t slots[VIEW_MAX_SLOTS];
+    uint64_t keys[VIEW_MAX_SLOTS];
+    uint16_t n = 0;
+    const uint32_t c0 = v.px / TILE_VIEW_PX;
+    const uint32_t r0 = v.py / TILE_VIEW_PX;
+    for (uint32_t r = r0; r < r0 + g; r++) {
+        for (uint32_t c = c0; c < c0 + g; c++) {
+            tile_key_wire_t kw = {};
+            kw.z = v.z;
+            kw.x = c;
+            kw.y = r;
+            const uint16_t slot = tile_view_slot(c, r, g);
+            if (s_view_key[slot] != tile_key(&kw)) {
+                slots[n] = slot;
+                keys[n] = tile_key(&kw);
+                n++;
+            }
+        }
+    }
+
+    uint16_t cap = 0;
+    view_batch_t *b = view_batch_alloc(n, &cap);
+    if (!b) {
+        Serial0.println("[UI_BRIDGE] tile view dropped (no memory)");
+        return;
+    }
+    b->set_view = true;
+    b->view = v;
+    b->n = 0;
+
+    tile_key_wire_t miss[TILE_MISS_BATCH];
+    size_t miss_n = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        size_t len = 0;
+        if (b->n < cap && s_tile_raw &&
+            tile_cache_get(keys[i], s_tile_raw, TILE_CACHE_MAX_BYTES, &len) && view_decode(s_tile_raw, len)) {
+            view_batch_add(b, slots[i], keys[i]);
+            continue;
+        }
+        if (b->n >= cap || s_view_want[slots[i]] == keys[i]) {
+            continue;   // 内存不够留到下次；已经要过的不重复要
+        }
+        s_view_want[slots[i]] = keys[i];
+        miss[miss_n].z = v.z;
+        memset(miss[miss_n].rsv, 0, sizeof(miss[miss_n].rsv));
+        miss[miss_n].x = (uint32_t)((keys[i] >> 28) & 0x0FFFFFFFu);
+        miss[miss_n].y = (uint32_t)(keys[i] & 0x0FFFFFFFu);
+        if (++miss_n == TILE_MISS_BATCH) {
+            tile_report_miss(miss, miss_n);
+            miss_n = 0;
+        }
+    }
+    tile_report_miss(miss, miss_n);
+
+    out->kind = MAP_OUT_VIEW;
+    out->buf = (uint8_t *)b;
+}
+
+// TILE 到达时：落在当前视口网格里就装进槽，返回 true
+static bool view_take_tile(const tile_key_wire_t *kw, uint64_t k, const uint8_t *body, size_t len, map_out_t *out)
+{
+    const uint8_t g = tile_view_grid();
+    const uint32_t c0 = s_view_hdr.px / TILE_VIEW_PX;
+    const uint32_t r0 = s_view_hdr.py / TILE_VIEW_PX;
+    if (!s_view_on || kw->z != s_view_hdr.z ||
+        kw->x < c0 || kw->x >= c0 + g || kw->y < r0 || kw->y >= r0 + g) {
+        return false;
+    }
+    const uint16_t slot = tile_view_slot(kw->x, kw->y, g);
+    if (s_view_key[slot] == k || !view_decode(body, len)) {
+        return true;
+    }
+    uint16_t cap = 0;
+    view_batch_t *b = view_batch_alloc(1, &cap);
+    if (!b || cap == 0) {
+        ui_free(b);
+        return true;
+    }
+    b->set_view = false;
+    b->n = 0;
+    view_batch_add(b, slot, k);
+    s_view_want[slot] = UINT64_MAX;
+    out->kind = MAP_OUT_VIEW;
+    out->buf = (uint8_t *)b;
+    return true;
+}
+
+static void commit_view(const view_batch_t *b)
+{
+    for (uint16_t i = 0; i < b->n; i++) {
+        tile_view_put(b->slot[i], b->key[i], (const uint8_t *)(b + 1) + (size_t)i * VIEW_TILE_BYTES);
+    }
+    if (b->set_view) {
+        tile_view_set(&b->view);
+    }
+}
+
+static void decode_tile(const png_item_t *it, map_out_t *out)
+{
+    tile_key_wire_t key;
+    r565_hdr_t th;
+    const uint8_t *body = it->png + sizeof(key);
+    const size_t body_len = it->len > sizeof(key) ? it->len - sizeof(key) : 0;
+    if (body_len == 0 || !r565_parse(body, body_len, &th)) {
+        release_item(it);
+        Serial0.println("[UI_BRIDGE] tile dropped (bad payload)");
+        return;
+    }
+    memcpy(&key, it->png, sizeof(key));
+    const uint64_t k = tile_key(&key);
+    (void)tile_cache_put(k, body, body_len);  // 写不进缓存也照样显示
+
+    if (view_take_tile(&key, k, body, body_len, out)) {
+        release_item(it);
+        return;
+    }
+
+    // 当前布局引用它时补到地图上
+    tile_map_hdr_t hdr;
+    tile_ref_t ref;
+    bool placed = false;
+    if (s_tile_layout) {
+        memcpy(&hdr, s_tile_layout, sizeof(hdr));
+        for (uint16_t i = 0; i < hdr.count && !placed; i++) {
+            memcpy(&ref, s_tile_layout + sizeof(hdr) + (size_t)i * sizeof(ref), sizeof(ref));
+            placed = tile_key(&ref.key) == k;
+        }
+    }
+    tile_clip_t c;
+    const bool ok = placed && tile_decode(body, body_len, &th) && tile_clip(&ref, &th, &hdr, &c);
+    release_item(it);
+    if (!ok) return;
+
+    uint8_t *tmp = (uint8_t *)ui_alloc((size_t)c.w * c.h * sizeof(lv_color_t));
+    if (!tmp) return;
+    tile_blit(&th, &c, tmp, (size_t)c.w * sizeof(lv_color_t));
+
+    out->kind = MAP_OUT_RECT;
+    out->buf = tmp;
+    out->w = (lv_coord_t)c.w;
+    out->h = (lv_coord_t)c.h;
+    out->rect.x = (uint16_t)c.x;
+    out->rect.y = (uint16_t)c.y;
+    out->rect.map_w = hdr.map_w;
+    out->rect.map_h = hdr.map_h;
+}
+
+/* ---------- 流式PNG（分片边收边解码；解码线程里整帧PNG也走这里）----------
+   每个分片到达即送入流式解码器，逐行转换成 LVGL 位图；最后一行完成后才切换显示，
+   中途丢片或解码失败则保留旧地图。解码线程里用两核流水 png_pipe（frag_row 在 png_rows 线程上跑），
+   LVGL 线程解码或流水建不起来时用单线程 png_stream。 */
+
+typedef struct {
+    png_stream_t *dec;
+    png_pipe_t *pipe;
+    bool active;        // 正在组装一张图
+    uint16_t next;      // 期望的下一个分片序号
+    uint8_t *buf;
+    size_t bytes;
+    lv_coord_t w;
+    lv_coord_t h;
+    lv_img_cf_t cf;
+} frag_ctx_t;
+
+static frag_ctx_t s_frag;
+
+static bool frag_begin(void *user, const png_stream_info_t *info)
+{
+    frag_ctx_t *f = (frag_ctx_t *)user;
+    f->w = (lv_coord_t)info->w;
+    f->h = (lv_coord_t)info->h;
+    f->cf = info->has_alpha ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+    f->bytes = (size_t)lv_img_buf_get_img_size(f->w, f->h, f->cf);
+    f->buf = map_buf_acquire(f->bytes, map_buf_wait());
+    return f->buf != nullptr;
+}
+
+static void frag_row(void *user, uint32_t y, const uint8_t *rgba)
+{
+    frag_ctx_t *f = (frag_ctx_t *)user;
+    const bool alpha = (f->cf == LV_IMG_CF_TRUE_COLOR_ALPHA);
+    const size_t px = alpha ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    uint8_t *dst = f->buf + (size_t)y * f->w * px;
+
+    for (lv_coord_t x = 0; x < f->w; x++, rgba += 4, dst += px) {
+        lv_color_t c = lv_color_make(rgba[0], rgba[1], rgba[2]);
+        memcpy(dst, &c, sizeof(c));
+        if (alpha) {
+            dst[sizeof(c)] = rgba[3];
+        }
+    }
+}
+
+static void frag_dec_reset(void)
+{
+    if (s_frag.pipe) {
+        png_pipe_reset(s_frag.pipe);
+    } else if (s_frag.dec) {
+        png_stream_reset(s_frag.dec);
+    }
+}
+
+static void frag_abort(void)
+{
+    frag_dec_reset();   // 先等流水里的行做完，再还位图
+    if (s_frag.buf) {
+        map_buf_release(s_frag.buf);
+        s_frag.buf = nullptr;
+    }
+    s_frag.active = false;
+}
+
+/* 送入一段 PNG 数据；返回 png_stream_feed 的结果，未在组装时返回 PNG_STREAM_ERR */
+static int frag_feed(const uint8_t *data, size_t len, uint16_t frag, uint8_t flags, bool *in_order)
+{
+    if (!s_frag.dec && !s_frag.pipe) {
+        if (UI_PNG_PIPE && s_decode_task && xTaskGetCurrentTaskHandle() == s_decode_task) {
+            s_frag.pipe = png_pipe_create(frag_begin, frag_row, &s_frag);
+        }
+        if (!s_frag.pipe) {
+            s_frag.dec = png_stream_create(frag_begin, frag_row, &s_frag);
+        }
+    }
+
+    if (flags & IMGF_FLAG_FIRST) {
+        frag_abort();
+        if (s_frag.dec || s_frag.pipe) {
+            s_frag.active = true;
+            s_frag.next = 0;
+        }
+    }
+
+    int r = PNG_STREAM_ERR;
+    *in_order = s_frag.active && frag == s_frag.next;
+    if (*in_order) {
+        r = s_frag.pipe ? png_pipe_feed(s_frag.pipe, data, len) : png_stream_feed(s_frag.dec, data, len);
+        s_frag.next++;
+    }
+    return r;
+}
+
+static void frag_take(map_out_t *out)
+{
+    out->kind = MAP_OUT_SWAP;
+    out->buf = s_frag.buf;
+    out->bytes = s_frag.bytes;
+    out->w = s_frag.w;
+    out->h = s_frag.h;
+    out->cf = s_frag.cf;
+    s_frag.buf = nullptr;   // 所有权交给调用方
+    s_frag.active = false;
+}
+
+static void decode_png_frag(const png_item_t *it, map_out_t *out)
+{
+    bool in_order = false;
+    const int r = frag_feed(it->png, it->len, it->frag, it->flags, &in_order);
+
+    // 分片数据已被解码器消费，立即归还接收缓冲
+    release_item(it);
+
+    if (!s_frag.active) {
+        return;     // 不属于任何正在组装的图（首片丢失或已完成），丢弃
+    }
+
+    if (r == PNG_STREAM_ERR || (r == PNG_STREAM_MORE && (it->flags & IMGF_FLAG_LAST))) {
+        Serial0.printf("[UI_BRIDGE] PNG fragment %u %s, keep previous map\n",
+                       (unsigned)it->frag, in_order ? "decode failed" : "out of order");
+        frag_abort();
+        return;
+    }
+
+    if (r == PNG_STREAM_DONE) {
+        frag_take(out);
+    }
+}
+
+/* 整帧PNG交给流式解码器（线程安全）；不支持的格式（如隔行）退回 LVGL 线程 */
+static void decode_png_whole(const png_item_t *it, map_out_t *out)
+{
+    bool in_order = false;
+    const int r = frag_feed(it->png, it->len, 0, IMGF_FLAG_FIRST | IMGF_FLAG_LAST, &in_order);
+    if (r == PNG_STREAM_DONE) {
+        release_item(it);
+        frag_take(out);
+        return;
+    }
+    frag_abort();
+    out->kind = MAP_OUT_LVGL_PNG;
+    out->item = *it;
+}
+
+/* 解码一个 IMG 事件（不调用 lv_obj 接口），off_thread 表示在解码线程里 */
+static void decode_img_event(const ui_event_t *ev, bool off_thread, map_out_t *out)
+{
+    const uint32_t t0 = hud_perf_now_us();
+    memset(out, 0, sizeof(*out));
+    if (ev->type == UI_EV_PNG_ITEM || ev->type == UI_EV_PNG_FRAG) {
+        tile_layout_forget();   // 整帧地图取代瓦片布局，之后的 TILE 只进缓存
+    }
+    if (ev->type == UI_EV_PNG_ITEM || ev->type == UI_EV_PNG_FRAG || ev->type == UI_EV_TILE_MAP) {
+        s_view_on = false;      // 同样取代瓦片视口
+    }
+    if (ev->type == UI_EV_PNG_FRAG) {
+        decode_png_frag(&ev->png_item, out);
+    } else if (ev->type == UI_EV_MAP_RECT) {
+        decode_map_rect(&ev->png_item, out);
+    } else if (ev->type == UI_EV_TRACK) {
+        decode_track(&ev->png_item, out);
+    } else if (ev->type == UI_EV_TILE) {
+        decode_tile(&ev->png_item, out);
+    } else if (ev->type == UI_EV_TILE_MAP) {
+        decode_tile_map(&ev->png_item, out);
+    } else if (ev->type == UI_EV_TILE_VIEW) {
+        decode_tile_view(&ev->png_item, out);
+    } else if (ev->png_item.type == IMGF_TYPE_R565) {
+        decode_r565(&ev->png_item, out);
+    } else if (off_thread) {
+        decode_png_whole(&ev->png_item, out);
+    } else {
+        out->kind = MAP_OUT_LVGL_PNG;
+        out->item = ev->png_item;
+    }
+    if (out->kind != MAP_OUT_LVGL_PNG) {
+        HUD_PERF_RECORD(HUD_PERF_IMG_DECODE, hud_perf_now_us() - t0);
+    }
+}
+
+/* 只在 LVGL 线程调用 */
+static void commit_map_out(map_out_t *o)
+{
+    switch (o->kind) {
+    case MAP_OUT_SWAP:
+        tile_view_hide();
+        set_map_bitmap(o->buf, o->bytes, o->w, o->h, o->cf);
+        break;
+    case MAP_OUT_RECT:
+        patch_map_rect(o);
+        ui_free(o->buf);
+        break;
+    case MAP_OUT_LVGL_PNG:
+        tile_view_hide();
+        apply_png_lvgl(&o->item);
+        break;
+    case MAP_OUT_TRACK:
+        (void)track_layer_apply(o->buf, o->bytes);
+        free(o->buf);
+        break;
+    case MAP_OUT_VIEW:
+        commit_view((const view_batch_t *)o->buf);
+        s_map_view = true;
+        ui_free(o->buf);
+        break;
+    default:
+        break;
+    }
+    o->kind = MAP_OUT_NONE;
+}
+
+/* ---------- 解码线程 ----------
+   从 s_img_q 取图解码到新位图，只把“切换到这张”的结果投递给 LVGL 线程，
+   仪表刷新节奏不再受地图大小影响。 */
+
+static QueueHandle_t s_ready_q = nullptr;   // 解码完成、待 LVGL 线程生效的结果
+static volatile bool s_decode_on = false;   // 先于任务创建置位，避免两个线程同时消费 s_img_q
+static volatile bool s_map_paused = false;  // 省电：不解码、不切换地图，新图在 s_img_q 里只留最新
+
+static void decode_task_fn(void *arg)
+{
+    (void)arg;
+    ui_event_t ev;
+    for (;;) {
+        if (s_map_paused) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);   // ui_bridge_set_map_paused(false) 唤醒
+            continue;
+        }
+        if (xQueueReceive(s_img_q, &ev, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        // 连续的整帧只解最新一张
+        ui_event_t next;
+        while (ev.type == UI_EV_PNG_ITEM &&
+               xQueuePeek(s_img_q, &next, 0) == pdTRUE && next.type == UI_EV_PNG_ITEM) {
+            xQueueReceive(s_img_q, &next, 0);
+            release_item(&ev.png_item);
+            s_img_replaced++;
+            ev = next;
+        }
+
+        map_out_t out;
+        decode_img_event(&ev, true, &out);
+        if (out.kind != MAP_OUT_NONE) {
+            // 结果必须按序生效（矩形依赖之前的整帧），满了就等 LVGL 线程
+            xQueueSend(s_ready_q, &out, portMAX_DELAY);
+            notify_ui();
+        }
+    }
+}
+
+/* ---------- API ---------- */
+
+void ui_bridge_init(void)
+{
+    if (!s_msg_q) {
+        /* MSG队列：只保留最新快照，降低UI线程负担 */
+        s_msg_q = xQueueCreate(1, sizeof(ui_event_t));
+    }
+    
+    if (!s_img_q) {
+        /* IMG队列：深度4，整帧低频；分片时可缓冲几片与解码重叠 */
+        s_img_q = xQueueCreate(IMG_Q_DEPTH, sizeof(ui_event_t));
+    }
+
+    map_pool_init();
+    /* 整图帧（type=0）也可以是 QOI 文件：decode_png_to_lv_img_data 经 lv_img_decoder_open 自动选到它 */
+    img_qoi_lv_register();
+    if (!s_map_save_lock) {
+        s_map_save_lock = xSemaphoreCreateMutex();
+    }
+    if (!s_map_lock) {
+        s_map_lock = xSemaphoreCreateMutex();
+    }
+
+    /* 快照会改动的控件，静态层不能把它们烘进底图 */
+    lv_obj_t *const dynamic[] = {
+        ui_Speed_Number_1, ui_Speed_Number_2, ui_ImgSpeedfg,
+        ui_Label_Time3, ui_Label_Time_Trip, ui_Label_Gas_Number,
+        ui_Label_ODO_Number1, ui_Label_Trip_Odo, ui_Label_Temp2,
+        ui_Label_Battery_Number1, ui_Map_Bg,
+    };
+    for (size_t i = 0; i < sizeof(dynamic) / sizeof(dynamic[0]); i++) {
+        ui_static_layer_mark_dynamic(dynamic[i]);
+    }
+
+    /* 矢量轨迹画在地图之上的独立图层，地图底图不动 */
+    if (track_layer_init(ui_Map_Bg)) {
+        ui_static_layer_mark_dynamic(track_layer_obj());
+    }
+    /* 瓦片视口插在地图与轨迹层之间（后创建，排在轨迹层下面） */
+    if (tile_view_init(ui_Map_Bg)) {
+        ui_static_layer_mark_dynamic(tile_view_obj());
+    }
+
+#if UI_RPM_BAR_CLIP
+    rpm_bar_init();
+#endif
+#if UI_GAUGE_INTERP
+    gauge_init();
+#endif
+
+#if UI_SPEED_DIGIT_CACHE
+    /* 速度数字换成预解码的位图：阴影在下、前景在上 */
+    lv_obj_t *const speed_labels[] = {ui_Speed_Number_2, ui_Speed_Number_1};
+    if (!speed_digits_init(speed_labels, 2)) {
+        Serial0.printf("[UI_BRIDGE] speed digit cache unavailable, using labels\n");
+    }
+#endif
+}
+
+void ui_bridge_init_late(void)
+{
+#if UI_STATIC_LAYER
+    /* 快照要把整屏离屏渲染一遍，放到首帧之后，不拖慢开机出画面 */
+    ui_static_layer_build(ui_Home);
+#endif
+    /* 没烘进底图、仍实时绘制的图片定下驻留位置（ui_assets.h）；地图位图是动态的，不在此列 */
+    const void *const assets[] = {
+        &ui_img_speed_fg_small_png, &ui_img_speedbg_small_png, &ui_img_gps_bg_png, &ui_img_bg5_png,
+    };
+    ui_assets_pin(ui_Home, assets, sizeof(assets) / sizeof(assets[0]));
+}
+
+/* ---------- MSGF 快照 / 增量快照 ----------
+   线上格式是 26 字节小端结构（见 README）。增量帧以最近一次整包快照为基准：
+   只带与基准不同的字段，设备按掩码覆盖到基准副本上再当作整包快照处理。
+   两者都只在 app_task 里调用，基准无需加锁。 */
+
+#define SNAP_WIRE_BYTES 26
+#define SNAP_FIELDS 11
+
+static_assert(snap_layout::bytes == SNAP_WIRE_BYTES && snap_layout::count == SNAP_FIELDS,
+              "snapshot layout table does not match the wire format");
+
+static uint8_t s_base_wire[SNAP_WIRE_BYTES];
+static volatile int16_t s_speed = 0;        // 最近一帧快照的车速（电源管理判断停车）
+static volatile bool s_speed_valid = false;
+static uint32_t s_base_seq = 0;
+static bool s_base_valid = false;
+
+static void queue_snapshot(const uint8_t *d, uint32_t seq)
+{
+    ui_event_t ev;
+    ev.type = UI_EV_SNAPSHOT;
+
+    snap_layout::decode(ev.snap, d);
+    ev.snap.seq   = seq;
+    ev.snap.rx_ms = millis();
+
+    s_speed = ev.snap.speed;
+    s_speed_valid = true;
+
+    // 重启后先显示它（RTC 内存，每帧写也没有代价）
+    hud_persist_put_snapshot(d);
+
+    // 仪表语义：只关心最新状态，覆盖旧快照
+    xQueueOverwrite(s_msg_q, &ev);
+    notify_ui();
+}
+
+void ui_request_msg(const uint8_t *d, size_t len, uint32_t seq)
+{
+    if (!d || len < 22 || !s_msg_q) return;
+    HUD_PERF_MARK(seq, HUD_PERF_STAGE_REQUEST);
+
+    // 旧上位机不带油量字段（22 字节），按 0 补齐
+    memset(s_base_wire, 0, sizeof(s_base_wire));
+    memcpy(s_base_wire, d, len < SNAP_WIRE_BYTES ? len : SNAP_WIRE_BYTES);
+    s_base_seq = seq;
+    s_base_valid = true;
+
+    queue_snapshot(s_base_wire, seq);
+}
+
+bool ui_request_msg_delta(const uint8_t *d, size_t len, uint32_t seq)
+{
+    if (!d || len < 6 || !s_msg_q) return false;
+
+    const uint32_t base_seq = (uint32_t)(d[0] | (d[1] << 8) | (d[2] << 16) | ((uint32_t)d[3] << 24));
+    const uint16_t mask = (uint16_t)(d[4] | (d[5] << 8));
+    // 基准整包没收到（开机后、或被丢弃）：等上位机下一个整包
+    if (!s_base_valid || base_seq != s_base_seq || (mask >> SNAP_FIELDS)) return false;
+
+    uint8_t wire[SNAP_WIRE_BYTES];
+    memcpy(wire, s_base_wire, sizeof(wire));
+    size_t p = 6;
+    for (int i = 0; i < SNAP_FIELDS; i++) {
+        if (!(mask & (1u << i))) continue;
+        const size_t w = (size_t)(snap_layout::offsets[i + 1] - snap_layout::offsets[i]);
+        if (p + w > len) return false;
+        memcpy(wire + snap_layout::offsets[i], d + p, w);
+        p += w;
+    }
+
+    HUD_PERF_MARK(seq, HUD_PERF_STAGE_REQUEST);
+    queue_snapshot(wire, seq);
+    return true;
+}
+
+static bool queue_ordered(const ui_event_t *ev)
+{
+    if (xQueueSend(s_img_q, ev, 0) != pdTRUE) {
+        return false;
+    }
+    if (!s_decode_on) {
+        notify_ui();
+    }
+    return true;
+}
+
+/* 队列满时挤掉排队中最旧的一张整帧：分片、局部矩形、轨迹追加、瓦片/布局/视口必须按序生效，一个都不能丢，
+   其余事件按原顺序放回。IMG 队列只由分发线程写入（app；基准构建里是 bench），取出到放回之间消费者最多先拿走队头，顺序不变。
+   没有整帧可挤时返回 false。 */
+static bool evict_oldest_whole(void)
+{
+    static ui_event_t held[IMG_Q_DEPTH];   // 只有分发线程调用，静态缓冲不占栈
+    int n = 0;
+    bool evicted = false;
+    ui_event_t e;
+    while (n < IMG_Q_DEPTH && xQueueReceive(s_img_q, &e, 0) == pdTRUE) {
+        if (!evicted && e.type == UI_EV_PNG_ITEM) {
+            release_item(&e.png_item);
+            evicted = true;
+            continue;
+        }
+        held[n++] = e;
+    }
+    for (int i = 0; i < n; i++) {
+        xQueueSend(s_img_q, &held[i], 0);
+    }
+    return evicted;
+}
+
+static void queue_whole_image(const uint8_t *data,
+                              size_t len,
+                              uint8_t type,
+                              int imgf_token,
+                              void (*release_cb)(int token))
+{
+    if (!s_img_q || !data || len == 0) return;
+
+    ui_event_t ev;
+    ev.type = UI_EV_PNG_ITEM;
+    ev.png_item.png = data;
+    ev.png_item.len = len;
+    ev.png_item.token = imgf_token;
+    ev.png_item.release_cb = release_cb;
+    ev.png_item.frag = 0;
+    ev.png_item.flags = 0;
+    ev.png_item.type = type;
+    
+    // IMG队列使用发送语义：避免数据丢失
+    if (xQueueSend(s_img_q, &ev, 0) != pdTRUE) {
+        // 队列满时只挤掉最旧的整帧并释放其token，优先保留最新帧；没有整帧可挤就丢新来的这张
+        const bool evicted = evict_oldest_whole();
+        if (evicted) {
+            s_img_replaced++;
+        }
+
+        if (!evicted || xQueueSend(s_img_q, &ev, 0) != pdTRUE) {
+            if (release_cb) {
+                release_cb(imgf_token);
+            }
+            s_img_replaced++;
+            HUD_TRACE(HUD_TR_IMG_DROPPED, imgf_token, uxQueueMessagesWaiting(s_img_q));
+        } else {
+            HUD_TRACE(HUD_TR_IMG_REPLACED, imgf_token, uxQueueMessagesWaiting(s_img_q));
+        }
+    }
+    else {
+        HUD_TRACE(HUD_TR_IMG_QUEUED, imgf_token, uxQueueMessagesWaiting(s_img_q));
+    }
+    // 注意：release_cb在解码完成后立即调用
+    // 解码线程运行时由它在解码完成后唤醒 LVGL 线程
+    if (!s_decode_on) {
+        notify_ui();
+    }
+}
+
+void ui_request_set_png(const uint8_t *png,
+                       size_t len,
+                       int imgf_token,
+                       void (*release_cb)(int token))
+{
+    queue_whole_image(png, len, IMGF_TYPE_PNG, imgf_token, release_cb);
+}
+
+void ui_request_set_r565(const uint8_t *data,
+                         size_t len,
+                         int imgf_token,
+                         void (*release_cb)(int token))
+{
+    queue_whole_image(data, len, IMGF_TYPE_R565, imgf_token, release_cb);
+}
+
+bool ui_request_png_frag(const uint8_t *data,
+                         size_t len,
+                         uint16_t frag,
+                         uint8_t flags,
+                         int imgf_token,
+                         void (*release_cb)(int token))
+{
+    if (!s_img_q || !data || len == 0) return false;
+
+    ui_event_t ev;
+    ev.type = UI_EV_PNG_FRAG;
+    ev.png_item.png = data;
+    ev.png_item.len = len;
+    ev.png_item.token = imgf_token;
+    ev.png_item.release_cb = release_cb;
+    ev.png_item.frag = frag;
+    ev.png_item.flags = flags;
+    ev.png_item.type = IMGF_TYPE_PNG_FRAG;
+
+    // 分片不能像整帧那样“替换最旧”，队列满时交还调用方稍后重试
+    return queue_ordered(&ev);
+}
+
+bool ui_request_map_rect(const uint8_t *data,
+                         size_t len,
+                         int imgf_token,
+                         void (*release_cb)(int token))
+{
+    if (!s_img_q || !data || len == 0) return false;
+
+    ui_event_t ev;
+    ev.type = UI_EV_MAP_RECT;
+    ev.png_item.png = data;
+    ev.png_item.len = len;
+    ev.png_item.token = imgf_token;
+    ev.png_item.release_cb = release_cb;
+    ev.png_item.frag = 0;
+    ev.png_item.flags = 0;
+    ev.png_item.type = IMGF_TYPE_R565_RECT;
+
+    // 局部更新依赖先后顺序，与分片一样不能替换丢弃
+    return queue_ordered(&ev);
+}
+
+bool ui_request_track(const uint8_t *data,
+                      size_t len,
+                      int imgf_token,
+                      void (*release_cb)(int token))
+{
+    if (!s_img_q || !data || len == 0) return false;
+
+    ui_event_t ev;
+    ev.type = UI_EV_TRACK;
+    ev.png_item.png = data;
+    ev.png_item.len = len;
+    ev.png_item.token = imgf_token;
+    ev.png_item.release_cb = release_cb;
+    ev.png_item.frag = 0;
+    ev.png_item.flags = 0;
+    ev.png_item.type = IMGF_TYPE_TRACK;
+
+    // 追加帧依赖先后顺序
+    return queue_ordered(&ev);
+}
+
+static bool queue_tile_event(ui_ev_type_t ev_type,
+                             uint8_t img_type,
+                             const uint8_t *data,
+                             size_t len,
+                             int imgf_token,
+                             void (*release_cb)(int token))
+{
+    if (!s_img_q || !data || len == 0) return false;
+
+    ui_event_t ev;
+    ev.type = ev_type;
+    ev.png_item.png = data;
+    ev.png_item.len = len;
+    ev.png_item.token = imgf_token;
+    ev.png_item.release_cb = release_cb;
+    ev.png_item.frag = 0;
+    ev.png_item.flags = 0;
+    ev.png_item.type = img_type;
+
+    // 瓦片补在它之前的布局上，按序生效
+    return queue_ordered(&ev);
+}
+
+bool ui_request_tile(const uint8_t *data,
+                     size_t len,
+                     int imgf_token,
+                     void (*release_cb)(int token))
+{
+    return queue_tile_event(UI_EV_TILE, IMGF_TYPE_TILE, data, len, imgf_token, release_cb);
+}
+
+bool ui_request_tile_map(const uint8_t *data,
+                         size_t len,
+                         int imgf_token,
+                         void (*release_cb)(int token))
+{
+    return queue_tile_event(UI_EV_TILE_MAP, IMGF_TYPE_TILE_MAP, data, len, imgf_token, release_cb);
+}
+
+bool ui_request_tile_view(const uint8_t *data,
+                          size_t len,
+                          int imgf_token,
+                          void (*release_cb)(int token))
+{
+    return queue_tile_event(UI_EV_TILE_VIEW, IMGF_TYPE_TILE_VIEW, data, len, imgf_token, release_cb);
+}
+
+void ui_bridge_set_tile_miss(void (*fn)(const void *keys, size_t len, void *user), void *user)
+{
+    s_tile_miss_user = user;
+    s_tile_miss_fn = fn;
+}
+
+/* 启动时读回的地图载荷，解码完由接收路径的释放回调归还 */
+static uint8_t *s_boot_map = nullptr;
+
+static void free_boot_map(int token)
+{
+    (void)token;
+    ui_free(s_boot_map);
+    s_boot_map = nullptr;
+}
+
+bool ui_bridge_restore_map(void)
+{
+    // 断电前屏上的那张图优先：它已经包含之后的修补/补瓦片
+    const size_t n = hud_persist_map_len();
+    if (n && !s_boot_map) {
+        s_boot_map = (uint8_t *)ui_alloc(n);
+        size_t len = 0;
+        if (s_boot_map && hud_persist_load_map(s_boot_map, n, &len)) {
+            Serial0.printf("[UI_BRIDGE] restoring saved map (%u bytes)\n", (unsigned)len);
+            ui_request_set_r565(s_boot_map, len, -1, free_boot_map);
+            return true;
+        }
+        free_boot_map(-1);
+    }
+
+    // 解码侧会拷一份布局，这块缓冲只需活到事件被取走；只在启动时用一次
+    static uint8_t s_boot_layout[TILE_LAYOUT_MAX_BYTES];
+    size_t len = 0;
+    if (!tile_cache_load_layout(s_boot_layout, sizeof(s_boot_layout), &len)) {
+        return false;
+    }
+    Serial0.printf("[UI_BRIDGE] restoring saved tile map (%u bytes)\n", (unsigned)len);
+    return ui_request_tile_map(s_boot_layout, len, -1, nullptr);
+}
+
+bool ui_bridge_restore_snapshot(void)
+{
+    uint8_t wire[SNAP_WIRE_BYTES];
+    if (!hud_persist_get_snapshot(wire)) {
+        return false;
+    }
+    // seq=0：上位机的增量帧对不上这个基准，会等它的下一个整包
+    ui_request_msg(wire, sizeof(wire), 0);
+    return true;
+}
+
+// 持 s_map_save_lock 调用
+static bool save_map_locked(void)
+{
+    const uint32_t gen = s_map_gen;
+    if (gen == s_map_saved_gen) {
+        return false;
+    }
+
+    // 只存屏上看到的整张不透明位图；瓦片视口、带透明通道的图、放不进分区的图都跳过
+    map_lock();
+    const lv_coord_t w = s_map_dsc.header.w;
+    const lv_coord_t h = s_map_dsc.header.h;
+    const size_t px = (s_map_img_buf && !s_map_view && s_map_dsc.header.cf == LV_IMG_CF_TRUE_COLOR)
+                          ? (size_t)w * h * sizeof(lv_color_t) : 0;
+    const size_t len = sizeof(r565_hdr_t) + px;
+    uint8_t *payload = (px && len <= hud_persist_map_cap()) ? (uint8_t *)ui_alloc(len) : nullptr;
+    if (payload) {
+        const r565_hdr_t hdr = {R565_MAGIC, (uint16_t)w, (uint16_t)h, (uint16_t)w, R565_CODEC_RAW,
+                                (uint8_t)(LV_COLOR_16_SWAP ? R565_FLAG_SWAPPED : 0), (uint32_t)px};
+        memcpy(payload, &hdr, sizeof(hdr));
+        hud_dma_copy(payload + sizeof(hdr), s_map_img_buf, px);
+    }
+    map_unlock();
+
+    if (!payload) {
+        if (!px) {
+            s_map_saved_gen = gen;   // 不可保存的内容：等它变了再试
+        }
+        return false;
+    }
+    const bool ok = hud_persist_save_map(payload, len);
+    ui_free(payload);
+    if (ok) {
+        s_map_saved_gen = gen;
+    }
+    Serial0.printf("[UI_BRIDGE] map %ux%u %s\n", (unsigned)w, (unsigned)h, ok ? "saved" : "save failed");
+    return ok;
+}
+
+bool ui_bridge_save_map(void)
+{
+    if (!s_map_lock || !s_map_save_lock) {
+        return false;
+    }
+    // 另一个线程正在擦写时等它写完，再看它存的是不是已经是当前这张
+    xSemaphoreTake(s_map_save_lock, portMAX_DELAY);
+    const bool ok = save_map_locked();
+    xSemaphoreGive(s_map_save_lock);
+    return ok;
+}
+
+bool ui_bridge_last_speed(int16_t *speed)
+{
+    if (!s_speed_valid || !speed) {
+        return false;
+    }
+    *speed = s_speed;
+    return true;
+}
+
+void ui_bridge_set_map_paused(bool paused)
+{
+    if (s_map_paused == paused) {
+        return;
+    }
+    s_map_paused = paused;
+    if (!paused) {
+        if (s_decode_task) {
+            xTaskNotifyGive(s_decode_task);
+        }
+        notify_ui();   // 暂停期间积下的最新一张马上生效
+    }
+}
+
+static bool is_ordered_event(ui_ev_type_t type)
+{
+    return type == UI_EV_MAP_RECT || type == UI_EV_TRACK ||
+           type == UI_EV_TILE || type == UI_EV_TILE_MAP || type == UI_EV_TILE_VIEW;
+}
+
+void ui_bridge_apply_pending(void)
+{
+    if (!s_msg_q && !s_img_q) return;
+
+    ui_event_t ev;
+
+    // 优先处理MSG数据（高频小数据）
+    if (s_msg_q) {
+        while (xQueueReceive(s_msg_q, &ev, 0) == pdTRUE) {
+            if (ev.type == UI_EV_SNAPSHOT) {
+                apply_snapshot_lvgl(&ev.snap);
+            }
+        }
+    }
+
+    if (s_map_paused) {
+        return;
+    }
+
+    // 解码线程已把图解好，这里只做切换/修补
+    if (s_decode_on) {
+        map_out_t out;
+        while (xQueueReceive(s_ready_q, &out, 0) == pdTRUE) {
+            commit_map_out(&out);
+        }
+        return;
+    }
+
+    // 未启动解码线程：在LVGL线程里解码（低频大数据）
+    if (s_img_q) {
+        // 只处理最新一张，避免解码过期帧导致延迟累积
+        bool has_latest = false;
+        ui_event_t latest = {};
+        map_out_t out;
+
+        while (xQueuePeek(s_img_q, &ev, 0) == pdTRUE) {
+            if (ev.type == UI_EV_PNG_FRAG) {
+                // 分片按序逐个解码，每轮最多一个，避免长时间占用LVGL线程
+                if (!has_latest) {
+                    xQueueReceive(s_img_q, &ev, 0);
+                    decode_img_event(&ev, false, &out);
+                    commit_map_out(&out);
+                    if (uxQueueMessagesWaiting(s_img_q) > 0) {
+                        notify_ui();    // 还有分片，下一轮尽快继续
+                    }
+                }
+                break;
+            }
+            if (is_ordered_event(ev.type)) {
+                // 矩形基于当前位图，必须在其之前的整帧生效之后再按序打上；轨迹、瓦片同样按序
+                if (!has_latest) {
+                    while (xQueuePeek(s_img_q, &ev, 0) == pdTRUE && is_ordered_event(ev.type)) {
+                        xQueueReceive(s_img_q, &ev, 0);
+                        decode_img_event(&ev, false, &out);
+                        commit_map_out(&out);
+                    }
+                }
+                break;
+            }
+            xQueueReceive(s_img_q, &ev, 0);
             if (ev.type == UI_EV_PNG_ITEM) {
-                if (has_latest && latest.release_cb) {
-                    latest.release_cb(latest.token);
+                if (has_latest) {
+                    release_item(&latest.png_item);
+                    s_img_replaced++;
                 }
-                latest = ev.png_item;
+                latest = ev;
                 has_latest = true;
             }
         }
 
         if (has_latest) {
-            Serial0.println("[UI_BRIDGE] applying latest image update");
-            apply_png_lvgl(&latest);
-            Serial0.println("[UI_BRIDGE] latest image update applied");
+            HUD_TRACE(HUD_TR_IMG_APPLY_BEGIN, latest.png_item.token, latest.png_item.len);
+            decode_img_event(&latest, false, &out);
+            commit_map_out(&out);
+            HUD_TRACE(HUD_TR_IMG_APPLY_END, latest.png_item.token, 0);
         }
     }
 }
 
+void ui_bridge_get_stats(ui_bridge_stats_t *out)
+{
+    if (!out) return;
+    out->img_replaced = s_img_replaced;
+    out->img_pending = s_img_q ? (uint32_t)uxQueueMessagesWaiting(s_img_q) : 0;
+}
+
+void ui_bridge_map_size(uint16_t *w, uint16_t *h)
+{
+    *w = UI_MAP_POOL_W;
+    *h = UI_MAP_POOL_H;
+}
+
+void ui_bridge_set_notify(void (*fn)(void *user), void *user)
+{
+    s_notify_user = user;
+    s_notify_fn = fn;
+}
+
+bool ui_bridge_start_decoder(int core, unsigned priority, uint32_t stack)
+{
+    if (s_decode_on) return true;
+    if (!s_img_q) return false;
+
+    if (!s_ready_q) {
+        /* 就绪队列：每项只是一个位图指针，LVGL 线程每轮全部取走 */
+        s_ready_q = xQueueCreate(4, sizeof(map_out_t));
+        if (!s_ready_q) return false;
+    }
+
+    s_decode_on = true;
+    BaseType_t ok;
+    if (core >= 0) {
+        ok = xTaskCreatePinnedToCore(decode_task_fn, "img_dec", stack, nullptr, priority, &s_decode_task, core);
+    } else {
+        ok = xTaskCreate(decode_task_fn, "img_dec", stack, nullptr, priority, &s_decode_task);
+    }
+    if (ok != pdPASS) {
+        s_decode_task = nullptr;
+        s_decode_on = false;
+        Serial0.println("[UI_BRIDGE] decode task create failed, decoding on LVGL thread");
+        return false;
+    }
+    return true;
+}
+
 } /* extern "C" */
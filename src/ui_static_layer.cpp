@@ -0,0 +1,265 @@
+#include "ui_static_layer.h"
+
+#include <Arduino.h>
+#include <string.h>
+
+#include <lvgl.h>
+
+extern "C" {
+
+#define SL_FLAG_DYNAMIC LV_OBJ_FLAG_USER_1
+#define SL_MAX_OBJS 128     // 参与分类的对象上限，超出放弃
+#define SL_MAX_AREAS 48     // 实时区域上限，超出后并入最后一块（偏保守）
+
+typedef enum {
+    SL_BAKE = 0,    // 整个子树进快照
+    SL_STRIP,       // 自身进快照，但有实时子对象：保留对象，只去掉自身的绘制
+    SL_LIVE         // 子树保持实时绘制
+} sl_kind_t;
+
+typedef struct {
+    lv_obj_t *obj;
+    uint8_t kind;       // sl_kind_t
+    bool root;          // 父对象与自己归类不同（需要处理的那一层）
+    bool had_opa;       // LIVE 根：原先是否有本地 opa
+    lv_style_value_t opa;
+} sl_entry_t;
+
+static sl_entry_t s_ent[SL_MAX_OBJS];
+static int s_ent_count;
+static lv_area_t s_live[SL_MAX_AREAS];
+static int s_live_count;
+static bool s_overflow;
+
+static lv_img_dsc_t *s_snap = nullptr;
+static lv_obj_t *s_base = nullptr;
+
+void ui_static_layer_mark_dynamic(lv_obj_t *obj)
+{
+    if (obj) lv_obj_add_flag(obj, SL_FLAG_DYNAMIC);
+}
+
+size_t ui_static_layer_bytes(void)
+{
+    return s_snap ? s_snap->data_size : 0;
+}
+
+static void ext_coords(lv_obj_t *obj, lv_area_t *a)
+{
+    lv_obj_get_coords(obj, a);
+    const lv_coord_t ext = _lv_obj_get_ext_draw_size(obj);
+    a->x1 -= ext;
+    a->y1 -= ext;
+    a->x2 += ext;
+    a->y2 += ext;
+}
+
+static void add_live(const lv_area_t *a)
+{
+    if (s_live_count < SL_MAX_AREAS) {
+        s_live[s_live_count++] = *a;
+    } else {
+        _lv_area_join(&s_live[SL_MAX_AREAS - 1], &s_live[SL_MAX_AREAS - 1], a);
+    }
+}
+
+static bool hits_live(const lv_area_t *a)
+{
+    lv_area_t tmp;
+    for (int i = 0; i < s_live_count; i++) {
+        if (_lv_area_intersect(&tmp, a, &s_live[i])) return true;
+    }
+    return false;
+}
+
+/* 动态对象可能占到的范围：固定尺寸的就是它自己，尺寸随内容变化或会被移动的
+   （文字、图片）按父对象的裁剪区算 */
+static void dynamic_area(lv_obj_t *obj, lv_area_t *a)
+{
+    ext_coords(obj, a);
+    lv_obj_t *parent = lv_obj_get_parent(obj);
+    const bool fixed = lv_obj_get_style_width(obj, LV_PART_MAIN) != LV_SIZE_CONTENT &&
+                       lv_obj_get_style_height(obj, LV_PART_MAIN) != LV_SIZE_CONTENT &&
+                       !lv_obj_check_type(obj, &lv_img_class) &&
+                       !lv_obj_check_type(obj, &lv_label_class);
+    if (parent && !fixed) {
+        lv_area_t p;
+        ext_coords(parent, &p);
+        _lv_area_join(a, a, &p);
+    }
+}
+
+static bool subtree_has_dynamic(lv_obj_t *obj)
+{
+    if (lv_obj_has_flag(obj, SL_FLAG_DYNAMIC)) return true;
+    const uint32_t n = lv_obj_get_child_cnt(obj);
+    for (uint32_t i = 0; i < n; i++) {
+        if (subtree_has_dynamic(lv_obj_get_child(obj, (int32_t)i))) return true;
+    }
+    return false;
+}
+
+static sl_entry_t *new_entry(lv_obj_t *obj, sl_kind_t kind, bool root)
+{
+    if (s_ent_count >= SL_MAX_OBJS) {
+        s_overflow = true;
+        return nullptr;
+    }
+    sl_entry_t *e = &s_ent[s_ent_count++];
+    memset(e, 0, sizeof(*e));
+    e->obj = obj;
+    e->kind = (uint8_t)kind;
+    e->root = root;
+    return e;
+}
+
+/* 实时子树：只记录区域，子对象受父对象裁剪，记父对象的区域即可 */
+static void mark_live(lv_obj_t *obj)
+{
+    lv_area_t a;
+    if (subtree_has_dynamic(obj)) {
+        dynamic_area(obj, &a);
+    } else {
+        ext_coords(obj, &a);
+    }
+    add_live(&a);
+    new_entry(obj, SL_LIVE, true);
+}
+
+/* 按绘制顺序分类；返回该对象的归类 */
+static sl_kind_t classify(lv_obj_t *obj, bool force_live)
+{
+    const bool hidden = lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    if (hidden && !subtree_has_dynamic(obj)) {
+        return SL_BAKE;     // 不绘制，也不会被显示出来：保持原样
+    }
+
+    lv_area_t a;
+    ext_coords(obj, &a);
+    if (force_live || hidden || lv_obj_has_flag(obj, SL_FLAG_DYNAMIC) || hits_live(&a)) {
+        mark_live(obj);
+        return SL_LIVE;
+    }
+
+    sl_entry_t *self = new_entry(obj, SL_BAKE, true);
+    if (!self) return SL_LIVE;
+    const int self_idx = (int)(self - s_ent);
+
+    // 布局容器里动态子对象的尺寸变化会挪动兄弟，整组实时
+    const bool layout_dyn = lv_obj_get_style_layout(obj, LV_PART_MAIN) != 0 && subtree_has_dynamic(obj);
+
+    bool any_live = false;
+    const uint32_t n = lv_obj_get_child_cnt(obj);
+    for (uint32_t i = 0; i < n; i++) {
+        if (classify(lv_obj_get_child(obj, (int32_t)i), layout_dyn) != SL_BAKE) any_live = true;
+    }
+    if (!any_live) {
+        // 子对象跟随本对象整体处理，不再单独隐藏
+        for (int i = self_idx + 1; i < s_ent_count; i++) s_ent[i].root = false;
+        return SL_BAKE;
+    }
+
+    // 只有纯容器能单独去掉自身绘制；图片/文字带实时子对象的情况不处理
+    if (!lv_obj_check_type(obj, &lv_obj_class)) s_overflow = true;
+    s_ent[self_idx].kind = SL_STRIP;
+    return SL_STRIP;
+}
+
+/* 隐藏已进快照的对象：父对象有布局或按内容定尺寸时改用透明度，避免兄弟被挪动 */
+static void retire(lv_obj_t *obj)
+{
+    lv_obj_t *parent = lv_obj_get_parent(obj);
+    const bool keep_layout = parent &&
+                             (lv_obj_get_style_layout(parent, LV_PART_MAIN) != 0 ||
+                              lv_obj_get_style_width(parent, LV_PART_MAIN) == LV_SIZE_CONTENT ||
+                              lv_obj_get_style_height(parent, LV_PART_MAIN) == LV_SIZE_CONTENT);
+    if (keep_layout) {
+        lv_obj_set_style_opa(obj, LV_OPA_TRANSP, LV_PART_MAIN);
+    } else {
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+static void strip(lv_obj_t *obj)
+{
+    lv_obj_set_style_bg_opa(obj, LV_OPA_TRANSP, LV_PART_MAIN);
+    lv_obj_set_style_bg_img_opa(obj, LV_OPA_TRANSP, LV_PART_MAIN);
+    lv_obj_set_style_border_opa(obj, LV_OPA_TRANSP, LV_PART_MAIN);
+    lv_obj_set_style_outline_opa(obj, LV_OPA_TRANSP, LV_PART_MAIN);
+    lv_obj_set_style_shadow_opa(obj, LV_OPA_TRANSP, LV_PART_MAIN);
+}
+
+bool ui_static_layer_build(lv_obj_t *screen)
+{
+#if LV_USE_SNAPSHOT
+    if (!screen || s_snap) return false;
+
+    lv_obj_update_layout(screen);
+    s_ent_count = 0;
+    s_live_count = 0;
+    s_overflow = false;
+
+    int baked = 0;
+    const uint32_t n = lv_obj_get_child_cnt(screen);
+    for (uint32_t i = 0; i < n; i++) {
+        classify(lv_obj_get_child(screen, (int32_t)i), false);
+    }
+    for (int i = 0; i < s_ent_count; i++) {
+        if (s_ent[i].root && s_ent[i].kind == SL_BAKE) baked++;
+    }
+    if (s_overflow || baked == 0) {
+        Serial0.printf("[STATIC] nothing to bake (%d objects, overflow %d)\n", s_ent_count, (int)s_overflow);
+        return false;
+    }
+
+    // 实时对象暂时透明，渲染出只含静态内容的底图
+    for (int i = 0; i < s_ent_count; i++) {
+        sl_entry_t *e = &s_ent[i];
+        if (e->kind != SL_LIVE) continue;
+        e->had_opa = lv_obj_get_local_style_prop(e->obj, LV_STYLE_OPA, &e->opa, LV_PART_MAIN) == LV_RES_OK;
+        lv_obj_set_style_opa(e->obj, LV_OPA_TRANSP, LV_PART_MAIN);
+    }
+
+    s_snap = lv_snapshot_take(screen, LV_IMG_CF_TRUE_COLOR);
+
+    for (int i = 0; i < s_ent_count; i++) {
+        sl_entry_t *e = &s_ent[i];
+        if (e->kind != SL_LIVE) continue;
+        if (e->had_opa) {
+            lv_obj_set_local_style_prop(e->obj, LV_STYLE_OPA, e->opa, LV_PART_MAIN);
+        } else {
+            lv_obj_remove_local_style_prop(e->obj, LV_STYLE_OPA, LV_PART_MAIN);
+        }
+    }
+
+    if (!s_snap) {
+        Serial0.printf("[STATIC] snapshot alloc failed\n");
+        return false;
+    }
+
+    for (int i = 0; i < s_ent_count; i++) {
+        sl_entry_t *e = &s_ent[i];
+        if (e->kind == SL_STRIP) {
+            strip(e->obj);
+        } else if (e->kind == SL_BAKE && e->root) {
+            retire(e->obj);
+        }
+    }
+
+    s_base = lv_img_create(screen);
+    lv_obj_clear_flag(s_base, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_img_set_src(s_base, s_snap);
+    lv_obj_set_pos(s_base, 0, 0);
+    lv_obj_move_to_index(s_base, 0);
+    lv_obj_invalidate(screen);
+
+    Serial0.printf("[STATIC] baked %d objects into %ux%u background (%u bytes)\n", baked,
+                   (unsigned)s_snap->header.w, (unsigned)s_snap->header.h, (unsigned)s_snap->data_size);
+    return true;
+#else
+    (void)screen;
+    return false;
+#endif
+}
+
+} // extern "C"
@@ -7,18 +7,226 @@
 #include "freertos/semphr.h"
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define USB_SR_MAX_SYNC_TAILS 4
+/* upper bound on a notify wait, covers a missed event from the transport */
+#define USB_SR_NOTIFY_BACKSTOP_MS 50
 
-static uint32_t crc32_ieee(const uint8_t *data, size_t len)
+/* -------- CRC32 (IEEE 802.3, reflected, poly 0xEDB88320) --------
+   crc32_update() follows the zlib convention: start from 0, feed chunks in order,
+   the returned value is the final CRC. This lets the RX path checksum each chunk
+   while it is still in the (internal RAM) read buffer instead of re-reading PSRAM. */
+#if __has_include("esp_rom_crc.h")
+#include "esp_rom_crc.h"
+static void crc32_init(void) {}
+static inline uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len)
 {
-    uint32_t crc = 0xffffffffu;
-    for (size_t i = 0; i < len; i++)
+    /* ROM implementation does the pre/post inversion itself. */
+    return esp_rom_crc32_le(crc, data, (uint32_t)len);
+}
+#else
+/* slice-by-8 fallback, tables built once on first router creation */
+static uint32_t s_crc_tab[8][256];
+static bool s_crc_tab_ready = false;
+
+static void crc32_init(void)
+{
+    if (s_crc_tab_ready)
+        return;
+    for (uint32_t i = 0; i < 256; i++)
     {
-        crc ^= data[i];
+        uint32_t c = i;
         for (int j = 0; j < 8; j++)
-            crc = (crc >> 1) ^ (0xedb88320u & (-(int)(crc & 1)));
+            c = (c >> 1) ^ (0xedb88320u & (-(int32_t)(c & 1)));
+        s_crc_tab[0][i] = c;
     }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = s_crc_tab[0][i];
+        for (int t = 1; t < 8; t++)
+        {
+            c = s_crc_tab[0][c & 0xff] ^ (c >> 8);
+            s_crc_tab[t][i] = c;
+        }
+    }
+    s_crc_tab_ready = true;
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    while (len && ((uintptr_t)data & 3))
+    {
+        crc = s_crc_tab[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        len--;
+    }
+    while (len >= 8)
+    {
+        /* little-endian word loads (Xtensa / x86 / ARM-LE) */
+        uint32_t a, b;
+        memcpy(&a, data, 4);
+        memcpy(&b, data + 4, 4);
+        a ^= crc;
+        crc = s_crc_tab[7][a & 0xff] ^ s_crc_tab[6][(a >> 8) & 0xff] ^
+              s_crc_tab[5][(a >> 16) & 0xff] ^ s_crc_tab[4][a >> 24] ^
+              s_crc_tab[3][b & 0xff] ^ s_crc_tab[2][(b >> 8) & 0xff] ^
+              s_crc_tab[1][(b >> 16) & 0xff] ^ s_crc_tab[0][b >> 24];
+        data += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = s_crc_tab[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
     return ~crc;
 }
+#endif
+
+/* -------- Streaming LZ4 block decoder --------
+   Compressed payloads (USB_SR_FLAG_LZ4) are decoded chunk by chunk as they are read, straight
+   into the receiver's buffer; matches only ever look back into that buffer, so the decoder keeps
+   just the position inside the current sequence. */
+enum
+{
+    LZ_TOKEN,
+    LZ_LITLEN, /* literal length extension bytes */
+    LZ_LIT,
+    LZ_OFF0, /* a sequence's literals are done: also the valid end of the block */
+    LZ_OFF1,
+    LZ_MATLEN /* match length extension bytes */
+};
+
+typedef struct
+{
+    uint8_t st;
+    uint8_t token;
+    bool bad;
+    uint16_t off;
+    uint32_t n; /* literal / match length */
+    uint8_t *dst;
+    uint32_t cap; /* raw_len */
+    uint32_t out;
+} lz4s_t;
+
+static void lz4s_init(lz4s_t *z, uint8_t *dst, uint32_t cap)
+{
+    memset(z, 0, sizeof(*z));
+    z->st = LZ_TOKEN;
+    z->dst = dst;
+    z->cap = cap;
+}
+
+static void lz4s_match(lz4s_t *z)
+{
+    if (z->n > z->cap - z->out)
+    {
+        z->bad = true;
+        return;
+    }
+    uint8_t *d = z->dst + z->out;
+    const uint8_t *m = d - z->off;
+    if (z->off >= z->n)
+    {
+        memcpy(d, m, z->n);
+    }
+    else
+    {
+        /* overlapping copy repeats the last off bytes: must go forward byte by byte */
+        for (uint32_t i = 0; i < z->n; i++)
+            d[i] = m[i];
+    }
+    z->out += z->n;
+    z->st = LZ_TOKEN;
+}
+
+/* Once bad is set the rest of the payload is only counted; the frame is dropped at its end. */
+static void lz4s_feed(lz4s_t *z, const uint8_t *s, size_t n)
+{
+    const uint8_t *end = s + n;
+    while (s < end && !z->bad)
+    {
+        switch (z->st)
+        {
+        case LZ_TOKEN:
+            z->token = *s++;
+            z->n = z->token >> 4;
+            z->st = (z->n == 15) ? LZ_LITLEN : (z->n ? LZ_LIT : LZ_OFF0);
+            break;
+        case LZ_LITLEN:
+            z->n += *s;
+            if (*s++ != 255)
+                z->st = LZ_LIT;
+            z->bad = z->n > z->cap;
+            break;
+        case LZ_LIT:
+        {
+            if (z->n > z->cap - z->out)
+            {
+                z->bad = true;
+                break;
+            }
+            uint32_t take = (uint32_t)MIN((size_t)(end - s), (size_t)z->n);
+            memcpy(z->dst + z->out, s, take);
+            s += take;
+            z->out += take;
+            z->n -= take;
+            if (z->n == 0)
+                z->st = LZ_OFF0;
+            break;
+        }
+        case LZ_OFF0:
+            z->off = *s++;
+            z->st = LZ_OFF1;
+            break;
+        case LZ_OFF1:
+            z->off |= (uint16_t)(*s++ << 8);
+            if (z->off == 0 || z->off > z->out)
+            {
+                z->bad = true;
+                break;
+            }
+            z->n = (uint32_t)(z->token & 15) + 4;
+            if ((z->token & 15) == 15)
+                z->st = LZ_MATLEN;
+            else
+                lz4s_match(z);
+            break;
+        default: /* LZ_MATLEN */
+            z->n += *s;
+            if (*s++ != 255)
+                lz4s_match(z);
+            else
+                z->bad = z->n > z->cap;
+            break;
+        }
+    }
+}
+
+static bool lz4s_done(const lz4s_t *z)
+{
+    return !z->bad && z->out == z->cap && z->st == LZ_OFF0;
+}
+
+/* Largest wire payload a receiver can be sent: LZ4's worst case expansion plus raw_len. */
+static size_t wire_max_len(const usb_sr_receiver_t *rcv, uint8_t flags)
+{
+    if ((flags & USB_SR_FLAG_CODEC_MASK) == USB_SR_FLAG_LZ4)
+        return rcv->max_len + rcv->max_len / 255 + 16 + 4;
+    return rcv->max_len;
+}
+
+/* one multiplexed frame being reassembled (RX task only) */
+typedef struct
+{
+    bool open;
+    const usb_sr_receiver_t *rcv;
+    usb_sr_hdr_t hdr;  /* the inner frame's header */
+    usb_sr_hdr_t view; /* what the receiver sees: codec bits cleared, len = decoded length */
+    uint8_t *buf;
+    uint32_t got; /* wire bytes of the inner payload */
+    bool z;       /* USB_SR_FLAG_LZ4: bytes go through lz */
+    lz4s_t lz;
+    uint32_t crc;
+    uint16_t next_idx; /* rsv expected on the next fragment */
+    TickType_t last;   /* tick of the last fragment */
+} mux_chan_t;
 
 struct usb_stream_router
 {
@@ -33,18 +241,124 @@ struct usb_stream_router
     bool has_default;
     usb_sr_receiver_t default_rcv;
 
+    /* resync fast-skip patterns (magic top byte replicated to 4 lanes) */
+    uint32_t tail_pat[USB_SR_MAX_SYNC_TAILS];
+    int tail_count;
+
     TaskHandle_t rx_task;
 
+    /* device -> host */
+    SemaphoreHandle_t tx_mtx;
+    uint32_t tx_seq;
+
+    mux_chan_t mux[USB_SR_MUX_CHANNELS];
+
     usb_sr_stats_t st;
 };
 
-static int find_any_magic(const uint8_t *b, int n)
+/* -------- Resync scanner --------
+   While hunting for a frame start the router keeps a rolling window of the last 4 bytes
+   and compares it against the registered magics. Magics are little-endian, so a magic is
+   complete when its top byte arrives; any 4-byte word that contains none of those "tail"
+   bytes can be skipped in one step (SWAR zero-byte test). */
+#define HAS_ZERO_BYTE(v) (((v) - 0x01010101u) & ~(v) & 0x80808080u)
+
+typedef struct
+{
+    uint32_t win;  /* last bytes seen, newest in bits 24..31 */
+    int fill;      /* valid bytes in win (0..4) */
+    uint32_t hunt; /* bytes consumed since the hunt started */
+} sync_state_t;
+
+static void sync_reset(sync_state_t *s)
 {
-    /* We cannot know all magics; we just look for 4-byte boundary candidates by scanning,
-       then validate hdr after we have full header. So return any position 0..n-4. */
-    /* Heuristic: look for ASCII uppercase letters? Here keep simplest: just slide; real resync happens by header validation. */
-    (void)b;
-    return (n >= 4) ? 0 : -1;
+    s->win = 0;
+    s->fill = 0;
+    s->hunt = 0;
+}
+
+static void rebuild_sync_tails(usb_stream_router_t *r)
+{
+    r->tail_count = 0;
+    for (int i = -1; i < r->receiver_count; i++)
+    {
+        const uint32_t magic = (i < 0) ? USB_SR_MAGIC_MUX : r->receivers[i].magic;
+        uint32_t pat = 0x01010101u * (magic >> 24);
+        bool dup = false;
+        for (int k = 0; k < r->tail_count; k++)
+            dup = dup || (r->tail_pat[k] == pat);
+        if (!dup && r->tail_count < USB_SR_MAX_SYNC_TAILS)
+            r->tail_pat[r->tail_count++] = pat;
+    }
+}
+
+static bool word_has_tail(const usb_stream_router_t *r, uint32_t v)
+{
+    if (r->has_default || r->tail_count >= USB_SR_MAX_SYNC_TAILS)
+        return true; /* any magic is acceptable: no fast skip */
+    for (int k = 0; k < r->tail_count; k++)
+    {
+        if (HAS_ZERO_BYTE(v ^ r->tail_pat[k]))
+            return true;
+    }
+    return false;
+}
+
+static bool is_known_magic(const usb_stream_router_t *r, uint32_t w)
+{
+    if (r->has_default || w == USB_SR_MAGIC_MUX)
+        return true;
+    for (int i = 0; i < r->receiver_count; i++)
+    {
+        if (r->receivers[i].magic == w)
+            return true;
+    }
+    return false;
+}
+
+/* Scan b[0..n) for a magic. Returns the number of bytes consumed up to and including
+   the magic's last byte, or -1 when none was found (all n bytes consumed). */
+static int sync_scan(const usb_stream_router_t *r, sync_state_t *s, const uint8_t *b, int n)
+{
+    int i = 0;
+    while (i < n)
+    {
+        if (i + 4 <= n)
+        {
+            uint32_t v;
+            memcpy(&v, b + i, 4);
+            if (!word_has_tail(r, v))
+            {
+                s->win = v;
+                s->fill = 4;
+                i += 4;
+                continue;
+            }
+        }
+
+        s->win = (s->win >> 8) | ((uint32_t)b[i] << 24);
+        if (s->fill < 4)
+            s->fill++;
+        i++;
+        if (s->fill == 4 && is_known_magic(r, s->win))
+        {
+            s->hunt += (uint32_t)i;
+            return i;
+        }
+    }
+    s->hunt += (uint32_t)n;
+    return -1;
+}
+
+/* A magic was found: account the garbage in front of it. */
+static void sync_found(usb_stream_router_t *r, sync_state_t *s)
+{
+    uint32_t skipped = (s->hunt > 4) ? (s->hunt - 4) : 0;
+    if (skipped)
+    {
+        r->st.bytes_skipped += skipped;
+        r->st.resync_count++;
+    }
 }
 
 static const usb_sr_receiver_t *lookup_receiver(usb_stream_router_t *r, uint32_t magic)
@@ -65,6 +379,151 @@ static void drop_frame(const usb_sr_receiver_t *rcv, int reason, const usb_sr_hd
         rcv->drop(rcv->user, hdr, reason);
 }
 
+/* -------- Channel multiplexing (RX task only) -------- */
+
+static void mux_close(usb_stream_router_t *r, mux_chan_t *ch, int reason)
+{
+    if (!ch->open)
+        return;
+    ch->open = false;
+    r->st.frames_dropped++;
+    if (reason == USB_SR_DROP_TIMEOUT)
+        r->st.frames_timeout++;
+    drop_frame(ch->rcv, reason, &ch->view);
+}
+
+/* A frame for rcv is about to acquire a buffer: end whatever the receiver has open on a channel. */
+static void mux_release_receiver(usb_stream_router_t *r, const usb_sr_receiver_t *rcv)
+{
+    for (int i = 0; i < USB_SR_MUX_CHANNELS; i++)
+    {
+        if (r->mux[i].open && r->mux[i].rcv == rcv)
+            mux_close(r, &r->mux[i], USB_SR_DROP_MUX_GAP);
+    }
+}
+
+static bool mux_any_open(const usb_stream_router_t *r)
+{
+    for (int i = 0; i < USB_SR_MUX_CHANNELS; i++)
+    {
+        if (r->mux[i].open)
+            return true;
+    }
+    return false;
+}
+
+static void mux_expire(usb_stream_router_t *r, TickType_t timeout)
+{
+    if (!timeout)
+        return;
+    const TickType_t now = xTaskGetTickCount();
+    for (int i = 0; i < USB_SR_MUX_CHANNELS; i++)
+    {
+        if (r->mux[i].open && (TickType_t)(now - r->mux[i].last) >= timeout)
+            mux_close(r, &r->mux[i], USB_SR_DROP_TIMEOUT);
+    }
+}
+
+static void mux_put(mux_chan_t *ch, const uint8_t *src, size_t n)
+{
+    if (ch->rcv->require_crc)
+        ch->crc = crc32_update(ch->crc, src, n);
+    if (ch->z)
+        lz4s_feed(&ch->lz, src, n);
+    else
+        memcpy(ch->buf + ch->got, src, n);
+    ch->got += (uint32_t)n;
+}
+
+/* The fragment in frag has been consumed: commit the inner frame once it is complete. */
+static void mux_fragment_done(usb_stream_router_t *r, mux_chan_t *ch, const usb_sr_hdr_t *frag)
+{
+    if (!ch->open)
+        return;
+    ch->last = xTaskGetTickCount();
+    ch->next_idx = (uint16_t)(frag->rsv + 1);
+    if (ch->got < ch->hdr.len)
+    {
+        if (frag->flags & USB_SR_MUX_LAST)
+            mux_close(r, ch, USB_SR_DROP_BAD_LEN);
+        return;
+    }
+    if (ch->rcv->require_crc && (ch->hdr.crc32 == 0 || ch->crc != ch->hdr.crc32))
+    {
+        mux_close(r, ch, USB_SR_DROP_BAD_CRC);
+        return;
+    }
+    if (ch->z && !lz4s_done(&ch->lz))
+    {
+        mux_close(r, ch, USB_SR_DROP_BAD_CODEC);
+        return;
+    }
+    ch->open = false;
+    if (ch->rcv->commit)
+        ch->rcv->commit(ch->rcv->user, &ch->view, ch->buf, (size_t)ch->view.len);
+    r->st.frames_ok++;
+    r->st.mux_frames++;
+    if (ch->z)
+    {
+        r->st.lz4_frames++;
+        r->st.lz4_bytes_out += ch->view.len;
+    }
+}
+
+/* Header (and raw_len of a compressed frame) known: get the receiver's buffer for view->len bytes.
+   Returns 0 or the USB_SR_DROP_* reason. */
+static int bind_buffer(usb_stream_router_t *r, const usb_sr_receiver_t *rcv, const usb_sr_hdr_t *view,
+                       uint8_t **buf)
+{
+    size_t cap = 0;
+    *buf = NULL;
+    /* before the drop too: drop() frees what the receiver has open on a channel */
+    mux_release_receiver(r, rcv);
+    if (view->len == 0 || view->len > rcv->max_len)
+        return USB_SR_DROP_BAD_LEN;
+    if (rcv->acquire)
+        *buf = (uint8_t *)rcv->acquire(rcv->user, view, &cap);
+    if (!*buf || cap < view->len)
+        return USB_SR_DROP_NO_BUFFER;
+    return 0;
+}
+
+static uint32_t get_u32le(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void rx_notify(void *arg)
+{
+    usb_stream_router_t *r = (usb_stream_router_t *)arg;
+    if (r && r->rx_task)
+        xTaskNotifyGive(r->rx_task);
+}
+
+/* Nothing to read: block until the transport signals data, or fall back to a 1-tick poll.
+   max_wait bounds the block while a frame is open so the frame timeout is honoured. */
+static void rx_wait(usb_stream_router_t *r, TickType_t max_wait)
+{
+    if (r->tp.set_rx_notify)
+    {
+        TickType_t t = pdMS_TO_TICKS(USB_SR_NOTIFY_BACKSTOP_MS);
+        if (max_wait && max_wait < t)
+            t = max_wait;
+        ulTaskNotifyTake(pdTRUE, t ? t : 1);
+    }
+    else
+    {
+        vTaskDelay(1);
+    }
+}
+
+static void account_rx(usb_stream_router_t *r, int n)
+{
+    r->st.bytes_rx += (uint64_t)n;
+    if (r->cfg.on_rx_activity)
+        r->cfg.on_rx_activity(r->cfg.on_rx_activity_user, (size_t)n);
+}
+
 static void rx_task_fn(void *arg)
 {
     usb_stream_router_t *r = (usb_stream_router_t *)arg;
@@ -73,16 +532,39 @@ static void rx_task_fn(void *arg)
     {
         ST_SYNC,
         ST_HDR,
-        ST_PAYLOAD
+        ST_ZLEN, /* raw_len word in front of an LZ4 payload */
+        ST_PAYLOAD,
+        ST_DISCARD,
+        ST_MUX_HDR,  /* first fragment: the inner frame's header */
+        ST_MUX_ZLEN, /* first fragment: raw_len of a compressed inner frame */
+        ST_MUX_DATA  /* fragment bytes into the channel's buffer */
     } st = ST_SYNC;
 
     usb_sr_hdr_t hdr;
     uint32_t hdr_got = 0;
+    uint32_t discard_left = 0;
+
+    sync_state_t sync;
+    sync_reset(&sync);
 
     const usb_sr_receiver_t *rcv = NULL;
-    void *payload_buf = NULL;
-    size_t payload_cap = 0;
-    uint32_t pay_got = 0;
+    usb_sr_hdr_t view; /* hdr as the receiver sees it (decoded len, codec bits cleared) */
+    uint8_t *payload_buf = NULL;
+    uint32_t pay_got = 0; /* wire bytes */
+    uint32_t pay_crc = 0;
+    bool need_crc = false;
+    bool pay_done = false;
+
+    /* USB_SR_FLAG_LZ4 payloads (plain or inner MUXF frames) */
+    bool pay_z = false;
+    lz4s_t pz;
+    uint8_t zlen[4];
+    uint32_t zlen_got = 0;
+
+    /* MUXF: hdr is the fragment header, ch the channel it feeds */
+    mux_chan_t *ch = NULL;
+    uint32_t frag_left = 0;
+    uint32_t inner_got = 0;
 
     int chunk = r->cfg.read_chunk;
     if (chunk < 512)
@@ -90,6 +572,11 @@ static void rx_task_fn(void *arg)
     if (chunk > 16384)
         chunk = 16384;
 
+    /* inter-byte timeout while a frame is open (header seen, payload incomplete) */
+    const TickType_t frame_timeout =
+        (r->cfg.frame_timeout_ms > 0) ? pdMS_TO_TICKS(r->cfg.frame_timeout_ms) : 0;
+    TickType_t last_rx = xTaskGetTickCount();
+
     static uint8_t tmp_storage[16384];
     uint8_t *tmp = tmp_storage;
 
@@ -98,40 +585,103 @@ static void rx_task_fn(void *arg)
         int avail = r->tp.available(r->tp.ctx);
         if (avail <= 0)
         {
-            vTaskDelay(1);
+            if (st != ST_SYNC && frame_timeout &&
+                (TickType_t)(xTaskGetTickCount() - last_rx) >= frame_timeout)
+            {
+                /* host stalled or len was corrupt: abandon the frame instead of waiting forever */
+                if (st == ST_MUX_DATA && ch->open)
+                {
+                    mux_close(r, ch, USB_SR_DROP_TIMEOUT);
+                }
+                else if (st != ST_DISCARD && st != ST_MUX_DATA)
+                {
+                    /* a discarded frame (or a closed channel's fragment) was counted when it was dropped */
+                    r->st.frames_dropped++;
+                    r->st.frames_timeout++;
+                    if (st == ST_PAYLOAD)
+                        drop_frame(rcv, USB_SR_DROP_TIMEOUT, &view);
+                }
+                sync_reset(&sync);
+                st = ST_SYNC;
+            }
+            /* channels waiting for their next fragment age out the same way */
+            mux_expire(r, frame_timeout);
+            rx_wait(r, (st != ST_SYNC || mux_any_open(r)) ? frame_timeout : 0);
             continue;
         }
 
-        int rd = MIN(avail, chunk);
-        int n = r->tp.read(r->tp.ctx, tmp, rd);
-        if (n <= 0)
-            continue;
-
-        r->st.bytes_rx += (uint64_t)n;
-        if (r->cfg.on_rx_activity)
-            r->cfg.on_rx_activity(r->cfg.on_rx_activity_user, (size_t)n);
+        int n, off = 0;
+        if (((st == ST_PAYLOAD && !pay_z) || (st == ST_MUX_DATA && ch->open && !ch->z)) && r->tp.read_into)
+        {
+            /* zero-copy: the rest of the payload goes straight into the receiver buffer
+               (compressed payloads are staged in tmp and decoded from there) */
+            uint8_t *dst = (st == ST_PAYLOAD) ? payload_buf + pay_got : ch->buf + ch->got;
+            uint32_t left = (st == ST_PAYLOAD) ? hdr.len - pay_got : frag_left;
+            int rd = (int)MIN((uint32_t)avail, left);
+            n = r->tp.read_into(r->tp.ctx, dst, rd);
+            if (n <= 0)
+                continue;
+            account_rx(r, n);
+            last_rx = xTaskGetTickCount();
+            if (st == ST_PAYLOAD)
+            {
+                if (need_crc)
+                    pay_crc = crc32_update(pay_crc, dst, (size_t)n);
+                pay_got += (uint32_t)n;
+                pay_done = (pay_got == hdr.len);
+            }
+            else
+            {
+                if (ch->rcv->require_crc)
+                    ch->crc = crc32_update(ch->crc, dst, (size_t)n);
+                ch->got += (uint32_t)n;
+                frag_left -= (uint32_t)n;
+                pay_done = (frag_left == 0);
+            }
+            n = 0; /* nothing staged in tmp */
+        }
+        else
+        {
+            int rd = MIN(avail, chunk);
+            n = r->tp.read(r->tp.ctx, tmp, rd);
+            if (n <= 0)
+                continue;
+            account_rx(r, n);
+            last_rx = xTaskGetTickCount();
+        }
 
-        int off = 0;
-        while (off < n)
+        while (off < n || pay_done)
         {
 
             if (st == ST_SYNC)
             {
-                /* We don't know magic set globally; try to start at current off, then validate header later.
-                   If header invalid, slide by 1 and try again. */
-                int pos = find_any_magic(tmp + off, n - off);
-                if (pos < 0)
+                int end = sync_scan(r, &sync, tmp + off, n - off);
+                if (end < 0)
+                {
+                    off = n;
                     break;
+                }
+                off += end;
 
-                /* start collecting header from off+pos */
-                hdr_got = 0;
-                int take = MIN((int)sizeof(hdr), n - (off + pos));
-                memcpy(((uint8_t *)&hdr) + hdr_got, tmp + off + pos, (size_t)take);
-                hdr_got += (uint32_t)take;
-                off = off + pos + take;
-                st = (hdr_got == sizeof(hdr)) ? ST_PAYLOAD : ST_HDR;
+                /* magic complete: it forms the first 4 header bytes */
+                sync_found(r, &sync);
+                memcpy(&hdr, &sync.win, 4);
+                hdr_got = 4;
+                st = ST_HDR;
+                continue;
+            }
 
-                r->st.resync_count++;
+            if (st == ST_DISCARD)
+            {
+                /* payload of a well-formed frame we could not store: skip it as a unit */
+                int take = (int)MIN(discard_left, (uint32_t)(n - off));
+                off += take;
+                discard_left -= (uint32_t)take;
+                if (discard_left == 0)
+                {
+                    sync_reset(&sync);
+                    st = ST_SYNC;
+                }
                 continue;
             }
 
@@ -145,114 +695,303 @@ static void rx_task_fn(void *arg)
 
                 if (hdr_got < sizeof(hdr))
                     continue;
-                st = ST_PAYLOAD;
-            }
 
-            if (st == ST_PAYLOAD)
-            {
-                /* validate & bind receiver once per frame */
-                rcv = lookup_receiver(r, hdr.magic);
-                if (!rcv)
+                /* validate & bind receiver once per frame, before any buffer is acquired */
+                bool hdr_rejected = false;
+                if (hdr.magic == USB_SR_MAGIC_MUX)
                 {
-                    r->st.frames_dropped++;
-                    st = ST_SYNC;
+                    rcv = NULL;
+                    hdr_rejected = hdr.type >= USB_SR_MUX_CHANNELS || hdr.len == 0 ||
+                                   hdr.len > USB_SR_MUX_FRAG_MAX ||
+                                   ((hdr.flags & USB_SR_MUX_FIRST) && hdr.len < sizeof(usb_sr_hdr_t));
+                    if (hdr_rejected)
+                        r->st.frames_dropped++;
+                }
+                else
+                {
+                    rcv = lookup_receiver(r, hdr.magic);
+                    if (!rcv)
+                    {
+                        r->st.frames_dropped++;
+                        hdr_rejected = true;
+                    }
+                    else if (hdr.len == 0 || hdr.len > wire_max_len(rcv, hdr.flags) ||
+                             ((hdr.flags & USB_SR_FLAG_CODEC_MASK) == USB_SR_FLAG_LZ4 && hdr.len <= 4))
+                    {
+                        mux_release_receiver(r, rcv);
+                        r->st.frames_dropped++;
+                        drop_frame(rcv, USB_SR_DROP_BAD_LEN, &hdr);
+                        hdr_rejected = true;
+                    }
+                    else if ((hdr.flags & USB_SR_FLAG_CODEC_MASK) &&
+                             (hdr.flags & USB_SR_FLAG_CODEC_MASK) != USB_SR_FLAG_LZ4)
+                    {
+                        mux_release_receiver(r, rcv);
+                        r->st.frames_dropped++;
+                        drop_frame(rcv, USB_SR_DROP_BAD_CODEC, &hdr);
+                        hdr_rejected = true;
+                    }
+                }
+
+                if (hdr_rejected)
+                {
+                    /* false candidate: a real magic may start inside the 16 bytes after it */
+                    uint8_t hb[sizeof(hdr)];
+                    memcpy(hb, &hdr, sizeof(hdr));
+                    sync_reset(&sync);
+                    sync.hunt = 1;
+                    int end = sync_scan(r, &sync, hb + 1, (int)sizeof(hdr) - 1);
+                    if (end >= 0)
+                    {
+                        int start = 1 + end - 4;
+                        sync_found(r, &sync);
+                        hdr_got = (uint32_t)((int)sizeof(hdr) - start);
+                        memmove(&hdr, hb + start, hdr_got);
+                        st = ST_HDR;
+                    }
+                    else
+                    {
+                        st = ST_SYNC;
+                    }
                     continue;
                 }
 
-                if (hdr.len == 0 || hdr.len > rcv->max_len)
+                if (hdr.magic == USB_SR_MAGIC_MUX)
                 {
-                    r->st.frames_dropped++;
-                    drop_frame(rcv, USB_SR_DROP_BAD_LEN, &hdr);
-                    st = ST_SYNC;
+                    r->st.mux_fragments++;
+                    ch = &r->mux[hdr.type];
+                    frag_left = hdr.len;
+                    if (hdr.flags & USB_SR_MUX_FIRST)
+                    {
+                        mux_close(r, ch, USB_SR_DROP_MUX_GAP); /* a restart supersedes the old frame */
+                        inner_got = 0;
+                        st = ST_MUX_HDR;
+                        continue;
+                    }
+                    if (!ch->open || hdr.rsv != ch->next_idx || hdr.len > ch->hdr.len - ch->got)
+                    {
+                        /* the frame this belongs to is gone (or never made it): skip the piece */
+                        mux_close(r, ch, USB_SR_DROP_MUX_GAP);
+                        discard_left = hdr.len;
+                        st = ST_DISCARD;
+                        continue;
+                    }
+                    st = ST_MUX_DATA;
+                    continue;
+                }
+
+                view = hdr;
+                view.flags &= (uint8_t)~USB_SR_FLAG_CODEC_MASK;
+                pay_got = 0;
+                pay_crc = 0;
+                need_crc = rcv->require_crc;
+                pay_z = (hdr.flags & USB_SR_FLAG_CODEC_MASK) == USB_SR_FLAG_LZ4;
+                if (pay_z)
+                {
+                    /* the buffer is sized by raw_len, which leads the payload */
+                    zlen_got = 0;
+                    st = ST_ZLEN;
                     continue;
                 }
 
                 /* acquire payload buffer */
-                payload_buf = NULL;
-                payload_cap = 0;
-                if (rcv->acquire)
+                int reason = bind_buffer(r, rcv, &view, &payload_buf);
+                if (reason)
                 {
-                    payload_buf = rcv->acquire(rcv->user, &hdr, &payload_cap);
+                    r->st.frames_dropped++;
+                    drop_frame(rcv, reason, &view);
+                    discard_left = hdr.len;
+                    st = ST_DISCARD;
+                    continue;
                 }
-                if (!payload_buf || payload_cap < hdr.len)
+                st = ST_PAYLOAD;
+                continue;
+            }
+
+            if (st == ST_ZLEN)
+            {
+                int take = MIN((int)(sizeof(zlen) - zlen_got), n - off);
+                memcpy(zlen + zlen_got, tmp + off, (size_t)take);
+                zlen_got += (uint32_t)take;
+                off += take;
+                if (zlen_got < sizeof(zlen))
+                    continue;
+
+                if (need_crc)
+                    pay_crc = crc32_update(pay_crc, zlen, sizeof(zlen));
+                pay_got = sizeof(zlen);
+                view.len = get_u32le(zlen);
+                int reason = bind_buffer(r, rcv, &view, &payload_buf);
+                if (reason)
                 {
                     r->st.frames_dropped++;
-                    drop_frame(rcv, USB_SR_DROP_NO_BUFFER, &hdr);
-                    st = ST_SYNC;
+                    drop_frame(rcv, reason, &view);
+                    discard_left = hdr.len - pay_got;
+                    st = ST_DISCARD;
                     continue;
                 }
+                lz4s_init(&pz, payload_buf, view.len);
+                st = ST_PAYLOAD;
+                continue;
+            }
 
-                /* copy payload (might already have some bytes in tmp after header) */
-                pay_got = 0;
-                while (off < n && pay_got < hdr.len)
+            if (st == ST_MUX_HDR)
+            {
+                int need = (int)sizeof(ch->hdr) - (int)inner_got;
+                int take = MIN(need, n - off);
+                memcpy(((uint8_t *)&ch->hdr) + inner_got, tmp + off, (size_t)take);
+                inner_got += (uint32_t)take;
+                off += take;
+                frag_left -= (uint32_t)take;
+                if (inner_got < sizeof(ch->hdr))
+                    continue;
+
+                /* the inner frame gets the same checks as an unfragmented one */
+                const usb_sr_receiver_t *in = (ch->hdr.magic != USB_SR_MAGIC_MUX)
+                                                  ? lookup_receiver(r, ch->hdr.magic)
+                                                  : NULL;
+                const uint8_t codec = ch->hdr.flags & USB_SR_FLAG_CODEC_MASK;
+                ch->view = ch->hdr;
+                ch->view.flags &= (uint8_t)~USB_SR_FLAG_CODEC_MASK;
+                ch->z = (codec == USB_SR_FLAG_LZ4);
+                uint8_t *buf = NULL;
+                int reason = 0;
+                if (!in)
+                    reason = USB_SR_DROP_NO_RECEIVER;
+                else if (ch->hdr.len == 0 || ch->hdr.len > wire_max_len(in, ch->hdr.flags) ||
+                         frag_left > ch->hdr.len || (ch->z && (ch->hdr.len <= 4 || frag_left < 4)))
+                    reason = USB_SR_DROP_BAD_LEN;
+                else if (codec && !ch->z)
+                    reason = USB_SR_DROP_BAD_CODEC;
+                else if (!ch->z)
+                    reason = bind_buffer(r, in, &ch->view, &buf);
+                if (reason)
                 {
-                    int need = (int)hdr.len - (int)pay_got;
-                    int take = MIN(need, n - off);
-                    memcpy(((uint8_t *)payload_buf) + pay_got, tmp + off, (size_t)take);
-                    pay_got += (uint32_t)take;
-                    off += take;
+                    if (in)
+                        mux_release_receiver(r, in);
+                    r->st.frames_dropped++;
+                    drop_frame(in, reason, &ch->view);
+                    discard_left = frag_left;
+                    st = discard_left ? ST_DISCARD : ST_SYNC;
+                    sync_reset(&sync);
+                    continue;
                 }
 
-                if (pay_got < hdr.len)
+                ch->rcv = in;
+                ch->buf = buf;
+                ch->got = 0;
+                ch->crc = 0;
+                if (ch->z)
                 {
-                    /* need continue receiving payload across next reads */
-                    while (pay_got < hdr.len)
-                    {
-                        int a = r->tp.available(r->tp.ctx);
-                        if (a <= 0)
-                        {
-                            vTaskDelay(1);
-                            continue;
-                        }
-
-                        int rr = MIN(a, chunk);
-                        int nn = r->tp.read(r->tp.ctx, tmp, rr);
-                        if (nn <= 0)
-                            continue;
-                        r->st.bytes_rx += (uint64_t)nn;
-                        if (r->cfg.on_rx_activity)
-                            r->cfg.on_rx_activity(r->cfg.on_rx_activity_user, (size_t)nn);
-
-                        int oo = 0;
-                        while (oo < nn && pay_got < hdr.len)
-                        {
-                            int need = (int)hdr.len - (int)pay_got;
-                            int take = MIN(need, nn - oo);
-                            memcpy(((uint8_t *)payload_buf) + pay_got, tmp + oo, (size_t)take);
-                            pay_got += (uint32_t)take;
-                            oo += take;
-                        }
-                    }
+                    zlen_got = 0;
+                    st = ST_MUX_ZLEN;
+                    continue;
                 }
+                ch->open = true;
+                st = ST_MUX_DATA;
+                if (frag_left == 0)
+                    pay_done = true; /* header-only first fragment */
+                continue;
+            }
 
-                /* CRC check */
-                bool need_crc = rcv->require_crc;
-                if (need_crc)
+            if (st == ST_MUX_ZLEN)
+            {
+                int take = MIN((int)(sizeof(zlen) - zlen_got), n - off);
+                memcpy(zlen + zlen_got, tmp + off, (size_t)take);
+                zlen_got += (uint32_t)take;
+                off += take;
+                frag_left -= (uint32_t)take;
+                if (zlen_got < sizeof(zlen))
+                    continue;
+
+                ch->view.len = get_u32le(zlen);
+                int reason = bind_buffer(r, ch->rcv, &ch->view, &ch->buf);
+                if (reason)
                 {
-                    if (hdr.crc32 == 0)
-                    {
-                        r->st.frames_dropped++;
-                        drop_frame(rcv, USB_SR_DROP_BAD_CRC, &hdr);
-                        st = ST_SYNC;
-                        continue;
-                    }
-                    uint32_t c = crc32_ieee((const uint8_t *)payload_buf, (size_t)hdr.len);
-                    if (c != hdr.crc32)
-                    {
-                        r->st.frames_dropped++;
-                        drop_frame(rcv, USB_SR_DROP_BAD_CRC, &hdr);
-                        st = ST_SYNC;
+                    r->st.frames_dropped++;
+                    drop_frame(ch->rcv, reason, &ch->view);
+                    discard_left = frag_left;
+                    st = discard_left ? ST_DISCARD : ST_SYNC;
+                    sync_reset(&sync);
+                    continue;
+                }
+                if (ch->rcv->require_crc)
+                    ch->crc = crc32_update(0, zlen, sizeof(zlen));
+                ch->got = sizeof(zlen);
+                lz4s_init(&ch->lz, ch->buf, ch->view.len);
+                ch->open = true;
+                st = ST_MUX_DATA;
+                if (frag_left == 0)
+                    pay_done = true;
+                continue;
+            }
+
+            if (st == ST_MUX_DATA)
+            {
+                if (!pay_done)
+                {
+                    int take = (int)MIN(frag_left, (uint32_t)(n - off));
+                    mux_put(ch, tmp + off, (size_t)take);
+                    off += take;
+                    frag_left -= (uint32_t)take;
+                    if (frag_left)
                         continue;
-                    }
                 }
+                pay_done = false;
+                mux_fragment_done(r, ch, &hdr);
+                sync_reset(&sync);
+                st = ST_SYNC;
+                continue;
+            }
 
-                /* commit */
-                if (rcv->commit)
-                    rcv->commit(rcv->user, &hdr, payload_buf, (size_t)hdr.len);
+            /* ST_PAYLOAD: copy whatever this read holds, resume on the next one */
+            if (!pay_done)
+            {
+                int need = (int)(hdr.len - pay_got);
+                int take = MIN(need, n - off);
+                if (need_crc)
+                    pay_crc = crc32_update(pay_crc, tmp + off, (size_t)take);
+                if (pay_z)
+                    lz4s_feed(&pz, tmp + off, (size_t)take);
+                else
+                    memcpy(payload_buf + pay_got, tmp + off, (size_t)take);
+                pay_got += (uint32_t)take;
+                off += take;
+                if (pay_got < hdr.len)
+                    continue;
+            }
+            pay_done = false;
 
-                r->st.frames_ok++;
+            /* CRC check (accumulated while copying, no second pass over the buffer) */
+            if (need_crc && (hdr.crc32 == 0 || pay_crc != hdr.crc32))
+            {
+                r->st.frames_dropped++;
+                drop_frame(rcv, USB_SR_DROP_BAD_CRC, &view);
+                sync_reset(&sync);
                 st = ST_SYNC;
+                continue;
+            }
+            if (pay_z && !lz4s_done(&pz))
+            {
+                r->st.frames_dropped++;
+                drop_frame(rcv, USB_SR_DROP_BAD_CODEC, &view);
+                sync_reset(&sync);
+                st = ST_SYNC;
+                continue;
             }
+
+            /* commit */
+            if (rcv->commit)
+                rcv->commit(rcv->user, &view, payload_buf, (size_t)view.len);
+
+            r->st.frames_ok++;
+            if (pay_z)
+            {
+                r->st.lz4_frames++;
+                r->st.lz4_bytes_out += view.len;
+            }
+            sync_reset(&sync);
+            st = ST_SYNC;
         }
     }
 }
@@ -263,6 +1002,8 @@ usb_stream_router_t *usb_sr_create(const usb_sr_transport_t *tp,
     if (!tp || !cfg || !tp->available || !tp->read)
         return NULL;
 
+    crc32_init();
+
     usb_stream_router_t *r = (usb_stream_router_t *)pvPortMalloc(sizeof(*r));
     if (!r)
         return NULL;
@@ -277,9 +1018,18 @@ usb_stream_router_t *usb_sr_create(const usb_sr_transport_t *tp,
         return NULL;
     }
 
+    r->tx_mtx = xSemaphoreCreateMutex();
+    if (!r->tx_mtx)
+    {
+        vSemaphoreDelete(r->mtx);
+        vPortFree(r);
+        return NULL;
+    }
+
     r->receivers = (usb_sr_receiver_t *)pvPortMalloc(sizeof(usb_sr_receiver_t) * cfg->max_receivers);
     if (!r->receivers)
     {
+        vSemaphoreDelete(r->tx_mtx);
         vSemaphoreDelete(r->mtx);
         vPortFree(r);
         return NULL;
@@ -308,6 +1058,10 @@ usb_stream_router_t *usb_sr_create(const usb_sr_transport_t *tp,
         }
     }
 
+    /* task handle is valid now, so the transport may start signalling */
+    if (r->tp.set_rx_notify)
+        r->tp.set_rx_notify(r->tp.ctx, rx_notify, r);
+
     return r;
 }
 
@@ -321,6 +1075,8 @@ void usb_sr_destroy(usb_stream_router_t *r)
         vPortFree(r->receivers);
     if (r->mtx)
         vSemaphoreDelete(r->mtx);
+    if (r->tx_mtx)
+        vSemaphoreDelete(r->tx_mtx);
     vPortFree(r);
 }
 
@@ -335,6 +1091,7 @@ bool usb_sr_register(usb_stream_router_t *r, const usb_sr_receiver_t *rcv)
         return false;
     }
     r->receivers[r->receiver_count++] = *rcv;
+    rebuild_sync_tails(r);
     xSemaphoreGive(r->mtx);
     return true;
 }
@@ -356,6 +1113,41 @@ void usb_sr_set_default(usb_stream_router_t *r, const usb_sr_receiver_t *rcv)
     xSemaphoreGive(r->mtx);
 }
 
+static bool tx_all(usb_stream_router_t *r, const uint8_t *p, size_t n)
+{
+    while (n > 0)
+    {
+        int w = r->tp.write(r->tp.ctx, p, n > 0x7fffffff ? 0x7fffffff : (int)n);
+        if (w <= 0)
+            return false;
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+bool usb_sr_send(usb_stream_router_t *r, uint32_t magic, uint8_t type, uint8_t flags,
+                 const void *payload, size_t len)
+{
+    if (!r || !r->tp.write || (len && !payload))
+        return false;
+
+    usb_sr_hdr_t hdr;
+    hdr.magic = magic;
+    hdr.type = type;
+    hdr.flags = flags;
+    hdr.rsv = 0;
+    hdr.len = (uint32_t)len;
+    hdr.crc32 = len ? crc32_update(0, (const uint8_t *)payload, len) : 0;
+
+    xSemaphoreTake(r->tx_mtx, portMAX_DELAY);
+    hdr.seq = r->tx_seq++;
+    bool ok = tx_all(r, (const uint8_t *)&hdr, sizeof(hdr)) &&
+              tx_all(r, (const uint8_t *)payload, len);
+    xSemaphoreGive(r->tx_mtx);
+    return ok;
+}
+
 void usb_sr_get_stats(usb_stream_router_t *r, usb_sr_stats_t *out)
 {
     if (!r || !out)
@@ -0,0 +1,179 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+
+struct shim_task
+{
+    pthread_t th;
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+    uint32_t notify;
+    atomic_int kill;
+    TaskFunction_t fn;
+    void *arg;
+};
+
+struct shim_sem
+{
+    pthread_mutex_t mtx;
+};
+
+static __thread struct shim_task *s_self;
+
+void *pvPortMalloc(size_t n) { return malloc(n); }
+void vPortFree(void *p) { free(p); }
+
+static struct timespec deadline(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    const uint64_t ns = (uint64_t)ticks * (1000000000ull / configTICK_RATE_HZ) + (uint64_t)ts.tv_nsec;
+    ts.tv_sec += (time_t)(ns / 1000000000ull);
+    ts.tv_nsec = (long)(ns % 1000000000ull);
+    return ts;
+}
+
+static void exit_if_killed(void)
+{
+    if (s_self && atomic_load(&s_self->kill))
+        pthread_exit(NULL);
+}
+
+/* -------- tasks -------- */
+
+static void *trampoline(void *p)
+{
+    s_self = (struct shim_task *)p;
+    s_self->fn(s_self->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t prio, TaskHandle_t *out)
+{
+    (void)name;
+    (void)stack;
+    (void)prio;
+    struct shim_task *t = (struct shim_task *)calloc(1, sizeof(*t));
+    if (!t)
+        return pdFAIL;
+    pthread_mutex_init(&t->mtx, NULL);
+    pthread_cond_init(&t->cv, NULL);
+    t->fn = fn;
+    t->arg = arg;
+    /* handle first: the task may look itself up (rx_notify) before create returns */
+    if (out)
+        *out = t;
+    if (pthread_create(&t->th, NULL, trampoline, t) != 0)
+    {
+        if (out)
+            *out = NULL;
+        free(t);
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t t)
+{
+    if (!t || t == s_self)
+        pthread_exit(NULL); /* self-delete; the handle leaks, as a detached test thread would */
+
+    pthread_mutex_lock(&t->mtx);
+    atomic_store(&t->kill, 1);
+    pthread_cond_broadcast(&t->cv);
+    pthread_mutex_unlock(&t->mtx);
+    pthread_join(t->th, NULL);
+    pthread_cond_destroy(&t->cv);
+    pthread_mutex_destroy(&t->mtx);
+    free(t);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    exit_if_killed();
+    struct timespec ts = {(time_t)(ticks / configTICK_RATE_HZ),
+                          (long)(ticks % configTICK_RATE_HZ) * (1000000000L / configTICK_RATE_HZ)};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+    exit_if_killed();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t)((uint64_t)ts.tv_sec * configTICK_RATE_HZ +
+                        (uint64_t)ts.tv_nsec / (1000000000ull / configTICK_RATE_HZ));
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct shim_task *t = s_self;
+    if (!t)
+        return 0; /* not a shim task: nobody can notify it */
+
+    pthread_mutex_lock(&t->mtx);
+    const struct timespec until = deadline(ticks);
+    while (!t->notify && !atomic_load(&t->kill))
+    {
+        if (ticks == portMAX_DELAY)
+            pthread_cond_wait(&t->cv, &t->mtx);
+        else if (pthread_cond_timedwait(&t->cv, &t->mtx, &until) == ETIMEDOUT)
+            break;
+    }
+    const uint32_t v = t->notify;
+    if (v)
+        t->notify = clear_on_exit ? 0 : v - 1;
+    pthread_mutex_unlock(&t->mtx);
+    exit_if_killed();
+    return v;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t)
+{
+    if (!t)
+        return pdFAIL;
+    pthread_mutex_lock(&t->mtx);
+    t->notify++;
+    pthread_cond_signal(&t->cv);
+    pthread_mutex_unlock(&t->mtx);
+    return pdPASS;
+}
+
+/* -------- mutexes -------- */
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct shim_sem *s = (struct shim_sem *)calloc(1, sizeof(*s));
+    if (s)
+        pthread_mutex_init(&s->mtx, NULL);
+    return s;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s)
+{
+    if (!s)
+        return;
+    pthread_mutex_destroy(&s->mtx);
+    free(s);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY)
+        return pthread_mutex_lock(&s->mtx) == 0 ? pdTRUE : pdFALSE;
+    const struct timespec until = deadline(ticks);
+    return pthread_mutex_timedlock(&s->mtx, &until) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    return pthread_mutex_unlock(&s->mtx) == 0 ? pdTRUE : pdFALSE;
+}
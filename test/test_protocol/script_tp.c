@@ -0,0 +1,136 @@
+#include "script_tp.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+struct script_tp
+{
+    script_tp_config_t cfg;
+    pthread_mutex_t mtx;
+    pthread_cond_t cv;
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    bool drained; /* router saw available() == 0 after the last byte */
+    uint32_t rng;
+    void (*notify)(void *arg);
+    void *notify_arg;
+};
+
+uint32_t script_rand(uint32_t *s)
+{
+    uint32_t x = *s ? *s : 1;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static int tp_available(void *ctx)
+{
+    script_tp_t *t = (script_tp_t *)ctx;
+    pthread_mutex_lock(&t->mtx);
+    const size_t left = t->len - t->pos;
+    if (!left && t->data && !t->drained)
+    {
+        t->drained = true;
+        pthread_cond_broadcast(&t->cv);
+    }
+    pthread_mutex_unlock(&t->mtx);
+    return left > 0x7fffffff ? 0x7fffffff : (int)left;
+}
+
+static int tp_read(void *ctx, uint8_t *dst, int max_len)
+{
+    script_tp_t *t = (script_tp_t *)ctx;
+    pthread_mutex_lock(&t->mtx);
+    size_t n = 1 + script_rand(&t->rng) % (uint32_t)t->cfg.max_read;
+    if (n > (size_t)max_len)
+        n = (size_t)max_len;
+    if (n > t->len - t->pos)
+        n = t->len - t->pos;
+    memcpy(dst, t->data + t->pos, n);
+    t->pos += n;
+    pthread_mutex_unlock(&t->mtx);
+    return (int)n;
+}
+
+static void tp_set_rx_notify(void *ctx, void (*notify)(void *arg), void *arg)
+{
+    script_tp_t *t = (script_tp_t *)ctx;
+    pthread_mutex_lock(&t->mtx);
+    t->notify = notify;
+    t->notify_arg = arg;
+    pthread_mutex_unlock(&t->mtx);
+}
+
+script_tp_t *script_tp_create(const script_tp_config_t *cfg, usb_sr_transport_t *out)
+{
+    script_tp_t *t = (script_tp_t *)calloc(1, sizeof(*t));
+    if (!t)
+        return NULL;
+    t->cfg = *cfg;
+    if (t->cfg.max_read <= 0)
+        t->cfg.max_read = 4096;
+    t->rng = cfg->seed ? cfg->seed : 1;
+    pthread_mutex_init(&t->mtx, NULL);
+    pthread_cond_init(&t->cv, NULL);
+
+    memset(out, 0, sizeof(*out));
+    out->ctx = t;
+    out->available = tp_available;
+    out->read = tp_read;
+    out->read_into = cfg->zero_copy ? tp_read : NULL;
+    out->set_rx_notify = cfg->notify ? tp_set_rx_notify : NULL;
+    return t;
+}
+
+void script_tp_destroy(script_tp_t *t)
+{
+    if (!t)
+        return;
+    pthread_cond_destroy(&t->cv);
+    pthread_mutex_destroy(&t->mtx);
+    free(t);
+}
+
+int64_t script_tp_run(script_tp_t *t, const uint8_t *data, size_t len, int timeout_ms)
+{
+    struct timespec until;
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec += timeout_ms / 1000;
+    until.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (until.tv_nsec >= 1000000000L)
+    {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+    }
+
+    const int64_t t0 = now_ns();
+    pthread_mutex_lock(&t->mtx);
+    t->data = data;
+    t->len = len;
+    t->pos = 0;
+    t->drained = false;
+    if (t->notify)
+        t->notify(t->notify_arg);
+
+    int rc = 0;
+    while (!t->drained && rc != ETIMEDOUT)
+        rc = pthread_cond_timedwait(&t->cv, &t->mtx, &until);
+    const bool ok = t->drained;
+    /* leave the router an empty stream, not a pointer into the caller's buffer */
+    t->data = NULL;
+    t->len = t->pos = 0;
+    pthread_mutex_unlock(&t->mtx);
+    return ok ? now_ns() - t0 : -1;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "usb_stream_router.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* -------- Scripted transport --------
+       Stands in for the CDC port: script_tp_run() hands the router a byte stream and waits
+       until it has been read completely and the RX task is back in rx_wait(), i.e. every
+       frame in it has been committed or dropped. Reads return a pseudo-random 1..max_read
+       bytes so headers and payloads get split at every possible offset. */
+    typedef struct
+    {
+        int max_read;   /* upper bound of one read(), 0 -> 4096 */
+        bool zero_copy; /* also expose read_into */
+        bool notify;    /* event-driven RX (set_rx_notify) instead of the 1-tick poll */
+        uint32_t seed;  /* read-size sequence, 0 -> 1 */
+    } script_tp_config_t;
+
+    typedef struct script_tp script_tp_t;
+
+    script_tp_t *script_tp_create(const script_tp_config_t *cfg, usb_sr_transport_t *out);
+    void script_tp_destroy(script_tp_t *t);
+
+    /* Feed data (not copied, must stay valid until return) and block until it is consumed.
+       Returns the wall time in ns, or -1 if the router did not drain it within timeout_ms. */
+    int64_t script_tp_run(script_tp_t *t, const uint8_t *data, size_t len, int timeout_ms);
+
+    /* small deterministic PRNG shared with the tests (xorshift32) */
+    uint32_t script_rand(uint32_t *state);
+
+#ifdef __cplusplus
+}
+#endif
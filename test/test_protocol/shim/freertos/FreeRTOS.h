@@ -0,0 +1,32 @@
+#pragma once
+/* Host (pthread) stand-in for the slice of FreeRTOS the protocol stack uses.
+   Only built by [env:native]; see test/test_protocol/freertos_shim.c. */
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef uint32_t TickType_t;
+    typedef long BaseType_t;
+    typedef unsigned long UBaseType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define configTICK_RATE_HZ 1000
+#define configNUM_CORES 1
+#define portMAX_DELAY ((TickType_t)0xffffffffu)
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+    void *pvPortMalloc(size_t n);
+    void vPortFree(void *p);
+
+#ifdef __cplusplus
+}
+#endif
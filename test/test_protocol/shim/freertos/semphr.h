@@ -0,0 +1,18 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct shim_sem *SemaphoreHandle_t;
+
+    SemaphoreHandle_t xSemaphoreCreateMutex(void);
+    void vSemaphoreDelete(SemaphoreHandle_t s);
+    BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks);
+    BaseType_t xSemaphoreGive(SemaphoreHandle_t s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct shim_task *TaskHandle_t;
+    typedef void (*TaskFunction_t)(void *arg);
+
+    /* stack size and priority are ignored: every task is a plain thread */
+    BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                           UBaseType_t prio, TaskHandle_t *out);
+
+    /* Deleting another task is cooperative: it ends at its next vTaskDelay/ulTaskNotifyTake,
+       which the router loop reaches as soon as the transport runs dry. Joins before returning. */
+    void vTaskDelete(TaskHandle_t t);
+
+    void vTaskDelay(TickType_t ticks);
+    TickType_t xTaskGetTickCount(void);
+
+    uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+    BaseType_t xTaskNotifyGive(TaskHandle_t t);
+
+#ifdef __cplusplus
+}
+#endif
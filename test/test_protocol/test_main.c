@@ -0,0 +1,1168 @@
+/* Off-target tests for the USB protocol stack: the real usb_stream_router.c, msgf_receiver.c
+   and imgf_receiver.c on top of a pthread FreeRTOS shim and a scripted transport.
+   Run with:  pio test -e native  (add -v to see the resync / throughput figures) */
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "usb_stream_router.h"
+#include "msgf_receiver.h"
+#include "imgf_receiver.h"
+#include "script_tp.h"
+
+#define MAGIC_MSGF 0x4647534Du
+#define MAGIC_IMGF 0x46474D49u
+#define MAGIC_TEST 0x54534554u /* 'TEST': recording receiver below */
+#define MAGIC_TEST2 0x32545354u /* 'TST2': second recording receiver */
+
+#define RUN_TIMEOUT_MS 10000
+
+static usb_stream_router_t *s_r;
+static script_tp_t *s_tp;
+
+/* -------- stream builder -------- */
+
+static uint32_t crc32_ref(const uint8_t *p, size_t n)
+{
+    uint32_t c = 0xFFFFFFFFu;
+    while (n--)
+    {
+        c ^= *p++;
+        for (int k = 0; k < 8; k++)
+            c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1u)));
+    }
+    return ~c;
+}
+
+typedef struct
+{
+    uint8_t *p;
+    size_t len;
+    size_t cap;
+} stream_t;
+
+static void st_reserve(stream_t *s, size_t n)
+{
+    if (s->len + n <= s->cap)
+        return;
+    size_t cap = s->cap ? s->cap : 4096;
+    while (cap < s->len + n)
+        cap *= 2;
+    s->p = (uint8_t *)realloc(s->p, cap);
+    TEST_ASSERT_NOT_NULL(s->p);
+    s->cap = cap;
+}
+
+static void st_put(stream_t *s, const void *d, size_t n)
+{
+    st_reserve(s, n);
+    memcpy(s->p + s->len, d, n);
+    s->len += n;
+}
+
+static void st_free(stream_t *s)
+{
+    free(s->p);
+    memset(s, 0, sizeof(*s));
+}
+
+static void st_frame(stream_t *s, uint32_t magic, uint8_t type, uint32_t seq,
+                     const uint8_t *pay, size_t len, bool crc)
+{
+    usb_sr_hdr_t h = {0};
+    h.magic = magic;
+    h.type = type;
+    h.len = (uint32_t)len;
+    h.crc32 = crc ? crc32_ref(pay, len) : 0;
+    h.seq = seq;
+    st_put(s, &h, sizeof(h));
+    st_put(s, pay, len);
+}
+
+static const uint32_t k_magics[] = {MAGIC_MSGF, MAGIC_IMGF, MAGIC_TEST, MAGIC_TEST2, USB_SR_MAGIC_MUX};
+
+/* Appends n bytes of garbage that never completes a magic, not even together with the 3
+   bytes already in the stream before it. 'F'/'T' tail bytes still occur, so the scanner's
+   slow path gets exercised as well as the word skip. */
+static void st_garbage(stream_t *s, size_t n, uint32_t *rng)
+{
+    st_reserve(s, n);
+    for (size_t i = 0; i < n; i++)
+    {
+        uint8_t b = (uint8_t)script_rand(rng);
+        for (;;)
+        {
+            uint32_t w = (uint32_t)b << 24;
+            for (int k = 1; k <= 3 && s->len >= (size_t)k; k++)
+                w |= (uint32_t)s->p[s->len - k] << (24 - 8 * k);
+            bool hit = false;
+            for (size_t m = 0; m < sizeof(k_magics) / sizeof(k_magics[0]); m++)
+                hit = hit || (s->len >= 3 && w == k_magics[m]);
+            if (!hit)
+                break;
+            b++;
+        }
+        s->p[s->len++] = b;
+    }
+}
+
+static void fill_rand(uint8_t *p, size_t n, uint32_t *rng)
+{
+    for (size_t i = 0; i < n; i++)
+        p[i] = (uint8_t)script_rand(rng);
+}
+
+/* -------- recording receiver (router-only tests) -------- */
+
+#define REC_MAX_LEN 8192
+#define REC_MAX_FRAMES 4096
+
+typedef struct
+{
+    uint8_t buf[REC_MAX_LEN];
+    uint32_t seq[REC_MAX_FRAMES];
+    uint32_t sum[REC_MAX_FRAMES];
+    int n;
+    int drops[USB_SR_DROP_BAD_CODEC + 1];
+} rec_t;
+
+static rec_t s_rec;
+static rec_t s_rec2;
+static rec_t s_rec3;
+
+static uint32_t fnv1a(const uint8_t *p, size_t n)
+{
+    uint32_t h = 2166136261u;
+    while (n--)
+        h = (h ^ *p++) * 16777619u;
+    return h;
+}
+
+static void *rec_acquire(void *user, const usb_sr_hdr_t *hdr, size_t *capacity)
+{
+    rec_t *r = (rec_t *)user;
+    (void)hdr;
+    *capacity = sizeof(r->buf);
+    return r->buf;
+}
+
+static void rec_commit(void *user, const usb_sr_hdr_t *hdr, void *buf, size_t len)
+{
+    rec_t *r = (rec_t *)user;
+    if (r->n < REC_MAX_FRAMES)
+    {
+        r->seq[r->n] = hdr->seq;
+        r->sum[r->n] = fnv1a((const uint8_t *)buf, len);
+    }
+    r->n++;
+}
+
+static void rec_drop(void *user, const usb_sr_hdr_t *hdr, int reason)
+{
+    rec_t *r = (rec_t *)user;
+    (void)hdr;
+    if (reason >= 0 && reason <= USB_SR_DROP_BAD_CODEC)
+        r->drops[reason]++;
+}
+
+static void register_rec_as(rec_t *r, uint32_t magic, bool crc)
+{
+    memset(r, 0, sizeof(*r));
+    usb_sr_receiver_t rcv = {0};
+    rcv.user = r;
+    rcv.magic = magic;
+    rcv.max_len = REC_MAX_LEN;
+    rcv.require_crc = crc;
+    rcv.acquire = rec_acquire;
+    rcv.commit = rec_commit;
+    rcv.drop = rec_drop;
+    TEST_ASSERT_TRUE(usb_sr_register(s_r, &rcv));
+}
+
+static void register_rec(bool crc)
+{
+    register_rec_as(&s_rec, MAGIC_TEST, crc);
+}
+
+/* -------- fixture -------- */
+
+static void start(int max_read, bool zero_copy, bool notify, uint32_t seed)
+{
+    script_tp_config_t tc = {0};
+    tc.max_read = max_read;
+    tc.zero_copy = zero_copy;
+    tc.notify = notify;
+    tc.seed = seed;
+    usb_sr_transport_t tp;
+    s_tp = script_tp_create(&tc, &tp);
+    TEST_ASSERT_NOT_NULL(s_tp);
+
+    usb_sr_config_t cfg = {0};
+    cfg.rx_task_priority = 18;
+    cfg.rx_task_stack = 6144;
+    cfg.rx_task_core = -1;
+    cfg.read_chunk = 16384;
+    cfg.max_receivers = 4;
+    s_r = usb_sr_create(&tp, &cfg);
+    TEST_ASSERT_NOT_NULL(s_r);
+}
+
+static int64_t run(const stream_t *s)
+{
+    const int64_t ns = script_tp_run(s_tp, s->p, s->len, RUN_TIMEOUT_MS);
+    TEST_ASSERT_TRUE_MESSAGE(ns >= 0, "router did not drain the stream");
+    return ns;
+}
+
+void setUp(void)
+{
+    s_r = NULL;
+    s_tp = NULL;
+}
+
+/* router first: its RX task still polls the transport. Receivers go after this. */
+static void stop(void)
+{
+    usb_sr_destroy(s_r);
+    s_r = NULL;
+    script_tp_destroy(s_tp);
+    s_tp = NULL;
+}
+
+void tearDown(void)
+{
+    stop();
+}
+
+/* -------- framing -------- */
+
+static bool pop_seq(msgf_rx_t *m, uint32_t *seq)
+{
+    uint8_t tmp[256];
+    return msgf_rx_pop(m, tmp, sizeof(tmp), NULL, seq);
+}
+
+static void test_msgf_roundtrip_split_reads(void)
+{
+    start(7, false, false, 11);
+    msgf_rx_config_t mc = {0};
+    mc.max_msg_bytes = 1024;
+    mc.queue_depth = 4;
+    mc.require_crc = true;
+    msgf_rx_t *m = msgf_rx_create(&mc);
+    TEST_ASSERT_NOT_NULL(m);
+    usb_sr_receiver_t rcv;
+    msgf_rx_get_receiver(m, &rcv);
+    TEST_ASSERT_TRUE(usb_sr_register(s_r, &rcv));
+
+    uint8_t pay[3][200];
+    uint32_t rng = 5;
+    stream_t s = {0};
+    for (int i = 0; i < 3; i++)
+    {
+        fill_rand(pay[i], sizeof(pay[i]), &rng);
+        st_frame(&s, MAGIC_MSGF, 0, 100 + i, pay[i], 50 + 70 * i, true);
+    }
+    run(&s);
+
+    for (int i = 0; i < 3; i++)
+    {
+        uint8_t out[1024];
+        size_t len = 0;
+        uint32_t seq = 0;
+        TEST_ASSERT_TRUE(msgf_rx_pop(m, out, sizeof(out), &len, &seq));
+        TEST_ASSERT_EQUAL_UINT32(100 + i, seq);
+        TEST_ASSERT_EQUAL_UINT32(50 + 70 * i, len);
+        TEST_ASSERT_EQUAL_MEMORY(pay[i], out, len);
+    }
+    TEST_ASSERT_FALSE(pop_seq(m, NULL));
+
+    usb_sr_stats_t st;
+    usb_sr_get_stats(s_r, &st);
+    TEST_ASSERT_EQUAL_UINT32(3, st.frames_ok);
+    TEST_ASSERT_EQUAL_UINT32(0, st.frames_dropped);
+    TEST_ASSERT_EQUAL_UINT32(s.len, (uint32_t)st.bytes_rx);
+    st_free(&s);
+    stop();
+    msgf_rx_destroy(m);
+}
+
+static void test_imgf_zero_copy(void)
+{
+    start(1000, true, true, 3);
+    imgf_rx_config_t ic = {0};
+    ic.max_png_bytes = 64 * 1024;
+    ic.require_crc = true;
+    ic.slots = 2;
+    imgf_rx_t *im = imgf_rx_create(&ic);
+    TEST_ASSERT_NOT_NULL(im);
+    usb_sr_receiver_t rcv;
+    imgf_rx_get_receiver(im, &rcv);
+    TEST_ASSERT_TRUE(usb_sr_register(s_r, &rcv));
+
+    static uint8_t pay[40000];
+    uint32_t rng = 9;
+    fill_rand(pay, sizeof(pay), &rng);
+    stream_t s = {0};
+    st_frame(&s, MAGIC_IMGF, IMGF_TYPE_R565, 7, pay, sizeof(pay), true);
+    run(&s);
+
+    imgf_rx_item_t it;
+    TEST_ASSERT_TRUE(imgf_rx_get_item(im, &it));
+    TEST_ASSERT_EQUAL_UINT32(7, it.seq);
+    TEST_ASSERT_EQUAL_UINT8(IMGF_TYPE_R565, it.type);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(pay), it.len);
+    TEST_ASSERT_EQUAL_MEMORY(pay, it.data, sizeof(pay));
+    imgf_rx_release(im, it.token);
+    st_free(&s);
+    stop();
+    imgf_rx_destroy(im);
+}
+
+static void test_resync_after_garbage(void)
+{
+    start(512, false, true, 21);
+    register_rec(true);
+
+    uint32_t rng = 77;
+    uint8_t pay[64];
+    fill_rand(pay, sizeof(pay), &rng);
+
+    static const size_t k_garbage[] = {1, 3, 5, 1000, 100000};
+    for (size_t g = 0; g < sizeof(k_garbage) / sizeof(k_garbage[0]); g++)
+    {
+        usb_sr_reset_stats(s_r);
+        s_rec.n = 0;
+        stream_t s = {0};
+        st_garbage(&s, k_garbage[g], &rng);
+        st_frame(&s, MAGIC_TEST, 0, (uint32_t)g, pay, sizeof(pay), true);
+        const int64_t ns = run(&s);
+
+        usb_sr_stats_t st;
+        usb_sr_get_stats(s_r, &st);
+        /* resynced on the very first magic byte: nothing of the frame itself was skipped */
+        TEST_ASSERT_EQUAL_INT(1, s_rec.n);
+        TEST_ASSERT_EQUAL_UINT32(g, s_rec.seq[0]);
+        TEST_ASSERT_EQUAL_UINT32((uint32_t)k_garbage[g], (uint32_t)st.bytes_skipped);
+        TEST_ASSERT_EQUAL_UINT32(1, st.resync_count);
+
+        char msg[96];
+        snprintf(msg, sizeof(msg), "resync over %u garbage bytes: %.1f us",
+                 (unsigned)k_garbage[g], (double)ns / 1000.0);
+        TEST_MESSAGE(msg);
+        st_free(&s);
+    }
+}
+
+static void test_false_candidate_rescan(void)
+{
+    start(3, false, false, 2);
+    register_rec(true);
+
+    /* a stray magic whose "header" swallows the real frame's first 16 bytes: len reads the
+       zero type/flags/rsv of the real header, is rejected, and the rescan must find the real
+       magic inside the swallowed bytes */
+    uint8_t pay[32];
+    uint32_t rng = 4;
+    fill_rand(pay, sizeof(pay), &rng);
+    stream_t s = {0};
+    const uint32_t stray = MAGIC_TEST;
+    st_put(&s, &stray, 4);
+    st_frame(&s, MAGIC_TEST, 0, 42, pay, sizeof(pay), true);
+    run(&s);
+
+    usb_sr_stats_t st;
+    usb_sr_get_stats(s_r, &st);
+    TEST_ASSERT_EQUAL_INT(1, s_rec.n);
+    TEST_ASSERT_EQUAL_UINT32(42, s_rec.seq[0]);
+    TEST_ASSERT_EQUAL_UINT32(fnv1a(pay, sizeof(pay)), s_rec.sum[0]);
+    TEST_ASSERT_EQUAL_INT(1, s_rec.drops[USB_SR_DROP_BAD_LEN]);
+    TEST_ASSERT_EQUAL_UINT32(1, st.frames_dropped);
+    TEST_ASSERT_EQUAL_UINT32(4, (uint32_t)st.bytes_skipped);
+    st_free(&s);
+}
+
+/* Random mix of good frames, garbage, CRC-corrupt frames and bad-len headers, read in random
+   pieces. Every good frame must come out exactly once and in order. */
+static void fuzz_once(uint32_t seed, bool zero_copy)
+{
+    start(1 + (int)(seed % 4096), zero_copy, (seed & 1) != 0, seed);
+    register_rec(true);
+
+    uint32_t rng = seed * 2654435761u;
+    static uint8_t pay[REC_MAX_LEN];
+    uint32_t want_seq[REC_MAX_FRAMES];
+    uint32_t want_sum[REC_MAX_FRAMES];
+    int n_ok = 0, n_crc = 0, n_len = 0;
+    size_t n_garbage = 0;
+
+    stream_t s = {0};
+    for (int item = 0; item < 1500 && n_ok < REC_MAX_FRAMES; item++)
+    {
+        const uint32_t kind = script_rand(&rng) % 8;
+        const size_t len = 1 + script_rand(&rng) % 3000;
+        if (kind <= 3)
+        {
+            fill_rand(pay, len, &rng);
+            want_seq[n_ok] = (uint32_t)item;
+            want_sum[n_ok] = fnv1a(pay, len);
+            n_ok++;
+            st_frame(&s, MAGIC_TEST, 0, (uint32_t)item, pay, len, true);
+        }
+        else if (kind <= 5)
+        {
+            const size_t g = len % 700;
+            st_garbage(&s, g, &rng);
+            n_garbage += g;
+        }
+        else if (kind == 6)
+        {
+            fill_rand(pay, len, &rng);
+            const size_t at = s.len + sizeof(usb_sr_hdr_t) + script_rand(&rng) % len;
+            st_frame(&s, MAGIC_TEST, 0, (uint32_t)item, pay, len, true);
+            s.p[at] ^= (uint8_t)(1u << (script_rand(&rng) % 8));
+            n_crc++;
+        }
+        else
+        {
+            /* header claiming more than max_len; its tail fields are garbage too, so the
+               16-byte rescan inside it cannot find a magic */
+            usb_sr_hdr_t h = {0};
+            h.magic = MAGIC_TEST;
+            h.len = REC_MAX_LEN + 1 + script_rand(&rng) % 100000;
+            st_put(&s, &h, 12);
+            st_garbage(&s, 8, &rng);
+            n_len++;
+            n_garbage += 8;
+        }
+    }
+    run(&s);
+
+    usb_sr_stats_t st;
+    usb_sr_get_stats(s_r, &st);
+    TEST_ASSERT_EQUAL_INT(n_ok, s_rec.n);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(want_seq, s_rec.seq, n_ok);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(want_sum, s_rec.sum, n_ok);
+    TEST_ASSERT_EQUAL_INT(n_crc, s_rec.drops[USB_SR_DROP_BAD_CRC]);
+    TEST_ASSERT_EQUAL_INT(n_len, s_rec.drops[USB_SR_DROP_BAD_LEN]);
+    TEST_ASSERT_EQUAL_UINT32(n_crc + n_len, st.frames_dropped);
+    TEST_ASSERT_EQUAL_UINT32(n_ok, st.frames_ok);
+    TEST_ASSERT_EQUAL_UINT32(s.len, (uint32_t)st.bytes_rx);
+    TEST_ASSERT_TRUE(st.bytes_skipped >= n_garbage);
+    st_free(&s);
+
+    stop();
+}
+
+static void test_fuzz_stream(void)
+{
+    for (uint32_t seed = 1; seed <= 16; seed++)
+        fuzz_once(seed, (seed & 2) != 0);
+}
+
+/* -------- receiver policies under slot pressure -------- */
+
+static void imgf_pressure(imgf_drop_policy_t policy, uint32_t first_kept)
+{
+    start(256, false, true, 8);
+    imgf_rx_config_t ic = {0};
+    ic.max_png_bytes = 4096;
+    ic.drop_policy = policy;
+    ic.slots = 2;
+    imgf_rx_t *im = imgf_rx_create(&ic);
+    TEST_ASSERT_NOT_NULL(im);
+    usb_sr_receiver_t rcv;
+    imgf_rx_get_receiver(im, &rcv);
+    TEST_ASSERT_TRUE(usb_sr_register(s_r, &rcv));
+
+    /* 5 images, nobody consuming: 2 slots hold what the policy keeps */
+    uint8_t pay[3000];
+    stream_t s = {0};
+    for (uint32_t i = 1; i <= 5; i++)
+    {
+        memset(pay, (int)i, sizeof(pay));
+        st_frame(&s, MAGIC_IMGF, IMGF_TYPE_R565, i, pay, sizeof(pay), false);
+    }
+    run(&s);
+
+    TEST_ASSERT_EQUAL_INT(0, imgf_rx_free_slots(im));
+    for (uint32_t k = 0; k < 2; k++)
+    {
+        imgf_rx_item_t it;
+        TEST_ASSERT_TRUE(imgf_rx_get_item(im, &it));
+        TEST_ASSERT_EQUAL_UINT32(first_kept + k, it.seq);
+        TEST_ASSERT_EQUAL_UINT8(first_kept + k, it.data[sizeof(pay) - 1]);
+        imgf_rx_release(im, it.token);
+    }
+    imgf_rx_item_t it;
+    TEST_ASSERT_FALSE(imgf_rx_get_item(im, &it));
+
+    imgf_rx_stats_t ist;
+    imgf_rx_get_stats(im, &ist);
+    usb_sr_stats_t st;
+    usb_sr_get_stats(s_r, &st);
+    TEST_ASSERT_EQUAL_UINT32(5, ist.frames_seen);
+    TEST_ASSERT_EQUAL_UINT32(3, ist.frames_drop);
+    /* DROP_NEW refuses the buffer (router discards the payload), DROP_OLD overwrites */
+    TEST_ASSERT_EQUAL_UINT32(policy == IMGF_DROP_NEW ? 3 : 0, st.frames_dropped);
+    TEST_ASSERT_EQUAL_UINT32(policy == IMGF_DROP_NEW ? 2 : 5, st.frames_ok);
+    st_free(&s);
+
+    stop();
+    imgf_rx_destroy(im);
+}
+
+static void test_imgf_drop_new(void) { imgf_pressure(IMGF_DROP_NEW, 1); }
+static void test_imgf_drop_old(void) { imgf_pressure(IMGF_DROP_OLD, 4); }
+
+static void test_msgf_latest_wins(void)
+{
+    start(64, false, true, 6);
+    msgf_rx_config_t mc = {0};
+    mc.max_msg_bytes = 256;
+    mc.queue_depth = 2;
+    mc.latest_cmd_mask = 1u << 0; /* CMD 0 = snapshot */
+    msgf_rx_t *m = msgf_rx_create(&mc);
+    TEST_ASSERT_NOT_NULL(m);
+    usb_sr_receiver_t rcv;
+    msgf_rx_get_receiver(m, &rcv);
+    TEST_ASSERT_TRUE(usb_sr_register(s_r, &rcv));
+
+    /* ring holds 1, 2; 3 and 4 are replaced in the mailbox by 5 */
+    uint8_t pay[100] = {0};
+    stream_t s = {0};
+    for (uint32_t i = 1; i <= 5; i++)
+        st_frame(&s, MAGIC_MSGF, 0, i, pay, sizeof(pay), false);
+    run(&s);
+
+    static const uint32_t k_want[] = {1, 2, 5};
+    for (int k = 0; k < 3; k++)
+    {
+        uint32_t seq = 0;
+        TEST_ASSERT_TRUE(pop_seq(m, &seq));
+        TEST_ASSERT_EQUAL_UINT32(k_want[k], seq);
+    }
+    TEST_ASSERT_FALSE(pop_seq(m, NULL));
+
+    /* a reliable command (CMD 1) finding the ring full is dropped, not parked */
+    s.len = 0;
+    st_frame(&s, MAGIC_MSGF, 0, 6, pay, sizeof(pay), false);
+    st_frame(&s, MAGIC_MSGF, 0, 7, pay, sizeof(pay), false);
+    pay[0] = 1;
+    st_frame(&s, MAGIC_MSGF, 0, 8, pay, sizeof(pay), false);
+    run(&s);
+
+    for (uint32_t want = 6; want <= 7; want++)
+    {
+        uint32_t seq = 0;
+        TEST_ASSERT_TRUE(pop_seq(m, &seq));
+        TEST_ASSERT_EQUAL_UINT32(want, seq);
+    }
+    TEST_ASSERT_FALSE(pop_seq(m, NULL));
+
+    msgf_rx_stats_t mst;
+    msgf_rx_get_stats(m, &mst);
+    TEST_ASSERT_EQUAL_UINT32(8, mst.frames_seen);
+    TEST_ASSERT_EQUAL_UINT32(3, mst.frames_drop);
+    st_free(&s);
+
+    stop();
+    msgf_rx_destroy(m);
+}
+
+/* -------- multiplexing -------- */
+
+static void st_mux(stream_t *s, uint8_t chan, uint16_t idx, uint8_t flags,
+                   const uint8_t *p, size_t len)
+{
+    usb_sr_hdr_t h = {0};
+    h.magic = USB_SR_MAGIC_MUX;
+    h.type = chan;
+    h.flags = flags;
+    h.rsv = idx;
+    h.len = (uint32_t)len;
+    st_put(s, &h, sizeof(h));
+    st_put(s, p, len);
+}
+
+/* Cuts a whole inner frame (header included) into fragments of the given sizes; the last one
+   takes whatever is left. */
+static void st_mux_frame(stream_t *s, uint8_t chan, const stream_t *inner,
+                         const size_t *sizes, int n)
+{
+    size_t off = 0;
+    for (int i = 0; i < n && off < inner->len; i++)
+    {
+        size_t take = (i == n - 1) ? inner->len - off : sizes[i];
+        uint8_t flags = (i == 0) ? USB_SR_MUX_FIRST : 0;
+        if (off + take >= inner->len)
+        {
+            take = inner->len - off;
+            flags |= USB_SR_MUX_LAST;
+        }
+        st_mux(s, chan, (uint16_t)i, flags, inner->p + off, take);
+        off += take;
+    }
+}
+
+typedef struct
+{
+    stream_t inner; /* frame being cut, header included */
+    size_t off;
+    uint16_t idx;
+    int done;
+} mux_src_t;
+
+#define MUX_FRAMES 12
+
+static void test_mux_interleave(void)
+{
+    for (int zc = 0; zc <= 1; zc++)
+    {
+        start(zc ? 700 : 333, zc, true, 40 + zc);
+        register_rec(true);
+        register_rec_as(&s_rec2, MAGIC_TEST2, false);
+        register_rec_as(&s_rec3, MAGIC_MSGF, true);
+
+        /* channel 0 carries TEST frames, channel 1 TEST2; small MSGF frames go in between */
+        static const uint32_t k_magic[2] = {MAGIC_TEST, MAGIC_TEST2};
+        uint32_t want[2][MUX_FRAMES];
+        mux_src_t src[2];
+        memset(src, 0, sizeof(src));
+        static uint8_t pay[REC_MAX_LEN];
+        uint32_t rng = 1234 + (uint32_t)zc;
+        stream_t s = {0};
+        uint32_t plain = 0, frags = 0;
+
+        while (src[0].done < MUX_FRAMES || src[1].done < MUX_FRAMES)
+        {
+            int c = (int)(script_rand(&rng) & 1u);
+            if (src[c].done == MUX_FRAMES)
+                c ^= 1;
+            mux_src_t *m = &src[c];
+            if (m->inner.len == 0)
+            {
+                size_t len = 1 + script_rand(&rng) % REC_MAX_LEN;
+                fill_rand(pay, len, &rng);
+                want[c][m->done] = fnv1a(pay, len);
+                st_frame(&m->inner, k_magic[c], 0, (uint32_t)m->done, pay, len, c == 0);
+            }
+            size_t take = 20 + script_rand(&rng) % 1480;
+            uint8_t flags = (m->idx == 0) ? USB_SR_MUX_FIRST : 0;
+            if (m->off + take >= m->inner.len)
+            {
+                take = m->inner.len - m->off;
+                flags |= USB_SR_MUX_LAST;
+            }
+            st_mux(&s, (uint8_t)c, m->idx++, flags, m->inner.p + m->off, take);
+            frags++;
+            m->off += take;
+            if (flags & USB_SR_MUX_LAST)
+            {
+                m->inner.len = 0;
+                m->off = 0;
+                m->idx = 0;
+                m->done++;
+            }
+            if (script_rand(&rng) % 3 == 0)
+            {
+                fill_rand(pay, 27, &rng);
+                st_frame(&s, MAGIC_MSGF, 0, plain++, pay, 27, true);
+            }
+        }
+        st_free(&src[0].inner);
+        st_free(&src[1].inner);
+        run(&s);
+
+        TEST_ASSERT_EQUAL_INT(MUX_FRAMES, s_rec.n);
+        TEST_ASSERT_EQUAL_INT(MUX_FRAMES, s_rec2.n);
+        for (int k = 0; k < MUX_FRAMES; k++)
+        {
+            TEST_ASSERT_EQUAL_UINT32(k, s_rec.seq[k]);
+            TEST_ASSERT_EQUAL_UINT32(want[0][k], s_rec.sum[k]);
+            TEST_ASSERT_EQUAL_UINT32(k, s_rec2.seq[k]);
+            TEST_ASSERT_EQUAL_UINT32(want[1][k], s_rec2.sum[k]);
+        }
+        TEST_ASSERT_EQUAL_INT((int)plain, s_rec3.n);
+
+        usb_sr_stats_t st;
+        usb_sr_get_stats(s_r, &st);
+        TEST_ASSERT_EQUAL_UINT32(frags, st.mux_fragments);
+        TEST_ASSERT_EQUAL_UINT32(2 * MUX_FRAMES, st.mux_frames);
+        TEST_ASSERT_EQUAL_UINT32(2 * MUX_FRAMES + plain, st.frames_ok);
+        TEST_ASSERT_EQUAL_UINT32(0, st.frames_dropped);
+        st_free(&s);
+        stop();
+    }
+}
+
+static void test_mux_gap(void)
+{
+    start(512, false, true, 5);
+    register_rec(true);
+
+    uint32_t rng = 31;
+    static uint8_t pay[3000];
+    fill_rand(pay, sizeof(pay), &rng);
+    static const size_t k_cut[] = {600, 700, 800, 900};
+    stream_t in = {0};
+    stream_t s = {0};
+
+    /* seq 1 loses fragment 2: dropped when fragment 3 arrives out of order */
+    st_frame(&in, MAGIC_TEST, 0, 1, pay, sizeof(pay), true);
+    stream_t tmp = {0};
+    st_mux_frame(&tmp, 0, &in, k_cut, 4);
+    const size_t f2 = 2 * sizeof(usb_sr_hdr_t) + 600 + 700;
+    const size_t f3 = f2 + sizeof(usb_sr_hdr_t) + 800;
+    st_put(&s, tmp.p, f2);
+    st_put(&s, tmp.p + f3, tmp.len - f3);
+
+    /* seq 2 goes through whole */
+    in.len = 0;
+    st_frame(&in, MAGIC_TEST, 0, 2, pay, sizeof(pay), true);
+    st_mux_frame(&s, 0, &in, k_cut, 4);
+
+    /* seq 3 is cut off by an unfragmented frame for the same receiver (seq 4); its remaining
+       fragments are skipped */
+    in.len = 0;
+    st_frame(&in, MAGIC_TEST, 0, 3, pay, sizeof(pay), true);
+    tmp.len = 0;
+    st_mux_frame(&tmp, 1, &in, k_cut, 4);
+    const size_t f1 = sizeof(usb_sr_hdr_t) + 600;
+    st_put(&s, tmp.p, f1);
+    st_frame(&s, MAGIC_TEST, 0, 4, pay, 100, true);
+    st_put(&s, tmp.p + f1, tmp.len - f1);
+
+    /* seq 5 is superseded by a new FIRST on its channel (seq 6) */
+    in.len = 0;
+    st_frame(&in, MAGIC_TEST, 0, 5, pay, sizeof(pay), true);
+    st_mux(&s, 2, 0, USB_SR_MUX_FIRST, in.p, 600);
+    in.len = 0;
+    st_frame(&in, MAGIC_TEST, 0, 6, pay, sizeof(pay), true);
+    st_mux_frame(&s, 2, &in, k_cut, 4);
+    run(&s);
+
+    static const uint32_t k_want[] = {2, 4, 6};
+    TEST_ASSERT_EQUAL_INT(3, s_rec.n);
+    for (int k = 0; k < 3; k++)
+        TEST_ASSERT_EQUAL_UINT32(k_want[k], s_rec.seq[k]);
+    TEST_ASSERT_EQUAL_UINT32(fnv1a(pay, sizeof(pay)), s_rec.sum[0]);
+    TEST_ASSERT_EQUAL_INT(3, s_rec.drops[USB_SR_DROP_MUX_GAP]);
+
+    usb_sr_stats_t st;
+    usb_sr_get_stats(s_r, &st);
+    TEST_ASSERT_EQUAL_UINT32(2, st.mux_frames);
+    TEST_ASSERT_EQUAL_UINT32(3, st.frames_ok);
+    TEST_ASSERT_EQUAL_UINT32(3, st.frames_dropped);
+    st_free(&tmp);
+    st_free(&in);
+    st_free(&s);
+    stop();
+}
+
+/* A header rejected for a receiver ends what that receiver has open on a channel, before its
+   drop() runs: the receiver frees that buffer in drop(), the channel must not commit into it. */
+static void test_mux_reject_releases(void)
+{
+    start(512, false, true, 6);
+    register_rec(true);
+
+    uint32_t rng = 37;
+    static uint8_t pay[3000];
+    fill_rand(pay, sizeof(pay), &rng);
+    static const size_t k_cut[] = {600, 700, 800, 900};
+    const size_t f1 = sizeof(usb_sr_hdr_t) + 600;
+    stream_t in = {0};
+    stream_t tmp = {0};
+    stream_t s = {0};
+    usb_sr_hdr_t bad = {0};
+    bad.magic = MAGIC_TEST;
+
+    /* seq 1: cut by an oversize header (ST_HDR BAD_LEN) */
+    st_frame(&in, MAGIC_TEST, 0, 1, pay, sizeof(pay), true);
+    st_mux_frame(&tmp, 0, &in, k_cut, 4);
+    st_put(&s, tmp.p, f1);
+    bad.len = 1u << 30;
+    st_put(&s, &bad, sizeof(bad));
+    st_put(&s, tmp.p + f1, tmp.len - f1);
+
+    /* seq 2: cut by an unknown codec (ST_HDR BAD_CODEC) */
+    in.len = 0;
+    tmp.len = 0;
+    st_frame(&in, MAGIC_TEST, 0, 2, pay, sizeof(pay), true);
+    st_mux_frame(&tmp, 1, &in, k_cut, 4);
+    st_put(&s, tmp.p, f1);
+    bad.len = 16;
+    bad.flags = USB_SR_FLAG_CODEC_MASK;
+    st_put(&s, &bad, sizeof(bad));
+    st_put(&s, tmp.p + f1, tmp.len - f1);
+
+    /* seq 3: cut by an oversize inner header on another channel (ST_MUX_HDR) */
+    in.len = 0;
+    tmp.len = 0;
+    st_frame(&in, MAGIC_TEST, 0, 3, pay, sizeof(pay), true);
+    st_mux_frame(&tmp, 2, &in, k_cut, 4);
+    st_put(&s, tmp.p, f1);
+    bad.len = 1u << 30;
+    bad.flags = 0;
+    st_mux(&s, 3, 0, USB_SR_MUX_FIRST | USB_SR_MUX_LAST, (const uint8_t *)&bad, sizeof(bad));
+    st_put(&s, tmp.p + f1, tmp.len - f1);
+
+    /* seq 4: cut by an LZ4 frame whose raw_len is too big (bind_buffer BAD_LEN) */
+    in.len = 0;
+    tmp.len = 0;
+    st_frame(&in, MAGIC_TEST, 0, 4, pay, sizeof(pay), true);
+    st_mux_frame(&tmp, 0, &in, k_cut, 4);
+    st_put(&s, tmp.p, f1);
+    static const uint8_t k_zpay[8] = {0, 0, 0x10, 0}; /* raw_len 1 MiB, then zeros */
+    bad.len = sizeof(k_zpay);
+    bad.flags = USB_SR_FLAG_LZ4;
+    bad.crc32 = crc32_ref(k_zpay, sizeof(k_zpay));
+    st_put(&s, &bad, sizeof(bad));
+    st_put(&s, k_zpay, sizeof(k_zpay));
+    st_put(&s, tmp.p + f1, tmp.len - f1);
+
+    /* seq 5 goes through whole */
+    in.len = 0;
+    st_frame(&in, MAGIC_TEST, 0, 5, pay, sizeof(pay), true);
+    st_mux_frame(&s, 1, &in, k_cut, 4);
+    run(&s);
+
+    TEST_ASSERT_EQUAL_INT(1, s_rec.n);
+    TEST_ASSERT_EQUAL_UINT32(5, s_rec.seq[0]);
+    TEST_ASSERT_EQUAL_INT(4, s_rec.drops[USB_SR_DROP_MUX_GAP]);
+    TEST_ASSERT_EQUAL_INT(3, s_rec.drops[USB_SR_DROP_BAD_LEN]);
+    TEST_ASSERT_EQUAL_INT(1, s_rec.drops[USB_SR_DROP_BAD_CODEC]);
+
+    usb_sr_stats_t st;
+    usb_sr_get_stats(s_r, &st);
+    TEST_ASSERT_EQUAL_UINT32(1, st.mux_frames);
+    TEST_ASSERT_EQUAL_UINT32(1, st.frames_ok);
+    TEST_ASSERT_EQUAL_UINT32(8, st.frames_dropped);
+    st_free(&tmp);
+    st_free(&in);
+    st_free(&s);
+    stop();
+}
+
+/* -------- compressed payloads -------- */
+
+static void lz_put_len(stream_t *s, size_t n)
+{
+    for (; n >= 255; n -= 255)
+        st_put(s, "\xff", 1);
+    uint8_t b = (uint8_t)n;
+    st_put(s, &b, 1);
+}
+
+/* Greedy LZ4 block encoder (same rules as host_pc.py): raw_len word + block. */
+static void lz_payload(stream_t *s, const uint8_t *src, size_t n)
+{
+    static int32_t table[4096];
+    for (int k = 0; k < 4096; k++)
+        table[k] = -1;
+    uint32_t raw = (uint32_t)n;
+    st_put(s, &raw, 4);
+    size_t anchor = 0, i = 0;
+    while (n >= 12 && i < n - 12)
+    {
+        uint32_t key;
+        memcpy(&key, src + i, 4);
+        const uint32_t slot = (key * 2654435761u) >> 20;
+        const int32_t cand = table[slot];
+        table[slot] = (int32_t)i;
+        if (cand < 0 || i - (size_t)cand > 0xFFFF || memcmp(src + cand, src + i, 4) != 0)
+        {
+            i++;
+            continue;
+        }
+        size_t mlen = 4;
+        while (i + mlen < n - 5 && src[cand + mlen] == src[i + mlen])
+            mlen++;
+        const size_t lit = i - anchor;
+        uint8_t tok = (uint8_t)(((lit < 15 ? lit : 15) << 4) | (mlen - 4 < 15 ? mlen - 4 : 15));
+        st_put(s, &tok, 1);
+        if (lit >= 15)
+            lz_put_len(s, lit - 15);
+        st_put(s, src + anchor, lit);
+        const uint16_t off = (uint16_t)(i - (size_t)cand);
+        st_put(s, &off, 2);
+        if (mlen - 4 >= 15)
+            lz_put_len(s, mlen - 4 - 15);
+        i += mlen;
+        anchor = i;
+    }
+    const size_t lit = n - anchor;
+    uint8_t tok = (uint8_t)((lit < 15 ? lit : 15) << 4);
+    st_put(s, &tok, 1);
+    if (lit >= 15)
+        lz_put_len(s, lit - 15);
+    st_put(s, src + anchor, lit);
+}
+
+static void st_lz_frame(stream_t *s, uint32_t magic, uint8_t flags, uint32_t seq,
+                        const uint8_t *pay, size_t len, bool crc)
+{
+    stream_t z = {0};
+    lz_payload(&z, pay, len);
+    usb_sr_hdr_t h = {0};
+    h.magic = magic;
+    h.flags = flags;
+    h.len = (uint32_t)z.len;
+    h.crc32 = crc ? crc32_ref(z.p, z.len) : 0;
+    h.seq = seq;
+    st_put(s, &h, sizeof(h));
+    st_put(s, z.p, z.len);
+    st_free(&z);
+}
+
+/* Map-like content: runs (overlapping matches), repeated rows and some noise. */
+static void fill_compressible(uint8_t *p, size_t n, uint32_t *rng)
+{
+    size_t i = 0;
+    while (i < n)
+    {
+        const uint32_t r = script_rand(rng);
+        size_t run = 1 + r % 300;
+        if (run > n - i)
+            run = n - i;
+        if ((r >> 12) % 3 == 0 && i >= 520)
+            memcpy(p + i, p + i - 520, run); /* same pixels one row up */
+        else if ((r >> 12) % 3 == 1)
+            memset(p + i, (int)(r >> 20), run);
+        else
+            fill_rand(p + i, run, rng);
+        i += run;
+    }
+}
+
+#define LZ_FRAMES 40
+
+static void test_lz4_payloads(void)
+{
+    for (int zc = 0; zc <= 1; zc++)
+    {
+        start(zc ? 1000 : 77, zc, true, 60 + zc);
+        register_rec(true);
+        register_rec_as(&s_rec2, MAGIC_TEST2, false);
+
+        static uint8_t pay[REC_MAX_LEN];
+        uint32_t want[LZ_FRAMES];
+        uint32_t rng = 99 + (uint32_t)zc;
+        stream_t s = {0};
+        size_t raw_total = 0;
+        for (int k = 0; k < LZ_FRAMES; k++)
+        {
+            size_t len = 1 + script_rand(&rng) % REC_MAX_LEN;
+            fill_compressible(pay, len, &rng);
+            want[k] = fnv1a(pay, len);
+            raw_total += len;
+            /* receiver flag bits pass through untouched */
+            st_lz_frame(&s, MAGIC_TEST, USB_SR_FLAG_LZ4 | (uint8_t)(k & 3), (uint32_t)k, pay, len, true);
+            if (k % 4 == 0)
+                st_frame(&s, MAGIC_TEST2, 0, (uint32_t)k, pay, 64, false);
+        }
+        const size_t wire = s.len;
+        run(&s);
+
+        TEST_ASSERT_EQUAL_INT(LZ_FRAMES, s_rec.n);
+        for (int k = 0; k < LZ_FRAMES; k++)
+        {
+            TEST_ASSERT_EQUAL_UINT32(k, s_rec.seq[k]);
+            TEST_ASSERT_EQUAL_UINT32(want[k], s_rec.sum[k]);
+        }
+        TEST_ASSERT_EQUAL_INT(LZ_FRAMES / 4, s_rec2.n);
+        TEST_ASSERT_TRUE(wire < raw_total);
+
+        usb_sr_stats_t st;
+        usb_sr_get_stats(s_r, &st);
+        TEST_ASSERT_EQUAL_UINT32(LZ_FRAMES, st.lz4_frames);
+        TEST_ASSERT_EQUAL_UINT32(raw_total, (uint32_t)st.lz4_bytes_out);
+        TEST_ASSERT_EQUAL_UINT32(0, st.frames_dropped);
+        st_free(&s);
+        stop();
+    }
+}
+
+static void test_lz4_bad(void)
+{
+    start(256, false, true, 7);
+    register_rec(false);
+
+    uint32_t rng = 5;
+    static uint8_t pay[4000];
+    fill_compressible(pay, sizeof(pay), &rng);
+    stream_t s = {0};
+    stream_t z = {0};
+
+    /* seq 1: match offset reaching in front of the buffer */
+    static const uint8_t k_far[] = {4, 0, 0, 0, 0x10, 'a', 0x40, 0x00, 0x00};
+    usb_sr_hdr_t h = {0};
+    h.magic = MAGIC_TEST;
+    h.flags = USB_SR_FLAG_LZ4;
+    h.len = sizeof(k_far);
+    h.seq = 1;
+    st_put(&s, &h, sizeof(h));
+    st_put(&s, k_far, sizeof(k_far));
+
+    /* seq 2: block decodes to less than raw_len */
+    lz_payload(&z, pay, sizeof(pay));
+    const uint32_t more = sizeof(pay) + 1;
+    memcpy(z.p, &more, 4);
+    h.len = (uint32_t)z.len;
+    h.seq = 2;
+    st_put(&s, &h, sizeof(h));
+    st_put(&s, z.p, z.len);
+
+    /* seq 3: raw_len beyond max_len */
+    const uint32_t huge = REC_MAX_LEN + 1;
+    memcpy(z.p, &huge, 4);
+    h.seq = 3;
+    st_put(&s, &h, sizeof(h));
+    st_put(&s, z.p, z.len);
+
+    /* seq 4: codec the device does not have */
+    st_lz_frame(&s, MAGIC_TEST, 0x40, 4, pay, sizeof(pay), false);
+
+    /* seq 5 decodes, also from inside MUXF fragments (seq 6) */
+    st_lz_frame(&s, MAGIC_TEST, USB_SR_FLAG_LZ4, 5, pay, sizeof(pay), false);
+    z.len = 0;
+    st_lz_frame(&z, MAGIC_TEST, USB_SR_FLAG_LZ4, 6, pay, sizeof(pay), false);
+    static const size_t k_cut[] = {24, 500, 700};
+    st_mux_frame(&s, 1, &z, k_cut, 3);
+    run(&s);
+
+    static const uint32_t k_want[] = {5, 6};
+    TEST_ASSERT_EQUAL_INT(2, s_rec.n);
+    for (int k = 0; k < 2; k++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(k_want[k], s_rec.seq[k]);
+        TEST_ASSERT_EQUAL_UINT32(fnv1a(pay, sizeof(pay)), s_rec.sum[k]);
+    }
+    TEST_ASSERT_EQUAL_INT(3, s_rec.drops[USB_SR_DROP_BAD_CODEC]);
+    TEST_ASSERT_EQUAL_INT(1, s_rec.drops[USB_SR_DROP_BAD_LEN]);
+
+    usb_sr_stats_t st;
+    usb_sr_get_stats(s_r, &st);
+    TEST_ASSERT_EQUAL_UINT32(2, st.lz4_frames);
+    TEST_ASSERT_EQUAL_UINT32(1, st.mux_frames);
+    TEST_ASSERT_EQUAL_UINT32(4, st.frames_dropped);
+    st_free(&z);
+    st_free(&s);
+    stop();
+}
+
+/* -------- micro-benchmark --------
+   Consumers drain from on_commit (router task), so the figure is parser + CRC + copy into
+   the receiver, without the app side. Not asserted: it only has to be comparable between
+   builds of the same host. */
+
+static msgf_rx_t *s_bm;
+static imgf_rx_t *s_bi;
+
+static void bench_drain_msgf(void *arg)
+{
+    (void)arg;
+    const uint8_t *d;
+    size_t len;
+    uint32_t seq;
+    if (msgf_rx_peek(s_bm, &d, &len, &seq))
+        msgf_rx_release(s_bm);
+}
+
+static void bench_drain_imgf(void *arg)
+{
+    (void)arg;
+    imgf_rx_item_t it;
+    if (imgf_rx_get_item(s_bi, &it))
+        imgf_rx_release(s_bi, it.token);
+}
+
+static void bench_case(const char *name, uint32_t magic, size_t frame, bool crc,
+                       bool zero_copy, size_t total)
+{
+    start(16384, zero_copy, true, 1);
+
+    msgf_rx_config_t mc = {0};
+    mc.max_msg_bytes = 1024;
+    mc.queue_depth = 4;
+    mc.require_crc = crc;
+    mc.on_commit = bench_drain_msgf;
+    s_bm = msgf_rx_create(&mc);
+    imgf_rx_config_t ic = {0};
+    ic.max_png_bytes = 128 * 1024;
+    ic.require_crc = crc;
+    ic.slots = 2;
+    ic.on_commit = bench_drain_imgf;
+    s_bi = imgf_rx_create(&ic);
+    TEST_ASSERT_NOT_NULL(s_bm);
+    TEST_ASSERT_NOT_NULL(s_bi);
+    usb_sr_receiver_t rcv;
+    msgf_rx_get_receiver(s_bm, &rcv);
+    TEST_ASSERT_TRUE(usb_sr_register(s_r, &rcv));
+    imgf_rx_get_receiver(s_bi, &rcv);
+    TEST_ASSERT_TRUE(usb_sr_register(s_r, &rcv));
+
+    uint8_t *pay = (uint8_t *)malloc(frame);
+    TEST_ASSERT_NOT_NULL(pay);
+    uint32_t rng = 1;
+    fill_rand(pay, frame, &rng);
+    stream_t s = {0};
+    uint32_t frames = 0;
+    while (s.len < total)
+        st_frame(&s, magic, IMGF_TYPE_R565, frames++, pay, frame, crc);
+    free(pay);
+
+    run(&s); /* warm-up: page in the stream and the receiver buffers */
+    usb_sr_reset_stats(s_r);
+    const int64_t ns = run(&s);
+
+    usb_sr_stats_t st;
+    usb_sr_get_stats(s_r, &st);
+    TEST_ASSERT_EQUAL_UINT32(frames, st.frames_ok);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%-22s crc=%d zc=%d: %6.3f ns/byte, %8.1f MB/s, %u frames",
+             name, crc, zero_copy, (double)ns / (double)s.len,
+             (double)s.len * 1e3 / (double)ns, (unsigned)frames);
+    TEST_MESSAGE(msg);
+    st_free(&s);
+
+    stop();
+    msgf_rx_destroy(s_bm);
+    imgf_rx_destroy(s_bi);
+}
+
+static void test_bench_throughput(void)
+{
+    const size_t total = 32u << 20;
+    for (int crc = 0; crc <= 1; crc++)
+    {
+        bench_case("MSGF 160 B snapshots", MAGIC_MSGF, 160, crc, false, total);
+        bench_case("IMGF 64 KiB maps", MAGIC_IMGF, 64 * 1024, crc, false, total);
+        bench_case("IMGF 64 KiB maps", MAGIC_IMGF, 64 * 1024, crc, true, total);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    UNITY_BEGIN();
+    RUN_TEST(test_msgf_roundtrip_split_reads);
+    RUN_TEST(test_imgf_zero_copy);
+    RUN_TEST(test_resync_after_garbage);
+    RUN_TEST(test_false_candidate_rescan);
+    RUN_TEST(test_fuzz_stream);
+    RUN_TEST(test_imgf_drop_new);
+    RUN_TEST(test_imgf_drop_old);
+    RUN_TEST(test_msgf_latest_wins);
+    RUN_TEST(test_mux_interleave);
+    RUN_TEST(test_mux_gap);
+    RUN_TEST(test_mux_reject_releases);
+    RUN_TEST(test_lz4_payloads);
+    RUN_TEST(test_lz4_bad);
+    RUN_TEST(test_bench_throughput);
+    return UNITY_END();
+}